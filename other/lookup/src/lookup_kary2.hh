@@ -66,7 +66,7 @@ namespace kAry2Lookup {
 	    _entries[idx] = p;
 	}
 
-	inline uint32_t bytes() const	{ return _tblsz * sizeof(P); }
+	inline uint32_t bytes() const	{ return _tbl_sz * sizeof(P); }
 	inline uint32_t size() const	{ return _tbl_sz; }
 	inline uint32_t log2size() const	{ return _mw; }
     };
@@ -133,6 +133,7 @@ namespace kAry2Lookup {
     public:
 	inline Compiler(const char* settings);
 	static const char* name()		{ return "kary2"; }
+	size_t route_count() const		{ return _m.size(); }
 	inline bool add_route(const IPNet<A>& n, P portno);
 	inline bool remove_route(const IPNet<A>& n);
 	inline bool compile(EngineData<A,P>& ed);
@@ -97,6 +97,7 @@ namespace kAryCompressedLookup {
     public:
 	Compiler(const char* settings) : _k(settings)	{}
 	static const char* name()	{ return "karycompressed"; }
+	size_t route_count() const	{ return _k.route_count(); }
 
 	inline bool add_route(const IPNet<A>& n, P portno)
 	{
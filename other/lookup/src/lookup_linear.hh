@@ -43,6 +43,7 @@ namespace LinearLookup {
     public:
 	Compiler(const char* /* settings */) 		{}
 	static const char* name()			{ return "linear"; }
+	size_t route_count() const			{ return _m.size(); }
 	inline bool add_route(const IPNet<A>& n, P portno);
 	inline bool remove_route(const IPNet<A>& n);
 	inline bool compile(EngineData<A,P>& ed);
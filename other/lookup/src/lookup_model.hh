@@ -57,6 +57,11 @@ namespace IpLookup {
 	 */
 	static const char* name();
 
+	/**
+	 * @return number of live routes.
+	 */
+	size_t route_count() const;
+
 	/**
 	 * Add route.  Adds route to table, and overwrites existing
 	 * resolution if it exists.
@@ -30,7 +30,7 @@ namespace PrefixTableLookup {
 
     public:
 	Entry(const A& a, P p) : addr(a), port(p) {}
-	Entry() : addr(A::ZERO()), port(NO_PORT) {}
+	Entry() : addr(A::ZERO()), port(static_cast<P>(~0)) {}
 	inline bool operator<(const Entry& o) const {
 	    return addr < o.addr;
 	}
@@ -75,6 +75,7 @@ namespace PrefixTableLookup {
     public:
 	Compiler(const char* /* settings */)	{}
 	static const char* name() 		{ return "prefixtable"; }
+	size_t route_count() const		{ return _m.size(); }
 	inline bool add_route(const IPNet<A>& n, P portno);
 	inline bool remove_route(const IPNet<A>& n);
 	inline bool compile(EngineData<A,P>& ed);
@@ -0,0 +1,93 @@
+#ifndef __LOOKUP_XORP_LC_TRIE_HH__
+#define __LOOKUP_XORP_LC_TRIE_HH__
+
+#include "libxorp/lc_trie.hh"
+
+namespace XorpLcTrieLookup {
+
+    template <typename A, typename P>
+    struct EngineData {
+	LcTrie<A,P> trie;
+
+	size_t bytes() const
+	{
+	    // Compiled lookup structure plus the nodes of the embedded
+	    // Trie that it refers to.  Does not include empty nodes in
+	    // the Trie.
+	    size_t s = sizeof(*this);
+	    s += trie.compiled_bytes();
+	    s += trie.route_count() * sizeof(typename LcTrie<A,P>::Node);
+	    return s;
+	}
+    };
+
+    template <typename A, typename P>
+    class Compiler {
+    public:
+	typedef A AddrType;
+	typedef P PortType;
+
+	static const P NO_PORT = ~0;
+	static const P MAX_PORT = NO_PORT - 1;
+
+    public:
+	Compiler(const char* /* settings */)	{}
+
+	static const char* name()		{ return "xorplctrie"; }
+	size_t route_count() const		{ return _t.route_count(); }
+
+	inline bool add_route(const IPNet<A>& net, P p) {
+	    _t.insert(net, p);
+	    return true;
+	}
+
+	inline bool remove_route(const IPNet<A>& net) {
+	    _t.erase(net);
+	    return true;
+	}
+
+	inline bool compile(EngineData<A,P>& ed) {
+	    ed.trie.delete_all_nodes();
+	    typename Trie<A,P>::iterator i;
+	    for (i = _t.begin(); i != _t.end(); ++i) {
+		ed.trie.insert(i.key(), i.payload());
+	    }
+	    ed.trie.compile();
+
+	    return true;
+	}
+
+    protected:
+	Trie<A,P> _t;
+    };
+
+    template <typename A, typename P>
+    class Engine {
+    public:
+	typedef A AddrType;
+	typedef P PortType;
+
+	static const P NO_PORT  = Compiler<A,P>::NO_PORT;
+	static const P MAX_PORT = Compiler<A,P>::MAX_PORT;
+
+    public:
+	Engine() {}
+
+	void set_engine_data(const EngineData<A,P>* ned)	{ _ed = ned; }
+	const EngineData<A,P>* engine_data()			{ return _ed; }
+
+	inline P lookup(const A& addr) {
+	    typename LcTrie<A,P>::iterator i = _ed->trie.find(addr);
+	    if (i == _ed->trie.end()) {
+		return NO_PORT;
+	    }
+	    return i.payload();
+	}
+
+    protected:
+	const EngineData<A,P>* _ed;
+    };
+
+}; // XorpLcTrieLookup -- end of namepsace
+
+#endif /* __LOOKUP_XORP_LC_TRIE_HH__ */
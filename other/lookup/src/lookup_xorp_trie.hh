@@ -31,6 +31,7 @@ namespace XorpTrieLookup {
 	Compiler(const char* /* settings */)	{}
 
 	static const char* name()		{ return "xorptrie"; }
+	size_t route_count() const		{ return _t.route_count(); }
 
 	inline bool add_route(const IPNet<A>& net, P p) {
 	    //	remove_route(net);
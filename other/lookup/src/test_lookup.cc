@@ -18,6 +18,7 @@ using namespace std;
 #include "lookup_linear.hh"
 #include "lookup_prefix_table.hh"
 #include "lookup_xorp_trie.hh"
+#include "lookup_xorp_lc_trie.hh"
 #include "lookup_kary.hh"
 #include "lookup_kary2.hh"
 #include "lookup_kary_compressed.hh"
@@ -195,6 +196,10 @@ struct TestEngineCompiler
 
 	cout << "# compiled in    " << t1 - t0 << " ticks" << endl;
 	cout << "# engine data size " << _d.bytes() << " bytes" << endl;
+	if (_c.route_count() != 0) {
+	    cout << "# bytes per prefix " << setprecision(2) << fixed
+		 << double(_d.bytes()) / double(_c.route_count()) << endl;
+	}
 	_e.set_engine_data(&_d);
     }
 
@@ -336,7 +341,7 @@ struct TestEngineCompiler
 	rdtsc(t0);
 	for (size_t k = 0; k < N; k++) {
 	    for (size_t i = 0; i < n; i++) {
-		A(random());
+		(void)A(random());
 	    }
 	}
 	rdtsc(t1);
@@ -368,7 +373,7 @@ struct TestEngineCompiler
 	for (size_t k = 0; k < N; k++) {
 	    for (size_t i = 0; i < n; i++) {
 		ck.kill();
-		A(random());
+		(void)A(random());
 	    }
 	}
 	rdtsc(t1);
@@ -487,6 +492,13 @@ main(int argc, char * const argv[])
 		XorpTrieLookup::EngineData<IPv4, uint8_t>
 		>()
 	);
+    factories.push_back(
+	new TestEngineCompilerFactory<
+		XorpLcTrieLookup::Compiler<IPv4, uint8_t>,
+		XorpLcTrieLookup::Engine<IPv4, uint8_t>,
+		XorpLcTrieLookup::EngineData<IPv4, uint8_t>
+		>()
+	);
     factories.push_back(
 	new TestEngineCompilerFactory<
 		kAryLookup::Compiler<IPv4, uint16_t>,
@@ -123,116 +123,74 @@ ASSegment::first_asnum() const
 }
 
 /**
- * prints ASSegments as 
+ * prints a segment as 
  *
  *  AS_SEQUENCE:         [comma-separated-asn-list]  
  *  AS_SET:              {comma-separated-asn-list}
  *  AS_CONFED_SEQUENCE:  (comma-separated-asn-list)
  *  AS_CONFED_SET:       <comma-separated-asn-list> 
+ *
+ * or, in the compact form, as
+ *
+ *  AS_SEQUENCE:         space-separated-asn-list
+ *  AS_SET:              {space-separated-asn-list}
+ *  AS_CONFED_SEQUENCE:  (space-separated-asn-list)
+ *  AS_CONFED_SET:       <space-separated-asn-list> 
+ *
+ * The AS numbers are either AsNum or their 4-byte values.
  */
-string
-ASSegment::str() const
+template <class Iter>
+static string
+segment_str(ASPathSegType type, Iter first, Iter last, bool compact)
 {
-    string s;
-    string sep; 
-    switch(_type) {
+    const char* open = "";
+    const char* close = "";
+    switch(type) {
     case AS_NONE: 
 	break; 
     case AS_SET: 
-	sep = "{"; 
+	open = "{";
+	close = "}";
 	break; 
     case AS_SEQUENCE: 
-	sep = "[";  
+	if (!compact) {
+	    open = "[";
+	    close = "]";
+	}
 	break; 
     case AS_CONFED_SEQUENCE: 
-	sep = "(";  
+	open = "(";
+	close = ")";
 	break; 
     case AS_CONFED_SET: 
-	sep = "<";  
+	open = "<";
+	close = ">";
 	break; 
     }
-    const_iterator iter = _aslist.begin();
 
-    for (u_int i = 0; i<_aslist.size(); i++, ++iter) {
-	s += sep ;
-	s += iter->str();
-	sep = ", ";
-    }
-    switch(_type) {
-    case AS_NONE: 
-	break; 
-    case AS_SET: 
-	sep = "}"; 
-	break; 
-    case AS_SEQUENCE: 
-	sep = "]";  
-	break; 
-    case AS_CONFED_SEQUENCE: 
-	sep = ")";  
-	break; 
-    case AS_CONFED_SET: 
-	sep = ">";  
-	break; 
+    string s;
+    const char* sep = open;
+    for (; first != last; ++first) {
+	AsNum as(*first);
+	s += sep;
+	s += compact ? as.short_str() : as.str();
+	sep = compact ? " " : ", ";
     }
-    s += sep; 
+    s += close;
+
     return s;
 }
 
-/**
- * prints ASSegments as 
- *
- *  AS_SEQUENCE:         comma-separated-asn-list
- *  AS_SET:              {comma-separated-asn-list}
- *  AS_CONFED_SEQUENCE:  (comma-separated-asn-list)
- *  AS_CONFED_SET:       <comma-separated-asn-list> 
- */
 string
-ASSegment::short_str() const
+ASSegment::str() const
 {
-    string s;
-    string sep; 
-    switch(_type) {
-    case AS_NONE: 
-	break; 
-    case AS_SET: 
-	sep = "{"; 
-	break; 
-    case AS_SEQUENCE: 
-	sep = "";  
-	break; 
-    case AS_CONFED_SEQUENCE: 
-	sep = "(";  
-	break; 
-    case AS_CONFED_SET: 
-	sep = "<";  
-	break; 
-    }
-    const_iterator iter = _aslist.begin();
-
-    for (u_int i = 0; i<_aslist.size(); i++, ++iter) {
-	s += sep ;
-	s += iter->short_str();
-	sep = " ";
-    }
-    switch(_type) {
-    case AS_NONE: 
-	break; 
-    case AS_SET: 
-	sep = "}"; 
-	break; 
-    case AS_SEQUENCE: 
-	sep = "";  
-	break; 
-    case AS_CONFED_SEQUENCE: 
-	sep = ")";  
-	break; 
-    case AS_CONFED_SET: 
-	sep = ">";  
-	break; 
-    }
-    s += sep; 
+    return segment_str(_type, _aslist.begin(), _aslist.end(), false);
+}
 
-    return s;
+string
+ASSegment::short_str() const
+{
+    return segment_str(_type, _aslist.begin(), _aslist.end(), true);
 }
 
 /**
@@ -379,6 +337,217 @@ AS4Segment::encode(size_t &len, uint8_t *data) const
 }
 
 
+/* *************** ASPathData ******************* */
+
+ASPathData::ASPathData(vector<uint32_t>& words, uint32_t hash)
+    : _hash(hash), _num_segments(0), _num_as(0), _path_len(0),
+      _first_as(AsNum::AS_INVALID), _first_type(AS_NONE), _confed(false),
+      _interned(false), _refs(0), _next(0)
+{
+    _words.swap(words);
+
+    for (const uint32_t* w = begin(); w != end(); w += 1 + seg_size(*w)) {
+	ASPathSegType type = seg_type(*w);
+	size_t n = seg_size(*w);
+
+	if (_num_segments++ == 0) {
+	    _first_type = type;
+	    if (n != 0)
+		_first_as = AsNum(w[1]);
+	}
+	_num_as += n;
+	switch (type) {
+	case AS_NONE:
+	    break;
+	case AS_SET:
+	    _path_len++;
+	    break;
+	case AS_SEQUENCE:
+	    _path_len += n;
+	    break;
+	case AS_CONFED_SET:
+	    _path_len++;
+	    _confed = true;
+	    break;
+	case AS_CONFED_SEQUENCE:
+	    _path_len += n;
+	    _confed = true;
+	    break;
+	}
+    }
+}
+
+/**
+ * The table of interned paths.  It is a chained hash table, with as
+ * many buckets as paths, or more.  It is never freed, so that paths
+ * in static objects can safely be released at exit.
+ *
+ * The paths built while interning is deferred are kept out of the
+ * table, and only counted by the objects holding them.
+ */
+class ASPathTable {
+public:
+    static ASPathTable& table() {
+	static ASPathTable* t = new ASPathTable;
+	return *t;
+    }
+
+    ASPathTable() : _buckets(MIN_BUCKETS, static_cast<ASPathData*>(0)),
+		    _count(0)				{}
+
+    const ASPathData* intern(vector<uint32_t>& words);
+    const ASPathData* intern(const ASPathData* pending);
+    void release(const ASPathData* data);
+
+    static const ASPathData* pending(vector<uint32_t>& words);
+    size_t size() const				{ return _count; }
+
+private:
+    static const size_t MIN_BUCKETS = 1024;
+
+    static uint32_t hash(const vector<uint32_t>& words);
+
+    ASPathData*& bucket(uint32_t hash) {
+	return _buckets[hash & (_buckets.size() - 1)];
+    }
+    void grow();
+
+    vector<ASPathData*>	_buckets;	// Size is a power of two
+    size_t		_count;
+};
+
+uint32_t
+ASPathTable::hash(const vector<uint32_t>& words)
+{
+    // FNV-1a over the words, and a final mix so that the low bits,
+    // which select the bucket, depend on all the bits.
+    uint32_t h = 2166136261U;
+    for (size_t i = 0; i < words.size(); i++)
+	h = (h ^ words[i]) * 16777619U;
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+
+    return h;
+}
+
+const ASPathData*
+ASPathTable::intern(vector<uint32_t>& words)
+{
+    uint32_t h = hash(words);
+
+    for (ASPathData* d = bucket(h); d != 0; d = d->_next) {
+	if (d->_hash == h && d->_words == words) {
+	    d->_refs++;
+	    return d;
+	}
+    }
+
+    ASPathData* d = new ASPathData(words, h);
+    d->_interned = true;
+    d->_refs = 1;
+    d->_next = bucket(h);
+    bucket(h) = d;
+
+    if (++_count > _buckets.size())
+	grow();
+
+    return d;
+}
+
+/**
+ * Intern a path built while interning was deferred, taking over the
+ * caller's reference to it.  The data itself goes in the table unless
+ * the path is already there, or other objects still hold the data.
+ */
+const ASPathData*
+ASPathTable::intern(const ASPathData* pending)
+{
+    XLOG_ASSERT(!pending->_interned);
+
+    for (ASPathData* d = bucket(pending->_hash); d != 0; d = d->_next) {
+	if (d->_hash == pending->_hash && d->_words == pending->_words) {
+	    d->_refs++;
+	    release(pending);
+	    return d;
+	}
+    }
+
+    if (pending->_refs != 1) {
+	vector<uint32_t> words(pending->_words);
+	release(pending);
+	return intern(words);
+    }
+
+    ASPathData* d = const_cast<ASPathData*>(pending);
+    d->_interned = true;
+    d->_next = bucket(d->_hash);
+    bucket(d->_hash) = d;
+
+    if (++_count > _buckets.size())
+	grow();
+
+    return d;
+}
+
+void
+ASPathTable::release(const ASPathData* data)
+{
+    if (--data->_refs != 0)
+	return;
+
+    if (data->_interned) {
+	ASPathData** p = &bucket(data->_hash);
+	while (*p != data)
+	    p = &(*p)->_next;
+	*p = data->_next;
+	_count--;
+    }
+
+    delete data;
+}
+
+const ASPathData*
+ASPathTable::pending(vector<uint32_t>& words)
+{
+    uint32_t h = hash(words);
+    ASPathData* d = new ASPathData(words, h);
+    d->_refs = 1;
+
+    return d;
+}
+
+void
+ASPathTable::grow()
+{
+    vector<ASPathData*> old(2 * _buckets.size(),
+			    static_cast<ASPathData*>(0));
+    old.swap(_buckets);
+
+    for (size_t i = 0; i < old.size(); i++) {
+	ASPathData* next;
+	for (ASPathData* d = old[i]; d != 0; d = next) {
+	    next = d->_next;
+	    d->_next = bucket(d->_hash);
+	    bucket(d->_hash) = d;
+	}
+    }
+}
+
+/*
+ * Set while the current thread defers interning.
+ */
+static __thread bool defer_intern = false;
+
+static void
+append_segment(vector<uint32_t>& words, const ASSegment& s)
+{
+    words.push_back(ASPathData::header(s.type(), s.as_size()));
+    for (size_t i = 0; i < s.as_size(); i++)
+	words.push_back(s.as_num(i).as4());
+}
+
 /* *************** ASPath *********************** */
 
 /**
@@ -398,10 +567,9 @@ AS4Segment::encode(size_t &len, uint8_t *data) const
  */
 
 ASPath::ASPath(const char *as_path) throw(InvalidString)
+    : _data(0)
 {
     debug_msg("ASPath(%s) constructor called\n", as_path);
-    _num_segments = 0;
-    _path_len = 0;
 
     // make a copy removing all spaces from the string.
 
@@ -411,6 +579,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	path = path.substr(0, pos) + path.substr(pos + 1);
     }
 
+    vector<uint32_t> words;
     ASSegment seg;
     for (size_t i = 0; i < path.length(); i++) {
 	char c = path[i];
@@ -433,7 +602,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == '[') {
 	    if (seg.type() == AS_SEQUENCE) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else if (seg.type() != AS_NONE) // nested, invalid
 		xorp_throw(InvalidString,
@@ -443,7 +612,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == ']') {
 	    if (seg.type() == AS_SEQUENCE) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else
 		xorp_throw(InvalidString,
@@ -452,7 +621,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == '{') {
 	    if (seg.type() == AS_SEQUENCE) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else if (seg.type() != AS_NONE) // nested, invalid
 		xorp_throw(InvalidString,
@@ -462,7 +631,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == '}') {
 	    if (seg.type() == AS_SET) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else
 		xorp_throw(InvalidString,
@@ -471,7 +640,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == '(') {
 	    if (seg.type() == AS_SEQUENCE) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else if (seg.type() != AS_NONE) // nested, invalid
 		xorp_throw(InvalidString,
@@ -481,7 +650,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == ')') {
 	    if (seg.type() == AS_CONFED_SEQUENCE) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else
 		xorp_throw(InvalidString,
@@ -490,7 +659,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == '<') {
 	    if (seg.type() == AS_SEQUENCE) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else if (seg.type() != AS_NONE) // nested, invalid
 		xorp_throw(InvalidString,
@@ -500,7 +669,7 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 	} else if (c == '>') {
 	    if (seg.type() == AS_CONFED_SET) {
 		// push previous thing and start a new one
-		add_segment(seg);
+		append_segment(words, seg);
 		seg.clear();
 	    } else
 		xorp_throw(InvalidString,
@@ -514,71 +683,100 @@ ASPath::ASPath(const char *as_path) throw(InvalidString)
 				c, path.c_str()));
     }
     if (seg.type() == AS_SEQUENCE)	// close existing seg.
-	add_segment(seg);
+	append_segment(words, seg);
     else if (seg.type() == AS_SET)
 	xorp_throw(InvalidString,
 		       c_format("Unterminated ASSet: %s", path.c_str()));
+    set_words(words);
     debug_msg("end of ASPath()\n");
 }
 
 /**
- * populate an ASPath from the received data representation
+ * populate an ASPath from the received data representation, straight
+ * into the flat form.
  */
 void
-ASPath::decode(const uint8_t *d, size_t l) throw(CorruptMessage)
+ASPath::decode(const uint8_t *d, size_t l, size_t as_size)
+    throw(CorruptMessage)
 {
-    _num_segments = 0;
-    _path_len = 0;
+    vector<uint32_t> words;
+    words.reserve(l / as_size + 1);
+
     while (l > 0) {		// grab segments
-	size_t len = 2 + d[1]*2;	// XXX length in bytes for 16bit AS's
+	size_t n = l >= 2 ? d[1] : 0;
+	size_t len = 2 + n * as_size;	// length in bytes
 	if (len > l)
 	    xorp_throw(CorruptMessage,
 		       c_format("Bad ASpath (len) %u > (l) %u\n",
 				XORP_UINT_CAST(len), XORP_UINT_CAST(l)),
 		       UPDATEMSGERR, MALASPATH);
 
-	ASSegment s(d);
-	add_segment(s);
+	ASPathSegType type = (ASPathSegType)d[0];
+	switch(type) {
+	case AS_NONE:
+	case AS_SET:
+	case AS_SEQUENCE:
+	case AS_CONFED_SET:
+	case AS_CONFED_SEQUENCE:
+	    break;
+	default:
+	    xorp_throw(CorruptMessage,
+		       c_format("Bad AS Segment type: %u\n", type),
+		       UPDATEMSGERR, MALASPATH);
+	}
+
+	words.push_back(ASPathData::header(type, n));
+	for (const uint8_t* p = d + 2; p != d + len; p += as_size) {
+	    if (as_size == 2)
+		words.push_back((p[0] << 8) | p[1]);
+	    else
+		words.push_back((p[0] << 24) | (p[1] << 16) | (p[2] << 8)
+				| p[3]);
+	}
 	d += len;
 	l -= len;
     }
+
+    set_words(words);
 }
 
 /**
  * construct a new aggregate ASPath from two ASPaths
  */
 ASPath::ASPath(const ASPath &asp1, const ASPath &asp2)
+    : _data(0)
 {
-    _num_segments = 0;
-    _path_len = 0;
+    vector<ASSegment> segs1, segs2, segs;
+    asp1.segments(segs1);
+    asp2.segments(segs2);
 
     size_t curseg;
     size_t matchelem = 0;
     bool fullmatch = true;
 
     for (curseg = 0;
-	curseg < asp1.num_segments() && curseg < asp2.num_segments();
+	curseg < segs1.size() && curseg < segs2.size();
 	curseg++) {
-	if (asp1.segment(curseg).type() != asp2.segment(curseg).type())
+	if (segs1[curseg].type() != segs2[curseg].type())
 	    break;
 
-	size_t minseglen = min(asp1.segment(curseg).path_length(),
-			       asp2.segment(curseg).path_length());
+	size_t minseglen = min(segs1[curseg].path_length(),
+			       segs2[curseg].path_length());
 
 	for (matchelem = 0; matchelem < minseglen; matchelem++)
-	    if (asp1.segment(curseg).as_num(matchelem) !=
-		asp2.segment(curseg).as_num(matchelem))
+	    if (segs1[curseg].as_num(matchelem) !=
+		segs2[curseg].as_num(matchelem))
 		break;
 
 	if (matchelem) {
-	    ASSegment newseg(asp1.segment(curseg).type());
+	    ASSegment newseg(segs1[curseg].type());
 	    for (size_t elem = 0; elem < matchelem; elem++)
-		newseg.add_as(asp1.segment(curseg).as_num(elem));
-	    this->add_segment(newseg);
+		newseg.add_as(segs1[curseg].as_num(elem));
+	    segs.push_back(newseg);
 	}
 
-	if (matchelem < asp1.segment(curseg).path_length() ||
-	    matchelem < asp2.segment(curseg).path_length()) {
+	if (matchelem < segs1[curseg].path_length() ||
+	    matchelem < segs2[curseg].path_length()) {
 	    fullmatch = false;
 	    break;
 	}
@@ -587,66 +785,202 @@ ASPath::ASPath(const ASPath &asp1, const ASPath &asp2)
     if (!fullmatch) {
 	ASSegment new_asset(AS_SET);
 	size_t startelem = matchelem;
-	for (size_t curseg1 = curseg; curseg1 < asp1.num_segments();
-	     curseg1++) {
+	for (size_t curseg1 = curseg; curseg1 < segs1.size(); curseg1++) {
 	    for (size_t elem = startelem;
-		 elem < asp1.segment(curseg1).path_length(); elem++) {
-		const class AsNum asn = asp1.segment(curseg).as_num(elem);
+		 elem < segs1[curseg1].path_length(); elem++) {
+		const class AsNum asn = segs1[curseg1].as_num(elem);
 		if (!new_asset.contains(asn))
 		    new_asset.add_as(asn);
 		}
 	    startelem = 0;
 	}
 	startelem = matchelem;
-	for (size_t curseg2 = curseg; curseg2 < asp2.num_segments();
-	     curseg2++) {
+	for (size_t curseg2 = curseg; curseg2 < segs2.size(); curseg2++) {
 	    for (size_t elem = startelem;
-		 elem < asp2.segment(curseg2).path_length(); elem++) {
-		const class AsNum asn = asp2.segment(curseg).as_num(elem);
+		 elem < segs2[curseg2].path_length(); elem++) {
+		const class AsNum asn = segs2[curseg2].as_num(elem);
 		if (!new_asset.contains(asn))
 		    new_asset.add_as(asn);
 		}
 	    startelem = 0;
 	}
-	this->add_segment(new_asset);
+	segs.push_back(new_asset);
+    }
+
+    assign(segs);
+}
+
+void
+ASPath::release()
+{
+    if (_data != 0)
+	ASPathTable::table().release(_data);
+    _data = 0;
+}
+
+void
+ASPath::set_words(vector<uint32_t>& words)
+{
+    const ASPathData* old = _data;
+
+    if (words.empty())
+	_data = 0;
+    else if (defer_intern)
+	_data = ASPathTable::pending(words);
+    else
+	_data = ASPathTable::table().intern(words);
+    if (old != 0)
+	ASPathTable::table().release(old);
+}
+
+void
+ASPath::intern()
+{
+    if (_data != 0 && !_data->_interned)
+	_data = ASPathTable::table().intern(_data);
+}
+
+ASPath::DeferIntern::DeferIntern()
+    : _saved(defer_intern)
+{
+    defer_intern = true;
+}
+
+ASPath::DeferIntern::~DeferIntern()
+{
+    defer_intern = _saved;
+}
+
+size_t
+ASPath::interned_paths()
+{
+    return ASPathTable::table().size();
+}
+
+void
+ASPath::segments(vector<ASSegment>& segs) const
+{
+    segs.clear();
+    if (_data == 0)
+	return;
+
+    segs.reserve(_data->_num_segments);
+    const uint32_t* w = _data->begin();
+    while (w != _data->end()) {
+	size_t n = ASPathData::seg_size(*w);
+	segs.push_back(ASSegment(ASPathData::seg_type(*w)));
+	for (w++; n > 0; n--, w++)
+	    segs.back().add_as(AsNum(*w));
     }
 }
 
+void
+ASPath::assign(const vector<ASSegment>& segs)
+{
+    vector<uint32_t> words;
+    for (size_t i = 0; i < segs.size(); i++)
+	append_segment(words, segs[i]);
+    set_words(words);
+}
+
 void
 ASPath::add_segment(const ASSegment& s)
 {
     debug_msg("Adding As Segment\n");
-    _segments.push_back(s);
-    _num_segments++;
-
-    size_t n = s.path_length();
-    _path_len += n;
-    debug_msg("End of add_segment, As Path length by %u to be %u\n",
-	      XORP_UINT_CAST(n), XORP_UINT_CAST(_path_len));
+    vector<uint32_t> words;
+    if (_data != 0)
+	words.assign(_data->begin(), _data->end());
+    append_segment(words, s);
+    set_words(words);
 }
 
 void
 ASPath::prepend_segment(const ASSegment& s)
 {
     debug_msg("Prepending As Segment\n");
-    _segments.push_front(s);
-    _num_segments++;
+    vector<uint32_t> words;
+    append_segment(words, s);
+    if (_data != 0)
+	words.insert(words.end(), _data->begin(), _data->end());
+    set_words(words);
+}
 
-    size_t n = s.path_length();
-    _path_len += n;
-    debug_msg("End of add_segment, As Path length by %u to be %u\n",
-	      XORP_UINT_CAST(n), XORP_UINT_CAST(_path_len));
+bool
+ASPath::contains(const AsNum& as_num) const
+{
+    if (_data == 0)
+	return false;
+
+    uint32_t as = as_num.as4();
+    const uint32_t* w = _data->begin();
+    while (w != _data->end()) {
+	size_t n = ASPathData::seg_size(*w++);
+	for (; n > 0; n--, w++)
+	    if (*w == as)
+		return true;
+    }
+    return false;
+}
+
+const AsNum&
+ASPath::first_asnum() const
+{
+    XLOG_ASSERT(_data != 0);
+    if (_data->_first_type == AS_SET || _data->_first_type == AS_CONFED_SET) {
+	// This shouldn't be possible.  The spec doesn't explicitly
+	// prohibit passing someone an AS_PATH starting with an AS_SET,
+	// but it doesn't make sense, and doesn't seem to be allowed by
+	// the aggregation rules.
+	XLOG_ERROR("Attempting to extract first AS Number "
+		    "from an AS Path that starts with an AS_SET "
+		    "not an AS_SEQUENCE\n"); 
+    }
+    XLOG_ASSERT(ASPathData::seg_size(*_data->begin()) != 0);
+    return _data->_first_as;
+}
+
+ASSegment
+ASPath::segment(size_t n) const
+{
+    if (n < num_segments()) {
+	const uint32_t* w = _data->begin();
+	for (; n > 0; n--)
+	    w += 1 + ASPathData::seg_size(*w);
+
+	ASSegment s(ASPathData::seg_type(*w));
+	for (size_t i = ASPathData::seg_size(*w); i > 0; i--)
+	    s.add_as(AsNum(*++w));
+	return s;
+    }
+    XLOG_FATAL("Segment %u doesn't exist.", (uint32_t)n);
+    xorp_throw(InvalidString, "segment invalid n\n");
+}
+
+ASPathSegType
+ASPath::segment_type(size_t n) const
+{
+    if (n < num_segments()) {
+	const uint32_t* w = _data->begin();
+	for (; n > 0; n--)
+	    w += 1 + ASPathData::seg_size(*w);
+	return ASPathData::seg_type(*w);
+    }
+    XLOG_FATAL("Segment %u doesn't exist.", (uint32_t)n);
+    xorp_throw(InvalidString, "segment invalid n\n");
 }
 
 string
 ASPath::str() const
 {
     string s = "ASPath:";
-    const_iterator iter = _segments.begin();
-    while(iter != _segments.end()) {
+    if (_data == 0)
+	return s;
+
+    for (const uint32_t* w = _data->begin(); w != _data->end();
+	 w += 1 + ASPathData::seg_size(*w)) {
 	s.append(" ");
-	s.append((*iter).str());
-	++iter;
+	s.append(segment_str(ASPathData::seg_type(*w), w + 1,
+			     w + 1 + ASPathData::seg_size(*w), false));
     }
     return s;
 }
@@ -655,33 +989,23 @@ string
 ASPath::short_str() const
 {
     string s;
-    const_iterator iter = _segments.begin();
-    while(iter != _segments.end()) {
-	if (iter != _segments.begin())
+    if (_data == 0)
+	return s;
+
+    for (const uint32_t* w = _data->begin(); w != _data->end();
+	 w += 1 + ASPathData::seg_size(*w)) {
+	if (w != _data->begin())
 	    s.append(" ");
-	s.append((*iter).short_str());
-	++iter;
+	s.append(segment_str(ASPathData::seg_type(*w), w + 1,
+			     w + 1 + ASPathData::seg_size(*w), true));
     }
     return s;
 }
 
-size_t
-ASPath::wire_size() const
-{
-    size_t l = 0;
-    const_iterator iter = _segments.begin();
-
-    for (; iter != _segments.end(); ++iter)
-	l += iter->wire_size();
-    return l;
-}
-
 const uint8_t *
-ASPath::encode(size_t &len, uint8_t *buf) const
+ASPath::encode(size_t &len, uint8_t *buf, size_t as_size) const
 {
-    XLOG_ASSERT(_num_segments == _segments.size());	// XXX expensive
-    const_iterator i;
-    size_t pos, l = wire_size();
+    size_t l = wire_size(as_size);
 
     // allocate or check the memory.
     if (buf == 0)		// no buffer, allocate one
@@ -690,122 +1014,118 @@ ASPath::encode(size_t &len, uint8_t *buf) const
 	XLOG_ASSERT(len >= l);	// in fact, just abort if not so.
     len = l;			// set the correct value.
 
+    if (_data == 0)
+	return buf;
+
     // encode into the buffer
-    for (pos = 0, i = _segments.begin(); i != _segments.end(); ++i) {
-	l = i->wire_size();
-	i->encode(l, buf + pos);
-	pos += l;
+    uint8_t* p = buf;
+    const uint32_t* w = _data->begin();
+    while (w != _data->end()) {
+	size_t n = ASPathData::seg_size(*w);
+	XLOG_ASSERT(n <= 255);
+	*p++ = ASPathData::seg_type(*w++);
+	*p++ = n;
+	for (; n > 0; n--, w++) {
+	    AsNum as(*w);
+	    if (as_size == 2)
+		as.copy_out(p);
+	    else
+		as.copy_out4(p);
+	    p += as_size;
+	}
     }
     return buf;
 }
 
 void
-ASPath::prepend_as(const AsNum &asn)
+ASPath::prepend(ASPathSegType type, const AsNum &asn)
 {
-    if (_segments.empty() || _segments.front().type() == AS_SET) {
-	ASSegment seg = ASSegment(AS_SEQUENCE);
-
-	seg.add_as(asn);
-	_segments.push_front(seg);
-	_num_segments++;
+    vector<uint32_t> words;
+    words.reserve((_data != 0 ? _data->_words.size() : 0) + 2);
+
+    if (_data != 0 && ASPathData::seg_type(*_data->begin()) == type
+	&& ASPathData::seg_size(*_data->begin()) < 255) {
+	// Add to the first segment
+	words.push_back(ASPathData::header(type,
+				ASPathData::seg_size(*_data->begin()) + 1));
+	words.push_back(asn.as4());
+	words.insert(words.end(), _data->begin() + 1, _data->end());
     } else {
-	XLOG_ASSERT(_segments.front().type() == AS_SEQUENCE);
-	_segments.front().prepend_as(asn);
+	words.push_back(ASPathData::header(type, 1));
+	words.push_back(asn.as4());
+	if (_data != 0)
+	    words.insert(words.end(), _data->begin(), _data->end());
     }
-    _path_len++;	// in both cases the length increases by one.
+
+    set_words(words);
 }
 
 void
-ASPath::prepend_confed_as(const AsNum &asn)
+ASPath::prepend_as(const AsNum &asn)
 {
-    if (_segments.empty() || _segments.front().type() == AS_SET 
-	|| _segments.front().type() == AS_SEQUENCE) {
-	ASSegment seg = ASSegment(AS_CONFED_SEQUENCE);
-
-	seg.add_as(asn);
-	_segments.push_front(seg);
-	_num_segments++;
-    } else {
-	XLOG_ASSERT(_segments.front().type() == AS_CONFED_SEQUENCE);
-	_segments.front().prepend_as(asn);
-    }
-    _path_len++;	// in both cases the length increases by one.
+    prepend(AS_SEQUENCE, asn);
 }
 
 void
-ASPath::remove_confed_segments()
+ASPath::prepend_confed_as(const AsNum &asn)
 {
-        debug_msg("Deleting all CONFED Segments\n");
-	const_iterator iter = _segments.begin();
-	const_iterator next_iter;
-	while (iter != _segments.end()) {
-	    next_iter = iter;
-	    ++next_iter;
-	    if ((*iter).type() == AS_CONFED_SEQUENCE 
-		|| (*iter).type() == AS_CONFED_SET) {
-		_path_len--;
-		_num_segments--;
-		_segments.remove((*iter)); 
-	    } 
-	    iter = next_iter;
-	}
+    prepend(AS_CONFED_SEQUENCE, asn);
 }
 
-bool
-ASPath::contains_confed_segments() const
+void
+ASPath::remove_confed_segments()
 {
-    for (const_iterator i = _segments.begin(); i != _segments.end(); i++) {
-	ASPathSegType type = (*i).type();
-	if (AS_CONFED_SEQUENCE == type || AS_CONFED_SET == type)
-	    return true;
-    }
+    debug_msg("Deleting all CONFED Segments\n");
+    if (!contains_confed_segments())
+	return;
 
-    return false;
+    vector<uint32_t> words;
+    const uint32_t* w = _data->begin();
+    while (w != _data->end()) {
+	const uint32_t* next = w + 1 + ASPathData::seg_size(*w);
+	ASPathSegType type = ASPathData::seg_type(*w);
+	if (type != AS_CONFED_SEQUENCE && type != AS_CONFED_SET)
+	    words.insert(words.end(), w, next);
+	w = next;
+    }
+    set_words(words);
 }
 
 ASPath&
 ASPath::operator=(const ASPath& him)
 {
-    // clear out my list
-    while (!_segments.empty()) {
-	_segments.pop_front();
-    }
+    if (him._data != 0)
+	him._data->_refs++;
+    release();
+    _data = him._data;
 
-    // copy in from his
-    const_iterator i;
-    for (i = him._segments.begin() ;i != him._segments.end(); i++) {
-	_segments.push_back(*i);
-    }
     return *this;
 }
 
-bool
-ASPath::operator==(const ASPath& him) const
-{
-    if (_num_segments != him._num_segments) 
-	return false;
-    const_iterator my_i = _segments.begin();
-    const_iterator his_i = him._segments.begin();
-    for (;my_i != _segments.end(); my_i++, his_i++)
-	if (*my_i != *his_i)
-	    return false;
-    return true;
-}
-
 bool
 ASPath::operator<(const ASPath& him) const
 {
-    if (_num_segments < him._num_segments)
-	return true;
-    if (_num_segments > him._num_segments)
+    if (_data == him._data)
 	return false;
-    const_iterator my_i = _segments.begin();
-    const_iterator his_i = him._segments.begin();
-    for (;my_i != _segments.end(); my_i++, his_i++) {
-	if (*my_i < *his_i)
-	    return true;
-	if (*his_i < *my_i)
-	    return false;
+    if (num_segments() != him.num_segments())
+	return num_segments() < him.num_segments();
+
+    // Segment by segment: shortest first, then by AS numbers, and
+    // lastly by type.
+    const uint32_t* my_w = _data->begin();
+    const uint32_t* his_w = him._data->begin();
+    while (my_w != _data->end()) {
+	size_t n = ASPathData::seg_size(*my_w);
+	if (n != ASPathData::seg_size(*his_w))
+	    return n < ASPathData::seg_size(*his_w);
+	for (size_t i = 1; i <= n; i++) {
+	    if (my_w[i] != his_w[i])
+		return my_w[i] < his_w[i];
+	}
+	if (*my_w != *his_w)
+	    return *my_w < *his_w;
+	my_w += 1 + n;
+	his_w += 1 + n;
     }
     return false;
 }
@@ -813,7 +1133,8 @@ ASPath::operator<(const ASPath& him) const
 void
 ASPath::encode_for_mib(vector<uint8_t>& encode_buf) const
 {
-    //See RFC 1657, Page 15 for the encoding.
+    //See RFC 1657, Page 15 for the encoding, which is the 2-byte
+    //encoding on the wire.
     size_t buf_size = wire_size();
     if (buf_size > 2)
 	encode_buf.resize(buf_size);
@@ -828,20 +1149,21 @@ ASPath::encode_for_mib(vector<uint8_t>& encode_buf) const
 	return;
     }
 
-    int ctr = 0;
-    const_iterator i = _segments.begin();
-    for(i = _segments.begin(); i != _segments.end(); i++) {
-	ctr += i->encode_for_mib(&encode_buf[ctr], buf_size - ctr);
-    }
+    encode(buf_size, &encode_buf[0]);
 }
 
 bool
 ASPath::two_byte_compatible() const
 {
-    const_iterator i = _segments.begin();
-    for(i = _segments.begin(); i != _segments.end(); i++) {
-	if ( !(i->two_byte_compatible()) )
-	    return false;
+    if (_data == 0)
+	return true;
+
+    const uint32_t* w = _data->begin();
+    while (w != _data->end()) {
+	size_t n = ASPathData::seg_size(*w++);
+	for (; n > 0; n--, w++)
+	    if (AsNum(*w).extended())
+		return false;
     }
     return true;
 }
@@ -866,27 +1188,7 @@ AS4Path::AS4Path(const uint8_t* d, size_t len, const ASPath& as_path)
 AS4Path::AS4Path(const uint8_t* d, size_t len)
      throw(CorruptMessage)
 {
-    decode(d, len);
-}
-
-/**
- * populate a ASPath from the received data representation from a
- * AS4_PATH attribute.
- */
-void
-AS4Path::decode(const uint8_t *d, size_t l) throw(CorruptMessage)
-{
-    _num_segments = 0;
-    _path_len = 0;
-    while (l > 0) {		// grab segments
-	size_t len = 2 + d[1]*4;	// XXX length in bytes for 32bit AS's
-	XLOG_ASSERT(len <= l);
-
-	AS4Segment s(d);
-	add_segment(s);
-	d += len;
-	l -= len;
-    }
+    decode(d, len, 4);
 }
 
 /**
@@ -904,14 +1206,7 @@ void AS4Path::cross_validate(const ASPath& as_path)
 	// This is illegal.  The spec says to ignore the AS4_PATH
 	// attribute and use the data from the AS_PATH attribute throw
 	// away the data we had.
-	while (!_segments.empty()) {
-	    _segments.pop_front();
-	}
-	// copy in from the AS_PATH version 
-	for (uint32_t i = 0; i < as_path.num_segments(); i++) {
-	    debug_msg("adding %u %s\n", i, as_path.segment(i).str().c_str()); 
-	    add_segment(as_path.segment(i));
-	}
+	ASPath::operator=(as_path);
 	return;
     }
 
@@ -928,27 +1223,30 @@ void AS4Path::cross_validate(const ASPath& as_path)
 
 	// The AS_PATH has at least as many segments as the
 	// AS4_PATH find where they differ, and copy across.
-	for (uint32_t i = 1; i <= num_segments(); i++) {
-	    const ASSegment *old_seg;
-	    ASSegment *new_seg;
-	    old_seg = &(as_path.segment(as_path.num_segments() - i));
-	    new_seg = const_cast<ASSegment*>(&(segment(num_segments() - i)));
-	    printf("old seg: %s\n", old_seg->str().c_str());
-	    printf("new seg: %s\n", new_seg->str().c_str());
-	    if (old_seg->path_length() == new_seg->path_length()) 
+	vector<ASSegment> old_segs, new_segs;
+	as_path.segments(old_segs);
+	segments(new_segs);
+	for (uint32_t i = 1; i <= new_segs.size(); i++) {
+	    const ASSegment& old_seg = old_segs[old_segs.size() - i];
+	    ASSegment& new_seg = new_segs[new_segs.size() - i];
+	    debug_msg("old seg: %s\n", old_seg.str().c_str());
+	    debug_msg("new seg: %s\n", new_seg.str().c_str());
+	    if (old_seg.path_length() == new_seg.path_length()) 
 		continue;
-	    if (old_seg->path_length() < new_seg->path_length()) {
+	    if (old_seg.path_length() < new_seg.path_length()) {
 		// ooops - WTF happened here
 		debug_msg("do patchup\n");
 		do_patchup(as_path);
+		return;
 	    }
-	    if (old_seg->path_length() > new_seg->path_length()) {
+	    if (old_seg.path_length() > new_seg.path_length()) {
 		// found a segment that needs data copying over
 		debug_msg("pad segment\n");
-		printf("new_seg type: %u\n", new_seg->type());
-		pad_segment(*old_seg, *new_seg);
+		debug_msg("new_seg type: %u\n", new_seg.type());
+		pad_segment(old_seg, new_seg);
 	    }
 	}
+	assign(new_segs);
 
 	debug_msg("after patching: \n");
 	debug_msg("old as_path (len %u): %s\n", (uint32_t)as_path.path_length(), as_path.str().c_str());
@@ -961,7 +1259,7 @@ void AS4Path::cross_validate(const ASPath& as_path)
 	// There are more segments, so copy across whole segments
 	for (int i = as_path.num_segments() - num_segments() - 1; 
 	     i >= 0; i--) {
-	    prepend_segment(as_path.segment(i));
+	    prepend_segment(old_segs[i]);
 	}
 
 	XLOG_ASSERT(as_path.path_length() == path_length());
@@ -985,7 +1283,7 @@ void AS4Path::pad_segment(const ASSegment& old_seg, ASSegment& new_seg)
 	    }
 	}
 	// If that wasn't enough, do arbitrary padding to match size
-	while (old_seg.as_size() < new_seg.as_size()) {
+	while (new_seg.as_size() < old_seg.as_size()) {
 	    new_seg.prepend_as(new_seg.first_asnum());
 	}
 	return;
@@ -1023,7 +1321,6 @@ void AS4Path::pad_segment(const ASSegment& old_seg, ASSegment& new_seg)
     // now we can simply copy across the missing AS numbers
     for (int i = old_seg.as_size() - new_seg.as_size() - 1; i >= 0; i--) {
 	new_seg.prepend_as(old_seg.as_num(i));
-	_path_len++;
     }
     return;
 }
@@ -1039,9 +1336,12 @@ void AS4Path::do_patchup(const ASPath& as_path)
     // loops forming, but it's really ugly.
 
     ASSegment new_set(AS_SET);
-    for (uint32_t i = 0; i < as_path.path_length(); i++) {
-	const ASSegment *s = &(as_path.segment(i));
-	for (uint32_t j = 0; j < s->path_length(); j++) {
+    vector<ASSegment> old_segs;
+    as_path.segments(old_segs);
+    bool enough = false;
+    for (uint32_t i = 0; i < old_segs.size() && !enough; i++) {
+	const ASSegment *s = &old_segs[i];
+	for (uint32_t j = 0; j < s->as_size(); j++) {
 	    const AsNum *asn = &(s->as_num(j));
 	    if (asn->as() == AsNum::AS_TRAN)
 		continue;
@@ -1050,18 +1350,22 @@ void AS4Path::do_patchup(const ASPath& as_path)
 		if (new_set.path_length() + path_length() 
 		    == as_path.path_length()) {
 		    // we've got enough now
-		    i = as_path.path_length(); break;
+		    enough = true;
+		    break;
 		}
 	    }
 	}
     }
     // All this work, and we've still not got enough ASes in the AS
     // path. Artificially inflate it.
-    if (_segments.front().type() == AS_SET) {
+    vector<ASSegment> segs;
+    segments(segs);
+    if (!segs.empty() && segs.front().type() == AS_SET) {
 	// need to merge two sets
-	for (uint32_t i = 0; i < new_set.path_length(); i++) {
-	    _segments.front().add_as(new_set.as_num(i));
+	for (uint32_t i = 0; i < new_set.as_size(); i++) {
+	    segs.front().add_as(new_set.as_num(i));
 	}
+	assign(segs);
     } else {
 	prepend_segment(new_set);
     }
@@ -1072,42 +1376,3 @@ void AS4Path::do_patchup(const ASPath& as_path)
     }
     return;
 }
-
-const uint8_t *
-AS4Path::encode(size_t &len, uint8_t *buf) const
-{
-    debug_msg("AS4Path::encode\n");
-    XLOG_ASSERT(_num_segments == _segments.size());	// XXX expensive
-    const_iterator i;
-    size_t pos, l = wire_size();
-
-    // allocate or check the memory.
-    if (buf == 0)		// no buffer, allocate one
-	buf = new uint8_t[l];
-    else			// we got a buffer, make sure is large enough.
-	XLOG_ASSERT(len >= l);	// in fact, just abort if not so.
-    len = l;			// set the correct value.
-
-    // encode into the buffer
-    for (pos = 0, i = _segments.begin(); i != _segments.end(); ++i) {
-	const AS4Segment *new_seg = (const AS4Segment*)(&(*i));
-	l = new_seg->wire_size();
-	new_seg->encode(l, buf + pos);
-	pos += l;
-    }
-    return buf;
-}
-
-
-size_t
-AS4Path::wire_size() const
-{
-    size_t l = 0;
-    const_iterator i;
-
-    for (i = _segments.begin(); i != _segments.end(); ++i) {
-	const AS4Segment *new_seg = (const AS4Segment*)(&(*i));
-	l += new_seg->wire_size();
-    }
-    return l;
-}
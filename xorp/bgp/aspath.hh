@@ -54,11 +54,20 @@ class AS4Path;
  *   1 byte:	number of element in the segment
  *   n entries:	the ASnumbers in the segment, 2 or 4 bytes each
  *
- * In terms of internal representation, it might be more efficient
- * useful to store segments as either an AS_SET, or a sequence of size 1,
- * and then do the necessary grouping on output.
+ * Internally, an ASPath stores its segments back to back in a single
+ * array of 32-bit words: a header word holding the segment type and
+ * the number of AS numbers, followed by the AS numbers themselves, in
+ * their 4-byte form.  The array is interned, so the ASPath objects
+ * holding the same path share one copy, and it is never modified:
+ * changing a path builds a new array.  Comparing two paths for
+ * equality is then a pointer comparison, and copying a path is a
+ * reference count increment.  ASSegment is only used to build and
+ * inspect paths one segment at a time.
  *
- * The current implementation allows both forms.
+ * The intern table belongs to the main thread.  A thread decoding
+ * messages for it holds an ASPath::DeferIntern: the paths it builds
+ * are then private to the objects holding them, and are only interned
+ * when the main thread calls intern() on them.
  *
  * Note that the external representation (provided by encode()) returns
  * a malloc'ed chunk of memory which must be freed by the caller.
@@ -121,7 +130,7 @@ enum ASPathSegType {
  */
 class ASSegment {
 public:
-    typedef list<AsNum> ASLIST;
+    typedef vector<AsNum> ASLIST;
     typedef ASLIST::iterator iterator;
     typedef ASLIST::const_iterator const_iterator;
     typedef ASLIST::const_reverse_iterator const_reverse_iterator;
@@ -197,7 +206,7 @@ public:
      */
     void prepend_as(const AsNum& n)			{
 	debug_msg("Number of As entries %u\n", XORP_UINT_CAST(_aslist.size()));
-	_aslist.push_front(n);
+	_aslist.insert(_aslist.begin(), n);
     }
 
     /**
@@ -218,12 +227,7 @@ public:
      * find the n'th AS number in the segment 
      */
     const AsNum& as_num(int n) const			{
-	const_iterator i = _aslist.begin();
-
-	while (n--)
-	    i++;
-
-	return *i;
+	return _aslist[n];
     }
 
     /**
@@ -315,16 +319,59 @@ private:
     /* no storage, as this is handled by the underlying ASSegment */
 };
 
+/**
+ * The interned form of an AS path.
+ *
+ * The words are laid out as described at the top of this file.  The
+ * values that the decision process and the filters need are computed
+ * once, when the path is interned.  The objects are owned by the
+ * intern table, and are shared by reference between all the ASPath
+ * objects holding the same path.
+ */
+class ASPathData {
+public:
+    /**
+     * Build a segment header word.
+     */
+    static uint32_t header(ASPathSegType type, size_t n)	{
+	return (static_cast<uint32_t>(type) << 24) | n;
+    }
+    static ASPathSegType seg_type(uint32_t header)	{
+	return static_cast<ASPathSegType>(header >> 24);
+    }
+    static size_t seg_size(uint32_t header)		{
+	return header & 0xffffff;
+    }
+
+    const uint32_t* begin() const		{ return &_words[0]; }
+    const uint32_t* end() const		{ return begin() + _words.size(); }
+
+private:
+    friend class ASPath;
+    friend class ASPathTable;
+
+    ASPathData(vector<uint32_t>& words, uint32_t hash);
+
+    vector<uint32_t>	_words;
+    uint32_t		_hash;
+    size_t		_num_segments;
+    size_t		_num_as;	// AS numbers in all the segments
+    size_t		_path_len;
+    AsNum		_first_as;	// AS_INVALID if none
+    ASPathSegType	_first_type;
+    bool		_confed;	// has confederation segments
+    bool		_interned;	// in the intern table
+    mutable uint32_t	_refs;
+    ASPathData*		_next;		// intern table chain
+};
+
 /**
  * An ASPath is a list of ASSegments, each of which can be an AS_SET,
  * AS_CONFED_SET, AS_SEQUENCE, or an AS_CONFED_SEQUENCE.
  */
 class ASPath {
 public:
-    typedef list <ASSegment>::const_iterator const_iterator;
-    typedef list <ASSegment>::iterator iterator;
-
-    ASPath() : _num_segments(0), _path_len(0)		{}
+    ASPath() : _data(0)					{}
 
     /**
      * Initialize from a string in the format
@@ -335,8 +382,8 @@ public:
     /**
      * construct from received data
      */
-    ASPath(const uint8_t* d, size_t len) throw(CorruptMessage) {
-	decode(d, len); 
+    ASPath(const uint8_t* d, size_t len) throw(CorruptMessage) : _data(0) {
+	decode(d, len, 2); 
     }
 
     /**
@@ -347,44 +394,51 @@ public:
     /**
      * Copy constructor
      */
-    ASPath(const ASPath &a) : _segments(a._segments), 
-	_num_segments(a._num_segments), _path_len(a._path_len) {}
+    ASPath(const ASPath &a) : _data(a._data)		{
+	if (_data != 0)
+	    _data->_refs++;
+    }
 
-    ~ASPath()						{}
+    ~ASPath()						{ release(); }
 
     void add_segment(const ASSegment& s);
     void prepend_segment(const ASSegment& s);
 
-    size_t path_length() const				{ return _path_len; }
-
-    bool contains(const AsNum& as_num) const		{
-	const_iterator i = _segments.begin();
-	for (; i != _segments.end(); ++i)
-	    if ((*i).contains(as_num))
-		return true;
-	return false;
+    /**
+     * @return the path length, computed when the path was built.
+     */
+    size_t path_length() const			{
+	return _data != 0 ? _data->_path_len : 0;
     }
 
-    const AsNum& first_asnum() const			{
-	XLOG_ASSERT(!_segments.empty());
-	return _segments.front().first_asnum();
-    }
+    bool contains(const AsNum& as_num) const;
+
+    /**
+     * @return the first AS number of the path, i.e. the neighbour AS.
+     */
+    const AsNum& first_asnum() const;
 
     string str() const;
     string short_str() const;
 
-    const ASSegment& segment(size_t n) const		{
-	if (n < _num_segments) {
-	    const_iterator iter = _segments.begin();
-	    for (u_int i = 0; i<n; i++)
-		++iter;
-	    return (*iter);
-        }
-	XLOG_FATAL("Segment %u doesn't exist.", (uint32_t)n);
-	xorp_throw(InvalidString, "segment invalid n\n");
+    /**
+     * @return a copy of the n'th segment.
+     */
+    ASSegment segment(size_t n) const;
+
+    /**
+     * @return the type of the n'th segment.
+     */
+    ASPathSegType segment_type(size_t n) const;
+
+    size_t num_segments() const			{
+	return _data != 0 ? _data->_num_segments : 0;
     }
 
-    size_t num_segments() const			{ return _num_segments; }
+    /**
+     * Copy all the segments out.
+     */
+    void segments(vector<ASSegment>& segs) const;
 
     /**
      * Convert from internal to external representation, with the
@@ -397,13 +451,14 @@ public:
      * input buffer, which must be large enough to store the encoding.
      * @return the pointer to the buffer, len is the actual size.
      */
-    const uint8_t *encode(size_t &len, uint8_t *buf) const;
+    const uint8_t *encode(size_t &len, uint8_t *buf) const {
+	return encode(len, buf, 2);
+    }
 
     /**
      * @return the size of the list on the wire.
-     * XXX this should be made more efficient.
      */
-    size_t wire_size() const;
+    size_t wire_size() const			{ return wire_size(2); }
 
     /**
      * Add the As number to the begining of the AS_SEQUENCE that starts
@@ -428,11 +483,22 @@ public:
     /**
      * @return true if the AS_PATH Contains confederation segments.
      */
-    bool contains_confed_segments() const;
+    bool contains_confed_segments() const	{
+	return _data != 0 && _data->_confed;
+    }
 
     ASPath& operator=(const ASPath& him);
 
-    bool operator==(const ASPath& him) const;
+    /**
+     * Paths are interned, so equal paths share their data.
+     */
+    bool operator==(const ASPath& him) const	{
+	return _data == him._data;
+    }
+
+    bool operator!=(const ASPath& him) const	{
+	return _data != him._data;
+    }
 
     bool operator<(const ASPath& him) const;
 
@@ -451,19 +517,71 @@ public:
      */
     void merge_as4_path(AS4Path& as4_path);
 
+    /**
+     * @return the number of distinct paths currently interned.
+     */
+    static size_t interned_paths();
+
+    /**
+     * Intern a path built while interning was deferred.  It must not
+     * be compared or copied before.  Only call on the main thread.
+     */
+    void intern();
+
+    /**
+     * @return true if the path is interned, or empty.
+     */
+    bool interned() const		{ return _data == 0 || _data->_interned; }
+
+    /**
+     * While an object of this class is in scope, the paths built by
+     * the current thread are not interned.
+     */
+    class DeferIntern {
+    public:
+	DeferIntern();
+	~DeferIntern();
+    private:
+	bool _saved;
+    };
+
 protected:
     /**
-     * internal representation
+     * populate an ASPath from received data, with AS numbers of
+     * as_size bytes.
      */
-    list <ASSegment>	_segments;
-    size_t		_num_segments;
-    size_t		_path_len;
+    void decode(const uint8_t *d, size_t len, size_t as_size)
+	throw(CorruptMessage);
+
+    const uint8_t *encode(size_t &len, uint8_t *buf, size_t as_size) const;
+
+    size_t wire_size(size_t as_size) const	{
+	if (_data == 0)
+	    return 0;
+	return 2 * _data->_num_segments + as_size * _data->_num_as;
+    }
+
+    /**
+     * Replace the segments.
+     */
+    void assign(const vector<ASSegment>& segs);
+
+    /**
+     * Replace the path with the given words, which are consumed.
+     */
+    void set_words(vector<uint32_t>& words);
 
-private:
     /**
-     * populate an ASPath from received data. Only used in the constructor.
+     * Build a new path with the AS number added at the front.
      */
-    void decode(const uint8_t *d, size_t len) throw(CorruptMessage);
+    void prepend(ASPathSegType type, const AsNum& asn);
+
+    void release();
+
+    /**
+     * internal representation, 0 for an empty path.
+     */
+    const ASPathData*	_data;
 };
 
 /* subclass to handle 4-byte AS encoding and decoding */
@@ -502,17 +620,17 @@ public:
      * input buffer, which must be large enough to store the encoding.
      * @return the pointer to the buffer, len is the actual size.
      */
-    const uint8_t *encode(size_t &len, uint8_t *buf) const;
+    const uint8_t *encode(size_t &len, uint8_t *buf) const {
+	return ASPath::encode(len, buf, 4);
+    }
 
-    size_t wire_size() const;
+    size_t wire_size() const			{
+	return ASPath::wire_size(4);
+    }
 
     void cross_validate(const ASPath& as_path);
 
 private:
-    /**
-     * populate an ASPath from received data. Only used in the constructor.
-     */
-    void decode(const uint8_t *d, size_t len) throw(CorruptMessage);
     void pad_segment(const ASSegment& old_seg, ASSegment& new_seg);
     void do_patchup(const ASPath& as_path);
 };
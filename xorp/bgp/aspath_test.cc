@@ -30,6 +30,9 @@
 #include <getopt.h>
 #endif
 
+#include "libxorp/timeval.hh"
+#include "libxorp/timer.hh"
+
 #include "aspath.hh"
 
 void
@@ -284,6 +287,141 @@ test_as4_coding_compat(bool verbose)
     assert(compat_aspath == dec_aspath);
 }
 
+void
+test_interning(bool verbose)
+{
+    /*********************************************************************/
+    /**** testing that equal paths share their storage                ****/
+    /*********************************************************************/
+
+    if (verbose)
+	printf("Test6 interning of AS paths\n");
+
+    size_t before = ASPath::interned_paths();
+    {
+	ASPath a("1,2,3,{4,5}");
+	ASPath b("1,2,3,{4,5}");
+	ASPath c("2,3,{4,5}");
+
+	assert(ASPath::interned_paths() == before + 2);
+	assert(a == b);
+	assert(!(a == c));
+	assert(c < a);
+	assert(!(a < b) && !(b < a));
+
+	// Prepending an AS to an existing path yields the existing
+	// path.
+	c.prepend_as(AsNum(1));
+	assert(a == c);
+	assert(ASPath::interned_paths() == before + 1);
+	assert(c.path_length() == 4);
+	assert(c.first_asnum() == AsNum(1));
+
+	c.prepend_confed_as(AsNum(65001));
+	assert(c.contains_confed_segments());
+	assert(c.path_length() == 5);
+	c.remove_confed_segments();
+	assert(a == c);
+    }
+    assert(ASPath::interned_paths() == before);
+}
+
+/*
+** A run of the benchmark: the time per operation in nanoseconds.
+*/
+static double
+ns_per_op(const TimeVal& start, const TimeVal& end, size_t ops)
+{
+    return (end - start).get_double() * 1.0e9 / ops;
+}
+
+void
+benchmark(bool verbose, size_t count)
+{
+    /*********************************************************************/
+    /**** timing decode, compare and prepend                          ****/
+    /*********************************************************************/
+
+    if (verbose)
+	printf("Benchmark with %u paths\n", XORP_UINT_CAST(count));
+
+    /*
+    ** Paths of 2 to 9 ASes, about half of them distinct, as seen in a
+    ** full table.
+    */
+    vector<vector<uint8_t> > wire(count);
+    for (size_t i = 0; i < count; i++) {
+	ASSegment seq(AS_SEQUENCE);
+	size_t len = 2 + (i / 2) % 8;
+	for (size_t j = 0; j < len; j++)
+	    seq.add_as(AsNum(static_cast<uint32_t>(1 + (i / 2 + j * 7) % 60000)));
+	ASPath path;
+	path.add_segment(seq);
+
+	wire[i].resize(path.wire_size());
+	size_t l = wire[i].size();
+	path.encode(l, &wire[i][0]);
+    }
+
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    vector<ASPath> paths;
+    paths.reserve(count);
+    for (size_t i = 0; i < count; i++)
+	paths.push_back(ASPath(&wire[i][0], wire[i].size()));
+
+    TimerList::system_gettimeofday(&end);
+    if (verbose)
+	printf("decode:  %.0f ns/path, %u distinct paths\n",
+	       ns_per_op(start, end, count),
+	       XORP_UINT_CAST(ASPath::interned_paths()));
+
+    // The decision process compares the path lengths and the
+    // neighbour ASes, the attribute manager compares whole paths.
+    size_t equal = 0, shorter = 0, same_neighbour = 0;
+    TimerList::system_gettimeofday(&start);
+
+    for (size_t i = 1; i < count; i++) {
+	if (paths[i] == paths[i - 1])
+	    equal++;
+	if (paths[i].path_length() < paths[i - 1].path_length())
+	    shorter++;
+	if (paths[i].first_asnum() == paths[i - 1].first_asnum())
+	    same_neighbour++;
+    }
+
+    TimerList::system_gettimeofday(&end);
+    if (verbose)
+	printf("compare: %.0f ns/path (%u equal, %u shorter, "
+	       "%u same neighbour)\n",
+	       ns_per_op(start, end, count - 1), XORP_UINT_CAST(equal),
+	       XORP_UINT_CAST(shorter), XORP_UINT_CAST(same_neighbour));
+
+    TimerList::system_gettimeofday(&start);
+
+    sort(paths.begin(), paths.end());
+
+    TimerList::system_gettimeofday(&end);
+    if (verbose)
+	printf("sort:    %.0f ns/path\n", ns_per_op(start, end, count));
+
+    for (size_t i = 1; i < count; i++)
+	assert(!(paths[i] < paths[i - 1]));
+
+    TimerList::system_gettimeofday(&start);
+
+    for (size_t i = 0; i < count; i++)
+	paths[i].prepend_as(AsNum(static_cast<uint32_t>(65000)));
+
+    TimerList::system_gettimeofday(&end);
+    if (verbose)
+	printf("prepend: %.0f ns/path\n", ns_per_op(start, end, count));
+
+    for (size_t i = 0; i < count; i++)
+	assert(paths[i].first_asnum() == AsNum(static_cast<uint32_t>(65000)));
+}
+
 
 int
 main(int argc, char* argv[])
@@ -387,6 +525,8 @@ main(int argc, char* argv[])
     test_string_as4(verbose);
     test_as4_coding(verbose);
     test_as4_coding_compat(verbose);
+    test_interning(verbose);
+    benchmark(verbose, 100000);
 
     if (verbose) printf("All tests passed\n");
 #if 0
@@ -23,6 +23,17 @@
 #include "bgp_module.h"
 #include "attribute_manager.hh"
 
+// Implementation Notes:
+//
+// The table uses linear probing.  A list is stored in the first free
+// slot at or after the slot its hash maps to, so a lookup stops at the
+// first free slot.  Deletion shifts back the entries that follow, so
+// that there never is a free slot between an entry and its home.
+//
+// The table holds a reference to every stored list, so a list is not
+// deleted before it is erased from the table.  The table is grown when
+// three quarters full, and shrunk when less than an eighth full.
+
 #if 0
 template <class A>
 bool
@@ -32,10 +43,21 @@ StoredAttributeList<A>::operator<(const StoredAttributeList<A>& them) const
 }
 #endif
 
+template <class A>
+const size_t AttributeManager<A>::MIN_TABLE_SIZE;
+
 template <class A>
 AttributeManager<A>::AttributeManager()
 {
-    _total_references = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    _table = new Slot[MIN_TABLE_SIZE];
+    _mask = MIN_TABLE_SIZE - 1;
+}
+
+template <class A>
+AttributeManager<A>::~AttributeManager()
+{
+    delete[] _table;
 }
 
 template <class A>
@@ -43,25 +65,36 @@ PAListRef<A>
 AttributeManager<A>::add_attribute_list(PAListRef<A>& palist)
 {
     debug_msg("AttributeManager<A>::add_attribute_list\n");
-    typedef typename set<PAListRef<A>, Att_Ptr_Cmp<A> >::iterator Iter;
-    Iter i = _attribute_lists.find(palist);
+    size_t pos = find(palist);
+    Slot& slot = _table[pos];
 
-    if (i == _attribute_lists.end()) {
-	_attribute_lists.insert(palist);
+    _stats.lookups++;
+    _stats.references++;
+
+    if (slot.palist.is_empty()) {
+	slot.hash = palist->hash();
+	slot.palist = palist;
 	palist->incr_managed_refcount(1);
+	_stats.lists++;
+	_stats.bytes += palist->canonical_length();
 	debug_msg("** new att list\n");
 	debug_msg("** (+) ref count for %p now %u\n",
 		  palist.attributes(), palist->managed_references());
+
+	if (_stats.lists * 4 > (_mask + 1) * 3)
+	    resize((_mask + 1) * 2);
 	return palist;
     }
 
-    (*i)->incr_managed_refcount(1);
+    slot.palist->incr_managed_refcount(1);
+    _stats.hits++;
+    _stats.bytes_shared += slot.palist->canonical_length();
     debug_msg("** old att list\n");
     debug_msg("** (+) ref count for %p now %u\n",
-	      (*i).attributes(), (*i)->managed_references());
+	      slot.palist.attributes(), slot.palist->managed_references());
     debug_msg("done\n");
 
-    return *i;
+    return slot.palist;
 }
 
 template <class A>
@@ -70,19 +103,86 @@ AttributeManager<A>::delete_attribute_list(PAListRef<A>& palist)
 {
     debug_msg("AttributeManager<A>::delete_attribute_list %p\n",
 	      palist.attributes());
-    typedef typename set<PAListRef<A>, Att_Ptr_Cmp<A> >::iterator Iter;
-    Iter i = _attribute_lists.find(palist);
-    assert(i != _attribute_lists.end());
+    size_t pos = find(palist);
+    const PathAttributeList<A>* stored = _table[pos].palist.attributes();
+    assert(stored != 0);
 
-    XLOG_ASSERT((*i)->managed_references()>=1);
-    (*i)->decr_managed_refcount(1);
+    XLOG_ASSERT(stored->managed_references()>=1);
+    stored->decr_managed_refcount(1);
+    _stats.references--;
 
     debug_msg("** (-) ref count for %p now %u\n",
-	      (*i).attributes(), (*i)->managed_references());
+	      stored, stored->managed_references());
+
+    if (stored->managed_references() >= 1) {
+	_stats.bytes_shared -= stored->canonical_length();
+	return;
+    }
+
+    _stats.lists--;
+    _stats.bytes -= stored->canonical_length();
+    erase(pos);
+
+    if (_mask + 1 > MIN_TABLE_SIZE && _stats.lists * 8 < _mask + 1)
+	resize((_mask + 1) / 2);
+}
+
+template <class A>
+size_t
+AttributeManager<A>::find(const PAListRef<A>& palist) const
+{
+    uint32_t hash = palist->hash();
+    size_t pos = hash & _mask;
 
-    if ((*i)->managed_references() < 1) {
-	_attribute_lists.erase(i);
+    while (!_table[pos].palist.is_empty()) {
+	if (_table[pos].hash == hash && _table[pos].palist == palist)
+	    return pos;
+	pos = (pos + 1) & _mask;
+    }
+
+    return pos;
+}
+
+template <class A>
+void
+AttributeManager<A>::erase(size_t pos)
+{
+    size_t hole = pos;
+    size_t next = (pos + 1) & _mask;
+
+    while (!_table[next].palist.is_empty()) {
+	// Move the entry back if the hole is between its home and it
+	size_t home = _table[next].hash & _mask;
+	if (((next - home) & _mask) >= ((next - hole) & _mask)) {
+	    _table[hole] = _table[next];
+	    hole = next;
+	}
+	next = (next + 1) & _mask;
     }
+
+    _table[hole].palist.release();
+}
+
+template <class A>
+void
+AttributeManager<A>::resize(size_t size)
+{
+    Slot* old_table = _table;
+    size_t old_size = _mask + 1;
+
+    _table = new Slot[size];
+    _mask = size - 1;
+
+    for (size_t i = 0; i < old_size; i++) {
+	if (old_table[i].palist.is_empty())
+	    continue;
+	size_t pos = old_table[i].hash & _mask;
+	while (!_table[pos].palist.is_empty())
+	    pos = (pos + 1) & _mask;
+	_table[pos] = old_table[i];
+    }
+
+    delete[] old_table;
 }
 
 template class AttributeManager<IPv4>;
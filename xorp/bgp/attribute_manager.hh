@@ -60,29 +60,15 @@ private:
 #endif
 
 /**
- * Att_Ptr_Cmp is needed because we want BGPAttributeManager to use a
- * set of pointers, but when we check to see if something's in the set,
- * we want to compare the data and not the pointers themselves.  This
- * forces the right comparison.
+ * AttributeManager statistics, the same for all address families.
  */
-template <class A>
-class Att_Ptr_Cmp {
-public:
-    bool operator() (const PAListRef<A>& a, const PAListRef<A>& b) const {
-/*	printf("Att_Ptr_Cmp [%s] < [%s] ?\n", a->attribute()->str().c_str(),
-	b->attribute()->str().c_str());*/
-#ifdef OLDWAY
-	if (*(a->attribute()) < *(b->attribute())) {
-	    //	    printf("true\n");
-	    return true;
-	} else {
-	    //	    printf("false\n");
-	    return false;
-	}
-#else
-	return a < b;
-#endif
-    }
+struct AttributeManagerStats {
+    uint32_t lists;		// distinct lists stored
+    uint32_t references;	// references to the stored lists
+    uint64_t bytes;		// canonical data bytes stored
+    uint64_t bytes_shared;	// bytes not stored thanks to sharing
+    uint64_t lookups;		// lists added
+    uint64_t hits;		// lists added that were already stored
 };
 
 /**
@@ -92,20 +78,41 @@ public:
  * it gives you back a pointer to where it stored it.  To unstore
  * something, you just tell it to delete it, and the undeletion is
  * handled for you if no-one else is still referencing a copy.
+ *
+ * The lists are kept in an open addressing hash table, keyed by the
+ * hash of their canonical data, which the lists compute once when
+ * they are created.  The data of two lists is only compared when
+ * their hashes are equal.
  */
 template <class A>
 class AttributeManager {
 public:
+    typedef AttributeManagerStats Stats;
+
     AttributeManager();
+    ~AttributeManager();
     PAListRef<A> add_attribute_list(PAListRef<A>& attribute_list);
     void delete_attribute_list(PAListRef<A>& attribute_list);
     int number_of_managed_atts() const {
-	return _attribute_lists.size();
+	return _stats.lists;
     }
+    const Stats& stats() const { return _stats; }
+
+    static const size_t MIN_TABLE_SIZE = 1024;
+
 private:
-    // set above for explanation of Att_Ptr_Cmp
-    set <PAListRef<A>, Att_Ptr_Cmp<A> > _attribute_lists;
-    int _total_references;
+    struct Slot {
+	uint32_t hash;
+	PAListRef<A> palist;	// empty if the slot is free
+    };
+
+    size_t find(const PAListRef<A>& palist) const;
+    void erase(size_t pos);
+    void resize(size_t size);
+
+    Slot* _table;
+    size_t _mask;		// table size - 1, the size is a power of 2
+    Stats _stats;
 };
 
 #endif // __BGP_ATTRIBUTE_MANAGER_HH__
@@ -51,10 +51,13 @@
 BGPMain::BGPMain(EventLoop& eventloop)
     : _eventloop(eventloop),
       _exit_loop(false),
+      _update_groups(eventloop),
+      _update_decoder(eventloop),
       _component_count(0),
       _ifmgr(NULL),
       _is_ifmgr_ready(false),
-      _first_policy_push(false)
+      _first_policy_push(false),
+      _incremental_policy_push(true)
 {
     debug_msg("BGPMain object created\n");
     /*
@@ -1902,19 +1905,28 @@ void
 BGPMain::configure_filter(const uint32_t& filter, const string& conf)
 {
     _policy_filters.configure(filter,conf);
+    _update_groups.regroup();
 }
 
 void
 BGPMain::reset_filter(const uint32_t& filter)
 {
     _policy_filters.reset(filter);
+    _update_groups.regroup();
 }
 
 void
 BGPMain::push_routes()
 {
-    _plumbing_unicast->push_routes();
-    _plumbing_multicast->push_routes();
+    // The changes are taken even for a full push, so that the next
+    // incremental push starts from the configuration pushed here.
+    FilterChanges changes;
+    _policy_filters.take_changes(changes);
+    debug_msg("Policy changes: %s", changes.str().c_str());
+
+    const FilterChanges* affected = _incremental_policy_push ? &changes : NULL;
+    _plumbing_unicast->push_routes(affected);
+    _plumbing_multicast->push_routes(affected);
 
     if (!_first_policy_push) {
 	_first_policy_push = true;
@@ -36,6 +36,7 @@
 #include "path_attribute.hh"
 #include "peer_handler.hh"
 #include "process_watch.hh"
+#include "update_group.hh"
 
 #include "libfeaclient/ifmgr_xrl_mirror.hh"
 #include "policy/backend/version_filters.hh"
@@ -647,6 +648,50 @@ public:
     BGPPlumbing *plumbing_unicast() const { return _plumbing_unicast; }
     BGPPlumbing *plumbing_multicast() const { return _plumbing_multicast; }
 
+    /**
+     * @return the update groups of the established peers.
+     */
+    UpdateGroupTable& update_groups() { return _update_groups; }
+
+    /**
+     * @return the decoder of the UPDATE messages received.
+     */
+    UpdateDecoder& update_decoder() { return _update_decoder; }
+
+    /**
+     * Set the number of threads decoding the UPDATE messages received.
+     *
+     * @param threads the number of threads, 0 to decode the messages
+     * on the main thread.
+     * @param error_msg the error message (if error).
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int set_decode_threads(uint32_t threads, string& error_msg) {
+	return _update_decoder.set_threads(threads, error_msg);
+    }
+
+    /**
+     * Select the fast dump mode for the table dumps to the peerings
+     * that come up from now on.
+     *
+     * @param fast true to dump routes in batches, with the peerings
+     * that come up together sharing a walk of the RibIns.
+     */
+    void set_fast_dump(bool fast) {
+	DumpTable<IPv4>::set_fast_dump(fast);
+	DumpTable<IPv6>::set_fast_dump(fast);
+    }
+
+    /**
+     * Select how the routes are pushed through the policy filters.
+     *
+     * @param incremental true to only push the routes the policy
+     * changes since the last push may affect, false to push all routes.
+     */
+    void set_incremental_policy_push(bool incremental) {
+	_incremental_policy_push = incremental;
+    }
+
     XrlStdRouter *get_router() { return _xrl_router; }
     EventLoop& eventloop() { return _eventloop; }
     XrlBgpTarget *get_xrl_target() { return _xrl_target; }
@@ -721,6 +766,9 @@ public:
 
     /**
      * Push routes through policy filters for re-filtering.
+     *
+     * Unless disabled, only the routes the policy changes since the last
+     * push may affect are pushed.
      */
     void push_routes();
 
@@ -962,6 +1010,17 @@ private:
     */
     BGPPlumbing *_plumbing_multicast;
 
+    /**
+     * Peers sent the same UPDATE messages, by a shared output branch.
+     */
+    UpdateGroupTable _update_groups;
+
+    /**
+     * The threads decoding the UPDATE messages received, shared by
+     * all the peers.
+     */
+    UpdateDecoder _update_decoder;
+
     /**
      * Token generator to map between unicast and multicast.
      */
@@ -1051,6 +1110,8 @@ private:
 
     bool _first_policy_push;	     	// Don't form peerings until the
 					// first policy push is seen.
+    bool _incremental_policy_push;	// Only push the routes the policy
+					// changes may affect.
 
 #ifdef HAVE_IPV6
 
@@ -33,11 +33,10 @@ ChainedSubnetRoute(const SubnetRoute<A>& route,
     if (prev != NULL) {
 	set_prev(prev);
 	set_next(prev->next());
-	_prev->set_next(this);
-	_next->set_prev(this);
+	prev->set_next(this);
+	next()->set_prev(this);
     } else {
-	_prev = this;
-	_next = this;
+	_prev = _next = slab().index(this);
     }
 }
 
@@ -46,18 +45,32 @@ ChainedSubnetRoute<A>::
 ChainedSubnetRoute(const ChainedSubnetRoute<A>& original)
     : SubnetRoute<A>(original)
 {
-    _prev = &original;
-    _next = original.next();
+    set_prev(&original);
+    set_next(original.next());
     original.set_next(this);
-    _next->set_prev(this);
+    next()->set_prev(this);
 }
 
 template<class A>
 bool
 ChainedSubnetRoute<A>::unchain() const {
-    _prev->set_next(_next);
-    _next->set_prev(_prev);
-    return _next != this;
+    prev()->set_next(next());
+    next()->set_prev(prev());
+    return next() != this;
+}
+
+template<class A>
+void*
+ChainedSubnetRoute<A>::operator new(size_t/* size*/)
+{
+    return slab().alloc();
+}
+
+template<class A>
+void
+ChainedSubnetRoute<A>::operator delete(void* ptr)
+{
+    SlabAllocator::free(ptr);
 }
 
 /*************************************************************************/
@@ -148,5 +161,31 @@ BgpTrie<A>::delete_all_nodes()
     ((RouteTrie*)this)->delete_all_nodes();
 }
 
+template<class A>
+void
+BgpTrie<A>::memory_usage(MemoryUsage& usage) const
+{
+    typedef RefTrieNode<A, const ChainedSubnetRoute> Node;
+    // A node of the red-black tree: its colour and three pointers.
+    static const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    size_t node_size =
+	SlabAllocator::size_class(sizeof(Node)).stats().object_size;
+    size_t route_size =
+	SlabAllocator::size_class(sizeof(ChainedSubnetRoute)).stats().object_size;
+
+    usage.routes = this->route_count();
+    usage.nodes = this->node_count();
+    usage.node_bytes = usage.nodes * node_size;
+    usage.route_bytes = usage.routes * route_size;
+    usage.chains = _pathmap.size();
+    usage.pathmap_bytes = usage.chains *
+	(sizeof(typename PathmapType::value_type) + MAP_NODE_OVERHEAD);
+}
+
+template void* ChainedSubnetRoute<IPv4>::operator new(size_t);
+template void ChainedSubnetRoute<IPv4>::operator delete(void*);
+template void* ChainedSubnetRoute<IPv6>::operator new(size_t);
+template void ChainedSubnetRoute<IPv6>::operator delete(void*);
 template class BgpTrie<IPv4>;
 template class BgpTrie<IPv6>;
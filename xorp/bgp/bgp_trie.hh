@@ -35,27 +35,44 @@ public:
     }
 };
 
+/**
+ * A SubnetRoute in a BgpTrie.  The routes with the same path attribute
+ * list are chained together.  The links of the chain are the indices
+ * of the routes in the slab they are allocated from, rather than
+ * pointers, which saves eight bytes on each route.  All the
+ * ChainedSubnetRoutes come from that slab, both the ones allocated
+ * with new and the payloads of the RefTrieNodes.
+ */
 template<class A>
 class ChainedSubnetRoute : public SubnetRoute<A> {
 public:
     ChainedSubnetRoute(const IPNet<A> &net,
 		       const PAListRef<A> attributes) :
-	SubnetRoute<A>(net, attributes), _prev(0), _next(0) {}
+	SubnetRoute<A>(net, attributes) {
+	_prev = _next = slab().index(this);
+    }
 
     ChainedSubnetRoute(const SubnetRoute<A>& route,
 		       const ChainedSubnetRoute<A>* prev);
 
     ChainedSubnetRoute(const ChainedSubnetRoute& csr);
 
-    const ChainedSubnetRoute<A> *prev() const { return _prev; }
-    const ChainedSubnetRoute<A> *next() const { return _next; }
+    const ChainedSubnetRoute<A> *prev() const { return route(_prev); }
+    const ChainedSubnetRoute<A> *next() const { return route(_next); }
 
     bool unchain() const;
 
+    void* operator new(size_t size);
+    void operator delete(void* ptr);
+
 protected:
-    void set_next(const ChainedSubnetRoute<A> *next) const { _next = next; }
+    void set_next(const ChainedSubnetRoute<A> *next) const {
+	_next = slab().index(next);
+    }
 
-    void set_prev(const ChainedSubnetRoute<A> *prev) const { _prev = prev; }
+    void set_prev(const ChainedSubnetRoute<A> *prev) const {
+	_prev = slab().index(prev);
+    }
 
     ChainedSubnetRoute& operator=(const ChainedSubnetRoute& csr); // Not impl.
 
@@ -66,13 +83,23 @@ private:
     friend class SubnetRoute<A>; //shut the compiler up.
     ~ChainedSubnetRoute() {}
 
+    static SlabAllocator& slab() {
+	static SlabAllocator& s =
+	    SlabAllocator::size_class(sizeof(ChainedSubnetRoute<A>));
+	return s;
+    }
+
+    static const ChainedSubnetRoute<A> *route(uint32_t index) {
+	return static_cast<const ChainedSubnetRoute<A> *>(slab().object(index));
+    }
+
     // it looks odd to have these be mutable and the methods to set
     // them be const, but that's because the chaining is really
     // conceptually part of the container, not the payload.  It these
     // aren't mutable we can't modify the chaining and have the payload
     // be const.
-    mutable const ChainedSubnetRoute<A> *_prev;
-    mutable const ChainedSubnetRoute<A> *_next;
+    mutable uint32_t _prev;
+    mutable uint32_t _next;
 };
 
 /**
@@ -120,6 +147,23 @@ public:
     typedef RefTrie<A, const ChainedSubnetRoute> RouteTrie;
     typedef typename RouteTrie::iterator iterator;
 
+    /**
+     * The memory held by a BgpTrie.  The path attribute lists are
+     * shared with the other tables, so they are not included.
+     */
+    struct MemoryUsage {
+	size_t routes;		// routes in the trie
+	size_t nodes;		// nodes, with or without a route
+	size_t node_bytes;
+	size_t route_bytes;
+	size_t chains;		// distinct path attribute lists
+	size_t pathmap_bytes;
+
+	size_t bytes() const {
+	    return node_bytes + route_bytes + pathmap_bytes;
+	}
+    };
+
     BgpTrie();
     ~BgpTrie();
 
@@ -131,6 +175,14 @@ public:
 
     const PathmapType& pathmap() const { return _pathmap; }
 
+    /**
+     * Account for the memory held by the trie.  This walks the whole
+     * trie.
+     *
+     * @param usage the memory usage.
+     */
+    void memory_usage(MemoryUsage& usage) const;
+
 private:
     PathmapType	_pathmap;
 };
@@ -36,9 +36,10 @@ Damping::Damping(EventLoop& eventloop)
 	 _damping(false),
 	 _half_life(15),
 	 _max_hold_down(60),
-	 _cutoff(3000),
-	 _tick(0)
+	 _reuse(750),
+	 _cutoff(3000)
 {
+    _eventloop.current_time(_start);
     init();
 }
 
@@ -88,10 +89,8 @@ Damping::init()
 {
     debug_msg("init\n");
 
-    if (!_damping) {
-	halt();
+    if (!_damping)
 	return;
-    }
 
     size_t array_size = _max_hold_down * 60;	// Into seconds.
     _decay.resize(array_size);
@@ -103,24 +102,6 @@ Damping::init()
 // 	printf("%d %d %f\n",i, _decay[i], decay_i);
 	decay_i = pow(decay_1, static_cast<int>(i + 2));
     }
-
-    // Start the timer to incement the tick
-    _tick_tock = _eventloop.new_periodic_ms(1000,
-					    callback(this, &Damping::tick));
-}
-
-void
-Damping::halt()
-{
-    _tick_tock.unschedule();
-}
-
-bool
-Damping::tick()
-{
-    _tick++;    
-
-    return true;
 }
 
 uint32_t
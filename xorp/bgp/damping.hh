@@ -32,6 +32,8 @@
 class Damping {
  public:
     static const uint32_t FIXED = 1000;
+    static const uint32_t REUSE_GRANULARITY = 5;	// Seconds covered by
+							// each reuse list.
 
     Damping(EventLoop& eventloop);
 
@@ -48,10 +50,13 @@ class Damping {
     void set_cutoff(uint32_t cutoff);
 
     /**
-     * Get the current clock tick.
+     * Get the current clock tick, the seconds since the damping
+     * parameters were created.
      */
     uint32_t get_tick() const {
-	return _tick;
+	TimeVal now;
+	_eventloop.current_time(now);
+	return (now - _start).sec();
     }
 
     /**
@@ -85,7 +90,15 @@ class Damping {
      * The time for this figure of merit to decay to the reuse threshold.
      */
     uint32_t get_reuse_time(uint32_t merit) const;
-	
+
+    /**
+     * The number of reuse lists, each REUSE_GRANULARITY seconds long,
+     * needed to hold a route for the maximum hold down time.
+     */
+    uint32_t get_reuse_lists() const {
+	return _max_hold_down * 60 / REUSE_GRANULARITY + 2;
+    }
+
  private:
     EventLoop& _eventloop;
     bool _damping;		// True if damping is enabled.
@@ -95,23 +108,12 @@ class Damping {
     uint32_t _cutoff;		// Cutoff threshold.
 
     vector<uint32_t> _decay;	// Per tick delay.
-    uint32_t _tick;		// incremented every tick.
-    XorpTimer _tick_tock;	// Timer to increment the tick.
+    TimeVal _start;		// The time of tick zero.
 
     /**
      * Called when damping is enabled.
      */
     void init();
-
-    /**
-     * Called when damping is disabled.
-     */
-    void halt();
-
-    /*
-     * Called every clock tick.
-     */
-    bool tick();
 };
 
 #endif // __BGP_DAMPING_HH__
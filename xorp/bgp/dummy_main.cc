@@ -32,7 +32,9 @@
 
 
 BGPMain::BGPMain(EventLoop& eventloop)
-    : _eventloop(eventloop)
+    : _eventloop(eventloop),
+      _update_groups(eventloop),
+      _update_decoder(eventloop)
 {
     _local_data = new LocalData(_eventloop);
     _xrl_router = NULL;
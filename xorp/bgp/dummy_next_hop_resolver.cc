@@ -88,3 +88,6 @@ DummyNextHopResolver<A>::unset_nexthop_metric(const A nexthop) {
 //force these templates to be built
 template class DummyNextHopResolver<IPv4>;
 
+#ifdef HAVE_IPV6
+template class DummyNextHopResolver<IPv6>;
+#endif
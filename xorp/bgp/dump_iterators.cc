@@ -145,6 +145,8 @@ DumpIterator<A>::DumpIterator(const PeerHandler* peer,
     }
     _route_iterator_is_valid = false;
     _routes_dumped_on_current_peer = false;
+    _restricted = false;
+    _overlapping_found = false;
 }
 
 template <class A>
@@ -266,6 +268,8 @@ DumpIterator<A>::next_peer()
     _aggr_iterator = aggr_empty;	
     _route_iterator_is_valid = false;
     _routes_dumped_on_current_peer = false;
+    _overlapping_found = false;
+    _overlapping.clear();
     if (_current_peer == _peers_to_dump.end())
 	return false;
     return true;
@@ -642,5 +646,44 @@ DumpIterator<A>::iterator_got_moved(IPNet<A> new_net) const
     }
 }
 
+template <class A>
+void
+DumpIterator<A>::peers_still_to_dump(list<const PeerHandler*>& peers) const
+{
+    typename list <PeerTableInfo<A> >::const_iterator i;
+    for (i = _peers_to_dump.begin(); i != _peers_to_dump.end(); i++) {
+	typename map <const PeerHandler*,
+		      PeerDumpState<A>* >::const_iterator state_i;
+	state_i = _peers.find(i->peer_handler());
+	XLOG_ASSERT(state_i != _peers.end());
+	switch (state_i->second->status()) {
+	case STILL_TO_DUMP:
+	case CURRENTLY_DUMPING:
+	    peers.push_back(i->peer_handler());
+	    break;
+	case DOWN_DURING_DUMP:
+	case DOWN_BEFORE_DUMP:
+	case COMPLETELY_DUMPED:
+	case NEW_PEER:
+	case FIRST_SEEN_DURING_DUMP:
+	    break;
+	}
+    }
+}
+
+template <class A>
+void
+DumpIterator<A>::take_over_walk(const DumpIterator<A>& other)
+{
+    XLOG_ASSERT(is_valid() && other.is_valid());
+    XLOG_ASSERT(current_peer() == other.current_peer());
+    XLOG_ASSERT(_routes_dumped_on_current_peer
+		== other._routes_dumped_on_current_peer);
+
+    _route_iterator = other._route_iterator;
+    _aggr_iterator = other._aggr_iterator;
+    _route_iterator_is_valid = other._route_iterator_is_valid;
+}
+
 template class DumpIterator<IPv4>;
 template class DumpIterator<IPv6>;
@@ -169,6 +169,36 @@ public:
      * @return true if the iterator got moved since the last delete
      */
     bool iterator_got_moved(IPNet<A> new_net) const;
+
+    /**
+     * The peers that are still to be dumped, in dump order, starting
+     * with the one being dumped.
+     */
+    void peers_still_to_dump(list<const PeerHandler*>& peers) const;
+
+    /**
+     * Carry on the walk of the RibIns of another iterator, which was
+     * dumping the same peer and the same routes as this one.
+     */
+    void take_over_walk(const DumpIterator<A>& other);
+
+    /**
+     * Only dump the routes whose network overlaps one of these networks.
+     */
+    void restrict_to(const set<IPNet<A> >& nets) {
+	_restricted = true;
+	_restricted_nets = nets;
+    }
+    bool restricted() const { return _restricted; }
+    const set<IPNet<A> >& restricted_nets() const { return _restricted_nets; }
+
+    /**
+     * The networks of the routes of the current peer which overlap the
+     * restricted networks and are still to be dumped.
+     */
+    bool overlapping_found() const { return _overlapping_found; }
+    void set_overlapping_found() { _overlapping_found = true; }
+    list<IPNet<A> >& overlapping() { return _overlapping; }
 private:
     const PeerHandler *_peer;
 
@@ -188,6 +218,11 @@ private:
 
     map <const PeerHandler*, PeerDumpState<A>* > _peers;
 
+    bool _restricted;
+    set<IPNet<A> > _restricted_nets;
+    bool _overlapping_found;
+    list<IPNet<A> > _overlapping;
+
 };
 
 #endif // __BGP_DUMP_ITERATORS_HH__
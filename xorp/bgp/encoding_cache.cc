@@ -0,0 +1,144 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+// #define DEBUG_LOGGING
+// #define DEBUG_PRINT_FUNCTION_NAME
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/debug.h"
+#include "libxorp/xlog.h"
+
+#include "encoding_cache.hh"
+
+// Implementation Notes:
+//
+// The encoding of a path attribute list only depends on the list and
+// on the 4 byte AS capability of the two ends: the AS path and the
+// aggregator are encoded with 2 byte AS numbers for an old peer, and
+// an AS4_PATH is added when we speak 4 byte AS numbers and the peer
+// does not.  The IPv6 multiprotocol attributes and the confederation
+// segments of the AS path are part of the list, so of the key.
+//
+// The canonical form of the list is what the RibOut compares when it
+// groups routes into UPDATEs, so it has normally been computed by the
+// time the UPDATE is encoded, and looking a list up costs a hash and
+// a memcmp().
+
+AttributeEncodingCache::AttributeEncodingCache()
+    : _enabled(true), _slots(SLOTS)
+{
+    reset_stats();
+}
+
+const uint8_t*
+AttributeEncodingCache::encode(const FPAList4Ref& pa_list, size_t& len,
+			       const BGPPeerData* peerdata)
+{
+    if (!_enabled) {
+	size_t wire_size = sizeof(_buf);
+	if (!pa_list->encode(_buf, wire_size, peerdata) || wire_size > len)
+	    return NULL;
+	len = wire_size;
+	return _buf;
+    }
+
+    pa_list->canonicalize();
+    const uint8_t* canonical = pa_list->canonical_data();
+    size_t canonical_length = pa_list->canonical_length();
+    uint32_t hash = canonical_hash(canonical, canonical_length);
+    uint32_t prof = profile(peerdata);
+
+    Entry& e = _slots[(hash ^ (prof * 0x9e3779b9U)) % SLOTS];
+    if (e.hash == hash && e.profile == prof
+	&& e.canonical_length == canonical_length
+	&& !e.data.empty()
+	&& memcmp(&e.data[0], canonical, canonical_length) == 0) {
+	size_t wire_size = e.data.size() - canonical_length;
+	if (wire_size > len)
+	    return NULL;
+	_stats.hits++;
+	len = wire_size;
+	return &e.data[canonical_length];
+    }
+
+    uint8_t buf[BGPPacket::MAXPACKETSIZE];
+    size_t wire_size = sizeof(buf);
+    if (!pa_list->encode(buf, wire_size, peerdata) || wire_size > len)
+	return NULL;
+    _stats.misses++;
+    if (!e.data.empty())
+	_stats.replaced++;
+
+    e.hash = hash;
+    e.profile = prof;
+    e.canonical_length = canonical_length;
+    e.data.assign(canonical, canonical + canonical_length);
+    e.data.insert(e.data.end(), buf, buf + wire_size);
+
+    len = wire_size;
+    return &e.data[canonical_length];
+}
+
+void
+AttributeEncodingCache::set_enabled(bool enabled)
+{
+    _enabled = enabled;
+
+    // Drop the entries, so the memory is released when disabled.
+    vector<Entry> slots(enabled ? SLOTS : 0);
+    _slots.swap(slots);
+}
+
+void
+AttributeEncodingCache::reset_stats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+string
+AttributeEncodingCache::str() const
+{
+    return c_format("%s: %llu hits, %llu misses, %llu replaced",
+		    _enabled ? "enabled" : "disabled",
+		    (unsigned long long)_stats.hits,
+		    (unsigned long long)_stats.misses,
+		    (unsigned long long)_stats.replaced);
+}
+
+AttributeEncodingCache&
+AttributeEncodingCache::shared()
+{
+    static AttributeEncodingCache* cache = NULL;
+
+    if (cache == NULL)
+	cache = new AttributeEncodingCache();
+
+    return *cache;
+}
+
+uint32_t
+AttributeEncodingCache::profile(const BGPPeerData* peerdata)
+{
+    return (peerdata->use_4byte_asnums() ? 1 : 0)
+	| (peerdata->we_use_4byte_asnums() ? 2 : 0);
+}
@@ -0,0 +1,112 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __BGP_ENCODING_CACHE_HH__
+#define __BGP_ENCODING_CACHE_HH__
+
+#include "packet.hh"
+#include "path_attribute.hh"
+#include "peer_data.hh"
+
+/**
+ * @short A cache of path attribute lists in wire format.
+ *
+ * Encoding the path attribute list of an UPDATE for a peer is most of
+ * the work of encoding the UPDATE, and consecutive UPDATEs, and the
+ * UPDATEs sent to different peers, often carry the same attributes.
+ * The cache keeps the encoded attributes, keyed by the canonical form
+ * of the list and by the encoding profile of the peer, so that an
+ * UPDATE with attributes seen recently is built with a memcpy().
+ *
+ * The cache is direct mapped: an entry is replaced by the next list
+ * that hashes to its slot.
+ */
+class AttributeEncodingCache {
+public:
+    /**
+     * Cache statistics.
+     */
+    struct Stats {
+	uint64_t	hits;		// lists found in the cache
+	uint64_t	misses;		// lists encoded
+	uint64_t	replaced;	// entries replaced by another list
+    };
+
+    /**
+     * The number of entries.
+     */
+    static const size_t SLOTS = 4096;
+
+    AttributeEncodingCache();
+
+    /**
+     * Get the wire format of a path attribute list for a peer.
+     *
+     * @param pa_list the path attribute list, which is canonicalized.
+     * @param len is given the size of the buffer the attributes will
+     * be copied to, and returns the size of the attributes.
+     * @param peerdata the data of the peer the list is encoded for.
+     * @return the attributes, valid until the next call, or NULL if
+     * they would not fit in len bytes.
+     */
+    const uint8_t* encode(const FPAList4Ref& pa_list, size_t& len,
+			  const BGPPeerData* peerdata);
+
+    /**
+     * Enable or disable the cache.  When it is disabled every list
+     * is encoded.
+     */
+    void set_enabled(bool enabled);
+    bool enabled() const		{ return _enabled; }
+
+    const Stats& stats() const		{ return _stats; }
+    void reset_stats();
+
+    string str() const;
+
+    /**
+     * @return the cache shared by all the peers.
+     */
+    static AttributeEncodingCache& shared();
+
+private:
+    AttributeEncodingCache(const AttributeEncodingCache&);	// Not implemented
+    AttributeEncodingCache& operator=(const AttributeEncodingCache&); // Not implemented
+
+    /**
+     * The properties of a peer the encoding of a list depends on.
+     */
+    static uint32_t profile(const BGPPeerData* peerdata);
+
+    struct Entry {
+	Entry() : hash(0), profile(0), canonical_length(0) {}
+
+	uint32_t	hash;
+	uint32_t	profile;
+	size_t		canonical_length;
+	vector<uint8_t>	data;		// The canonical form then the wire
+    };
+
+    bool		_enabled;
+    vector<Entry>	_slots;
+    uint8_t		_buf[BGPPacket::MAXPACKETSIZE];	// When disabled
+    Stats		_stats;
+};
+
+#endif // __BGP_ENCODING_CACHE_HH__
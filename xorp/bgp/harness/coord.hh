@@ -22,6 +22,7 @@
 #ifndef __BGP_HARNESS_COORD_HH__
 #define __BGP_HARNESS_COORD_HH__
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/coord_base.hh"
 #include "command.hh"
 
@@ -79,6 +80,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError coord_0_1_command(
 	// Input values, 
         const string&	command);
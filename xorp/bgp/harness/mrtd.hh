@@ -0,0 +1,187 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __BGP_HARNESS_MRTD_HH__
+#define __BGP_HARNESS_MRTD_HH__
+
+#include "libxorp/xlog.h"
+#include "libxorp/ipv4net.hh"
+
+#include "libproto/packet.hh"
+
+/*
+** Readers for the MRT files written by mrtd and zebra: update streams
+** (BGP4MP) and table dumps (TABLE_DUMP).  They are shared by the test
+** peer and the BGP replay benchmark.
+*/
+
+enum MrtType {
+    MRT_TABLE_DUMP = 12,
+    MRT_BGP4MP = 16
+};
+
+enum MrtTableDumpSubtype {
+    MRT_TABLE_DUMP_AFI_IPV4 = 1
+};
+
+struct mrt_header {
+    uint32_t time;
+    uint16_t type;
+    uint16_t subtype;
+    uint32_t length;
+};
+
+struct mrt_update {
+    uint16_t source_as;
+    uint16_t dest_as;
+    uint16_t ifindex;
+    uint16_t af;
+    uint32_t source_ip;
+    uint32_t dest_ip;
+};
+
+/**
+ * Read the next message from an MRT update stream.
+ *
+ * @param fp the file.
+ * @param len the length of the message.
+ * @return the BGP message including its header, which the caller must
+ * delete[], or 0 at the end of the file.
+ */
+inline
+const
+uint8_t *
+mrtd_traffic_file_read(FILE *fp, size_t& len)
+{
+    mrt_header header;
+
+    if(fread(&header, sizeof(header), 1, fp) != 1) {
+	if(feof(fp))
+	    return 0;
+	XLOG_WARNING("fread failed:%s", strerror(errno));
+	return 0;
+    }
+
+    len = ntohl(header.length) - sizeof(mrt_update);
+
+    mrt_update update;
+    if(fread(&update, sizeof(update), 1, fp) != 1) {
+	if(feof(fp))
+	    return 0;
+	XLOG_WARNING("fread failed:%s", strerror(errno));
+	return 0;
+    }
+
+    uint8_t *buf = new uint8_t[len];
+
+    if(fread(buf, len, 1, fp) != 1) {
+	if(feof(fp))
+	    return 0;
+	XLOG_WARNING("fread failed:%s", strerror(errno));
+	return 0;
+    }
+
+    return buf;
+}
+
+/**
+ * Read the next IPv4 route from an MRT table dump.  Records of any
+ * other type are skipped.
+ *
+ * Originally contributed by Ratul Mahajan.
+ *
+ * @param fp the file.
+ * @param net the prefix of the route.
+ * @param len the length of the path attributes.
+ * @return the path attributes of the route in wire format, which the
+ * caller must delete[], or 0 at the end of the file.
+ */
+inline
+const
+uint8_t *
+mrtd_table_file_read(FILE *fp, IPv4Net& net, size_t& len)
+{
+    // The fields of a TABLE_DUMP record: view (2), sequence (2),
+    // prefix (4), prefix length (1), status (1), originated (4),
+    // peer address (4), peer AS (2) and attribute length (2). The
+    // record is not padded, so it is not read into a structure.
+    static const size_t TABLE_LEN = 22;
+    static const size_t PREFIX_OFFSET = 4;
+    static const size_t PREFIX_LEN_OFFSET = 8;
+    static const size_t ATTR_LEN_OFFSET = 20;
+
+    mrt_header header;
+
+    for (;;) {
+	if(fread(&header, sizeof(header), 1, fp) != 1) {
+	    if(feof(fp))
+		return 0;
+	    XLOG_WARNING("fread failed:%s", strerror(errno));
+	    return 0;
+	}
+
+	if (ntohs(header.type) == MRT_TABLE_DUMP &&
+	    ntohs(header.subtype) == MRT_TABLE_DUMP_AFI_IPV4)
+	    break;
+
+	if (fseek(fp, ntohl(header.length), SEEK_CUR) != 0) {
+	    XLOG_WARNING("fseek failed:%s", strerror(errno));
+	    return 0;
+	}
+    }
+
+    uint8_t table[TABLE_LEN];
+    if(fread(table, sizeof(table), 1, fp) != 1) {
+	if(feof(fp))
+	    return 0;
+	XLOG_WARNING("fread failed:%s", strerror(errno));
+	return 0;
+    }
+
+    len = extract_16(table + ATTR_LEN_OFFSET);
+    if (len != ntohl(header.length) - TABLE_LEN) {
+	XLOG_WARNING("attribute length %u does not match record length %u",
+		     XORP_UINT_CAST(len),
+		     XORP_UINT_CAST(ntohl(header.length)));
+	return 0;
+    }
+
+    uint32_t prefix;
+    memcpy(&prefix, table + PREFIX_OFFSET, sizeof(prefix));
+    uint32_t prefix_len = table[PREFIX_LEN_OFFSET];
+    if (prefix_len > IPv4::addr_bitlen()) {
+	XLOG_WARNING("bad prefix length %u", XORP_UINT_CAST(prefix_len));
+	return 0;
+    }
+    net = IPv4Net(IPv4(prefix), prefix_len);
+
+    uint8_t *buf = new uint8_t[len];
+
+    if(len > 0 && fread(buf, len, 1, fp) != 1) {
+	delete [] buf;
+	if(feof(fp))
+	    return 0;
+	XLOG_WARNING("fread failed:%s", strerror(errno));
+	return 0;
+    }
+
+    return buf;
+}
+
+#endif // __BGP_HARNESS_MRTD_HH__
@@ -22,6 +22,7 @@
 #ifndef __BGP_HARNESS_TEST_PEER_HH__
 #define __BGP_HARNESS_TEST_PEER_HH__
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/test_peer_base.hh"
 #include "bgp/packet.hh"
 
@@ -139,6 +140,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      *  Register for receiving packets and events.
      */
@@ -261,6 +261,11 @@ NextHopResolver<A>::rib_client_route_info_invalid(const A& addr,
 	return false;
     }
 
+    /*
+    ** Any answer for this subnet that is still in flight is stale too.
+    */
+    _next_hop_rib_request.mark_invalid(addr, prefix_len);
+
     map<A, int> m = _next_hop_cache.delete_entry(addr, prefix_len);
     typename map<A, int>::iterator i;
     for (i = m.begin(); i != m.end(); i++)
@@ -686,14 +691,34 @@ NextHopCache<A>::rpe_to_pe_delete(RealPrefixEntry& rpe, A addr,
 
 /****************************************/
 
+/*
+** Requests are sent to the RIB in batches of at most NH_BATCH_SIZE
+** entries, with at most NH_BATCH_WINDOW batches outstanding.
+*/
+static const size_t NH_BATCH_SIZE = 128;
+static const size_t NH_BATCH_WINDOW = 4;
+
+static inline void
+atom_addr(const XrlAtom& atom, IPv4& addr)
+{
+    addr = atom.ipv4();
+}
+
+#ifdef HAVE_IPV6
+static inline void
+atom_addr(const XrlAtom& atom, IPv6& addr)
+{
+    addr = atom.ipv6();
+}
+#endif
+
 template<class A>
 NextHopRibRequest<A>::NextHopRibRequest(XrlStdRouter *xrl_router,
 					NextHopResolver<A>& next_hop_resolver,
 					NextHopCache<A>& next_hop_cache,
 					BGPMain& bgp)
     : _xrl_router(xrl_router), _next_hop_resolver(next_hop_resolver),
-      _next_hop_cache(next_hop_cache), _bgp(bgp), _busy(false),
-      _invalid(false), _tardy_invalid(false)
+      _next_hop_cache(next_hop_cache), _bgp(bgp), _next_batch(0)
 {
 }
 
@@ -704,6 +729,99 @@ NextHopRibRequest<A>::~NextHopRibRequest()
     ** Free all the outstanding queue entries.
     */
     for_each(_queue.begin(), _queue.end(), &NextHopRibRequest::zapper);
+    typename list<Batch>::iterator b;
+    for (b = _batches.begin(); b != _batches.end(); b++)
+	for_each(b->_entries.begin(), b->_entries.end(),
+		 &NextHopRibRequest::zapper);
+}
+
+template<class A>
+RibRegisterQueueEntry<A> *
+NextHopRibRequest<A>::find_register(const A& nexthop) const
+{
+    typename list<Batch>::const_iterator b;
+    typename list<RibRequestQueueEntry<A> *>::const_iterator i;
+    for (b = _batches.begin(); b != _batches.end(); b++) {
+	for (i = b->_entries.begin(); i != b->_entries.end(); i++) {
+	    RibRegisterQueueEntry<A> *rr =
+		dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
+	    if (rr && rr->nexthop() == nexthop)
+		return rr;
+	}
+    }
+    for (i = _queue.begin(); i != _queue.end(); i++) {
+	RibRegisterQueueEntry<A> *rr =
+	    dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
+	if (rr && rr->nexthop() == nexthop)
+	    return rr;
+    }
+
+    return 0;
+}
+
+template<class A>
+bool
+NextHopRibRequest<A>::find_deregister(const A& base_addr,
+				      uint32_t prefix_len) const
+{
+    typename list<Batch>::const_iterator b;
+    typename list<RibRequestQueueEntry<A> *>::const_iterator i;
+    for (b = _batches.begin(); b != _batches.end(); b++) {
+	for (i = b->_entries.begin(); i != b->_entries.end(); i++) {
+	    RibDeregisterQueueEntry<A> *dreg =
+		dynamic_cast<RibDeregisterQueueEntry<A> *>(*i);
+	    if (dreg && dreg->base_addr() == base_addr &&
+		dreg->prefix_len() == prefix_len)
+		return true;
+	}
+    }
+    for (i = _queue.begin(); i != _queue.end(); i++) {
+	RibDeregisterQueueEntry<A> *dreg =
+	    dynamic_cast<RibDeregisterQueueEntry<A> *>(*i);
+	if (dreg && dreg->base_addr() == base_addr &&
+	    dreg->prefix_len() == prefix_len)
+	    return true;
+    }
+
+    return false;
+}
+
+template<class A>
+bool
+NextHopRibRequest<A>::register_pending(const IPNet<A>& net) const
+{
+    typename list<Batch>::const_iterator b;
+    typename list<RibRequestQueueEntry<A> *>::const_iterator i;
+    for (b = _batches.begin(); b != _batches.end(); b++) {
+	for (i = b->_entries.begin(); i != b->_entries.end(); i++) {
+	    RibRegisterQueueEntry<A> *rr =
+		dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
+	    if (rr && net.contains(rr->nexthop()))
+		return true;
+	}
+    }
+    for (i = _queue.begin(); i != _queue.end(); i++) {
+	RibRegisterQueueEntry<A> *rr =
+	    dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
+	if (rr && net.contains(rr->nexthop()))
+	    return true;
+    }
+
+    return false;
+}
+
+template<class A>
+typename list<typename NextHopRibRequest<A>::Batch>::iterator
+NextHopRibRequest<A>::find_batch(uint32_t id)
+{
+    typename list<Batch>::iterator b;
+    for (b = _batches.begin(); b != _batches.end(); b++)
+	if (b->_id == id)
+	    return b;
+
+    XLOG_FATAL("No batch %u in flight", XORP_UINT_CAST(id));
+
+    return b;
 }
 
 template<class A>
@@ -718,15 +836,11 @@ NextHopRibRequest<A>::register_nexthop(A nexthop, IPNet<A> net_from_route,
     ** Make sure that we are not already waiting for a response for
     ** this sucker.
     */
-    typename list<RibRequestQueueEntry<A> *>::iterator i;
-    for (i = _queue.begin(); i != _queue.end(); i++) {
-	RibRegisterQueueEntry<A> *rr = 
-	    dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
-	if (rr && rr->nexthop() == nexthop) {
-	    rr->register_nexthop(net_from_route, requester);
-	    debug_msg("This registration is already queued\n");
-	    return;
-	}
+    RibRegisterQueueEntry<A> *rr = find_register(nexthop);
+    if (rr) {
+	rr->register_nexthop(net_from_route, requester);
+	debug_msg("This registration is already queued\n");
+	return;
     }
 
     debug_msg("Queue registration\n");
@@ -734,27 +848,29 @@ NextHopRibRequest<A>::register_nexthop(A nexthop, IPNet<A> net_from_route,
     /*
     ** Construct a request.
     */
-    RibRegisterQueueEntry<A> *rr 
-	= new RibRegisterQueueEntry<A>(nexthop, net_from_route, requester);
+    rr = new RibRegisterQueueEntry<A>(nexthop, net_from_route, requester);
 
     /*
-    ** Add the request to the queue.
+    ** Add the request to the queue. It is only sent if there is room
+    ** in the window of outstanding batches.
     */
     _queue.push_back(rr);
-
-    /*
-    ** We allow only one outstanding request to the RIB. The "_busy"
-    ** flag marks if there is currently an outstanding request.
-    */
-    if (!_busy) {
-	send_next_request();
-    }
+    send_next_request();
 }
 
 template<class A>
 void
 NextHopRibRequest<A>::deregister_from_rib(const A& base_addr,
 					  uint32_t prefix_len)
+{
+    queue_deregister(base_addr, prefix_len);
+    send_next_request();
+}
+
+template<class A>
+void
+NextHopRibRequest<A>::queue_deregister(const A& base_addr,
+				       uint32_t prefix_len)
 {
     debug_msg("R addr %s prefix_len %d\n",
 	      base_addr.str().c_str(), prefix_len);
@@ -763,17 +879,22 @@ NextHopRibRequest<A>::deregister_from_rib(const A& base_addr,
     ** Its possible that we are already trying to deregister for this
     ** addr/prefix. In which case just return.
     */
-    typename list<RibRequestQueueEntry<A> *>::iterator i = _queue.begin();
-    for ( ;i != _queue.end(); i++) {
-	RibDeregisterQueueEntry<A> *dreg = 
-	    dynamic_cast<RibDeregisterQueueEntry<A> *>(*i);
-	if (dreg) {
-	    if (dreg->base_addr() == base_addr && 
-		dreg->prefix_len() == prefix_len) {
-		debug_msg("This deregistration is already queued\n");
-		return;
-	    }
-	}
+    if (find_deregister(base_addr, prefix_len)) {
+	debug_msg("This deregistration is already queued\n");
+	return;
+    }
+
+    /*
+    ** A registration that is queued or in flight may be answered with
+    ** this very subnet, the RIB only holds one registration per
+    ** subnet, and would drop it when this deregistration reaches it.
+    ** Hold the deregistration back until the answers have arrived.
+    */
+    IPNet<A> net(base_addr, prefix_len);
+    if (register_pending(net)) {
+	debug_msg("A registration for this subnet is pending\n");
+	_held_deregisters.insert(net);
+	return;
     }
 
     debug_msg("Queue deregistration\n");
@@ -781,57 +902,41 @@ NextHopRibRequest<A>::deregister_from_rib(const A& base_addr,
     /*
     ** Construct a request.
     */
-    RibDeregisterQueueEntry<A> *rr 
+    RibDeregisterQueueEntry<A> *rr
 	= new RibDeregisterQueueEntry<A>(base_addr, prefix_len);
 
     /*
     ** Add the request to the queue.
     */
     _queue.push_back(rr);
-
-    /*
-    ** We allow only one outstanding request to the RIB. The "_busy"
-    ** flag marks if there is currently an outstanding request.
-    */
-    if (!_busy) {
-	send_next_request();
-    }
 }
 
 template<>
 void
-NextHopRibRequest<IPv4>::register_interest(IPv4 nexthop)
+NextHopRibRequest<IPv4>::register_interests(const XrlAtomList& nexthops,
+					   uint32_t batch)
 {
-    debug_msg("nexthop %s\n", nexthop.str().c_str());
+    debug_msg("%u nexthops\n", XORP_UINT_CAST(nexthops.size()));
     PROFILE(XLOG_TRACE(_bgp.profile().enabled(trace_nexthop_resolution),
-		       "nexthop %s\n", nexthop.str().c_str()));
+		       "%u nexthops\n", XORP_UINT_CAST(nexthops.size())));
     if (0 == _xrl_router)	// The test code sets _xrl_router to zero
 	return;
 
     XrlRibV0p1Client rib(_xrl_router);
-    rib.send_register_interest4(_ribname.c_str(), _xrl_router->name(),
-				nexthop,
-				::callback(this,
-		&NextHopRibRequest::register_interest_response,
-		nexthop,
-		c_format("nexthop: %s", nexthop.str().c_str())));
+    rib.send_bulk_register_interest4(_ribname.c_str(), _xrl_router->name(),
+				     nexthops,
+				     ::callback(this,
+		&NextHopRibRequest::register_interests_response,
+		batch,
+		c_format("%u nexthops",
+			 XORP_UINT_CAST(nexthops.size()))));
 }
 
-
 template<class A>
 void
-NextHopRibRequest<A>::register_interest_response(const XrlError& error,
-						 const bool *resolves,
-						 const A *addr,
-						 const uint32_t *prefix_len,
-						 const uint32_t *real_prefix_len,
-						 const A *actual_nexthop,
-						 const uint32_t *metric,
-						 const A /*nexthop_interest*/,
-						 const string comment)
+NextHopRibRequest<A>::check_register_error(const XrlError& error,
+					   const string& comment)
 {
-    UNUSED(actual_nexthop);
-
     /*
     ** We attempted to register a next hop with the RIB and an error
     ** ocurred. Its not clear that we should continue.
@@ -860,35 +965,96 @@ NextHopRibRequest<A>::register_interest_response(const XrlError& error,
 	break;
 
     }
+}
 
-    debug_msg("Error %s resolves %d addr %s "
-	      "prefix_len %u real prefix_len %u actual nexthop %s metric %d %s\n",
- 	      error.str().c_str(), *resolves, addr->str().c_str(),
-	      XORP_UINT_CAST(*prefix_len), XORP_UINT_CAST(*real_prefix_len),
-	      actual_nexthop->str().c_str(), XORP_UINT_CAST(*metric),
-	      comment.c_str());
-    PROFILE(XLOG_TRACE(_bgp.profile().enabled(trace_nexthop_resolution),
-		       "Error %s resolves %d addr %s "
-		       "prefix_len %u real prefix_len %u "
-		       "actual nexthop %s metric %d %s\n",
-		       error.str().c_str(), *resolves, addr->str().c_str(),
-		       XORP_UINT_CAST(*prefix_len), XORP_UINT_CAST(*real_prefix_len),
-		       actual_nexthop->str().c_str(), XORP_UINT_CAST(*metric),
-		       comment.c_str()));
-
-    XLOG_ASSERT(*real_prefix_len <= A::addr_bitlen());
+template<class A>
+void
+NextHopRibRequest<A>::register_interests_response(const XrlError& error,
+					  const XrlAtomList *resolves,
+					  const XrlAtomList *addrs,
+					  const XrlAtomList *prefix_lens,
+					  const XrlAtomList *real_prefix_lens,
+					  const XrlAtomList *actual_nexthops,
+					  const XrlAtomList *metrics,
+					  uint32_t batch,
+					  const string comment)
+{
+    check_register_error(error, comment);
 
     /*
-    ** Make sure that there is something on our queue.
+    ** The answers of a batch are in the order of its next hops, but
+    ** the batches may be answered in any order.
     */
-    XLOG_ASSERT(!_queue.empty());
-    RibRegisterQueueEntry<A> *first_rr =
-	dynamic_cast<RibRegisterQueueEntry<A> *>(_queue.front());
+    typename list<Batch>::iterator b = find_batch(batch);
+
+    size_t n = b->_entries.size();
+    if (resolves->size() != n || addrs->size() != n ||
+	prefix_lens->size() != n || real_prefix_lens->size() != n ||
+	actual_nexthops->size() != n || metrics->size() != n)
+	XLOG_FATAL("callback: %s %u next hops sent, answers %u/%u/%u/%u/%u/%u",
+		   comment.c_str(), XORP_UINT_CAST(n),
+		   XORP_UINT_CAST(resolves->size()),
+		   XORP_UINT_CAST(addrs->size()),
+		   XORP_UINT_CAST(prefix_lens->size()),
+		   XORP_UINT_CAST(real_prefix_lens->size()),
+		   XORP_UINT_CAST(actual_nexthops->size()),
+		   XORP_UINT_CAST(metrics->size()));
 
     /*
-    ** Make sure the front entry is a register rather than a deregister
+    ** Take each entry out of the batch as its answer is processed, the
+    ** entries still to go are in flight as far as deregistration is
+    ** concerned.
     */
-    XLOG_ASSERT(first_rr != NULL);
+    vector<RegisterAnswer> added;
+    for (size_t k = 0; k < n; k++) {
+	RibRegisterQueueEntry<A> *rr =
+	    dynamic_cast<RibRegisterQueueEntry<A> *>(b->_entries.front());
+	XLOG_ASSERT(rr != NULL);
+	b->_entries.pop_front();
+
+	RegisterAnswer answer;
+	answer._nexthop = rr->nexthop();
+	try {
+	    answer._resolves = resolves->get(k).boolean();
+	    atom_addr(addrs->get(k), answer._addr);
+	    answer._prefix_len = prefix_lens->get(k).uint32();
+	    answer._real_prefix_len = real_prefix_lens->get(k).uint32();
+	    answer._metric = metrics->get(k).uint32();
+	} catch (const XorpException& e) {
+	    XLOG_FATAL("callback: %s bad answer %u %s", comment.c_str(),
+		       XORP_UINT_CAST(k), e.str().c_str());
+	}
+
+	debug_msg("nexthop %s resolves %d addr %s prefix_len %u "
+		  "real prefix_len %u metric %u\n",
+		  answer._nexthop.str().c_str(), answer._resolves,
+		  answer._addr.str().c_str(),
+		  XORP_UINT_CAST(answer._prefix_len),
+		  XORP_UINT_CAST(answer._real_prefix_len),
+		  XORP_UINT_CAST(answer._metric));
+	PROFILE(XLOG_TRACE(_bgp.profile().enabled(trace_nexthop_resolution),
+			   "nexthop %s resolves %d addr %s prefix_len %u "
+			   "real prefix_len %u metric %u\n",
+			   answer._nexthop.str().c_str(), answer._resolves,
+			   answer._addr.str().c_str(),
+			   XORP_UINT_CAST(answer._prefix_len),
+			   XORP_UINT_CAST(answer._real_prefix_len),
+			   XORP_UINT_CAST(answer._metric)));
+
+	process_answer(*b, rr, answer, added);
+    }
+
+    finish_answers(b, added);
+}
+
+template<class A>
+void
+NextHopRibRequest<A>::process_answer(Batch& batch,
+				     RibRegisterQueueEntry<A> *rr,
+				     const RegisterAnswer& answer,
+				     vector<RegisterAnswer>& added)
+{
+    XLOG_ASSERT(answer._real_prefix_len <= A::addr_bitlen());
 
     /*
     ** At this point I would really like to directly compare the
@@ -897,48 +1063,59 @@ NextHopRibRequest<A>::register_interest_response(const XrlError& error,
     ** a base address for the covered region. So the comparison has to
     ** be masked by the prefix_len that is returned.
     */
-    XLOG_ASSERT(IPNet<A>(*addr, *prefix_len) ==
-		IPNet<A>(first_rr->nexthop(), *prefix_len));
+    IPNet<A> net(answer._addr, answer._prefix_len);
+    XLOG_ASSERT(net == IPNet<A>(rr->nexthop(), answer._prefix_len));
 
     /*
     ** It is possible that we register interest in a nexthop and while
     ** we were are waiting for the response the answer becomes invalid.
     ** Unfortunately the invalid can arrive before the response. If we
-    ** have previously received an invalidate and it was not in our
-    ** cache then it was saved. If the invalid and response match then
-    ** register again.
+    ** have previously received an invalidate for this subnet while
+    ** the batch was in flight then register again.
     */
-    if (_invalid) {
-	XLOG_ASSERT(*addr == _invalid_net.masked_addr() &&
-		    *prefix_len == _invalid_net.prefix_len());
-	_invalid = false;
-	send_next_request();
+    if (batch._invalid.find(net) != batch._invalid.end()) {
+	_queue.push_front(rr);
 	return;
     }
 
     /*
-    ** We have a lot to do here. This response may have satisfied
-    ** other requests on the queue. Also there are two reasons for
-    ** making requests. The simple case is that the next hop table has
-    ** called down to us. In which case we should run the call
-    ** backs. The other reason is that a previous entry has become
-    ** invalid in which case we need to call the next hop changed hook
-    ** in the decision table. It is possible (legal) for an entry to be here
-    ** for both reasons.
-    **
-    ** The simplest strategy is to insert this result into the
-    ** NextHopCache. Then traverse the queue removing all entries that
-    ** are satisfied by the NextHopCache.
+    ** Insert this result into the NextHopCache unless a previous
+    ** answer already covers this next hop. With several batches in
+    ** flight the same subnet can be returned more than once. If the
+    ** covering entry is for a different subnet then the registration
+    ** the RIB has just made for us is surplus.
     */
-    A first_nexthop = first_rr->nexthop();
-    _next_hop_cache.add_entry(*addr, first_nexthop, *prefix_len, 
-			      *real_prefix_len, *resolves, *metric);
+    bool resolvable;
+    uint32_t metric;
+    if (!_next_hop_cache.lookup_by_nexthop_without_entry(rr->nexthop(),
+							 resolvable,
+							 metric)) {
+	_next_hop_cache.add_entry(answer._addr, rr->nexthop(),
+				  answer._prefix_len, answer._real_prefix_len,
+				  answer._resolves, answer._metric);
+	added.push_back(answer);
+	resolvable = answer._resolves;
+    } else {
+	bool r;
+	uint32_t m;
+	if (!_next_hop_cache.lookup_by_addr(answer._addr, answer._prefix_len,
+					    r, m))
+	    queue_deregister(answer._addr, answer._prefix_len);
+    }
+
+    complete_register(rr, resolvable);
+    delete rr;
+}
 
+template<class A>
+void
+NextHopRibRequest<A>::finish_answers(typename list<Batch>::iterator batch,
+				     const vector<RegisterAnswer>& added)
+{
     /*
-    ** As soon as we come across an entry in the queue that we
-    ** can't lookup in the cache we bail. It may be the case that
-    ** there are other entries later in the queue that may
-    ** resolve. Don't worry about it we will get there eventually.
+    ** The new answers may have satisfied other requests on the queue
+    ** that have not been sent yet. Complete any that can be looked up
+    ** in the cache.
     */
     typename list<RibRequestQueueEntry<A> *>::iterator i;
     i = _queue.begin();
@@ -947,57 +1124,13 @@ NextHopRibRequest<A>::register_interest_response(const XrlError& error,
 	uint32_t m;
 	RibRegisterQueueEntry<A> *rr
 	    = dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
-	if (rr) {
-	    if (_next_hop_cache.lookup_by_nexthop_without_entry(rr->nexthop(),
-								lookup_succeeded, m)) {
-		XLOG_ASSERT(rr->new_register() || rr->reregister());
-		/*
-		** See if this request was caused by a downcall from
-		** the next hop table.
-		*/
-		if (rr->new_register()) {
-		    NHRequest<A>* request_data = &rr->requests();
-		    /*
-		    ** If nobody is interested then don't register or run
-		    ** the callbacks.
-		    */
-		    if (0 != request_data->requests()) {
-			_next_hop_cache.register_nexthop(rr->nexthop(),
-							 request_data->requests());
-
-			typename set <NhLookupTable<A> *>::const_iterator req_iter;
-			for (req_iter = request_data->requesters().begin();
-			     req_iter != request_data->requesters().end();
-			     req_iter++) {
-			    NhLookupTable<A> *requester = (*req_iter);
-			    requester->RIB_lookup_done(rr->nexthop(),
-						       request_data->request_nets(requester),
-						       lookup_succeeded);
-			}
-		    }
-		}
-		/*
-		** See if this request was caused by an upcall from the
-		** RIB. If it was then notify decision that this next hop
-		** has changed.
-		*/
-		if (rr->reregister() && 0 != rr->ref_cnt()) {
-		    _next_hop_cache.register_nexthop(rr->nexthop(), rr->ref_cnt());
-		    /*
-		    ** Start the upcall with the old metrics. Only if the
-		    ** state has changed will the upcall be made.
-		    */
-		    _next_hop_resolver.next_hop_changed(rr->nexthop(),
-							rr->resolvable(),
-							rr->metric());
-		}
-		delete rr;
-		i = _queue.erase(i);
-	    } else {
-		break;
-	    }
+	if (rr && _next_hop_cache.
+	    lookup_by_nexthop_without_entry(rr->nexthop(),
+					    lookup_succeeded, m)) {
+	    complete_register(rr, lookup_succeeded);
+	    delete rr;
+	    i = _queue.erase(i);
 	} else {
-	    //skip the deregister
 	    i++;
 	}
     }
@@ -1010,40 +1143,161 @@ NextHopRibRequest<A>::register_interest_response(const XrlError& error,
     ** outstanding queries in the queue. If it hasn't then the entry
     ** will be invalid so deregister interest with the RIB.
     */
-    if (!_next_hop_cache.validate_entry(*addr, first_nexthop, *prefix_len,
-					*real_prefix_len)) {
-	deregister_from_rib(*addr, *prefix_len);
+    typename vector<RegisterAnswer>::const_iterator a;
+    for (a = added.begin(); a != added.end(); a++) {
+	if (!_next_hop_cache.validate_entry(a->_addr, a->_nexthop,
+					    a->_prefix_len,
+					    a->_real_prefix_len)) {
+	    queue_deregister(a->_addr, a->_prefix_len);
+	}
     }
 
+    if (batch->_entries.empty())
+	_batches.erase(batch);
+
     /*
-    ** There are entries left on the queue, so, fire off another request.
+    ** Deregistrations held back for registrations that have now been
+    ** answered. If the RIB answered with another subnet, or the answer
+    ** was not wanted, nothing uses the registration of the subnet.
+    */
+    typename set<IPNet<A> >::iterator h = _held_deregisters.begin();
+    while (h != _held_deregisters.end()) {
+	bool r;
+	uint32_t m;
+	if (register_pending(*h)) {
+	    h++;
+	    continue;
+	}
+	if (!_next_hop_cache.lookup_by_addr(h->masked_addr(), h->prefix_len(),
+					    r, m))
+	    queue_deregister(h->masked_addr(), h->prefix_len());
+	_held_deregisters.erase(h++);
+    }
+
+    /*
+    ** There may be entries left on the queue, so, fire off another
+    ** request.
     */
     send_next_request();
 }
 
 template<class A>
 void
-NextHopRibRequest<A>::send_next_request()
+NextHopRibRequest<A>::complete_register(RibRegisterQueueEntry<A> *rr,
+					bool resolvable)
 {
-    if (_queue.empty()) {
-	_busy = false;
-	return;
+    XLOG_ASSERT(rr->new_register() || rr->reregister());
+    /*
+    ** See if this request was caused by a downcall from
+    ** the next hop table.
+    */
+    if (rr->new_register()) {
+	NHRequest<A>* request_data = &rr->requests();
+	/*
+	** If nobody is interested then don't register or run
+	** the callbacks.
+	*/
+	if (0 != request_data->requests()) {
+	    _next_hop_cache.register_nexthop(rr->nexthop(),
+					     request_data->requests());
+
+	    typename set <NhLookupTable<A> *>::const_iterator req_iter;
+	    for (req_iter = request_data->requesters().begin();
+		 req_iter != request_data->requesters().end();
+		 req_iter++) {
+		NhLookupTable<A> *requester = (*req_iter);
+		requester->RIB_lookup_done(rr->nexthop(),
+					   request_data->request_nets(requester),
+					   resolvable);
+	    }
+	}
     }
-    _busy = true;
-    RibRegisterQueueEntry<A> *rr = 
-	dynamic_cast<RibRegisterQueueEntry<A> *>(_queue.front());
-    if (rr) {
-	register_interest(rr->nexthop());
-	return;
+    /*
+    ** See if this request was caused by an upcall from the
+    ** RIB. If it was then notify decision that this next hop
+    ** has changed.
+    */
+    if (rr->reregister() && 0 != rr->ref_cnt()) {
+	_next_hop_cache.register_nexthop(rr->nexthop(), rr->ref_cnt());
+	/*
+	** Start the upcall with the old metrics. Only if the
+	** state has changed will the upcall be made.
+	*/
+	_next_hop_resolver.next_hop_changed(rr->nexthop(),
+					    rr->resolvable(),
+					    rr->metric());
     }
-    
-    RibDeregisterQueueEntry<A> *rd = 
-	dynamic_cast<RibDeregisterQueueEntry<A> *>(_queue.front());
-    if (rd) {
-	deregister_interest(rd->base_addr(), rd->prefix_len());
-	return;
+}
+
+template<class A>
+void
+NextHopRibRequest<A>::send_next_request()
+{
+    /*
+    ** Fill the window. Each batch is a run of requests of the same
+    ** kind from the front of the queue.
+    */
+    while (!_queue.empty() && _batches.size() < NH_BATCH_WINDOW) {
+	bool reg = 0 !=
+	    dynamic_cast<RibRegisterQueueEntry<A> *>(_queue.front());
+
+	_batches.push_back(Batch());
+	Batch& batch = _batches.back();
+	batch._id = _next_batch++;
+	XrlAtomList addrs;
+	XrlAtomList prefix_lens;
+	for (size_t n = 0; !_queue.empty() && n < NH_BATCH_SIZE; n++) {
+	    RibRequestQueueEntry<A> *e = _queue.front();
+	    RibRegisterQueueEntry<A> *rr =
+		dynamic_cast<RibRegisterQueueEntry<A> *>(e);
+	    if ((0 != rr) != reg)
+		break;
+	    if (rr) {
+		addrs.append(XrlAtom(rr->nexthop()));
+	    } else {
+		RibDeregisterQueueEntry<A> *rd =
+		    dynamic_cast<RibDeregisterQueueEntry<A> *>(e);
+		XLOG_ASSERT(rd != NULL);
+		addrs.append(XrlAtom(rd->base_addr()));
+		prefix_lens.append(XrlAtom(rd->prefix_len()));
+	    }
+	    batch._entries.push_back(e);
+	    _queue.pop_front();
+	}
+
+	if (reg)
+	    register_interests(addrs, batch._id);
+	else
+	    deregister_interests(addrs, prefix_lens, batch._id);
+    }
+}
+
+template<class A>
+bool
+NextHopRibRequest<A>::mark_invalid(const A& addr, const uint32_t& prefix_len)
+{
+    IPNet<A> net(addr, prefix_len);
+    bool found = false;
+
+    typename list<Batch>::iterator b;
+    for (b = _batches.begin(); b != _batches.end(); b++) {
+	typename list<RibRequestQueueEntry<A> *>::iterator i;
+	for (i = b->_entries.begin(); i != b->_entries.end(); i++) {
+	    RibRegisterQueueEntry<A> *rr =
+		dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
+	    RibDeregisterQueueEntry<A> *dreg =
+		dynamic_cast<RibDeregisterQueueEntry<A> *>(*i);
+	    if ((rr && net.contains(rr->nexthop())) ||
+		(dreg && dreg->base_addr() == addr &&
+		 dreg->prefix_len() == prefix_len)) {
+		b->_invalid.insert(net);
+		found = true;
+		break;
+	    }
+	}
     }
-    XLOG_UNREACHABLE();
+
+    return found;
 }
 
 template<class A>
@@ -1051,61 +1305,39 @@ bool
 NextHopRibRequest<A>::premature_invalid(const A& addr,
 					const uint32_t& prefix_len)
 {
-    if (!_busy)
+    /*
+    ** The RIB no longer holds a registration it has invalidated.
+    */
+    _held_deregisters.erase(IPNet<A>(addr, prefix_len));
+
+    if (_batches.empty())
 	return false;
 
     /*
     ** An invalid has been received for an entry that we don't have in
     ** our cache.
-    * 1) The current request may have generated an invalid. Extremely
+    * 1) An outstanding request may have generated an invalid. Extremely
     * irritating, we make a request and before receiving the response
-    * we get an invalid from the RIB. In which case set the _invalid
-    * flag and _invalid_net and all should be well.
+    * we get an invalid from the RIB. In which case note the subnet
+    * in the batch and all should be well.
     * 2) We receive an invalid for an entry that we are no longer
     * interested in but the deregister is still in the request queue. In
     * which case remove the deregister from the queue and continue.
     */
-
-    XLOG_ASSERT(!_queue.empty());
-    RibRegisterQueueEntry<A> *first_rr =
-	dynamic_cast<RibRegisterQueueEntry<A> *>(_queue.front());
-    if (first_rr && 
-	(IPNet<A>(addr, prefix_len) ==
-	 IPNet<A>(first_rr->nexthop(), prefix_len))) {
-
-	XLOG_ASSERT(_busy);
-	XLOG_ASSERT(!_invalid);
-
-	_invalid = true;
-	_invalid_net = IPNet<A>(addr, prefix_len);
-
+    if (mark_invalid(addr, prefix_len))
 	return true;
-    }
 
     typename list<RibRequestQueueEntry<A> *>::iterator i = _queue.begin();
     for ( ;i != _queue.end(); i++) {
-	RibDeregisterQueueEntry<A> *dreg = 
+	RibDeregisterQueueEntry<A> *dreg =
 	    dynamic_cast<RibDeregisterQueueEntry<A> *>(*i);
 	if (dreg) {
-	    if (dreg->base_addr() == addr && 
+	    if (dreg->base_addr() == addr &&
 		dreg->prefix_len() == prefix_len) {
-		/*
-		** Don't erase the first entry in the queue this is an
-		** ongoing transaction.
-		*/
-		XLOG_INFO("invalid addr %s prefix len %u matched delete %s",
-			  cstring(addr), XORP_UINT_CAST(prefix_len),
-			  (i == _queue.begin()) ? "front" : "not front");
-		if (i == _queue.begin()) {
-		    XLOG_ASSERT(_busy);
-		    XLOG_ASSERT(!_invalid);
-
-		    _invalid = true;
-		    _invalid_net = IPNet<A>(addr, prefix_len);
-		} else {
-		    delete dreg;
-		    _queue.erase(i);
-		}
+		XLOG_INFO("invalid addr %s prefix len %u matched queued delete",
+			  cstring(addr), XORP_UINT_CAST(prefix_len));
+		delete dreg;
+		_queue.erase(i);
 		return true;
 	    }
 	}
@@ -1118,17 +1350,18 @@ template<class A>
 bool
 NextHopRibRequest<A>::tardy_invalid(const A& addr, const uint32_t& prefix_len)
 {
-    if (_tardy_invalid) {
-	_tardy_invalid = false;
-	if (addr != _tardy_invalid_net.masked_addr() || 
-	    prefix_len != _tardy_invalid_net.prefix_len())
-	    XLOG_FATAL("Invalidate does not match previous failed "
-		       "de-registration addr %s prefix len %u",
-		       cstring(addr), XORP_UINT_CAST(prefix_len));
-	return true;
-    }
+    if (_tardy_invalid_nets.empty())
+	return false;
 
-    return false;
+    typename set<IPNet<A> >::iterator i =
+	_tardy_invalid_nets.find(IPNet<A>(addr, prefix_len));
+    if (i == _tardy_invalid_nets.end())
+	XLOG_FATAL("Invalidate does not match previous failed "
+		   "de-registration addr %s prefix len %u",
+		   cstring(addr), XORP_UINT_CAST(prefix_len));
+    _tardy_invalid_nets.erase(i);
+
+    return true;
 }
 
 template<class A>
@@ -1138,24 +1371,20 @@ NextHopRibRequest<A>::deregister_nexthop(A nexthop, IPNet<A> net_from_route,
 {
     debug_msg("nexthop %s net %s requested %p\n",
 	      nexthop.str().c_str(), net_from_route.str().c_str(), requester);
-    typename list<RibRequestQueueEntry<A> *>::iterator i;
 
     /*
     ** The deregister may mean that there are no more interested parties.
     ** It may therefore be tempting to remove this entry from the
     ** queue DON'T as a request to the RIB might be in progress. The
-    ** register_interest_response will tidy up. Worst case we
+    ** register_interests_response will tidy up. Worst case we
     ** occasionally make a request for a next hop for which there are
     ** no requesters.
     */
-    for (i = _queue.begin(); i != _queue.end(); i++) {
-	RibRegisterQueueEntry<A> *rr = 
-	    dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
-	if (rr && rr->nexthop() == nexthop) {
-	    if (!rr->deregister_nexthop(net_from_route, requester))
-		XLOG_WARNING("Removing request %p probably failed", requester);
-	    return true;
-	}
+    RibRegisterQueueEntry<A> *rr = find_register(nexthop);
+    if (rr) {
+	if (!rr->deregister_nexthop(net_from_route, requester))
+	    XLOG_WARNING("Removing request %p probably failed", requester);
+	return true;
     }
     return false;
 }
@@ -1194,57 +1423,41 @@ NextHopRibRequest<A>::reregister_nexthop(A nexthop, uint32_t ref_cnt,
     ** Make sure that we are not already waiting for a response for
     ** this sucker.
     */
-    typename list<RibRequestQueueEntry<A> *>::iterator i;
-    for (i = _queue.begin(); i != _queue.end(); i++) {
-	RibRegisterQueueEntry<A> *rr = 
-	    dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
-	if (rr && rr->nexthop() == nexthop) {
-	    rr->reregister_nexthop(ref_cnt, resolvable, metric);
-	    return;
-	}
+    RibRegisterQueueEntry<A> *rr = find_register(nexthop);
+    if (rr) {
+	rr->reregister_nexthop(ref_cnt, resolvable, metric);
+	return;
     }
 
     /*
     ** Construct a request.
     */
-    RibRegisterQueueEntry<A> *rr 
-	= new RibRegisterQueueEntry<A>(nexthop, ref_cnt, resolvable, metric);
+    rr = new RibRegisterQueueEntry<A>(nexthop, ref_cnt, resolvable, metric);
 
     /*
     ** Add the request to the queue.
     */
     _queue.push_back(rr);
-
-    /*
-    ** We allow only one outstanding request to the RIB. The "_busy"
-    ** flag marks if there is currently an outstanding request.
-    */
-    if (!_busy) {
-	send_next_request();
-    }
+    send_next_request();
 }
 
 template<class A>
 bool
-NextHopRibRequest<A>::lookup(const A& nexthop, 
+NextHopRibRequest<A>::lookup(const A& nexthop,
 			     bool& resolvable, uint32_t& metric) const
 {
     /*
     ** Make sure that we are not already waiting for a response for
     ** this sucker.
     */
-    typename list<RibRequestQueueEntry<A> *>::const_iterator i;
-    for (i = _queue.begin(); i != _queue.end(); i++) {
-	RibRegisterQueueEntry<A> *rr = 
-	    dynamic_cast<RibRegisterQueueEntry<A> *>(*i);
-	if (rr && rr->reregister() && rr->nexthop() == nexthop) {
-	    resolvable = rr->resolvable();
-	    metric = rr->metric();
-	    debug_msg("nexthop %s resolvable %d metric %u\n",
-		      nexthop.str().c_str(), resolvable,
-		      XORP_UINT_CAST(metric));
-	    return true;
-	}
+    RibRegisterQueueEntry<A> *rr = find_register(nexthop);
+    if (rr && rr->reregister()) {
+	resolvable = rr->resolvable();
+	metric = rr->metric();
+	debug_msg("nexthop %s resolvable %d metric %u\n",
+		  nexthop.str().c_str(), resolvable,
+		  XORP_UINT_CAST(metric));
+	return true;
     }
 
     debug_msg("nexthop %s not resolvable\n", nexthop.str().c_str());
@@ -1254,42 +1467,36 @@ NextHopRibRequest<A>::lookup(const A& nexthop,
 
 template<>
 void
-NextHopRibRequest<IPv4>::deregister_interest(IPv4 addr, 
-					     uint32_t prefix_len)
+NextHopRibRequest<IPv4>::deregister_interests(const XrlAtomList& addrs,
+					      const XrlAtomList& prefix_lens,
+					      uint32_t batch)
 {
-    debug_msg("addr %s/%u\n", addr.str().c_str(), XORP_UINT_CAST(prefix_len));
+    debug_msg("%u subnets\n", XORP_UINT_CAST(addrs.size()));
     PROFILE(XLOG_TRACE(_bgp.profile().enabled(trace_nexthop_resolution),
-		       "addr %s/%u\n", addr.str().c_str(),
-		       XORP_UINT_CAST(prefix_len)));
+		       "%u subnets\n", XORP_UINT_CAST(addrs.size())));
     if (0 == _xrl_router)	// The test code sets _xrl_router to zero
 	return;
 
     XrlRibV0p1Client rib(_xrl_router);
-    rib.send_deregister_interest4(_ribname.c_str(),
-				  _xrl_router->name(),
-				  addr,
-				  prefix_len,
-	    ::callback(this,&NextHopRibRequest::deregister_interest_response,
-		       addr, prefix_len,
-		       c_format("deregister_from_rib: addr %s/%u",
-				addr.str().c_str(),
-				XORP_UINT_CAST(prefix_len))));
+    rib.send_bulk_deregister_interest4(_ribname.c_str(),
+				       _xrl_router->name(),
+				       addrs,
+				       prefix_lens,
+	    ::callback(this,&NextHopRibRequest::deregister_interests_response,
+		       batch,
+		       c_format("deregister_from_rib: %u subnets",
+				XORP_UINT_CAST(addrs.size()))));
 }
 
 template <class A>
 void
-NextHopRibRequest<A>::deregister_interest_response(const XrlError& error, 
-						   A addr,
-						   uint32_t prefix_len,
-						   string comment)
+NextHopRibRequest<A>::deregister_interests_response(const XrlError& error,
+						    const XrlAtomList *
+						    deregistered,
+						    uint32_t batch,
+						    string comment)
 {
-    //Check that this answer is for the question on the front of the queue
-    XLOG_ASSERT(!_queue.empty());
-    RibDeregisterQueueEntry<A> *rd = 
-	dynamic_cast<RibDeregisterQueueEntry<A> *>(_queue.front());
-    XLOG_ASSERT(rd != NULL);
-    XLOG_ASSERT(addr == rd->base_addr());
-    XLOG_ASSERT(prefix_len == rd->prefix_len());
+    typename list<Batch>::iterator b = find_batch(batch);
 
     debug_msg("%s %s\n", comment.c_str(), error.str().c_str());
     switch (error.error_code()) {
@@ -1313,6 +1520,9 @@ NextHopRibRequest<A>::deregister_interest_response(const XrlError& error,
 	    delete _queue.front();
 		_queue.pop_front();
 	}
+	for_each(b->_entries.begin(), b->_entries.end(),
+		 &NextHopRibRequest::zapper);
+	_batches.erase(b);
 	return;
 	break;
     case SEND_FAILED:
@@ -1321,43 +1531,53 @@ NextHopRibRequest<A>::deregister_interest_response(const XrlError& error,
     case SEND_FAILED_TRANSIENT:
     case NO_SUCH_METHOD:
     case BAD_ARGS:
+    case COMMAND_FAILED:
     case INTERNAL_ERROR:
 	XLOG_FATAL("callback: %s %s",  comment.c_str(), error.str().c_str());
 	break;
-    case COMMAND_FAILED:
+    }
+
+    if (deregistered->size() != b->_entries.size())
+	XLOG_FATAL("callback: %s %u subnets sent, %u answers",
+		   comment.c_str(), XORP_UINT_CAST(b->_entries.size()),
+		   XORP_UINT_CAST(deregistered->size()));
+
+    typename list<RibRequestQueueEntry<A> *>::iterator i;
+    size_t k = 0;
+    for (i = b->_entries.begin(); i != b->_entries.end(); i++, k++) {
+	RibDeregisterQueueEntry<A> *rd =
+	    dynamic_cast<RibDeregisterQueueEntry<A> *>(*i);
+	XLOG_ASSERT(rd != NULL);
+	bool ok = false;
+	try {
+	    ok = deregistered->get(k).boolean();
+	} catch (const XorpException& e) {
+	    XLOG_FATAL("callback: %s bad answer %u %s", comment.c_str(),
+		       XORP_UINT_CAST(k), e.str().c_str());
+	}
 	/*
 	** If it possible that we were de-registering interest in this
-	** nexthop when it became invalid. In this case the command
-	** may fail as the RIB has already told us it is invalid.
+	** nexthop when it became invalid. In this case the deregister
+	** fails as the RIB has already told us it is invalid.
+	**
+	** Otherwise the de-registration may have failed because the
+	** RIB has already sent as an invalid for this
+	** registration. The invalid however has not yet been
+	** received by BGP. So rather than generate a warning here
+	** wait until we receive the next invalid. If it does not
+	** match this net generate an error.
 	*/
-	if (_invalid) {
-	    XLOG_ASSERT(addr == _invalid_net.masked_addr() &&
-			prefix_len == _invalid_net.prefix_len());
-	    _invalid = false;
-	} else {
-	    // The de-registration may have failed because the
-	    // RIB has already sent as an invalid for this
-	    // registration. The invalid however has not yet been
-	    // received by BGP. So rather than generate a warning here
-	    // wait until we receive the next invalid. If it does not
-	    // match this net generate an error.
-	    _tardy_invalid = true;
-	    _tardy_invalid_net = IPNet<A>(addr, prefix_len);
-	}
-	break;
+	IPNet<A> net(rd->base_addr(), rd->prefix_len());
+	if (!ok && b->_invalid.find(net) == b->_invalid.end())
+	    _tardy_invalid_nets.insert(net);
+	delete rd;
     }
 
-    //remove this request from the queue
-    delete rd;
-    _queue.pop_front();
+    //remove this batch
+    _batches.erase(b);
 
     //if there's anything else queued, send it.
-    if (_queue.empty())
-	_busy = false;
-    else
-	send_next_request();
-
-    return;
+    send_next_request();
 }
 
 /****************************************/
@@ -1434,6 +1654,7 @@ NHRequest<A>::request_nets(NhLookupTable<A>* requester) const
 
 //force these templates to be built
 template class NextHopResolver<IPv4>;
+template class NextHopRibRequest<IPv4>;
 
 
 #ifdef HAVE_IPV6
@@ -1441,49 +1662,51 @@ template class NextHopResolver<IPv4>;
 
 template<>
 void
-NextHopRibRequest<IPv6>::register_interest(IPv6 nexthop)
+NextHopRibRequest<IPv6>::register_interests(const XrlAtomList& nexthops,
+					   uint32_t batch)
 {
-    debug_msg("nexthop %s\n", nexthop.str().c_str());
+    debug_msg("%u nexthops\n", XORP_UINT_CAST(nexthops.size()));
     PROFILE(XLOG_TRACE(_bgp.profile().enabled(trace_nexthop_resolution),
-		       "nexthop %s\n", nexthop.str().c_str()));
+		       "%u nexthops\n", XORP_UINT_CAST(nexthops.size())));
     if (0 == _xrl_router)	// The test code sets _xrl_router to zero
 	return;
 
     XrlRibV0p1Client rib(_xrl_router);
-    rib.send_register_interest6(_ribname.c_str(), _xrl_router->name(),
-				nexthop,
-				::callback(this,
-		&NextHopRibRequest::register_interest_response,
-		nexthop,
-		c_format("nexthop: %s", nexthop.str().c_str())));
+    rib.send_bulk_register_interest6(_ribname.c_str(), _xrl_router->name(),
+				     nexthops,
+				     ::callback(this,
+		&NextHopRibRequest::register_interests_response,
+		batch,
+		c_format("%u nexthops",
+			 XORP_UINT_CAST(nexthops.size()))));
 }
 
 template<>
 void
-NextHopRibRequest<IPv6>::deregister_interest(IPv6 addr, 
-					     uint32_t prefix_len)
+NextHopRibRequest<IPv6>::deregister_interests(const XrlAtomList& addrs,
+					      const XrlAtomList& prefix_lens,
+					      uint32_t batch)
 {
-    debug_msg("addr %s/%u\n", addr.str().c_str(), XORP_UINT_CAST(prefix_len));
+    debug_msg("%u subnets\n", XORP_UINT_CAST(addrs.size()));
     PROFILE(XLOG_TRACE(_bgp.profile().enabled(trace_nexthop_resolution),
-		       "addr %s/%u\n", addr.str().c_str(),
-		       XORP_UINT_CAST(prefix_len)));
+		       "%u subnets\n", XORP_UINT_CAST(addrs.size())));
     if (0 == _xrl_router)	// The test code sets _xrl_router to zero
 	return;
 
     XrlRibV0p1Client rib(_xrl_router);
-    rib.send_deregister_interest6(_ribname.c_str(),
-				  _xrl_router->name(),
-				  addr,
-				  prefix_len,
-	    ::callback(this,&NextHopRibRequest::deregister_interest_response,
-		       addr, prefix_len,
-		       c_format("deregister_from_rib: addr %s/%u",
-				addr.str().c_str(),
-				XORP_UINT_CAST(prefix_len))));
+    rib.send_bulk_deregister_interest6(_ribname.c_str(),
+				       _xrl_router->name(),
+				       addrs,
+				       prefix_lens,
+	    ::callback(this,&NextHopRibRequest::deregister_interests_response,
+		       batch,
+		       c_format("deregister_from_rib: %u subnets",
+				XORP_UINT_CAST(addrs.size()))));
 }
 
 
 template class NextHopResolver<IPv6>;
+template class NextHopRibRequest<IPv6>;
 
 
 #endif //ipv6
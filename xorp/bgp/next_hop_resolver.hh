@@ -33,6 +33,7 @@
 #include "libxorp/ipnet.hh"
 #include "libxorp/ref_trie.hh"
 
+#include "libxipc/xrl_atom_list.hh"
 #include "libxipc/xrl_std_router.hh"
 
 template<class A> class NhLookupTable;
@@ -565,11 +566,15 @@ private:
 /**
  * Make requests of the RIB and get responses.
  *
- * At any time there is only ever one outstanding request to the
- * RIB. Firstly we don't want to overrun the RIB with
- * requests. Secondly it is possible that different next hops in the
- * queue of requests may resolve to the same address/prefix_len answer
- * (see below).
+ * Requests are queued and sent to the RIB in batches: a run of
+ * queued requests of the same kind travels in a single bulk XRL, and
+ * only a small window of batches may be outstanding at once. Firstly
+ * we don't want to overrun the RIB with requests. Secondly it is
+ * possible that different next hops in the queue of requests may
+ * resolve to the same address/prefix_len answer (see below), so
+ * holding back the tail of the queue lets one answer satisfy many
+ * next hops. Each batch carries an id, so the answers may arrive in
+ * any order.
  */
 template<class A>
 class NextHopRibRequest {
@@ -604,22 +609,34 @@ public:
      * A small method that will be specialized to differentiate
      * between IPv4 and IPv6.
      *
-     * @param nexthop The next hop that we are attempting to resolve.
+     * @param nexthops The next hops that we are attempting to resolve.
+     * @param batch The id of the batch carrying them.
+     */
+    void register_interests(const XrlAtomList& nexthops, uint32_t batch);
+
+    /**
+     * XRL callback from register_interests, one list element per next
+     * hop of the batch.
+     *
+     * @param batch The id of the batch answered.
      */
-    void register_interest(A nexthop);
+    void register_interests_response(const XrlError& error,
+				     const XrlAtomList *resolves,
+				     const XrlAtomList *addrs,
+				     const XrlAtomList *prefix_lens,
+				     const XrlAtomList *real_prefix_lens,
+				     const XrlAtomList *actual_nexthops,
+				     const XrlAtomList *metrics,
+				     uint32_t batch,
+				     const string comment);
 
     /**
-     * XRL callback from register_interest.
+     * An invalidate has been received, any answer for this subnet
+     * that is still in flight is stale.
+     *
+     * @return True if an outstanding request was affected.
      */
-    void register_interest_response(const XrlError& error,
-				    const bool *resolves,
-				    const A *addr,
-				    const uint32_t *prefix_len,
-				    const uint32_t *real_prefix_len,
-				    const A *actual_nexthop,
-				    const uint32_t *metric,
-				    const A nexthop_interest,
-				    const string comment);
+    bool mark_invalid(const A& addr, const uint32_t& prefix_len);
 
 
     /**
@@ -688,25 +705,64 @@ public:
     void deregister_from_rib(const A& nexthop, uint32_t prefix_len);
 
     /*
-     * Deregister ourselves from the RIB for this next hop
+     * Deregister ourselves from the RIB for these next hops
      *
-     * @param nexthop The next hop.
-     * @param prefix_len The prefix_len we registered with.
+     * @param addrs The base addresses we registered with.
+     * @param prefix_lens The prefix_lens we registered with.
+     * @param batch The id of the batch carrying them.
      */
-    void deregister_interest(A nexthop, uint32_t prefix_len);
+    void deregister_interests(const XrlAtomList& addrs,
+			      const XrlAtomList& prefix_lens,
+			      uint32_t batch);
 
     /**
      * XRL response method.
      *
      * @param error Error returned by xrl call.
+     * @param deregistered For each subnet whether the RIB knew of it.
+     * @param batch The id of the batch answered.
      * @param comment Comment string used for diagnostic purposes.
      */
-    void deregister_interest_response(const XrlError& error, 
-				      A addr,
-				      uint32_t prefix_len,
-				      string comment);
+    void deregister_interests_response(const XrlError& error,
+				       const XrlAtomList *deregistered,
+				       uint32_t batch,
+				       string comment);
 
 private:
+    /**
+     * An answer from the RIB for one next hop.
+     */
+    struct RegisterAnswer {
+	A _nexthop;
+	bool _resolves;
+	A _addr;
+	uint32_t _prefix_len;
+	uint32_t _real_prefix_len;
+	uint32_t _metric;
+    };
+
+    /**
+     * The requests carried by one bulk XRL, all of the same kind.
+     */
+    struct Batch {
+	uint32_t _id;
+	list<RibRequestQueueEntry<A> *> _entries;
+	set<IPNet<A> > _invalid;	// Invalids that beat the response.
+    };
+
+    void check_register_error(const XrlError& error, const string& comment);
+    void process_answer(Batch& batch, RibRegisterQueueEntry<A> *rr,
+			const RegisterAnswer& answer,
+			vector<RegisterAnswer>& added);
+    void finish_answers(typename list<Batch>::iterator batch,
+			const vector<RegisterAnswer>& added);
+    void complete_register(RibRegisterQueueEntry<A> *rr, bool resolvable);
+    void queue_deregister(const A& base_addr, uint32_t prefix_len);
+    RibRegisterQueueEntry<A> *find_register(const A& nexthop) const;
+    bool find_deregister(const A& base_addr, uint32_t prefix_len) const;
+    bool register_pending(const IPNet<A>& net) const;
+    typename list<Batch>::iterator find_batch(uint32_t id);
+
     string _ribname;
     XrlStdRouter *_xrl_router;
     NextHopResolver<A>& _next_hop_resolver;
@@ -714,19 +770,27 @@ private:
     BGPMain& _bgp;
 
     /**
-     * Are we currently waiting for a response from the RIB.
+     * The batches that we are waiting for the RIB to answer, oldest
+     * first.
      */
-    bool _busy;
+    list<Batch> _batches;
+    uint32_t _next_batch;	// The id of the next batch sent.
 
-    bool _invalid;		// True if received an unmatched invalid call.
-    IPNet<A> _invalid_net;	// Saved invalid subnet.
+    /**
+     * Subnets to deregister once the registrations inside them that
+     * are queued or in flight have been answered.
+     */
+    set<IPNet<A> > _held_deregisters;
 
-    bool _tardy_invalid;	// True if we are expecting an invalid
-				// from the RIB.
-    IPNet<A> _tardy_invalid_net;// Saved invalid subnet.
+    /**
+     * Subnets that we failed to deregister, because the RIB had
+     * already invalidated them; we are expecting these invalids
+     * from the RIB.
+     */
+    set<IPNet<A> > _tardy_invalid_nets;
 
     /**
-     * The queue of outstanding requests.
+     * The queue of requests not yet sent.
      */
     list<RibRequestQueueEntry<A> *> _queue;
 
@@ -204,13 +204,60 @@ private:
 
 /* **************** UpdatePacket *********************** */
 
+class DecodedUpdate;
+
 class UpdatePacket : public BGPPacket {
 public:
     UpdatePacket();
+
+    /**
+     * Decode a received message.
+     *
+     * @param in_place if true the withdrawn routes and NLRI are left
+     * in the message, and iterated over with wr_wire() and
+     * nlri_wire(), until wr_list() or nlri_list() is called.  The
+     * path attributes received in canonical form are kept as they
+     * are, and only decoded again if they are used.  The message must
+     * outlive the packet.
+     */
     UpdatePacket(const uint8_t *d, uint16_t l, const BGPPeerData *peerdata,
-		 BGPMain* mainprocess, bool do_checks)
+		 BGPMain* mainprocess, bool do_checks, bool in_place = false)
+	throw(CorruptMessage,UnusableMessage);
+
+    /**
+     * Build a packet from a message that an UpdateDecoder has taken
+     * apart, with all the checks.  The path attributes, withdrawn
+     * routes and NLRI are moved out of the decoded message.  Here the
+     * AS paths are interned and the next hops are checked.
+     *
+     * The errors thrown are the ones the other constructor would throw
+     * for the same message.
+     */
+    UpdatePacket(DecodedUpdate& du, BGPMain* mainprocess)
 	throw(CorruptMessage,UnusableMessage);
 
+    /**
+     * Check the lengths of the sections of an UPDATE message and decode
+     * the withdrawn routes.  Touches no shared state, so it can be
+     * called on any thread.
+     *
+     * @param d the message.
+     * @param l the length of the message.
+     * @param wr_list the withdrawn routes.
+     * @param duplicates if not NULL, where to put the duplicate
+     * withdrawn routes rather than logging them.
+     * @param pa_offset the offset of the path attributes in the message.
+     * @param pa_len the length of the path attributes.
+     * @param nlri_offset the offset of the NLRI in the message.
+     * @param nlri_len the length of the NLRI.
+     */
+    static void decode_sections(const uint8_t *d, uint16_t l,
+				BGPUpdateAttribList& wr_list,
+				BGPUpdateAttribList *duplicates,
+				size_t& pa_offset, size_t& pa_len,
+				size_t& nlri_offset, size_t& nlri_len)
+	throw(CorruptMessage);
+
     ~UpdatePacket();
 
     void add_withdrawn(const BGPUpdateAttrib& wdr);
@@ -220,9 +267,30 @@ public:
     void add_pathatt(PathAttribute *pa);
 
     void add_nlri(const BGPUpdateAttrib& nlri);
-    const BGPUpdateAttribList& wr_list() const		{ return _wr_list; }
+    const BGPUpdateAttribList& wr_list() const		{
+	decode_in_place();
+	return _wr_list;
+    }
     FPAList4Ref& pa_list() 	                        { return  _pa_list; }
-    const BGPUpdateAttribList& nlri_list() const	{ return _nlri_list; }
+    const BGPUpdateAttribList& nlri_list() const	{
+	decode_in_place();
+	return _nlri_list;
+    }
+
+    /**
+     * @return true if the withdrawn routes and NLRI are still in the
+     * received message, where wr_wire() and nlri_wire() find them.
+     */
+    bool in_place() const				{ return _in_place; }
+    const BGPUpdateAttribWire& wr_wire() const		{ return _wr_wire; }
+    const BGPUpdateAttribWire& nlri_wire() const	{ return _nlri_wire; }
+
+    /**
+     * @return the number of NLRI, without decoding them.
+     */
+    size_t nlri_count() const				{
+	return _in_place ? _nlri_wire.size() : _nlri_list.size();
+    }
 
     template <typename A> const MPReachNLRIAttribute<A> *mpreach(Safi) const;
     template <typename A> const MPUNReachNLRIAttribute<A> *mpunreach(Safi) const;
@@ -239,9 +307,28 @@ private:
     // don't allow the use of the default copy constructor
     UpdatePacket(const UpdatePacket& UpdatePacket);
 
-    BGPUpdateAttribList		_wr_list;
+    /**
+     * Check the lengths of the sections of an UPDATE message.
+     */
+    static void find_sections(const uint8_t *d, uint16_t l,
+			      size_t& wr_offset, size_t& wr_len,
+			      size_t& pa_offset, size_t& pa_len,
+			      size_t& nlri_offset, size_t& nlri_len)
+	throw(CorruptMessage);
+
+    /**
+     * Copy the withdrawn routes and NLRI of a packet decoded in place
+     * out of the message.
+     */
+    void decode_in_place() const;
+
+    mutable BGPUpdateAttribList	_wr_list;
     FPAList4Ref	                _pa_list;
-    BGPUpdateAttribList		_nlri_list;
+    mutable BGPUpdateAttribList	_nlri_list;
+
+    mutable bool		_in_place;
+    BGPUpdateAttribWire		_wr_wire;
+    BGPUpdateAttribWire		_nlri_wire;
 };
 
 template <typename A> 
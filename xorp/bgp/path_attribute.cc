@@ -2240,6 +2240,20 @@ PathAttribute::set_header(uint8_t *data, size_t payload_size, size_t &wire_size)
 
 #define PARANOID
 
+/*
+ * FNV-1a hash of the canonical data of a PathAttributeList.
+ */
+uint32_t
+canonical_hash(const uint8_t* data, size_t len)
+{
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < len; i++) {
+	hash ^= data[i];
+	hash *= 16777619U;
+    }
+    return hash;
+}
+
 template<class A>
 PathAttributeList<A>::PathAttributeList() 
     : _refcount(0), _managed_refcount(0)
@@ -2247,6 +2261,7 @@ PathAttributeList<A>::PathAttributeList()
     debug_msg("%p\n", this);
     _canonical_data = 0;
     _canonical_length = 0;
+    _hash = canonical_hash(_canonical_data, _canonical_length);
 }
 
 template<class A>
@@ -2258,6 +2273,7 @@ PathAttributeList<A>::PathAttributeList(const PathAttributeList<A>& palist)
     _canonical_length = palist._canonical_length;
     _canonical_data = new uint8_t[_canonical_length];
     memcpy(_canonical_data, palist._canonical_data, _canonical_length);
+    _hash = palist._hash;
 }
 
 template<class A>
@@ -2268,6 +2284,7 @@ PathAttributeList<A>::PathAttributeList(FPAListRef& fpa_list)
     _canonical_length = fpa_list->canonical_length();
     _canonical_data = new uint8_t[_canonical_length];
     memcpy(_canonical_data, fpa_list->canonical_data(), _canonical_length);
+    _hash = canonical_hash(_canonical_data, _canonical_length);
 }
     
 template<class A>
@@ -2338,6 +2355,8 @@ bool
 PathAttributeList<A>::
 operator== (const PathAttributeList<A> &him) const
 {
+    if (_hash != him.hash())
+	return false;
     if (_canonical_length != him.canonical_length())
 	return false;
     return (memcmp(_canonical_data, him.canonical_data(), _canonical_length) == 0);
@@ -2588,6 +2607,7 @@ FastPathAttributeList<A>::FastPathAttributeList(PAListRef<A>& palistref)
 template<class A>
 FastPathAttributeList<A>::FastPathAttributeList(FastPathAttributeList<A>& him)
     :   _slave_pa_list(him._slave_pa_list), 
+	_received_data(him._received_data),
 	_locked(false),
 	_canonical_data(0),
 	_canonical_length(0),
@@ -2748,6 +2768,57 @@ FastPathAttributeList<A>::aspath() {
 
 
 
+/*
+** Is an attribute received from a peer in the canonical form
+** canonicalize() would encode it to?  The header must be the one we
+** would write, and the payload must be one that the decoding and the
+** encoding preserve: the AS numbers must be 4 bytes, the communities
+** must already be sorted, and so on.
+*/
+static bool
+received_in_canonical_form(const PathAttribute* pa, const uint8_t* d,
+			   size_t len, const BGPPeerData* peerdata)
+{
+    size_t hdr_len = (d[0] & PathAttribute::Extended) ? 4 : 3;
+    size_t payload_len = len - hdr_len;
+    uint8_t flags = d[0] & PathAttribute::ValidFlags
+	& ~PathAttribute::Extended;
+    if (payload_len > 255)
+	flags |= PathAttribute::Extended;
+    if (d[0] != flags)
+	return false;
+
+    switch (d[1]) {
+    case ORIGIN:
+    case NEXT_HOP:
+    case MED:
+    case LOCAL_PREF:
+    case ATOMIC_AGGREGATE:
+    case ORIGINATOR_ID:
+	return true;
+
+    case AS_PATH:
+    case AGGREGATOR:
+	return peerdata == NULL || peerdata->use_4byte_asnums();
+
+    case CLUSTER_LIST:
+	return payload_len % 4 == 0;
+
+    case COMMUNITY: {
+	if (payload_len % 4 != 0)
+	    return false;
+	const uint8_t* p = d + hdr_len;
+	for (size_t i = 4; i < payload_len; i += 4)
+	    if (memcmp(p + i - 4, p + i, 4) >= 0)
+		return false;
+	return true;
+    }
+
+    default:
+	return dynamic_cast<const UnknownAttribute*>(pa) != 0;
+    }
+}
+
 template<class A>
 void
 FastPathAttributeList<A>::load_raw_data(const uint8_t *data, 
@@ -2755,13 +2826,38 @@ FastPathAttributeList<A>::load_raw_data(const uint8_t *data,
 					const BGPPeerData* peerdata,
 					bool have_nlri,
 					BGPMain *mainprocess,
-					bool do_checks)
+					bool do_checks,
+					bool keep_canonical)
 {
     debug_msg("FastPathAttributeList::load_raw_data\n");
+    decode_raw_data(data, size, peerdata, have_nlri, do_checks,
+		    keep_canonical);
+    check_nexthops(mainprocess, do_checks);
+}
+
+template<class A>
+void
+FastPathAttributeList<A>::decode_raw_data(const uint8_t *data, 
+					  size_t size, 
+					  const BGPPeerData* peerdata,
+					  bool have_nlri,
+					  bool do_checks,
+					  bool keep_canonical)
+{
     XLOG_ASSERT(!_locked);
     _canonicalized = false;
     bool have_ipv4_nlri = have_nlri;
 
+    // The attributes are decoded to check them, but those already in
+    // canonical form are also kept as they are, so the lists copied
+    // from this one get the bytes rather than copies of the decoded
+    // attributes.
+    const uint8_t* received = 0;
+    if (keep_canonical && size > 0) {
+	_received_data = new vector<uint8_t>(data, data + size);
+	received = &(*_received_data)[0];
+    }
+
     // We need to decode the data into a set of path attributes, then
     // store the canonical form.
 
@@ -2807,7 +2903,11 @@ FastPathAttributeList<A>::load_raw_data(const uint8_t *data,
 		       buf, wire_size);
 	}
 
-	if (type <= MAX_ATTRIBUTE) {
+	if (type <= MAX_ATTRIBUTE && received != 0
+	    && received_in_canonical_form(pa, data, used, peerdata)) {
+	    _att_bytes[type] = received + (size - pa_len);
+	    _att_lengths[type] = used;
+	} else if (type <= MAX_ATTRIBUTE) {
 	    // we don't yet have a canonical form stored, so these
 	    // accessor shortcuts are not yet usable
 	    _att_bytes[type] = 0;
@@ -2859,12 +2959,6 @@ FastPathAttributeList<A>::load_raw_data(const uint8_t *data,
 		    xorp_throw(CorruptMessage,"Illegal nexthop", UPDATEMSGERR, 
 			       MISSWATTR, &data, 1);
 		}
-		if (mainprocess && 
-		    mainprocess->interface_address4(mp4_reach_att->nexthop())) {
-		    XLOG_ERROR("Nexthop in update belongs to this router:\n %s",
-			       cstring(*this));
-		    xorp_throw(UnusableMessage, "Nexthop belongs to this router");
-		}
 	    }
 	}
 
@@ -2885,12 +2979,6 @@ FastPathAttributeList<A>::load_raw_data(const uint8_t *data,
 		    xorp_throw(CorruptMessage,"Illegal nexthop", UPDATEMSGERR, 
 			       MISSWATTR, &data, 1);
 		}
-		if (do_checks && mainprocess &&
-		    mainprocess->interface_address6(mp6_reach_att->nexthop())) {
-		    XLOG_ERROR("Nexthop in update belongs to this router:\n %s",
-			       cstring(*this));
-		    xorp_throw(UnusableMessage, "Nexthop6 belongs to this router");
-		}
 	    }
 	}
 #endif
@@ -2992,20 +3080,62 @@ FastPathAttributeList<A>::load_raw_data(const uint8_t *data,
 		       UPDATEMSGERR, MALASPATH);
     }
 
+    count_attributes();
+}
+
+template<class A>
+void
+FastPathAttributeList<A>::intern_as_paths()
+{
+    if (_att[AS_PATH] != NULL)
+	((ASPathAttribute*)_att[AS_PATH])->as_path().intern();
+    if (_att[AS4_PATH] != NULL)
+	((AS4PathAttribute*)_att[AS4_PATH])->as_path().intern();
+}
+
+template<class A>
+void
+FastPathAttributeList<A>::check_nexthops(BGPMain *mainprocess,
+					 bool do_checks)
+{
+    if (mainprocess == NULL)
+	return;
+
     // If an update message is received that contains a nexthop
     // that belongs to this router then discard the update, don't
-    // send a notification.
+    // send a notification.  The multiprotocol attributes left were
+    // negotiated.
+    if (_att[MP_REACH_NLRI]) {
+	MPReachNLRIAttribute<IPv4>* mp4_reach_att =
+	    dynamic_cast<MPReachNLRIAttribute<IPv4>*>(_att[MP_REACH_NLRI]);
+	if (mp4_reach_att &&
+	    mainprocess->interface_address4(mp4_reach_att->nexthop())) {
+	    XLOG_ERROR("Nexthop in update belongs to this router:\n %s",
+		       cstring(*this));
+	    xorp_throw(UnusableMessage, "Nexthop belongs to this router");
+	}
+
+#ifdef HAVE_IPV6
+	MPReachNLRIAttribute<IPv6>* mp6_reach_att =
+	    dynamic_cast<MPReachNLRIAttribute<IPv6>*>(_att[MP_REACH_NLRI]);
+	if (do_checks && mp6_reach_att &&
+	    mainprocess->interface_address6(mp6_reach_att->nexthop())) {
+	    XLOG_ERROR("Nexthop in update belongs to this router:\n %s",
+		       cstring(*this));
+	    xorp_throw(UnusableMessage, "Nexthop6 belongs to this router");
+	}
+#else
+	UNUSED(do_checks);
+#endif
+    }
 
     if (_att[NEXT_HOP] != NULL) {
-	if (mainprocess && 
-	    mainprocess->interface_address4(((NextHopAttribute<IPv4>*)_att[NEXT_HOP])->nexthop())) {
+	if (mainprocess->interface_address4(((NextHopAttribute<IPv4>*)_att[NEXT_HOP])->nexthop())) {
 	    XLOG_ERROR("Nexthop in update belongs to this router:\n %s",
 		       cstring(((NextHopAttribute<IPv4>*)_att[NEXT_HOP])->nexthop()));
 	    xorp_throw(UnusableMessage, "Nexthop belongs to this router");
 	}
     }
-
-    count_attributes();
 }
 
 template<class A>
@@ -3121,6 +3251,34 @@ FastPathAttributeList<A>::add_path_attribute(PathAttribute *a)
     }
 }
 
+template<class A>
+template<class A2>
+void
+FastPathAttributeList<A>::copy_path_attribute(FastPathAttributeList<A2>& him,
+					      PathAttType type)
+{
+    XLOG_ASSERT(!_locked);
+
+    // The bytes can only be shared if they are the ones received,
+    // and we don't already share those of another list.
+    if (type <= MAX_ATTRIBUTE && him._att_bytes[type] != 0
+	&& !him._received_data.is_empty()
+	&& (_received_data.is_empty()
+	    || _received_data == him._received_data)) {
+	remove_attribute_by_type(type);
+	_canonicalized = false;
+	_received_data = him._received_data;
+	_att_bytes[type] = him._att_bytes[type];
+	_att_lengths[type] = him._att_lengths[type];
+	_attribute_count++;
+	return;
+    }
+
+    PathAttribute* pa = him.find_attribute_by_type(type);
+    if (pa)
+	add_path_attribute(*pa);
+}
+
 template<class A>
 PathAttribute*
 FastPathAttributeList<A>::find_attribute_by_type(PathAttType type)
@@ -3347,7 +3505,10 @@ FastPathAttributeList<A>::encode(uint8_t* buf, size_t &wire_size,
 
 	// we're using 4byte AS nums, but our peer isn't so we need to
 	// add an AS4Path attribute
-	XLOG_ASSERT(_att[AS_PATH]);  // surely we've decoded this by now?
+	// The AS path of a list loaded from a received UPDATE may not
+	// have been decoded yet.
+	FastPathAttributeList<A>* me = const_cast<FastPathAttributeList<A>*>(this);
+	XLOG_ASSERT(me->aspath_att());
 	if (!((ASPathAttribute*)_att[AS_PATH])->as_path().two_byte_compatible()) {
 	    // only add the AS4Path if we can't code the ASPath without losing information
 
@@ -3379,14 +3540,15 @@ FastPathAttributeList<A>::encode_and_decode_attribute(const uint8_t* att_data,
 						      const BGPPeerData* peerdata) const
 {
     PathAttribute *pa;
-    bool use_4byte_asnums = peerdata->use_4byte_asnums();
+    bool use_4byte_asnums = peerdata->use_4byte_asnums()
+	&& peerdata->we_use_4byte_asnums();
     switch (att_data[1]) {	// depending on type, do the right thing.
 
     case AS_PATH: 
     case AGGREGATOR:
 	// AS Path and Aggregator can be encoded differently for each
 	// peer, so we need to decode and re-encode if we are not
-	// using 4-byte AS nums.
+	// using 4-byte AS nums.  The canonical form has 4-byte AS nums.
 	if (use_4byte_asnums) {
 	    if (wire_size < att_len) 
 		return false;
@@ -3395,10 +3557,10 @@ FastPathAttributeList<A>::encode_and_decode_attribute(const uint8_t* att_data,
 	    return true;
 	} else {
 	    if (att_data[1] == AS_PATH) {
-		ASPathAttribute as_path_att(att_data, use_4byte_asnums);
+		ASPathAttribute as_path_att(att_data, true);
 		return as_path_att.encode(buf, wire_size, peerdata);
 	    } else {
-		AggregatorAttribute agg_att(att_data, use_4byte_asnums);
+		AggregatorAttribute agg_att(att_data, true);
 		return agg_att.encode(buf, wire_size, peerdata);
 	    }
 	}
@@ -3453,6 +3615,10 @@ FastPathAttributeList<A>::str() const
 
 template class FastPathAttributeList<IPv4>;
 template class FastPathAttributeList<IPv6>;
+template void FastPathAttributeList<IPv4>::copy_path_attribute(
+	FastPathAttributeList<IPv4>&, PathAttType);
+template void FastPathAttributeList<IPv6>::copy_path_attribute(
+	FastPathAttributeList<IPv4>&, PathAttType);
 template class PathAttributeList<IPv4>;
 template class PathAttributeList<IPv6>;
 template class PAListRef<IPv4>;
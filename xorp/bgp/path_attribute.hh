@@ -646,6 +646,12 @@ private:
 template<class A>
 class FastPathAttributeList;
 
+/**
+ * @return the FNV-1a hash of the canonical data of a path attribute
+ * list.
+ */
+uint32_t canonical_hash(const uint8_t* data, size_t len);
+
 /**
  * PathAttributeList is used to handle efficiently path attribute lists.
  *
@@ -688,6 +694,12 @@ public:
     const uint8_t* canonical_data() const {return _canonical_data;}
     size_t canonical_length() const {return _canonical_length;}
 
+    /**
+     * @return the hash of the canonical data, computed when the list
+     * is created.  Lists with different hashes are different.
+     */
+    uint32_t hash() const {return _hash;}
+
     void incr_refcount(uint32_t change) const {
 	XLOG_ASSERT(0xffffffff - change > _refcount);
 	_refcount += change;
@@ -733,6 +745,7 @@ protected:
     // should not be sent directly - it's only for internal storage.
     uint8_t* _canonical_data;
     uint16_t _canonical_length;
+    uint32_t _hash;
 
 private:
     //    void assert_rehash() const;
@@ -775,6 +788,7 @@ public:
     inline bool is_empty() const {return _palist == 0;}
     void release();
     const PathAttributeList<A>* attributes() const {return _palist;}
+    static const AttributeManager<A>* attribute_manager() {return _att_mgr;}
     void create_attribute_manager() {
 	_att_mgr = new AttributeManager<A>();
     };
@@ -817,11 +831,42 @@ public:
      *  Load the raw path attribute data from an update message.  This
      * data will not yet be in canonical form.  Call canonicalize() to
      * put the data in canonical form.
+     *
+     * @param keep_canonical if true, keep a copy of the attributes
+     * that the peer sent in canonical form, which copy_path_attribute()
+     * shares with other lists.
      */
     void load_raw_data(const uint8_t *data, size_t size, 
 		       const BGPPeerData* peer, bool have_nlri,
 		       BGPMain *mainprocess,
-		       bool do_checks);
+		       bool do_checks,
+		       bool keep_canonical = false);
+
+    /**
+     * The first part of load_raw_data(): decode the attributes and run
+     * the checks that only depend on the message and the peer.
+     *
+     * If keep_canonical is false and interning is deferred (see
+     * ASPath::DeferIntern), this touches no state shared with other
+     * threads, and can run off the main thread.
+     */
+    void decode_raw_data(const uint8_t *data, size_t size,
+			 const BGPPeerData* peer, bool have_nlri,
+			 bool do_checks, bool keep_canonical = false);
+
+    /**
+     * Intern the AS paths of a list decoded while interning was
+     * deferred.
+     */
+    void intern_as_paths();
+
+    /**
+     * The second part of load_raw_data(): check that the next hops
+     * do not belong to this router.
+     *
+     * @throw UnusableMessage if one does.
+     */
+    void check_nexthops(BGPMain *mainprocess, bool do_checks);
 
 
     /* see commemt on _locked variable */
@@ -875,6 +920,17 @@ public:
      */
     void add_path_attribute(PathAttribute *att);
 
+    /**
+     * Add the path attribute of a type from another list.  If that
+     * list was loaded keeping the attributes received in canonical
+     * form, and this is one of them, its bytes are shared rather than
+     * the attribute copied: it is only decoded if it is used, and
+     * canonicalize() copies the bytes.
+     */
+    template <class A2>
+    void copy_path_attribute(FastPathAttributeList<A2>& him,
+			     PathAttType type);
+
     /**
      * return the relevant path attribute, given the PA type.
      */
@@ -975,8 +1031,15 @@ private:
 				     size_t& wire_size ,
 				     const BGPPeerData* peerdata) const;
 
+    template <class A2> friend class FastPathAttributeList;
+
     const PAListRef<A> _slave_pa_list;
 
+    // The attributes of a received UPDATE, when the attributes in
+    // canonical form are kept, and shared by the lists copied from
+    // this one.
+    ref_ptr<vector<uint8_t> > _received_data;
+
     // Break out of the path attribute list by type for quick access.
     // bytes and lengths include the header so we preserve the flags.
     // _att is only filled out on demand.  These can be arrays because
@@ -55,7 +55,9 @@ BGPPeer::BGPPeer(LocalData *ld, BGPPeerData *pd, SocketClient *sock,
       _damp_peer_oscillations(m->eventloop(),
 			      10,	/* restart threshold */
 			      5 * 60,	/* time period */
-			      2 * 60 	/* idle holdtime */)
+			      2 * 60 	/* idle holdtime */),
+      _decode_queue(m->update_decoder(), pd,
+		    callback(this, &BGPPeer::deliver_decoded_updates))
 {
     debug_msg("BGPPeer constructor called (1)\n");
 
@@ -66,6 +68,7 @@ BGPPeer::BGPPeer(LocalData *ld, BGPPeerData *pd, SocketClient *sock,
     _SocketClient = sock;
     _output_queue_was_busy = false;
     _handler = NULL;
+    _update_group = NULL;
     _peername = c_format("Peer-%s", peerdata()->iptuple().str().c_str());
 
     zero_stats();
@@ -75,6 +78,7 @@ BGPPeer::BGPPeer(LocalData *ld, BGPPeerData *pd, SocketClient *sock,
 
 BGPPeer::~BGPPeer()
 {
+    leave_update_group();
     delete _SocketClient;
     delete _peerdata;
     list<AcceptSession *>::iterator i;
@@ -234,6 +238,19 @@ BGPPeer::get_message(BGPPacket::Status status, const uint8_t *buf,
 
     const uint8_t* marker = buf + BGPPacket::MARKER_OFFSET;
     uint8_t type = extract_8(buf + BGPPacket::TYPE_OFFSET);
+
+    /*
+    ** The UPDATE messages still being decoded were received first.
+    */
+    if (type != MESSAGETYPEUPDATE && !_decode_queue.empty()) {
+	_decode_queue.wait();
+	deliver_decoded_updates();
+	if (!is_connected() || !still_reading()) {
+	    TIMESPENT_CHECK();
+	    return false;
+	}
+    }
+
     try {
 
 	/*
@@ -280,7 +297,24 @@ BGPPeer::get_message(BGPPacket::Status status, const uint8_t *buf,
 	    debug_msg("UPDATE Packet RECEIVED\n");
 	    _in_updates++;
 	    _mainprocess->eventloop().current_time(_in_update_time);
-	    UpdatePacket pac(buf, length, _peerdata, _mainprocess, /*do checks*/true);
+
+	    /*
+	    ** Hand the message to the decoder threads, if there are
+	    ** any. The queue is also used while it holds messages
+	    ** received before the threads were stopped.
+	    */
+	    if (_decode_queue.decoder().enabled() || !_decode_queue.empty()) {
+		_decode_queue.push(buf, length);
+		if (!_decode_queue.decoder().enabled())
+		    deliver_decoded_updates();
+		else if (_decode_queue.size() >= DECODE_QUEUE_HIGH)
+		    _SocketClient->pause_reader();
+		TIMESPENT_CHECK();
+		break;
+	    }
+
+	    UpdatePacket pac(buf, length, _peerdata, _mainprocess,
+			     /*do checks*/true, /*in place*/true);
 
 	    PROFILE(XLOG_TRACE(main()->profile().enabled(trace_message_in),
 			       "Peer %s: Receive: %s",
@@ -358,6 +392,66 @@ BGPPeer::get_message(BGPPacket::Status status, const uint8_t *buf,
     return true;
 }
 
+void
+BGPPeer::deliver_decoded_updates()
+{
+    DecodedUpdate *du;
+    while (_decode_queue.front() != NULL) {
+	/*
+	** Once we stop reading, the messages that follow are dropped
+	** as they would not have been read.
+	*/
+	if (!is_connected() || !still_reading()) {
+	    _decode_queue.clear();
+	    return;
+	}
+
+	// Processing the message may clear the queue.
+	du = _decode_queue.pop();
+	process_decoded_update(*du);
+	delete du;
+    }
+
+    if (_SocketClient->reader_paused()
+	&& _decode_queue.size() <= DECODE_QUEUE_LOW)
+	_SocketClient->resume_reader();
+}
+
+void
+BGPPeer::process_decoded_update(DecodedUpdate& du)
+{
+    TIMESPENT();
+
+    try {
+	UpdatePacket pac(du, _mainprocess);
+
+	PROFILE(XLOG_TRACE(main()->profile().enabled(trace_message_in),
+			   "Peer %s: Receive: %s",
+			   peerdata()->iptuple().str().c_str(),
+			   cstring(pac)));
+
+	// All decode errors should throw a CorruptMessage.
+	debug_msg("%s", pac.str().c_str());
+
+	event_recvupdate(pac);
+	TIMESPENT_CHECK();
+	if (TIMESPENT_OVERLIMIT()) {
+	    XLOG_WARNING("Processing packet took longer than %u second %s",
+			 XORP_UINT_CAST(TIMESPENT_LIMIT),
+			 pac.str().c_str());
+	}
+    } catch(CorruptMessage& c) {
+	XLOG_WARNING("%s %s %s", this->str().c_str(), c.where().c_str(),
+		     c.why().c_str());
+	notify_peer_of_error(c.error(), c.subcode(), c.data(), c.len());
+    } catch (UnusableMessage& um) {
+	XLOG_WARNING("%s %s %s", this->str().c_str(), um.where().c_str(),
+		     um.why().c_str());
+    }
+
+    TIMESPENT_CHECK();
+}
+
 PeerOutputState
 BGPPeer::send_message(const BGPPacket& p)
 {
@@ -426,13 +520,7 @@ BGPPeer::send_message_complete(SocketClient::Event ev, const uint8_t *buf)
     switch (ev) {
     case SocketClient::DATA:
 	debug_msg("event: data\n");
-	if (_output_queue_was_busy &&
-	    (_SocketClient->output_queue_busy() == false)) {
-	    debug_msg("Peer: output no longer busy\n");
-	    _output_queue_was_busy = false;
-	    if (_handler != NULL)
-		_handler->output_no_longer_busy();
-	}
+	output_queue_drained();
 	TIMESPENT_CHECK();
 	/*drop through to next case*/
     case SocketClient::FLUSHING:
@@ -454,6 +542,77 @@ BGPPeer::send_message_complete(SocketClient::Event ev, const uint8_t *buf)
     }
 }
 
+PeerOutputState
+BGPPeer::send_shared_update(const UpdatePacket& p,
+			    ref_ptr<EncodedUpdate> wire)
+{
+    debug_msg("%s", p.str().c_str());
+
+    PROFILE(XLOG_TRACE(main()->profile().enabled(trace_message_out),
+		       "Peer %s: Send: %s",
+		       peerdata()->iptuple().str().c_str(),
+		       cstring(p)));
+
+    _out_total_messages++;
+    _out_updates++;
+
+    /*
+    ** The buffer is shared with the other members of the update
+    ** group. The reference held by the callback keeps it until the
+    ** write completes.
+    */
+    bool ret = _SocketClient->send_message(wire->data(), wire->size(),
+		callback(this, &BGPPeer::send_shared_update_complete, wire));
+
+    if (!ret)
+	return PEER_OUTPUT_FAIL;
+
+    if (_SocketClient->output_queue_busy()) {
+	_output_queue_was_busy = true;
+	return PEER_OUTPUT_BUSY;
+    }
+
+    return PEER_OUTPUT_OK;
+}
+
+void
+BGPPeer::send_shared_update_complete(SocketClient::Event ev,
+				     const uint8_t* /*buf*/,
+				     ref_ptr<EncodedUpdate> /*wire*/)
+{
+    TIMESPENT();
+
+    switch (ev) {
+    case SocketClient::DATA:
+	debug_msg("event: data\n");
+	output_queue_drained();
+	TIMESPENT_CHECK();
+	break;
+    case SocketClient::FLUSHING:
+	// The buffer goes with the last reference to it.
+	debug_msg("event: flushing\n");
+	break;
+    case SocketClient::ERROR:
+	debug_msg("event: error\n");
+	event_closed();
+	TIMESPENT_CHECK();
+    }
+}
+
+void
+BGPPeer::output_queue_drained()
+{
+    if (_output_queue_was_busy &&
+	(_SocketClient->output_queue_busy() == false)) {
+	debug_msg("Peer: output no longer busy\n");
+	_output_queue_was_busy = false;
+	if (_update_group != NULL && _update_group->following(this))
+	    _update_group->member_ready(this);
+	else if (_handler != NULL)
+	    _handler->output_no_longer_busy();
+    }
+}
+
 void
 BGPPeer::send_notification(const NotificationPacket& p, bool restart,
 			   bool automatic)
@@ -1117,7 +1276,7 @@ BGPPeer::event_recvupdate(UpdatePacket& p) // EVENTRECUPDATEMESS
 	ConfigVar<uint32_t> &prefix_limit =
 	    const_cast<BGPPeerData *>(peerdata())->get_prefix_limit();
 	if (prefix_limit.get_enabled()) {
-	    if ((_handler->get_prefix_count() + p.nlri_list().size())
+	    if ((_handler->get_prefix_count() + p.nlri_count())
 		> prefix_limit.get_var()) {
 		NotificationPacket np(CEASE);
 		send_notification(np);
@@ -1723,6 +1882,9 @@ BGPPeer::established()
 //     _out_updates = 0;
 //     _in_total_messages = 0;
 //     _out_total_messages = 0;
+    leave_update_group();
+    _mainprocess->update_groups().join(this, _handler);
+
     _established_transitions++;
     _mainprocess->eventloop().current_time(_established_time);
     _mainprocess->eventloop().current_time(_in_update_time);
@@ -1992,9 +2154,15 @@ BGPPeer::release_resources()
 
     debug_msg("BGPPeer::release_resources()\n");
 
+    // Leave the update group first, so that it sends us nothing more.
+    leave_update_group();
+
     if (_handler != NULL && _handler->peering_is_up())
 	_handler->peering_went_down();
 
+    // Drop the messages from this session still being decoded.
+    _decode_queue.clear();
+
     TIMESPENT_CHECK();
 
     /*
@@ -2013,6 +2181,15 @@ BGPPeer::release_resources()
     return true;
 }
 
+void
+BGPPeer::leave_update_group()
+{
+    if (_update_group == NULL)
+	return;
+
+    _mainprocess->update_groups().leave(this);
+}
+
 #if	0
 string
 BGPPeer::str() const
@@ -2096,6 +2273,7 @@ BGPPeer::set_state(FSMState s, bool restart, bool automatic)
 	if (previous_state == STATEESTABLISHED) {
 	    // We'll have an active peerhandler, so we need to inactivate it.
 	    XLOG_ASSERT(0 != _handler);
+	    leave_update_group();
 	    _handler->stop();
 	}
 	break;
@@ -2607,6 +2785,7 @@ AcceptSession::get_message_accept(BGPPacket::Status status,
 
     const uint8_t* marker = buf + BGPPacket::MARKER_OFFSET;
     uint8_t type = extract_8(buf + BGPPacket::TYPE_OFFSET);
+
     try {
 	/*
 	** Check the Marker, total waste of time as it never contains
@@ -2655,7 +2834,8 @@ AcceptSession::get_message_accept(BGPPacket::Status status,
 // 	    _in_updates++;
 // 	    main()->eventloop().current_time(_in_update_time);
 	    UpdatePacket pac(buf, length, _peer.peerdata(), 
-			     _peer.main(), /*do checks*/true);
+			     _peer.main(), /*do checks*/true,
+			     /*in place*/true);
 
  	    PROFILE(XLOG_TRACE(main()->profile().enabled(trace_message_in),
 			       "Peer %s: Receive: %s",
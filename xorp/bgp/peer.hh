@@ -27,6 +27,10 @@
 #include "socket.hh"
 #include "local_data.hh"
 #include "peer_data.hh"
+#include "update_decoder.hh"
+
+class UpdateGroup;
+class EncodedUpdate;
 
 enum FSMState {
     STATEIDLE = 1,
@@ -221,6 +225,19 @@ public:
     PeerOutputState send_message(const BGPPacket& p);
     void send_message_complete(SocketClient::Event, const uint8_t *buf);
 
+    /**
+     * Send an UPDATE message of the update group this peer follows.
+     *
+     * @param p the message.
+     * @param wire the message encoded for the group.
+     * @return the state of the output queue.
+     */
+    virtual PeerOutputState send_shared_update(const UpdatePacket& p,
+					       ref_ptr<EncodedUpdate> wire);
+    void send_shared_update_complete(SocketClient::Event, const uint8_t *buf,
+				     ref_ptr<EncodedUpdate> wire);
+    void output_queue_drained();
+
     string str() const			{ return _peername; }
     bool is_connected() const		{ return _SocketClient->is_connected(); }
     bool still_reading() const		{ return _SocketClient->still_reading(); }
@@ -236,6 +253,12 @@ public:
 	return _localdata->use_4byte_asnums(); 
     }
 
+    /**
+     * The update group, while established.
+     */
+    UpdateGroup* update_group() const	{ return _update_group; }
+    void set_update_group(UpdateGroup* group)	{ _update_group = group; }
+
     /**
      * send the netreachability message, return send result.
      */
@@ -292,6 +315,7 @@ private:
     BGPPeerData* _peerdata;
     BGPMain* _mainprocess;
     PeerHandler *_handler;
+    UpdateGroup *_update_group;	// The update group, while established.
     list<AcceptSession *> _accept_attempt;
     string _peername;
 
@@ -328,6 +352,11 @@ private:
 
     bool release_resources();
 
+    /**
+     * Leave the update group, if in one.
+     */
+    void leave_update_group();
+
     /**
      * move to the desired state, plus does some additional
      * work to clean up existing state and possibly retrying to
@@ -350,6 +379,26 @@ private:
      * tracking peer damp oscillations.
      */
     void automatic_restart();
+
+    /**
+     * The UPDATE messages received while there are decoder threads,
+     * waiting to be decoded or processed.
+     */
+    UpdateDecodeQueue _decode_queue;
+
+    /**
+     * Stop reading when this many messages are queued, start again
+     * when there are DECODE_QUEUE_LOW left.
+     */
+    static const size_t DECODE_QUEUE_HIGH = 256;
+    static const size_t DECODE_QUEUE_LOW = 64;
+
+    /**
+     * Process, in order, the messages at the front of the decode queue
+     * that have been decoded.
+     */
+    void deliver_decoded_updates();
+    void process_decoded_update(DecodedUpdate& du);
     
 private:
     friend class BGPMain;
@@ -105,6 +105,48 @@ PeerHandler::peering_came_up()
     _plumbing_multicast->peering_came_up(this);
 }
 
+/*
+** The IPv4 unicast NLRI and withdrawn routes are either in the lists
+** of the packet or, if it was decoded in place, in the message.
+*/
+template <class I>
+void
+PeerHandler::add_unicast(const UpdatePacket *p, I ni4, I end, size_t count,
+			 FPAList4Ref& pa_list)
+{
+    while (ni4 != end) {
+	if (!ni4->net().is_unicast()) {
+	    XLOG_ERROR("NLRI <%s> is not semantically correct ignoring.%s",
+		       cstring(ni4->net()), cstring(*p));
+	    ++ni4;
+	    continue;
+	}
+	PolicyTags policy_tags;
+	FPAList4Ref fpalist;
+	if (count == 1) {
+	    // no need to copy if there's only one
+	    fpalist = pa_list;
+	} else {
+	    // need to copy the others, or each one's changes will affect the rest
+	    fpalist = new FastPathAttributeList<IPv4>(*pa_list);
+	}
+	XLOG_ASSERT(!fpalist->is_locked());
+	_plumbing_unicast->add_route(ni4->net(), fpalist, 
+				     policy_tags, this);
+	++ni4;
+    }
+}
+
+template <class I>
+void
+PeerHandler::withdraw_unicast(I wi, I end)
+{
+    while (wi != end) {
+	_plumbing_unicast->delete_route(wi->net(), this);
+	++wi;
+    }
+}
+
 template <>
 bool
 PeerHandler::add<IPv4>(const UpdatePacket *p,
@@ -116,35 +158,17 @@ PeerHandler::add<IPv4>(const UpdatePacket *p,
     XLOG_ASSERT(!pa_list->is_locked());
     switch(safi) {
     case SAFI_UNICAST: {
-	if (p->nlri_list().empty())
+	if (p->nlri_count() == 0)
 	    return false;
 
 	XLOG_ASSERT(pa_list->complete());
 
-	BGPUpdateAttribList::const_iterator ni4;
-	ni4 = p->nlri_list().begin();
-	int count = p->nlri_list().size();
-	while (ni4 != p->nlri_list().end()) {
-	    if (!ni4->net().is_unicast()) {
-		XLOG_ERROR("NLRI <%s> is not semantically correct ignoring.%s",
-			   cstring(ni4->net()), cstring(*p));
-		++ni4;
-		continue;
-	    }
-	    PolicyTags policy_tags;
-	    FPAList4Ref fpalist;
-	    if (count == 1) {
-		// no need to copy if there's only one
-		fpalist = pa_list;
-	    } else {
-		// need to copy the others, or each one's changes will affect the rest
-		fpalist = new FastPathAttributeList<IPv4>(*pa_list);
-	    }
-	    XLOG_ASSERT(!fpalist->is_locked());
-	    _plumbing_unicast->add_route(ni4->net(), fpalist, 
-					 policy_tags, this);
-	    ++ni4;
-	}
+	if (p->in_place())
+	    add_unicast(p, p->nlri_wire().begin(), p->nlri_wire().end(),
+			p->nlri_count(), pa_list);
+	else
+	    add_unicast(p, p->nlri_list().begin(), p->nlri_list().end(),
+			p->nlri_count(), pa_list);
     }
 	break;
     case SAFI_MULTICAST: {
@@ -287,14 +311,14 @@ PeerHandler::withdraw<IPv4>(const UpdatePacket *p,
 {
     switch(safi) {
     case SAFI_UNICAST: {
-	if (p->wr_list().empty())
-	    return false;
-
-	BGPUpdateAttribList::const_iterator wi;
-	wi = p->wr_list().begin();
-	while (wi != p->wr_list().end()) {
-	    _plumbing_unicast->delete_route(wi->net(), this);
-	    ++wi;
+	if (p->in_place()) {
+	    if (p->wr_wire().empty())
+		return false;
+	    withdraw_unicast(p->wr_wire().begin(), p->wr_wire().end());
+	} else {
+	    if (p->wr_list().empty())
+		return false;
+	    withdraw_unicast(p->wr_list().begin(), p->wr_list().end());
 	}
     }
 	break;
@@ -358,7 +382,17 @@ PeerHandler::process_update_packet(UpdatePacket *p)
     // It's safe to mess with the ASPath in place, as we won't need
     // the original after this.
     ASPath* as_path = 0;
+    bool as4_path_merged = false;
+
+    // The attributes are copied with copy_path_attribute(), which
+    // shares those received in canonical form rather than copying
+    // them.  The multiprotocol lists are only used when there is an
+    // MP_REACH_NLRI.
+    bool mp_reach = false;
     if (!pa_list->is_empty()) {
+	if (pa_list->find_attribute_by_type(MP_REACH_NLRI))
+	    mp_reach = true;
+
 	if (pa_list->aspath_att())
 	    as_path = const_cast<ASPath*>(&(pa_list->aspath()));
 
@@ -384,6 +418,7 @@ PeerHandler::process_update_packet(UpdatePacket *p)
 			    (const AS4PathAttribute*)(pa_list->as4path_att());
 			XLOG_ASSERT(as_path);
 			as_path->merge_as4_path(as4attr->as4_path());
+			as4_path_merged = true;
 
 			/* don't store the AS4path in the PA list */
 			continue;
@@ -457,16 +492,19 @@ PeerHandler::process_update_packet(UpdatePacket *p)
 		    {}
 		} /* end of switch */
 
-		pa_ipv4_unicast->add_path_attribute(*pa);
+		pa_ipv4_unicast->copy_path_attribute(*pa_list, (PathAttType)i);
 
 		/*
 		** The nexthop path attribute applies only to IPv4 Unicast case.
 		*/
-		if (NEXT_HOP != pa->type()) {
-		    pa_ipv4_multicast->add_path_attribute(*pa);
+		if (NEXT_HOP != pa->type() && mp_reach) {
+		    pa_ipv4_multicast->copy_path_attribute(*pa_list,
+							   (PathAttType)i);
 #ifdef HAVE_IPV6
-		    pa_ipv6_unicast->add_path_attribute(*pa);
-		    pa_ipv6_multicast->add_path_attribute(*pa);
+		    pa_ipv6_unicast->copy_path_attribute(*pa_list,
+							 (PathAttType)i);
+		    pa_ipv6_multicast->copy_path_attribute(*pa_list,
+							   (PathAttType)i);
 #endif
 		}
 	    } /* end of if */
@@ -474,7 +512,7 @@ PeerHandler::process_update_packet(UpdatePacket *p)
     } /* end of if pa_list */
 
     /* finally store the ASPath attribute, now we know we're done messing with it */
-    if (as_path) {
+    if (as_path && as4_path_merged) {
 	ASPathAttribute as_path_attr(*as_path);
 	pa_ipv4_unicast->add_path_attribute(as_path_attr);
 	pa_ipv4_multicast->add_path_attribute(as_path_attr);
@@ -482,6 +520,15 @@ PeerHandler::process_update_packet(UpdatePacket *p)
 	pa_ipv6_unicast->add_path_attribute(as_path_attr);
 	pa_ipv6_multicast->add_path_attribute(as_path_attr);
 #endif
+    } else if (as_path) {
+	pa_ipv4_unicast->copy_path_attribute(*pa_list, AS_PATH);
+	if (mp_reach) {
+	    pa_ipv4_multicast->copy_path_attribute(*pa_list, AS_PATH);
+#ifdef HAVE_IPV6
+	    pa_ipv6_unicast->copy_path_attribute(*pa_list, AS_PATH);
+	    pa_ipv6_multicast->copy_path_attribute(*pa_list, AS_PATH);
+#endif
+	}
     }
 
 
@@ -718,12 +765,18 @@ PeerHandler::push_packet()
     debug_msg("Mean packet has %f nlri's\n", ((float)_nlri_total)/_packets);
 
     PeerOutputState result;
-    result = _peer->send_update_message(*_packet);
+    result = send_update(*_packet);
     delete _packet;
     _packet = NULL;
     return result;
 }
 
+PeerOutputState
+PeerHandler::send_update(const UpdatePacket& p)
+{
+    return _peer->send_update_message(p);
+}
+
 void
 PeerHandler::output_no_longer_busy()
 {
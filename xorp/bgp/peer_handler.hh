@@ -107,6 +107,15 @@ public:
     virtual PeerOutputState push_packet();
     virtual void output_no_longer_busy();
 
+    /**
+     * Called by the RibOut before add_route, replace_route or
+     * delete_route with the peers the old and the new route came
+     * from, either of which may be NULL.  Only the handler of an
+     * update group needs them.
+     */
+    virtual void set_origin_peers(const PeerHandler* /* old_origin */,
+				  const PeerHandler* /* new_origin */) {}
+
     /**
      * The AS number of this router.
      */
@@ -197,6 +206,15 @@ public:
 
     virtual EventLoop& eventloop() const;
 
+    /**
+     * @return true if this handler sends the routes of an update
+     * group to its members, rather than to a peer of its own.
+     */
+    virtual bool update_group_handler() const { return false; }
+
+    BGPPlumbing* plumbing_unicast() const	{ return _plumbing_unicast; }
+    BGPPlumbing* plumbing_multicast() const	{ return _plumbing_multicast; }
+
 
 #ifdef HAVE_IPV6
 
@@ -227,9 +245,27 @@ public:
 #endif //ipv6
 
 protected:
+    /**
+     * Send an UPDATE message built by push_packet.
+     *
+     * @return the state of the output queue.
+     */
+    virtual PeerOutputState send_update(const UpdatePacket& p);
+
+    /**
+     * Change the peer the data of the peering is taken from.
+     */
+    void set_peer(BGPPeer *peer)		{ _peer = peer; }
+
     BGPPlumbing *_plumbing_unicast;
     BGPPlumbing *_plumbing_multicast;
 private:
+    template <class I>
+    void add_unicast(const UpdatePacket *p, I first, I last, size_t count,
+		     ref_ptr<FastPathAttributeList<IPv4> >& pa_list);
+    template <class I>
+    void withdraw_unicast(I first, I last);
+
     string _peername;
     BGPPeer *_peer;
     bool _peering_is_up; /*whether we still think it's up (it may be
@@ -126,6 +126,74 @@ BGPPlumbing::delete_peering(PeerHandler* peer_handler)
     return result;
 }
 
+int
+BGPPlumbing::add_group(PeerHandler* group_handler)
+{
+    int result = 0;
+    result |= plumbing_ipv4().add_group(group_handler);
+#ifdef HAVE_IPV6
+    result |= plumbing_ipv6().add_group(group_handler);
+#endif
+    return result;
+}
+
+int
+BGPPlumbing::delete_group(PeerHandler* group_handler)
+{
+    int result = 0;
+    result |= plumbing_ipv4().delete_group(group_handler);
+#ifdef HAVE_IPV6
+    result |= plumbing_ipv6().delete_group(group_handler);
+#endif
+    return result;
+}
+
+bool
+BGPPlumbing::output_idle(PeerHandler* peer_handler)
+{
+    return plumbing_ipv4().output_idle(peer_handler)
+#ifdef HAVE_IPV6
+	&& plumbing_ipv6().output_idle(peer_handler)
+#endif
+	;
+}
+
+int
+BGPPlumbing::join_group(PeerHandler* peer_handler,
+			PeerHandler* group_handler)
+{
+    int result = 0;
+    result |= plumbing_ipv4().join_group(peer_handler, group_handler);
+#ifdef HAVE_IPV6
+    result |= plumbing_ipv6().join_group(peer_handler, group_handler);
+#endif
+    return result;
+}
+
+int
+BGPPlumbing::leave_group(PeerHandler* peer_handler,
+			 PeerHandler* group_handler)
+{
+    int result = 0;
+    result |= plumbing_ipv4().leave_group(peer_handler, group_handler);
+#ifdef HAVE_IPV6
+    result |= plumbing_ipv6().leave_group(peer_handler, group_handler);
+#endif
+    return result;
+}
+
+bool
+BGPPlumbing::directly_connected(const PeerHandler* peer_handler) const
+{
+    return const_cast<BGPPlumbing *>(this)->
+	plumbing_ipv4().directly_connected(peer_handler)
+#ifdef HAVE_IPV6
+	|| const_cast<BGPPlumbing *>(this)->
+	plumbing_ipv6().directly_connected(peer_handler)
+#endif
+	;
+}
+
 void
 BGPPlumbing::flush(PeerHandler* peer_handler) 
 {
@@ -144,8 +212,7 @@ BGPPlumbing::add_route(const IPv4Net& net,
 {
     debug_msg("BGPPlumbing::add_route IPv4\n");
     PROFILE(if (main().profile().enabled(profile_route_ribin))
-		main().profile().log(profile_route_ribin,
-				     c_format("add %s", net.str().c_str())));
+		main().profile().log_net(profile_route_ribin, "add", net));
 
     XLOG_ASSERT(!pa_list->is_locked());
     return plumbing_ipv4().add_route(net, pa_list, policy_tags, peer_handler);
@@ -156,8 +223,8 @@ BGPPlumbing::delete_route(InternalMessage<IPv4> &rtmsg,
 			  PeerHandler* peer_handler) 
 {
     PROFILE(if (main().profile().enabled(profile_route_ribin))
-		main().profile().log(profile_route_ribin,
-				     c_format("delete %s", rtmsg.net().str().c_str())));
+		main().profile().log_net(profile_route_ribin,
+					 "delete", rtmsg.net()));
 
     return plumbing_ipv4().delete_route(rtmsg, peer_handler);
 }
@@ -167,8 +234,7 @@ BGPPlumbing::delete_route(const IPNet<IPv4>& net,
 			  PeerHandler* peer_handler) 
 {
     PROFILE(if (main().profile().enabled(profile_route_ribin))
-		main().profile().log(profile_route_ribin,
-				     c_format("delete %s", net.str().c_str())));
+		main().profile().log_net(profile_route_ribin, "delete", net));
 
     return plumbing_ipv4().delete_route(net, peer_handler);
 }
@@ -242,10 +308,10 @@ BGPPlumbing::status(string& reason) const
 }
 
 void
-BGPPlumbing::push_routes() {
-    plumbing_ipv4().push_routes();
+BGPPlumbing::push_routes(const FilterChanges* changes) {
+    plumbing_ipv4().push_routes(changes);
 #ifdef HAVE_IPV6
-    plumbing_ipv6().push_routes();
+    plumbing_ipv6().push_routes(changes);
 #endif
 }
 
@@ -723,6 +789,48 @@ BGPPlumbingAF<A>::add_peering(PeerHandler* peer_handler)
     /*
      * Plumb the output branch
      */
+    FilterTable<A>* filter_out = plumb_output_branch(peer_handler);
+
+    /*
+     * Start things up on the output branch
+     */
+
+    /* 1. configure filters */
+    configure_outbound_filter(peer_handler, filter_out);
+
+    /* 2. load up damping filters */
+    /* TBD */
+
+    /* 3. finally plumb in the output branch */
+    _fanout_table->add_next_table(filter_out, peer_handler, rib_in->genid());
+
+    /* 4. cause the routing table to be dumped to the new peer */
+    dump_entire_table(filter_out, _ribname);
+    if (_awaits_push)
+	push(peer_handler);
+
+    return 0;
+}
+
+template <class A>
+FilterTable<A>*
+BGPPlumbingAF<A>::plumb_output_branch(PeerHandler* peer_handler)
+{
+    /*
+     *   FanoutTable -> FilterTable -> PolicyTableExport ->..
+     *        ..-> RibOutTable -> PeerHandler.
+     *
+     * The branch is not plumbed into the fanout table yet.
+     */
+
+    string peername(peer_handler->peername());
+
+    A self_addr;
+    try {
+	self_addr = A(peer_handler->get_local_addr().c_str()); 
+    } catch (...) {
+    }
+
     FilterTable<A>* filter_out =
 	new FilterTable<A>(_ribname + "PeerOutputFilter" + peername,
 			   _master.safi(),
@@ -763,25 +871,7 @@ BGPPlumbingAF<A>::add_peering(PeerHandler* peer_handler)
     _tables.insert(policy_filter_out);
     _tables.insert(rib_out);
 
-    /*
-     * Start things up on the output branch
-     */
-
-    /* 1. configure filters */
-    configure_outbound_filter(peer_handler, filter_out);
-
-    /* 2. load up damping filters */
-    /* TBD */
-
-    /* 3. finally plumb in the output branch */
-    _fanout_table->add_next_table(filter_out, peer_handler, rib_in->genid());
-
-    /* 4. cause the routing table to be dumped to the new peer */
-    dump_entire_table(filter_out, _ribname);
-    if (_awaits_push)
-	push(peer_handler);
-
-    return 0;
+    return filter_out;
 }
 
 template <class A>
@@ -984,6 +1074,120 @@ BGPPlumbingAF<A>::delete_peering(PeerHandler* peer_handler)
     return 0;
 }
 
+template <class A>
+int
+BGPPlumbingAF<A>::add_group(PeerHandler* group_handler)
+{
+    /*
+     * An update group only has an output branch.  Nothing is dumped
+     * to it: a peer only moves onto the branch of its group once it
+     * has been sent all that was queued for it.
+     */
+    FilterTable<A>* filter_out = plumb_output_branch(group_handler);
+    configure_outbound_filter(group_handler, filter_out);
+    _fanout_table->add_next_table(filter_out, group_handler, GENID_UNKNOWN);
+
+    return 0;
+}
+
+template <class A>
+int
+BGPPlumbingAF<A>::delete_group(PeerHandler* group_handler)
+{
+    typename map <PeerHandler*, RibOutTable<A>*>::iterator iter;
+    iter = _out_map.find(group_handler);
+    if (iter == _out_map.end())
+	XLOG_FATAL("BGPPlumbingAF<A>::delete_group: group %p not found",
+		   group_handler);
+    RibOutTable<A> *rib_out = iter->second;
+    _out_map.erase(iter);
+    _reverse_out_map.erase(rib_out);
+
+    BGPRouteTable<A> *rt, *parent;
+    rt = rib_out;
+    while (rt->parent() != _fanout_table)
+	rt = rt->parent();
+    rt->set_parent(NULL);
+    _fanout_table->remove_next_table(rt);
+
+    rt = rib_out;
+    while (rt != NULL) {
+	parent = rt->parent();
+	_tables.erase(rt);
+	delete rt;
+	rt = parent;
+    }
+    return 0;
+}
+
+template <class A>
+bool
+BGPPlumbingAF<A>::output_idle(PeerHandler* peer_handler)
+{
+    RibOutTable<A> *rib_out = rib_out_table(peer_handler);
+    XLOG_ASSERT(rib_out != NULL);
+    if (!rib_out->queue_empty())
+	return false;
+
+    BGPRouteTable<A> *rt = rib_out;
+    while (rt->parent() != _fanout_table) {
+	rt = rt->parent();
+	// Either not plumbed in or still being sent the dump.
+	if (rt == NULL || rt->type() == DUMP_TABLE)
+	    return false;
+    }
+
+    return !_fanout_table->has_queued_data(rt);
+}
+
+template <class A>
+int
+BGPPlumbingAF<A>::join_group(PeerHandler* peer_handler,
+			     PeerHandler* group_handler)
+{
+    XLOG_ASSERT(output_idle(peer_handler));
+    XLOG_ASSERT(output_idle(group_handler));
+
+    // The group now sends the peer what its own branch would have.
+    return stop_peering(peer_handler);
+}
+
+template <class A>
+int
+BGPPlumbingAF<A>::leave_group(PeerHandler* peer_handler,
+			      PeerHandler* group_handler)
+{
+    // Send the member what the group was given before it leaves.
+    RibOutTable<A> *group_out = rib_out_table(group_handler);
+    XLOG_ASSERT(group_out != NULL);
+    group_out->flush();
+
+    BGPRouteTable<A> *group_top = group_out;
+    while (group_top->parent() != _fanout_table) {
+	group_top = group_top->parent();
+	XLOG_ASSERT(group_top != NULL);
+    }
+
+    RibInTable<A> *rib_in = rib_in_table(peer_handler);
+    XLOG_ASSERT(rib_in != NULL);
+
+    // Plumb the output branch of the member back into the fanout
+    // table, as peering_came_up does, but where the group is in the
+    // queue rather than with a route dump.
+    BGPRouteTable<A> *rt = rib_out_table(peer_handler);
+    XLOG_ASSERT(rt != NULL);
+    while (rt->parent() != NULL)
+	rt = rt->parent();
+    FilterTable<A> *filter_out = dynamic_cast<FilterTable<A> *>(rt);
+    XLOG_ASSERT(filter_out != NULL);
+
+    filter_out->set_parent(_fanout_table);
+    _fanout_table->add_next_table(filter_out, peer_handler, rib_in->genid());
+    _fanout_table->copy_queue_position(filter_out, group_top);
+
+    return 0;
+}
+
 template <class A>
 void
 BGPPlumbingAF<A>::dump_entire_table(FilterTable<A> *filter_out, string ribname)
@@ -1211,6 +1415,30 @@ that has no associated RibIn");
     return iter->second->route_count();
 }
 
+template <class A>
+RibInTable<A>*
+BGPPlumbingAF<A>::rib_in_table(PeerHandler* peer_handler) const
+{
+    typename map <PeerHandler*, RibInTable<A>* >::const_iterator iter;
+    iter = _in_map.find(peer_handler);
+    if (iter == _in_map.end())
+	return NULL;
+
+    return iter->second;
+}
+
+template <class A>
+RibOutTable<A>*
+BGPPlumbingAF<A>::rib_out_table(PeerHandler* peer_handler) const
+{
+    typename map <PeerHandler*, RibOutTable<A>* >::const_iterator iter;
+    iter = _out_map.find(peer_handler);
+    if (iter == _out_map.end())
+	return NULL;
+
+    return iter->second;
+}
+
 template <>
 const IPv4& 
 BGPPlumbingAF<IPv4>::get_local_nexthop(const PeerHandler *peerhandler) const 
@@ -1218,6 +1446,45 @@ BGPPlumbingAF<IPv4>::get_local_nexthop(const PeerHandler *peerhandler) const
     return peerhandler->my_v4_nexthop();
 }
 
+/**
+ * Add the networks of the changes made to the sets a variable holding the
+ * network of a route is matched against.
+ *
+ * @param changed the networks of the changes, by variable.
+ * @param var the variable holding the network of a route.
+ * @param nets the networks are added to this, if not NULL.
+ * @return false if the changes are to sets matched against other
+ * variables.
+ */
+template <class N>
+static bool
+changed_nets_of(const map<VarRW::Id, set<N> >& changed, VarRW::Id var,
+		set<N>* nets)
+{
+    typename map<VarRW::Id, set<N> >::const_iterator i;
+    for (i = changed.begin(); i != changed.end(); ++i) {
+	if (i->first != var)
+	    return false;
+
+	if (nets != NULL)
+	    nets->insert(i->second.begin(), i->second.end());
+    }
+
+    return true;
+}
+
+template <>
+bool
+BGPPlumbingAF<IPv4>::changed_nets(const FilterChanges& changes,
+				  set<IPNet<IPv4> >& nets) const
+{
+    // The IPv6 network of an IPv4 route is not set.
+    return changed_nets_of(changes.nets4(), BGPVarRW<IPv4>::VAR_NETWORK4,
+			   &nets)
+	&& changed_nets_of(changes.nets6(), BGPVarRW<IPv4>::VAR_NETWORK6,
+			   static_cast<set<IPv6Net>*>(NULL));
+}
+
 template <>
 bool
 BGPPlumbingAF<IPv4>::directly_connected(const PeerHandler *peer_handler,
@@ -1249,6 +1516,15 @@ BGPPlumbingAF<IPv4>::directly_connected(const PeerHandler *peer_handler,
     return false;
 }
 
+template <class A>
+bool
+BGPPlumbingAF<A>::directly_connected(const PeerHandler *peer_handler) const
+{
+    IPNet<A> subnet;
+    A peer;
+    return directly_connected(peer_handler, subnet, peer);
+}
+
 template <class A>
 list <RibInTable<A>*>
 BGPPlumbingAF<A>::ribin_list() const 
@@ -1309,12 +1585,22 @@ BGPPlumbingAF<A>::status(string&) const
 
 template <class A>
 void
-BGPPlumbingAF<A>::push_routes() {
+BGPPlumbingAF<A>::push_routes(const FilterChanges* changes) {
+    set<IPNet<A> > nets;
+    bool restricted = changes != NULL && !changes->all()
+	&& changed_nets(*changes, nets);
+
+    if (restricted && nets.empty()) {
+	debug_msg("No route of this family affected by the policy changes\n");
+	return;
+    }
+
     list<const PeerTableInfo<A>*> peer_list;
 
     _fanout_table->peer_table_info(peer_list);
 
-    _policy_sourcematch_table->push_routes(peer_list);
+    _policy_sourcematch_table->push_routes(peer_list,
+					   restricted ? &nets : NULL);
 
     /*
     ** It is possible that another peer was in the middle of going
@@ -1355,8 +1641,7 @@ BGPPlumbing::add_route(const IPv6Net& net,
 {
     debug_msg("BGPPlumbing::add_route IPv6\n");
     PROFILE(if (main().profile().enabled(profile_route_ribin))
-		main().profile().log(profile_route_ribin,
-				     c_format("add %s", net.str().c_str())));
+		main().profile().log_net(profile_route_ribin, "add", net));
 
     XLOG_ASSERT(!pa_list->is_locked());
     return plumbing_ipv6().add_route(net, pa_list, policy_tags, peer_handler);
@@ -1368,8 +1653,8 @@ BGPPlumbing::delete_route(InternalMessage<IPv6> &rtmsg,
 			  PeerHandler* peer_handler) 
 {
     PROFILE(if (main().profile().enabled(profile_route_ribin))
-		main().profile().log(profile_route_ribin,
-				     c_format("delete %s", rtmsg.net().str().c_str())));
+		main().profile().log_net(profile_route_ribin,
+					 "delete", rtmsg.net()));
 
     return plumbing_ipv6().delete_route(rtmsg, peer_handler);
 }
@@ -1379,8 +1664,7 @@ BGPPlumbing::delete_route(const IPNet<IPv6>& net,
 			  PeerHandler* peer_handler) 
 {
     PROFILE(if (main().profile().enabled(profile_route_ribin))
-		main().profile().log(profile_route_ribin,
-				     c_format("delete %s", net.str().c_str())));
+		main().profile().log_net(profile_route_ribin, "delete", net));
     return plumbing_ipv6().delete_route(net, peer_handler);
 }
 
@@ -1422,6 +1706,18 @@ BGPPlumbingAF<IPv6>::get_local_nexthop(const PeerHandler *peerhandler) const
     return peerhandler->my_v6_nexthop();
 }
 
+template <>
+bool
+BGPPlumbingAF<IPv6>::changed_nets(const FilterChanges& changes,
+				  set<IPNet<IPv6> >& nets) const
+{
+    // The IPv4 network of an IPv6 route is not set.
+    return changed_nets_of(changes.nets6(), BGPVarRW<IPv6>::VAR_NETWORK6,
+			   &nets)
+	&& changed_nets_of(changes.nets4(), BGPVarRW<IPv6>::VAR_NETWORK4,
+			   static_cast<set<IPv4Net>*>(NULL));
+}
+
 template <>
 bool
 BGPPlumbingAF<IPv6>::directly_connected(const PeerHandler *peer_handler,
@@ -63,6 +63,40 @@ public:
     int peering_came_up(PeerHandler* peer_handler);
     int delete_peering(PeerHandler* peer_handler);
 
+    /**
+     * Plumb the output branch of an update group.
+     */
+    int add_group(PeerHandler* group_handler);
+
+    /**
+     * Tear down the output branch of an update group.
+     */
+    int delete_group(PeerHandler* group_handler);
+
+    /**
+     * @return true if the output branch of a peer or group is plumbed
+     * in, with nothing left to send.
+     */
+    bool output_idle(PeerHandler* peer_handler);
+
+    /**
+     * Unplumb the output branch of an idle peer, whose routes are now
+     * sent by an idle update group.
+     */
+    int join_group(PeerHandler* peer_handler, PeerHandler* group_handler);
+
+    /**
+     * Plumb the output branch of a member of an update group back in,
+     * to be sent what the group has still to send.
+     */
+    int leave_group(PeerHandler* peer_handler, PeerHandler* group_handler);
+
+    /**
+     * @return true if the peer is on a subnet of this family this
+     * router is on.
+     */
+    bool directly_connected(const PeerHandler *peer_handler) const;
+
     void flush(PeerHandler* peer_handler);
     int add_route(const IPNet<A>& net, 
 		  FPAListRef& pa_list,
@@ -82,6 +116,16 @@ public:
      */
     uint32_t get_prefix_count(PeerHandler* peer_handler) const;
 
+    /**
+     * @return the RibIn of a peering, or NULL if there is none.
+     */
+    RibInTable<A>* rib_in_table(PeerHandler* peer_handler) const;
+
+    /**
+     * @return the RibOut of a peering, or NULL if there is none.
+     */
+    RibOutTable<A>* rib_out_table(PeerHandler* peer_handler) const;
+
     /**
      * Hook to the next hop resolver so that xrl calls from the RIB
      * can be passed through.
@@ -105,8 +149,11 @@ public:
 
     /**
      * Push routes through policy filters for re-filtering.
+     *
+     * @param changes if not NULL, only the routes the changes may affect
+     * are pushed.
      */
-    void push_routes();
+    void push_routes(const FilterChanges* changes);
 
 private:
     /**
@@ -114,6 +161,11 @@ private:
      */
     void dump_entire_table(FilterTable<A> *filter_out, string ribname);
 
+    /**
+     * Create the output branch of a peer or update group.
+     */
+    FilterTable<A>* plumb_output_branch(PeerHandler* peer_handler);
+
     void configure_inbound_filter(PeerHandler* peer_handler,
 				  FilterTable<A>* filter_in);
     void configure_outbound_filter(PeerHandler* peer_handler,
@@ -122,6 +174,15 @@ private:
 
     const A& get_local_nexthop(const PeerHandler *peer_handler) const;
 
+    /**
+     * Find the networks of this family the routes the policy changes may
+     * affect overlap.
+     *
+     * @return false if the changes may affect routes in another way.
+     */
+    bool changed_nets(const FilterChanges& changes,
+		      set<IPNet<A> >& nets) const;
+
     /**
      * Is the peer directly connected and if it is return the common
      * subnet and the peer address.
@@ -179,6 +240,20 @@ public:
     int peering_came_up(PeerHandler* peer_handler);
     int delete_peering(PeerHandler* peer_handler);
 
+    /**
+     * Update groups: see BGPPlumbingAF.
+     */
+    int add_group(PeerHandler* group_handler);
+    int delete_group(PeerHandler* group_handler);
+    bool output_idle(PeerHandler* peer_handler);
+    int join_group(PeerHandler* peer_handler, PeerHandler* group_handler);
+    int leave_group(PeerHandler* peer_handler, PeerHandler* group_handler);
+
+    /**
+     * @return true if the peer is on a subnet this router is on.
+     */
+    bool directly_connected(const PeerHandler* peer_handler) const;
+
     void flush(PeerHandler* peer_handler);
     int add_route(const IPv4Net& net, 
 		  FPAList4Ref& pa_list,
@@ -233,8 +308,11 @@ public:
     
     /**
      * Push routes through policy filters for re-filtering.
+     *
+     * @param changes if not NULL, only the routes the changes may affect
+     * are pushed.
      */
-    void push_routes();
+    void push_routes(const FilterChanges* changes = NULL);
 
     PolicyFilters& policy_filters() { return _policy_filters; }
 
@@ -353,12 +353,20 @@ RibIpcHandler::withdraw_route(const IPv4Net& nlri, const bool& unicast,
     return true;
 }
 
+/*
+** Route changes are sent to the RIB in batches, each one a
+** route_changes XRL carrying up to XRL_BATCH_ROUTES adds and deletes.
+** When no XRLs are in flight whatever is queued is sent at once, so a
+** single change is not delayed. While XRLs are in flight up to
+** XRL_WINDOW full batches are sent, and a partial batch waits for a
+** reply to send it, or for XRL_BATCH_DELAY_MS, whichever comes first.
+*/
 template<class A>
 XrlQueue<A>::XrlQueue(RibIpcHandler& rib_ipc_handler,
 		      XrlStdRouter& xrl_router, BGPMain& bgp)
     : _rib_ipc_handler(rib_ipc_handler),
       _xrl_router(xrl_router), _bgp(bgp),
-      _flying(0), _flow_controlled(false)
+      _flying(0), _batch_due(false)
 {
 }
 
@@ -378,27 +386,14 @@ XrlQueue<A>::queue_add_route(string ribname, bool ibgp, Safi safi,
     Queued q;
 
     PROFILE(if (_bgp.profile().enabled(profile_route_rpc_in))
-		_bgp.profile().log(profile_route_rpc_in,
-				   c_format("add %s", net.str().c_str())));
+		_bgp.profile().log_net(profile_route_rpc_in, "add", net));
 
     q.add = true;
-    q.ribname = ribname;
-    q.ibgp = ibgp;
-    q.safi = safi;
     q.net = net;
     q.nexthop = nexthop;
-    q.comment = 
-	c_format("add_route: ribname %s %s safi %d net %s nexthop %s",
-		 ribname.c_str(),
-		 ibgp ? "ibgp" : "ebgp",
-		 safi,
-		 net.str().c_str(),
-		 nexthop.str().c_str());
-    q.policytags = policytags;
+    q.policytags = policytags.xrl_atomlist();
 
-    _xrl_queue.push_back(q);
-
-    start();
+    queue_change(ribname, ibgp, safi, q);
 }
 
 template<class A>
@@ -409,22 +404,55 @@ XrlQueue<A>::queue_delete_route(string ribname, bool ibgp, Safi safi,
     Queued q;
 
     PROFILE(if (_bgp.profile().enabled(profile_route_rpc_in))
-		_bgp.profile().log(profile_route_rpc_in,
-				   c_format("delete %s", net.str().c_str())));
+		_bgp.profile().log_net(profile_route_rpc_in, "delete", net));
 
     q.add = false;
-    q.ribname = ribname;
-    q.ibgp = ibgp;
-    q.safi = safi;
     q.net = net;
-    q.comment = 
-	c_format("delete_route: ribname %s %s safi %d net %s",
-		 ribname.c_str(),
-		 ibgp ? "ibgp" : "ebgp",
-		 safi,
-		 net.str().c_str());
 
-    _xrl_queue.push_back(q);
+    queue_change(ribname, ibgp, safi, q);
+}
+
+/*
+** An estimate of the bytes a route change adds to an XRL: the atoms
+** of the add flag, the network, the next hop, the metric, the tag
+** count and the tags.
+*/
+template<class A>
+static inline size_t
+change_bytes(size_t tags)
+{
+    return 2 + (A::addr_bytelen() + 2) + (A::addr_bytelen() + 1) + 5 + 5
+	+ 5 * tags;
+}
+
+template<class A>
+void
+XrlQueue<A>::queue_change(const string& ribname, bool ibgp, Safi safi,
+			  const Queued& q)
+{
+    size_t bytes = change_bytes<A>(q.policytags.size());
+
+    if (_xrl_queue.empty() || _xrl_queue.back().full ||
+	_xrl_queue.back().ribname != ribname ||
+	_xrl_queue.back().ibgp != ibgp || _xrl_queue.back().safi != safi ||
+	_xrl_queue.back().bytes + bytes > XRL_BATCH_BYTES) {
+	if (!_xrl_queue.empty())
+	    _xrl_queue.back().full = true;
+	_xrl_queue.push_back(Batch());
+	Batch& b = _xrl_queue.back();
+	b.ribname = ribname;
+	b.ibgp = ibgp;
+	b.safi = safi;
+	b.bytes = 0;
+	b.full = false;
+	b.changes.reserve(XRL_BATCH_ROUTES);
+    }
+
+    Batch& b = _xrl_queue.back();
+    b.changes.push_back(q);
+    b.bytes += bytes;
+    if (b.changes.size() >= XRL_BATCH_ROUTES)
+	b.full = true;
 
     start();
 }
@@ -440,45 +468,39 @@ template<class A>
 void
 XrlQueue<A>::start()
 {
-    // If we are currently busy don't attempt to send any more XRLs.
-#if	0
-    if (busy())
-	return;
-#else
-    if (flow_controlled())
-	return;
-#endif
-
-    // Now there are no outstanding XRLs try and send as many of the queued
-    // route commands as possible as possible.
+    // Send as many batches as the window allows.
 
-    for(;;) {
+    while (_flying < XRL_WINDOW) {
 	debug_msg("queue length %u\n", XORP_UINT_CAST(_xrl_queue.size()));
 
 	if(_xrl_queue.empty()) {
 	    debug_msg("Output no longer busy\n");
-#if	0
-	    _rib_ipc_handler.output_no_longer_busy();
-#endif
+	    _batch_timer.unschedule();
+	    _batch_due = false;
 	    return;
 	}
 
-	typename deque<typename XrlQueue<A>::Queued>::const_iterator qi;
-
-	qi = _xrl_queue.begin();
-
-	XLOG_ASSERT(qi != _xrl_queue.end());
+	const Batch& b = _xrl_queue.front();
 
-	Queued q = *qi;
+	// A partial batch waits for more changes while there are
+	// replies to come, but not for longer than XRL_BATCH_DELAY_MS.
+	if (!b.full && 0 != _flying && !_batch_due) {
+	    if (!_batch_timer.scheduled())
+		_batch_timer = eventloop().
+		    new_oneoff_after_ms(XRL_BATCH_DELAY_MS,
+					callback(this,
+						 &XrlQueue::batch_timeout));
+	    return;
+	}
 
-	const char *bgp = q.ibgp ? "ibgp" : "ebgp";
-	bool sent = sendit_spec(q, bgp);
+	const char *bgp = b.ibgp ? "ibgp" : "ebgp";
+	bool sent = sendit_spec(b, bgp);
 
 	if (sent) {
 	    _flying++;
 	    _xrl_queue.pop_front();
-	    if (flow_controlled())
-		return;
+	    _batch_timer.unschedule();
+	    _batch_due = false;
  	    continue;
 	}
 	
@@ -496,15 +518,47 @@ XrlQueue<A>::start()
     }
 }
 
+template<class A>
+void
+XrlQueue<A>::batch_timeout()
+{
+    _batch_due = true;
+    start();
+}
+
+template<class A>
+void
+XrlQueue<A>::batch_lists(const Batch& b, XrlAtomList& adds,
+			 XrlAtomList& networks, XrlAtomList& nexthops,
+			 XrlAtomList& metrics, XrlAtomList& tag_counts,
+			 XrlAtomList& policytags) const
+{
+    typename vector<Queued>::const_iterator qi;
+    for (qi = b.changes.begin(); qi != b.changes.end(); ++qi) {
+	PROFILE(if (_bgp.profile().enabled(profile_route_rpc_out))
+		    _bgp.profile().log_net(profile_route_rpc_out,
+					   qi->add ? "add" : "delete",
+					   qi->net));
+
+	adds.append(XrlAtom(qi->add));
+	networks.append(XrlAtom(qi->net));
+	nexthops.append(XrlAtom(qi->nexthop));
+	metrics.append(XrlAtom(static_cast<uint32_t>(0)));
+	const XrlAtomList& tags = qi->policytags;
+	tag_counts.append(XrlAtom(static_cast<uint32_t>(tags.size())));
+	for (size_t j = 0; j < tags.size(); j++)
+	    policytags.append(tags.get(j));
+    }
+}
+
 template<>
 bool
-XrlQueue<IPv4>::sendit_spec(Queued& q, const char *bgp)
+XrlQueue<IPv4>::sendit_spec(const Batch& b, const char *bgp)
 {
-    bool sent;
     bool unicast = false;
     bool multicast = false;
 
-    switch(q.safi) {
+    switch(b.safi) {
     case SAFI_UNICAST:
 	unicast = true;
 	break;
@@ -513,41 +567,26 @@ XrlQueue<IPv4>::sendit_spec(Queued& q, const char *bgp)
 	break;
     }
 
-    XrlRibV0p1Client rib(&_xrl_router);
-    if(q.add) {
-	debug_msg("adding route from %s peer to rib\n", bgp);
-	PROFILE(if (_bgp.profile().enabled(profile_route_rpc_out))
-		    _bgp.profile().log(profile_route_rpc_out, 
-				       c_format("add %s", q.net.str().c_str())));
-
-	sent = rib.send_add_route4(q.ribname.c_str(),
-			    bgp,
-			    unicast, multicast,
-			    q.net, q.nexthop, /*metric*/0,
-			    q.policytags.xrl_atomlist(),
-			    callback(this, &XrlQueue::route_command_done,
-				     q.comment));
-// 	if (!sent)
-// 	    XLOG_WARNING("scheduling add route %s failed",
-// 			 q.net.str().c_str());
-    } else {
-	debug_msg("deleting route from %s peer to rib\n", bgp);
-	PROFILE(if (_bgp.profile().enabled(profile_route_rpc_out))
-		    _bgp.profile().log(profile_route_rpc_out, 
-				       c_format("delete %s", q.net.str().c_str())));
-	sent = rib.send_delete_route4(q.ribname.c_str(),
-				      bgp,
-				      unicast, multicast,
-				      q.net,
-				      ::callback(this,
-						 &XrlQueue::route_command_done,
-						 q.comment));
-// 	if (!sent)
-// 	    XLOG_WARNING("scheduling delete route %s failed",
-// 			 q.net.str().c_str());
-    }
+    XrlAtomList adds, networks, nexthops, metrics, tag_counts, policytags;
+    batch_lists(b, adds, networks, nexthops, metrics, tag_counts,
+		policytags);
+
+    debug_msg("sending %u route changes from %s peer to rib\n",
+	      XORP_UINT_CAST(b.changes.size()), bgp);
+    string comment =
+	c_format("route_changes4: ribname %s %s safi %d %u changes from %s",
+		 b.ribname.c_str(), bgp, b.safi,
+		 XORP_UINT_CAST(b.changes.size()),
+		 b.changes.front().net.str().c_str());
 
-    return sent;
+    XrlRibV0p1Client rib(&_xrl_router);
+    return rib.send_route_changes4(b.ribname.c_str(),
+				   bgp,
+				   unicast, multicast,
+				   adds, networks, nexthops, metrics,
+				   tag_counts, policytags,
+				   callback(this, &XrlQueue::route_command_done,
+					    comment));
 }
 
 template<class A>
@@ -741,13 +780,12 @@ RibIpcHandler::withdraw_route(const IPv6Net& nlri, const bool& unicast,
 
 template<>
 bool
-XrlQueue<IPv6>::sendit_spec(Queued& q, const char *bgp)
+XrlQueue<IPv6>::sendit_spec(const Batch& b, const char *bgp)
 {
-    bool sent;
     bool unicast = false;
     bool multicast = false;
 
-    switch(q.safi) {
+    switch(b.safi) {
     case SAFI_UNICAST:
 	unicast = true;
 	break;
@@ -756,39 +794,26 @@ XrlQueue<IPv6>::sendit_spec(Queued& q, const char *bgp)
 	break;
     }
 
-    XrlRibV0p1Client rib(&_xrl_router);
-    if(q.add) {
-	debug_msg("adding route from %s peer to rib\n", bgp);
-	PROFILE(if (_bgp.profile().enabled(profile_route_rpc_out))
-		    _bgp.profile().log(profile_route_rpc_out, 
-				       c_format("add %s", q.net.str().c_str())));
-	sent = rib.send_add_route6(q.ribname.c_str(),
-			    bgp,
-			    unicast, multicast,
-			    q.net, q.nexthop, /*metric*/0, 
-			    q.policytags.xrl_atomlist(),
-			    callback(this, &XrlQueue::route_command_done,
-				     q.comment));
-// 	if (!sent)
-// 	    XLOG_WARNING("scheduling add route %s failed",
-// 			 q.net.str().c_str());
-    } else {
-	debug_msg("deleting route from %s peer to rib\n", bgp);
-	PROFILE(if (_bgp.profile().enabled(profile_route_rpc_out))
-		    _bgp.profile().log(profile_route_rpc_out, 
-				       c_format("delete %s", q.net.str().c_str())));
-	sent = rib.send_delete_route6(q.ribname.c_str(),
-			       bgp,
-			       unicast, multicast,
-			       q.net,
-			       callback(this, &XrlQueue::route_command_done,
-					q.comment));
-// 	if (!sent)
-// 	    XLOG_WARNING("scheduling delete route %s failed",
-// 			 q.net.str().c_str());
-    }
+    XrlAtomList adds, networks, nexthops, metrics, tag_counts, policytags;
+    batch_lists(b, adds, networks, nexthops, metrics, tag_counts,
+		policytags);
+
+    debug_msg("sending %u route changes from %s peer to rib\n",
+	      XORP_UINT_CAST(b.changes.size()), bgp);
+    string comment =
+	c_format("route_changes6: ribname %s %s safi %d %u changes from %s",
+		 b.ribname.c_str(), bgp, b.safi,
+		 XORP_UINT_CAST(b.changes.size()),
+		 b.changes.front().net.str().c_str());
 
-    return sent;
+    XrlRibV0p1Client rib(&_xrl_router);
+    return rib.send_route_changes6(b.ribname.c_str(),
+				   bgp,
+				   unicast, multicast,
+				   adds, networks, nexthops, metrics,
+				   tag_counts, policytags,
+				   callback(this, &XrlQueue::route_command_done,
+					    comment));
 }
 
 template class XrlQueue<IPv6>;
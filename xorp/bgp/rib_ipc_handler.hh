@@ -50,11 +50,14 @@ public:
 
     bool busy();
 private:
-    static const size_t XRL_HIWAT = 100;	// Maximum number of XRLs
+    static const size_t XRL_BATCH_ROUTES = 256;	// Maximum number of route
+						// changes in one XRL.
+    static const size_t XRL_BATCH_BYTES = 8192;	// Maximum estimated size
+						// of the changes in one XRL.
+    static const uint32_t XRL_BATCH_DELAY_MS = 10;	// Longest a partial batch
+						// waits for more changes.
+    static const size_t XRL_WINDOW = 8;		// Maximum number of XRLs
 						// allowed in flight.
-    static const size_t XRL_LOWAT = 10;		// Low watermark for XRL
-						// in-flight flow control
-						// hysteresis.
 
     RibIpcHandler &_rib_ipc_handler;
     XrlStdRouter &_xrl_router;
@@ -62,43 +65,62 @@ private:
 
     struct Queued {
 	bool add;
+	IPNet<A> net;
+	A nexthop;
+	XrlAtomList policytags;
+    };
+
+    /*
+     * Consecutive route changes for the same RIB, peer type and SAFI,
+     * sent to the RIB in one XRL.
+     */
+    struct Batch {
 	string ribname;
 	bool ibgp;
 	Safi safi;
-	IPNet<A> net;
-	A nexthop;
-	string comment;
-	PolicyTags policytags;
+	size_t bytes;	// Estimated size of the changes in the XRL
+	bool full;	// No more changes can be added
+	vector<Queued> changes;
     };
 
-    deque <Queued> _xrl_queue;
+    deque <Batch> _xrl_queue;
     size_t _flying; //XRLs currently in flight
-    bool _flow_controlled;
+    XorpTimer _batch_timer;	// Bounds the wait of a partial batch
+    bool _batch_due;		// Send a partial batch now
 
     /**
-     * Flow control hysteresis
+     * Add a route change to the last batch, or to a new batch if it
+     * does not fit, and start sending.
      */
-    bool flow_controlled() {
-	if (_flying >= XRL_HIWAT)
-	    _flow_controlled = true;
-	else if (_flying <= XRL_LOWAT)
-	    _flow_controlled = false;
-	return _flow_controlled;
-    }
+    void queue_change(const string& ribname, bool ibgp, Safi safi,
+		      const Queued& q);
 
     /**
      * Start the transmission of XRLs to tbe RIB.
      */
     void start();
 
+    /**
+     * A partial batch has waited long enough. Send it.
+     */
+    void batch_timeout();
+
+    /**
+     * Build the arguments of a route_changes XRL from a batch.
+     */
+    void batch_lists(const Batch& b, XrlAtomList& adds,
+		     XrlAtomList& networks, XrlAtomList& nexthops,
+		     XrlAtomList& metrics, XrlAtomList& tag_counts,
+		     XrlAtomList& policytags) const;
+
     /**
      * The specialised method called by sendit to deal with IPv4/IPv6.
      *
-     * @param q the queued command.
+     * @param b the batch of route changes.
      * @param bgp "ibg"p or "ebgp".
-     * @return True if the add/delete was queued.
+     * @return True if the batch was queued.
      */
-    bool sendit_spec(Queued& q, const char *bgp);
+    bool sendit_spec(const Batch& b, const char *bgp);
 
     EventLoop& eventloop() const;
 
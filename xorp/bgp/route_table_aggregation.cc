@@ -378,7 +378,7 @@ AggregateRoute<A>::reevaluate(AggregationTable<A> *parent)
     // Add a MED attr if needed and allowed to
     if (med &&
 	!(fpa_list->aspath().num_segments() &&
-	  fpa_list->aspath().segment(0).type() == AS_SET)) {
+	  fpa_list->aspath().segment_type(0) == AS_SET)) {
 	MEDAttribute med_attr(med);
 	fpa_list->add_path_attribute(med_attr);
     }
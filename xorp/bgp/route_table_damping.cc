@@ -34,7 +34,7 @@ DampingTable<A>::DampingTable(string tablename, Safi safi,
 			      const PeerHandler *peer,
 			      Damping& damping)
     : BGPRouteTable<A>(tablename, safi), _peer(peer), _damping(damping),
-      _damp_count(0)
+      _damp_count(0), _reuse_next(0), _release_next(0)
 {
     this->_parent = parent;
 }
@@ -133,19 +133,13 @@ DampingTable<A>::replace_route(InternalMessage<A> &old_rtmsg,
 	typename RefTrie<A, DampRoute<A> >::iterator r;
 	r = _damped.lookup_node(old_rtmsg.net());
 	XLOG_ASSERT(r != _damped.end());
-	TimeVal exp;
-	if (!r.payload().timer().time_remaining(exp))
-	    XLOG_FATAL("Route is being damped but no timer is scheduled");
-	r.payload().timer().unschedule();
+	uint32_t reuse = r.payload().reuse();
 	_damped.erase(r);
+	// The network stays on its reuse list.
 	if (damping_global()) {
-		DampRoute<A> damproute(new_rtmsg.route(), new_rtmsg.genid());
-		damproute.timer() = eventloop().
-		    new_oneoff_after(exp,
-				     callback(this,
-					      &DampingTable<A>::undamp,
-					      new_rtmsg.net()));
-		_damped.insert(new_rtmsg.net(), damproute);
+	    DampRoute<A> damproute(new_rtmsg.route(), new_rtmsg.genid(),
+				   reuse);
+	    _damped.insert(new_rtmsg.net(), damproute);
 	    return ADD_UNUSED;
 	}
 	
@@ -202,8 +196,7 @@ DampingTable<A>::delete_route(InternalMessage<A> &rtmsg,
 	typename RefTrie<A, DampRoute<A> >::iterator r;
 	r = _damped.lookup_node(rtmsg.net());
 	XLOG_ASSERT(r != _damped.end());
-	r.payload().timer().unschedule();	// Not strictly necessary.
-	_damped.erase(r);
+	_damped.erase(r);	// Skipped when its reuse list is released.
 
 	damp._damped = false;
 	_damp_count--;
@@ -295,13 +288,10 @@ DampingTable<A>::update_figure_of_merit(Damp& damp,
 	debug_msg("Damped\n");
 	damp._damped = true;
 	_damp_count++;
-	DampRoute<A> damproute(rtmsg.route(), rtmsg.genid());
-	damproute.timer() = eventloop().
-	    new_oneoff_after(TimeVal(_damping.get_reuse_time(damp._merit), 0),
-			     callback(this,
-				      &DampingTable<A>::undamp,
-				      rtmsg.net()));
+	uint32_t reuse = damp._time + _damping.get_reuse_time(damp._merit);
+	DampRoute<A> damproute(rtmsg.route(), rtmsg.genid(), reuse);
 	_damped.insert(rtmsg.net(), damproute);
+	reuse_insert(rtmsg.net(), reuse);
 
 	return true;
     }
@@ -325,8 +315,113 @@ DampingTable<A>::is_this_route_damped(const IPNet<A> &net) const
 
 template<class A>
 void
-DampingTable<A>::undamp(IPNet<A> net)
+DampingTable<A>::reuse_insert(const IPNet<A>& net, uint32_t reuse)
+{
+    const uint32_t granularity = Damping::REUSE_GRANULARITY;
+
+    // The first damped route allocates the lists and starts the timer.
+    if (_reuse_lists.empty()) {
+	_reuse_lists.resize(_damping.get_reuse_lists());
+	_reuse_next = _damping.get_tick() / granularity;
+	_reuse_timer = eventloop().
+	    new_periodic_ms(granularity * 1000,
+			    callback(this, &DampingTable<A>::reuse_timeout));
+    }
+
+    // The slot that is released once the reuse time has passed, but
+    // not one that has already been released or that would wrap
+    // around onto a slot still to be released.
+    uint32_t slot = (reuse + granularity - 1) / granularity;
+    if (slot < _reuse_next)
+	slot = _reuse_next;
+    if (slot - _reuse_next >= _reuse_lists.size())
+	slot = _reuse_next + _reuse_lists.size() - 1;
+
+    _reuse_lists[slot % _reuse_lists.size()].push_back(net);
+}
+
+template<class A>
+bool
+DampingTable<A>::reuse_timeout()
+{
+    uint32_t now = _damping.get_tick();
+
+    // The lists that are due are released in the background, so the
+    // RibOuts can drain what has been released before more is.
+    while (_reuse_next * Damping::REUSE_GRANULARITY <= now) {
+	vector<IPNet<A> >& nets =
+	    _reuse_lists[_reuse_next % _reuse_lists.size()];
+	if (_releasing.empty())
+	    _releasing.swap(nets);
+	else
+	    _releasing.insert(_releasing.end(), nets.begin(), nets.end());
+	vector<IPNet<A> > empty;
+	nets.swap(empty);
+	_reuse_next++;
+    }
+
+    if (!_releasing.empty() && !_release_task.scheduled())
+	_release_task = eventloop().new_task(
+	    callback(this, &DampingTable<A>::release_next_batch),
+	    XorpTask::PRIORITY_BACKGROUND, XorpTask::WEIGHT_DEFAULT);
+
+    // Free the lists when there is nothing left to release.
+    if (0 == _damp_count && _releasing.empty()) {
+	vector<vector<IPNet<A> > > empty;
+	_reuse_lists.swap(empty);
+	return false;
+    }
+
+    return true;
+}
+
+template<class A>
+bool
+DampingTable<A>::release_next_batch()
+{
+    uint32_t now = _damping.get_tick();
+
+    // The RibOut groups what it is pushed by path attributes, which
+    // is quadratic in the size of the push.
+    uint32_t released = 0;
+    while (_release_next < _releasing.size() &&
+	   released < REUSE_PUSH_BATCH) {
+	// The route may have been deleted, or released and damped
+	// again with a later reuse time.
+	const IPNet<A>& net = _releasing[_release_next++];
+	typename RefTrie<A, DampRoute<A> >::iterator r;
+	r = _damped.lookup_node(net);
+	if (r == _damped.end())
+	    continue;
+
+	// A route inserted while the timer was running late may have
+	// been put on the last list of the ring, before its reuse time.
+	if (r.payload().reuse() > now) {
+	    reuse_insert(net, r.payload().reuse());
+	    continue;
+	}
+	undamp(r);
+	released++;
+    }
+
+    if (released > 0)
+	this->_next_table->push(static_cast<BGPRouteTable<A>*>(this));
+
+    if (_release_next < _releasing.size())
+	return true;
+
+    vector<IPNet<A> > empty;
+    _releasing.swap(empty);
+    _release_next = 0;
+
+    return false;
+}
+
+template<class A>
+void
+DampingTable<A>::undamp(typename RefTrie<A, DampRoute<A> >::iterator r)
 {
+    IPNet<A> net = r.key();
     debug_msg("Released net %s\n", cstring(net));
 
     typename Trie<A, Damp>::iterator i = _damp.lookup_node(net);
@@ -334,9 +429,6 @@ DampingTable<A>::undamp(IPNet<A> net)
     Damp& damp = i.payload();
     XLOG_ASSERT(damp._damped);
     
-    typename RefTrie<A, DampRoute<A> >::iterator r;
-    r = _damped.lookup_node(net);
-    XLOG_ASSERT(r != _damped.end());
     InternalMessage<A> rtmsg(r.payload().route(), _peer, r.payload().genid());
     _damped.erase(r);
     damp._damped = false;
@@ -344,7 +436,6 @@ DampingTable<A>::undamp(IPNet<A> net)
 
     this->_next_table->add_route(rtmsg,
 				 static_cast<BGPRouteTable<A>*>(this));
-    this->_next_table->push(static_cast<BGPRouteTable<A>*>(this));
 }
 
 template<class A>
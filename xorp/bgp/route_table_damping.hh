@@ -53,29 +53,38 @@ class Damp {
 template<class A>
 class DampRoute {
 public:
-    DampRoute(const SubnetRoute<A>* route, uint32_t genid) 
-	: _routeref(route), _genid(genid) {}
+    DampRoute(const SubnetRoute<A>* route, uint32_t genid, uint32_t reuse)
+	: _routeref(route), _genid(genid), _reuse(reuse) {}
     const SubnetRoute<A>* route() const { return _routeref.route(); }
     uint32_t genid() const { return _genid; }
-    XorpTimer& timer() { return _timer; }
+    uint32_t reuse() const { return _reuse; }
 private:
     SubnetRouteConstRef<A> _routeref;
     uint32_t _genid;
-    XorpTimer _timer;   // If this route is damped time when it should
-			// be released. 
+    uint32_t _reuse;	// The tick at which the route should be released.
 };
 
 /**
  * Manage the damping of routes.
  *
+ * Damped routes are released from the reuse lists of RFC 2439, a
+ * ring of lists each holding the networks due for release in a
+ * REUSE_GRANULARITY second slot. A single timer per table hands the
+ * lists to a background task as they fall due, instead of a timer per
+ * route. A network is not removed from its list when it stops being
+ * damped, it is skipped when its list is released.
+ *
  * NOTE: If damping was enabled and is then disabled it is possible
  * that some routes may be damped. While damped routes exist the
  * damping code is entered, no more routes are damped but routes are
- * only released as the timers fire.
+ * only released as their reuse lists fall due.
  */
 template<class A>
 class DampingTable : public BGPRouteTable<A>  {
 public:
+    static const uint32_t REUSE_PUSH_BATCH = 50;	// Routes released
+							// per task run.
+
     DampingTable(string tablename, Safi safi, BGPRouteTable<A>* parent,
 		 const PeerHandler *peer,
 		 Damping& damping);
@@ -129,9 +138,32 @@ public:
     bool is_this_route_damped(const IPNet<A> &net) const;
 
     /**
-     * Callback method called to release damped route.
+     * Schedule the release of a damped network.
+     *
+     * @param net the network.
+     * @param reuse the tick at which to release it.
+     */
+    void reuse_insert(const IPNet<A>& net, uint32_t reuse);
+
+    /**
+     * Callback method called to release the reuse lists that are due.
+     *
+     * @return true while routes are being damped.
      */
-    void undamp(IPNet<A> net);
+    bool reuse_timeout();
+
+    /**
+     * Background task that releases the routes on the reuse lists
+     * that have fallen due, a batch at a time.
+     *
+     * @return true while there are routes left to release.
+     */
+    bool release_next_batch();
+
+    /**
+     * Release a damped route.
+     */
+    void undamp(typename RefTrie<A, DampRoute<A> >::iterator r);
 
     EventLoop& eventloop() const;
 
@@ -142,6 +174,13 @@ public:
     Trie<A, Damp> _damp;
     RefTrie<A, DampRoute<A> > _damped;
     uint32_t _damp_count;	// Number of damped routes.
+
+    vector<vector<IPNet<A> > > _reuse_lists;	// Allocated while damping.
+    uint32_t _reuse_next;	// The next reuse slot to be released.
+    XorpTimer _reuse_timer;	// Releases the reuse lists.
+    vector<IPNet<A> > _releasing;	// The lists that have fallen due.
+    size_t _release_next;	// The next network in _releasing.
+    XorpTask _release_task;	// Releases the routes in _releasing.
 };
 
 #endif // __BGP_ROUTE_TABLE_DAMPING_HH__
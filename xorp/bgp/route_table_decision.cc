@@ -42,6 +42,96 @@
 #define PARANOID_ASSERT(x) {}
 #endif
 
+// Implementation Notes:
+//
+// The candidate routes to a prefix are kept in a trie, one per
+// upstream branch, in a tree sorted on local preference, AS path
+// length and origin, and indexed by branch.  These steps order all
+// the routes, so only the best ranking routes can win, and a route
+// ranking strictly below the current winner can be added or deleted
+// in O(log k) without running the decision process.  The later steps
+// (MED, EBGP, IGP distance, BGP ID) are not transitive, and are only
+// run on the best ranking routes.
+//
+// A candidate only remembers what the decision process compares.  The
+// route's attributes are looked up in its branch when the route is
+// sent downstream, which only happens when the winner changes.
+
+template<class A>
+DecisionCandidate<A>::DecisionCandidate(InternalMessage<A>& rtmsg,
+					PeerTableInfo<A>* parent)
+    : _route(rtmsg.route()), _parent(parent), _nexthop(rtmsg.nexthop())
+{
+    const FPAListRef& pa_list = rtmsg.attributes();
+
+    /*
+     * Local Pref should be present on all routes.  If the route comes
+     * from EBGP, the incoming FilterTable should have added it.  If
+     * the route comes from IBGP, it should have been present on the
+     * incoming route.  
+     */
+    const LocalPrefAttribute* localpref_att = pa_list->local_pref_att();
+    _local_pref = localpref_att ? localpref_att->localpref() : 0;
+    const MEDAttribute* med_att = pa_list->med_att();
+    _med = med_att ? med_att->med() : 0;
+
+    const ASPath& aspath = pa_list->aspath();
+    _path_length = aspath.path_length();
+    _neighbour_as = (0 == _path_length) ? 
+	AsNum(AsNum::AS_INVALID).as4() : aspath.first_asnum().as4();
+    _origin = pa_list->origin();
+}
+
+template<class A>
+const DecisionCandidate<A>&
+DecisionCandidates<A>::insert(const DecisionCandidate<A>& c)
+{
+    erase(c.parent());
+
+    typename List::iterator i = _list.insert(c);
+    _index.insert(make_pair(c.parent(), i));
+    return *i;
+}
+
+template<class A>
+bool
+DecisionCandidates<A>::erase(const PeerTableInfo<A>* parent)
+{
+    typename Index::iterator i = _index.find(parent);
+    if (i == _index.end())
+	return false;
+
+    if (_winner == i->second)
+	_winner = _list.end();
+    _list.erase(i->second);
+    _index.erase(i);
+    return true;
+}
+
+template<class A>
+const DecisionCandidate<A>*
+DecisionCandidates<A>::find(const PeerTableInfo<A>* parent) const
+{
+    typename Index::const_iterator i = _index.find(parent);
+    if (i == _index.end())
+	return NULL;
+    return &(*i->second);
+}
+
+template<class A>
+void
+DecisionCandidates<A>::set_winner(const DecisionCandidate<A>* c)
+{
+    if (c == NULL) {
+	_winner = _list.end();
+	return;
+    }
+
+    typename Index::iterator i = _index.find(c->parent());
+    XLOG_ASSERT(i != _index.end() && &(*i->second) == c);
+    _winner = i->second;
+}
+
 template<class A>
 DecisionTable<A>::DecisionTable(string table_name, 
 				Safi safi,
@@ -91,6 +181,19 @@ DecisionTable<A>::remove_parent(BGPRouteTable<A> *ex_parent) {
     i = _parents.find(ex_parent);
     PeerTableInfo<A> *pti = i->second;
     const PeerHandler* peer = pti->peer_handler();
+
+    //forget the routes from this branch
+    list<IPNet<A> > emptied;
+    typename CandidateTrie::iterator j;
+    for (j = _candidates.begin(); j != _candidates.end(); j++) {
+	DecisionCandidates<A>& candidates = j.payload();
+	if (candidates.erase(pti) && candidates.empty())
+	    emptied.push_back(j.key());
+    }
+    typename list<IPNet<A> >::const_iterator k;
+    for (k = emptied.begin(); k != emptied.end(); k++)
+	_candidates.erase(_candidates.lookup_node(*k));
+
     _parents.erase(i);
     _sorted_parents.erase(_sorted_parents.find(peer->get_unique_id()));
     delete pti;
@@ -107,6 +210,20 @@ DecisionTable<A>::add_route(InternalMessage<A> &rtmsg,
 
     debug_msg("DT:add_route %s\n", rtmsg.route()->str().c_str());
 
+    PeerTableInfo<A> *pti = parent_info(caller);
+    typename CandidateTrie::iterator iter
+	= _candidates.lookup_node(rtmsg.net());
+    if (iter == _candidates.end())
+	iter = _candidates.insert(rtmsg.net(), DecisionCandidates<A>());
+    DecisionCandidates<A>& candidates = iter.payload();
+
+    //if this route replaced an earlier winner from the same parent
+    //we'd see it as a replace, not an add
+    XLOG_ASSERT(candidates.winner() == NULL
+		|| candidates.winner()->parent() != pti);
+    const DecisionCandidate<A>& new_route
+	= candidates.insert(DecisionCandidate<A>(rtmsg, pti));
+
     //if the nexthop isn't resolvable, don't even consider the route
     debug_msg("testing resolvability\n");
     XLOG_ASSERT(rtmsg.route()->nexthop_resolved() ==
@@ -117,65 +234,47 @@ DecisionTable<A>::add_route(InternalMessage<A> &rtmsg,
     }
     debug_msg("route resolvable\n");
 
-    //find the alternative routes, and the old winner if there was one.
-    RouteData<A> *old_winner = NULL, *old_winner_clone = NULL;
-    list<RouteData<A> > alternatives;
-    old_winner = find_alternative_routes(caller, rtmsg.net(), alternatives);
-
-    debug_msg("there are %d alternatives\n", (int)alternatives.size());
-
-    //preserve old_winner because the original may be deleted by the
-    //decision process
-    if (old_winner != NULL) {
-	old_winner_clone = new RouteData<A>(*old_winner);
-    }
-    
-    RouteData<A> *new_winner = NULL;
-    RouteData<A> new_route(rtmsg.route(), rtmsg.attributes(), caller, 
-			   rtmsg.origin_peer(), rtmsg.genid());
-    if (!alternatives.empty()) {
-	//add the new route to the pool of possible winners.
-	alternatives.push_back(new_route);
-	new_winner = find_winner(alternatives);
-    } else {
-	//the new route wins by default
-	new_winner = &new_route;
+    const DecisionCandidate<A>* old_winner = candidates.winner();
+    if (old_winner != NULL && old_winner->ranks_before(new_route)) {
+	//the new route can't beat the old winner
+	debug_msg("route ranks below the winner\n");
+	return ADD_UNUSED;
     }
+
+    const DecisionCandidate<A>* new_winner = find_winner(candidates);
     XLOG_ASSERT(new_winner != NULL);
 
-    if (old_winner_clone != NULL) {
-	if (old_winner_clone->route() == new_winner->route()) {
+    if (old_winner != NULL) {
+	if (old_winner == new_winner) {
 	    //the winner didn't change.
-	    XLOG_ASSERT(old_winner_clone != NULL);
-	    delete old_winner_clone;
 	    return ADD_UNUSED;
 	}
 
 	//the winner did change, so send a delete for the old winner
-	InternalMessage<A> old_rt_msg(old_winner_clone->route(), 
-				      old_winner_clone->attributes(),
-				      old_winner_clone->peer_handler(), 
-				      old_winner_clone->genid());
+	uint32_t genid;
+	FPAListRef pa_list;
+	lookup_candidate(rtmsg.net(), *old_winner, genid, pa_list);
+	InternalMessage<A> old_rt_msg(old_winner->route(), pa_list,
+				      old_winner->peer_handler(), genid);
 	this->_next_table->delete_route(old_rt_msg, (BGPRouteTable<A>*)this);
 
 	//the old winner is no longer the winner
-	old_winner_clone->set_is_not_winner();
-
-	//clean up temporary state
-	delete old_winner_clone;
+	old_winner->set_is_not_winner();
+	candidates.set_winner(NULL);
     }
 
     //send an add for the new winner
-    new_winner->route()->set_is_winner(
-		       igp_distance(new_winner->attributes()->nexthop()));
+    new_winner->route()->set_is_winner(igp_distance(new_winner->nexthop()));
+    candidates.set_winner(new_winner);
     int result;
-    if (new_winner->route() != rtmsg.route()) {
+    if (new_winner != &new_route) {
 	//we have a new winner, but it isn't the route that was just added.
 	//this can happen due to MED wierdness.
-	InternalMessage<A> new_rt_msg(new_winner->route(), 
-				      new_winner->attributes(),
-				      new_winner->peer_handler(), 
-				      new_winner->genid());
+	uint32_t genid;
+	FPAListRef pa_list;
+	lookup_candidate(rtmsg.net(), *new_winner, genid, pa_list);
+	InternalMessage<A> new_rt_msg(new_winner->route(), pa_list,
+				      new_winner->peer_handler(), genid);
 	if (rtmsg.push())
 	    new_rt_msg.set_push();
 	result = this->_next_table->add_route(new_rt_msg, 
@@ -203,86 +302,81 @@ DecisionTable<A>::replace_route(InternalMessage<A> &old_rtmsg,
 
     debug_msg("DT:replace_route.\nOld route: %s\nNew Route: %s\n", old_rtmsg.route()->str().c_str(), new_rtmsg.route()->str().c_str());
 
-    list <RouteData<A> > alternatives;
-    RouteData<A> *old_winner, *old_winner_clone = NULL;
-    old_winner = find_alternative_routes(caller, old_rtmsg.net(),alternatives);
-    if (old_winner) {
-	//preserve this, because the original old_winner's data will
-	//be clobbered by route_wins.
-	old_winner_clone = new RouteData<A>(*old_winner);
-
-    } else if (old_rtmsg.route()->is_winner()) {
-	//the route being deleted was the old winner
-	old_winner_clone = new RouteData<A>(old_rtmsg.route(), 
-					    old_rtmsg.attributes(),
-					    caller,
-					    old_rtmsg.origin_peer(),
-					    old_rtmsg.genid());
-    }
-    
-    if (old_winner_clone == NULL) {
+    PeerTableInfo<A> *pti = parent_info(caller);
+    typename CandidateTrie::iterator iter
+	= _candidates.lookup_node(new_rtmsg.net());
+    if (iter == _candidates.end() || iter.payload().winner() == NULL) {
 	//no route was the old winner, presumably because no route was
 	//resolvable.
 	return add_route(new_rtmsg, caller);
     }
+    DecisionCandidates<A>& candidates = iter.payload();
+
+    //the route being replaced may have been the old winner
+    PeerTableInfo<A> *old_winner_parent = candidates.winner()->parent();
+    bool old_route_won = (old_winner_parent == pti);
 
-    RouteData<A> *new_winner = NULL;
-    RouteData<A> new_route(new_rtmsg.route(), new_rtmsg.attributes(),
-			   caller, new_rtmsg.origin_peer(),
-			   new_rtmsg.genid());
-    if (!alternatives.empty()) {
-	//add the new route to the pool of possible winners.
-	alternatives.push_back(new_route);
-	new_winner = find_winner(alternatives);
-    } else if (resolvable(new_rtmsg.nexthop())) {
-	//the new route wins by default if it's resolvable.
-	new_winner = &new_route;
+    const DecisionCandidate<A>& new_route
+	= candidates.insert(DecisionCandidate<A>(new_rtmsg, pti));
+    const DecisionCandidate<A>* old_winner = NULL;
+    if (!old_route_won) {
+	old_winner = candidates.find(old_winner_parent);
+	if (old_winner->ranks_before(new_route)) {
+	    //No change.
+	    return ADD_USED;
+	}
     }
 
+    const DecisionCandidate<A>* new_winner = find_winner(candidates);
+
     //if there's no new winner, just delete the old route.
     if (new_winner == NULL) {
-	delete_route(old_rtmsg, caller);
+	XLOG_ASSERT(old_route_won);
+	this->_next_table->delete_route(old_rtmsg, (BGPRouteTable<A>*)this);
+	old_rtmsg.route()->set_is_not_winner();
+	candidates.set_winner(NULL);
 	if (new_rtmsg.push() && !old_rtmsg.push())
 	    this->_next_table->push(this);
-	delete old_winner_clone;
 	return ADD_UNUSED;
     }
     
-    if (new_winner->route() == old_winner_clone->route()) {
+    if (new_winner == old_winner) {
 	//No change.
-	//I don't think this can happen.
-	delete old_winner_clone;
 	return ADD_USED;
     }
 
     //create the deletion part of the message
     InternalMessage<A> *old_rtmsg_p, *new_rtmsg_p;
-    if (old_winner_clone->route() == old_rtmsg.route()) {
+    if (old_route_won) {
 	old_rtmsg.clear_push();
 	// FIXME: hack to enable policy route pushing.
 //	old_rtmsg.route()->set_is_not_winner();
 	old_rtmsg_p = &old_rtmsg;
     } else {
-	old_rtmsg_p = new InternalMessage<A>(old_winner_clone->route(), 
-					     old_winner_clone->attributes(),
-					     old_winner_clone->peer_handler(), 
-					     old_winner_clone->genid());
-	old_winner_clone->set_is_not_winner();
+	uint32_t genid;
+	FPAListRef pa_list;
+	lookup_candidate(old_rtmsg.net(), *old_winner, genid, pa_list);
+	old_rtmsg_p = new InternalMessage<A>(old_winner->route(), pa_list,
+					     old_winner->peer_handler(),
+					     genid);
+	old_winner->set_is_not_winner();
     }
 
     //create the addition part of the message
-    new_winner->route()->set_is_winner(
-                         igp_distance(new_winner->attributes()->nexthop()));
+    new_winner->route()->set_is_winner(igp_distance(new_winner->nexthop()));
+    candidates.set_winner(new_winner);
     int result;
-    if (new_winner->route() == new_rtmsg.route()) {
+    if (new_winner == &new_route) {
 	new_rtmsg_p = &new_rtmsg;
     } else {
-	new_rtmsg_p = new InternalMessage<A>(new_winner->route(), 
-					     new_winner->attributes(),
-					     new_winner->peer_handler(), 
-					     new_winner->genid());
+	uint32_t genid;
+	FPAListRef pa_list;
+	lookup_candidate(new_rtmsg.net(), *new_winner, genid, pa_list);
+	new_rtmsg_p = new InternalMessage<A>(new_winner->route(), pa_list,
+					     new_winner->peer_handler(),
+					     genid);
 	if (new_rtmsg.push())
-	    const_cast<InternalMessage<A>*>(new_rtmsg_p)->set_push();
+	    new_rtmsg_p->set_push();
     }
 
     //send the replace message
@@ -299,7 +393,6 @@ DecisionTable<A>::replace_route(InternalMessage<A> &old_rtmsg,
     }
 
     //clean up temporary state
-    delete old_winner_clone;
     if (old_rtmsg_p != &old_rtmsg)
 	delete old_rtmsg_p;
     if (new_rtmsg_p != &new_rtmsg)
@@ -318,76 +411,82 @@ DecisionTable<A>::delete_route(InternalMessage<A> &rtmsg,
     PARANOID_ASSERT(_parents.find(caller) != _parents.end());
     XLOG_ASSERT(this->_next_table != NULL);
 
-    //find the alternative routes, and the old winner if there was one.
-    RouteData<A> *old_winner = NULL, *old_winner_clone = NULL;
-    list<RouteData<A> > alternatives;
-    old_winner = find_alternative_routes(caller, rtmsg.net(), alternatives);
+    PeerTableInfo<A> *pti = parent_info(caller);
+    typename CandidateTrie::iterator iter
+	= _candidates.lookup_node(rtmsg.net());
+    if (iter == _candidates.end())
+	return -1;
+    DecisionCandidates<A>& candidates = iter.payload();
 
-    //preserve old_winner because the original may be deleted by the
-    //decision process
+    //find the old winner if there was one.
+    const DecisionCandidate<A>* old_route = candidates.find(pti);
+    const DecisionCandidate<A>* old_winner = candidates.winner();
+    PeerTableInfo<A> *old_winner_parent = NULL;
+    bool old_route_won = false;
     if (old_winner != NULL) {
-	old_winner_clone = new RouteData<A>(*old_winner);
+	old_winner_parent = old_winner->parent();
+	old_route_won = (old_winner_parent == pti);
 	debug_msg("The Old winner was %s\n", 
 		  old_winner->route()->str().c_str());
-    } else if (rtmsg.route()->is_winner()) {
-	//the route being deleted was the old winner
-	old_winner_clone = new RouteData<A>(rtmsg.route(), 
-					    rtmsg.attributes(),
-					    caller,
-					    rtmsg.origin_peer(), 
-					    rtmsg.genid());
-    }
-    
-    RouteData<A> *new_winner = NULL;
-    if (!alternatives.empty()) {
-	new_winner = find_winner(alternatives);
+	if (!old_route_won && old_route != NULL
+	    && old_winner->ranks_before(*old_route)) {
+	    //the route being deleted can't have beaten the old winner
+	    candidates.erase(pti);
+	    return -1;
+	}
     }
 
-    if (old_winner_clone == NULL && new_winner == NULL) {
+    candidates.erase(pti);
+    old_winner = NULL;
+    if (old_winner_parent != NULL && !old_route_won)
+	old_winner = candidates.find(old_winner_parent);
+    const DecisionCandidate<A>* new_winner = find_winner(candidates);
+
+    if (old_winner_parent == NULL && new_winner == NULL) {
 	//there are no resolvable routes, and there weren't before either/
 	//nothing to do.
+	if (candidates.empty())
+	    _candidates.erase(iter);
 	return -1;
     }
     bool delayed_push = rtmsg.push();
-    if (old_winner_clone != NULL) {
-	if (new_winner != NULL
-	    && old_winner_clone->route() == new_winner->route()) {
+    if (old_winner_parent != NULL) {
+	if (new_winner != NULL && old_winner == new_winner) {
 	    //the winner didn't change.
-	    XLOG_ASSERT(old_winner_clone != NULL);
-	    delete old_winner_clone;
 	    return -1;
 	}
 
 	//the winner did change, or there's no new winner, so send a
 	//delete for the old winner
-	if (old_winner_clone->route() != rtmsg.route()) {
-	    InternalMessage<A> old_rt_msg(old_winner_clone->route(), 
-					  old_winner_clone->attributes(),
-					  old_winner_clone->peer_handler(), 
-					  old_winner_clone->genid());
+	if (!old_route_won) {
+	    uint32_t genid;
+	    FPAListRef pa_list;
+	    lookup_candidate(rtmsg.net(), *old_winner, genid, pa_list);
+	    InternalMessage<A> old_rt_msg(old_winner->route(), pa_list,
+					  old_winner->peer_handler(), genid);
 	    if (rtmsg.push() && new_winner == NULL)
 		old_rt_msg.set_push();
 	    this->_next_table->delete_route(old_rt_msg, (BGPRouteTable<A>*)this);
-	    old_winner_clone->set_is_not_winner();
+	    old_winner->set_is_not_winner();
 	} else {
 	    if (new_winner != NULL)
 		rtmsg.clear_push();
 	    this->_next_table->delete_route(rtmsg, (BGPRouteTable<A>*)this);
 	    rtmsg.route()->set_is_not_winner();
 	}
-
-	//clean up temporary state
-	delete old_winner_clone;
+	candidates.set_winner(NULL);
     }
 
     if (new_winner != NULL) {
 	//send an add for the new winner
 	new_winner->route()->set_is_winner(
-		   igp_distance(new_winner->attributes()->nexthop()));
-	InternalMessage<A> new_rt_msg(new_winner->route(), 
-				      new_winner->attributes(),
-				      new_winner->peer_handler(), 
-				      new_winner->genid());
+		   igp_distance(new_winner->nexthop()));
+	candidates.set_winner(new_winner);
+	uint32_t genid;
+	FPAListRef pa_list;
+	lookup_candidate(rtmsg.net(), *new_winner, genid, pa_list);
+	InternalMessage<A> new_rt_msg(new_winner->route(), pa_list,
+				      new_winner->peer_handler(), genid);
 	//	if (rtmsg.push())
 	//	    new_rt_msg.set_push();
 	this->_next_table->add_route(new_rt_msg, 
@@ -396,6 +495,9 @@ DecisionTable<A>::delete_route(InternalMessage<A> &rtmsg,
 	    this->_next_table->push((BGPRouteTable<A>*)this);
     }
 
+    if (candidates.empty())
+	_candidates.erase(iter);
+
     return 0;
 }
 
@@ -411,33 +513,11 @@ DecisionTable<A>::push(BGPRouteTable<A> *caller) {
 }
 
 /**
- * This version of lookup_route finds the previous winner if there was
- * one, else it finds the best alternative.  Note that the previous
- * winner might not actually be the best current winner, but in this
- * context we need to be consistent - if it won before, then it still
- * wins until a delete_route or replace_route arrives to update our
- * idea of the winner */
-
-template<class A>
-const SubnetRoute<A>*
-DecisionTable<A>::lookup_route(const BGPRouteTable<A>* ignore_parent,
-			       const IPNet<A> &net,
-			       const PeerHandler*& best_routes_peer,
-			       BGPRouteTable<A>*& best_routes_parent) const
-{
-    list <RouteData<A> > alternatives;
-    RouteData<A>* winner
-	= find_alternative_routes(ignore_parent, net, alternatives);
-    if (winner == NULL  && !alternatives.empty()) {
-	winner = find_winner(alternatives);
-    }
-    if (winner != NULL) {
-	best_routes_peer = winner->peer_handler();
-	best_routes_parent = winner->parent_table();
-	return winner->route();
-    }
-    return NULL;
-}
+ * This version of lookup_route finds the current winner if there is
+ * one.  Note that the winner might not actually be the best current
+ * route, but in this context we need to be consistent - if it won
+ * before, then it still wins until a delete_route or replace_route
+ * arrives to update our idea of the winner */
 
 template<class A>
 const SubnetRoute<A>*
@@ -445,83 +525,48 @@ DecisionTable<A>::lookup_route(const IPNet<A> &net,
 			       uint32_t& genid,
 			       FPAListRef& pa_list) const
 {
-    list <RouteData<A> > alternatives;
-    RouteData<A>* winner = find_alternative_routes(NULL, net, alternatives);
+    typename CandidateTrie::iterator iter = _candidates.lookup_node(net);
+    if (iter == _candidates.end())
+	return NULL;
+    const DecisionCandidate<A>* winner = iter.payload().winner();
     if (winner == NULL)
 	return NULL;
-    else {
-	genid = winner->genid();
-	pa_list = winner->attributes();
-	return winner->route();
-    }
-    XLOG_UNREACHABLE();
-    return NULL;
-}
 
+    //while a change of winner is being sent downstream, the winning
+    //branch may already hold a route that hasn't won yet
+    const SubnetRoute<A>* found_route
+	= winner->parent()->route_table()->lookup_route(net, genid, pa_list);
+    if (found_route == NULL || !found_route->is_winner())
+	return NULL;
+    return found_route;
+}
 
 template<class A>
-RouteData<A>*
-DecisionTable<A>::find_alternative_routes(
-    const BGPRouteTable<A> *caller,
-    const IPNet<A>& net,
-    list <RouteData<A> >& alternatives) const 
+PeerTableInfo<A>*
+DecisionTable<A>::parent_info(BGPRouteTable<A>* parent) const
 {
-    RouteData<A>* previous_winner = NULL;
     typename map<BGPRouteTable<A>*, PeerTableInfo<A>* >::const_iterator i;
-    const SubnetRoute<A>* found_route;
-    for (i = _parents.begin();  i != _parents.end();  i++) {
-	//We don't need to lookup the route in the parent that the new
-	//route came from - if this route replaced an earlier route
-	//from the same parent we'd see it as a replace, not an add
- 	if (i->first != caller) {
-	    uint32_t found_genid;
-	    FPAListRef found_attributes;
-	    found_route = i->first->lookup_route(net, found_genid, 
-						 found_attributes);
-	    if (found_route != NULL) {
-		PeerTableInfo<A> *pti = i->second;
-		alternatives.push_back(RouteData<A>(found_route, 
-						    found_attributes,
-						    pti->route_table(),
-						    pti->peer_handler(),
-						    found_genid));
-		if (found_route->is_winner()) {
-		    XLOG_ASSERT(previous_winner == NULL);
-		    previous_winner = &(alternatives.back());
-		}
-	    }
-	}
-    }
-    return previous_winner;
+    i = _parents.find(parent);
+    XLOG_ASSERT(i != _parents.end());
+    return i->second;
 }
 
+/*
+** Get the attributes of a candidate from the branch it came from.
+*/
 template<class A>
-uint32_t
-DecisionTable<A>::local_pref(const FPAListRef& pa_list) const
+const SubnetRoute<A>*
+DecisionTable<A>::lookup_candidate(const IPNet<A>& net,
+				   const DecisionCandidate<A>& c,
+				   uint32_t& genid,
+				   FPAListRef& pa_list) const
 {
-    /*
-     * Local Pref should be present on all routes.  If the route comes
-     * from EBGP, the incoming FilterTable should have added it.  If
-     * the route comes from IBGP, it should have been present on the
-     * incoming route.  
-     */
-    const LocalPrefAttribute* localpref_att = pa_list->local_pref_att();
-    if (localpref_att) {
-	return localpref_att->localpref();
-    }
-    return 0;
-}
+    const SubnetRoute<A>* found_route
+	= c.parent()->route_table()->lookup_route(net, genid, pa_list);
 
-template<class A>
-uint32_t
-DecisionTable<A>::med(const FPAListRef& pa_list) const
-{
-    const MEDAttribute* med_attribute = pa_list->med_att();
-    if (med_attribute) {
-	return med_attribute->med();
-    }
-    
-    return 0;
+    //the branch must still hold the route it last told us about
+    XLOG_ASSERT(found_route == c.route());
+    return found_route;
 }
 
 /*
@@ -569,15 +614,17 @@ DecisionTable<A>::igp_distance(const A nexthop) const
 /*
 ** The main decision process.
 **
-** return true if test_route is better than current_route.
-**        resolved is set to true if the winning route resolves.
+** Only the best ranking candidates can win, so the steps that don't
+** order all the routes are only run on them.
+**
+** return the winning candidate, or NULL if no route is resolvable.
 */
 template<class A>
-RouteData<A>*
-DecisionTable<A>::find_winner(list<RouteData<A> >& alternatives) const
+const DecisionCandidate<A>*
+DecisionTable<A>::find_winner(const DecisionCandidates<A>& candidates) const
 {
-    debug_msg("find_winner: there are %d alternatices\n", (int)alternatives.size());
-    typename list<RouteData<A> >::iterator i;
+    const typename DecisionCandidates<A>::List& list = candidates.list();
+    typename DecisionCandidates<A>::List::const_iterator i = list.begin();
 
     /* The spec seems pretty odd.  In our architecture, it seems
        reasonable to do phase 2 before phase 1, because if a route
@@ -588,262 +635,125 @@ DecisionTable<A>::find_winner(list<RouteData<A> >& alternatives) const
     /*
     ** Check if routes resolve.
     */
-    for (i=alternatives.begin(); i!=alternatives.end();) {
-	if (!i->route()->nexthop_resolved()) {
-	    i = alternatives.erase(i);
-	} else {
-	    i++;
-	}
-    }
-    
+    while (i != list.end() && !i->resolved())
+	i++;
+
     /* If there are no resolvable alternatives, no-one wins */
-    if (alternatives.empty()) {
+    if (i == list.end()) {
 	debug_msg("no resolvable routes\n");
 	return NULL;
     }
-    if (alternatives.size()==1) {
-	debug_msg("one one resolvable route\n");
-	return &(alternatives.front());
-    }
-
-    /* By this point, all remaining routes are resolvable */
 
     /* 
     ** Phase 1: Calculation of degree of preference.
     */
-    int test_pref = local_pref(alternatives.front().attributes());
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	int lp = local_pref(i->attributes());
-	XLOG_ASSERT(lp >= 0);
-	//prefer higher preference
-	if (lp < test_pref) {
-	    i = alternatives.erase(i);
-	} else if (lp > test_pref) {
-	    test_pref = lp;
-	    alternatives.erase(alternatives.begin(), i);
-	    i++;
-	} else {
-	    i++;
-	}
-    }
-
-    if (alternatives.size()==1) {
-	debug_msg("decided on localpref\n");
-	return &(alternatives.front());
-    }
-	  
-
-    /*
-    ** If we got here the preferences for both routes are the same.
-    */
-
-    /*
-    ** Here we are crappy tie breaking.
-    */
-    
-    debug_msg("tie breaking\n");
-    debug_msg("AS path test\n");
     /*
-    ** Shortest AS path length.
+    ** Highest local preference, shortest AS path length and lowest
+    ** origin value: the candidates are sorted on these.
     */
-    int test_aspath_length = alternatives.front().attributes()->
-	aspath().path_length();
-
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	int len = i->attributes()->aspath().path_length();
-	XLOG_ASSERT(len >= 0);
-	//prefer shortest path
-	if (len > test_aspath_length) {
-	    i = alternatives.erase(i);
-	} else if (len < test_aspath_length) {
-	    test_aspath_length = len;
-	    alternatives.erase(alternatives.begin(), i);
-	} else {
-	    i++;
-	}
+    const DecisionCandidate<A>& best = *i;
+    vector<const DecisionCandidate<A>*> alternatives;
+    for (; i != list.end() && !best.ranks_before(*i); i++) {
+	if (i->resolved())
+	    alternatives.push_back(&(*i));
     }
 
-    
     if (alternatives.size()==1) {
-	return &(alternatives.front());
+	debug_msg("decided on localpref, AS path or origin\n");
+	return alternatives.front();
     }
 
-    debug_msg("origin test\n");
     /*
-    ** Lowest origin value.
+    ** Here we are crappy tie breaking.
     */
-    int test_origin = alternatives.front().attributes()->origin();
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	int origin = i->attributes()->origin();
-	//prefer lower origin
-	if (origin > test_origin) {
-	    i = alternatives.erase(i);
-	} else if (origin < test_origin) {
-	    test_origin = origin;
-	    alternatives.erase(alternatives.begin(), i);
-	    i++;
-	} else {
-	    i++;
-	}
-    }
-
-    if (alternatives.size()==1) {
-	return &(alternatives.front());
-    }
+    typename vector<const DecisionCandidate<A>*>::iterator j, k;
 
     debug_msg("MED test\n");
     /*
     ** Compare meds if both routes came from the same neighbour AS.
+    ** This is not transitive, so a route is only dropped if another
+    ** one from its neighbour AS has a lower MED.
     */
-    typename list <RouteData<A> >::iterator j;
-    for (i=alternatives.begin(); i!=alternatives.end();) {
-	ASPath aspath1 = i->attributes()->aspath();
- 	AsNum asnum1 = (0 == aspath1.path_length()) ? 
- 	    AsNum(AsNum::AS_INVALID) : aspath1.first_asnum();
-	int med1 = med(i->attributes());
-	bool del_i = false;
-	for (j=alternatives.begin(); j!=alternatives.end();) {
-	    bool del_j = false;
-	    if (i != j) {
-		ASPath aspath2 = j->attributes()->aspath();
-		AsNum asnum2 = (0 == aspath2.path_length()) ? 
-		    AsNum(AsNum::AS_INVALID) : aspath2.first_asnum();
-		int med2 = med(j->attributes());
-		if (asnum1 == asnum2) {
-		    if (med1 > med2) {
-			i = alternatives.erase(i);
-			del_i = true;
-			break;
-		    } else if (med1 < med2) {
-			j = alternatives.erase(j);
-			del_j = true;
-		    }
-		} 
-	    }
-	    //move to the next j if we didn't already do it using erase
-	    if (del_j == false) {
-		j++;
-	    }
-	}	
-	//move to the next i if we didn't already do it using erase
-	if (del_i == false) {
-	    i++;
+    vector<const DecisionCandidate<A>*> survivors;
+    for (j = alternatives.begin(); j != alternatives.end(); j++) {
+	for (k = alternatives.begin(); k != alternatives.end(); k++) {
+	    if ((*k)->neighbour_as() == (*j)->neighbour_as()
+		&& (*k)->med() < (*j)->med())
+		break;
 	}
+	if (k == alternatives.end())
+	    survivors.push_back(*j);
     }
+    alternatives.swap(survivors);
 
     if (alternatives.size()==1) {
-	return &(alternatives.front());
+	return alternatives.front();
     }
 
-
     debug_msg("EBGP vs IBGP test\n");
     /*
     ** Prefer routes from external peers over internal peers.
     */
-    bool test_ibgp = alternatives.front().peer_handler()->ibgp();
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	bool ibgp = i->peer_handler()->ibgp();
+    bool test_ibgp = alternatives.front()->peer_handler()->ibgp();
+    j = alternatives.begin(); j++;
+    while(j!=alternatives.end()) {
+	bool ibgp = (*j)->peer_handler()->ibgp();
 	if ((!test_ibgp) && ibgp) {
 	    //test route is external, alternative is internal
-	    i = alternatives.erase(i);
+	    j = alternatives.erase(j);
 	} else if (test_ibgp && !ibgp) {
 	    //test route is internal, alternative is external
-	    alternatives.erase(alternatives.begin(), i);
+	    j = alternatives.erase(alternatives.begin(), j);
 	    test_ibgp = ibgp;
-	    i++;
+	    j++;
 	} else {
-	    i++;
+	    j++;
 	}
     }
 
     if (alternatives.size()==1) {
-	return &(alternatives.front());
+	return alternatives.front();
     }
 
-
     debug_msg("IGP distance test\n");
     /*
     ** Compare IGP distances.
     */
-    int test_igp_distance = igp_distance(alternatives.front().attributes()->nexthop());
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	int igp_dist = igp_distance(i->attributes()->nexthop());
+    uint32_t test_igp_distance = igp_distance(alternatives.front()->nexthop());
+    j = alternatives.begin(); j++;
+    while(j!=alternatives.end()) {
+	uint32_t igp_dist = igp_distance((*j)->nexthop());
 	//prefer lower IGP distance
 	if (test_igp_distance < igp_dist) {
-	    i = alternatives.erase(i);
+	    j = alternatives.erase(j);
 	} else if (test_igp_distance > igp_dist) {
-	    alternatives.erase(alternatives.begin(), i);
+	    j = alternatives.erase(alternatives.begin(), j);
 	    test_igp_distance = igp_dist;
-	    i++;
+	    j++;
 	} else {
-	    i++;
+	    j++;
 	}
     }
 
     if (alternatives.size()==1) {
-	return &(alternatives.front());
+	return alternatives.front();
     }
 
-
     debug_msg("BGP ID test\n");
     /*
     ** Choose the route from the neighbour with the lowest BGP ID.
+    ** The neighbour address used to be compared next, but it is the
+    ** BGP ID too.
     */
-    IPv4 test_id = alternatives.front().peer_handler()->id();
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	IPv4 id = i->peer_handler()->id();
-	//prefer lower ID distance
-	if (test_id < id) {
-	    i = alternatives.erase(i);
-	} else if (test_id > id) {
-	    alternatives.erase(alternatives.begin(), i);
-	    test_id = id;
-	    i++;
-	} else {
-	    i++;
-	}
-    }
-
-    if (alternatives.size()==1) {
-	return &(alternatives.front());
-    }
-
-
-    debug_msg("neighbour addr test\n");
-    /*
-    ** Choose the route from the neighbour with the lowest neighbour
-    ** address.
-    */
-    int test_address = alternatives.front().peer_handler()
-	->neighbour_address();
-    i = alternatives.begin(); i++;
-    while(i!=alternatives.end()) {
-	int address = i->peer_handler()->neighbour_address();
-	//prefer lower address
-	if (test_address < address) {
-	    i = alternatives.erase(i);
-	} else if (test_address > address) {
-	    alternatives.erase(alternatives.begin(), i);
-	    test_address = address;
-	    i++;
-	} else {
-	    i++;
-	}
+    const DecisionCandidate<A>* winner = alternatives.front();
+    for (j = alternatives.begin(); j != alternatives.end(); j++) {
+	if ((*j)->peer_handler()->id() < winner->peer_handler()->id())
+	    winner = *j;
     }
 
-    if (alternatives.empty()) {
-	XLOG_UNREACHABLE();
-    }
-    
     //We can get here with more than one route if we compare two
     //identically rated routes.  Just choose one.
-    return &(alternatives.front());
+    return winner;
 }
 
 template<class A>
@@ -23,6 +23,8 @@
 #define __BGP_ROUTE_TABLE_DECISION_HH__
 
 
+#include "libxorp/trie.hh"
+
 #include "route_table_base.hh"
 #include "dump_iterators.hh"
 #include "peer_handler.hh"
@@ -30,50 +32,120 @@
 #include "peer_route_pair.hh"
 
 /**
- * Container for a route and the meta-data about the origin of a route
- * used in the DecisionTable decision process.
+ * A route competing in the DecisionTable decision process, with the
+ * attributes the decision process compares as they were when the route
+ * reached the DecisionTable.
  */
 
 template<class A>
-class RouteData {
+class DecisionCandidate {
 public:
-    RouteData(const SubnetRoute<A>* route, 
-	      FPAListRef pa_list,
-	      BGPRouteTable<A>* parent_table,
-	      const PeerHandler* peer_handler,
-	      uint32_t genid) 
-	: _route(route), _pa_list(pa_list), _parent_table(parent_table), 
-	  _peer_handler(peer_handler), _genid(genid) {}
-
-    /* main reason for defining operator= is to keep the refcount
-       correct on _pa_list */
-    RouteData<A>& operator=(const RouteData<A>& him) {
-	_route = him._route;
-	_pa_list = him._pa_list;
-	_parent_table = him._parent_table;
-	_peer_handler = him.peer_handler;
-	_genid = him._genid;
+    DecisionCandidate(InternalMessage<A>& rtmsg,
+		      PeerTableInfo<A>* parent);
+
+    /**
+     * Compare the steps of the decision process that order all the
+     * routes: higher local preference, shorter AS path, lower origin.
+     *
+     * @return true if this candidate is strictly better than him.
+     */
+    bool ranks_before(const DecisionCandidate<A>& him) const {
+	if (_local_pref != him._local_pref)
+	    return _local_pref > him._local_pref;
+	if (_path_length != him._path_length)
+	    return _path_length < him._path_length;
+	return _origin < him._origin;
     }
 
-    void set_is_not_winner() {
-	_parent_table->route_used(_route, false);
+    void set_is_not_winner() const {
+	_parent->route_table()->route_used(_route, false);
 	_route->set_is_not_winner();
     }
-    void set_is_winner(int igp_distance) {
-	_parent_table->route_used(_route, true);
-	_route->set_is_winner(igp_distance);
-    }
+
     const SubnetRoute<A>* route() const { return _route; }
-    const FPAListRef& attributes() const { return _pa_list; }
-    const PeerHandler* peer_handler() const { return _peer_handler; }
-    BGPRouteTable<A>* parent_table() const { return _parent_table; }
-    uint32_t genid() const { return _genid; }
+    PeerTableInfo<A>* parent() const { return _parent; }
+    const PeerHandler* peer_handler() const { return _parent->peer_handler(); }
+    bool resolved() const { return _route->nexthop_resolved(); }
+    uint32_t med() const { return _med; }
+    uint32_t neighbour_as() const { return _neighbour_as; }
+    const A& nexthop() const { return _nexthop; }
 private:
     const SubnetRoute<A>* _route;
-    FPAListRef _pa_list;
-    BGPRouteTable<A>* _parent_table;
-    const PeerHandler* _peer_handler;
-    uint32_t _genid;
+    PeerTableInfo<A>* _parent;
+    uint32_t _local_pref;
+    uint32_t _path_length;
+    uint32_t _med;
+    uint32_t _neighbour_as;	// AS_INVALID if the AS path is empty
+    A _nexthop;
+    uint8_t _origin;
+};
+
+/**
+ * The routes to a prefix from all the upstream branches, one per
+ * branch, best ranking first, and the current winner.
+ *
+ * The candidates are kept in a tree sorted on the ranking steps, and
+ * indexed by branch, so adding, replacing or removing a candidate
+ * costs O(log k) for k candidates and never reorders the others.
+ */
+
+template<class A>
+class DecisionCandidates {
+public:
+    struct RanksBefore {
+	bool operator()(const DecisionCandidate<A>& a,
+			const DecisionCandidate<A>& b) const {
+	    return a.ranks_before(b);
+	}
+    };
+    typedef multiset<DecisionCandidate<A>, RanksBefore> List;
+
+    DecisionCandidates() : _winner(_list.end()) {}
+    DecisionCandidates(const DecisionCandidates& him)
+	: _winner(_list.end())
+    {
+	XLOG_ASSERT(him.empty());
+    }
+
+    /**
+     * Add a candidate, replacing the one from the same branch if any.
+     * Candidates ranking the same keep the order they arrived in.
+     *
+     * @return the new candidate.
+     */
+    const DecisionCandidate<A>& insert(const DecisionCandidate<A>& c);
+
+    /**
+     * Remove the candidate from a branch.  If it was the winner, no
+     * route wins any more.
+     *
+     * @return true if there was a candidate from the branch.
+     */
+    bool erase(const PeerTableInfo<A>* parent);
+
+    /**
+     * @return the candidate from a branch, or NULL if there is none.
+     */
+    const DecisionCandidate<A>* find(const PeerTableInfo<A>* parent) const;
+
+    const List& list() const { return _list; }
+    bool empty() const { return _list.empty(); }
+
+    /**
+     * @return the current winner, or NULL if no route wins.
+     */
+    const DecisionCandidate<A>* winner() const {
+	return _winner == _list.end() ? NULL : &(*_winner);
+    }
+    void set_winner(const DecisionCandidate<A>* c);
+private:
+    DecisionCandidates& operator=(const DecisionCandidates&); // Not impl
+
+    typedef map<const PeerTableInfo<A>*, typename List::iterator> Index;
+
+    List _list;
+    Index _index;
+    typename List::iterator _winner;
 };
 
 /**
@@ -93,10 +165,13 @@ private:
  * BGP decision process are propagated downstream.
  *
  * When a new route reaches DecisionTable from one peer, we must
- * lookup that route in all the other upstream branches to see if this
- * route wins, or even if it doesn't win, if it causes a change of
- * winning route.  Similarly for route deletions coming from a peer,
- * etc.
+ * decide if this route wins, or even if it doesn't win, if it causes
+ * a change of winning route.  Similarly for route deletions coming
+ * from a peer, etc.  Rather than looking the route up in all the other
+ * upstream branches, DecisionTable keeps the candidate routes to each
+ * prefix, ranked by the first steps of the decision process, so a
+ * change is usually decided by comparing it with the current winner,
+ * and only the winning branch is looked up to send a route downstream.
  */
 
 template<class A>
@@ -153,25 +228,23 @@ public:
 			 BGPRouteTable<A> *caller);
 
 private:
-    const SubnetRoute<A> *lookup_route(const BGPRouteTable<A>* ignore_parent,
-				       const IPNet<A> &net,
-				       const PeerHandler*& best_routes_peer,
-				       BGPRouteTable<A>*& best_routes_parent
-				       ) const;
-
-    RouteData<A>* 
-        find_alternative_routes(const BGPRouteTable<A> *caller,
-				const IPNet<A>& net,
-				list <RouteData<A> >& alternatives) const;
-    uint32_t local_pref(const FPAListRef& pa_list) const;
-    uint32_t med(const FPAListRef& pa_list) const;
+    typedef Trie<A, DecisionCandidates<A> > CandidateTrie;
+
+    PeerTableInfo<A>* parent_info(BGPRouteTable<A>* parent) const;
+    const SubnetRoute<A>* lookup_candidate(const IPNet<A>& net,
+					   const DecisionCandidate<A>& c,
+					   uint32_t& genid,
+					   FPAListRef& pa_list) const;
     bool resolvable(const A) const;
     uint32_t igp_distance(const A) const;
-    RouteData<A>* find_winner(list<RouteData<A> >& alternatives) const;
+    const DecisionCandidate<A>* 
+        find_winner(const DecisionCandidates<A>& candidates) const;
     map<BGPRouteTable<A>*, PeerTableInfo<A>* > _parents;
     map<uint32_t, PeerTableInfo<A>* > _sorted_parents;
 
     NextHopResolver<A>& _next_hop_resolver;
+
+    CandidateTrie _candidates;
 };
 
 #endif // __BGP_ROUTE_TABLE_DECISION_HH__
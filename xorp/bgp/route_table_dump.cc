@@ -35,6 +35,27 @@
 #define cp(x) {}
 #endif
 
+// Implementation Notes:
+//
+// In the fast dump mode, the dump tables of peers that come up
+// together form a dump group.  The first one created, the leader,
+// walks the RibIns; the peers of the others came up after it, so it
+// has none of them to dump.  A follower is created with the peers the
+// leader is still to dump at the front of its list, in the same
+// order, and the peers of the group at the back.  Each table keeps
+// its own DumpIterator, which sees the same route dumps and the same
+// peering events as the leader's during the shared part of the walk,
+// so that it answers route_change_is_valid() for its own queue.
+// Before each batch the leader drains the queues of the followers, as
+// each table does with its own queue before it dumps a route.  When
+// the shared part of the walk is over, the followers carry on on their
+// own with the peers of the group, whose RibIns are usually still
+// empty.  If the leader goes away first, a follower takes over its
+// walk.
+
+template<class A>
+bool DumpTable<A>::_fast_dump = false;
+
 
 template<class A>
 DumpTable<A>::DumpTable(string table_name,
@@ -56,6 +77,9 @@ DumpTable<A>::DumpTable(string table_name,
     _waiting_for_deletion_completion = false;
     _completed = false;
     _triggered_event = false;
+    _fast = _fast_dump;
+    _dump_started = false;
+    _leader = NULL;
 #ifdef AUDIT_ENABLE
     _audit_entries = 0;
     _first_audit = 0;
@@ -190,11 +214,43 @@ DumpTable<A>::route_dump(InternalMessage<A> &rtmsg,
     /* turn the route_dump into a route_add */
     _dump_iter.route_dump(rtmsg);
     _dumped++;
+
+    // The followers get the route before our downstream gets to
+    // modify the path attributes.
+    typename list<DumpTable<A> *>::iterator i;
+    for (i = _followers.begin(); i != _followers.end(); i++)
+	(*i)->follow_route_dump(rtmsg);
+
     int result = this->_next_table->add_route(rtmsg, (BGPRouteTable<A>*)this);
-    this->_next_table->push((BGPRouteTable<A>*)this);
+    // In the fast dump mode the whole batch is pushed at once.
+    if (!_fast)
+	this->_next_table->push((BGPRouteTable<A>*)this);
     return result;
 }
 
+template<class A>
+void
+DumpTable<A>::follow_route_dump(const InternalMessage<A> &rtmsg)
+{
+    XLOG_ASSERT(_leader != NULL);
+    XLOG_ASSERT(!_completed);
+
+    // Need to clone the PA list or we'll modify the same version
+    // multiple times in different ways downstream.
+    FPAListRef fpa_list = 
+	new FastPathAttributeList<A>(*rtmsg.const_attributes());
+    InternalMessage<A> copy(rtmsg.route(), fpa_list, rtmsg.origin_peer(),
+			    rtmsg.genid());
+    if (rtmsg.changed())
+	copy.set_changed();
+    if (rtmsg.from_previous_peering())
+	copy.set_from_previous_peering();
+
+    _dump_iter.route_dump(copy);
+    _dumped++;
+    this->_next_table->add_route(copy, (BGPRouteTable<A>*)this);
+}
+
 /*
  * We can see a delete_route during a route dump because routes we've
  * already dumped may then be deleted before the dump has completed */
@@ -282,6 +338,13 @@ DumpTable<A>::initiate_background_dump()
     //delay the actual start of the dump to allow whoever is calling
     //us to get their act in order before we wake up the downstream
     //branch
+    schedule_wakeup_downstream();
+}
+
+template<class A>
+void
+DumpTable<A>::schedule_wakeup_downstream()
+{
     _dump_timer = eventloop().
 	new_oneoff_after_ms(0 /*call back immediately, but after
 				network events or expired timers */,
@@ -289,6 +352,77 @@ DumpTable<A>::initiate_background_dump()
 				     &DumpTable<A>::wakeup_downstream));
 }
 
+template<class A>
+bool
+DumpTable<A>::can_lead() const
+{
+    return _fast && _leader == NULL && !_dump_started && !_completed
+	&& _dump_iter.is_valid();
+}
+
+template<class A>
+void
+DumpTable<A>::add_follower(DumpTable<A> *follower)
+{
+    XLOG_ASSERT(can_lead());
+    XLOG_ASSERT(follower->_leader == NULL && follower->_followers.empty());
+    XLOG_ASSERT(follower->_dump_iter.current_peer()
+		== _dump_iter.current_peer());
+
+    follower->_leader = this;
+    _followers.push_back(follower);
+}
+
+/*
+ * The leader has walked all the peers the group shares: the followers
+ * are on their own now.
+ */
+template<class A>
+void
+DumpTable<A>::end_shared_walk()
+{
+    while (!_followers.empty()) {
+	DumpTable<A> *follower = _followers.front();
+	_followers.pop_front();
+	follower->_leader = NULL;
+	follower->_dump_started = true;
+	// The follower has not been asking upstream for more since it
+	// started.
+	follower->schedule_wakeup_downstream();
+    }
+}
+
+/*
+ * We are going away before the end of the shared walk.
+ */
+template<class A>
+void
+DumpTable<A>::leave_dump_group()
+{
+    if (_leader != NULL) {
+	_leader->_followers.remove(this);
+	_leader = NULL;
+	return;
+    }
+
+    if (_followers.empty())
+	return;
+
+    // The first follower takes over our walk, and leads the others.
+    DumpTable<A> *leader = _followers.front();
+    _followers.pop_front();
+    leader->_leader = NULL;
+    leader->_dump_started = true;
+    leader->_followers.swap(_followers);
+    typename list<DumpTable<A> *>::iterator i;
+    for (i = leader->_followers.begin(); i != leader->_followers.end(); i++)
+	(*i)->_leader = leader;
+    // If our walk is over, the shared part of the walk is over too.
+    if (_dump_iter.is_valid())
+	leader->_dump_iter.take_over_walk(_dump_iter);
+    leader->schedule_wakeup_downstream();
+}
+
 template<class A>
 void
 DumpTable<A>::wakeup_downstream()
@@ -322,6 +456,7 @@ DumpTable<A>::suspend_dump()
     cp(16);
     _dump_active = false;
     _dump_timer.unschedule();
+    leave_dump_group();
 
     // suspend is being called because the fanout table is unplumbing us.
     this->_next_table->set_parent(NULL);
@@ -339,12 +474,15 @@ DumpTable<A>::do_next_route_dump()
 {
     XLOG_ASSERT(!_completed);
     XLOG_ASSERT(!_triggered_event);
+    XLOG_ASSERT(_leader == NULL);
 
     // if we get here, the output is not busy and there's no queue of
     // changes upstream of us, so it's time to do more of the route
     // dump...
     debug_msg("dumped %d routes\n", _dumped);
+    _dump_started = true;
     if (_dump_iter.is_valid() == false) {
+	end_shared_walk();
 	if (_dump_iter.waiting_for_deletion_completion()) {
 	    // go into final wait state
 	    _waiting_for_deletion_completion = true;
@@ -356,7 +494,11 @@ DumpTable<A>::do_next_route_dump()
 
     //	debug_msg("dump route with net %p\n", _dump_iter.net().str().c_str());
     if (this->_parent->dump_next_route(_dump_iter) == false) {
+	typename list<DumpTable<A> *>::iterator i;
+	for (i = _followers.begin(); i != _followers.end(); i++)
+	    (*i)->_dump_iter.next_peer();
 	if (_dump_iter.next_peer() == false) {
+	    end_shared_walk();
 	    if (_dump_iter.waiting_for_deletion_completion()) {
 		// go into final wait state
 		_waiting_for_deletion_completion = true;
@@ -369,6 +511,35 @@ DumpTable<A>::do_next_route_dump()
     return true;
 }
 
+template<class A>
+bool
+DumpTable<A>::do_next_batch()
+{
+    // Like us, the followers must take the changes queued for them
+    // before any more routes are dumped.
+    typename list<DumpTable<A> *>::iterator i;
+    for (i = _followers.begin(); i != _followers.end(); i++) {
+	while (this->_parent->
+	       get_next_message(static_cast<BGPRouteTable<A>*>(*i)))
+	    ;
+    }
+
+    list<DumpTable<A> *> followers = _followers;
+    int dumped = _dumped;
+    bool more = true;
+    for (int n = 0; n < FAST_DUMP_BATCH && more; n++)
+	more = do_next_route_dump();
+
+    // The routes were not pushed as they were dumped.  The followers
+    // we had when the batch started may have been released since.
+    if (_dumped != dumped) {
+	this->_next_table->push((BGPRouteTable<A>*)this);
+	for (i = followers.begin(); i != followers.end(); i++)
+	    (*i)->_next_table->push((BGPRouteTable<A>*)*i);
+    }
+    return more;
+}
+
 template<class A>
 bool
 DumpTable<A>::get_next_message(BGPRouteTable<A> *next_table) 
@@ -403,6 +574,9 @@ DumpTable<A>::get_next_message(BGPRouteTable<A> *next_table)
 	    get_next_message(static_cast<BGPRouteTable<A>*>(this));
 	if (messages_queued) {
 	    return true;
+	} else if (_leader != NULL) {
+	    // Our leader does the dumping for us.
+	    return false;
 	} else if (!_triggered_event) {
 	    // Only dump the next chunk if we have been woken up as a
 	    // background task.  Otherwise it's not safe to dump a
@@ -410,6 +584,8 @@ DumpTable<A>::get_next_message(BGPRouteTable<A> *next_table)
 	    // event elsewhere, and we need to be careful never to do
 	    // a dump between events that some other route table
 	    // assumes are atomic
+	    if (_fast)
+		return do_next_batch();
 	    return do_next_route_dump();
 	} else {
 	    return false;
@@ -565,6 +741,7 @@ DumpTable<A>::unplumb_self()
     XLOG_ASSERT(this->_next_table != NULL);
     XLOG_ASSERT(this->_parent != NULL 
 		|| (this->_parent == NULL && _dump_active == false));
+    XLOG_ASSERT(_leader == NULL && _followers.empty());
     _dump_active = false;
 
     this->_next_table->set_parent(this->_parent);
@@ -67,6 +67,58 @@ public:
     void initiate_background_dump();
     void suspend_dump();
 
+    /**
+     * Select the fast dump mode for the dump tables created from now
+     * on.  A fast dump sends a batch of routes each time the
+     * downstream asks for more, and pushes them once, rather than
+     * sending a route at a time.  Dump tables that are created before
+     * any of them has started to dump also share a single walk of the
+     * RibIns (a dump group): the first one created walks the RibIns
+     * and the routes found are passed to all of them.
+     *
+     * @param fast true to select the fast dump mode.
+     */
+    static void set_fast_dump(bool fast) { _fast_dump = fast; }
+    static bool fast_dump() { return _fast_dump; }
+
+    /**
+     * The number of routes dumped in a batch in the fast dump mode.
+     */
+    static const int FAST_DUMP_BATCH = 50;
+
+    /**
+     * @return true if a new dump table can share the walk of the
+     * RibIns of this one: we were created in the fast dump mode, we
+     * walk for ourselves, and we have not started yet.
+     */
+    bool can_lead() const;
+
+    /**
+     * The peers this dump table is still to dump, in the order it
+     * will dump them.  A dump table that joins our walk must dump
+     * them first, in the same order.
+     */
+    void peers_still_to_dump(list<const PeerHandler*>& peers) const {
+	_dump_iter.peers_still_to_dump(peers);
+    }
+
+    /**
+     * Add a dump table to our dump group.  It must have been created
+     * with the peers we are still to dump at the front of its list.
+     */
+    void add_follower(DumpTable<A> *follower);
+
+    /**
+     * @return the table that walks the RibIns for us, or NULL if we
+     * walk for ourselves.
+     */
+    const DumpTable<A> *leader() const { return _leader; }
+
+    /**
+     * @return the peer this table dumps to.
+     */
+    const PeerHandler *peer_to_dump_to() const { return _peer; }
+
     /**
      * A peer which is down but still deleting routes when this peer
      * is brought up.
@@ -107,7 +159,12 @@ private:
     void schedule_unplumb_self();
     void unplumb_self();
     void wakeup_downstream();
+    void schedule_wakeup_downstream();
     bool do_next_route_dump();
+    bool do_next_batch();
+    void follow_route_dump(const InternalMessage<A> &rtmsg);
+    void end_shared_walk();
+    void leave_dump_group();
     EventLoop& eventloop() const {return _peer->eventloop();}
 
     const PeerHandler *_peer;
@@ -132,6 +189,13 @@ private:
     //The dump table has done its job and can be removed.
     bool _completed;
 
+    bool _fast;				// Dumping in the fast dump mode
+    bool _dump_started;			// true once we walked the RibIns
+    DumpTable<A> *_leader;		// Walks the RibIns for us, if any
+    list<DumpTable<A> *> _followers;	// Share our walk of the RibIns
+
+    static bool _fast_dump;
+
 #ifdef AUDIT_ENABLE
     //audit trail for debugging - keep a log of last few events, use
     //this as a circular buffer
@@ -206,6 +206,12 @@ FanoutTable<A>::replace_next_table(BGPRouteTable<A> *old_next_table,
     const PeerHandler *peer = iter.second().peer_handler();
     uint32_t genid = iter.second().genid();
 
+    // A dump table that is done unplumbs itself by replacing itself
+    // with its next table.
+    DumpTable<A> *dtp = dynamic_cast<DumpTable<A>*>(old_next_table);
+    if (dtp)
+	remove_dump_table(dtp);
+
     _next_tables.erase(iter);
     _next_tables.insert(new_next_table, peer, genid);
     return 0;
@@ -493,7 +499,9 @@ FanoutTable<A>::peer_table_info(list<const PeerTableInfo<A>*>& peer_list) {
     typename NextTableMap<A>::iterator i;
     
     for (i = _next_tables.begin(); i != _next_tables.end(); i++) {
-	if (i.second().peer_handler() != NULL)
+	const PeerHandler *ph = i.second().peer_handler();
+	// An update group handler has no routes of its own.
+	if (ph != NULL && !ph->update_group_handler())
 	    peer_list.push_back(&(i.second()));
     }
 
@@ -511,7 +519,8 @@ FanoutTable<A>::dump_entire_table(BGPRouteTable<A> *child_to_dump_to,
     PeerTableInfo<A> *peer_info = NULL;
     list <const PeerTableInfo<A>*> peer_list;
     for (i = _next_tables.begin(); i != _next_tables.end(); i++) {
-	if (i.second().peer_handler() != NULL)
+	const PeerHandler *ph = i.second().peer_handler();
+	if (ph != NULL && !ph->update_group_handler())
 	    peer_list.push_back(&(i.second()));
 	if (i.first() == child_to_dump_to)
 	    peer_info = &(i.second());
@@ -524,11 +533,45 @@ FanoutTable<A>::dump_entire_table(BGPRouteTable<A> *child_to_dump_to,
     XLOG_ASSERT(peer_info != NULL);
     const PeerHandler *peer_handler = peer_info->peer_handler();
 
+    // In the fast dump mode, share the walk of a dump table that has
+    // not started yet.  We must dump the peers it is still to dump
+    // first, in the same order, to stay in step with it.
+    DumpTable<A>* leader = NULL;
+    if (DumpTable<A>::fast_dump()) {
+	typename set <DumpTable<A>*>::iterator d;
+	for (d = _dump_tables.begin(); d != _dump_tables.end(); d++) {
+	    if ((*d)->can_lead()) {
+		leader = *d;
+		break;
+	    }
+	}
+    }
+    if (leader != NULL) {
+	list <const PeerHandler*> shared;
+	leader->peers_still_to_dump(shared);
+	list <const PeerTableInfo<A>*> ordered;
+	typename list <const PeerHandler*>::iterator s;
+	for (s = shared.begin(); s != shared.end(); s++) {
+	    typename list <const PeerTableInfo<A>*>::iterator p;
+	    for (p = peer_list.begin(); p != peer_list.end(); p++) {
+		if ((*p)->peer_handler() == *s)
+		    break;
+	    }
+	    // A peer the leader is still to dump cannot have gone down.
+	    XLOG_ASSERT(p != peer_list.end());
+	    ordered.push_back(*p);
+	    peer_list.erase(p);
+	}
+	peer_list.splice(peer_list.begin(), ordered);
+    }
+
     string tablename = string(ribname + "DumpTable" +
 			      peer_handler->peername());
     DumpTable<A>* dump_table =
 	new DumpTable<A>(tablename, peer_handler, peer_list,
 			 (BGPRouteTable<A>*)this, safi);
+    if (leader != NULL)
+	leader->add_follower(dump_table);
 
     dump_table->set_next_table(child_to_dump_to);
     child_to_dump_to->set_parent(dump_table);
@@ -845,6 +888,56 @@ FanoutTable<A>::get_next_message(BGPRouteTable<A> *next_table)
     return peer_info->has_queued_data();
 }
 
+template<class A>
+bool
+FanoutTable<A>::has_queued_data(BGPRouteTable<A> *next_table)
+{
+    typename NextTableMap<A>::iterator i;
+    i = _next_tables.find(next_table);
+    XLOG_ASSERT(i != _next_tables.end());
+
+    return i.second().has_queued_data();
+}
+
+template<class A>
+void
+FanoutTable<A>::copy_queue_position(BGPRouteTable<A> *to,
+				    BGPRouteTable<A> *from)
+{
+    typename NextTableMap<A>::iterator i;
+    i = _next_tables.find(from);
+    XLOG_ASSERT(i != _next_tables.end());
+    PeerTableInfo<A> *from_info = &(i.second());
+
+    i = _next_tables.find(to);
+    XLOG_ASSERT(i != _next_tables.end());
+    PeerTableInfo<A> *to_info = &(i.second());
+    XLOG_ASSERT(to_info->has_queued_data() == false);
+
+    if (from_info->has_queued_data() == false)
+	return;
+
+    /* skip past anything that came from the peer of the new position */
+    typename list<const RouteQueueEntry<A>*>::iterator queue_ptr;
+    queue_ptr = from_info->queue_position();
+    while ((queue_ptr != _output_queue.end())
+	   && ((*queue_ptr)->origin_peer() == to_info->peer_handler())) {
+	if ((*queue_ptr)->op() == RTQUEUE_OP_REPLACE_OLD)
+	    queue_ptr++;
+	XLOG_ASSERT(queue_ptr != _output_queue.end());
+	queue_ptr++;
+    }
+    if (queue_ptr == _output_queue.end())
+	return;
+
+    to_info->set_queue_position(queue_ptr);
+    to_info->set_has_queued_data(true);
+    if (to_info->is_ready()) {
+	to_info->wakeup_sent();
+	to->wakeup();
+    }
+}
+
 template<class A>
 void
 FanoutTable<A>::skip_entire_queue(BGPRouteTable<A> *next_table) 
@@ -113,6 +113,21 @@ public:
     /* mechanisms to implement flow control in the output plumbing */
     bool get_next_message(BGPRouteTable<A> *next_table);
 
+    /**
+     * @return true if there are queued messages for a next table.
+     */
+    bool has_queued_data(BGPRouteTable<A> *next_table);
+
+    /**
+     * Start a next table with no queued data at the queue position of
+     * another next table, so that it is sent what the other one has
+     * still to be sent, except what came from its own peer.
+     *
+     * @param to the next table to start.
+     * @param from the next table whose position is copied.
+     */
+    void copy_queue_position(BGPRouteTable<A> *to, BGPRouteTable<A> *from);
+
     void peering_went_down(const PeerHandler *peer, uint32_t genid,
 			   BGPRouteTable<A> *caller);
     void peering_down_complete(const PeerHandler *peer, uint32_t genid,
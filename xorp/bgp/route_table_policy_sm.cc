@@ -53,11 +53,21 @@ PolicyTableSourceMatch<A>::~PolicyTableSourceMatch()
 
 template <class A>
 void
-PolicyTableSourceMatch<A>::push_routes(list<const PeerTableInfo<A>*>& peer_list)
+PolicyTableSourceMatch<A>::push_routes(list<const PeerTableInfo<A>*>& peer_list,
+				       const set<IPNet<A> >* nets)
 {
+    if (_pushing_routes) {
+	debug_msg("[BGP] Push routes restarted\n");
+	_dump_task.unschedule();
+	delete _dump_iter;
+	nets = NULL;
+    }
+
     _pushing_routes = true;
     
     _dump_iter = new DumpIterator<A>(NULL, peer_list);
+    if (nets != NULL)
+	_dump_iter->restrict_to(*nets);
 
     debug_msg("[BGP] Push routes\n");
 
@@ -118,7 +128,13 @@ PolicyTableSourceMatch<A>::do_background_dump()
 	return false;
 
     // do a dump
-    do_next_route_dump();
+    for (int n = 0; n < DUMP_BATCH && _pushing_routes; n++)
+	do_next_route_dump();
+
+    // The RibOuts queue the changes until they are pushed, and look up
+    // the queue for each route they are given, so let the queue grow
+    // by a batch rather than by the whole table.
+    this->_next_table->push(this);
 
     // continue in background...
     return true;
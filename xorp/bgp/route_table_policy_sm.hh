@@ -54,9 +54,15 @@ public:
     /**
      * Push routes of all these peers.
      *
+     * A push started while another one is in progress pushes all the
+     * routes, as the routes the other one did not reach yet are unknown.
+     *
      * @param peer_list peers for which routes whould be dumped.
+     * @param nets if not NULL, only push the routes whose network
+     * overlaps one of these networks.
      */
-    void push_routes(list<const PeerTableInfo<A>*>& peer_list);
+    void push_routes(list<const PeerTableInfo<A>*>& peer_list,
+		     const set<IPNet<A> >* nets = NULL);
 
     /*
      * Need to keep track what is going on with dump iterators which peers go
@@ -73,6 +79,19 @@ public:
     void peering_came_up(const PeerHandler *peer, uint32_t genid,
                          BGPRouteTable<A> *caller);
 
+    /**
+     * The number of routes dumped in a background step, and pushed
+     * downstream together.
+     */
+    static const int DUMP_BATCH = 50;
+
+    /**
+     * Check whether a policy push is occuring 
+     *
+     * @return true if routes are being pushed
+     */
+    bool pushing_routes();
+
 private:
     /**
      * Dump the next route.
@@ -89,13 +108,6 @@ private:
      */
     bool do_background_dump();
 
-    /**
-     * Check whether a policy push is occuring 
-     *
-     * @return true if routes are being pushed
-     */
-    bool pushing_routes();
-
 private:
     EventLoop&		eventloop();
 
@@ -329,6 +329,9 @@ template<class A>
 bool
 RibInTable<A>::dump_next_route(DumpIterator<A>& dump_iter)
 {
+    if (dump_iter.restricted())
+	return dump_next_overlapping_route(dump_iter);
+
     typename BgpTrie<A>::iterator route_iterator;
     debug_msg("dump iter: %s\n", dump_iter.str().c_str());
    
@@ -366,24 +369,7 @@ RibInTable<A>::dump_next_route(DumpIterator<A>& dump_iter)
 	// XXX: or if its a policy route dump
 
 	if (chained_rt->is_winner() || dump_iter.peer_to_dump_to() == NULL) {
-	    InternalMessage<A> rt_msg(chained_rt, _peer, _genid);
-	   
-	    //XLOG_WARNING("dump route: %s", rt_msg.str().c_str());
-	    try {
-		int res = this->_next_table->route_dump(rt_msg, (BGPRouteTable<A>*)this,
-							dump_iter.peer_to_dump_to());
-		if(res == ADD_FILTERED) 
-		    chained_rt->set_filtered(true);
-		else
-		    chained_rt->set_filtered(false);
-	    }
-	    catch (const XorpException& e) {
-		//TODO:  Make sure bad routes never get into the table in the first place
-		// (was an IPv6 zero default route that triggered this bug initially)
-		//  See test 28-ipv6 in harness/test_peering1.sh  --Ben
-		XLOG_WARNING("Exception in dump_next_route: %s\n", e.str().c_str());
-		XLOG_WARNING("  rt_msg: %s\n", rt_msg.str().c_str());
-	    }
+	    dump_route(dump_iter, chained_rt);
 	    break;
 	}
     }
@@ -397,6 +383,84 @@ RibInTable<A>::dump_next_route(DumpIterator<A>& dump_iter)
     return true;
 }
 
+template<class A>
+bool
+RibInTable<A>::dump_next_overlapping_route(DumpIterator<A>& dump_iter)
+{
+    debug_msg("dump iter: %s\n", dump_iter.str().c_str());
+
+    list<IPNet<A> >& overlapping = dump_iter.overlapping();
+
+    if (!dump_iter.overlapping_found()) {
+	/*
+	** The first call for this peer: find the networks of the routes
+	** which overlap a restricted network, which are those it covers
+	** and those covering it.  The walk is done at once as the trie
+	** may change between calls, so only the networks are kept.
+	*/
+	set<IPNet<A> > found;
+	const set<IPNet<A> >& nets = dump_iter.restricted_nets();
+	typename set<IPNet<A> >::const_iterator i;
+	for (i = nets.begin(); i != nets.end(); ++i) {
+	    typename BgpTrie<A>::iterator j;
+	    for (j = _route_table->search_subtree(*i);
+		 j != _route_table->end(); j++) {
+		// The walk may start at a node outside the subtree.
+		if (i->contains(j.key()))
+		    found.insert(j.key());
+	    }
+	    for (j = _route_table->find_less_specific(*i);
+		 j != _route_table->end();
+		 j = _route_table->find_less_specific(j.key()))
+		found.insert(j.key());
+	}
+	overlapping.insert(overlapping.end(), found.begin(), found.end());
+	dump_iter.set_overlapping_found();
+    }
+
+    // Skip the routes deleted since the walk.
+    while (!overlapping.empty()) {
+	typename BgpTrie<A>::iterator j
+	    = _route_table->lookup_node(overlapping.front());
+	overlapping.pop_front();
+	if (j == _route_table->end())
+	    continue;
+
+	const ChainedSubnetRoute<A>* chained_rt = &(j.payload());
+	if (chained_rt->is_winner() || dump_iter.peer_to_dump_to() == NULL) {
+	    dump_route(dump_iter, chained_rt);
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+template<class A>
+void
+RibInTable<A>::dump_route(DumpIterator<A>& dump_iter,
+			  const ChainedSubnetRoute<A>* chained_rt)
+{
+    InternalMessage<A> rt_msg(chained_rt, _peer, _genid);
+	   
+    //XLOG_WARNING("dump route: %s", rt_msg.str().c_str());
+    try {
+	int res = this->_next_table->route_dump(rt_msg, (BGPRouteTable<A>*)this,
+						dump_iter.peer_to_dump_to());
+	if(res == ADD_FILTERED) 
+	    chained_rt->set_filtered(true);
+	else
+	    chained_rt->set_filtered(false);
+    }
+    catch (const XorpException& e) {
+	//TODO:  Make sure bad routes never get into the table in the first place
+	// (was an IPv6 zero default route that triggered this bug initially)
+	//  See test 28-ipv6 in harness/test_peering1.sh  --Ben
+	XLOG_WARNING("Exception in dump_next_route: %s\n", e.str().c_str());
+	XLOG_WARNING("  rt_msg: %s\n", rt_msg.str().c_str());
+    }
+}
+
 template<class A>
 void
 RibInTable<A>::igp_nexthop_changed(const A& bgp_nexthop)
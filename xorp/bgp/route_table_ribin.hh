@@ -104,6 +104,14 @@ public:
 
     bool dump_next_route(DumpIterator<A>& dump_iter);
 
+    /**
+     * Dump the next route whose network overlaps one of the networks the
+     * dump is restricted to.
+     *
+     * @return false when no such route is left.
+     */
+    bool dump_next_overlapping_route(DumpIterator<A>& dump_iter);
+
     /*igp_nexthop_changed is called when the IGP routing changes in
       such a way that IGP information that was being used by BGP for
       its decision process is affected.  We need to scan through the
@@ -135,6 +143,12 @@ public:
 private:
     EventLoop& eventloop() const;
 
+    /**
+     * Send a route downstream as part of a dump.
+     */
+    void dump_route(DumpIterator<A>& dump_iter,
+		    const ChainedSubnetRoute<A>* chained_rt);
+
     BgpTrie<A>* _route_table;
     const PeerHandler *_peer;
     bool _peer_is_up;
@@ -336,6 +336,7 @@ RibOutTable<A>::push(BGPRouteTable<A> *caller)
 		// the sanity checking was done in add_route...
 		FPAListRef pa_list = (*i)->attributes();
 		pa_list->unlock();
+		_peer->set_origin_peers(NULL, (*i)->origin_peer());
 		_peer->add_route(*((*i)->route()), 
 				 pa_list,
 				 (*i)->origin_peer()->ibgp(), this->safi());
@@ -345,6 +346,7 @@ RibOutTable<A>::push(BGPRouteTable<A> *caller)
 		debug_msg("* Withdraw\n");
 		FPAListRef pa_list = (*i)->attributes();
 		pa_list->unlock();
+		_peer->set_origin_peers((*i)->origin_peer(), NULL);
 		_peer->delete_route(*((*i)->route()), 
 				    pa_list,
 				    (*i)->origin_peer()->ibgp(), this->safi());
@@ -362,6 +364,8 @@ RibOutTable<A>::push(BGPRouteTable<A> *caller)
 		FPAListRef pa_list = (*i)->attributes();
 		pa_list->unlock();
 		old_queue_entry->attributes()->unlock();
+		_peer->set_origin_peers(old_queue_entry->origin_peer(),
+					(*i)->origin_peer());
 		_peer->replace_route(*old_route, old_ibgp,
 				     *new_route, new_ibgp,
 				     pa_list,
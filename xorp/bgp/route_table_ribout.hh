@@ -77,6 +77,16 @@ public:
 
     void reschedule_self();
 
+    /**
+     * @return true if no route is waiting for a push.
+     */
+    bool queue_empty() const { return _queue.empty(); }
+
+    /**
+     * Send the routes waiting for a push to the peer handler now.
+     */
+    void flush() { push(this->_parent); }
+
     void peering_went_down(const PeerHandler *peer, uint32_t genid,
 			   BGPRouteTable<A> *caller);
     void peering_down_complete(const PeerHandler *peer, uint32_t genid,
@@ -155,6 +155,7 @@ SocketClient::SocketClient(const Iptuple& iptuple, EventLoop& e, bool md5sig)
     _async_reader = 0;
     _disconnecting = false;
     _connecting = false;
+    _reader_paused = false;
 }
 
 SocketClient::~SocketClient()
@@ -323,7 +324,8 @@ SocketClient::async_read_message(AsyncFileWriter::Event ev,
 	     */
 	    if (buf_bytes == fh_length) {
 		if (_callback->dispatch(BGPPacket::GOOD_MESSAGE,
-					buf, buf_bytes, this))
+					buf, buf_bytes, this)
+		    && !_reader_paused)
 		    async_read_start();		// ready for next message
 	    } else {				// read rest of the message
 		async_read_start(fh_length, buf_bytes);
@@ -333,12 +335,13 @@ SocketClient::async_read_message(AsyncFileWriter::Event ev,
 	** At this point if we have a valid _async_reader then it should
 	** have buffers into which we expect data.
 	*/
-	if (_async_reader && 0 == _async_reader->buffers_remaining())
+	if (_async_reader && !_reader_paused
+	    && 0 == _async_reader->buffers_remaining())
 	    XLOG_WARNING("No outstanding reads %s socket %p async_reader %p",
 			 is_connected() ? "connected" : "not connected",
 			 this, _async_reader);
 	
-	XLOG_ASSERT(!_async_reader ||
+	XLOG_ASSERT(!_async_reader || _reader_paused ||
 		    (_async_reader &&
 		     _async_reader->buffers_remaining() > 0));
 	break;
@@ -427,11 +430,12 @@ SocketClient::send_message(const uint8_t* buf,
 bool 
 SocketClient::output_queue_busy() const 
 {
-    //20 is a fairly arbitrary soft limit on how many buffers we want
-    //in the output queue before we start to push back
+    // A soft limit on how many buffers we want in the output queue
+    // before we start to push back.  It is also how many buffers the
+    // writer coalesces, so a full queue is a single write.
     XLOG_ASSERT(_async_writer);
 
-    if (_async_writer->buffers_remaining() > 20)
+    if (_async_writer->buffers_remaining() > OUTPUT_QUEUE_LIMIT)
 	return true;
     else
 	return false;
@@ -589,7 +593,7 @@ SocketClient::async_add(XorpFd sock)
 	XLOG_FATAL("Failed to go non-blocking");
 
     XLOG_ASSERT(0 == _async_writer);
-    _async_writer = new AsyncFileWriter(eventloop(), sock);
+    _async_writer = new AsyncFileWriter(eventloop(), sock, OUTPUT_QUEUE_LIMIT);
 
     XLOG_ASSERT(0 == _async_reader);
     //
@@ -625,6 +629,18 @@ SocketClient::async_remove_reader()
 	delete _async_reader;
 	_async_reader = 0;
     }
+    _reader_paused = false;
+}
+
+void
+SocketClient::resume_reader()
+{
+    if (!_reader_paused)
+	return;
+
+    _reader_paused = false;
+    if (_async_reader)
+	async_read_start();
 }
 
 bool 
@@ -121,6 +121,13 @@ private:
 
 class SocketClient : public Socket {
 public:
+    /**
+     * The number of messages queued for transmission before the client
+     * is asked to stop sending.  The queued messages are written
+     * together, by as few system calls as possible.
+     */
+    static const uint32_t OUTPUT_QUEUE_LIMIT = 64;
+
     /**
      * @param iptuple specification of the connection endpoints.
      */
@@ -166,6 +173,23 @@ public:
      */
     void stop_reader() {async_remove_reader();}
 
+    /**
+     * Flow control for incoming data: stop reading messages, once the
+     * message being delivered has been processed, without closing
+     * the session.
+     */
+    void pause_reader()				{ _reader_paused = true; }
+
+    /**
+     * Start reading messages again after pause_reader().
+     */
+    void resume_reader();
+
+    /**
+     * @return true if reading has been paused.
+     */
+    bool reader_paused() const			{ return _reader_paused; }
+
     /**
      * Disconnect this socket.
      */
@@ -280,6 +304,7 @@ private:
     bool _disconnecting;
     bool _connecting;
     bool _md5sig;
+    bool _reader_paused;
 
     uint8_t _read_buf[BGPPacket::MAXPACKETSIZE]; // Maximum allowed BGP message
 };
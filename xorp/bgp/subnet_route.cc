@@ -29,16 +29,38 @@ RouteMetaData::RouteMetaData(const RouteMetaData& metadata)
     _flags = metadata._flags;  // leave the ref count - this will be
 			      // fixed by the container class
     _igp_metric = metadata._igp_metric;
-    _policytags = metadata._policytags;
+    _policytags = NULL;
+    if (metadata._policytags != NULL)
+	_policytags = new PolicyTags(*metadata._policytags);
     for (int i = 0; i < 3; i++)
 	_pfilter[i] = metadata._pfilter[i];
 }
 
 RouteMetaData::RouteMetaData()
-    :_flags(0), _igp_metric(0xffffffff)
+    :_flags(0), _igp_metric(0xffffffff), _policytags(NULL)
 {
 }
 
+void
+RouteMetaData::set_policytags(const PolicyTags& tags)
+{
+    if (tags.empty()) {
+	delete _policytags;
+	_policytags = NULL;
+    } else if (_policytags != NULL) {
+	*_policytags = tags;
+    } else {
+	_policytags = new PolicyTags(tags);
+    }
+}
+
+const PolicyTags&
+RouteMetaData::no_policytags()
+{
+    static const PolicyTags tags;
+    return tags;
+}
+
 
 template<class A>
 SubnetRoute<A>::SubnetRoute(const SubnetRoute<A>& route_to_clone) 
@@ -128,6 +150,28 @@ SubnetRoute<A>::operator==(const SubnetRoute<A>& them) const {
     return true;
 }
 
+template<class A>
+void*
+SubnetRoute<A>::operator new(size_t/* size*/)
+{
+    return memory_pool().alloc();
+}
+
+template<class A>
+void
+SubnetRoute<A>::operator delete(void* ptr)
+{
+    memory_pool().free(ptr);
+}
+
+template<class A>
+MemoryPool<SubnetRoute<A> >&
+SubnetRoute<A>::memory_pool()
+{
+    static MemoryPool<SubnetRoute<A> > mp;
+    return mp;
+}
+
 template<class A>
 SubnetRoute<A>::~SubnetRoute() {
     debug_msg("SubnetRoute destructor called for %p\n", this);
@@ -28,6 +28,7 @@
 #include "libxorp/xorp.h"
 #include "libxorp/ipv4net.hh"
 #include "libxorp/ipv6net.hh"
+#include "libxorp/memory_pool.hh"
 
 #include "policy/backend/policytags.hh"
 #include "policy/backend/policy_filter.hh"
@@ -64,6 +65,7 @@ public:
     RouteMetaData();
 
     ~RouteMetaData() {
+	delete _policytags;
 	// prevent accidental reuse after deletion
 	_flags = 0xffffffff;
     }
@@ -206,7 +208,7 @@ public:
      * @return policy tags associated with route.
      */
     inline const PolicyTags& policytags() const {
-	return _policytags;
+	return _policytags != NULL ? *_policytags : no_policytags();
     }
 
     /**
@@ -214,9 +216,7 @@ public:
      *
      * @param tags new policy tags for route.
      */
-    inline void set_policytags(const PolicyTags& tags) {
-	_policytags = tags;
-    }
+    void set_policytags(const PolicyTags& tags);
 
     inline const RefPf& policyfilter(uint32_t i) const {
 	return _pfilter[i];
@@ -315,8 +315,17 @@ private:
      */
     uint32_t _igp_metric;
 
-    PolicyTags _policytags;
+    /**
+     * Most routes have no policy tags, so they are only allocated for
+     * the routes that do: an empty PolicyTags is bigger than all the
+     * other fields of the route together.
+     */
+    PolicyTags *_policytags;
     RefPf _pfilter[3];
+
+    static const PolicyTags& no_policytags();
+
+    RouteMetaData& operator=(const RouteMetaData&);	// Not implemented
 };
 
 /**
@@ -609,6 +618,9 @@ public:
 	return _metadata.aggr_prefix_len();
     }
 
+    void* operator new(size_t size);
+    void operator delete(void* ptr);
+
 protected:
     /**
      * @short protected SubnetRoute destructor.
@@ -649,6 +661,8 @@ private:
     const SubnetRoute<A> *_parent_route;
 
     mutable RouteMetaData _metadata;
+
+    static MemoryPool<SubnetRoute<A> >& memory_pool();
 };
 
 
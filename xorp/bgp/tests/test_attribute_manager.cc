@@ -0,0 +1,228 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/test_main.hh"
+#include "libxorp/timeval.hh"
+#include "libxorp/timer.hh"
+
+#include "attribute_manager.hh"
+#include "path_attribute.hh"
+
+
+/*
+** Create a PA list that only differs from the others by its MED.
+*/
+static PAListRef<IPv4>
+make_palist(uint32_t med)
+{
+    NextHopAttribute<IPv4> nhatt(IPv4("10.0.0.1"));
+    ASPath aspath("1,2,3");
+    ASPathAttribute aspathatt(aspath);
+    OriginAttribute igp_origin_att(IGP);
+
+    FPAList4Ref fpa_list =
+	new FastPathAttributeList<IPv4>(nhatt, aspathatt, igp_origin_att);
+    MEDAttribute med_att(med);
+    fpa_list->add_path_attribute(med_att);
+
+    return PAListRef<IPv4>(new PathAttributeList<IPv4>(fpa_list));
+}
+
+bool
+test_interning(TestInfo& info)
+{
+    DOUT(info) << "test_interning: " << endl;
+
+    const AttributeManager<IPv4>* mgr = PAListRef<IPv4>::attribute_manager();
+    AttributeManagerStats before = mgr->stats();
+
+    /*
+    ** Three copies of one list, two of another.
+    */
+    PAListRef<IPv4> refs[5];
+    for (int i = 0; i < 5; i++) {
+	refs[i] = make_palist(i < 3 ? 1 : 2);
+	refs[i].register_with_attmgr();
+    }
+
+    AttributeManagerStats st = mgr->stats();
+    size_t len = refs[0]->canonical_length();
+    DOUT(info) << "lists " << st.lists << " references " << st.references
+	       << " bytes " << st.bytes << " shared " << st.bytes_shared
+	       << endl;
+
+    if (refs[0].attributes() != refs[1].attributes()
+	|| refs[0].attributes() != refs[2].attributes()
+	|| refs[3].attributes() != refs[4].attributes()
+	|| refs[0].attributes() == refs[3].attributes()) {
+	DOUT(info) << "Equal lists should be stored once\n";
+	return false;
+    }
+    if (st.lists - before.lists != 2 || st.references - before.references != 5
+	|| st.hits - before.hits != 3 || st.lookups - before.lookups != 5) {
+	DOUT(info) << "Bad counters\n";
+	return false;
+    }
+    if (st.bytes - before.bytes != 2 * len
+	|| st.bytes_shared - before.bytes_shared != 3 * len) {
+	DOUT(info) << "Bad byte counters\n";
+	return false;
+    }
+
+    for (int i = 0; i < 5; i++)
+	refs[i].deregister_with_attmgr();
+
+    st = mgr->stats();
+    if (st.lists != before.lists || st.references != before.references
+	|| st.bytes != before.bytes || st.bytes_shared != before.bytes_shared) {
+	DOUT(info) << "Lists should be released\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_table(TestInfo& info, uint32_t count)
+{
+    DOUT(info) << "test_table: " << endl;
+
+    const AttributeManager<IPv4>* mgr = PAListRef<IPv4>::attribute_manager();
+    int base = mgr->number_of_managed_atts();
+
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    vector<PAListRef<IPv4> > refs;
+    for (uint32_t i = 0; i < count; i++) {
+	refs.push_back(make_palist(i));
+	refs.back().register_with_attmgr();
+    }
+
+    TimerList::system_gettimeofday(&end);
+    DOUT(info) << count << " lists added in " << (end - start).str()
+	       << " seconds" << endl;
+
+    if (mgr->number_of_managed_atts() - base != static_cast<int>(count)) {
+	DOUT(info) << "All lists should be stored\n";
+	return false;
+    }
+
+    /*
+    ** Delete half the lists in a scattered order, then check the
+    ** others can still be found.
+    */
+    uint32_t step = 7919;	// prime, so all the indexes are visited
+    for (uint32_t i = 0, n = 0; n < count / 2; i = (i + step) % count) {
+	if (refs[i].is_empty())
+	    continue;
+	refs[i].deregister_with_attmgr();
+	refs[i].release();
+	n++;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+	if (refs[i].is_empty())
+	    continue;
+	PAListRef<IPv4> copy = make_palist(i);
+	copy.register_with_attmgr();
+	if (copy.attributes() != refs[i].attributes()) {
+	    DOUT(info) << "List " << i << " lost\n";
+	    return false;
+	}
+	copy.deregister_with_attmgr();
+    }
+
+    TimerList::system_gettimeofday(&start);
+
+    for (uint32_t i = 0; i < count; i++) {
+	if (refs[i].is_empty())
+	    continue;
+	refs[i].deregister_with_attmgr();
+    }
+
+    TimerList::system_gettimeofday(&end);
+    DOUT(info) << count / 2 << " lists deleted in " << (end - start).str()
+	       << " seconds" << endl;
+
+    if (mgr->number_of_managed_atts() != base) {
+	DOUT(info) << "All lists should be released\n";
+	return false;
+    }
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    t.complete_args_parsing();
+
+    PAListRef<IPv4> dummy_palist;
+    dummy_palist.create_attribute_manager();
+
+    try {
+	struct test {
+	    string test_name;
+	    XorpCallback1<bool, TestInfo&>::RefPtr cb;
+	} tests[] = {
+	    {"interning", callback(test_interning)},
+	    {"table", callback(test_table, static_cast<uint32_t>(100000))},
+	};
+
+	if("" == test_name) {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	} else {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		if(test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
@@ -64,7 +64,7 @@ test_decision(TestInfo& /*info*/)
 
     comm_init();
 
-    Iptuple iptuple1("3.0.0.127", 179, "2.0.0.1", 179);
+    Iptuple iptuple1("", "3.0.0.127", 179, "2.0.0.1", 179);
     BGPPeerData *peer_data1 =
 	new BGPPeerData(localdata, iptuple1, AsNum(1), IPv4("2.0.0.1"), 30);
     peer_data1->compute_peer_type();
@@ -73,7 +73,7 @@ test_decision(TestInfo& /*info*/)
     BGPPeer peer1(&localdata, peer_data1, NULL, &bgpmain);
     PeerHandler handler1("test1", &peer1, NULL, NULL);
 
-    Iptuple iptuple2("3.0.0.127", 179, "2.0.0.2", 179);
+    Iptuple iptuple2("", "3.0.0.127", 179, "2.0.0.2", 179);
     BGPPeerData *peer_data2 =
 	new BGPPeerData(localdata, iptuple2, AsNum(1), IPv4("2.0.0.2"), 30);
     peer_data2->compute_peer_type();
@@ -82,7 +82,7 @@ test_decision(TestInfo& /*info*/)
     BGPPeer peer2(&localdata, peer_data2, NULL, &bgpmain);
     PeerHandler handler2("test2", &peer2, NULL, NULL);
 
-    Iptuple iptuple3("3.0.0.127", 179, "2.0.0.3", 179);
+    Iptuple iptuple3("", "3.0.0.127", 179, "2.0.0.3", 179);
     BGPPeerData *peer_data3 =
 	new BGPPeerData(localdata, iptuple2, AsNum(1), IPv4("2.0.0.3"), 30);
     peer_data3->compute_peer_type();
@@ -2092,3 +2092,117 @@ test_decision(TestInfo& /*info*/)
 
 
 
+
+/*
+** Time the decision process with many peers sending the same table.
+*/
+bool
+test_decision_benchmark(TestInfo& info, uint32_t peers, uint32_t routes)
+{
+    EventLoop eventloop;
+    BGPMain bgpmain(eventloop);
+    LocalData localdata(bgpmain.eventloop());
+    localdata.set_as(AsNum(1));
+
+    DummyNextHopResolver<IPv4> next_hop_resolver(bgpmain.eventloop(), bgpmain);
+
+    DecisionTable<IPv4> *decision_table
+	= new DecisionTable<IPv4>("DECISION", SAFI_UNICAST, next_hop_resolver);
+
+    DebugTable<IPv4>* debug_table
+	 = new DebugTable<IPv4>("D1", (BGPRouteTable<IPv4>*)decision_table);
+    decision_table->set_next_table(debug_table);
+    FILE* null_file = fopen("/dev/null", "w");
+    debug_table->set_output_file(null_file);
+    debug_table->set_canned_response(ADD_USED);
+
+    vector<BGPPeer*> peer(peers);
+    vector<PeerHandler*> handler(peers);
+    vector<RibInTable<IPv4>*> ribin(peers);
+    vector<NhLookupTable<IPv4>*> nhlookup(peers);
+    vector<FPAList4Ref> fpalist(peers);
+    for (uint32_t i = 0; i < peers; i++) {
+	IPv4 addr(htonl(0x02000001 + i));
+	Iptuple iptuple("", "3.0.0.127", 179, addr.str().c_str(), 179);
+	BGPPeerData *peer_data =
+	    new BGPPeerData(localdata, iptuple, AsNum(100 + i), addr, 30);
+	peer_data->compute_peer_type();
+	peer_data->set_id(addr);
+	peer[i] = new BGPPeer(&localdata, peer_data, NULL, &bgpmain);
+	handler[i] = new PeerHandler("bench", peer[i], NULL, NULL);
+
+	ribin[i] = new RibInTable<IPv4>("RIB-IN", SAFI_UNICAST, handler[i]);
+	nhlookup[i] = new NhLookupTable<IPv4>("NHL-IN", SAFI_UNICAST,
+					      &next_hop_resolver, ribin[i]);
+	ribin[i]->set_next_table(nhlookup[i]);
+	nhlookup[i]->set_next_table(decision_table);
+	decision_table->add_parent(nhlookup[i], handler[i], ribin[i]->genid());
+
+	// The AS path length spreads the winners over the peers
+	next_hop_resolver.set_nexthop_metric(addr, 27);
+	NextHopAttribute<IPv4> nhatt(addr);
+	ASPath aspath;
+	for (uint32_t j = 0; j < 2 + (i * 7) % 5; j++)
+	    aspath.prepend_as(AsNum(1000 + i));
+	ASPathAttribute aspathatt(aspath);
+	OriginAttribute igp_origin_att(IGP);
+	fpalist[i] =
+	    new FastPathAttributeList<IPv4>(nhatt, aspathatt, igp_origin_att);
+	LocalPrefAttribute lpa(100);
+	fpalist[i]->add_path_attribute(lpa);
+    }
+
+    PolicyTags pt;
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    for (uint32_t i = 0; i < peers; i++) {
+	for (uint32_t r = 0; r < routes; r++) {
+	    IPNet<IPv4> net(IPv4(htonl(0x0a000000 + (r << 8))), 24);
+	    FPAList4Ref fpa = new FastPathAttributeList<IPv4>(*fpalist[i]);
+	    ribin[i]->add_route(net, fpa, pt);
+	}
+	ribin[i]->push(NULL);
+    }
+
+    TimerList::system_gettimeofday(&end);
+    DOUT(info) << peers << " peers, " << routes << " routes each, added in "
+	       << (end - start).str() << " seconds" << endl;
+
+    TimerList::system_gettimeofday(&start);
+
+    for (uint32_t i = 0; i < peers; i++) {
+	for (uint32_t r = 0; r < routes; r++) {
+	    IPNet<IPv4> net(IPv4(htonl(0x0a000000 + (r << 8))), 24);
+	    ribin[i]->delete_route(net);
+	}
+	ribin[i]->push(NULL);
+    }
+
+    TimerList::system_gettimeofday(&end);
+    DOUT(info) << peers << " peers, " << routes << " routes each, deleted in "
+	       << (end - start).str() << " seconds" << endl;
+
+    uint32_t genid;
+    FPAList4Ref pa_list;
+    bool empty = decision_table->lookup_route(IPNet<IPv4>("10.0.0.0/24"),
+					      genid, pa_list) == NULL;
+
+    for (uint32_t i = 0; i < peers; i++) {
+	delete ribin[i];
+	delete nhlookup[i];
+	delete handler[i];
+	delete peer[i];
+	fpalist[i].release();
+    }
+    delete decision_table;
+    delete debug_table;
+    fclose(null_file);
+
+    if (!empty) {
+	DOUT(info) << "Routes left behind\n";
+	return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,249 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/test_main.hh"
+
+#include "local_data.hh"
+#include "packet.hh"
+#include "path_attribute.hh"
+#include "encoding_cache.hh"
+
+
+/*
+** A path attribute list with the AS path <as>, 2, which can only be
+** encoded for an old peer with an AS4_PATH if <as> is a 4 byte AS.
+*/
+static FPAList4Ref
+make_pa_list(uint32_t as)
+{
+    FPAList4Ref fpa_list = new FastPathAttributeList<IPv4>();
+
+    NextHopAttribute<IPv4> nexthop_att(IPv4("10.0.0.1"));
+    fpa_list->add_path_attribute(nexthop_att);
+
+    ASSegment seq = ASSegment(AS_SEQUENCE);
+    seq.add_as(AsNum(as));
+    seq.add_as(AsNum(2));
+    ASPath aspath;
+    aspath.add_segment(seq);
+    ASPathAttribute aspath_att(aspath);
+    fpa_list->add_path_attribute(aspath_att);
+
+    OriginAttribute origin_att(IGP);
+    fpa_list->add_path_attribute(origin_att);
+
+    return fpa_list;
+}
+
+static BGPPeerData*
+make_peerdata(LocalData& localdata, const char* addr, bool use_4byte_asnums)
+{
+    Iptuple iptuple("", "10.0.0.1", 179, addr, 179);
+    BGPPeerData* pd = new BGPPeerData(localdata, iptuple, AsNum(1),
+				      IPv4(), 0);
+    pd->compute_peer_type();
+    pd->set_use_4byte_asnums(use_4byte_asnums);
+
+    return pd;
+}
+
+/*
+** The attributes from the cache must be those the list encodes to.
+*/
+static bool
+check_encoding(TestInfo& info, AttributeEncodingCache& cache,
+	       const FPAList4Ref& pa_list, const BGPPeerData* pd)
+{
+    uint8_t buf[BGPPacket::MAXPACKETSIZE];
+    size_t len = BGPPacket::MAXPACKETSIZE;
+    XLOG_ASSERT(pa_list->encode(buf, len, pd));
+
+    size_t cached_len = BGPPacket::MAXPACKETSIZE;
+    const uint8_t* cached = cache.encode(pa_list, cached_len, pd);
+    if (cached == NULL || cached_len != len
+	|| memcmp(buf, cached, len) != 0) {
+	DOUT(info) << "Cached encoding differs\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_hits(TestInfo& info, LocalData* localdata)
+{
+    DOUT(info) << "test_hits: " << endl;
+
+    BGPPeerData* pd2 = make_peerdata(*localdata, "10.0.0.2", false);
+    BGPPeerData* pd4 = make_peerdata(*localdata, "10.0.0.3", true);
+    AttributeEncodingCache cache;
+
+    /*
+    ** A copy of a list is found in the cache, for a peer with the
+    ** same profile only.
+    */
+    FPAList4Ref a = make_pa_list(70000);
+    FPAList4Ref b = make_pa_list(70000);
+    if (!check_encoding(info, cache, a, pd2)
+	|| !check_encoding(info, cache, b, pd2))
+	return false;
+    DOUT(info) << cache.str() << endl;
+    if (cache.stats().misses != 1 || cache.stats().hits != 1) {
+	DOUT(info) << "The copy should have been found\n";
+	return false;
+    }
+
+    if (!check_encoding(info, cache, a, pd4))
+	return false;
+    if (cache.stats().misses != 2) {
+	DOUT(info) << "A peer with another profile should miss\n";
+	return false;
+    }
+
+    /*
+    ** A list that has been changed is encoded again.
+    */
+    b->replace_AS_path(ASPath("1,3"));
+    if (!check_encoding(info, cache, b, pd2))
+	return false;
+    if (cache.stats().misses != 3) {
+	DOUT(info) << "A changed list should miss\n";
+	return false;
+    }
+
+    /*
+    ** Every list is encoded when the cache is disabled.
+    */
+    cache.set_enabled(false);
+    cache.reset_stats();
+    if (!check_encoding(info, cache, a, pd2))
+	return false;
+    if (cache.stats().hits != 0) {
+	DOUT(info) << "A disabled cache should not be used\n";
+	return false;
+    }
+
+    delete pd2;
+    delete pd4;
+
+    return true;
+}
+
+bool
+test_replace(TestInfo& info, LocalData* localdata)
+{
+    DOUT(info) << "test_replace: " << endl;
+
+    BGPPeerData* pd = make_peerdata(*localdata, "10.0.0.2", true);
+    AttributeEncodingCache cache;
+
+    /*
+    ** More lists than slots: the entries are replaced, and every
+    ** lookup still returns the right attributes.
+    */
+    uint32_t lists = 2 * AttributeEncodingCache::SLOTS;
+    for (uint32_t as = 1; as <= lists; as++) {
+	if (!check_encoding(info, cache, make_pa_list(as), pd))
+	    return false;
+    }
+    for (uint32_t as = 1; as <= lists; as += 97) {
+	if (!check_encoding(info, cache, make_pa_list(as), pd))
+	    return false;
+    }
+    DOUT(info) << cache.str() << endl;
+
+    if (cache.stats().replaced == 0) {
+	DOUT(info) << "Entries should have been replaced\n";
+	return false;
+    }
+
+    /*
+    ** The attributes must fit in the space given.
+    */
+    FPAList4Ref pa_list = make_pa_list(1);
+    size_t len = 4;
+    if (cache.encode(pa_list, len, pd) != NULL) {
+	DOUT(info) << "The attributes should not fit\n";
+	return false;
+    }
+
+    delete pd;
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    EventLoop eventloop;
+    LocalData localdata(eventloop);
+    localdata.set_as(AsNum(1)); // IBGP
+    localdata.set_use_4byte_asnums(true);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    t.complete_args_parsing();
+
+    try {
+	struct test {
+	    string test_name;
+	    XorpCallback1<bool, TestInfo&>::RefPtr cb;
+	} tests[] = {
+	    {"hits", callback(test_hits, &localdata)},
+	    {"replace", callback(test_replace, &localdata)},
+	};
+
+	if("" == test_name) {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	} else {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		if(test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
@@ -38,6 +38,7 @@ bool test_policy_dump(TestInfo& info);
 bool test_cache(TestInfo& info);
 bool test_nhlookup(TestInfo& info);
 bool test_decision(TestInfo& info);
+bool test_decision_benchmark(TestInfo& info, uint32_t peers, uint32_t routes);
 bool test_fanout(TestInfo& info);
 bool test_dump_create(TestInfo& info);
 bool test_dump(TestInfo& info);
@@ -123,6 +124,8 @@ main(int argc, char** argv)
 
     string test_name =
 	t.get_optional_args("-t", "--test", "run only the specified test");
+    bool run_benchmarks =
+	t.get_optional_flag("-b", "--benchmarks", "also run the benchmarks");
     t.complete_args_parsing();
 
     try {
@@ -192,12 +195,35 @@ main(int argc, char** argv)
 	    {"nhr.test9", callback(nhr_test9<IPv4>, nh4, rnh4, nlri4, iter)},
 	    {"nhr.test9.ipv6", callback(nhr_test9<IPv6>, nh6, rnh6, nlri6,
 					iter)},
+
+	    {"nhr.test10", callback(nhr_test10<IPv4>, nh4, rnh4, nlri4, iter)},
+	    {"nhr.test10.ipv6", callback(nhr_test10<IPv6>, nh6, rnh6, nlri6,
+					 iter)},
+
+	    {"nhr.test11", callback(nhr_test11<IPv4>, nh4, rnh4, nlri4)},
+	    {"nhr.test11.ipv6", callback(nhr_test11<IPv6>, nh6, rnh6, nlri6)},
+
+	    {"nhr.test12", callback(nhr_test12<IPv4>, nh4, rnh4, nlri4)},
+	    {"nhr.test12.ipv6", callback(nhr_test12<IPv6>, nh6, rnh6, nlri6)},
+	};
+
+	/*
+	** Only run with -b, or when named with -t.
+	*/
+	struct test benchmarks[] = {
+	    {"DecisionBenchmark", callback(test_decision_benchmark,
+					   static_cast<uint32_t>(50),
+					   static_cast<uint32_t>(10000))},
 	};
 
 	if("" == test_name) {
 	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test); 
 		i++)
 		t.run(tests[i].test_name, tests[i].cb);
+	    if (run_benchmarks)
+		for(unsigned int i = 0;
+		    i < sizeof(benchmarks) / sizeof(struct test); i++)
+		    t.run(benchmarks[i].test_name, benchmarks[i].cb);
 	} else {
 	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test); 
 		i++)
@@ -205,6 +231,12 @@ main(int argc, char** argv)
 		    t.run(tests[i].test_name, tests[i].cb);
 		    return t.exit();
 		}
+	    for(unsigned int i = 0;
+		i < sizeof(benchmarks) / sizeof(struct test); i++)
+		if(test_name == benchmarks[i].test_name) {
+		    t.run(benchmarks[i].test_name, benchmarks[i].cb);
+		    return t.exit();
+		}
 	    t.failed("No test with name " + test_name + " found\n");
 	}
     } catch(...) {
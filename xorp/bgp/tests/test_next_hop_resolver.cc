@@ -47,12 +47,13 @@ public:
     }
 
     void
-    RIB_lookup_done(const A& /*nexthop*/,
+    RIB_lookup_done(const A& nexthop,
 		    const set <IPNet<A> >& /*nets*/,
 		    bool /*lookup_succeeded*/)
     {
 	DOUT(_info) << "Rib lookup done\n";
 	_done = true;
+	_nexthops.insert(nexthop);
     }
 
     bool
@@ -60,8 +61,19 @@ public:
 	return _done;
     }
 
+    bool
+    done(const A& nexthop) {
+	return _nexthops.find(nexthop) != _nexthops.end();
+    }
+
+    size_t
+    done_count() {
+	return _nexthops.size();
+    }
+
 private:
     bool _done;
+    set<A> _nexthops;
     TestInfo& _info;
 };
 
@@ -108,6 +120,44 @@ public:
     }
 };
 
+/**
+ * Answer a batch of registrations as the RIB's bulk_register_interest
+ * would, with the same answer for each of the <nexthops> next hops of
+ * the batch.
+ */
+template <class A>
+void
+register_answer(NextHopRibRequest<A> *next_hop_rib_request, uint32_t batch,
+		size_t nexthops, bool resolves, A addr, uint32_t prefix_len,
+		uint32_t real_prefix_len, A actual_nexthop, uint32_t metric)
+{
+    XrlAtomList resolves_list;
+    XrlAtomList addrs;
+    XrlAtomList prefix_lens;
+    XrlAtomList real_prefix_lens;
+    XrlAtomList actual_nexthops;
+    XrlAtomList metrics;
+
+    for(size_t i = 0; i < nexthops; i++) {
+	resolves_list.append(XrlAtom(resolves));
+	addrs.append(XrlAtom(addr));
+	prefix_lens.append(XrlAtom(prefix_len));
+	real_prefix_lens.append(XrlAtom(real_prefix_len));
+	actual_nexthops.append(XrlAtom(actual_nexthop));
+	metrics.append(XrlAtom(metric));
+    }
+
+    next_hop_rib_request->register_interests_response(XrlError::OKAY(),
+						      &resolves_list,
+						      &addrs,
+						      &prefix_lens,
+						      &real_prefix_lens,
+						      &actual_nexthops,
+						      &metrics,
+						      batch,
+						      "testing");
+}
+
 /**
  * Register interest in a nexthop
  */
@@ -144,17 +194,9 @@ nhr_test1(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback went all the way to the next hop
     ** table. This must be true before a lookup will succeed.
@@ -235,17 +277,9 @@ nhr_test2(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet, int reg)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback went all the way to the next hop
     ** table. This must be true before a lookup will succeed.
@@ -327,17 +361,9 @@ nhr_test3(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet, int reg)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback went all the way to the next hop
     ** table. This must be true before a lookup will succeed.
@@ -431,17 +457,9 @@ nhr_test4(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** We have deregistered interest in this nexthop we should not get
     ** this callback.
@@ -518,17 +536,9 @@ nhr_test5(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback went all the way to the next hop
     ** table. This must be true before a lookup will succeed.
@@ -570,15 +580,8 @@ nhr_test5(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     ** Respond to the second request that should have been made.
     */
     metric++;	// Change metric to defeat no change optimisation.
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+    register_answer(next_hop_rib_request, 1, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
 
     /*
     ** Verify that we called the decision process with the new
@@ -663,17 +666,9 @@ nhr_test6(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback did not get back to the next hop table.
     */
@@ -741,17 +736,9 @@ nhr_test7(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback went all the way to the next hop
     ** table. This must be true before a lookup will succeed.
@@ -798,15 +785,8 @@ nhr_test7(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     ** Respond to the second request that should have been made.
     */
     metric++;	// Change metric to defeat no change optimisation.
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+    register_answer(next_hop_rib_request, 1, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
 
     /*
     ** Verify that we don't call back to the decision table.
@@ -871,17 +851,9 @@ nhr_test8(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     uint32_t real_prefix_len = 16;
     A addr = nexthop.mask_by_prefix_len(prefix_len);
     uint32_t metric = 1;
-    string comment = "testing";
-
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+
+    register_answer(next_hop_rib_request, 0, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
     /*
     ** Verify that the callback went all the way to the next hop
     ** table. This must be true before a lookup will succeed.
@@ -909,15 +881,8 @@ nhr_test8(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     /*
     ** Respond to the second request that should have been made.
     */
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+    register_answer(next_hop_rib_request, 1, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
 
     /*
     ** The metrics haven't changed we shouldn't call back to the
@@ -967,15 +932,8 @@ nhr_test8(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     ** Respond to the second request that should have been made.
     */
     metric++;	// Change the metric
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+    register_answer(next_hop_rib_request, 2, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
 
     /*
     ** The metrics haven't changed we shouldn't call back to the
@@ -1022,15 +980,8 @@ nhr_test8(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     ** Respond to the second request that should have been made.
     */
     resolves = true;
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+    register_answer(next_hop_rib_request, 3, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
 
     /*
     ** The next hop now resolves we expect a callback to the decison process.
@@ -1077,15 +1028,8 @@ nhr_test8(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
     */
     dt.clear();
     metric++;
-    next_hop_rib_request->register_interest_response(XrlError::OKAY(),
-						     &resolves,
-						     &addr,
-						     &prefix_len,
-						     &real_prefix_len,
-						     &real_nexthop,
-						     &metric,
-						     nexthop,
-						     comment);
+    register_answer(next_hop_rib_request, 4, 1, resolves, addr,
+		    prefix_len, real_prefix_len, real_nexthop, metric);
 
     /*
     ** The next hop now resolves we expect a callback to the decison process.
@@ -1167,6 +1111,260 @@ nhr_test9(TestInfo& info, A nexthop, A /*real_nexthop*/, IPNet<A> subnet,
     return true;
 }
 
+/**
+ * Register interest in many nexthops in the same subnet at once, as
+ * happens at startup. More requests are queued than fit in the window
+ * of outstanding batches, the first answer should satisfy the requests
+ * that have not been sent yet.
+ */
+template <class A>
+bool
+nhr_test10(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet, int reg)
+{
+    DOUT(info) << "nexthop: " << nexthop.str() << endl;
+
+    EventLoop eventloop;
+    BGPMain bgp(eventloop);
+    DummyNextHopResolver2<A> nhr = DummyNextHopResolver2<A>(eventloop, bgp);
+
+    DummyNhLookupTable<A> nht(info, &nhr);
+
+    /*
+    ** Register interest in "reg" distinct nexthops.
+    */
+    vector<A> nexthops;
+    A nh = nexthop;
+    for(int i = 0; i < reg; i++) {
+	nexthops.push_back(nh);
+	nhr.register_nexthop(nh, subnet, &nht);
+	++nh;
+    }
+
+    NextHopRibRequest<A> *next_hop_rib_request =
+	nhr.get_next_hop_rib_request();
+
+    bool resolves = true;
+    uint32_t prefix_len = 16;
+    uint32_t real_prefix_len = 16;
+    A addr = nexthop.mask_by_prefix_len(prefix_len);
+    uint32_t metric = 1;
+
+    /*
+    ** Answer the requests that are still outstanding, the answers
+    ** all cover the same subnet.
+    */
+    int answers = 0;
+    for(int i = 0; i < reg; i++) {
+	if(nht.done(nexthops[i]))
+	    continue;
+	A ni = nexthops[i];
+	register_answer(next_hop_rib_request, answers, 1, resolves, addr,
+			prefix_len, real_prefix_len, real_nexthop, metric);
+	answers++;
+	if(!nht.done(ni)) {
+	    DOUT(info) << "Callback to next hop table failed " << ni.str()
+		       << endl;
+	    return false;
+	}
+    }
+
+    if(static_cast<int>(nht.done_count()) != reg) {
+	DOUT(info) << "Only " << nht.done_count() << " of " << reg
+		   << " callbacks made\n";
+	return false;
+    }
+
+    /*
+    ** Requests that were never sent should have been satisfied by the
+    ** cache.
+    */
+    DOUT(info) << answers << " answers for " << reg << " nexthops\n";
+    if(answers >= reg) {
+	DOUT(info) << "Every nexthop needed an answer\n";
+	return false;
+    }
+
+    for(int i = 0; i < reg; i++) {
+	bool res;
+	uint32_t met;
+	if(!nhr.lookup(nexthops[i], res, met) || res != resolves ||
+	   met != metric) {
+	    DOUT(info) << "Nexthop " << nexthops[i].str() << " not in table?\n";
+	    return false;
+	}
+    }
+
+    for(int i = 0; i < reg; i++)
+	nhr.deregister_nexthop(nexthops[i], subnet, &nht);
+
+    bool res;
+    uint32_t met;
+    if(nhr.lookup(nexthop, res, met)) {
+	DOUT(info) << "Nexthop in table?\n";
+	return false;
+    }
+
+    return true;
+}
+
+/**
+ * Register interest in two nexthops in different subnets, so that
+ * they are sent in two batches, and have the RIB answer the second
+ * batch first.
+ */
+template <class A>
+bool
+nhr_test11(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
+{
+    DOUT(info) << "nexthop: " << nexthop.str() << endl;
+
+    EventLoop eventloop;
+    BGPMain bgp(eventloop);
+    DummyNextHopResolver2<A> nhr = DummyNextHopResolver2<A>(eventloop, bgp);
+
+    DummyNhLookupTable<A> nht(info, &nhr);
+
+    /*
+    ** The other nexthop differs in the last bit of the subnet.
+    */
+    uint32_t prefix_len = 16;
+    A other = nexthop ^ (A::make_prefix(prefix_len) &
+			 ~A::make_prefix(prefix_len - 1));
+
+    nhr.register_nexthop(nexthop, subnet, &nht);
+    nhr.register_nexthop(other, subnet, &nht);
+
+    NextHopRibRequest<A> *next_hop_rib_request =
+	nhr.get_next_hop_rib_request();
+
+    /*
+    ** The answer to the second batch arrives first.
+    */
+    register_answer(next_hop_rib_request, 1, 1, true,
+		    other.mask_by_prefix_len(prefix_len),
+		    prefix_len, prefix_len, real_nexthop, 2);
+    if(!nht.done(other) || nht.done(nexthop)) {
+	DOUT(info) << "Wrong nexthop completed\n";
+	return false;
+    }
+
+    register_answer(next_hop_rib_request, 0, 1, true,
+		    nexthop.mask_by_prefix_len(prefix_len),
+		    prefix_len, prefix_len, real_nexthop, 1);
+    if(!nht.done(nexthop)) {
+	DOUT(info) << "Callback to next hop table failed\n";
+	return false;
+    }
+
+    bool res;
+    uint32_t met;
+    if(!nhr.lookup(nexthop, res, met) || !res || met != 1) {
+	DOUT(info) << "Nexthop " << nexthop.str() << " not in table?\n";
+	return false;
+    }
+    if(!nhr.lookup(other, res, met) || !res || met != 2) {
+	DOUT(info) << "Nexthop " << other.str() << " not in table?\n";
+	return false;
+    }
+
+    nhr.deregister_nexthop(nexthop, subnet, &nht);
+    nhr.deregister_nexthop(other, subnet, &nht);
+
+    if(nhr.lookup(nexthop, res, met) || nhr.lookup(other, res, met)) {
+	DOUT(info) << "Nexthop in table?\n";
+	return false;
+    }
+
+    return true;
+}
+
+/**
+ * 1) Register interest in two nexthops in the same subnet, which are
+ * sent in two batches.
+ * 2) The answer to the first batch covers both.
+ * 3) Deregister the first nexthop before the second answer arrives,
+ * the deregistration of the subnet is held back.
+ * 4) The RIB answers the second batch with a more specific subnet.
+ *
+ * Nothing uses the registration of the first subnet any more, it must
+ * be deregistered rather than leaked.
+ */
+template <class A>
+bool
+nhr_test12(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet)
+{
+    DOUT(info) << "nexthop: " << nexthop.str() << endl;
+
+    EventLoop eventloop;
+    BGPMain bgp(eventloop);
+    DummyNextHopResolver2<A> nhr = DummyNextHopResolver2<A>(eventloop, bgp);
+
+    DummyNhLookupTable<A> nht(info, &nhr);
+
+    A second = nexthop;
+    ++second;
+
+    nhr.register_nexthop(nexthop, subnet, &nht);
+    nhr.register_nexthop(second, subnet, &nht);
+
+    NextHopRibRequest<A> *next_hop_rib_request =
+	nhr.get_next_hop_rib_request();
+
+    uint32_t prefix_len = 16;
+    A addr = nexthop.mask_by_prefix_len(prefix_len);
+    register_answer(next_hop_rib_request, 0, 1, true, addr,
+		    prefix_len, prefix_len, real_nexthop, 1);
+    if(!nht.done(nexthop)) {
+	DOUT(info) << "Callback to next hop table failed\n";
+	return false;
+    }
+
+    nhr.deregister_nexthop(nexthop, subnet, &nht);
+
+    uint32_t specific_len = prefix_len + 8;
+    register_answer(next_hop_rib_request, 1, 1, true,
+		    second.mask_by_prefix_len(specific_len),
+		    specific_len, specific_len, real_nexthop, 2);
+    if(!nht.done(second)) {
+	DOUT(info) << "Callback to next hop table failed\n";
+	return false;
+    }
+
+    bool res;
+    uint32_t met;
+    if(!nhr.lookup(second, res, met) || !res || met != 2) {
+	DOUT(info) << "Nexthop " << second.str() << " not in table?\n";
+	return false;
+    }
+
+    /*
+    ** The deregistration of the first subnet should now be in flight,
+    ** so an invalidate of the subnet from the RIB is expected.
+    */
+    if(!nhr.rib_client_route_info_invalid(addr, prefix_len)) {
+	DOUT(info) << "The first subnet was not deregistered\n";
+	return false;
+    }
+
+    /*
+    ** The RIB has already dropped the registration it invalidated.
+    */
+    XrlAtomList deregistered;
+    deregistered.append(XrlAtom(false));
+    next_hop_rib_request->deregister_interests_response(XrlError::OKAY(),
+							&deregistered, 2,
+							"testing");
+
+    nhr.deregister_nexthop(second, subnet, &nht);
+
+    if(nhr.lookup(second, res, met)) {
+	DOUT(info) << "Nexthop in table?\n";
+	return false;
+    }
+
+    return true;
+}
+
 /*
 ** This function is never called it exists to instantiate the
 ** templatised functions.
@@ -1202,4 +1400,13 @@ dummy()
 
     callback(nhr_test9<IPv4>);
     callback(nhr_test9<IPv6>);
+
+    callback(nhr_test10<IPv4>);
+    callback(nhr_test10<IPv6>);
+
+    callback(nhr_test11<IPv4>);
+    callback(nhr_test11<IPv6>);
+
+    callback(nhr_test12<IPv4>);
+    callback(nhr_test12<IPv6>);
 }
@@ -64,4 +64,16 @@ template <class A>
 bool
 nhr_test9(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet, int reg);
 
+template <class A>
+bool
+nhr_test10(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet, int reg);
+
+template <class A>
+bool
+nhr_test11(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet);
+
+template <class A>
+bool
+nhr_test12(TestInfo& info, A nexthop, A real_nexthop, IPNet<A> subnet);
+
 #endif // __BGP_TEST_NEXT_HOP_RESOLVER_HH__
@@ -837,6 +837,193 @@ test_announce_packet2(TestInfo& info, BGPPeer* peer)
     return true;
 }
 
+/*
+** An UPDATE with <withdrawn> withdrawn routes and <nlri> NLRI, the
+** last NLRI repeated if <duplicate>, encoded for a peer.
+*/
+static void
+make_update(const BGPPeerData* pd, uint32_t withdrawn, uint32_t nlri,
+	    bool duplicate, uint8_t* buf, size_t& len)
+{
+    UpdatePacket updatepacket;
+    FPAList4Ref fpa_list = updatepacket.pa_list();
+
+    // 11.0.0.0/24, 11.0.1.0/24... then 12.0.0.0/24, 12.0.1.0/24...
+    for (uint32_t i = 0; i < withdrawn; i++)
+	updatepacket.add_withdrawn(IPv4Net(IPv4(htonl(0x0b000000 | i << 8)),
+					   24));
+    for (uint32_t i = 0; i < nlri; i++)
+	updatepacket.add_nlri(IPv4Net(IPv4(htonl(0x0c000000 | i << 8)), 24));
+    if (duplicate && nlri > 0)
+	updatepacket.add_nlri(IPv4Net(IPv4(htonl(0x0c000000 | (nlri - 1) << 8)),
+				      24));
+
+    NextHopAttribute<IPv4> nexthop_att(IPv4("10.0.0.1"));
+    fpa_list->add_path_attribute(nexthop_att);
+    ASPathAttribute aspath_att(ASPath("1,2,3,4,5"));
+    fpa_list->add_path_attribute(aspath_att);
+    OriginAttribute origin_att(IGP);
+    fpa_list->add_path_attribute(origin_att);
+    LocalPrefAttribute local_pref_att(237);
+    fpa_list->add_path_attribute(local_pref_att);
+    MEDAttribute med_att(515);
+    fpa_list->add_path_attribute(med_att);
+    CommunityAttribute com_att;
+    com_att.add_community(57);
+    com_att.add_community(58);
+    com_att.add_community(59);
+    fpa_list->add_path_attribute(com_att);
+
+    len = BGPPacket::MAXPACKETSIZE;
+    assert(updatepacket.encode(buf, len, pd));
+}
+
+/*
+** Do with the routes of a packet what the PeerHandler and the
+** plumbing do: copy the attributes into a list for the AFI/SAFI, copy
+** that list for each NLRI, canonicalize it for the RibIn and look at
+** the nexthop and the AS path.
+*/
+template <class I>
+static size_t
+receive_routes(I ni, I end, FPAList4Ref& pa_list, vector<string>* canonical)
+{
+    size_t routes = 0;
+    for (; ni != end; ++ni) {
+	FPAList4Ref fpalist = new FastPathAttributeList<IPv4>(*pa_list);
+	fpalist->canonicalize();
+	assert(fpalist->nexthop_att() != 0 && fpalist->aspath_att() != 0);
+	if (canonical != 0)
+	    canonical->push_back(ni->net().str() + " " +
+				 string((const char*)fpalist->canonical_data(),
+					fpalist->canonical_length()));
+	routes++;
+    }
+
+    return routes;
+}
+
+static size_t
+receive(UpdatePacket& p, vector<string>* canonical = 0)
+{
+    FPAList4Ref pa_list = p.pa_list();
+    FPAList4Ref pa_ipv4_unicast = new FastPathAttributeList<IPv4>();
+    for (int i = 0; i < pa_list->max_att(); i++)
+	if (pa_list->find_attribute_by_type((PathAttType)i))
+	    pa_ipv4_unicast->copy_path_attribute(*pa_list, (PathAttType)i);
+
+    if (p.in_place())
+	return receive_routes(p.nlri_wire().begin(), p.nlri_wire().end(),
+			      pa_ipv4_unicast, canonical);
+    return receive_routes(p.nlri_list().begin(), p.nlri_list().end(),
+			  pa_ipv4_unicast, canonical);
+}
+
+static BGPPeerData*
+make_peerdata(LocalData& localdata, bool use_4byte_asnums)
+{
+    Iptuple iptuple;
+    BGPPeerData* pd = new BGPPeerData(localdata, iptuple, AsNum(0), IPv4(), 0);
+    pd->compute_peer_type();
+    pd->set_use_4byte_asnums(use_4byte_asnums);
+
+    return pd;
+}
+
+bool
+test_in_place(TestInfo& info, BGPPeer* peer)
+{
+    DOUT(info) << "test_in_place: " << endl;
+
+    LocalData localdata(peer->main()->eventloop());
+    localdata.set_as(AsNum(0)); // IBGP
+    localdata.set_use_4byte_asnums(true);
+
+    for (int four = 0; four <= 1; four++) {
+	BGPPeerData* pd = make_peerdata(localdata, four == 1);
+	uint8_t buf[BGPPacket::MAXPACKETSIZE];
+	size_t len;
+	make_update(pd, 3, 10, false, buf, len);
+
+	UpdatePacket eager(buf, len, pd, peer->main(), true);
+	UpdatePacket lazy(buf, len, pd, peer->main(), true, true);
+	assert(!eager.in_place());
+	assert(lazy.in_place());
+	assert(lazy.nlri_count() == 10 && lazy.wr_wire().size() == 3);
+
+	// The routes are the same, with the same attributes.
+	vector<string> eager_routes, lazy_routes;
+	receive(eager, &eager_routes);
+	receive(lazy, &lazy_routes);
+	if (eager_routes != lazy_routes) {
+	    DOUT(info) << "The routes decoded in place differ\n";
+	    return false;
+	}
+
+	BGPUpdateAttribList::const_iterator i = eager.wr_list().begin();
+	BGPUpdateAttribWire::const_iterator w = lazy.wr_wire().begin();
+	for (; i != eager.wr_list().end(); ++i, ++w)
+	    assert(w != lazy.wr_wire().end() && i->net() == w->net());
+	assert(w == lazy.wr_wire().end());
+
+	// The lists are decoded when they are asked for.
+	assert(lazy.nlri_list() == eager.nlri_list());
+	assert(!lazy.in_place());
+	assert(lazy == eager);
+
+	// The lists drop duplicates, so they are decoded at once.
+	make_update(pd, 0, 10, true, buf, len);
+	UpdatePacket dup(buf, len, pd, peer->main(), true, true);
+	assert(!dup.in_place());
+	assert(dup.nlri_list().size() == 10);
+
+	delete pd;
+    }
+
+    return true;
+}
+
+bool
+test_in_place_speed(TestInfo& info, BGPPeer* peer)
+{
+    DOUT(info) << "test_in_place_speed: " << endl;
+
+    LocalData localdata(peer->main()->eventloop());
+    localdata.set_as(AsNum(0)); // IBGP
+    localdata.set_use_4byte_asnums(true);
+    BGPPeerData* pd = make_peerdata(localdata, true);
+
+    const uint32_t messages = 20000;
+    uint32_t nlris[] = { 1, 10, 100 };
+    for (size_t n = 0; n < sizeof(nlris) / sizeof(nlris[0]); n++) {
+	uint8_t buf[BGPPacket::MAXPACKETSIZE];
+	size_t len;
+	make_update(pd, 2, nlris[n], false, buf, len);
+
+	double rate[2];
+	for (int in_place = 0; in_place <= 1; in_place++) {
+	    TimeVal start, end;
+	    TimerList::system_gettimeofday(&start);
+	    size_t routes = 0;
+	    for (uint32_t i = 0; i < messages; i++) {
+		UpdatePacket p(buf, len, pd, peer->main(), true, in_place);
+		routes += receive(p);
+	    }
+	    TimerList::system_gettimeofday(&end);
+	    assert(routes == messages * nlris[n]);
+	    rate[in_place] = messages / (end - start).get_double();
+	}
+	DOUT(info) << nlris[n] << " NLRI: "
+		   << c_format("%.0f", rate[0]) << " messages/sec decoded, "
+		   << c_format("%.0f", rate[1]) << " messages/sec in place"
+		   << endl;
+    }
+
+    delete pd;
+
+    return true;
+}
+
 int
 main(int argc, char** argv) 
 {
@@ -904,6 +1091,8 @@ main(int argc, char** argv)
 	    {"withdraw_packet", callback(test_withdraw_packet, &peer)},
 	    {"announce_packet1", callback(test_announce_packet1, &peer)},
 	    {"announce_packet2", callback(test_announce_packet2, &peer)},
+	    {"in_place", callback(test_in_place, &peer)},
+	    {"in_place_speed", callback(test_in_place_speed, &peer)},
 	};
 
 	if("" == test_name) {
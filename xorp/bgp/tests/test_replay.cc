@@ -0,0 +1,2107 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/test_main.hh"
+#include "libxorp/timeval.hh"
+#include "libxorp/timer.hh"
+
+#include "libxipc/finder_server.hh"
+
+#include "policy/backend/version_filters.hh"
+#include "policy/backend/policy_filter.hh"
+
+#include <new>
+
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+#include "bgp.hh"
+#include "plumbing.hh"
+#include "dummy_next_hop_resolver.hh"
+#include "encoding_cache.hh"
+#include "harness/mrtd.hh"
+
+// Implementation Notes:
+//
+// A benchmark of the route tables, run without a network, a RIB or a
+// running finder.  The same table dump, update stream and withdrawal
+// of all the routes are replayed from each of a number of EBGP peers,
+// through PeerHandler::process_update_packet() into a BGPPlumbing
+// with a stub next hop resolver.  The RIB is a RibIpcHandler that
+// counts the routes it is given, and the peers encode the UPDATEs
+// they are sent and drop them.
+//
+// Without -d or -u the workload is synthetic.  The MRT files are
+// decoded as received from a peer without 4-byte AS numbers, and the
+// first AS of each path, that of the peer they were recorded from, is
+// replaced by the AS of each replay peer.  From this directory,
+//
+//	./test_replay -t replay -u ../../../data/bgp/icsi1.mrtd
+//
+// replays the 4778 UPDATEs recorded in icsi1.mrtd, 17886 routes, from
+// each peer.  Only the replay test reads an update stream.
+//
+// The install test times a full table, and its withdrawal, from the
+// peers to a stub RIB target over XRLs.  The RibIpcHandler registers
+// with the target as it would with the RIB, and the target counts and
+// acknowledges the route changes without installing them.
+//
+// The encode test times the encoding of the UPDATEs of full table
+// dumps, with and without the cache of encoded path attributes.
+//
+// The damping test flaps every route until it is damped, from a
+// single peer, and times the flaps and the release of the routes once
+// their reuse time has passed.  The damping_late test damps routes
+// while the reuse timer is running late, and checks they are released.
+//
+// The policy test edits the prefix list of an import policy that
+// rejects the routes it matches, and times the push of the routes
+// through the policy filters until the RIB and the peers have the
+// result, re-filtering all the routes and only the affected ones.  An
+// edit made while a push is in progress restarts it with all the routes.
+// A route is re-filtered by both the filter it was last filtered by and
+// the current one, so the initial push, from no import policy, runs the
+// policy half as many times as the pushes that follow it.
+//
+// The export test times a table through an export policy of 50 terms,
+// with the policies compiled and interpreted by IvExec, and checks that
+// the peers are sent the same UPDATEs.
+//
+// The pipeline is split into stages by StageMeters, pass-through
+// route tables spliced in front of the first table of each stage.
+// The time spent in a stage does not include the time spent in the
+// stages it calls, and the memory allocated is charged to the stage
+// that allocated it, by replacing the global operator new.
+
+/* **************** Stage accounting *********************** */
+
+enum Stage {
+    STAGE_OTHER,	// Not in the plumbing: setup and the workload
+    STAGE_RIBIN,	// PeerHandler, RibIn
+    STAGE_DAMPING,	// Damping
+    STAGE_POLICY,	// Input filters, import policy, cache
+    STAGE_DECISION,	// Next hop lookup, decision, aggregation
+    STAGE_FANOUT,	// Fanout, output filters, export policy
+    STAGE_RIBOUT,	// RibOut, building and encoding the UPDATEs
+    STAGES
+};
+
+static const char *stage_names[STAGES] = {
+    "other", "ribin", "damping", "policy", "decision", "fanout", "ribout"
+};
+
+static Stage current_stage = STAGE_OTHER;
+static int64_t stage_heap[STAGES];	// Live bytes allocated by a stage
+static uint64_t stage_routes[STAGES];	// Routes that entered a stage
+static double stage_secs[STAGES];
+static TimeVal stage_mark;
+
+/*
+** Charge the time since the last change of stage to the current stage.
+*/
+static void
+charge_stage()
+{
+    TimeVal now;
+    TimerList::system_gettimeofday(&now);
+    stage_secs[current_stage] += (now - stage_mark).get_double();
+    stage_mark = now;
+}
+
+static void
+reset_stage_counters()
+{
+    for (int s = 0; s < STAGES; s++) {
+	stage_routes[s] = 0;
+	stage_secs[s] = 0;
+    }
+    TimerList::system_gettimeofday(&stage_mark);
+}
+
+class StageScope {
+public:
+    StageScope(Stage stage) : _saved(current_stage) {
+	charge_stage();
+	current_stage = stage;
+    }
+    ~StageScope() {
+	charge_stage();
+	current_stage = _saved;
+    }
+private:
+    Stage _saved;
+};
+
+union AllocHeader {
+    struct {
+	size_t size;
+	int stage;
+    } h;
+    long double align;
+};
+
+static void *
+counted_alloc(size_t size)
+{
+    AllocHeader *a =
+	static_cast<AllocHeader *>(malloc(sizeof(AllocHeader) + size));
+    if (a == NULL)
+	return NULL;
+    a->h.size = size;
+    a->h.stage = current_stage;
+    stage_heap[current_stage] += size;
+
+    return a + 1;
+}
+
+static void
+counted_free(void *p)
+{
+    if (p == NULL)
+	return;
+    AllocHeader *a = static_cast<AllocHeader *>(p) - 1;
+    stage_heap[a->h.stage] -= a->h.size;
+    free(a);
+}
+
+void *
+operator new(size_t size) throw(std::bad_alloc)
+{
+    void *p = counted_alloc(size);
+    if (p == NULL)
+	throw std::bad_alloc();
+    return p;
+}
+
+void *
+operator new[](size_t size) throw(std::bad_alloc)
+{
+    void *p = counted_alloc(size);
+    if (p == NULL)
+	throw std::bad_alloc();
+    return p;
+}
+
+void *
+operator new(size_t size, const std::nothrow_t&) throw()
+{
+    return counted_alloc(size);
+}
+
+void *
+operator new[](size_t size, const std::nothrow_t&) throw()
+{
+    return counted_alloc(size);
+}
+
+void
+operator delete(void *p) throw()
+{
+    counted_free(p);
+}
+
+void
+operator delete[](void *p) throw()
+{
+    counted_free(p);
+}
+
+void
+operator delete(void *p, const std::nothrow_t&) throw()
+{
+    counted_free(p);
+}
+
+void
+operator delete[](void *p, const std::nothrow_t&) throw()
+{
+    counted_free(p);
+}
+
+/*
+** A route table that passes everything through, charging the work
+** done downstream to a stage.
+*/
+class StageMeter : public BGPRouteTable<IPv4> {
+public:
+    StageMeter(const string& tablename, Stage stage,
+	       BGPRouteTable<IPv4> *parent)
+	: BGPRouteTable<IPv4>(tablename, SAFI_UNICAST), _stage(stage) {
+	_parent = parent;
+    }
+
+    int add_route(InternalMessage<IPv4>& rtmsg, BGPRouteTable<IPv4> *caller) {
+	XLOG_ASSERT(caller == _parent);
+	StageScope scope(_stage);
+	stage_routes[_stage]++;
+	return _next_table->add_route(rtmsg, this);
+    }
+
+    int replace_route(InternalMessage<IPv4>& old_rtmsg,
+		      InternalMessage<IPv4>& new_rtmsg,
+		      BGPRouteTable<IPv4> *caller) {
+	XLOG_ASSERT(caller == _parent);
+	StageScope scope(_stage);
+	stage_routes[_stage]++;
+	return _next_table->replace_route(old_rtmsg, new_rtmsg, this);
+    }
+
+    int delete_route(InternalMessage<IPv4>& rtmsg,
+		     BGPRouteTable<IPv4> *caller) {
+	XLOG_ASSERT(caller == _parent);
+	StageScope scope(_stage);
+	stage_routes[_stage]++;
+	return _next_table->delete_route(rtmsg, this);
+    }
+
+    int route_dump(InternalMessage<IPv4>& rtmsg, BGPRouteTable<IPv4> *caller,
+		   const PeerHandler *dump_peer) {
+	XLOG_ASSERT(caller == _parent);
+	StageScope scope(_stage);
+	stage_routes[_stage]++;
+	return _next_table->route_dump(rtmsg, this, dump_peer);
+    }
+
+    int push(BGPRouteTable<IPv4> *caller) {
+	XLOG_ASSERT(caller == _parent);
+	StageScope scope(_stage);
+	return _next_table->push(this);
+    }
+
+    const SubnetRoute<IPv4> *lookup_route(const IPNet<IPv4>& net,
+					  uint32_t& genid,
+					  FPAList4Ref& pa_list) const {
+	return _parent->lookup_route(net, genid, pa_list);
+    }
+
+    void route_used(const SubnetRoute<IPv4> *route, bool in_use) {
+	_parent->route_used(route, in_use);
+    }
+
+    // Only a RibOut pulls routes, out of the fanout queue.
+    bool get_next_message(BGPRouteTable<IPv4> *next_table) {
+	XLOG_ASSERT(next_table == _next_table);
+	StageScope scope(STAGE_FANOUT);
+	return _parent->get_next_message(this);
+    }
+
+    RouteTableType type() const { return DEBUG_TABLE; }
+    string str() const { return "StageMeter<IPv4>" + tablename(); }
+
+private:
+    Stage _stage;
+};
+
+/*
+** Splice a StageMeter in front of a table.
+*/
+static StageMeter *
+insert_meter(BGPRouteTable<IPv4> *table, Stage stage)
+{
+    BGPRouteTable<IPv4> *parent = table->parent();
+    XLOG_ASSERT(parent != NULL);
+
+    StageMeter *meter = new StageMeter(table->tablename() + "Meter", stage,
+				       parent);
+    parent->set_next_table(meter);
+    meter->set_next_table(table);
+    table->set_parent(meter);
+
+    return meter;
+}
+
+static BGPRouteTable<IPv4> *
+find_downstream(BGPRouteTable<IPv4> *table, RouteTableType type)
+{
+    while (table != NULL && table->type() != type)
+	table = table->next_table();
+    XLOG_ASSERT(table != NULL);
+
+    return table;
+}
+
+static BGPRouteTable<IPv4> *
+find_upstream(BGPRouteTable<IPv4> *table, RouteTableType type)
+{
+    while (table != NULL && table->type() != type)
+	table = table->parent();
+    XLOG_ASSERT(table != NULL);
+
+    return table;
+}
+
+/* **************** Peers and the RIB *********************** */
+
+/*
+** A peer that encodes the UPDATEs it is sent and drops them.
+*/
+class ReplayPeer : public BGPPeer {
+public:
+    ReplayPeer(LocalData *ld, BGPPeerData *pd, BGPMain *m)
+	: BGPPeer(ld, pd, NULL, m), _messages(0), _bytes(0), _announced(0),
+	  _encode_secs(0), _digest(0)
+    {}
+
+    PeerOutputState send_update_message(const UpdatePacket& p) {
+	uint8_t buf[BGPPacket::MAXPACKETSIZE];
+	size_t len = BGPPacket::MAXPACKETSIZE;
+	TimeVal start, end;
+	TimerList::system_gettimeofday(&start);
+	if (!p.encode(buf, len, peerdata()))
+	    XLOG_WARNING("Failed to encode %s", cstring(p));
+	TimerList::system_gettimeofday(&end);
+	_encode_secs += (end - start).get_double();
+	_messages++;
+	_bytes += len;
+	_announced += p.nlri_list().size();
+	for (size_t i = 0; i < len; i++)
+	    _digest = _digest * 31 + buf[i];
+	return PEER_OUTPUT_OK;
+    }
+
+    uint64_t messages() const		{ return _messages; }
+    uint64_t bytes() const		{ return _bytes; }
+    uint64_t announced() const		{ return _announced; }
+    double encode_secs() const		{ return _encode_secs; }
+    uint64_t digest() const		{ return _digest; }
+    void reset_counters() {
+	_messages = _bytes = _announced = _digest = 0;
+	_encode_secs = 0;
+    }
+
+private:
+    uint64_t _messages;
+    uint64_t _bytes;
+    uint64_t _announced;	// Routes announced to the peer
+    double _encode_secs;	// Time spent encoding the UPDATEs
+    uint64_t _digest;		// Of the UPDATEs, in the order sent
+};
+
+/*
+** A RIB that counts the IPv4 routes it holds.  Once a RIB name is
+** registered the routes are sent to the RIB as well.
+*/
+class StubRib : public RibIpcHandler {
+public:
+    StubRib(XrlStdRouter& xrl_router, BGPMain& bgp)
+	: RibIpcHandler(xrl_router, bgp), _routes(0)
+    {}
+
+    using RibIpcHandler::add_route;
+    using RibIpcHandler::replace_route;
+    using RibIpcHandler::delete_route;
+
+    int add_route(const SubnetRoute<IPv4>& rt, FPAList4Ref& pa_list,
+		  bool ibgp, Safi safi) {
+	_routes++;
+	return RibIpcHandler::add_route(rt, pa_list, ibgp, safi);
+    }
+
+    int replace_route(const SubnetRoute<IPv4>& old_rt, bool old_ibgp,
+		      const SubnetRoute<IPv4>& new_rt, bool new_ibgp,
+		      FPAList4Ref& pa_list, Safi safi) {
+	return RibIpcHandler::replace_route(old_rt, old_ibgp, new_rt, new_ibgp,
+					    pa_list, safi);
+    }
+
+    int delete_route(const SubnetRoute<IPv4>& rt, FPAList4Ref& pa_list,
+		     bool ibgp, Safi safi) {
+	_routes--;
+	return RibIpcHandler::delete_route(rt, pa_list, ibgp, safi);
+    }
+
+    PeerOutputState push_packet()	{ return PEER_OUTPUT_OK; }
+
+    int64_t routes() const		{ return _routes; }
+
+private:
+    int64_t _routes;
+};
+
+/*
+** The RIB end of the XRLs: a target that acknowledges the route
+** changes it is sent and counts them.  It is not registered as the
+** "rib" class, or the ProcessWatch of the BGP process under test would
+** take it for the RIB and shut BGP down when it goes away.
+*/
+class XrlStubRib {
+public:
+    XrlStubRib(EventLoop& eventloop)
+	: _router(eventloop, "stub_rib"), _tables(0), _routes(0), _changes(0),
+	  _xrls(0)
+    {
+	_router.add_handler("rib/0.1/add_egp_table4",
+			    callback(this, &XrlStubRib::add_table));
+	_router.add_handler("rib/0.1/delete_egp_table4",
+			    callback(this, &XrlStubRib::delete_table));
+	_router.add_handler("rib/0.1/add_egp_table6",
+			    callback(this, &XrlStubRib::add_table));
+	_router.add_handler("rib/0.1/delete_egp_table6",
+			    callback(this, &XrlStubRib::delete_table));
+	_router.add_handler("rib/0.1/add_route4",
+			    callback(this, &XrlStubRib::add_route));
+	_router.add_handler("rib/0.1/delete_route4",
+			    callback(this, &XrlStubRib::delete_route));
+	_router.add_handler("rib/0.1/route_changes4",
+			    callback(this, &XrlStubRib::route_changes));
+	_router.finalize();
+	wait_until_xrl_router_is_ready(eventloop, _router);
+    }
+
+    const string& name() const		{ return _router.class_name(); }
+    int tables() const			{ return _tables; }
+    int64_t routes() const		{ return _routes; }
+    uint64_t changes() const		{ return _changes; }
+    uint64_t xrls() const		{ return _xrls; }
+    void reset_counters()		{ _changes = _xrls = 0; }
+
+private:
+    const XrlCmdError add_table(const XrlArgs&, XrlArgs*) {
+	_tables++;
+	return XrlCmdError::OKAY();
+    }
+
+    const XrlCmdError delete_table(const XrlArgs&, XrlArgs*) {
+	_tables--;
+	return XrlCmdError::OKAY();
+    }
+
+    const XrlCmdError add_route(const XrlArgs&, XrlArgs*) {
+	_xrls++;
+	_changes++;
+	_routes++;
+	return XrlCmdError::OKAY();
+    }
+
+    const XrlCmdError delete_route(const XrlArgs&, XrlArgs*) {
+	_xrls++;
+	_changes++;
+	_routes--;
+	return XrlCmdError::OKAY();
+    }
+
+    const XrlCmdError route_changes(const XrlArgs& in, XrlArgs*) {
+	_xrls++;
+	const XrlAtomList& adds = in.get_list("adds");
+	for (size_t i = 0; i < adds.size(); i++)
+	    _routes += adds.get(i).boolean() ? 1 : -1;
+	_changes += adds.size();
+	return XrlCmdError::OKAY();
+    }
+
+    XrlStdRouter _router;
+    int _tables;
+    int64_t _routes;
+    uint64_t _changes;
+    uint64_t _xrls;
+};
+
+/* **************** The workload *********************** */
+
+/*
+** An UPDATE before it is given the next hop and AS of a peer.
+*/
+struct ReplayUpdate {
+    vector<IPv4Net> withdrawn;
+    vector<IPv4Net> nlri;
+    FPAList4Ref pa_list;
+};
+
+typedef vector<ReplayUpdate> Updates;
+
+/*
+** Drop the withdrawals of routes that are not announced, so that all
+** the withdrawals reach the plumbing, and record the routes announced.
+*/
+static void
+add_update(Updates& updates, ReplayUpdate& u, set<IPv4Net>& live)
+{
+    vector<IPv4Net> withdrawn;
+    vector<IPv4Net>::const_iterator i;
+    for (i = u.withdrawn.begin(); i != u.withdrawn.end(); ++i) {
+	if (live.erase(*i) > 0)
+	    withdrawn.push_back(*i);
+    }
+    u.withdrawn.swap(withdrawn);
+
+    for (i = u.nlri.begin(); i != u.nlri.end(); ++i)
+	live.insert(*i);
+
+    if (!u.withdrawn.empty() || !u.nlri.empty())
+	updates.push_back(u);
+}
+
+static FPAList4Ref
+synthetic_attributes(uint32_t n, uint32_t version)
+{
+    FPAList4Ref pa_list = new FastPathAttributeList<IPv4>();
+
+    // Replaced by the address of each peer.
+    NextHopAttribute<IPv4> nexthop_att(IPv4("192.0.2.1"));
+    pa_list->add_path_attribute(nexthop_att);
+
+    // One to four ASes, more after a change.
+    string path = c_format("%u", XORP_UINT_CAST(1000 + n % 3000));
+    for (uint32_t i = 0; i < n % 4 + version; i++)
+	path += c_format(",%u", XORP_UINT_CAST(100 + (n + i) % 50));
+    ASPathAttribute aspath_att(ASPath(path.c_str()));
+    pa_list->add_path_attribute(aspath_att);
+
+    OriginAttribute origin_att(IGP);
+    pa_list->add_path_attribute(origin_att);
+    MEDAttribute med_att(version);
+    pa_list->add_path_attribute(med_att);
+
+    return pa_list;
+}
+
+static IPv4Net
+synthetic_net(uint32_t n)
+{
+    return IPv4Net(IPv4(htonl(0x10000000 + (n << 8))), 24);
+}
+
+static const uint32_t SYNTHETIC_PER_UPDATE = 10;
+
+/*
+** A table of <routes> /24s, announced ten to an UPDATE.
+*/
+static void
+synthetic_table(uint32_t routes, Updates& table, set<IPv4Net>& live)
+{
+    static const uint32_t PER_UPDATE = SYNTHETIC_PER_UPDATE;
+
+    for (uint32_t n = 0; n * PER_UPDATE < routes; n++) {
+	ReplayUpdate u;
+	for (uint32_t i = n * PER_UPDATE;
+	     i < (n + 1) * PER_UPDATE && i < routes; i++)
+	    u.nlri.push_back(synthetic_net(i));
+	u.pa_list = synthetic_attributes(n, 0);
+	add_update(table, u, live);
+    }
+}
+
+/*
+** Change the attributes of a quarter of the synthetic table and
+** withdraw an eighth of it.
+*/
+static void
+synthetic_stream(uint32_t routes, Updates& stream, set<IPv4Net>& live)
+{
+    static const uint32_t PER_UPDATE = SYNTHETIC_PER_UPDATE;
+
+    for (uint32_t n = 0; n * PER_UPDATE < routes; n++) {
+	ReplayUpdate u;
+	for (uint32_t i = n * PER_UPDATE;
+	     i < (n + 1) * PER_UPDATE && i < routes; i++) {
+	    if (n % 4 == 0)
+		u.nlri.push_back(synthetic_net(i));
+	    else if (n % 8 == 1)
+		u.withdrawn.push_back(synthetic_net(i));
+	}
+	if (!u.nlri.empty())
+	    u.pa_list = synthetic_attributes(n, 1);
+	add_update(stream, u, live);
+    }
+}
+
+/*
+** Only IPv4 unicast is replayed.
+*/
+static void
+strip_multiprotocol(FPAList4Ref& pa_list)
+{
+    pa_list->remove_attribute_by_type(MP_REACH_NLRI);
+    pa_list->remove_attribute_by_type(MP_UNREACH_NLRI);
+}
+
+/*
+** The AS paths of an MRT file start with the AS of the peer they were
+** recorded from, which the replay peers replace with their own.  The
+** MRT headers do not always carry it (data/bgp/icsi1.mrtd has 0), so
+** the first AS of the path is taken to be it.
+*/
+static void
+strip_recorded_peer(FPAList4Ref& pa_list)
+{
+    const ASPath& path = pa_list->aspath();
+    if (path.num_segments() == 0 || path.segment_type(0) != AS_SEQUENCE)
+	return;
+
+    vector<ASSegment> segs;
+    path.segments(segs);
+    ASSegment first(AS_SEQUENCE);
+    for (size_t i = 1; i < segs[0].as_size(); i++)
+	first.add_as(segs[0].as_num(i));
+    if (first.as_size() == 0)
+	segs.erase(segs.begin());
+    else
+	segs[0] = first;
+
+    ASPath stripped;
+    for (size_t i = 0; i < segs.size(); i++)
+	stripped.add_segment(segs[i]);
+    pa_list->replace_AS_path(stripped);
+}
+
+static bool
+read_table_dump(const string& fname, BGPPeerData *peerdata, Updates& table,
+		set<IPv4Net>& live, string& error_msg)
+{
+    static const size_t MAX_PER_UPDATE = 500;
+
+    FILE *fp = fopen(fname.c_str(), "r");
+    if (fp == NULL) {
+	error_msg = c_format("fopen of %s failed: %s", fname.c_str(),
+			     strerror(errno));
+	return false;
+    }
+
+    // Consecutive routes with the same attributes share an UPDATE.
+    ReplayUpdate u;
+    vector<uint8_t> last;
+    IPv4Net net;
+    size_t len;
+    const uint8_t *buf;
+    while (0 != (buf = mrtd_table_file_read(fp, net, len))) {
+	vector<uint8_t> attributes(buf, buf + len);
+	delete [] buf;
+
+	if (attributes == last && u.nlri.size() < MAX_PER_UPDATE) {
+	    u.nlri.push_back(net);
+	    continue;
+	}
+	if (!u.nlri.empty())
+	    add_update(table, u, live);
+	u = ReplayUpdate();
+	last.swap(attributes);
+
+	FPAList4Ref pa_list = new FastPathAttributeList<IPv4>();
+	try {
+	    const uint8_t *d = &last[0];
+	    size_t remaining = last.size();
+	    while (remaining > 0) {
+		size_t used = 0;
+		PathAttribute *pa = PathAttribute::create(d, remaining, used,
+							  peerdata, 4);
+		if (pa == NULL || used == 0)
+		    break;
+		pa_list->add_path_attribute(pa);
+		d += used;
+		remaining -= used;
+	    }
+	} catch(XorpException& e) {
+	    XLOG_WARNING("Skipping %s: %s", cstring(net), e.str().c_str());
+	    last.clear();
+	    continue;
+	}
+	strip_multiprotocol(pa_list);
+	if (!pa_list->complete()) {
+	    last.clear();
+	    continue;
+	}
+	strip_recorded_peer(pa_list);
+	u.pa_list = pa_list;
+	u.nlri.push_back(net);
+    }
+    if (!u.nlri.empty())
+	add_update(table, u, live);
+
+    fclose(fp);
+    return true;
+}
+
+static bool
+read_update_stream(const string& fname, BGPPeerData *peerdata, BGPMain *bgp,
+		   Updates& stream, set<IPv4Net>& live, string& error_msg)
+{
+    FILE *fp = fopen(fname.c_str(), "r");
+    if (fp == NULL) {
+	error_msg = c_format("fopen of %s failed: %s", fname.c_str(),
+			     strerror(errno));
+	return false;
+    }
+
+    size_t len;
+    const uint8_t *buf;
+    while (0 != (buf = mrtd_traffic_file_read(fp, len))) {
+	if (len < BGPPacket::MINUPDATEPACKET ||
+	    extract_8(buf + BGPPacket::TYPE_OFFSET) != MESSAGETYPEUPDATE) {
+	    delete [] buf;
+	    continue;
+	}
+
+	try {
+	    UpdatePacket p(buf, len, peerdata, bgp, false);
+	    ReplayUpdate u;
+	    BGPUpdateAttribList::const_iterator i;
+	    for (i = p.wr_list().begin(); i != p.wr_list().end(); ++i)
+		u.withdrawn.push_back(i->net());
+	    if (!p.nlri_list().empty() && p.pa_list()->complete()) {
+		for (i = p.nlri_list().begin(); i != p.nlri_list().end(); ++i)
+		    u.nlri.push_back(i->net());
+		u.pa_list = new FastPathAttributeList<IPv4>(*p.pa_list());
+		strip_multiprotocol(u.pa_list);
+		strip_recorded_peer(u.pa_list);
+	    }
+	    add_update(stream, u, live);
+	} catch(XorpException& e) {
+	    XLOG_WARNING("Skipping an UPDATE: %s", e.str().c_str());
+	}
+	delete [] buf;
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/*
+** The peer the MRT files are decoded as received from.
+*/
+class RecordingPeer {
+public:
+    RecordingPeer(BGPMain *bgp)
+	: _peer_data(*bgp->get_local_data(),
+		     Iptuple("", "10.255.0.1", 179, "10.254.0.1", 179),
+		     AsNum(65000), IPv4(), 0) {
+	_peer_data.compute_peer_type();
+    }
+
+    BGPPeerData *peer_data()		{ return &_peer_data; }
+
+private:
+    BGPPeerData _peer_data;
+};
+
+/*
+** Load the MRT table dump <dump>, or a synthetic table of <routes>
+** routes if there is none.
+*/
+static bool
+load_table(TestInfo& info, BGPMain *bgp, uint32_t routes, const string& dump,
+	   Updates& table, set<IPv4Net>& live)
+{
+    if (dump.empty()) {
+	synthetic_table(routes, table, live);
+	return true;
+    }
+
+    RecordingPeer peer(bgp);
+    string error_msg;
+    if (!read_table_dump(dump, peer.peer_data(), table, live, error_msg)) {
+	DOUT(info) << error_msg << endl;
+	return false;
+    }
+
+    return true;
+}
+
+/*
+** Load the MRT update stream <updates>, or the synthetic stream that
+** follows a synthetic table of <routes> routes if there is none.
+*/
+static bool
+load_stream(TestInfo& info, BGPMain *bgp, uint32_t routes,
+	    const string& updates, Updates& stream, set<IPv4Net>& live)
+{
+    if (updates.empty()) {
+	synthetic_stream(routes, stream, live);
+	return true;
+    }
+
+    RecordingPeer peer(bgp);
+    string error_msg;
+    if (!read_update_stream(updates, peer.peer_data(), bgp, stream, live,
+			    error_msg)) {
+	DOUT(info) << error_msg << endl;
+	return false;
+    }
+
+    return true;
+}
+
+/*
+** Withdraw all the routes still announced.
+*/
+static void
+withdraw_workload(const set<IPv4Net>& live, Updates& withdraw)
+{
+    static const size_t PER_UPDATE = 500;
+
+    ReplayUpdate u;
+    set<IPv4Net>::const_iterator i;
+    for (i = live.begin(); i != live.end(); ++i) {
+	u.withdrawn.push_back(*i);
+	if (u.withdrawn.size() == PER_UPDATE) {
+	    withdraw.push_back(u);
+	    u.withdrawn.clear();
+	}
+    }
+    if (!u.withdrawn.empty())
+	withdraw.push_back(u);
+}
+
+/* **************** The benchmark *********************** */
+
+class Replay {
+public:
+    Replay(TestInfo& info, BGPMain& bgp, uint32_t peers);
+    ~Replay();
+
+    /**
+     * Replay UPDATEs from all the peers and report on the stages.
+     */
+    void run(const string& phase, const Updates& updates);
+
+    /**
+     * @return true if each RibIn and the RIB hold <routes> routes.
+     */
+    bool check(size_t routes);
+
+    /**
+     * Reset peerings 1 to <resets> and time the dumps of the table to
+     * them when they all come back up at once.  The peers then
+     * announce <table> again.
+     *
+     * @return true if each peering reset was sent <routes> routes.
+     */
+    bool reset_peers(uint32_t resets, const Updates& table, size_t routes);
+
+    /**
+     * Replay UPDATEs from all the peers and time them until <rib> holds
+     * <routes> routes and the RibIpcHandler has no XRLs in flight.
+     *
+     * @return true if the RIB reached <routes> routes.
+     */
+    bool install(const string& phase, const Updates& updates,
+		 XrlStubRib& rib, size_t routes);
+
+    /**
+     * Configure the import filter and time the push of the routes
+     * through the policy filters until the RIB holds <routes> routes
+     * and the peers were sent the changes.
+     *
+     * @param incremental true to only push the routes the change of
+     * configuration may affect.
+     * @param restart if not empty, a configuration to change to before
+     * the push of the first one is done, which must restart it and push
+     * all the routes.
+     * @return true if the RIB holds <routes> routes.
+     */
+    bool push_policy(const string& phase, const string& conf,
+		     bool incremental, size_t routes,
+		     const string& restart = "");
+
+    /**
+     * Configure a policy filter before any route is replayed.
+     */
+    void configure_policy(filter::Filter type, const string& conf) {
+	_policy_filters.configure(type, conf);
+    }
+
+    /**
+     * @return a digest of the UPDATEs sent to the peers by the last run.
+     */
+    uint64_t digest() const;
+
+    StubRib *rib()			{ return _rib; }
+
+private:
+    UpdatePacket *peer_packet(const ReplayUpdate& u, uint32_t peer);
+    void meter_peer(PeerHandler *handler);
+    bool deletions_pending();
+    bool dumps_pending();
+    bool output_pending();
+    void drain();
+    void report(const string& phase, uint64_t routes, double secs);
+
+    TestInfo& _info;
+    BGPMain& _bgp;
+    DummyNextHopResolver<IPv4> _nhr_ipv4;
+    DummyNextHopResolver<IPv6> _nhr_ipv6;
+    VersionFilters _policy_filters;
+    AggregationHandler _aggr_handler;
+    StubRib *_rib;
+    BGPPlumbing *_plumbing;
+    vector<ReplayPeer *> _peers;
+    vector<PeerHandler *> _handlers;
+    FanoutTable<IPv4> *_fanout;
+    PolicyTableSourceMatch<IPv4> *_sourcematch;
+    list<StageMeter *> _shared_meters;	// Not torn down with a peering
+    uint64_t _full_push;		// Routes re-filtered by a full push
+};
+
+Replay::Replay(TestInfo& info, BGPMain& bgp, uint32_t peers)
+    : _info(info), _bgp(bgp),
+      _nhr_ipv4(bgp.eventloop(), bgp), _nhr_ipv6(bgp.eventloop(), bgp),
+      _full_push(0)
+{
+    _rib = new StubRib(*bgp.get_router(), bgp);
+    _plumbing = new BGPPlumbing(SAFI_UNICAST, _rib, &_aggr_handler,
+				_nhr_ipv4, _nhr_ipv6, _policy_filters, bgp);
+    _rib->set_plumbing(_plumbing, _plumbing);
+
+    LocalData *local_data = bgp.get_local_data();
+    for (uint32_t i = 0; i < peers; i++) {
+	string addr = c_format("10.%u.%u.1", XORP_UINT_CAST(i / 256),
+			       XORP_UINT_CAST(i % 256));
+	Iptuple iptuple("", "10.255.0.1", 179, addr.c_str(), 179);
+	BGPPeerData *peer_data =
+	    new BGPPeerData(*local_data, iptuple, AsNum(65001 + i),
+			    IPv4("10.255.0.1"), 0);
+	peer_data->set_id(IPv4(addr.c_str()));
+	peer_data->compute_peer_type();
+	peer_data->set_multiprotocol<IPv4>(SAFI_UNICAST);
+	_nhr_ipv4.set_nexthop_metric(IPv4(addr.c_str()), 10 + i);
+
+	ReplayPeer *peer = new ReplayPeer(local_data, peer_data, &bgp);
+	_peers.push_back(peer);
+	// Creating the PeerHandler adds the peering.
+	PeerHandler *handler = new PeerHandler(c_format("peer%u",
+							XORP_UINT_CAST(i)),
+					       peer, _plumbing, NULL);
+	_handlers.push_back(handler);
+	meter_peer(handler);
+    }
+
+    // The tables shared by all the peerings.
+    BGPPlumbingAF<IPv4>& plumbing = _plumbing->plumbing_ipv4();
+    RibOutTable<IPv4> *rib_out = plumbing.rib_out_table(_rib);
+    _shared_meters.push_back(insert_meter(rib_out, STAGE_RIBOUT));
+    _fanout = dynamic_cast<FanoutTable<IPv4> *>(find_upstream(rib_out,
+							      FANOUT_TABLE));
+    XLOG_ASSERT(_fanout != NULL);
+    _shared_meters.push_back(insert_meter(_fanout, STAGE_FANOUT));
+    _sourcematch = dynamic_cast<PolicyTableSourceMatch<IPv4> *>(
+	find_upstream(_fanout, POLICY_TABLE));
+    XLOG_ASSERT(_sourcematch != NULL);
+
+    // The tables dumped to the peers as they came up.
+    while (dumps_pending())
+	bgp.eventloop().run();
+}
+
+Replay::~Replay()
+{
+    // Deleting the PeerHandler deletes the peering.
+    vector<PeerHandler *>::iterator i;
+    for (i = _handlers.begin(); i != _handlers.end(); ++i)
+	delete *i;
+    vector<ReplayPeer *>::iterator j;
+    for (j = _peers.begin(); j != _peers.end(); ++j)
+	delete *j;
+    // As in BGPMain, the RIB handler goes before the plumbing.
+    delete _rib;
+    delete _plumbing;
+    list<StageMeter *>::iterator k;
+    for (k = _shared_meters.begin(); k != _shared_meters.end(); ++k)
+	delete *k;
+}
+
+void
+Replay::meter_peer(PeerHandler *handler)
+{
+    BGPPlumbingAF<IPv4>& plumbing = _plumbing->plumbing_ipv4();
+
+    BGPRouteTable<IPv4> *rib_in = plumbing.rib_in_table(handler);
+    insert_meter(find_downstream(rib_in, DAMPING_TABLE), STAGE_DAMPING);
+    insert_meter(find_downstream(rib_in, FILTER_TABLE), STAGE_POLICY);
+    insert_meter(find_downstream(rib_in, NHLOOKUP_TABLE), STAGE_DECISION);
+
+    insert_meter(plumbing.rib_out_table(handler), STAGE_RIBOUT);
+}
+
+/**
+ * @return true if the fanout still holds routes for any RibOut.
+ */
+bool
+Replay::output_pending()
+{
+    list<const PeerTableInfo<IPv4> *> peers;
+    _fanout->peer_table_info(peers);
+
+    list<const PeerTableInfo<IPv4> *>::const_iterator i;
+    for (i = peers.begin(); i != peers.end(); ++i)
+	if ((*i)->has_queued_data())
+	    return true;
+
+    return false;
+}
+
+bool
+Replay::deletions_pending()
+{
+    BGPPlumbingAF<IPv4>& plumbing = _plumbing->plumbing_ipv4();
+
+    vector<PeerHandler *>::iterator i;
+    for (i = _handlers.begin(); i != _handlers.end(); ++i) {
+	BGPRouteTable<IPv4> *t = plumbing.rib_in_table(*i)->next_table();
+	if (t->type() == DELETION_TABLE)
+	    return true;
+    }
+
+    return false;
+}
+
+bool
+Replay::dumps_pending()
+{
+    BGPPlumbingAF<IPv4>& plumbing = _plumbing->plumbing_ipv4();
+
+    vector<PeerHandler *>::iterator i;
+    for (i = _handlers.begin(); i != _handlers.end(); ++i) {
+	BGPRouteTable<IPv4> *t = plumbing.rib_out_table(*i);
+	// The branch of a peering that is down is not plumbed in.
+	for (; t != NULL && t->type() != FANOUT_TABLE; t = t->parent())
+	    if (t->type() == DUMP_TABLE)
+		return true;
+    }
+
+    return false;
+}
+
+/*
+** The UPDATE as a peer would send it: with the peer as next hop and
+** the AS of the peer in front of the AS path.
+*/
+UpdatePacket *
+Replay::peer_packet(const ReplayUpdate& u, uint32_t peer)
+{
+    UpdatePacket *p = new UpdatePacket();
+
+    vector<IPv4Net>::const_iterator i;
+    for (i = u.withdrawn.begin(); i != u.withdrawn.end(); ++i)
+	p->add_withdrawn(BGPUpdateAttrib(*i));
+    for (i = u.nlri.begin(); i != u.nlri.end(); ++i)
+	p->add_nlri(BGPUpdateAttrib(*i));
+
+    if (!u.nlri.empty()) {
+	const BGPPeerData *peer_data = _peers[peer]->peerdata();
+	FPAList4Ref pa_list = new FastPathAttributeList<IPv4>(*u.pa_list);
+	pa_list->replace_nexthop(
+	    IPv4(peer_data->iptuple().get_peer_addr().c_str()));
+	ASPath as_path(pa_list->aspath());
+	as_path.prepend_as(peer_data->as());
+	pa_list->replace_AS_path(as_path);
+	p->replace_pathattribute_list(pa_list);
+    }
+
+    return p;
+}
+
+static bool
+keep_running()
+{
+    return true;
+}
+
+void
+Replay::run(const string& phase, const Updates& updates)
+{
+    // The packets are built before the clock starts.
+    vector<vector<UpdatePacket *> > packets(_peers.size());
+    uint64_t routes = 0;
+    for (uint32_t peer = 0; peer < _peers.size(); peer++) {
+	Updates::const_iterator u;
+	for (u = updates.begin(); u != updates.end(); ++u) {
+	    packets[peer].push_back(peer_packet(*u, peer));
+	    routes += u->withdrawn.size() + u->nlri.size();
+	}
+    }
+
+    reset_stage_counters();
+    vector<ReplayPeer *>::iterator i;
+    for (i = _peers.begin(); i != _peers.end(); ++i)
+	(*i)->reset_counters();
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    // A task that is always runnable stops EventLoop::run() from
+    // blocking in select() once the RibOuts have drained the fanout.
+    XorpTask spin = _bgp.eventloop().new_task(callback(keep_running),
+					      XorpTask::PRIORITY_LOWEST,
+					      XorpTask::WEIGHT_DEFAULT);
+
+    // The peers take turns.
+    for (size_t n = 0; n < updates.size(); n++) {
+	for (uint32_t peer = 0; peer < _peers.size(); peer++) {
+	    UpdatePacket *p = packets[peer][n];
+	    StageScope scope(STAGE_RIBIN);
+	    stage_routes[STAGE_RIBIN] +=
+		p->wr_list().size() + p->nlri_list().size();
+	    _handlers[peer]->process_update_packet(p);
+	}
+	// The RibOuts pull from the fanout queue from the eventloop.
+	while (output_pending())
+	    _bgp.eventloop().run();
+    }
+
+    TimerList::system_gettimeofday(&end);
+    charge_stage();
+    spin.unschedule();
+
+    for (uint32_t peer = 0; peer < _peers.size(); peer++)
+	for (size_t n = 0; n < packets[peer].size(); n++)
+	    delete packets[peer][n];
+
+    report(phase, routes, (end - start).get_double());
+}
+
+bool
+Replay::install(const string& phase, const Updates& updates,
+		XrlStubRib& rib, size_t routes)
+{
+    static const uint32_t TIMEOUT_MS = 600 * 1000;
+
+    rib.reset_counters();
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    run(phase, updates);
+    bool timed_out = false;
+    XorpTimer t = _bgp.eventloop().set_flag_after_ms(TIMEOUT_MS, &timed_out);
+    while ((rib.routes() != (int64_t)routes || _rib->busy()) && !timed_out)
+	_bgp.eventloop().run();
+
+    TimerList::system_gettimeofday(&end);
+    double secs = (end - start).get_double();
+    if (timed_out) {
+	DOUT(_info) << "The RIB has " << rib.routes() << " routes, "
+		    << routes << " expected\n";
+	return false;
+    }
+
+    DOUT(_info) << c_format("  RIB install: %llu route changes in %.3f s, "
+			    "%.0f changes/s, %llu XRLs\n",
+			    (unsigned long long)rib.changes(), secs,
+			    secs > 0 ? rib.changes() / secs : 0,
+			    (unsigned long long)rib.xrls());
+
+    return true;
+}
+
+bool
+Replay::push_policy(const string& phase, const string& conf,
+		    bool incremental, size_t routes, const string& restart)
+{
+    _policy_filters.configure(filter::IMPORT, conf);
+
+    reset_stage_counters();
+    vector<ReplayPeer *>::iterator i;
+    for (i = _peers.begin(); i != _peers.end(); ++i)
+	(*i)->reset_counters();
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    // As BGPMain::push_routes() does.
+    FilterChanges changes;
+    _policy_filters.take_changes(changes);
+    _plumbing->push_routes(incremental ? &changes : NULL);
+
+    if (!restart.empty()) {
+	XLOG_ASSERT(_sourcematch->pushing_routes());
+	_policy_filters.configure(filter::IMPORT, restart);
+	_policy_filters.take_changes(changes);
+	_plumbing->push_routes(incremental ? &changes : NULL);
+    }
+
+    XorpTask spin = _bgp.eventloop().new_task(callback(keep_running),
+					      XorpTask::PRIORITY_LOWEST,
+					      XorpTask::WEIGHT_DEFAULT);
+    while (_sourcematch->pushing_routes() || output_pending())
+	_bgp.eventloop().run();
+    spin.unschedule();
+
+    TimerList::system_gettimeofday(&end);
+    charge_stage();
+    double secs = (end - start).get_double();
+
+    uint64_t messages = 0;
+    for (i = _peers.begin(); i != _peers.end(); ++i)
+	messages += (*i)->messages();
+    DOUT(_info) << c_format("  %-8s %-11s push: %llu routes re-filtered "
+			    "in %.3f s, %llu UPDATEs\n",
+			    phase.c_str(),
+			    incremental ? "incremental" : "full",
+			    (unsigned long long)stage_routes[STAGE_POLICY],
+			    secs, (unsigned long long)messages);
+
+    if (!incremental)
+	_full_push = stage_routes[STAGE_POLICY];
+    else if (!restart.empty() && stage_routes[STAGE_POLICY] < _full_push) {
+	DOUT(_info) << "The restarted push re-filtered "
+		    << stage_routes[STAGE_POLICY] << " routes, "
+		    << _full_push << " expected\n";
+	return false;
+    }
+
+    if (_rib->routes() != (int64_t)routes) {
+	DOUT(_info) << "The RIB has " << _rib->routes() << " routes, "
+		    << routes << " expected\n";
+	return false;
+    }
+
+    return true;
+}
+
+uint64_t
+Replay::digest() const
+{
+    uint64_t digest = 0;
+    vector<ReplayPeer *>::const_iterator i;
+    for (i = _peers.begin(); i != _peers.end(); ++i)
+	digest = digest * 31 + (*i)->digest();
+
+    return digest;
+}
+
+/*
+** Run the eventloop until all the deletions, dumps and output are done.
+*/
+void
+Replay::drain()
+{
+    XorpTask spin = _bgp.eventloop().new_task(callback(keep_running),
+					      XorpTask::PRIORITY_LOWEST,
+					      XorpTask::WEIGHT_DEFAULT);
+    while (deletions_pending() || dumps_pending() || output_pending())
+	_bgp.eventloop().run();
+    spin.unschedule();
+}
+
+bool
+Replay::reset_peers(uint32_t resets, const Updates& table, size_t routes)
+{
+    XLOG_ASSERT(resets < _peers.size());
+
+    for (uint32_t peer = 1; peer <= resets; peer++)
+	_plumbing->peering_went_down(_handlers[peer]);
+    drain();
+
+    vector<ReplayPeer *>::iterator i;
+    for (i = _peers.begin(); i != _peers.end(); ++i)
+	(*i)->reset_counters();
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+
+    for (uint32_t peer = 1; peer <= resets; peer++)
+	_plumbing->peering_came_up(_handlers[peer]);
+    drain();
+
+    TimerList::system_gettimeofday(&end);
+    double secs = (end - start).get_double();
+
+    bool ok = true;
+    uint64_t messages = 0;
+    double encode_secs = 0;
+    for (uint32_t peer = 1; peer <= resets; peer++) {
+	messages += _peers[peer]->messages();
+	encode_secs += _peers[peer]->encode_secs();
+	if (_peers[peer]->announced() != routes) {
+	    DOUT(_info) << _handlers[peer]->peername() << " was sent "
+			<< _peers[peer]->announced() << " routes, "
+			<< routes << " expected\n";
+	    ok = false;
+	}
+    }
+    DOUT(_info) << c_format("  %2u peers reset: full table in %.3f s, "
+			    "%.0f routes/s, %llu UPDATEs, "
+			    "encode %.2f us/UPDATE\n",
+			    XORP_UINT_CAST(resets), secs,
+			    secs > 0 ? resets * routes / secs : 0,
+			    (unsigned long long)messages,
+			    messages > 0 ? encode_secs * 1e6 / messages : 0);
+
+    // The peers announce their routes again, so that the next reset
+    // walks the same RibIns.
+    for (size_t n = 0; n < table.size(); n++) {
+	vector<UpdatePacket *> packets;
+	for (uint32_t peer = 1; peer <= resets; peer++) {
+	    packets.push_back(peer_packet(table[n], peer));
+	    _handlers[peer]->process_update_packet(packets.back());
+	}
+	drain();
+	for (size_t p = 0; p < packets.size(); p++)
+	    delete packets[p];
+    }
+
+    return ok;
+}
+
+void
+Replay::report(const string& phase, uint64_t routes, double secs)
+{
+    uint64_t messages = 0, bytes = 0;
+    double encode_secs = 0;
+    vector<ReplayPeer *>::const_iterator i;
+    for (i = _peers.begin(); i != _peers.end(); ++i) {
+	messages += (*i)->messages();
+	bytes += (*i)->bytes();
+	encode_secs += (*i)->encode_secs();
+    }
+
+    DOUT(_info) << c_format("%s: %u peers, %llu routes in %.3f s, "
+			    "%.0f routes/s\n",
+			    phase.c_str(), XORP_UINT_CAST(_peers.size()),
+			    (unsigned long long)routes, secs,
+			    secs > 0 ? routes / secs : 0);
+    DOUT(_info) << c_format("  %-10s %10s %10s %12s %12s %10s\n", "stage",
+			    "routes", "seconds", "routes/s", "heap KB",
+			    "B/prefix");
+    for (int s = STAGE_RIBIN; s < STAGES; s++) {
+	DOUT(_info) << c_format("  %-10s %10llu %10.3f %12.0f %12lld %10.1f\n",
+				stage_names[s],
+				(unsigned long long)stage_routes[s],
+				stage_secs[s],
+				stage_secs[s] > 0 ?
+				stage_routes[s] / stage_secs[s] : 0,
+				(long long)stage_heap[s] / 1024,
+				_rib->routes() > 0 ?
+				(double)stage_heap[s] / _rib->routes() : 0);
+    }
+
+    // What the RibIns hold, from their own accounting.
+    BgpTrie<IPv4>::MemoryUsage total;
+    memset(&total, 0, sizeof(total));
+    vector<PeerHandler *>::const_iterator h;
+    for (h = _handlers.begin(); h != _handlers.end(); ++h) {
+	BgpTrie<IPv4>::MemoryUsage usage;
+	_plumbing->plumbing_ipv4().rib_in_table(*h)->trie().memory_usage(usage);
+	total.routes += usage.routes;
+	total.nodes += usage.nodes;
+	total.node_bytes += usage.node_bytes;
+	total.route_bytes += usage.route_bytes;
+	total.chains += usage.chains;
+	total.pathmap_bytes += usage.pathmap_bytes;
+    }
+    if (total.routes > 0) {
+	DOUT(_info) << c_format("  RibIn %llu routes: %llu nodes %llu KB, "
+				"routes %llu KB, %llu chains %llu KB, "
+				"%.1f B/route\n",
+				(unsigned long long)total.routes,
+				(unsigned long long)total.nodes,
+				(unsigned long long)total.node_bytes / 1024,
+				(unsigned long long)total.route_bytes / 1024,
+				(unsigned long long)total.chains,
+				(unsigned long long)total.pathmap_bytes / 1024,
+				(double)total.bytes() / total.routes);
+    }
+    DOUT(_info) << c_format("  RIB routes %lld, sent %llu UPDATEs, "
+			    "%llu bytes, encode %.2f us/UPDATE\n",
+			    (long long)_rib->routes(),
+			    (unsigned long long)messages,
+			    (unsigned long long)bytes,
+			    messages > 0 ? encode_secs * 1e6 / messages : 0);
+}
+
+bool
+Replay::check(size_t routes)
+{
+    vector<PeerHandler *>::iterator i;
+    for (i = _handlers.begin(); i != _handlers.end(); ++i) {
+	uint32_t n = _plumbing->get_prefix_count(*i);
+	if (n != routes) {
+	    DOUT(_info) << (*i)->peername() << " RibIn has " << n
+			<< " routes, " << routes << " expected\n";
+	    return false;
+	}
+    }
+
+    if (_rib->routes() != (int64_t)routes) {
+	DOUT(_info) << "The RIB has " << _rib->routes() << " routes, "
+		    << routes << " expected\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_replay(TestInfo& info, BGPMain *bgp, uint32_t peers, uint32_t routes,
+	    string dump, string updates)
+{
+    DOUT(info) << "test_replay: " << endl;
+
+    Updates table, stream, withdraw;
+    set<IPv4Net> live;
+
+    // Without either file the workload is synthetic, else only the
+    // files given are replayed.
+    bool synthetic = dump.empty() && updates.empty();
+    if ((synthetic || !dump.empty()) &&
+	!load_table(info, bgp, routes, dump, table, live))
+	return false;
+    size_t table_live = live.size();
+    if ((synthetic || !updates.empty()) &&
+	!load_stream(info, bgp, routes, updates, stream, live))
+	return false;
+    withdraw_workload(live, withdraw);
+
+    Replay replay(info, *bgp, peers);
+
+    replay.run("table", table);
+    if (!replay.check(table_live))
+	return false;
+
+    replay.run("updates", stream);
+    if (!replay.check(live.size()))
+	return false;
+
+    replay.run("withdraw", withdraw);
+    if (!replay.check(0))
+	return false;
+
+    return true;
+}
+
+/*
+** The time it takes to dump the table to peers that come up: one at
+** a time, and many at once, with and without the fast dump mode.
+*/
+bool
+test_resets(TestInfo& info, BGPMain *bgp, uint32_t routes, string dump)
+{
+    DOUT(info) << "test_resets: " << endl;
+
+    static const uint32_t MAX_RESETS = 20;
+
+    Updates table;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+
+    Replay replay(info, *bgp, MAX_RESETS + 1);
+    replay.run("table", table);
+    if (!replay.check(live.size()))
+	return false;
+
+    bool ok = true;
+    for (int fast = 0; fast < 2; fast++) {
+	bgp->set_fast_dump(fast);
+	DOUT(info) << (fast ? "fast" : "normal") << " dump:\n";
+	if (!replay.reset_peers(1, table, live.size()))
+	    ok = false;
+	if (!replay.reset_peers(MAX_RESETS, table, live.size()))
+	    ok = false;
+    }
+    bgp->set_fast_dump(false);
+
+    return ok;
+}
+
+/*
+** The time it takes to encode the UPDATEs of a full table dump to
+** peers that come up, with and without the attribute encoding cache.
+*/
+bool
+test_encode(TestInfo& info, BGPMain *bgp, uint32_t peers, uint32_t routes,
+	    string dump)
+{
+    DOUT(info) << "test_encode: " << endl;
+
+    Updates table;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+
+    uint32_t resets = peers > 1 ? peers - 1 : 1;
+    Replay replay(info, *bgp, resets + 1);
+    replay.run("table", table);
+    if (!replay.check(live.size()))
+	return false;
+
+    AttributeEncodingCache& cache = AttributeEncodingCache::shared();
+    bool ok = true;
+    for (int enabled = 0; enabled < 2; enabled++) {
+	cache.set_enabled(enabled);
+	cache.reset_stats();
+	DOUT(info) << (enabled ? "cached" : "uncached") << " encoding:\n";
+	if (!replay.reset_peers(resets, table, live.size()))
+	    ok = false;
+	DOUT(info) << "  " << cache.str() << endl;
+    }
+
+    return ok;
+}
+
+/*
+** The time it takes to install a full table in the RIB, and to
+** withdraw it, with the XRLs to the RIB included.
+*/
+bool
+test_install(TestInfo& info, BGPMain *bgp, uint32_t routes, string dump)
+{
+    DOUT(info) << "test_install: " << endl;
+
+    Updates table, withdraw;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+    withdraw_workload(live, withdraw);
+
+    EventLoop& eventloop = bgp->eventloop();
+    XrlStubRib rib(eventloop);
+    Replay replay(info, *bgp, 1);
+    replay.rib()->register_ribname(rib.name());
+
+    bool ok = replay.install("table", table, rib, live.size()) &&
+	replay.install("withdraw", withdraw, rib, 0);
+
+    // Wait for the tables to go, so no replies arrive after the
+    // RibIpcHandler is deleted.
+    replay.rib()->register_ribname("");
+    bool timed_out = false;
+    XorpTimer t = eventloop.set_flag_after_ms(10 * 1000, &timed_out);
+    while ((rib.tables() > 0 || replay.rib()->busy()) && !timed_out)
+	eventloop.run();
+    timed_out = false;
+    t = eventloop.set_flag_after_ms(100, &timed_out);
+    while (!timed_out)
+	eventloop.run();
+
+    return ok;
+}
+
+/*
+** The user and system CPU time used by the process, in seconds.
+*/
+static double
+cpu_secs()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+	return 0;
+
+    return TimeVal(ru.ru_utime).get_double() +
+	TimeVal(ru.ru_stime).get_double();
+}
+
+/*
+** The peak resident set size of the process, in KB.  The tries are
+** allocated from slabs, which the stage accounting does not see.
+*/
+static long
+max_rss_kb()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+	return 0;
+
+    return ru.ru_maxrss;
+}
+
+/*
+** Flap every route until it is damped, and time the flaps and the
+** release of the damped routes from the reuse lists.
+*/
+bool
+test_damping(TestInfo& info, BGPMain *bgp, uint32_t routes, string dump)
+{
+    DOUT(info) << "test_damping: " << endl;
+
+    // Four announcements take the figure of merit over the cutoff
+    // threshold.  The routes are then held for the maximum hold down
+    // time of a minute, and released together.
+    static const uint32_t FLAPS = 3;
+    static const uint32_t MAX_HOLD_DOWN = 1;
+    static const uint32_t TIMEOUT_MS = 600 * 1000;
+
+    Updates table, withdraw;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+    withdraw_workload(live, withdraw);
+
+    Damping& damping = bgp->get_local_data()->get_damping();
+    bool saved_damping = damping.get_damping();
+    damping.set_damping(true);
+    damping.set_max_hold_down(MAX_HOLD_DOWN);
+
+    bool ok = true;
+    {
+	Replay replay(info, *bgp, 1);
+	replay.run("table", table);
+	if (!replay.check(live.size()))
+	    ok = false;
+
+	double cpu = cpu_secs();
+	TimeVal start, end;
+	TimerList::system_gettimeofday(&start);
+	for (uint32_t i = 0; i < FLAPS && ok; i++) {
+	    replay.run(c_format("withdraw %u", XORP_UINT_CAST(i + 1)),
+		       withdraw);
+	    replay.run(c_format("table %u", XORP_UINT_CAST(i + 2)), table);
+	}
+	TimerList::system_gettimeofday(&end);
+	if (ok && replay.rib()->routes() != 0) {
+	    DOUT(info) << "The RIB has " << replay.rib()->routes()
+		       << " routes, none should be used while damped\n";
+	    ok = false;
+	}
+	DOUT(info) << c_format("flaps: %u of %u routes in %.3f s, "
+			       "%.3f s CPU, damping heap %lld KB, "
+			       "max RSS %ld KB\n",
+			       XORP_UINT_CAST(FLAPS),
+			       XORP_UINT_CAST(live.size()),
+			       (end - start).get_double(), cpu_secs() - cpu,
+			       (long long)stage_heap[STAGE_DAMPING] / 1024,
+			       max_rss_kb());
+
+	// Wait for the reuse lists to release the routes.
+	cpu = cpu_secs();
+	TimerList::system_gettimeofday(&start);
+	bool timed_out = false;
+	XorpTimer t = bgp->eventloop().set_flag_after_ms(TIMEOUT_MS,
+							 &timed_out);
+	while (ok && replay.rib()->routes() != (int64_t)live.size() &&
+	       !timed_out)
+	    bgp->eventloop().run();
+	TimerList::system_gettimeofday(&end);
+	if (ok && !replay.check(live.size()))
+	    ok = false;
+	DOUT(info) << c_format("release: %u routes after %.3f s, "
+			       "%.3f s CPU, damping heap %lld KB, "
+			       "max RSS %ld KB\n",
+			       XORP_UINT_CAST(replay.rib()->routes()),
+			       (end - start).get_double(), cpu_secs() - cpu,
+			       (long long)stage_heap[STAGE_DAMPING] / 1024,
+			       max_rss_kb());
+
+	replay.run("withdraw", withdraw);
+	if (ok && !replay.check(0))
+	    ok = false;
+    }
+
+    damping.set_max_hold_down(60);
+    damping.set_damping(saved_damping);
+
+    return ok;
+}
+
+/*
+** Damp routes while the reuse timer is running late, as it does on a
+** busy eventloop, and check that they are all released once their
+** reuse time has passed.
+*/
+bool
+test_damping_late(TestInfo& info, BGPMain *bgp, uint32_t routes,
+		  string dump)
+{
+    DOUT(info) << "test_damping_late: " << endl;
+
+    // The first UPDATE of the table is damped to start the reuse
+    // timer, and the rest once the eventloop has been held up for
+    // longer than two reuse lists.  Their reuse time of a minute then
+    // lies beyond the end of the ring of reuse lists.
+    static const uint32_t FLAPS = 3;
+    static const uint32_t MAX_HOLD_DOWN = 1;
+    static const uint32_t LATE_SECS = 3 * Damping::REUSE_GRANULARITY;
+    static const uint32_t TIMEOUT_MS = 180 * 1000;
+
+    Updates table;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+    if (table.size() < 2) {
+	DOUT(info) << "The table must have at least two UPDATEs\n";
+	return false;
+    }
+
+    Updates first(table.begin(), table.begin() + 1);
+    Updates rest(table.begin() + 1, table.end());
+    set<IPv4Net> first_live(first[0].nlri.begin(), first[0].nlri.end());
+    set<IPv4Net> rest_live;
+    set_difference(live.begin(), live.end(),
+		   first_live.begin(), first_live.end(),
+		   inserter(rest_live, rest_live.begin()));
+    Updates first_withdraw, rest_withdraw, withdraw;
+    withdraw_workload(first_live, first_withdraw);
+    withdraw_workload(rest_live, rest_withdraw);
+    withdraw_workload(live, withdraw);
+
+    Damping& damping = bgp->get_local_data()->get_damping();
+    bool saved_damping = damping.get_damping();
+    damping.set_damping(true);
+    damping.set_max_hold_down(MAX_HOLD_DOWN);
+
+    bool ok = true;
+    {
+	Replay replay(info, *bgp, 1);
+	replay.run("table", table);
+	if (!replay.check(live.size()))
+	    ok = false;
+
+	for (uint32_t i = 0; i < FLAPS && ok; i++) {
+	    replay.run("withdraw first", first_withdraw);
+	    replay.run("table first", first);
+	    replay.run("withdraw rest", rest_withdraw);
+	    if (i + 1 < FLAPS)
+		replay.run("table rest", rest);
+	}
+
+	// Hold up the eventloop, then damp the rest before the reuse
+	// timer gets to run.
+	sleep(LATE_SECS);
+	bgp->eventloop().timer_list().advance_time();
+	replay.run("table rest", rest);
+	if (ok && replay.rib()->routes() != 0) {
+	    DOUT(info) << "The RIB has " << replay.rib()->routes()
+		       << " routes, none should be used while damped\n";
+	    ok = false;
+	}
+
+	TimeVal start, end;
+	TimerList::system_gettimeofday(&start);
+	bool timed_out = false;
+	XorpTimer t = bgp->eventloop().set_flag_after_ms(TIMEOUT_MS,
+							 &timed_out);
+	while (ok && replay.rib()->routes() != (int64_t)live.size() &&
+	       !timed_out)
+	    bgp->eventloop().run();
+	TimerList::system_gettimeofday(&end);
+	DOUT(info) << c_format("release: %u of %u routes after %.3f s\n",
+			       XORP_UINT_CAST(replay.rib()->routes()),
+			       XORP_UINT_CAST(live.size()),
+			       (end - start).get_double());
+	if (ok && !replay.check(live.size()))
+	    ok = false;
+
+	replay.run("withdraw", withdraw);
+	if (ok && !replay.check(0))
+	    ok = false;
+    }
+
+    damping.set_max_hold_down(60);
+    damping.set_damping(saved_damping);
+
+    return ok;
+}
+
+/*
+** An import policy rejecting the routes in a prefix list.
+*/
+static string
+reject_policy(const set<IPv4Net>& nets)
+{
+    string conf = c_format("POLICY_START reject\n"
+			   "TERM_START listed\n"
+			   "PUSH_SET listed\n"
+			   "LOAD %d\n"
+			   "<=\n"
+			   "ONFALSE_EXIT\n"
+			   "REJECT\n"
+			   "TERM_END\n"
+			   "POLICY_END\n",
+			   BGPVarRW<IPv4>::VAR_NETWORK4);
+
+    string elems;
+    set<IPv4Net>::const_iterator i;
+    for (i = nets.begin(); i != nets.end(); ++i) {
+	if (!elems.empty())
+	    elems += ",";
+	elems += i->str();
+    }
+
+    return conf + "SET set_ipv4net listed \"" + elems + "\"\n";
+}
+
+/*
+** The time it takes for a change of the prefix list of an import
+** policy to reach the RIB and the peers, pushing all the routes
+** through the policy filters and only the routes the change affects.
+*/
+bool
+test_policy(TestInfo& info, BGPMain *bgp, uint32_t peers, uint32_t routes,
+	    string dump)
+{
+    DOUT(info) << "test_policy: " << endl;
+
+    // A prefix list of one route in LISTED, edited by EDITED routes.
+    static const uint32_t LISTED = 100;
+    static const uint32_t EDITED = 10;
+
+    Updates table;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+
+    set<IPv4Net> listed, edited;
+    uint32_t n = 0;
+    set<IPv4Net>::const_iterator i;
+    for (i = live.begin(); i != live.end(); ++i, ++n) {
+	if (n % LISTED == 0)
+	    listed.insert(*i);
+	else if (n % LISTED == LISTED / 2 && edited.size() < EDITED)
+	    edited.insert(*i);
+    }
+    set<IPv4Net> listed_edited(listed);
+    listed_edited.insert(edited.begin(), edited.end());
+
+    Replay replay(info, *bgp, peers);
+    replay.run("table", table);
+    if (!replay.check(live.size()))
+	return false;
+
+    if (!replay.push_policy("initial", reject_policy(listed), false,
+			    live.size() - listed.size()))
+	return false;
+
+    bool ok = true;
+    for (int incremental = 0; incremental < 2; incremental++) {
+	if (!replay.push_policy("add", reject_policy(listed_edited),
+				incremental,
+				live.size() - listed_edited.size()))
+	    ok = false;
+	if (!replay.push_policy("remove", reject_policy(listed), incremental,
+				live.size() - listed.size()))
+	    ok = false;
+    }
+
+    // Changing the policy again while a push is in progress restarts the
+    // push, which does not know what the first push left to do, so all
+    // the routes are pushed.
+    if (!replay.push_policy("restart", reject_policy(listed_edited), true,
+			    live.size() - listed.size(),
+			    reject_policy(listed)))
+	ok = false;
+
+    return ok;
+}
+
+/*
+** An export policy of <terms> terms, most of which do not match a
+** route: half match the routes of a short prefix list and set their MED,
+** half reject the routes of a MED computed from constants.  The last
+** term sets the MED of the routes no other term matched.
+*/
+static string
+export_policy(const set<IPv4Net>& live, uint32_t terms)
+{
+    // One route in LISTED is in the prefix list of a term, which holds
+    // up to PREFIXES networks.
+    static const uint32_t LISTED = 1000;
+    static const uint32_t PREFIXES = 4;
+
+    vector<string> elems(terms);
+    vector<uint32_t> prefixes(terms);
+    uint32_t n = 0;
+    set<IPv4Net>::const_iterator i;
+    for (i = live.begin(); i != live.end(); ++i, ++n) {
+	uint32_t t = n % LISTED;
+	if (t >= terms - 1 || t % 2 != 0 || prefixes[t] == PREFIXES)
+	    continue;
+	if (!elems[t].empty())
+	    elems[t] += ",";
+	elems[t] += i->str();
+	prefixes[t]++;
+    }
+
+    string conf = "POLICY_START export\n";
+    string sets;
+    for (uint32_t t = 0; t < terms - 1; t++) {
+	conf += c_format("TERM_START term%u\n", XORP_UINT_CAST(t));
+	if (t % 2 == 0) {
+	    conf += c_format("PUSH_SET listed%u\n"
+			     "LOAD %d\n"
+			     "<=\n"
+			     "ONFALSE_EXIT\n"
+			     "PUSH u32 %u\n"
+			     "STORE %d\n"
+			     "ACCEPT\n",
+			     XORP_UINT_CAST(t), BGPVarRW<IPv4>::VAR_NETWORK4,
+			     XORP_UINT_CAST(t + 1), BGPVarRW<IPv4>::VAR_MED);
+	    sets += c_format("SET set_ipv4net listed%u \"%s\"\n",
+			     XORP_UINT_CAST(t), elems[t].c_str());
+	} else {
+	    conf += c_format("PUSH u32 %u\n"
+			     "PUSH u32 1000\n"
+			     "+\n"
+			     "LOAD %d\n"
+			     "==\n"
+			     "ONFALSE_EXIT\n"
+			     "REJECT\n",
+			     XORP_UINT_CAST(t), BGPVarRW<IPv4>::VAR_MED);
+	}
+	conf += "TERM_END\n";
+    }
+    conf += c_format("TERM_START last\n"
+		     "PUSH u32 %u\n"
+		     "STORE %d\n"
+		     "TERM_END\n"
+		     "POLICY_END\n",
+		     XORP_UINT_CAST(terms), BGPVarRW<IPv4>::VAR_MED);
+
+    return conf + sets;
+}
+
+/*
+** The rate of routes through an export policy of 50 terms, with the
+** policies compiled and interpreted.
+*/
+bool
+test_export(TestInfo& info, BGPMain *bgp, uint32_t peers, uint32_t routes,
+	    string dump)
+{
+    DOUT(info) << "test_export: " << endl;
+
+    static const uint32_t TERMS = 50;
+
+    Updates table, withdraw;
+    set<IPv4Net> live;
+
+    if (!load_table(info, bgp, routes, dump, table, live))
+	return false;
+    withdraw_workload(live, withdraw);
+
+    // The routes of a peer are exported to the others.
+    if (peers < 2)
+	peers = 2;
+    string conf = export_policy(live, TERMS);
+
+    bool ok = true;
+    double rate[2];
+    uint64_t digest[2];
+    for (int compile = 0; compile < 2; compile++) {
+	PolicyFilter::set_compile(compile);
+	DOUT(info) << (compile ? "compiled" : "interpreted") << " policy:\n";
+
+	Replay replay(info, *bgp, peers);
+	replay.configure_policy(filter::EXPORT, conf);
+	replay.run("table", table);
+	if (!replay.check(live.size()))
+	    ok = false;
+	rate[compile] = stage_secs[STAGE_FANOUT] > 0 ?
+	    stage_routes[STAGE_FANOUT] / stage_secs[STAGE_FANOUT] : 0;
+	digest[compile] = replay.digest();
+
+	replay.run("withdraw", withdraw);
+	if (!replay.check(0))
+	    ok = false;
+    }
+    PolicyFilter::set_compile(true);
+
+    DOUT(info) << c_format("export policy of %u terms: %.0f routes/s "
+			   "interpreted, %.0f routes/s compiled\n",
+			   XORP_UINT_CAST(TERMS), rate[0], rate[1]);
+    if (digest[0] != digest[1]) {
+	DOUT(info) << "The peers were sent different UPDATEs\n";
+	ok = false;
+    }
+
+    return ok;
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    string dump =
+	t.get_optional_args("-d", "--dump", "MRT table dump to replay");
+    string updates =
+	t.get_optional_args("-u", "--updates",
+			    "MRT update stream to replay (replay test only)");
+    string peers_arg =
+	t.get_optional_args("-p", "--peers", "number of peers (default 2)");
+    string routes_arg =
+	t.get_optional_args("-n", "--routes",
+			    "number of synthetic routes (default 20000)");
+    bool damping = t.get_optional_flag("-D", "--damping",
+				       "enable route flap damping");
+    t.complete_args_parsing();
+
+    uint32_t peers = peers_arg.empty() ? 2 : atoi(peers_arg.c_str());
+    uint32_t routes = routes_arg.empty() ? 20000 : atoi(routes_arg.c_str());
+    if (peers < 1 || peers > 500) {
+	t.failed("The number of peers must be between 1 and 500\n");
+	return t.exit();
+    }
+
+    try {
+	EventLoop eventloop;
+
+	// The BGP constructor expects to use the finder.
+	FinderServer finder(eventloop, FinderConstants::FINDER_DEFAULT_HOST(),
+			    FinderConstants::FINDER_DEFAULT_PORT());
+	BGPMain bgp(eventloop);
+	bgp.get_local_data()->set_as(AsNum(65000));
+	bgp.get_local_data()->set_id(IPv4("10.255.0.1"));
+	bgp.get_local_data()->get_damping().set_damping(damping);
+
+	struct test {
+	    string test_name;
+	    XorpCallback1<bool, TestInfo&>::RefPtr cb;
+	} tests[] = {
+	    {"replay", callback(test_replay, &bgp, peers, routes, dump,
+				updates)},
+	    {"resets", callback(test_resets, &bgp, routes, dump)},
+	    {"install", callback(test_install, &bgp, routes, dump)},
+	    {"encode", callback(test_encode, &bgp, peers, routes, dump)},
+	    {"damping", callback(test_damping, &bgp, routes, dump)},
+	    {"damping_late", callback(test_damping_late, &bgp, routes,
+				      dump)},
+	    {"policy", callback(test_policy, &bgp, peers, routes, dump)},
+	    {"export", callback(test_export, &bgp, peers, routes, dump)},
+	};
+
+	if("" == test_name) {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	} else {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		if(test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
@@ -0,0 +1,473 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/test_main.hh"
+#include "libxorp/timeval.hh"
+#include "libxorp/timer.hh"
+
+#include "local_data.hh"
+#include "packet.hh"
+#include "path_attribute.hh"
+#include "update_decoder.hh"
+
+
+typedef vector<vector<uint8_t> > Messages;
+
+/*
+** Encode an update packet announcing <count> /24s, starting with
+** 10.<n>.0.0/24, and withdrawing the same number of /24s in 172.16/12.
+*/
+static vector<uint8_t>
+make_message(BGPPeerData* peerdata, uint32_t n, uint32_t count)
+{
+    UpdatePacket p;
+    FPAList4Ref fpa_list = p.pa_list();
+
+    NextHopAttribute<IPv4> nexthop_att(IPv4("10.0.0.1"));
+    fpa_list->add_path_attribute(nexthop_att);
+    ASPathAttribute aspath_att(ASPath("2,3,4"));
+    fpa_list->add_path_attribute(aspath_att);
+    OriginAttribute origin_att(IGP);
+    fpa_list->add_path_attribute(origin_att);
+    MEDAttribute med_att(n);
+    fpa_list->add_path_attribute(med_att);
+
+    for (uint32_t i = 0; i < count; i++) {
+	uint32_t a = 0x0a000000 | ((n & 0xff) << 16) | (i << 8);
+	p.add_nlri(BGPUpdateAttrib(IPv4Net(IPv4(htonl(a)), 24)));
+	uint32_t w = 0xac100000 | (((n * count + i) & 0xfff) << 8);
+	p.add_withdrawn(BGPUpdateAttrib(IPv4Net(IPv4(htonl(w)), 24)));
+    }
+
+    uint8_t buf[BGPPacket::MAXPACKETSIZE];
+    size_t len = BGPPacket::MAXPACKETSIZE;
+    XLOG_ASSERT(p.encode(buf, len, peerdata));
+
+    return vector<uint8_t>(buf, buf + len);
+}
+
+/*
+** The messages used by the tests: correct ones, some with duplicate
+** prefixes, and some corrupt in different sections.
+*/
+static Messages
+make_messages(BGPPeerData* peerdata, uint32_t messages, uint32_t count)
+{
+    Messages m;
+
+    for (uint32_t n = 0; n < messages; n++)
+	m.push_back(make_message(peerdata, n, count));
+
+    // A duplicate NLRI, added at the end of the message.
+    vector<uint8_t> dup = make_message(peerdata, 1, 2);
+    dup.insert(dup.end(), dup.end() - 4, dup.end());
+    embed_16(&dup[BGPPacket::LENGTH_OFFSET], dup.size());
+    m.push_back(dup);
+
+    // Withdrawn routes length too large.
+    vector<uint8_t> wr = make_message(peerdata, 2, 2);
+    embed_16(&wr[BGPPacket::COMMON_HEADER_LEN], 0xfff0);
+    m.push_back(wr);
+
+    // Truncated NLRI.
+    vector<uint8_t> nlri = make_message(peerdata, 3, 2);
+    nlri.resize(nlri.size() - 1);
+    embed_16(&nlri[BGPPacket::LENGTH_OFFSET], nlri.size());
+    m.push_back(nlri);
+
+    // Truncated NLRI, and a missing well-known attribute: the
+    // attribute error is the one reported.
+    UpdatePacket p;
+    NextHopAttribute<IPv4> nexthop_att(IPv4("10.0.0.1"));
+    p.add_pathatt(nexthop_att);
+    p.add_nlri(BGPUpdateAttrib(IPv4Net("10.1.0.0/16")));
+    uint8_t buf[BGPPacket::MAXPACKETSIZE];
+    size_t len = BGPPacket::MAXPACKETSIZE;
+    XLOG_ASSERT(p.encode(buf, len, peerdata));
+    vector<uint8_t> both(buf, buf + len - 1);
+    embed_16(&both[BGPPacket::LENGTH_OFFSET], both.size());
+    m.push_back(both);
+
+    return m;
+}
+
+/*
+** The outcome of decoding a message, to compare the decoders.
+*/
+static string
+inline_decode(const vector<uint8_t>& m, BGPPeerData* peerdata)
+{
+    try {
+	UpdatePacket p(&m[0], m.size(), peerdata, NULL, true);
+	return p.str();
+    } catch(CorruptMessage& c) {
+	return c_format("corrupt %d %d", c.error(), c.subcode());
+    }
+}
+
+static string
+decoded_outcome(DecodedUpdate& du)
+{
+    try {
+	UpdatePacket p(du, NULL);
+	// The paths are compared by pointer once handed over.
+	FPAList4Ref pa_list = p.pa_list();
+	if (pa_list->aspath_att() != NULL && !pa_list->aspath().interned())
+	    return "AS path not interned";
+	return p.str();
+    } catch(CorruptMessage& c) {
+	return c_format("corrupt %d %d", c.error(), c.subcode());
+    }
+}
+
+bool
+test_decode(TestInfo& info, BGPPeerData* peerdata)
+{
+    DOUT(info) << "test_decode: " << endl;
+
+    Messages m = make_messages(peerdata, 10, 20);
+
+    for (size_t i = 0; i < m.size(); i++) {
+	DecodedUpdate du(&m[i][0], m[i].size(), peerdata);
+	du.decode();
+	string expected = inline_decode(m[i], peerdata);
+	string got = decoded_outcome(du);
+	DOUT(info) << i << ": " << (expected.size() < 40 ? expected : "ok")
+		   << endl;
+	if (expected != got) {
+	    DOUT(info) << "Message " << i << " decoded differently:\n"
+		       << expected << "\n" << got << endl;
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+/*
+** Paths built while interning is deferred stay out of the intern table
+** until they are interned.
+*/
+bool
+test_intern(TestInfo& info)
+{
+    DOUT(info) << "test_intern: " << endl;
+
+    ASPath interned("1,2,3");
+    size_t paths = ASPath::interned_paths();
+
+    ASPath *same, *other;
+    {
+	ASPath::DeferIntern defer;
+	same = new ASPath("1,2,3");
+	other = new ASPath("4,5,6");
+    }
+    ASPath after("7,8,9");
+
+    if (same->interned() || other->interned() || !after.interned()
+	|| ASPath::interned_paths() != paths + 1) {
+	DOUT(info) << "Only the path built after should be interned\n";
+	return false;
+    }
+    if (same->path_length() != 3 || same->str() != interned.str()) {
+	DOUT(info) << "A deferred path should be complete\n";
+	return false;
+    }
+
+    same->intern();
+    other->intern();
+    if (*same != interned || !other->interned()
+	|| ASPath::interned_paths() != paths + 2) {
+	DOUT(info) << "Interning should share the equal paths\n";
+	return false;
+    }
+
+    delete same;
+    delete other;
+    if (ASPath::interned_paths() != paths + 1) {
+	DOUT(info) << "The paths should be released\n";
+	return false;
+    }
+
+    return true;
+}
+
+/*
+** Take the messages from a queue as they are decoded, and check they
+** come out in order.
+*/
+class QueueReader {
+public:
+    QueueReader(UpdateDecoder& decoder, BGPPeerData* peerdata,
+		const Messages& m)
+	: _queue(decoder, peerdata, callback(this, &QueueReader::ready)),
+	  _peerdata(peerdata), _messages(m), _next(0), _bad(false)
+    {}
+
+    void ready() {
+	while (_queue.front() != NULL) {
+	    DecodedUpdate* du = _queue.pop();
+	    if (decoded_outcome(*du)
+		!= inline_decode(_messages[_next], _peerdata))
+		_bad = true;
+	    delete du;
+	    _next++;
+	}
+    }
+
+    UpdateDecodeQueue& queue()		{ return _queue; }
+    bool done() const			{ return _next == _messages.size(); }
+    bool bad() const			{ return _bad; }
+
+private:
+    UpdateDecodeQueue _queue;
+    BGPPeerData* _peerdata;
+    const Messages& _messages;
+    size_t _next;
+    bool _bad;
+};
+
+bool
+test_threads(TestInfo& info, EventLoop* eventloop, BGPPeerData* peerdata)
+{
+    DOUT(info) << "test_threads: " << endl;
+
+    UpdateDecoder decoder(*eventloop);
+    string error_msg;
+    if (decoder.set_threads(3, error_msg) != XORP_OK) {
+	DOUT(info) << error_msg << endl;
+	return false;
+    }
+
+    Messages m1 = make_messages(peerdata, 200, 5);
+    Messages m2 = make_messages(peerdata, 100, 50);
+    {
+	QueueReader r1(decoder, peerdata, m1);
+	QueueReader r2(decoder, peerdata, m2);
+
+	for (size_t i = 0; i < max(m1.size(), m2.size()); i++) {
+	    if (i < m1.size())
+		r1.queue().push(&m1[i][0], m1[i].size());
+	    if (i < m2.size())
+		r2.queue().push(&m2[i][0], m2[i].size());
+	}
+
+	while (!r1.done() || !r2.done())
+	    eventloop->run();
+
+	if (r1.bad() || r2.bad()) {
+	    DOUT(info) << "Messages decoded differently\n";
+	    return false;
+	}
+
+	/*
+	** Messages still queued are dropped with the queue.
+	*/
+	for (size_t i = 0; i < m1.size(); i++)
+	    r1.queue().push(&m1[i][0], m1[i].size());
+    }
+
+    /*
+    ** Without threads a message is decoded when it is queued.
+    */
+    if (decoder.set_threads(0, error_msg) != XORP_OK) {
+	DOUT(info) << error_msg << endl;
+	return false;
+    }
+    QueueReader r(decoder, peerdata, m1);
+    r.queue().push(&m1[0][0], m1[0].size());
+    if (r.queue().front() == NULL) {
+	DOUT(info) << "Message should be decoded\n";
+	return false;
+    }
+    r.queue().clear();
+
+    return true;
+}
+
+static void
+ignore_ready()
+{
+}
+
+/*
+** The CPU time used by the calling thread in seconds, or 0 if it
+** cannot be measured.
+*/
+static double
+thread_cpu_time()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    return 0;
+}
+
+/*
+** Decode the same stream of messages with more and more threads.  The
+** CPU time of the main thread shows how much of the work is left to it.
+*/
+bool
+test_benchmark(TestInfo& info, EventLoop* eventloop, BGPPeerData* peerdata,
+	       uint32_t messages)
+{
+    DOUT(info) << "test_benchmark: " << endl;
+
+    Messages m = make_messages(peerdata, 100, 200);
+    m.resize(100);
+
+    static const uint32_t threads[] = { 0, 1, 2, 4 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+	UpdateDecoder decoder(*eventloop);
+	string error_msg;
+	if (decoder.set_threads(threads[t], error_msg) != XORP_OK) {
+	    DOUT(info) << error_msg << endl;
+	    return false;
+	}
+
+	TimeVal start, end;
+	TimerList::system_gettimeofday(&start);
+	double cpu = thread_cpu_time();
+
+	size_t prefixes = 0;
+	{
+	    // The queue is polled rather than woken up.
+	    UpdateDecodeQueue queue(decoder, peerdata, callback(ignore_ready));
+	    for (uint32_t i = 0; i < messages; i++) {
+		const vector<uint8_t>& msg = m[i % m.size()];
+		queue.push(&msg[0], msg.size());
+		// What the main thread would do.
+		DecodedUpdate* du;
+		while ((du = queue.front()) != NULL) {
+		    UpdatePacket p(*du, NULL);
+		    prefixes += p.nlri_list().size() + p.wr_list().size();
+		    delete queue.pop();
+		}
+	    }
+	    queue.wait();
+	    while (!queue.empty()) {
+		DecodedUpdate* du = queue.pop();
+		UpdatePacket p(*du, NULL);
+		prefixes += p.nlri_list().size() + p.wr_list().size();
+		delete du;
+	    }
+	}
+
+	cpu = thread_cpu_time() - cpu;
+	TimerList::system_gettimeofday(&end);
+	double secs = (end - start).get_double();
+	DOUT(info) << threads[t] << " threads: " << messages << " messages, "
+		   << prefixes << " prefixes in " << (end - start).str()
+		   << " seconds, " << (secs > 0 ? messages / secs : 0)
+		   << " messages/s, main thread CPU " << cpu << " seconds"
+		   << endl;
+    }
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    bool run_benchmarks =
+	t.get_optional_flag("-b", "--benchmarks", "also run the benchmarks");
+    t.complete_args_parsing();
+
+    EventLoop eventloop;
+    LocalData localdata(eventloop);
+    localdata.set_as(AsNum(1));
+    Iptuple iptuple("", "10.0.0.1", 179, "10.0.0.2", 179);
+    BGPPeerData* peerdata = new BGPPeerData(localdata, iptuple, AsNum(2),
+					    IPv4(), 0);
+    peerdata->compute_peer_type();
+
+    try {
+	struct test {
+	    string test_name;
+	    XorpCallback1<bool, TestInfo&>::RefPtr cb;
+	} tests[] = {
+	    {"intern", callback(test_intern)},
+	    {"decode", callback(test_decode, peerdata)},
+	    {"threads", callback(test_threads, &eventloop, peerdata)},
+	};
+
+	/*
+	** Only run with -b, or when named with -t.
+	*/
+	struct test benchmarks[] = {
+	    {"benchmark", callback(test_benchmark, &eventloop, peerdata,
+				   static_cast<uint32_t>(5000))},
+	};
+
+	if("" == test_name) {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	    if (run_benchmarks)
+		for(unsigned int i = 0;
+		    i < sizeof(benchmarks) / sizeof(struct test); i++)
+		    t.run(benchmarks[i].test_name, benchmarks[i].cb);
+	} else {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		if(test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    delete peerdata;
+		    return t.exit();
+		}
+	    for(unsigned int i = 0;
+		i < sizeof(benchmarks) / sizeof(struct test); i++)
+		if(test_name == benchmarks[i].test_name) {
+		    t.run(benchmarks[i].test_name, benchmarks[i].cb);
+		    delete peerdata;
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    delete peerdata;
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
@@ -0,0 +1,686 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/test_main.hh"
+#include "libxorp/timer.hh"
+
+#include "libxipc/finder_server.hh"
+
+#include "policy/backend/version_filters.hh"
+
+#include "bgp.hh"
+#include "plumbing.hh"
+#include "bgp_varrw.hh"
+#include "dummy_next_hop_resolver.hh"
+#include "update_group.hh"
+
+// Implementation Notes:
+//
+// The peers are BGPPeers without a socket, plumbed into a BGPPlumbing
+// of their own with a stub next hop resolver and RIB, as in
+// test_replay.  The routes come from one EBGP peer and are sent to
+// the members of the update groups, other EBGP peers, which record
+// the routes they are sent and whether they were sent them by their
+// own output branch or by the branch of their group.  The members may
+// instead be IBGP route reflector clients, which announce routes of
+// their own.
+
+/*
+** A peer that records the routes it is sent.
+*/
+class GroupPeer : public BGPPeer {
+public:
+    GroupPeer(LocalData *ld, BGPPeerData *pd, BGPMain *m)
+	: BGPPeer(ld, pd, NULL, m), _own(0), _shared(0), _mismatch(0),
+	  _busy(false)
+    {}
+
+    PeerOutputState send_update_message(const UpdatePacket& p) {
+	_own++;
+	record(p);
+	return PEER_OUTPUT_OK;
+    }
+
+    PeerOutputState send_shared_update(const UpdatePacket& p,
+				       ref_ptr<EncodedUpdate> wire) {
+	_shared++;
+	_wire = wire;
+	record(p);
+
+	// The group encoding must be the one of this peer.
+	uint8_t buf[BGPPacket::MAXPACKETSIZE];
+	size_t len = BGPPacket::MAXPACKETSIZE;
+	XLOG_ASSERT(p.encode(buf, len, peerdata()));
+	if (len != wire->size() || memcmp(buf, wire->data(), len) != 0)
+	    _mismatch++;
+
+	// A busy socket still queues the message.
+	return _busy ? PEER_OUTPUT_BUSY : PEER_OUTPUT_OK;
+    }
+
+    size_t routes() const		{ return _routes.size(); }
+    bool has(const IPv4Net& net) const	{
+	return _routes.find(net) != _routes.end();
+    }
+    uint32_t own() const		{ return _own; }
+    uint32_t shared() const		{ return _shared; }
+    uint32_t mismatch() const		{ return _mismatch; }
+    const EncodedUpdate* wire() const	{ return _wire.get(); }
+    void set_busy(bool busy)		{ _busy = busy; }
+
+private:
+    void record(const UpdatePacket& p) {
+	BGPUpdateAttribList::const_iterator i;
+	for (i = p.wr_list().begin(); i != p.wr_list().end(); ++i)
+	    _routes.erase(i->net());
+	for (i = p.nlri_list().begin(); i != p.nlri_list().end(); ++i)
+	    _routes.insert(i->net());
+    }
+
+    set<IPv4Net> _routes;
+    uint32_t _own;		// Messages sent by the own branch
+    uint32_t _shared;		// Messages sent by the group branch
+    uint32_t _mismatch;		// Shared messages encoded differently
+    ref_ptr<EncodedUpdate> _wire;
+    bool _busy;
+};
+
+/*
+** A RIB that takes the routes without passing them on.
+*/
+class StubRib : public RibIpcHandler {
+public:
+    StubRib(XrlStdRouter& xrl_router, BGPMain& bgp)
+	: RibIpcHandler(xrl_router, bgp)
+    {}
+
+    PeerOutputState push_packet()	{ return PEER_OUTPUT_OK; }
+};
+
+static bool
+keep_running()
+{
+    return true;
+}
+
+/*
+** A source peer and <members> group members, all EBGP or the members
+** route reflector clients, plumbed into a plumbing of their own.
+*/
+class Harness {
+public:
+    Harness(BGPMain& bgp, uint32_t members, bool clients = false);
+    ~Harness();
+
+    GroupPeer *member(uint32_t i)	{ return _peers[i + 1]; }
+    PeerHandler *handler(uint32_t i)	{ return _handlers[i + 1]; }
+    VersionFilters& policy_filters()	{ return _policy_filters; }
+
+    /**
+     * Add a member to the update group matching it.
+     */
+    UpdateGroup *join(uint32_t i) {
+	return _bgp.update_groups().join(member(i), handler(i));
+    }
+
+    /**
+     * Announce 10.<n>.0.0/16 from the source peer, with an AS path of
+     * its own so that each route is sent in an UPDATE of its own.
+     */
+    void announce(uint32_t n);
+    void withdraw(uint32_t n);
+
+    /**
+     * Announce 10.<n>.0.0/16 from member <i>, a route reflector
+     * client, with an AS path of <hops> ASes.
+     */
+    void announce_from(uint32_t i, uint32_t n, uint32_t hops);
+
+    /**
+     * Run the eventloop until the members in <mask> have <routes>
+     * routes, or for <ms> milliseconds if it is 0.
+     *
+     * @return true if the routes were sent.
+     */
+    bool run(uint32_t mask, size_t routes, int ms = 10000);
+
+private:
+    void announce(PeerHandler *handler, const IPv4& nexthop,
+		  const ASPath& path, bool ibgp, uint32_t n);
+
+    BGPMain& _bgp;
+    DummyNextHopResolver<IPv4> _nhr_ipv4;
+    DummyNextHopResolver<IPv6> _nhr_ipv6;
+    VersionFilters _policy_filters;
+    AggregationHandler _aggr_handler;
+    StubRib *_rib;
+    BGPPlumbing *_plumbing;
+    vector<GroupPeer *> _peers;		// The source first
+    vector<PeerHandler *> _handlers;
+};
+
+Harness::Harness(BGPMain& bgp, uint32_t members, bool clients)
+    : _bgp(bgp),
+      _nhr_ipv4(bgp.eventloop(), bgp), _nhr_ipv6(bgp.eventloop(), bgp)
+{
+    _rib = new StubRib(*bgp.get_router(), bgp);
+    _plumbing = new BGPPlumbing(SAFI_UNICAST, _rib, &_aggr_handler,
+				_nhr_ipv4, _nhr_ipv6, _policy_filters, bgp);
+    _rib->set_plumbing(_plumbing, _plumbing);
+
+    LocalData *local_data = bgp.get_local_data();
+    for (uint32_t i = 0; i <= members; i++) {
+	string addr = c_format("10.254.0.%u", XORP_UINT_CAST(i + 2));
+	Iptuple iptuple("", "10.255.0.1", 179, addr.c_str(), 179);
+	AsNum as(i == 0 ? 65100 : clients ? 65000 : 65200);
+	BGPPeerData *peer_data =
+	    new BGPPeerData(*local_data, iptuple, as, IPv4("10.255.0.1"), 0);
+	peer_data->set_id(IPv4(addr.c_str()));
+	peer_data->set_route_reflector(i != 0 && clients);
+	peer_data->compute_peer_type();
+	peer_data->set_multiprotocol<IPv4>(SAFI_UNICAST);
+	_nhr_ipv4.set_nexthop_metric(IPv4(addr.c_str()), 10);
+
+	GroupPeer *peer = new GroupPeer(local_data, peer_data, &bgp);
+	_peers.push_back(peer);
+	// Creating the PeerHandler adds the peering.
+	_handlers.push_back(new PeerHandler(c_format("peer%u",
+						     XORP_UINT_CAST(i)),
+					    peer, _plumbing, NULL));
+    }
+
+    // The empty table dumped to the peers as they came up.
+    run(0, 0, 100);
+}
+
+Harness::~Harness()
+{
+    for (uint32_t i = 1; i < _peers.size(); i++)
+	_bgp.update_groups().leave(_peers[i]);
+    // Deleting the PeerHandler deletes the peering.
+    for (uint32_t i = 0; i < _handlers.size(); i++)
+	delete _handlers[i];
+    for (uint32_t i = 0; i < _peers.size(); i++)
+	delete _peers[i];
+    // As in BGPMain, the RIB handler goes before the plumbing.
+    delete _rib;
+    delete _plumbing;
+}
+
+void
+Harness::announce(uint32_t n)
+{
+    string path = c_format("65100,%u", XORP_UINT_CAST(1000 + n));
+    announce(_handlers[0], IPv4("10.254.0.2"), ASPath(path.c_str()), false,
+	     n);
+}
+
+void
+Harness::announce_from(uint32_t i, uint32_t n, uint32_t hops)
+{
+    ASPath path;
+    for (uint32_t hop = 0; hop < hops; hop++)
+	path.prepend_as(AsNum(1000 + hop));
+    IPv4 nexthop(member(i)->peerdata()->iptuple().get_peer_addr().c_str());
+    announce(handler(i), nexthop, path, true, n);
+}
+
+void
+Harness::announce(PeerHandler *handler, const IPv4& nexthop,
+		  const ASPath& path, bool ibgp, uint32_t n)
+{
+    UpdatePacket p;
+    FPAList4Ref pa_list = new FastPathAttributeList<IPv4>();
+    NextHopAttribute<IPv4> nexthop_att(nexthop);
+    pa_list->add_path_attribute(nexthop_att);
+    ASPathAttribute aspath_att(path);
+    pa_list->add_path_attribute(aspath_att);
+    OriginAttribute origin_att(IGP);
+    pa_list->add_path_attribute(origin_att);
+    if (ibgp) {
+	LocalPrefAttribute localpref_att(LocalPrefAttribute::default_value());
+	pa_list->add_path_attribute(localpref_att);
+    }
+    p.replace_pathattribute_list(pa_list);
+    p.add_nlri(BGPUpdateAttrib(IPv4Net(IPv4(htonl(0x0a000000 | (n << 16))),
+				       16)));
+
+    handler->process_update_packet(&p);
+}
+
+void
+Harness::withdraw(uint32_t n)
+{
+    UpdatePacket p;
+    p.add_withdrawn(BGPUpdateAttrib(
+			IPv4Net(IPv4(htonl(0x0a000000 | (n << 16))), 16)));
+
+    _handlers[0]->process_update_packet(&p);
+}
+
+bool
+Harness::run(uint32_t mask, size_t routes, int ms)
+{
+    EventLoop& eventloop = _bgp.eventloop();
+
+    // A task that is always runnable stops EventLoop::run() from
+    // blocking in select() once the RibOuts have drained the fanout.
+    XorpTask spin = eventloop.new_task(callback(keep_running),
+				       XorpTask::PRIORITY_LOWEST,
+				       XorpTask::WEIGHT_DEFAULT);
+
+    TimeVal now, end;
+    eventloop.current_time(now);
+    end = now + TimeVal(0, ms * 1000);
+    bool done = false;
+    while (now < end) {
+	eventloop.run();
+	eventloop.current_time(now);
+	if (mask == 0)
+	    continue;
+	done = true;
+	for (uint32_t i = 0; i + 1 < _peers.size(); i++)
+	    if ((mask & (1 << i)) && member(i)->routes() != routes)
+		done = false;
+	if (done)
+	    break;
+    }
+    spin.unschedule();
+
+    return done;
+}
+
+bool
+test_keys(TestInfo& info, BGPMain *bgp)
+{
+    DOUT(info) << "test_keys: " << endl;
+
+    LocalData& localdata = *bgp->get_local_data();
+    Iptuple iptuple1("", "10.255.0.1", 179, "10.254.0.3", 179);
+    Iptuple iptuple2("", "10.255.0.1", 179, "10.254.0.4", 179);
+    BGPPeerData pd1(localdata, iptuple1, AsNum(65200), IPv4(), 0);
+    BGPPeerData pd2(localdata, iptuple2, AsNum(65200), IPv4(), 0);
+    BGPPeerData pd3(localdata, iptuple2, AsNum(65300), IPv4(), 0);
+    BGPPeerData pd4(localdata, iptuple2, AsNum(65200), IPv4(), 0);
+    pd1.compute_peer_type();
+    pd2.compute_peer_type();
+    pd3.compute_peer_type();
+    pd4.compute_peer_type();
+    pd4.set_use_4byte_asnums(!pd1.use_4byte_asnums());
+
+    DOUT(info) << UpdateGroupKey(&pd1, true).str() << endl;
+
+    if (!(UpdateGroupKey(&pd1, false) == UpdateGroupKey(&pd2, false))) {
+	DOUT(info) << "Peers of the same AS should be grouped\n";
+	return false;
+    }
+    if (UpdateGroupKey(&pd1, true) == UpdateGroupKey(&pd2, true)) {
+	DOUT(info) << "Peers keyed by address should not be grouped\n";
+	return false;
+    }
+    if (UpdateGroupKey(&pd2, false) == UpdateGroupKey(&pd3, false)) {
+	DOUT(info) << "EBGP peers of different ASes have different "
+		   << "outbound filters\n";
+	return false;
+    }
+    if (UpdateGroupKey(&pd2, false) == UpdateGroupKey(&pd4, false)) {
+	DOUT(info) << "Peers should be grouped by encoding\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_group(TestInfo& info, BGPMain *bgp)
+{
+    DOUT(info) << "test_group: " << endl;
+
+    Harness h(*bgp, 3);
+    UpdateGroup *g = h.join(0);
+    if (h.join(1) != g || h.join(2) != g) {
+	DOUT(info) << "The members should be in the same group\n";
+	return false;
+    }
+
+    // All up to date: they follow the branch of the group.
+    g->merge();
+    if (g->followers() != 3) {
+	DOUT(info) << g->str() << endl;
+	DOUT(info) << "The members should follow the group\n";
+	return false;
+    }
+
+    for (uint32_t n = 0; n < 10; n++)
+	h.announce(n);
+    if (!h.run(7, 10)) {
+	DOUT(info) << "The routes were not sent to the members\n";
+	return false;
+    }
+    DOUT(info) << g->str() << endl;
+
+    for (uint32_t i = 0; i < 3; i++) {
+	if (h.member(i)->own() != 0 || h.member(i)->mismatch() != 0
+	    || h.member(i)->shared() != g->stats().encodes) {
+	    DOUT(info) << "Member " << i << " was sent "
+		       << h.member(i)->own() << " messages by its branch, "
+		       << h.member(i)->shared() << " by the group\n";
+	    return false;
+	}
+    }
+    if (g->stats().encodes != 10) {
+	DOUT(info) << "Each UPDATE should be encoded once\n";
+	return false;
+    }
+    if (h.member(0)->wire() != h.member(1)->wire()
+	|| h.member(0)->wire() != h.member(2)->wire()) {
+	DOUT(info) << "The members should share the encoded message\n";
+	return false;
+    }
+
+    for (uint32_t n = 0; n < 10; n++)
+	h.withdraw(n);
+    if (!h.run(7, 0)) {
+	DOUT(info) << "The routes were not withdrawn\n";
+	return false;
+    }
+
+    // With a single follower left, the group branch goes away.
+    bgp->update_groups().leave(h.member(0));
+    bgp->update_groups().leave(h.member(1));
+    if (g->followers() != 0 || g->members() != 1) {
+	DOUT(info) << g->str() << endl;
+	DOUT(info) << "The group should have been dissolved\n";
+	return false;
+    }
+    h.announce(20);
+    if (!h.run(4, 1) || h.member(2)->own() != 1) {
+	DOUT(info) << "The member should be back on its own branch\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_slow(TestInfo& info, BGPMain *bgp)
+{
+    DOUT(info) << "test_slow: " << endl;
+
+    Harness h(*bgp, 3);
+    UpdateGroup *g = h.join(0);
+    h.join(1);
+    h.join(2);
+    g->merge();
+
+    /*
+    ** The third member stays busy: it falls out of the group once
+    ** it is behind by MAX_BEHIND messages, without holding up the
+    ** others.
+    */
+    h.member(2)->set_busy(true);
+    uint32_t routes = 2 * UpdateGroup::MAX_BEHIND;
+    for (uint32_t n = 0; n < routes; n++)
+	h.announce(n);
+    if (!h.run(3, routes)) {
+	DOUT(info) << "The other members should not be held up\n";
+	return false;
+    }
+    h.run(0, 0, 100);
+    DOUT(info) << g->str() << endl;
+
+    if (g->following(h.member(2)) || g->followers() != 2
+	|| g->stats().splits != 1) {
+	DOUT(info) << "The slow member should have left the group\n";
+	return false;
+    }
+
+    // Its own branch sends it what it missed.
+    h.member(2)->set_busy(false);
+    for (uint32_t n = routes; n < routes + 5; n++)
+	h.announce(n);
+    if (!h.run(7, routes + 5)) {
+	DOUT(info) << "The slow member should have been sent the routes\n";
+	return false;
+    }
+    if (h.member(2)->own() == 0) {
+	DOUT(info) << "The slow member should be on its own branch\n";
+	return false;
+    }
+
+    // Up to date again, it follows the group.
+    g->merge();
+    if (!g->following(h.member(2)) || g->stats().merges != 4) {
+	DOUT(info) << g->str() << endl;
+	DOUT(info) << "The member should follow the group again\n";
+	return false;
+    }
+    uint32_t own = h.member(2)->own();
+    h.withdraw(0);
+    if (!h.run(7, routes + 4) || h.member(2)->own() != own) {
+	DOUT(info) << "The member should be sent the group messages\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_policy(TestInfo& info, BGPMain *bgp)
+{
+    DOUT(info) << "test_policy: " << endl;
+
+    Harness h(*bgp, 3);
+    UpdateGroup *g = h.join(0);
+    h.join(1);
+    h.join(2);
+    g->merge();
+    size_t groups = bgp->update_groups().groups();
+
+    /*
+    ** An export policy that matches on the neighbor: the peers no
+    ** longer have the same output branch.
+    */
+    string conf = c_format("POLICY_START neighbor\n"
+			   "TERM_START second\n"
+			   "PUSH ipv4 10.254.0.4\n"
+			   "LOAD %d\n"
+			   "==\n"
+			   "ONFALSE_EXIT\n"
+			   "REJECT\n"
+			   "TERM_END\n"
+			   "POLICY_END\n",
+			   BGPVarRW<IPv4>::VAR_NEIGHBOR);
+    h.policy_filters().configure(filter::EXPORT, conf);
+    bgp->update_groups().regroup();
+
+    if (bgp->update_groups().groups() != groups + 2) {
+	DOUT(info) << "The peers should be grouped by address\n";
+	return false;
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+	if (h.member(i)->update_group()->members() != 1) {
+	    DOUT(info) << h.member(i)->update_group()->str() << endl;
+	    DOUT(info) << "The peers should be in groups of their own\n";
+	    return false;
+	}
+    }
+
+    h.announce(1);
+    if (!h.run(5, 1)) {
+	DOUT(info) << "The route should have been sent\n";
+	return false;
+    }
+    h.run(0, 0, 100);
+    if (h.member(1)->routes() != 0) {
+	DOUT(info) << "The route should have been filtered\n";
+	return false;
+    }
+
+    h.policy_filters().reset(filter::EXPORT);
+    bgp->update_groups().regroup();
+    if (bgp->update_groups().groups() != groups) {
+	DOUT(info) << "The peers should be grouped again\n";
+	return false;
+    }
+
+    return true;
+}
+
+static bool
+clients(TestInfo& info, BGPMain *bgp)
+{
+    Harness h(*bgp, 3, true);
+    UpdateGroup *g = h.join(0);
+    h.join(1);
+    h.join(2);
+    g->merge();
+    if (g->followers() != 3) {
+	DOUT(info) << g->str() << endl;
+	DOUT(info) << "The clients should follow the group\n";
+	return false;
+    }
+
+    /*
+    ** A route of the first client is reflected to the others, but not
+    ** sent back to it, as its own branch would not have.
+    */
+    IPv4Net net("10.1.0.0/16");
+    h.announce_from(0, 1, 2);
+    if (!h.run(6, 1)) {
+	DOUT(info) << "The route should have been reflected\n";
+	return false;
+    }
+    h.run(0, 0, 100);
+    DOUT(info) << g->str() << endl;
+    if (h.member(0)->routes() != 0 || h.member(0)->own() != 0
+	|| h.member(0)->shared() != 0) {
+	DOUT(info) << "The client was sent its own route\n";
+	return false;
+    }
+
+    /*
+    ** A better route of the second client replaces it: the first is
+    ** sent it, the second has the route it was sent withdrawn, and
+    ** the third is sent the replacement.
+    */
+    h.announce_from(1, 1, 1);
+    h.run(0, 0, 200);
+    DOUT(info) << g->str() << endl;
+    if (!h.member(0)->has(net) || h.member(1)->has(net)
+	|| !h.member(2)->has(net)) {
+	DOUT(info) << "The replacement was not sent as the branches of "
+		   << "the clients would have\n";
+	return false;
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+	if (h.member(i)->mismatch() != 0) {
+	    DOUT(info) << "Member " << i << " was sent a bad encoding\n";
+	    return false;
+	}
+    }
+    if (g->stats().rebuilt == 0 || g->followers() != 3) {
+	DOUT(info) << "The group should have sent the clients the "
+		   << "messages built for them\n";
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_clients(TestInfo& info, BGPMain *bgp)
+{
+    DOUT(info) << "test_clients: " << endl;
+
+    LocalData *local_data = bgp->get_local_data();
+    local_data->set_cluster_id(IPv4("10.255.0.1"));
+    local_data->set_route_reflector(true);
+    bool result = clients(info, bgp);
+    local_data->set_route_reflector(false);
+
+    return result;
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    t.complete_args_parsing();
+
+    try {
+	EventLoop eventloop;
+
+	// The BGP constructor expects to use the finder.
+	FinderServer finder(eventloop, FinderConstants::FINDER_DEFAULT_HOST(),
+			    FinderConstants::FINDER_DEFAULT_PORT());
+	BGPMain bgp(eventloop);
+	bgp.get_local_data()->set_as(AsNum(65000));
+	bgp.get_local_data()->set_id(IPv4("10.255.0.1"));
+
+	struct test {
+	    string test_name;
+	    XorpCallback1<bool, TestInfo&>::RefPtr cb;
+	} tests[] = {
+	    {"keys", callback(test_keys, &bgp)},
+	    {"group", callback(test_group, &bgp)},
+	    {"slow", callback(test_slow, &bgp)},
+	    {"policy", callback(test_policy, &bgp)},
+	    {"clients", callback(test_clients, &bgp)},
+	};
+
+	if("" == test_name) {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	} else {
+	    for(unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		i++)
+		if(test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
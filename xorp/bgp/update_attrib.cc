@@ -129,7 +129,8 @@ BGPUpdateAttribList::add(const BGPUpdateAttrib &x)
 #endif
 
 void
-BGPUpdateAttribList::decode(const uint8_t *d, size_t len)
+BGPUpdateAttribList::decode(const uint8_t *d, size_t len,
+			    BGPUpdateAttribList *duplicates)
 	throw(CorruptMessage)
 {
     clear();
@@ -142,9 +143,12 @@ BGPUpdateAttribList::decode(const uint8_t *d, size_t len)
         if (x_set.find(wr.net()) == x_set.end()) {
             push_back(wr);
             x_set.insert(wr.net());
-        } else
+        } else if (duplicates != NULL) {
+	    duplicates->push_back(wr);
+	} else {
             XLOG_WARNING("Received duplicate %s in update message",
 			 wr.str("nlri or withdraw").c_str());
+	}
     }
     if (len != 0)
         xorp_throw(CorruptMessage,
@@ -152,6 +156,38 @@ BGPUpdateAttribList::decode(const uint8_t *d, size_t len)
                    UPDATEMSGERR, ATTRLEN);
 }
 
+bool
+BGPUpdateAttribWire::check(const uint8_t *d, size_t len)
+	throw(CorruptMessage)
+{
+    _data = d;
+    _len = len;
+    _count = 0;
+
+    // A prefix takes at least a byte, so the prefixes of a message
+    // fit in this array.  They are sorted to find the duplicates,
+    // which is cheaper than the set BGPUpdateAttribList::decode()
+    // builds.
+    uint64_t keys[BGPPacket::MAXPACKETSIZE];
+
+    while (len > 0 && len >= BGPUpdateAttrib::size(d)) {
+	BGPUpdateAttrib net(d);
+	keys[_count++] = (static_cast<uint64_t>(net.masked_addr().addr()) << 8)
+	    | net.prefix_len();
+	len -= net.wire_size();
+	d += net.wire_size();
+    }
+    if (len != 0)
+        xorp_throw(CorruptMessage,
+                   c_format("leftover bytes %u", XORP_UINT_CAST(len)),
+                   UPDATEMSGERR, ATTRLEN);
+
+    if (_count < 2)
+	return true;
+    sort(keys, keys + _count);
+    return adjacent_find(keys, keys + _count) == keys + _count;
+}
+
 
 string
 BGPUpdateAttribList::str(string nlri_or_withdraw) const
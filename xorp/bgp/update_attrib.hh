@@ -96,7 +96,17 @@ public:
 
     size_t wire_size() const;
     uint8_t *encode(size_t &l, uint8_t *buf = 0) const;
-    void decode(const uint8_t *d, size_t len)
+
+    /**
+     * Decode a list of prefixes, dropping duplicates.
+     *
+     * @param duplicates if not NULL, the duplicates are added to this
+     * list rather than logged, so the caller can log them later.
+     * Without logging the decode touches no shared state, so it can be
+     * done on any thread.
+     */
+    void decode(const uint8_t *d, size_t len,
+		BGPUpdateAttribList *duplicates = NULL)
 	throw(CorruptMessage);
     string str(string) const;
 
@@ -117,4 +127,77 @@ public:
     }
 };
 
+/**
+ * The withdrawn routes or NLRI of a received UPDATE, left in wire
+ * format in the message.  The prefixes are decoded one at a time as
+ * they are iterated over, rather than copied into a
+ * BGPUpdateAttribList, so the message must outlive the object.
+ */
+class BGPUpdateAttribWire {
+public:
+    class const_iterator {
+    public:
+	const_iterator(const uint8_t *d, const uint8_t *end)
+	    : _d(d), _end(end), _attrib(IPv4::ZERO(), 0)	{ load(); }
+
+	const BGPUpdateAttrib& operator*() const	{ return _attrib; }
+	const BGPUpdateAttrib* operator->() const	{ return &_attrib; }
+
+	const_iterator& operator++()			{
+	    _d += _attrib.wire_size();
+	    load();
+	    return *this;
+	}
+
+	bool operator==(const const_iterator& him) const {
+	    return _d == him._d;
+	}
+	bool operator!=(const const_iterator& him) const {
+	    return _d != him._d;
+	}
+
+    private:
+	void load()					{
+	    if (_d < _end)
+		_attrib = BGPUpdateAttrib(_d);
+	}
+
+	const uint8_t	*_d;
+	const uint8_t	*_end;
+	BGPUpdateAttrib	_attrib;
+    };
+
+    BGPUpdateAttribWire() : _data(0), _len(0), _count(0)	{}
+
+    /**
+     * Check a list of prefixes in wire format, and keep a reference
+     * to it.
+     *
+     * The errors thrown are the ones BGPUpdateAttribList::decode()
+     * would throw for the same prefixes.
+     *
+     * @return false if a prefix is listed more than once: the
+     * duplicates are only dropped when the prefixes are decoded into
+     * a BGPUpdateAttribList.
+     */
+    bool check(const uint8_t *d, size_t len) throw(CorruptMessage);
+
+    const_iterator begin() const	{
+	return const_iterator(_data, _data + _len);
+    }
+    const_iterator end() const		{
+	return const_iterator(_data + _len, _data + _len);
+    }
+
+    const uint8_t *data() const		{ return _data; }
+    size_t wire_size() const		{ return _len; }
+    size_t size() const			{ return _count; }
+    bool empty() const			{ return _count == 0; }
+
+private:
+    const uint8_t	*_data;
+    size_t		_len;
+    size_t		_count;
+};
+
 #endif // __BGP_UPDATE_ATTRIB_HH__
@@ -0,0 +1,431 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+// #define DEBUG_LOGGING
+// #define DEBUG_PRINT_FUNCTION_NAME
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/debug.h"
+#include "libxorp/xlog.h"
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include "packet.hh"
+#include "update_decoder.hh"
+
+// Implementation Notes:
+//
+// The workers must not touch anything shared with the main thread
+// without holding the decoder mutex: the reference counts of ref_ptr
+// live in a global pool, AS paths are interned in a global table and
+// the logging is not thread safe.  So a worker decodes the path
+// attributes into a list that is not yet held by a ref_ptr, with
+// interning deferred, and leaves out the next hop checks, which need
+// the interfaces of the router.  The main thread interns the AS paths
+// and runs the next hop checks when it takes the list.  Errors are
+// copied into the DecodedUpdate and thrown again on the main thread,
+// and so are the warnings about duplicate prefixes.
+//
+// Each message is a separate unit of work, so the messages from one
+// peer may be decoded out of order; the UpdateDecodeQueue of the peer
+// only hands out its messages in order.  A worker writes one byte to
+// the wakeup pipe when there is no wakeup pending, so the main thread
+// is woken up once for a batch of messages.
+
+DecodedUpdate::DecodedUpdate(const uint8_t *buf, size_t length,
+			     const BGPPeerData *peerdata)
+    : _length(length), _peerdata(peerdata),
+      _pa_offset(0), _pa_len(0), _nlri_len(0), _pa_list(NULL),
+      _section_error(NULL), _pa_error(NULL), _nlri_error(NULL),
+      _decoded(false)
+{
+    _data = new uint8_t[length];
+    memcpy(_data, buf, length);
+}
+
+DecodedUpdate::~DecodedUpdate()
+{
+    delete[] _data;
+    delete _pa_list;
+    delete _section_error;
+    delete _pa_error;
+    delete _nlri_error;
+}
+
+FastPathAttributeList<IPv4> *
+DecodedUpdate::release_pa_list()
+{
+    FastPathAttributeList<IPv4> *pa_list = _pa_list;
+    _pa_list = NULL;
+
+    return pa_list;
+}
+
+void
+DecodedUpdate::decode()
+{
+    size_t nlri_offset;
+
+    try {
+	UpdatePacket::decode_sections(_data, _length, _wr_list, &_duplicates,
+				      _pa_offset, _pa_len,
+				      nlri_offset, _nlri_len);
+    } catch(CorruptMessage& c) {
+	_section_error = new CorruptMessage(c);
+	return;
+    }
+
+    ASPath::DeferIntern defer;
+    _pa_list = new FastPathAttributeList<IPv4>();
+    try {
+	_pa_list->decode_raw_data(_data + _pa_offset, _pa_len, _peerdata,
+				  (_nlri_len > 0), /*do checks*/true);
+    } catch(CorruptMessage& c) {
+	_pa_error = new CorruptMessage(c);
+	delete _pa_list;
+	_pa_list = NULL;
+	return;
+    }
+
+    try {
+	_nlri_list.decode(_data + nlri_offset, _nlri_len, &_duplicates);
+    } catch(CorruptMessage& c) {
+	_nlri_error = new CorruptMessage(c);
+    }
+}
+
+/* **************** UpdateDecoder *********************** */
+
+UpdateDecoder::UpdateDecoder(EventLoop& eventloop)
+    : _eventloop(eventloop)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_work_cond, NULL);
+    pthread_cond_init(&_done_cond, NULL);
+    _stopping = false;
+    _wakeup_pending = false;
+    _wakeup_fds[0] = _wakeup_fds[1] = -1;
+#endif
+}
+
+UpdateDecoder::~UpdateDecoder()
+{
+    XLOG_ASSERT(_queues.empty());
+
+#ifdef HAVE_PTHREAD_H
+    stop_workers();
+    if (_wakeup_fds[0] != -1) {
+	_eventloop.remove_ioevent_cb(XorpFd(_wakeup_fds[0]), IOT_READ);
+	close(_wakeup_fds[0]);
+	close(_wakeup_fds[1]);
+    }
+    pthread_cond_destroy(&_done_cond);
+    pthread_cond_destroy(&_work_cond);
+    pthread_mutex_destroy(&_mutex);
+#endif
+}
+
+uint32_t
+UpdateDecoder::threads() const
+{
+#ifdef HAVE_PTHREAD_H
+    return _workers.size();
+#else
+    return 0;
+#endif
+}
+
+int
+UpdateDecoder::set_threads(uint32_t threads, string& error_msg)
+{
+#ifdef HAVE_PTHREAD_H
+    static const uint32_t MAX_THREADS = 64;
+
+    if (threads > MAX_THREADS) {
+	error_msg = c_format("Too many decoder threads %u, the maximum is %u",
+			     XORP_UINT_CAST(threads),
+			     XORP_UINT_CAST(MAX_THREADS));
+	return XORP_ERROR;
+    }
+
+    if (threads > 0 && _wakeup_fds[0] == -1) {
+	if (pipe(_wakeup_fds) != 0) {
+	    error_msg = c_format("Cannot create the decoder wakeup pipe: %s",
+				 strerror(errno));
+	    _wakeup_fds[0] = _wakeup_fds[1] = -1;
+	    return XORP_ERROR;
+	}
+	for (int i = 0; i < 2; i++)
+	    fcntl(_wakeup_fds[i], F_SETFL,
+		  fcntl(_wakeup_fds[i], F_GETFL) | O_NONBLOCK);
+	if (!_eventloop.add_ioevent_cb(XorpFd(_wakeup_fds[0]), IOT_READ,
+				       callback(this, &UpdateDecoder::wakeup))) {
+	    error_msg = "Cannot register the decoder wakeup pipe";
+	    close(_wakeup_fds[0]);
+	    close(_wakeup_fds[1]);
+	    _wakeup_fds[0] = _wakeup_fds[1] = -1;
+	    return XORP_ERROR;
+	}
+    }
+
+    stop_workers();
+
+    while (_workers.size() < threads) {
+	pthread_t thread;
+	int err = pthread_create(&thread, NULL, &UpdateDecoder::worker_main,
+				 this);
+	if (err != 0) {
+	    error_msg = c_format("Cannot create a decoder thread: %s",
+				 strerror(err));
+	    stop_workers();
+	    return XORP_ERROR;
+	}
+	_workers.push_back(thread);
+    }
+
+    return XORP_OK;
+#else
+    if (threads == 0)
+	return XORP_OK;
+    error_msg = "Threads are not supported on this platform";
+    return XORP_ERROR;
+#endif
+}
+
+void
+UpdateDecoder::add_queue(UpdateDecodeQueue *q)
+{
+    _queues.insert(q);
+}
+
+void
+UpdateDecoder::remove_queue(UpdateDecodeQueue *q)
+{
+    _queues.erase(q);
+}
+
+void
+UpdateDecoder::submit(DecodedUpdate *du)
+{
+#ifdef HAVE_PTHREAD_H
+    if (!_workers.empty()) {
+	pthread_mutex_lock(&_mutex);
+	_work.push_back(du);
+	pthread_cond_signal(&_work_cond);
+	pthread_mutex_unlock(&_mutex);
+	return;
+    }
+#endif
+
+    du->decode();
+    du->_decoded = true;
+}
+
+bool
+UpdateDecoder::decoded(const DecodedUpdate *du)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&_mutex);
+    bool decoded = du->_decoded;
+    pthread_mutex_unlock(&_mutex);
+
+    return decoded;
+#else
+    return du->_decoded;
+#endif
+}
+
+void
+UpdateDecoder::wait(const DecodedUpdate *du)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&_mutex);
+    while (!du->_decoded)
+	pthread_cond_wait(&_done_cond, &_mutex);
+    pthread_mutex_unlock(&_mutex);
+#else
+    XLOG_ASSERT(du->_decoded);
+#endif
+}
+
+void
+UpdateDecoder::wakeup(XorpFd fd, IoEventType type)
+{
+    XLOG_ASSERT(type == IOT_READ);
+#ifdef HAVE_PTHREAD_H
+    char buf[64];
+    while (read(fd, buf, sizeof(buf)) > 0)
+	;
+
+    pthread_mutex_lock(&_mutex);
+    _wakeup_pending = false;
+    pthread_mutex_unlock(&_mutex);
+#else
+    UNUSED(fd);
+#endif
+
+    // A queue may be removed by the callback of another queue.
+    set<UpdateDecodeQueue *> queues = _queues;
+    set<UpdateDecodeQueue *>::iterator i;
+    for (i = queues.begin(); i != queues.end(); ++i) {
+	if (_queues.find(*i) != _queues.end())
+	    (*i)->ready();
+    }
+}
+
+void
+UpdateDecoder::stop_workers()
+{
+#ifdef HAVE_PTHREAD_H
+    if (_workers.empty())
+	return;
+
+    pthread_mutex_lock(&_mutex);
+    _stopping = true;
+    pthread_cond_broadcast(&_work_cond);
+    pthread_mutex_unlock(&_mutex);
+
+    vector<pthread_t>::iterator i;
+    for (i = _workers.begin(); i != _workers.end(); ++i)
+	pthread_join(*i, NULL);
+    _workers.clear();
+
+    XLOG_ASSERT(_work.empty());
+    _stopping = false;
+#endif
+}
+
+void *
+UpdateDecoder::worker_main(void *arg)
+{
+    static_cast<UpdateDecoder *>(arg)->worker();
+    return NULL;
+}
+
+void
+UpdateDecoder::worker()
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&_mutex);
+    for (;;) {
+	while (_work.empty() && !_stopping)
+	    pthread_cond_wait(&_work_cond, &_mutex);
+	// The work queued is done before stopping.
+	if (_work.empty())
+	    break;
+
+	DecodedUpdate *du = _work.front();
+	_work.pop_front();
+	pthread_mutex_unlock(&_mutex);
+
+	du->decode();
+
+	pthread_mutex_lock(&_mutex);
+	du->_decoded = true;
+	pthread_cond_broadcast(&_done_cond);
+	if (!_wakeup_pending) {
+	    _wakeup_pending = true;
+	    char c = 0;
+	    if (write(_wakeup_fds[1], &c, 1) != 1)
+		_wakeup_pending = false;
+	}
+    }
+    pthread_mutex_unlock(&_mutex);
+#endif
+}
+
+/* **************** UpdateDecodeQueue *********************** */
+
+UpdateDecodeQueue::UpdateDecodeQueue(UpdateDecoder& decoder,
+				     const BGPPeerData *peerdata,
+				     ReadyCallback ready)
+    : _decoder(decoder), _peerdata(peerdata), _ready(ready)
+{
+    _decoder.add_queue(this);
+}
+
+UpdateDecodeQueue::~UpdateDecodeQueue()
+{
+    clear();
+    _decoder.remove_queue(this);
+}
+
+void
+UpdateDecodeQueue::push(const uint8_t *buf, size_t length)
+{
+    DecodedUpdate *du = new DecodedUpdate(buf, length, _peerdata);
+    _queue.push_back(du);
+    _decoder.submit(du);
+}
+
+DecodedUpdate *
+UpdateDecodeQueue::front()
+{
+    if (_queue.empty())
+	return NULL;
+
+    DecodedUpdate *du = _queue.front();
+    if (!_decoder.decoded(du))
+	return NULL;
+
+    return du;
+}
+
+DecodedUpdate *
+UpdateDecodeQueue::pop()
+{
+    XLOG_ASSERT(!_queue.empty());
+
+    DecodedUpdate *du = _queue.front();
+    _queue.pop_front();
+
+    return du;
+}
+
+void
+UpdateDecodeQueue::wait()
+{
+    list<DecodedUpdate *>::const_iterator i;
+    for (i = _queue.begin(); i != _queue.end(); ++i)
+	_decoder.wait(*i);
+}
+
+void
+UpdateDecodeQueue::clear()
+{
+    // The workers may still hold pointers to the messages.
+    wait();
+
+    while (!_queue.empty())
+	delete pop();
+}
+
+void
+UpdateDecodeQueue::ready()
+{
+    if (front() != NULL)
+	_ready->dispatch();
+}
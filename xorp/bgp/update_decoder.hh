@@ -0,0 +1,289 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __BGP_UPDATE_DECODER_HH__
+#define __BGP_UPDATE_DECODER_HH__
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "libxorp/eventloop.hh"
+#include "libxorp/callback.hh"
+
+#include "exceptions.hh"
+#include "update_attrib.hh"
+#include "path_attribute.hh"
+
+class BGPPeerData;
+
+/**
+ * @short An UPDATE message taken apart by an UpdateDecoder.
+ *
+ * The decoder checks the lengths of the sections of the message,
+ * decodes the withdrawn routes and the NLRI, and decodes and checks
+ * the path attributes.  The attribute list is not reference counted
+ * yet, and its AS paths are not interned: the UpdatePacket constructor
+ * that takes a DecodedUpdate does both on the main thread, and checks
+ * the next hops against the addresses of this router.
+ */
+class DecodedUpdate {
+public:
+    /**
+     * @param buf the message, which is copied.
+     * @param length the length of the message.
+     * @param peerdata the peer the message was received from.  The
+     * parameters negotiated with the peer must not change while the
+     * message is being decoded.
+     */
+    DecodedUpdate(const uint8_t *buf, size_t length,
+		  const BGPPeerData *peerdata);
+    ~DecodedUpdate();
+
+    /**
+     * Decode the message. Touches no shared state.
+     */
+    void decode();
+
+    /**
+     * Take the decoded path attributes.
+     *
+     * @return the attributes, which the caller must delete, or NULL
+     * if they were already taken.
+     */
+    FastPathAttributeList<IPv4> *release_pa_list();
+
+    const uint8_t *data() const			{ return _data; }
+    size_t length() const			{ return _length; }
+
+    BGPUpdateAttribList& wr_list()		{ return _wr_list; }
+    BGPUpdateAttribList& nlri_list()		{ return _nlri_list; }
+
+    /**
+     * @return the duplicate withdrawn routes and NLRI that were
+     * dropped, still to be logged.
+     */
+    const BGPUpdateAttribList& duplicates() const { return _duplicates; }
+
+    size_t pa_offset() const			{ return _pa_offset; }
+    size_t pa_len() const			{ return _pa_len; }
+    size_t nlri_len() const			{ return _nlri_len; }
+
+    /**
+     * @return the error found before reaching the path attributes,
+     * or NULL.
+     */
+    const CorruptMessage *section_error() const	{ return _section_error; }
+
+    /**
+     * @return the error found decoding the path attributes, or NULL.
+     */
+    const CorruptMessage *pa_error() const	{ return _pa_error; }
+
+    /**
+     * @return the error found decoding the NLRI, or NULL.  It must
+     * only be reported if the path attributes are correct.
+     */
+    const CorruptMessage *nlri_error() const	{ return _nlri_error; }
+
+private:
+    friend class UpdateDecoder;
+    friend class UpdateDecodeQueue;
+
+    DecodedUpdate(const DecodedUpdate&);		// Not implemented
+    DecodedUpdate& operator=(const DecodedUpdate&);	// Not implemented
+
+    uint8_t		*_data;
+    size_t		_length;
+    const BGPPeerData	*_peerdata;
+
+    BGPUpdateAttribList	_wr_list;
+    BGPUpdateAttribList	_nlri_list;
+    BGPUpdateAttribList	_duplicates;
+    size_t		_pa_offset;
+    size_t		_pa_len;
+    size_t		_nlri_len;
+    FastPathAttributeList<IPv4> *_pa_list;
+    CorruptMessage	*_section_error;
+    CorruptMessage	*_pa_error;
+    CorruptMessage	*_nlri_error;
+
+    bool		_decoded;	// Protected by the decoder mutex.
+};
+
+class UpdateDecodeQueue;
+
+/**
+ * @short A pool of threads decoding the UPDATE messages received.
+ *
+ * There is one decoder shared by all the peers.  Each peer queues its
+ * messages on its own UpdateDecodeQueue, which hands them back in the
+ * order they were received.  The workers wake the main thread up
+ * through a pipe registered with the EventLoop.
+ *
+ * With no worker threads, which is the default, the peers decode
+ * their messages as they arrive and do not use the decoder.
+ */
+class UpdateDecoder {
+public:
+    UpdateDecoder(EventLoop& eventloop);
+    ~UpdateDecoder();
+
+    /**
+     * Set the number of worker threads.  The messages queued are
+     * decoded by the old workers before they exit.
+     *
+     * @param threads the number of threads, 0 to decode the messages
+     * on the main thread as they arrive.
+     * @param error_msg the error message (if error).
+     * @return XORP_OK on success, otherwise XORP_ERROR.
+     */
+    int set_threads(uint32_t threads, string& error_msg);
+
+    /**
+     * @return the number of worker threads.
+     */
+    uint32_t threads() const;
+
+    /**
+     * @return true if the messages should be queued for the workers.
+     */
+    bool enabled() const			{ return threads() > 0; }
+
+private:
+    friend class UpdateDecodeQueue;
+
+    UpdateDecoder(const UpdateDecoder&);		// Not implemented
+    UpdateDecoder& operator=(const UpdateDecoder&);	// Not implemented
+
+    void add_queue(UpdateDecodeQueue *q);
+    void remove_queue(UpdateDecodeQueue *q);
+
+    /**
+     * Hand a message to the workers, or decode it now if there are none.
+     */
+    void submit(DecodedUpdate *du);
+
+    /**
+     * @return true if the message has been decoded.
+     */
+    bool decoded(const DecodedUpdate *du);
+
+    /**
+     * Block until a message has been decoded.
+     */
+    void wait(const DecodedUpdate *du);
+
+    /**
+     * Decoded messages are ready: notify the queues.
+     */
+    void wakeup(XorpFd fd, IoEventType type);
+
+    void stop_workers();
+    void worker();
+    static void *worker_main(void *arg);
+
+    EventLoop&			_eventloop;
+    set<UpdateDecodeQueue *>	_queues;
+
+#ifdef HAVE_PTHREAD_H
+    vector<pthread_t>		_workers;
+    pthread_mutex_t		_mutex;
+    pthread_cond_t		_work_cond;	// Work queued, or stopping
+    pthread_cond_t		_done_cond;	// A message was decoded
+    list<DecodedUpdate *>	_work;
+    bool			_stopping;
+    bool			_wakeup_pending;
+    int				_wakeup_fds[2];	// Read end, write end
+#endif
+};
+
+/**
+ * @short The UPDATE messages from a peer waiting to be decoded or
+ * processed, in the order they were received.
+ */
+class UpdateDecodeQueue {
+public:
+    typedef XorpCallback0<void>::RefPtr ReadyCallback;
+
+    /**
+     * @param decoder the decoder.
+     * @param peerdata the peer the messages are received from.
+     * @param ready called on the main thread when the message at the
+     * front of the queue has been decoded.
+     */
+    UpdateDecodeQueue(UpdateDecoder& decoder, const BGPPeerData *peerdata,
+		      ReadyCallback ready);
+
+    /**
+     * Drops the messages queued.
+     */
+    ~UpdateDecodeQueue();
+
+    /**
+     * Queue a message and hand it to the decoder.
+     *
+     * @param buf the message, which is copied.
+     * @param length the length of the message.
+     */
+    void push(const uint8_t *buf, size_t length);
+
+    /**
+     * @return the message at the front of the queue if it has been
+     * decoded, otherwise NULL.
+     */
+    DecodedUpdate *front();
+
+    /**
+     * Remove the message at the front of the queue.
+     *
+     * @return the message, which the caller must delete.
+     */
+    DecodedUpdate *pop();
+
+    /**
+     * Block until all the messages queued have been decoded.
+     */
+    void wait();
+
+    /**
+     * Drop all the messages queued.
+     */
+    void clear();
+
+    size_t size() const				{ return _queue.size(); }
+    bool empty() const				{ return _queue.empty(); }
+
+    UpdateDecoder& decoder()			{ return _decoder; }
+
+private:
+    friend class UpdateDecoder;
+
+    UpdateDecodeQueue(const UpdateDecodeQueue&);		// Not implemented
+    UpdateDecodeQueue& operator=(const UpdateDecodeQueue&);	// Not implemented
+
+    void ready();
+
+    UpdateDecoder&		_decoder;
+    const BGPPeerData		*_peerdata;
+    ReadyCallback		_ready;
+    list<DecodedUpdate *>	_queue;
+};
+
+#endif // __BGP_UPDATE_DECODER_HH__
@@ -0,0 +1,756 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+// #define DEBUG_LOGGING
+// #define DEBUG_PRINT_FUNCTION_NAME
+
+#include "bgp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/debug.h"
+#include "libxorp/xlog.h"
+
+#include "bgp.hh"
+#include "bgp_varrw.hh"
+#include "update_group.hh"
+
+// Implementation Notes:
+//
+// A peer joins the group matching its key when its peering comes up,
+// and is dumped the table on its own output branch as usual.  The
+// group only gets an output branch, plumbed into the fanout table
+// next to the ones of the peers, once two members have been sent all
+// their branches had queued.  Nothing is dumped to it: at that point
+// the group branch and the branches of the two members have nothing
+// left to send, so it sends them what their branches would have, and
+// their branches are unplumbed.  The other members follow the group
+// the same way once they and the group are up to date, which the
+// merge timer checks for.
+//
+// A follower that leaves the group has its branch plumbed back into
+// the fanout table at the queue position of the group branch, once
+// the RibOut of the group has sent what it holds.  A peering going
+// down leaves the group without that: its branch is torn down anyway.
+// The group branch goes away when fewer than two members follow it.
+//
+// The fanout table does not send the group branch what it skips for
+// the branch of a member: the routes the member announced itself.
+// The group handler is told by the RibOut which peer each route of
+// the UPDATE came from, and a follower whose routes are in it is sent
+// an UPDATE without them, built as its own branch would have.  Only
+// route reflector clients need that: the outbound filters drop the
+// routes a peer announced for EBGP and other IBGP peers anyway.
+//
+// The key of a group holds every property of a peer the outbound
+// filters and the encoding depend on.  The export policy is the same
+// for all the peers, except for what it does with the neighbor, so a
+// peer is only keyed by address if the policy matches on it, or if
+// the peer is directly connected, where the next hop rewrite depends
+// on its address.  A change of the export policy may change that, so
+// the peers are regrouped when it is configured.
+
+EncodedUpdate::EncodedUpdate(const UpdatePacket& p,
+			     const BGPPeerData* peerdata)
+{
+    _data = new uint8_t[BGPPacket::MAXPACKETSIZE];
+    _size = BGPPacket::MAXPACKETSIZE;
+    XLOG_ASSERT(p.encode(_data, _size, peerdata));
+}
+
+UpdateGroupKey::UpdateGroupKey(const BGPPeerData* peerdata, bool by_address)
+    : _peer_type(peerdata->get_peer_type()),
+      _as(peerdata->as().as4()),
+      _my_as(peerdata->my_AS_number().as4()),
+      _use_4byte_asnums(peerdata->use_4byte_asnums()),
+      _we_use_4byte_asnums(peerdata->we_use_4byte_asnums()),
+      _families(0),
+      _local_addr(peerdata->iptuple().get_local_addr()),
+      _v4_nexthop(peerdata->get_v4_local_addr()),
+      _v6_nexthop(peerdata->get_v6_local_addr()),
+      _next_hop_rewrite(peerdata->get_next_hop_rewrite())
+{
+    if (peerdata->multiprotocol<IPv4>(SAFI_UNICAST))
+	_families |= 1;
+    if (peerdata->multiprotocol<IPv4>(SAFI_MULTICAST))
+	_families |= 2;
+    if (peerdata->multiprotocol<IPv6>(SAFI_UNICAST))
+	_families |= 4;
+    if (peerdata->multiprotocol<IPv6>(SAFI_MULTICAST))
+	_families |= 8;
+
+    if (by_address)
+	_peer_addr = peerdata->iptuple().get_peer_addr();
+}
+
+bool
+UpdateGroupKey::operator<(const UpdateGroupKey& him) const
+{
+    if (_peer_type != him._peer_type)
+	return _peer_type < him._peer_type;
+    if (_as != him._as)
+	return _as < him._as;
+    if (_my_as != him._my_as)
+	return _my_as < him._my_as;
+    if (_use_4byte_asnums != him._use_4byte_asnums)
+	return _use_4byte_asnums < him._use_4byte_asnums;
+    if (_we_use_4byte_asnums != him._we_use_4byte_asnums)
+	return _we_use_4byte_asnums < him._we_use_4byte_asnums;
+    if (_families != him._families)
+	return _families < him._families;
+    if (_local_addr != him._local_addr)
+	return _local_addr < him._local_addr;
+    if (_v4_nexthop != him._v4_nexthop)
+	return _v4_nexthop < him._v4_nexthop;
+    if (_v6_nexthop != him._v6_nexthop)
+	return _v6_nexthop < him._v6_nexthop;
+    if (_next_hop_rewrite != him._next_hop_rewrite)
+	return _next_hop_rewrite < him._next_hop_rewrite;
+    return _peer_addr < him._peer_addr;
+}
+
+string
+UpdateGroupKey::str() const
+{
+    return c_format("type %d AS %u local AS %u%s%s families %#x "
+		    "local %s next hop rewrite %s%s%s",
+		    _peer_type, XORP_UINT_CAST(_as), XORP_UINT_CAST(_my_as),
+		    _use_4byte_asnums ? " 4byte-peer" : "",
+		    _we_use_4byte_asnums ? " 4byte-local" : "",
+		    XORP_UINT_CAST(_families), _local_addr.c_str(),
+		    _next_hop_rewrite.str().c_str(),
+		    _peer_addr.empty() ? "" : " peer ",
+		    _peer_addr.c_str());
+}
+
+/* **************** UpdateGroupHandler *********************** */
+
+UpdateGroupHandler::UpdateGroupHandler(UpdateGroup& group, uint32_t id,
+				       BGPPeer* peer, PeerHandler* handler)
+    : PeerHandler(c_format("UpdateGroup-%u", XORP_UINT_CAST(id)), peer,
+		  NULL, NULL),
+      _group(group), _id(htonl(id)), _old_origin(NULL), _new_origin(NULL)
+{
+    XLOG_ASSERT(id < 0x1000000);
+
+    _plumbing_unicast = handler->plumbing_unicast();
+    _plumbing_multicast = handler->plumbing_multicast();
+
+    if (_plumbing_unicast != NULL)
+	_plumbing_unicast->add_group(this);
+    if (_plumbing_multicast != NULL)
+	_plumbing_multicast->add_group(this);
+}
+
+UpdateGroupHandler::~UpdateGroupHandler()
+{
+    if (_plumbing_unicast != NULL)
+	_plumbing_unicast->delete_group(this);
+    if (_plumbing_multicast != NULL)
+	_plumbing_multicast->delete_group(this);
+
+    // The PeerHandler has no peering to delete.
+    _plumbing_unicast = NULL;
+    _plumbing_multicast = NULL;
+}
+
+void
+UpdateGroupHandler::output_no_longer_busy()
+{
+    if (_plumbing_unicast != NULL)
+	_plumbing_unicast->output_no_longer_busy(this);
+    if (_plumbing_multicast != NULL)
+	_plumbing_multicast->output_no_longer_busy(this);
+}
+
+void
+UpdateGroupHandler::set_origin_peers(const PeerHandler* old_origin,
+				     const PeerHandler* new_origin)
+{
+    _old_origin = old_origin;
+    _new_origin = new_origin;
+}
+
+int
+UpdateGroupHandler::start_packet()
+{
+    _changes4.clear();
+#ifdef HAVE_IPV6
+    _changes6.clear();
+#endif
+    _origins.clear();
+    return PeerHandler::start_packet();
+}
+
+PeerOutputState
+UpdateGroupHandler::push_packet()
+{
+    PeerOutputState result = PeerHandler::push_packet();
+
+    // Do not hold on to the routes once they are sent.
+    _changes4.clear();
+#ifdef HAVE_IPV6
+    _changes6.clear();
+#endif
+    _origins.clear();
+    return result;
+}
+
+// The PeerHandler puts the path attributes of a multicast route in the
+// packet and changes them there, so those are copied.
+template <class A>
+static ref_ptr<FastPathAttributeList<A> >
+kept(const ref_ptr<FastPathAttributeList<A> >& pa_list, Safi safi)
+{
+    if (safi == SAFI_MULTICAST)
+	return new FastPathAttributeList<A>(*pa_list);
+    return pa_list;
+}
+
+template <class A>
+void
+UpdateGroupHandler::record(list<Change<A> >& changes, const Change<A>& change)
+{
+    changes.push_back(change);
+    if (change.old_origin != NULL)
+	_origins.insert(change.old_origin);
+    if (change.new_origin != NULL)
+	_origins.insert(change.new_origin);
+}
+
+// The PeerHandler may push the packet and start another before it
+// adds a route, so a route is recorded once it has been added.  The
+// calls are qualified: the replace_route of the PeerHandler is an
+// add_route, which must not be recorded twice.
+
+int
+UpdateGroupHandler::add_route(const SubnetRoute<IPv4> &rt,
+			      FPAList4Ref& pa_list, bool ibgp, Safi safi)
+{
+    Change<IPv4> change(NULL, false, &rt, ibgp, kept(pa_list, safi), safi,
+		      NULL, _new_origin);
+    int result = PeerHandler::add_route(rt, pa_list, ibgp, safi);
+    record(_changes4, change);
+    return result;
+}
+
+int
+UpdateGroupHandler::replace_route(const SubnetRoute<IPv4> &old_rt,
+				  bool old_ibgp,
+				  const SubnetRoute<IPv4> &new_rt,
+				  bool new_ibgp,
+				  FPAList4Ref& pa_list, Safi safi)
+{
+    Change<IPv4> change(&old_rt, old_ibgp, &new_rt, new_ibgp,
+		      kept(pa_list, safi), safi, _old_origin, _new_origin);
+    int result = PeerHandler::add_route(new_rt, pa_list, new_ibgp, safi);
+    record(_changes4, change);
+    return result;
+}
+
+int
+UpdateGroupHandler::delete_route(const SubnetRoute<IPv4> &rt,
+				 FPAList4Ref& pa_list, bool ibgp, Safi safi)
+{
+    Change<IPv4> change(&rt, ibgp, NULL, false, kept(pa_list, safi), safi,
+		      _old_origin, NULL);
+    int result = PeerHandler::delete_route(rt, pa_list, ibgp, safi);
+    record(_changes4, change);
+    return result;
+}
+
+#ifdef HAVE_IPV6
+int
+UpdateGroupHandler::add_route(const SubnetRoute<IPv6> &rt,
+			      FPAList6Ref& pa_list, bool ibgp, Safi safi)
+{
+    Change<IPv6> change(NULL, false, &rt, ibgp, kept(pa_list, safi), safi,
+		      NULL, _new_origin);
+    int result = PeerHandler::add_route(rt, pa_list, ibgp, safi);
+    record(_changes6, change);
+    return result;
+}
+
+int
+UpdateGroupHandler::replace_route(const SubnetRoute<IPv6> &old_rt,
+				  bool old_ibgp,
+				  const SubnetRoute<IPv6> &new_rt,
+				  bool new_ibgp,
+				  FPAList6Ref& pa_list, Safi safi)
+{
+    Change<IPv6> change(&old_rt, old_ibgp, &new_rt, new_ibgp,
+		      kept(pa_list, safi), safi, _old_origin, _new_origin);
+    int result = PeerHandler::add_route(new_rt, pa_list, new_ibgp, safi);
+    record(_changes6, change);
+    return result;
+}
+
+int
+UpdateGroupHandler::delete_route(const SubnetRoute<IPv6> &rt,
+				 FPAList6Ref& pa_list, bool ibgp, Safi safi)
+{
+    Change<IPv6> change(&rt, ibgp, NULL, false, kept(pa_list, safi), safi,
+		      _old_origin, NULL);
+    int result = PeerHandler::delete_route(rt, pa_list, ibgp, safi);
+    record(_changes6, change);
+    return result;
+}
+#endif
+
+template <class A>
+void
+UpdateGroupHandler::replay(PeerHandler& builder,
+			   const list<Change<A> >& changes,
+			   const PeerHandler* member) const
+{
+    typename list<Change<A> >::const_iterator i;
+    for (i = changes.begin(); i != changes.end(); ++i) {
+	const SubnetRoute<A>* old_rt = i->old_route.route();
+	const SubnetRoute<A>* new_rt = i->new_route.route();
+	ref_ptr<FastPathAttributeList<A> > pa_list = kept(i->pa_list,
+							  i->safi);
+
+	// What the fanout table would have sent the branch of the
+	// member: nothing of its own, so a route it replaced is
+	// withdrawn and a route that replaced its own is added.
+	bool old_skipped = old_rt == NULL || i->old_origin == member;
+	bool new_skipped = new_rt == NULL || i->new_origin == member;
+	if (new_skipped && old_skipped)
+	    continue;
+	if (new_skipped)
+	    builder.delete_route(*old_rt, pa_list, i->old_ibgp, i->safi);
+	else if (old_skipped)
+	    builder.add_route(*new_rt, pa_list, i->new_ibgp, i->safi);
+	else
+	    builder.replace_route(*old_rt, i->old_ibgp, *new_rt, i->new_ibgp,
+				  pa_list, i->safi);
+    }
+}
+
+PeerOutputState
+UpdateGroupHandler::send_without_routes_of(BGPPeer* peer,
+					   const PeerHandler* member)
+{
+    // Built as the branch of the member would, and sent as it would.
+    PeerHandler builder(peername(), peer, NULL, NULL);
+    builder.start_packet();
+    replay(builder, _changes4, member);
+#ifdef HAVE_IPV6
+    replay(builder, _changes6, member);
+#endif
+    return builder.push_packet();
+}
+
+PeerOutputState
+UpdateGroupHandler::send_update(const UpdatePacket& p)
+{
+    return _group.send_update(p);
+}
+
+/* **************** UpdateGroup *********************** */
+
+const uint32_t UpdateGroup::MAX_BEHIND;
+const int UpdateGroup::MERGE_INTERVAL_MS;
+
+UpdateGroup::UpdateGroup(EventLoop& eventloop, const UpdateGroupKey& key,
+			 uint32_t id)
+    : _eventloop(eventloop), _key(key), _id(id), _handler(NULL),
+      _representative(NULL), _busy(false)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+UpdateGroup::~UpdateGroup()
+{
+    XLOG_ASSERT(_handler == NULL);
+}
+
+void
+UpdateGroup::add_member(BGPPeer* peer, PeerHandler* handler)
+{
+    XLOG_ASSERT(_members.find(peer) == _members.end());
+    _members.insert(make_pair(peer, Member(handler)));
+
+    if (_members.size() >= 2 && !_merge_timer.scheduled())
+	_merge_timer = _eventloop.new_periodic_ms(MERGE_INTERVAL_MS,
+				callback(this, &UpdateGroup::merge_timer));
+}
+
+void
+UpdateGroup::remove_member(BGPPeer* peer)
+{
+    MemberMap::iterator i = _members.find(peer);
+    XLOG_ASSERT(i != _members.end());
+    bool was_following = i->second.following;
+    _members.erase(i);
+
+    if (!was_following)
+	return;
+
+    if (followers() < 2)
+	dissolve();
+    else if (peer == _representative)
+	set_representative();
+}
+
+bool
+UpdateGroup::following(BGPPeer* peer) const
+{
+    MemberMap::const_iterator i = _members.find(peer);
+    return i != _members.end() && i->second.following;
+}
+
+size_t
+UpdateGroup::followers() const
+{
+    size_t n = 0;
+    MemberMap::const_iterator i;
+    for (i = _members.begin(); i != _members.end(); ++i)
+	if (i->second.following)
+	    n++;
+    return n;
+}
+
+bool
+UpdateGroup::output_idle(PeerHandler* handler) const
+{
+    BGPPlumbing* unicast = handler->plumbing_unicast();
+    BGPPlumbing* multicast = handler->plumbing_multicast();
+
+    return (unicast == NULL || unicast->output_idle(handler))
+	&& (multicast == NULL || multicast->output_idle(handler));
+}
+
+void
+UpdateGroup::split(BGPPeer* peer)
+{
+    MemberMap::iterator i = _members.find(peer);
+    XLOG_ASSERT(i != _members.end());
+    Member& m = i->second;
+    XLOG_ASSERT(m.following);
+
+    debug_msg("%s falls out of update group %u\n",
+	      peer->peerdata()->iptuple().str().c_str(), _id);
+
+    // The RibOut of the group sends what it holds to the peer first.
+    if (m.handler->plumbing_unicast() != NULL)
+	m.handler->plumbing_unicast()->leave_group(m.handler, _handler);
+    if (m.handler->plumbing_multicast() != NULL)
+	m.handler->plumbing_multicast()->leave_group(m.handler, _handler);
+    m.following = false;
+    m.busy = false;
+    m.behind = 0;
+    _stats.splits++;
+
+    if (followers() < 2)
+	dissolve();
+    else if (peer == _representative)
+	set_representative();
+
+    if (!_merge_timer.scheduled())
+	_merge_timer = _eventloop.new_periodic_ms(MERGE_INTERVAL_MS,
+				callback(this, &UpdateGroup::merge_timer));
+}
+
+void
+UpdateGroup::merge()
+{
+    MemberMap::iterator i;
+
+    if (_handler == NULL) {
+	// The group branch is only worth having for two members.
+	MemberMap::iterator first = _members.end();
+	for (i = _members.begin(); i != _members.end(); ++i) {
+	    if (!i->second.handler->peering_is_up()
+		|| !output_idle(i->second.handler))
+		continue;
+	    if (first != _members.end())
+		break;
+	    first = i;
+	}
+	if (i == _members.end())
+	    return;
+
+	_representative = first->first;
+	_handler = new UpdateGroupHandler(*this, _id, first->first,
+					  first->second.handler);
+	_busy = false;
+    } else if (!output_idle(_handler)) {
+	return;
+    }
+
+    for (i = _members.begin(); i != _members.end(); ++i) {
+	Member& m = i->second;
+	if (m.following || !m.handler->peering_is_up()
+	    || !output_idle(m.handler))
+	    continue;
+
+	debug_msg("%s follows update group %u\n",
+		  i->first->peerdata()->iptuple().str().c_str(), _id);
+
+	if (m.handler->plumbing_unicast() != NULL)
+	    m.handler->plumbing_unicast()->join_group(m.handler, _handler);
+	if (m.handler->plumbing_multicast() != NULL)
+	    m.handler->plumbing_multicast()->join_group(m.handler, _handler);
+	m.following = true;
+	m.busy = false;
+	m.behind = 0;
+	_stats.merges++;
+    }
+}
+
+bool
+UpdateGroup::merge_timer()
+{
+    merge();
+
+    return _members.size() >= 2 && followers() < _members.size();
+}
+
+PeerOutputState
+UpdateGroup::send_update(const UpdatePacket& p)
+{
+    XLOG_ASSERT(_representative != NULL);
+
+    // The encoding is the same for all the members, but for those
+    // whose own routes are in the UPDATE.
+    ref_ptr<EncodedUpdate> wire;
+
+    bool ok = false;
+    bool busy = false;
+    bool slow = false;
+    MemberMap::iterator i;
+    for (i = _members.begin(); i != _members.end(); ++i) {
+	Member& m = i->second;
+	if (!m.following)
+	    continue;
+
+	PeerOutputState state;
+	if (_handler->holds_routes_of(m.handler)) {
+	    _stats.rebuilt++;
+	    state = _handler->send_without_routes_of(i->first, m.handler);
+	} else {
+	    if (wire.is_empty()) {
+		wire = new EncodedUpdate(p, _representative->peerdata());
+		_stats.encodes++;
+	    }
+	    _stats.sent++;
+	    state = i->first->send_shared_update(p, wire);
+	}
+
+	switch (state) {
+	case PEER_OUTPUT_OK:
+	    ok = true;
+	    m.busy = false;
+	    m.behind = 0;
+	    break;
+	case PEER_OUTPUT_BUSY:
+	    busy = true;
+	    if (m.busy && ++m.behind >= MAX_BEHIND)
+		slow = true;
+	    m.busy = true;
+	    break;
+	case PEER_OUTPUT_FAIL:
+	    // The peering is going down.
+	    break;
+	}
+    }
+
+    // Not from here: this is the RibOut of the group sending.
+    if (slow && !_split_task.scheduled())
+	_split_task = _eventloop.new_oneoff_task(
+				callback(this, &UpdateGroup::split_slow));
+
+    // Hold up the group only if no follower can take more.
+    if (ok)
+	return PEER_OUTPUT_OK;
+    if (busy) {
+	_busy = true;
+	return PEER_OUTPUT_BUSY;
+    }
+    return PEER_OUTPUT_FAIL;
+}
+
+void
+UpdateGroup::split_slow()
+{
+    list<BGPPeer*> slow;
+    MemberMap::iterator i;
+    for (i = _members.begin(); i != _members.end(); ++i)
+	if (i->second.following && i->second.behind >= MAX_BEHIND)
+	    slow.push_back(i->first);
+
+    list<BGPPeer*>::iterator j;
+    for (j = slow.begin(); j != slow.end(); ++j)
+	if (following(*j))
+	    split(*j);
+}
+
+void
+UpdateGroup::member_ready(BGPPeer* peer)
+{
+    MemberMap::iterator i = _members.find(peer);
+    XLOG_ASSERT(i != _members.end());
+    i->second.busy = false;
+    i->second.behind = 0;
+
+    if (_busy && _handler != NULL) {
+	_busy = false;
+	_handler->output_no_longer_busy();
+    }
+}
+
+void
+UpdateGroup::set_representative()
+{
+    MemberMap::iterator i;
+    for (i = _members.begin(); i != _members.end(); ++i)
+	if (i->second.following)
+	    break;
+    XLOG_ASSERT(i != _members.end());
+
+    _representative = i->first;
+    _handler->set_representative(_representative);
+}
+
+void
+UpdateGroup::dissolve()
+{
+    MemberMap::iterator i;
+    for (i = _members.begin(); i != _members.end(); ++i) {
+	Member& m = i->second;
+	if (!m.following)
+	    continue;
+	if (m.handler->plumbing_unicast() != NULL)
+	    m.handler->plumbing_unicast()->leave_group(m.handler, _handler);
+	if (m.handler->plumbing_multicast() != NULL)
+	    m.handler->plumbing_multicast()->leave_group(m.handler, _handler);
+	m.following = false;
+	m.busy = false;
+	m.behind = 0;
+    }
+
+    delete _handler;
+    _handler = NULL;
+    _representative = NULL;
+    _busy = false;
+}
+
+string
+UpdateGroup::str() const
+{
+    return c_format("%u: %s: %u members (%u following), %u encoded, "
+		    "%u sent, %u rebuilt, %u merges, %u splits",
+		    XORP_UINT_CAST(_id), _key.str().c_str(),
+		    XORP_UINT_CAST(_members.size()),
+		    XORP_UINT_CAST(followers()),
+		    XORP_UINT_CAST(_stats.encodes),
+		    XORP_UINT_CAST(_stats.sent),
+		    XORP_UINT_CAST(_stats.rebuilt),
+		    XORP_UINT_CAST(_stats.merges),
+		    XORP_UINT_CAST(_stats.splits));
+}
+
+/* **************** UpdateGroupTable *********************** */
+
+UpdateGroupTable::UpdateGroupTable(EventLoop& eventloop)
+    : _eventloop(eventloop), _next_id(1)
+{
+}
+
+UpdateGroupTable::~UpdateGroupTable()
+{
+    // The peers have left their groups by now.
+    XLOG_ASSERT(_peers.empty());
+
+    GroupMap::iterator i;
+    for (i = _groups.begin(); i != _groups.end(); ++i)
+	delete i->second;
+}
+
+UpdateGroupKey
+UpdateGroupTable::key(BGPPeer* peer, PeerHandler* handler) const
+{
+    BGPPlumbing* plumbing = handler->plumbing_unicast();
+    XLOG_ASSERT(plumbing != NULL);
+
+    bool by_address = plumbing->directly_connected(handler)
+	|| plumbing->policy_filters().reads(filter::EXPORT,
+					    BGPVarRW<IPv4>::VAR_NEIGHBOR);
+
+    return UpdateGroupKey(peer->peerdata(), by_address);
+}
+
+UpdateGroup*
+UpdateGroupTable::join(BGPPeer* peer, PeerHandler* handler)
+{
+    XLOG_ASSERT(_peers.find(peer) == _peers.end());
+
+    UpdateGroupKey k = key(peer, handler);
+    GroupMap::iterator i = _groups.find(k);
+    if (i == _groups.end()) {
+	UpdateGroup* group = new UpdateGroup(_eventloop, k, _next_id++);
+	i = _groups.insert(make_pair(k, group)).first;
+    }
+
+    UpdateGroup* group = i->second;
+    group->add_member(peer, handler);
+    _peers[peer] = handler;
+    peer->set_update_group(group);
+
+    return group;
+}
+
+void
+UpdateGroupTable::leave(BGPPeer* peer)
+{
+    UpdateGroup* group = peer->update_group();
+    if (group == NULL)
+	return;
+
+    group->remove_member(peer);
+    _peers.erase(peer);
+    peer->set_update_group(NULL);
+
+    if (group->members() != 0)
+	return;
+
+    _groups.erase(group->key());
+    delete group;
+}
+
+void
+UpdateGroupTable::regroup()
+{
+    map<BGPPeer*, PeerHandler*> moved;
+    map<BGPPeer*, PeerHandler*>::iterator i;
+    for (i = _peers.begin(); i != _peers.end(); ++i)
+	if (!(key(i->first, i->second) == i->first->update_group()->key()))
+	    moved.insert(*i);
+
+    for (i = moved.begin(); i != moved.end(); ++i) {
+	UpdateGroup* group = i->first->update_group();
+	// Back on its own branch before it goes to another group.
+	if (group->following(i->first))
+	    group->split(i->first);
+	leave(i->first);
+	join(i->first, i->second);
+    }
+}
@@ -0,0 +1,404 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+
+// Copyright (c) 2001-2009 XORP, Inc.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __BGP_UPDATE_GROUP_HH__
+#define __BGP_UPDATE_GROUP_HH__
+
+#include "libxorp/ref_ptr.hh"
+#include "libxorp/eventloop.hh"
+
+#include "packet.hh"
+#include "peer_data.hh"
+#include "peer_handler.hh"
+
+class UpdateGroup;
+
+/**
+ * @short An UPDATE message in wire format.
+ *
+ * The message is encoded once, and the buffer is shared by reference
+ * between the output queues of all the peers it is sent to.  It is
+ * freed when the last reference goes away.
+ */
+class EncodedUpdate {
+public:
+    /**
+     * Encode a packet.
+     *
+     * @param p the packet.
+     * @param peerdata the data of the peer the packet is encoded for.
+     */
+    EncodedUpdate(const UpdatePacket& p, const BGPPeerData* peerdata);
+    ~EncodedUpdate()			{ delete[] _data; }
+
+    const uint8_t* data() const		{ return _data; }
+    size_t size() const			{ return _size; }
+
+private:
+    EncodedUpdate(const EncodedUpdate&);		// Not implemented
+    EncodedUpdate& operator=(const EncodedUpdate&);	// Not implemented
+
+    uint8_t*	_data;
+    size_t	_size;
+};
+
+/**
+ * @short The properties peers must share to be in the same update group.
+ *
+ * Two peers with the same key have output branches that send them the
+ * same UPDATE messages: the outbound filters, the export policy and
+ * the encoding only depend on these properties.  The address of the
+ * peer is only part of the key when the output branch depends on it:
+ * when the peer is directly connected, or when the export policy
+ * matches on the neighbor.
+ */
+class UpdateGroupKey {
+public:
+    /**
+     * @param peerdata the data of the peer.
+     * @param by_address true if the address of the peer is part of
+     * the key.
+     */
+    UpdateGroupKey(const BGPPeerData* peerdata, bool by_address);
+
+    bool operator<(const UpdateGroupKey& him) const;
+    bool operator==(const UpdateGroupKey& him) const {
+	return !(*this < him) && !(him < *this);
+    }
+    string str() const;
+
+private:
+    PeerType	_peer_type;		// Includes the route reflector role
+    uint32_t	_as;
+    uint32_t	_my_as;
+    bool	_use_4byte_asnums;
+    bool	_we_use_4byte_asnums;
+    uint32_t	_families;		// Negotiated AFI/SAFIs
+    string	_local_addr;
+    IPv4	_v4_nexthop;
+    IPv6	_v6_nexthop;
+    IPv4	_next_hop_rewrite;
+    string	_peer_addr;		// Empty unless by address
+};
+
+/**
+ * @short The PeerHandler of the output branch of an update group.
+ *
+ * The group has a single output branch in each plumbing, from the
+ * fanout table to a RibOut and to this handler.  The UPDATE messages
+ * it builds are given to the group, to be encoded once and sent to
+ * all the members that follow the branch.  The data of the peering
+ * the branch is configured from is taken from one of the members,
+ * the representative: they all have the same.
+ *
+ * The branch of a member does not send it the routes it announced
+ * itself, which the fanout table skips.  The group branch is sent
+ * them, so the handler keeps the routes of the UPDATE it builds and
+ * the peers they came from.  A member an UPDATE holds routes of is
+ * sent an UPDATE built for it alone, without them.
+ */
+class UpdateGroupHandler : public PeerHandler {
+public:
+    /**
+     * Plumb the output branch of a group in the plumbings of a member.
+     *
+     * @param group the group.
+     * @param id a number that is unique to the group.
+     * @param peer the representative.
+     * @param handler the handler of the representative.
+     */
+    UpdateGroupHandler(UpdateGroup& group, uint32_t id, BGPPeer* peer,
+		       PeerHandler* handler);
+    ~UpdateGroupHandler();
+
+    /**
+     * @return an ID in 0.0.0.0/8, which no BGP peer can have.
+     */
+    const IPv4& id() const		{ return _id; }
+
+    bool update_group_handler() const	{ return true; }
+
+    void output_no_longer_busy();
+
+    /**
+     * Take the data of the peering from another member.
+     */
+    void set_representative(BGPPeer* peer)	{ set_peer(peer); }
+
+    void set_origin_peers(const PeerHandler* old_origin,
+			  const PeerHandler* new_origin);
+
+    int start_packet();
+    PeerOutputState push_packet();
+    int add_route(const SubnetRoute<IPv4> &rt, FPAList4Ref& pa_list,
+		  bool ibgp, Safi safi);
+    int replace_route(const SubnetRoute<IPv4> &old_rt, bool old_ibgp,
+		      const SubnetRoute<IPv4> &new_rt, bool new_ibgp,
+		      FPAList4Ref& pa_list, Safi safi);
+    int delete_route(const SubnetRoute<IPv4> &rt, FPAList4Ref& pa_list,
+		     bool ibgp, Safi safi);
+#ifdef HAVE_IPV6
+    int add_route(const SubnetRoute<IPv6> &rt, FPAList6Ref& pa_list,
+		  bool ibgp, Safi safi);
+    int replace_route(const SubnetRoute<IPv6> &old_rt, bool old_ibgp,
+		      const SubnetRoute<IPv6> &new_rt, bool new_ibgp,
+		      FPAList6Ref& pa_list, Safi safi);
+    int delete_route(const SubnetRoute<IPv6> &rt, FPAList6Ref& pa_list,
+		     bool ibgp, Safi safi);
+#endif
+
+    /**
+     * @return true if the UPDATE being sent holds routes a member
+     * announced itself.
+     */
+    bool holds_routes_of(const PeerHandler* member) const {
+	return _origins.find(member) != _origins.end();
+    }
+
+    /**
+     * Send a member the UPDATE being sent without the routes it
+     * announced itself, as the output branch of the member would.
+     *
+     * @param peer the member.
+     * @param member the PeerHandler of the member.
+     * @return the state of the output queue of the member.
+     */
+    PeerOutputState send_without_routes_of(BGPPeer* peer,
+					    const PeerHandler* member);
+
+protected:
+    PeerOutputState send_update(const UpdatePacket& p);
+
+private:
+    /**
+     * A route of the UPDATE being built.  An add has no old route and
+     * a delete no new route.
+     */
+    template <class A>
+    struct Change {
+	Change(const SubnetRoute<A>* old_rt, bool old_ibgp_,
+	       const SubnetRoute<A>* new_rt, bool new_ibgp_,
+	       const ref_ptr<FastPathAttributeList<A> >& pa_list_, Safi safi_,
+	       const PeerHandler* old_origin_,
+	       const PeerHandler* new_origin_)
+	    : old_route(old_rt), old_ibgp(old_ibgp_),
+	      new_route(new_rt), new_ibgp(new_ibgp_),
+	      pa_list(pa_list_), safi(safi_),
+	      old_origin(old_origin_), new_origin(new_origin_) {}
+
+	SubnetRouteConstRef<A>		old_route;
+	bool				old_ibgp;
+	SubnetRouteConstRef<A>		new_route;
+	bool				new_ibgp;
+	ref_ptr<FastPathAttributeList<A> > pa_list;
+	Safi				safi;
+	const PeerHandler*		old_origin;
+	const PeerHandler*		new_origin;
+    };
+
+    template <class A>
+    void record(list<Change<A> >& changes, const Change<A>& change);
+
+    template <class A>
+    void replay(PeerHandler& builder, const list<Change<A> >& changes,
+		const PeerHandler* member) const;
+
+    UpdateGroup&	_group;
+    IPv4		_id;
+
+    const PeerHandler*	_old_origin;	// Of the next route
+    const PeerHandler*	_new_origin;
+    list<Change<IPv4> >	_changes4;	// Of the UPDATE being built
+#ifdef HAVE_IPV6
+    list<Change<IPv6> >	_changes6;
+#endif
+    set<const PeerHandler*> _origins;
+};
+
+/**
+ * @short A set of peers sent the same UPDATE messages.
+ *
+ * All the members of a group have the same key, so their output
+ * branches would send them the same messages.  Once at least two of
+ * them are up to date, they stop following their own branches and
+ * follow the branch of the group instead: the routes go through a
+ * single set of outbound filters and a single RibOut, and each UPDATE
+ * message is built and encoded once and the encoded message shared
+ * by reference between the output queues of the followers.
+ *
+ * A follower whose output queue stays busy for MAX_BEHIND messages
+ * falls out of the group: its own output branch is plumbed back in
+ * with what the group still has to send, so that its flow control no
+ * longer holds up the others.  It follows the group again once both
+ * its own branch and the group's have nothing left to send.
+ */
+class UpdateGroup {
+public:
+    /**
+     * Group statistics.
+     */
+    struct Stats {
+	uint32_t	encodes;	// messages encoded
+	uint32_t	sent;		// messages sent to the followers
+	uint32_t	rebuilt;	// without the routes of a follower
+	uint32_t	merges;		// members that started following
+	uint32_t	splits;		// followers that fell behind
+    };
+
+    /**
+     * The number of messages a busy follower is sent before it falls
+     * out of the group.
+     */
+    static const uint32_t MAX_BEHIND = 64;
+
+    /**
+     * How often members not following the group check if they can.
+     */
+    static const int MERGE_INTERVAL_MS = 1000;
+
+    UpdateGroup(EventLoop& eventloop, const UpdateGroupKey& key,
+		uint32_t id);
+    ~UpdateGroup();
+
+    const UpdateGroupKey& key() const	{ return _key; }
+    uint32_t id() const			{ return _id; }
+
+    /**
+     * Add an established peer, which keeps its own output branch
+     * until it can follow the group.
+     */
+    void add_member(BGPPeer* peer, PeerHandler* handler);
+
+    /**
+     * Remove a member whose peering is going down.  Its output branch
+     * is left as it is.
+     */
+    void remove_member(BGPPeer* peer);
+
+    /**
+     * @return true if a member follows the output branch of the group.
+     */
+    bool following(BGPPeer* peer) const;
+
+    /**
+     * Plumb the output branch of a follower back in, with what the
+     * group still has to send.
+     */
+    void split(BGPPeer* peer);
+
+    /**
+     * Move the members that are up to date onto the output branch of
+     * the group, creating it if necessary.
+     */
+    void merge();
+
+    /**
+     * Encode an UPDATE message of the group and send it to the
+     * followers.
+     *
+     * @return the state of the output queue of the group: busy only if
+     * the queues of all the followers are.
+     */
+    PeerOutputState send_update(const UpdatePacket& p);
+
+    /**
+     * The output queue of a follower drained.
+     */
+    void member_ready(BGPPeer* peer);
+
+    size_t members() const		{ return _members.size(); }
+    size_t followers() const;
+    const Stats& stats() const		{ return _stats; }
+
+    string str() const;
+
+private:
+    struct Member {
+	Member(PeerHandler* h)
+	    : handler(h), following(false), busy(false), behind(0) {}
+
+	PeerHandler*	handler;
+	bool		following;
+	bool		busy;		// Its output queue
+	uint32_t	behind;		// Messages sent while busy
+    };
+    typedef map<BGPPeer*, Member> MemberMap;
+
+    bool output_idle(PeerHandler* handler) const;
+    void set_representative();
+    void dissolve();
+    bool merge_timer();
+    void split_slow();
+
+    EventLoop&		_eventloop;
+    UpdateGroupKey	_key;
+    uint32_t		_id;
+    UpdateGroupHandler*	_handler;	// Only while members follow
+    BGPPeer*		_representative;
+    MemberMap		_members;
+    bool		_busy;		// Told the RibOut we are busy
+    XorpTimer		_merge_timer;
+    XorpTask		_split_task;
+    Stats		_stats;
+};
+
+/**
+ * @short The update groups of all the established peers.
+ */
+class UpdateGroupTable {
+public:
+    UpdateGroupTable(EventLoop& eventloop);
+    ~UpdateGroupTable();
+
+    /**
+     * Add an established peer to the group matching it, creating the
+     * group if necessary.
+     *
+     * @param peer the peer.
+     * @param handler the PeerHandler of the peer.
+     * @return the group joined.
+     */
+    UpdateGroup* join(BGPPeer* peer, PeerHandler* handler);
+
+    /**
+     * Remove a peer whose peering is going down from its group,
+     * deleting the group if empty.
+     */
+    void leave(BGPPeer* peer);
+
+    /**
+     * Move the peers that no longer match their group, after a change
+     * of the export policy, to the group matching them.
+     */
+    void regroup();
+
+    size_t groups() const		{ return _groups.size(); }
+
+private:
+    typedef map<UpdateGroupKey, UpdateGroup*> GroupMap;
+
+    UpdateGroupKey key(BGPPeer* peer, PeerHandler* handler) const;
+
+    EventLoop&			_eventloop;
+    GroupMap			_groups;
+    map<BGPPeer*, PeerHandler*>	_peers;
+    uint32_t			_next_id;
+};
+
+#endif // __BGP_UPDATE_GROUP_HH__
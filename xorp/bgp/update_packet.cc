@@ -30,6 +30,8 @@
 
 #include "packet.hh"
 #include "peer.hh"
+#include "update_decoder.hh"
+#include "encoding_cache.hh"
 
 #if 1
 void
@@ -47,7 +49,7 @@ void dump_bytes(const uint8_t*, size_t) {}
 /* **************** UpdatePacket *********************** */
 
 UpdatePacket::UpdatePacket()
-    : _pa_list(new FastPathAttributeList<IPv4>())
+    : _pa_list(new FastPathAttributeList<IPv4>()), _in_place(false)
 {
     _Type = MESSAGETYPEUPDATE;
 }
@@ -59,6 +61,7 @@ UpdatePacket::~UpdatePacket()
 void
 UpdatePacket::add_nlri(const BGPUpdateAttrib& nlri)
 {
+    decode_in_place();
     _nlri_list.push_back(nlri);
 }
 
@@ -84,6 +87,7 @@ UpdatePacket::replace_pathattribute_list(FPAList4Ref& pa_list)
 void
 UpdatePacket::add_withdrawn(const BGPUpdateAttrib& wdr)
 {
+    decode_in_place();
     _wr_list.push_back(wdr);
 }
 
@@ -95,7 +99,7 @@ UpdatePacket::big_enough() const
     //XXXX needs additional tests for v6
 
     //quick and dirty check
-    if (((_wr_list.size() + _nlri_list.size())* 4) > 2048) {
+    if (((wr_list().size() + nlri_list().size())* 4) > 2048) {
 	debug_msg("withdrawn size = %u\n", XORP_UINT_CAST(_wr_list.size()));
 	debug_msg("nlri size = %u\n", XORP_UINT_CAST(_wr_list.size()));
 	return true;
@@ -106,7 +110,7 @@ UpdatePacket::big_enough() const
 bool
 UpdatePacket::encode(uint8_t *d, size_t &len, const BGPPeerData *peerdata) const
 {
-    XLOG_ASSERT( (_nlri_list.empty()) ||  !(_pa_list->is_empty()) );
+    XLOG_ASSERT( (nlri_list().empty()) ||  !(_pa_list->is_empty()) );
     XLOG_ASSERT(d != 0);
     XLOG_ASSERT(len != 0);
     debug_msg("UpdatePacket::encode: len=%u\n", (uint32_t)len);
@@ -119,12 +123,16 @@ UpdatePacket::encode(uint8_t *d, size_t &len, const BGPPeerData *peerdata) const
     size_t nlri_len = nlri_list().wire_size();
 
     // compute packet length
+    // The attributes usually come ready encoded from the cache.
     pa_len = BGPPacket::MAXPACKETSIZE;
-    uint8_t pa_list_buf[pa_len];
+    const uint8_t *pa_list_buf = 0;
     if (_pa_list->is_empty() ) {
 	pa_len = 0;
     } else {
-	if (_pa_list->encode(pa_list_buf, pa_len, peerdata) == false) {
+	pa_list_buf = AttributeEncodingCache::shared().encode(_pa_list,
+							       pa_len,
+							       peerdata);
+	if (pa_list_buf == 0) {
 	    XLOG_WARNING("failed to encode update - no space for pa list\n");
 	    return false;
 	}
@@ -176,7 +184,8 @@ UpdatePacket::encode(uint8_t *d, size_t &len, const BGPPeerData *peerdata) const
 	i += (*pai)->wire_size();
     }
 #endif
-    memcpy(d+i, pa_list_buf, pa_len);
+    if (pa_len > 0)
+	memcpy(d+i, pa_list_buf, pa_len);
     i += pa_len;
 
     // fill NLRI list
@@ -188,16 +197,115 @@ UpdatePacket::encode(uint8_t *d, size_t &len, const BGPPeerData *peerdata) const
 UpdatePacket::UpdatePacket(const uint8_t *d, uint16_t l, 
 			   const BGPPeerData* peerdata,
 			   BGPMain *mainprocess,
-			   bool do_checks) throw(CorruptMessage,UnusableMessage)
+			   bool do_checks,
+			   bool in_place) throw(CorruptMessage,UnusableMessage)
+    : _in_place(false)
 {
     debug_msg("UpdatePacket constructor called\n");
     _Type = MESSAGETYPEUPDATE;
+
+    size_t wr_offset, wr_len, pa_offset, pa_len, nlri_offset, nlri_len;
+    find_sections(d, l, wr_offset, wr_len, pa_offset, pa_len,
+		  nlri_offset, nlri_len);
+
+    // Start of decoding of withdrawn routes.
+    bool unique = true;
+    if (in_place)
+	unique = _wr_wire.check(d + wr_offset, wr_len);
+    else
+	_wr_list.decode(d + wr_offset, wr_len);
+
+    // Start of decoding of Path Attributes
+    _pa_list = new FastPathAttributeList<IPv4>();
+    _pa_list->load_raw_data(d + pa_offset, pa_len, peerdata, 
+			    (nlri_len > 0), mainprocess, do_checks, in_place);
+
+    // Start of decoding of Network Reachability
+    if (in_place) {
+	if (!_nlri_wire.check(d + nlri_offset, nlri_len))
+	    unique = false;
+	_in_place = true;
+
+	// Duplicates are rare, leave them to the lists to drop.
+	if (!unique)
+	    decode_in_place();
+    } else {
+	_nlri_list.decode(d + nlri_offset, nlri_len);
+    }
+    /* End of decoding of Network Reachability */
+    debug_msg("No of withdrawn routes %u. "
+	      "No of networks %u.\n",
+	      XORP_UINT_CAST(_in_place ? _wr_wire.size() : _wr_list.size()),
+	      XORP_UINT_CAST(nlri_count()));
+}
+
+UpdatePacket::UpdatePacket(DecodedUpdate& du,
+			   BGPMain *mainprocess)
+    throw(CorruptMessage,UnusableMessage)
+    : _in_place(false)
+{
+    debug_msg("UpdatePacket constructor called\n");
+    _Type = MESSAGETYPEUPDATE;
+
+    BGPUpdateAttribList::const_iterator i;
+    for (i = du.duplicates().begin(); i != du.duplicates().end(); ++i)
+	XLOG_WARNING("Received duplicate %s in update message",
+		     i->str("nlri or withdraw").c_str());
+
+    if (du.section_error() != NULL)
+	throw CorruptMessage(*du.section_error());
+
+    _wr_list.swap(du.wr_list());
+
+    if (du.pa_error() != NULL)
+	throw CorruptMessage(*du.pa_error());
+
+    // The attributes were decoded and checked by the decoder.
+    _pa_list = du.release_pa_list();
+    XLOG_ASSERT(!_pa_list.is_empty());
+    _pa_list->intern_as_paths();
+    _pa_list->check_nexthops(mainprocess, /*do checks*/true);
+
+    if (du.nlri_error() != NULL)
+	throw CorruptMessage(*du.nlri_error());
+
+    _nlri_list.swap(du.nlri_list());
+    debug_msg("No of withdrawn routes %u. "
+	      "No of networks %u.\n",
+	      XORP_UINT_CAST(_wr_list.size()),
+	      XORP_UINT_CAST(_nlri_list.size()));
+}
+
+void
+UpdatePacket::decode_sections(const uint8_t *d, uint16_t l,
+			      BGPUpdateAttribList& wr_list,
+			      BGPUpdateAttribList *duplicates,
+			      size_t& pa_offset, size_t& pa_len,
+			      size_t& nlri_offset, size_t& nlri_len)
+    throw(CorruptMessage)
+{
+    size_t wr_offset, wr_len;
+    find_sections(d, l, wr_offset, wr_len, pa_offset, pa_len,
+		  nlri_offset, nlri_len);
+
+    // Start of decoding of withdrawn routes.
+    wr_list.decode(d + wr_offset, wr_len, duplicates);
+}
+
+void
+UpdatePacket::find_sections(const uint8_t *d, uint16_t l,
+			    size_t& wr_offset, size_t& wr_len,
+			    size_t& pa_offset, size_t& pa_len,
+			    size_t& nlri_offset, size_t& nlri_len)
+    throw(CorruptMessage)
+{
     if (l < BGPPacket::MINUPDATEPACKET)
 	xorp_throw(CorruptMessage,
 		   c_format("Update Message too short %d", l),
 		   MSGHEADERERR, BADMESSLEN, d + BGPPacket::MARKER_SIZE, 2);
+    const uint8_t *start = d;
     d += BGPPacket::COMMON_HEADER_LEN;		// move past header
-    size_t wr_len = (d[0] << 8) + d[1];		// withdrawn length
+    wr_len = (d[0] << 8) + d[1];		// withdrawn length
     if (BGPPacket::MINUPDATEPACKET + wr_len > l)
 	xorp_throw(CorruptMessage,
 		   c_format("Unreachable routes length is bogus %u > %u",
@@ -205,7 +313,7 @@ UpdatePacket::UpdatePacket(const uint8_t *d, uint16_t l,
 			    XORP_UINT_CAST(l - BGPPacket::MINUPDATEPACKET)),
 		   UPDATEMSGERR, MALATTRLIST);
     
-    size_t pa_len = (d[wr_len+2] << 8) + d[wr_len+3];	// pathatt length
+    pa_len = (d[wr_len+2] << 8) + d[wr_len+3];	// pathatt length
     if (BGPPacket::MINUPDATEPACKET + pa_len + wr_len > l)
 	xorp_throw(CorruptMessage,
 		   c_format("Pathattr length is bogus %u > %u",
@@ -213,29 +321,26 @@ UpdatePacket::UpdatePacket(const uint8_t *d, uint16_t l,
 			    XORP_UINT_CAST(l - wr_len - BGPPacket::MINUPDATEPACKET)),
 		UPDATEMSGERR, MALATTRLIST);
 
-    size_t nlri_len = l - BGPPacket::MINUPDATEPACKET - pa_len - wr_len;
+    nlri_len = l - BGPPacket::MINUPDATEPACKET - pa_len - wr_len;
 
-    // Start of decoding of withdrawn routes.
     d += 2;	// point to the routes.
-    _wr_list.decode(d, wr_len);
+    wr_offset = d - start;
     d += wr_len;
 
-    // Start of decoding of Path Attributes
     d += 2; // move past Total Path Attributes Length field
+    pa_offset = d - start;
+    nlri_offset = pa_offset + pa_len;
+}
 
-    size_t used = pa_len;
-    _pa_list = new FastPathAttributeList<IPv4>();
-    _pa_list->load_raw_data(d, used, peerdata, 
-			    (nlri_len > 0), mainprocess, do_checks);
-    d += used;
+void
+UpdatePacket::decode_in_place() const
+{
+    if (!_in_place)
+	return;
 
-    // Start of decoding of Network Reachability
-    _nlri_list.decode(d, nlri_len);
-    /* End of decoding of Network Reachability */
-    debug_msg("No of withdrawn routes %u. "
-	      "No of networks %u.\n",
-	      XORP_UINT_CAST(_wr_list.size()),
-	      XORP_UINT_CAST(_nlri_list.size()));
+    _wr_list.decode(_wr_wire.data(), _wr_wire.wire_size());
+    _nlri_list.decode(_nlri_wire.data(), _nlri_wire.wire_size());
+    _in_place = false;
 }
 
 string
@@ -247,8 +352,8 @@ UpdatePacket::str() const
 	      XORP_UINT_CAST(_wr_list.size()),
 	      XORP_UINT_CAST(_nlri_list.size()));
 
-    if (!_wr_list.empty())
-	s += _wr_list.str("Withdrawn");
+    if (!wr_list().empty())
+	s += wr_list().str("Withdrawn");
 
     if (!_pa_list->is_empty()) {
 	s += _pa_list->str();
@@ -262,7 +367,7 @@ UpdatePacket::str() const
     }
 #endif
     
-    s += _nlri_list.str("Nlri");
+    s += nlri_list().str("Nlri");
     return s;
 }
 
@@ -281,7 +386,7 @@ UpdatePacket::operator==(const UpdatePacket& him) const
 {
     debug_msg("compare %s and %s", this->str().c_str(), him.str().c_str());
 
-    if (_wr_list != him.wr_list())
+    if (wr_list() != him.wr_list())
 	return false;
 
 #if 0
@@ -331,7 +436,7 @@ UpdatePacket::operator==(const UpdatePacket& him) const
     }
 
     //net layer reachability equals
-    if (_nlri_list != him.nlri_list())
+    if (nlri_list() != him.nlri_list())
 	return false;
 
     return true;
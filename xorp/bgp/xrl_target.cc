@@ -40,6 +40,7 @@
 #include "xrl/interfaces/profile_client_xif.hh"
 #endif
 
+#include "attribute_manager.hh"
 #include "bgp.hh"
 #include "iptuple.hh"
 #include "xrl_target.hh"
@@ -853,6 +854,79 @@ XrlBgpTarget::bgp_0_3_trace(const string& tvar,
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlBgpTarget::bgp_0_3_get_attribute_stats(
+					  // Input values,
+					  const bool&	ipv6,
+					  // Output values,
+					  uint32_t&	lists,
+					  uint32_t&	references,
+					  uint64_t&	bytes,
+					  uint64_t&	bytes_shared,
+					  uint64_t&	lookups,
+					  uint64_t&	hits)
+{
+    AttributeManagerStats stats;
+
+    if (ipv6) {
+#ifdef HAVE_IPV6
+	const AttributeManager<IPv6>* mgr = PAListRef<IPv6>::attribute_manager();
+	if (mgr == NULL)
+	    return XrlCmdError::COMMAND_FAILED("No IPv6 attribute manager");
+	stats = mgr->stats();
+#else
+	return XrlCmdError::COMMAND_FAILED("IPv6 not supported");
+#endif
+    } else {
+	const AttributeManager<IPv4>* mgr = PAListRef<IPv4>::attribute_manager();
+	if (mgr == NULL)
+	    return XrlCmdError::COMMAND_FAILED("No IPv4 attribute manager");
+	stats = mgr->stats();
+    }
+
+    lists = stats.lists;
+    references = stats.references;
+    bytes = stats.bytes;
+    bytes_shared = stats.bytes_shared;
+    lookups = stats.lookups;
+    hits = stats.hits;
+
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlBgpTarget::bgp_0_3_set_decode_threads(
+					 // Input values,
+					 const uint32_t&	threads)
+{
+    string error_msg;
+
+    if (_bgp.set_decode_threads(threads, error_msg) != XORP_OK)
+	return XrlCmdError::COMMAND_FAILED(error_msg);
+
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlBgpTarget::bgp_0_3_set_fast_dump(
+				    // Input values,
+				    const bool&	enable)
+{
+    _bgp.set_fast_dump(enable);
+
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlBgpTarget::bgp_0_3_set_incremental_policy_push(
+				    // Input values,
+				    const bool&	enable)
+{
+    _bgp.set_incremental_policy_push(enable);
+
+    return XrlCmdError::OKAY();
+}
+
 XrlCmdError 
 XrlBgpTarget::bgp_0_3_get_peer_list_start(
 					  // Output values, 
@@ -1399,6 +1473,39 @@ XrlBgpTarget::profile_0_1_list(string& info)
     info = _bgp.profile().get_list();
     return XrlCmdError::OKAY();
 }
+
+XrlCmdError
+XrlBgpTarget::profile_0_1_set_histogram(const string& pname,
+					const bool& histogram)
+{
+    debug_msg("profile variable %s histogram %s\n", pname.c_str(),
+	      bool_c_str(histogram));
+
+    try {
+	_bgp.profile().set_histogram(pname, histogram);
+    } catch(PVariableUnknown& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    } catch(PVariableLocked& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    }
+
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlBgpTarget::profile_0_1_get_histogram(const string& pname,
+					string& histogram)
+{
+    debug_msg("profile variable %s\n", pname.c_str());
+
+    try {
+	histogram = _bgp.profile().get_histogram(pname);
+    } catch(PVariableUnknown& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    }
+
+    return XrlCmdError::OKAY();
+}
 #endif
 
 bool 
@@ -22,6 +22,7 @@
 #ifndef __BGP_XRL_TARGET_HH__
 #define __BGP_XRL_TARGET_HH__
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/bgp_base.hh"
 
 class BGPMain;
@@ -47,6 +48,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     XrlCmdError bgp_0_3_get_bgp_version(
@@ -260,6 +269,29 @@ public:
 	const string&	tvar,
 	const bool&	enable);
 
+    XrlCmdError bgp_0_3_get_attribute_stats(
+	// Input values,
+	const bool&	ipv6,
+	// Output values,
+	uint32_t&	lists,
+	uint32_t&	references,
+	uint64_t&	bytes,
+	uint64_t&	bytes_shared,
+	uint64_t&	lookups,
+	uint64_t&	hits);
+
+    XrlCmdError bgp_0_3_set_decode_threads(
+	// Input values,
+	const uint32_t&	threads);
+
+    XrlCmdError bgp_0_3_set_fast_dump(
+	// Input values,
+	const bool&	enable);
+
+    XrlCmdError bgp_0_3_set_incremental_policy_push(
+	// Input values,
+	const bool&	enable);
+
     XrlCmdError bgp_0_3_get_peer_list_start(
         // Output values,
         uint32_t& token,
@@ -554,6 +586,17 @@ public:
     XrlCmdError profile_0_1_list(
 	// Output values,
 	string&	info);
+
+    XrlCmdError profile_0_1_set_histogram(
+	// Input values,
+	const string&	pname,
+	const bool&	histogram);
+
+    XrlCmdError profile_0_1_get_histogram(
+	// Input values,
+	const string&	pname,
+	// Output values,
+	string&	histogram);
 #endif
 
     bool waiting();
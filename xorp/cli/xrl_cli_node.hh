@@ -26,6 +26,7 @@
 
 #include "libxorp/xlog.h"
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/cli_base.hh"
 #include "xrl/interfaces/cli_processor_xif.hh"
 #include "cli_node.hh"
@@ -98,6 +99,14 @@ protected:
      */
     virtual XrlCmdError common_0_1_shutdown();
 
+    virtual XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    virtual XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     virtual XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     /**
@@ -28,6 +28,7 @@
 //
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 
 #include "libfeaclient/ifmgr_xrl_mirror.hh"
 
@@ -137,6 +138,14 @@ protected:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      *  Announce target birth to observer.
      *
@@ -370,6 +370,24 @@ XrlOlsr4Target::profile_0_1_list(string& info)
     UNUSED(info);
 }
 
+XrlCmdError
+XrlOlsr4Target::profile_0_1_set_histogram(const string& pname,
+					  const bool& histogram)
+{
+    return XrlCmdError::COMMAND_FAILED("Profiling not yet implemented");
+    UNUSED(pname);
+    UNUSED(histogram);
+}
+
+XrlCmdError
+XrlOlsr4Target::profile_0_1_get_histogram(const string& pname,
+					  string& histogram)
+{
+    return XrlCmdError::COMMAND_FAILED("Profiling not yet implemented");
+    UNUSED(pname);
+    UNUSED(histogram);
+}
+
 
 /*
  * olsr4/0.1 target interface.
@@ -23,6 +23,7 @@
 #ifndef __OLSR_XRL_TARGET_HH__
 #define __OLSR_XRL_TARGET_HH__
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/olsr4_base.hh"
 
 #include "olsr.hh"
@@ -64,6 +65,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     /**
@@ -275,6 +284,26 @@ public:
 	// Output values,
 	string&	info);
 
+    /**
+     * Select between logging entries and counting them in a histogram.
+     *
+     * @param pname profile variable
+     * @param histogram true to count the entries in a histogram
+     */
+     XrlCmdError profile_0_1_set_histogram(
+	// Input values,
+	const string&	pname,
+	const bool&	histogram);
+
+    /**
+     *  Get the histogram of a profile variable.
+     */
+     XrlCmdError profile_0_1_get_histogram(
+	// Input values,
+	const string&	pname,
+	// Output values,
+	string&	histogram);
+
     /**
      * Enable/Disable tracing.
      *
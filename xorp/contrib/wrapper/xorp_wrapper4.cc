@@ -265,6 +265,22 @@ XrlCmdError XrlWrapper4Target::profile_0_1_list(string& info)
     UNUSED(info);
 }
 
+XrlCmdError XrlWrapper4Target::profile_0_1_set_histogram(const string& pname,
+        const bool& histogram)
+{
+    return XrlCmdError::COMMAND_FAILED("Profiling not yet implemented");
+    UNUSED(pname);
+    UNUSED(histogram);
+}
+
+XrlCmdError XrlWrapper4Target::profile_0_1_get_histogram(const string& pname,
+        string& histogram)
+{
+    return XrlCmdError::COMMAND_FAILED("Profiling not yet implemented");
+    UNUSED(pname);
+    UNUSED(histogram);
+}
+
 XrlCmdError XrlWrapper4Target::wrapper4_0_1_set_admin_distance(const uint32_t& admin)
 {
     _wrapper.set_admin_dist(admin);
@@ -19,6 +19,7 @@
 
 #include "xrl/targets/wrapper4_base.hh"
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 
 #include "xorp_io.hh"
 
@@ -60,6 +61,14 @@ public:
         return XrlCmdError::OKAY();
     }
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      * Announce target birth to observer.
      *
@@ -269,6 +278,26 @@ public:
         // Output values,
         string& info);
 
+    /**
+     * Select between logging entries and counting them in a histogram.
+     *
+     * @param pname profile variable
+     * @param histogram true to count the entries in a histogram
+     */
+    XrlCmdError profile_0_1_set_histogram(
+        // Input values,
+        const string&   pname,
+        const bool&     histogram);
+
+    /**
+     *  Get the histogram of a profile variable.
+     */
+    XrlCmdError profile_0_1_get_histogram(
+        // Input values,
+        const string&   pname,
+        // Output values,
+        string& histogram);
+
     /**
      */
     XrlCmdError wrapper4_0_1_set_admin_distance(
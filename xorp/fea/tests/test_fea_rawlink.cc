@@ -37,6 +37,7 @@
 
 #include "libxipc/sockutil.hh"
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 
 #include "xrl/interfaces/fea_rawlink_xif.hh"
 #include "xrl/targets/test_fea_rawlink_base.hh"
@@ -282,6 +283,14 @@ protected:
 	return XrlCmdError::COMMAND_FAILED("Not supported");
     }
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      *  Receive a raw link-level packet on an interface.
      *
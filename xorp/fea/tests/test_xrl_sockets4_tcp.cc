@@ -34,6 +34,7 @@
 
 #include "libxipc/sockutil.hh"
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 
 #include "xrl/interfaces/socket4_xif.hh"
 #include "xrl/targets/test_socket4_base.hh"
@@ -180,6 +181,14 @@ protected:
 	return XrlCmdError::COMMAND_FAILED("Not supported");
     }
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError
     socket4_user_0_1_recv_event(const string&		sockid,
 				const string&		if_name,
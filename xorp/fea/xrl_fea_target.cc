@@ -4843,4 +4843,37 @@ XrlFeaTarget::profile_0_1_list(string& info)
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlFeaTarget::profile_0_1_set_histogram(const string& pname,
+					const bool& histogram)
+{
+    debug_msg("profile variable %s histogram %s\n", pname.c_str(),
+	      bool_c_str(histogram));
+
+    try {
+	_profile.set_histogram(pname, histogram);
+    } catch(PVariableUnknown& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    } catch(PVariableLocked& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    }
+
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlFeaTarget::profile_0_1_get_histogram(const string& pname,
+					string& histogram)
+{
+    debug_msg("profile variable %s\n", pname.c_str());
+
+    try {
+	histogram = _profile.get_histogram(pname);
+    } catch(PVariableUnknown& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    }
+
+    return XrlCmdError::OKAY();
+}
+
 #endif //profile
@@ -27,6 +27,7 @@
 // FEA (Forwarding Engine Abstraction) XRL target implementation.
 //
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/fea_base.hh"
 #include "xrl_fib_client_manager.hh"
 
@@ -127,6 +128,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     /** Does nothing, but allows us to have rtrmgr verify startup. */
@@ -2733,6 +2742,17 @@ public:
     XrlCmdError profile_0_1_list(
 	// Output values,
 	string&	info);
+
+    XrlCmdError profile_0_1_set_histogram(
+	// Input values,
+	const string&	pname,
+	const bool&	histogram);
+
+    XrlCmdError profile_0_1_get_histogram(
+	// Input values,
+	const string&	pname,
+	// Output values,
+	string&	histogram);
 #endif
 
 private:
@@ -26,6 +26,7 @@
 //
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/interfaces/finder_event_notifier_xif.hh"
 #include "xrl/interfaces/mfea_client_xif.hh"
 #include "xrl/interfaces/cli_manager_xif.hh"
@@ -130,6 +131,14 @@ protected:
 	return mfea_0_1_start_mfea();
     }
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      *  Announce target birth to observer.
      *
@@ -25,6 +25,7 @@
 #include "libxorp/eventloop.hh"
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/interfaces/fea_ifmgr_replicator_xif.hh"
 #include "ifmgr_cmds.hh"
 #include "ifmgr_xrl_mirror.hh"
@@ -76,6 +77,14 @@ protected:
 
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     XrlCmdError fea_ifmgr_mirror_0_1_interface_add(
@@ -24,6 +24,7 @@
 #ifndef __LIBXIPC_FINDER_XRL_TARGET_HH__
 #define __LIBXIPC_FINDER_XRL_TARGET_HH__
 
+#include "xrl_dispatch_stats.hh"
 #include "xrl/targets/finder_base.hh"
 
 class Finder;
@@ -49,6 +50,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     /**
@@ -39,6 +39,7 @@
 
 #include "xrl/interfaces/finder_event_notifier_xif.hh"
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/test_finder_events_base.hh"
 
 #include "finder_server.hh"
@@ -256,6 +257,14 @@ public:
 	return XrlCmdError::COMMAND_FAILED();
     }
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError finder_event_observer_0_1_xrl_target_birth(const string& cls,
 							   const string& ins)
     {
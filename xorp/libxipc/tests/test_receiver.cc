@@ -32,6 +32,7 @@
 #include "libxorp/profile.hh"
 #include "libxorp/status_codes.h"
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/test_xrls_base.hh"
 #include "test_receiver.hh"
 
@@ -48,6 +48,14 @@ private:
 	string&	reason);
 
     XrlCmdError common_0_1_shutdown();
+
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     XrlCmdError test_xrls_0_1_start_transmission();
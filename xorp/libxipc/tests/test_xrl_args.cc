@@ -33,6 +33,7 @@
 #endif
 
 #include "xrl_args.hh"
+#include "xrl_tokens.hh"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -194,6 +195,68 @@ run_serialization_test()
     return 0;
 }
 
+/**
+ * Check that get() returns the right atoms however a list is walked,
+ * and that a long list survives packing and unpacking.
+ */
+static int
+run_list_test()
+{
+    static const uint32_t N = 1000;
+
+    XrlAtomList xal;
+    for (uint32_t i = 0; i < N; i++)
+	xal.append(XrlAtom(i));
+
+    for (uint32_t i = 0; i < N; i++) {
+	if (xal.get(i).uint32() != i) {
+	    verbose_log("Forward get(%u) failed.\n", XORP_UINT_CAST(i));
+	    return 1;
+	}
+    }
+    for (uint32_t i = N; i-- > 0; ) {
+	if (xal.get(i).uint32() != i) {
+	    verbose_log("Backward get(%u) failed.\n", XORP_UINT_CAST(i));
+	    return 1;
+	}
+    }
+
+    xal.get(N / 2);
+    xal.remove(0);
+    xal.prepend(XrlAtom(N));
+    if (xal.get(0).uint32() != N || xal.get(N / 2).uint32() != N / 2) {
+	verbose_log("get() after remove() and prepend() failed.\n");
+	return 1;
+    }
+
+    XrlAtomList copy;
+    copy = xal;
+    if (copy.get(N - 1).uint32() != N - 1 || !(copy == xal)) {
+	verbose_log("get() on a copy failed.\n");
+	return 1;
+    }
+
+    // A list parsed from text must start get() from the head.
+    string text;
+    for (uint32_t i = 0; i < 10; i++) {
+	if (i != 0)
+	    text += XrlToken::LIST_SEP;
+	text += XrlAtom(i).str();
+    }
+    XrlAtomList parsed(text);
+    for (uint32_t i = 0; i < 10; i++) {
+	if (parsed.get(i).uint32() != i) {
+	    verbose_log("get(%u) on a parsed list failed.\n",
+			XORP_UINT_CAST(i));
+	    return 1;
+	}
+    }
+
+    XrlArgs al;
+    al.add(XrlAtom("a_list", xal));
+    return test_serialize_one(al);
+}
+
 static int
 run_test()
 {
@@ -341,6 +404,9 @@ main(int argc, char * const argv[])
 	if (ret_value == 0) {
 	    ret_value = run_serialization_test();
 	}
+	if (ret_value == 0) {
+	    ret_value = run_list_test();
+	}
     }
     catch (...) {
 	xorp_catch_standard_exceptions();
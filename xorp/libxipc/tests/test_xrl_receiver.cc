@@ -40,6 +40,7 @@
 #endif
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/test_xrls_base.hh"
 #include "test_receiver.hh"
 
@@ -30,10 +30,66 @@
 #include "xrl_args.hh"
 #include "finder_server.hh"
 
+#include "xrl/interfaces/common_xif.hh"
+
 #ifndef UNUSED
 #define UNUSED(x) (x) = (x)
 #endif
 
+// ----------------------------------------------------------------------------
+// Allocation counting, for the send path benchmark
+
+static size_t s_allocs = 0;
+
+// The allocations are offset by a header, so that they are only ever
+// freed by the operator delete below.
+union AllocHeader {
+    long double align;
+};
+
+static void*
+counted_alloc(size_t size)
+{
+    s_allocs++;
+    AllocHeader* a =
+	static_cast<AllocHeader*>(malloc(sizeof(AllocHeader) + size));
+    if (a == NULL)
+	throw std::bad_alloc();
+    return a + 1;
+}
+
+static void
+counted_free(void* p)
+{
+    if (p == NULL)
+	return;
+    free(static_cast<AllocHeader*>(p) - 1);
+}
+
+void*
+operator new(size_t size) throw (std::bad_alloc)
+{
+    return counted_alloc(size);
+}
+
+void*
+operator new[](size_t size) throw (std::bad_alloc)
+{
+    return counted_alloc(size);
+}
+
+void
+operator delete(void* p) throw ()
+{
+    counted_free(p);
+}
+
+void
+operator delete[](void* p) throw ()
+{
+    counted_free(p);
+}
+
 // ----------------------------------------------------------------------------
 // Xrl request callbacks
 
@@ -44,6 +100,14 @@ hello_world(const XrlArgs& /* request */,
     return XrlCmdError::OKAY();
 }
 
+static const XrlCmdError
+get_target_name(const XrlArgs&	/* request */,
+		XrlArgs*	response)
+{
+    response->add_string("name", "party_A");
+    return XrlCmdError::OKAY();
+}
+
 static const XrlCmdError
 passback_integer(const XrlArgs&	/* request*/,
 		 XrlArgs*	response)
@@ -100,6 +164,57 @@ got_integer(const XrlError&	e,
     *done = true;
 }
 
+static void
+got_target_name(const XrlError&	e,
+		const string*	name,
+		size_t*		replies)
+{
+    if (e != XrlError::OKAY())
+	exit_on_xrlerror(e, __FILE__, __LINE__);
+    if (*name != "party_A") {
+	fprintf(stderr, "Corrupt target name.");
+	exit(-1);
+    }
+    (*replies)++;
+}
+
+/**
+ * Send XRLs through a generated client stub, and report the number of
+ * memory allocations made while sending each of them.
+ */
+static void
+bench_send_path(EventLoop& eventloop, XrlRouter& sender)
+{
+    static const size_t BATCH = 50;
+    static const size_t BATCHES = 200;
+    XrlCommonV0p1Client client(&sender);
+    size_t replies = 0;
+    size_t send_allocs = 0;
+    size_t total_allocs = s_allocs;
+
+    for (size_t b = 0; b < BATCHES; b++) {
+	XrlCommonV0p1Client::GetTargetNameCB cb =
+	    callback(got_target_name, &replies);
+	size_t before = s_allocs;
+	for (size_t i = 0; i < BATCH; i++) {
+	    if (! client.send_get_target_name("party_A", cb)) {
+		fprintf(stderr, "Send failed\n");
+		exit(-1);
+	    }
+	}
+	send_allocs += s_allocs - before;
+	while (replies < (b + 1) * BATCH)
+	    eventloop.run();
+    }
+    total_allocs = s_allocs - total_allocs;
+
+    printf("%u XRLs: %.2f allocations per send, "
+	   "%.2f allocations per round trip\n",
+	   XORP_UINT_CAST(BATCH * BATCHES),
+	   (double)send_allocs / (BATCH * BATCHES),
+	   (double)total_allocs / (BATCH * BATCHES));
+}
+
 #include "finder.hh"
 #include "finder_tcp_messenger.hh"
 #include "finder_xrl_target.hh"
@@ -127,6 +242,8 @@ test_main()
     // Add command that party_A knows about
     party_a.add_handler("hello_world", callback(hello_world));
     party_a.add_handler("passback_integer", callback(passback_integer));
+    party_a.add_handler("common/0.1/get_target_name",
+			callback(get_target_name));
 
     party_a.finalize();
     
@@ -168,6 +285,8 @@ test_main()
 	}
     }
 
+    bench_send_path(eventloop, party_b);
+
     if (finder)
 	delete finder;
 
@@ -28,7 +28,24 @@
 #include "xrl_atom_list.hh"
 #include "xrl_tokens.hh"
 
-XrlAtomList::XrlAtomList() : _size(0) {}
+XrlAtomList::XrlAtomList() : _size(0), _cached_idx(0), _cache_valid(false) {}
+
+XrlAtomList::XrlAtomList(const XrlAtomList& other)
+    : _list(other._list), _size(other._size), _cached_idx(0),
+      _cache_valid(false)
+{
+}
+
+XrlAtomList&
+XrlAtomList::operator=(const XrlAtomList& other)
+{
+    if (this != &other) {
+	_list = other._list;
+	_size = other._size;
+	_cache_valid = false;
+    }
+    return *this;
+}
 
 void
 XrlAtomList::prepend(const XrlAtom& xa) throw (BadAtomType)
@@ -41,6 +58,7 @@ XrlAtomList::prepend(const XrlAtom& xa) throw (BadAtomType)
     }
     _list.push_front(xa);
     _size++;
+    _cache_valid = false;
 }
 
 void
@@ -64,6 +82,7 @@ XrlAtomList::check_type(const XrlAtom& xa) throw (BadAtomType)
 void
 XrlAtomList::do_append(const XrlAtom& xa)
 {
+    // Appending leaves the cached iterator of get() valid.
     _list.push_back(xa);
     _size++;
 }
@@ -71,19 +90,29 @@ XrlAtomList::do_append(const XrlAtom& xa)
 const XrlAtom&
 XrlAtomList::get(size_t itemno) const throw (InvalidIndex)
 {
-    list<XrlAtom>::const_iterator ci = _list.begin();
-    size_t size = _size;
-
-    if (ci == _list.end() || size == 0) {
+    if (_list.empty() || _size == 0) {
 	xorp_throw(InvalidIndex, "Index out of range: empty list.");
     }
-    while (itemno != 0) {
+    if (itemno >= _size) {
+	xorp_throw(InvalidIndex, "Index out of range.");
+    }
+
+    // Start from the last atom found if it is not beyond this one.
+    list<XrlAtom>::const_iterator ci = _list.begin();
+    size_t idx = 0;
+    if (_cache_valid && _cached_idx <= itemno) {
+	ci = _cached;
+	idx = _cached_idx;
+    }
+    while (idx != itemno) {
 	++ci;
-	if (ci == _list.end() || size-- == 0) {
-	    xorp_throw(InvalidIndex, "Index out of range.");
-	}
-	itemno--;
+	idx++;
     }
+
+    _cached = ci;
+    _cached_idx = idx;
+    _cache_valid = true;
+
     return *ci;
 }
 
@@ -105,6 +134,7 @@ XrlAtomList::remove(size_t itemno) throw (InvalidIndex)
     }
     _list.erase(i);
     _size--;
+    _cache_valid = false;
 }
 
 size_t XrlAtomList::size() const
@@ -156,7 +186,8 @@ XrlAtomList::str() const
     return r;
 }
 
-XrlAtomList::XrlAtomList(const string& s) : _size(0)
+XrlAtomList::XrlAtomList(const string& s)
+    : _size(0), _cached_idx(0), _cache_valid(false)
 {
     const char *start, *sep;
     start = s.c_str();
@@ -186,8 +217,8 @@ XrlAtomList::modify(size_t idx, const uint8_t* buf, size_t len)
 	_size++;
     }
 
-    const XrlAtom& a = get(idx);
-    XrlAtom& atom = const_cast<XrlAtom&>(a); 
+    // Unpacking appends, so don't walk the list to find the new atom.
+    XrlAtom& atom = added ? _list.back() : const_cast<XrlAtom&>(get(idx));
 
     size_t rc = atom.unpack(buf, len);
 
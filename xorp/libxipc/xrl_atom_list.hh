@@ -52,6 +52,8 @@ public:
 
 public:
     XrlAtomList();
+    XrlAtomList(const XrlAtomList& other);
+    XrlAtomList& operator=(const XrlAtomList& other);
 
     /**
      * Insert an XrlAtom at the front of the list.
@@ -114,6 +116,12 @@ private:
 
     list<XrlAtom> _list;
     size_t	  _size;
+
+    // The atom found by the last get(), so that walking the list in
+    // order with get() is linear rather than quadratic.
+    mutable list<XrlAtom>::const_iterator _cached;
+    mutable size_t	  _cached_idx;
+    mutable bool	  _cache_valid;
 };
 
 #endif // __LIBXIPC_XRL_ATOM_LIST_HH__
@@ -0,0 +1,49 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+// 
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+// 
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __LIBXIPC_XRL_DISPATCH_STATS_HH__
+#define __LIBXIPC_XRL_DISPATCH_STATS_HH__
+
+#include "xrl_error.hh"
+
+//
+// The handlers of the common/0.1/set_dispatch_stats and
+// common/0.1/get_dispatch_stats XRLs, which every target implements
+// the same way: a target just calls them.
+//
+
+/**
+ * Enable or disable the dispatch statistics of the process.
+ *
+ * @param enable true to enable the statistics.
+ * @return XrlCmdError::OKAY().
+ */
+XrlCmdError xrl_set_dispatch_stats(bool enable);
+
+/**
+ * Get the dispatch statistics of the process.
+ *
+ * @param stats is set to the statistics, as text.
+ * @return XrlCmdError::OKAY().
+ */
+XrlCmdError xrl_get_dispatch_stats(string& stats);
+
+#endif // __LIBXIPC_XRL_DISPATCH_STATS_HH__
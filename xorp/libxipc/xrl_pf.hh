@@ -78,7 +78,7 @@ class XrlPFSender
 {
 public:
     typedef
-    XorpCallback2<void, const XrlError&, XrlArgs*>::RefPtr SendCallback;
+    XorpSmallCallback2<void, const XrlError&, XrlArgs*> SendCallback;
 
 public:
     XrlPFSender(const string& name, EventLoop& e, const char* address);
@@ -383,15 +383,6 @@ XrlRouter::add_handler_internal(const string& cmd,
     return XrlCmdMap::add_handler_internal(cmd, rcb);
 }
 
-void
-XrlRouter::send_callback(const XrlError& e,
-			 XrlArgs*	 reply,
-			 XrlPFSender* /* s */, // Don't use, should be a ref-ptr if it is ever used.
-			 XrlCallback	 user_callback)
-{
-    user_callback->dispatch(e, reply);
-}
-
 bool
 XrlRouter::send_resolved(const Xrl&		xrl,
 			 const FinderDBEntry*	dbe,
@@ -412,12 +403,9 @@ XrlRouter::send_resolved(const Xrl&		xrl,
     	x.set_args(xrl);
 
 	trace_xrl("Sending ", x);
-	// NOTE:  using s.get below breaks ref counting, but can't figure out WTF the
-	// callback template magic is to make it work with a ref-ptr.  Either way, it appears
-	// the ptr may not be used anyway (it's not in send_callback, for instance)
-	return s->send(x, direct_call,
-		       callback(this, &XrlRouter::send_callback,
-				s.get(), cb));
+	// The user callback is handed to the sender as is: it is a small
+	// callback, so copying it does not allocate.
+	return s->send(x, direct_call, cb);
 
 	cb->dispatch(XrlError(SEND_FAILED, "sender not instantiated"), 0);
     } catch (const InvalidString&) {
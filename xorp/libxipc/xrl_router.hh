@@ -190,15 +190,6 @@ protected:
 			  const FinderDBEntry*	  dbe,
 			  XrlRouterDispatchState* ds);
 
-    /**
-     * Send callback (fast path).
-     * FIXME: use smart ptr.
-     */
-    void send_callback(const XrlError&	e,
-		       XrlArgs*		reply,
-		       XrlPFSender*	sender, // un-used, should be ref-ptr if we ever actually use this.
-		       XrlCallback	user_callback);
-
     /**
      * Choose appropriate XrlPFSender and execute Xrl dispatch.
      *
@@ -36,7 +36,7 @@ class XrlSender {
 public:
     virtual ~XrlSender() {}
 
-    typedef XorpCallback2<void, const XrlError&, XrlArgs*>::RefPtr Callback;
+    typedef XorpSmallCallback2<void, const XrlError&, XrlArgs*> Callback;
 
     /**
      * @param xrl Xrl to be sent.
@@ -28,6 +28,7 @@
 #include "libxorp/xlog.h"
 #include "libxorp/eventloop.hh"
 
+#include <limits.h>
 #include <signal.h>
 
 #ifdef HAVE_SYS_UIO_H
@@ -394,22 +395,43 @@ string AsyncFileReader::toString() const {
 // AsyncFileWriter write method and entry hook
 
 #ifndef MAX_IOVEC
+#ifdef IOV_MAX
+#define MAX_IOVEC IOV_MAX
+#else
 #define MAX_IOVEC 16
 #endif
+#endif
+
+const size_t AsyncFileWriter::DEFAULT_COALESCE_BYTES;
 
 AsyncFileWriter::AsyncFileWriter(EventLoop& e, XorpFd fd, uint32_t coalesce,
 				 int priority)
-    : AsyncFileOperator(e, fd, priority)
+    : AsyncFileOperator(e, fd, priority),
+      _coalesce(0),
+      _coalesce_bytes(0),
+      _iov(NULL)
 {
-    static const uint32_t max_coalesce = 16;
-    _coalesce = (coalesce > MAX_IOVEC) ? MAX_IOVEC : coalesce;
-    if (_coalesce > max_coalesce) {
-	_coalesce = max_coalesce;
-    }
-    _iov = new iovec[_coalesce];
+    memset(&_stats, 0, sizeof(_stats));
+    set_coalesce(coalesce, DEFAULT_COALESCE_BYTES);
     _dtoken = new int;
 }
 
+void
+AsyncFileWriter::set_coalesce(uint32_t max_buffers, size_t max_bytes)
+{
+    if (max_buffers > MAX_IOVEC)
+	max_buffers = MAX_IOVEC;
+    if (max_buffers == 0)
+	max_buffers = 1;
+
+    if (max_buffers != _coalesce) {
+	delete[] _iov;
+	_iov = new iovec[max_buffers];
+	_coalesce = max_buffers;
+    }
+    _coalesce_bytes = max_bytes;
+}
+
 AsyncFileWriter::~AsyncFileWriter()
 {
     stop();
@@ -524,7 +546,8 @@ AsyncFileWriter::add_data_sendto(const vector<uint8_t>&	data,
 
 string AsyncFileWriter::toString() const {
     ostringstream oss;
-    oss << AsyncFileOperator::toString() << " buffers: " << _buffers.size() << endl;
+    oss << AsyncFileOperator::toString() << " buffers: " << _buffers.size()
+	<< " writes: " << _stats.writes << " bytes: " << _stats.bytes << endl;
     return oss.str();
 }
 
@@ -587,7 +610,7 @@ AsyncFileWriter::write(XorpFd fd, IoEventType type)
     errno = 0;
 
     //
-    // Group together a number of buffers.
+    // Group together a number of buffers, up to the coalescing limits.
     // If the buffer is sendto()-type, then send that buffer on its own.
     //
     list<BufferInfo *>::const_iterator i = _buffers.begin();
@@ -612,7 +635,7 @@ AsyncFileWriter::write(XorpFd fd, IoEventType type)
 	    dst_port = bi->dst_port();
 	    break;
 	}
-	if (iov_cnt == _coalesce)
+	if ((iov_cnt == _coalesce) || (total_bytes >= _coalesce_bytes))
 	    break;
 	++i;
     }
@@ -710,6 +733,17 @@ AsyncFileWriter::write(XorpFd fd, IoEventType type)
 			  _iov[0].iov_len, flags);
 	    if (done < 0)
 		_last_error = errno;
+	} else if (! mod_signals) {
+	    //
+	    // Use sendmsg(2) rather than writev(2) for the same reason.
+	    //
+	    struct msghdr mh;
+	    memset(&mh, 0, sizeof(mh));
+	    mh.msg_iov = _iov;
+	    mh.msg_iovlen = iov_cnt;
+	    done = ::sendmsg(_fd, &mh, flags);
+	    if (done < 0)
+		_last_error = errno;
 	} else {
 	    done = ::writev(_fd, _iov, (int)iov_cnt);
 	    if (done < 0)
@@ -719,6 +753,10 @@ AsyncFileWriter::write(XorpFd fd, IoEventType type)
 #endif // ! HOST_OS_WINDOWS
     }
 
+    _stats.writes++;
+    if (done > 0)
+	_stats.bytes += done;
+
     if (aio_trace.on()) {
 	XLOG_INFO("afw: %p Wrote %d of %u bytes, last-err: %i\n",
 		  this, XORP_INT_CAST(done), XORP_UINT_CAST(total_bytes),
@@ -802,6 +840,7 @@ AsyncFileWriter::complete_transfer(ssize_t sdone)
 
 	    assert(stack_token.is_only() == false);
 
+	    _stats.buffers++;
 	    head->dispatch_callback(DATA);
 	    delete head;
 	    if (stack_token.is_only() == true) {
@@ -259,6 +259,20 @@ class AsyncFileWriter :
     public AsyncFileOperator
 {
 public:
+    /**
+     * Writer statistics.
+     */
+    struct Stats {
+	uint64_t	writes;		// the number of write system calls
+	uint64_t	bytes;		// the number of bytes written
+	uint64_t	buffers;	// the number of buffers written
+    };
+
+    /**
+     * The default limit on the bytes coalesced by each write.
+     */
+    static const size_t DEFAULT_COALESCE_BYTES = 64 * 1024;
+
     /**
      * @param e EventLoop that object should associate itself with.
      * @param fd a file descriptor marked as non-blocking to write to.
@@ -366,6 +380,37 @@ public:
      */
     void flush_buffers();
 
+    /**
+     * Set how many of the queued buffers are coalesced by each write.
+     *
+     * The buffers at the head of the queue are gathered into a single
+     * writev() or sendmsg() system call until either limit is reached.
+     * The callback of each buffer is still invoked once the buffer is
+     * written, in the order the buffers were added.
+     *
+     * @param max_buffers the maximum number of buffers per write.  It is
+     * capped to the system's limit on the size of an I/O vector.
+     * @param max_bytes the number of bytes after which no more buffers
+     * are added to a write.  A larger buffer is still written whole.
+     */
+    void set_coalesce(uint32_t max_buffers, size_t max_bytes);
+
+    /**
+     * @return the maximum number of buffers coalesced by each write.
+     */
+    uint32_t coalesce_buffers() const	{ return _coalesce; }
+
+    /**
+     * @return the number of bytes after which buffers are no longer
+     * coalesced.
+     */
+    size_t coalesce_bytes() const	{ return _coalesce_bytes; }
+
+    /**
+     * @return the writer statistics.
+     */
+    const Stats& stats() const		{ return _stats; }
+
     virtual string toString() const;
 
 private:
@@ -425,7 +470,9 @@ protected:
     void complete_transfer(ssize_t done);
 
     uint32_t		_coalesce;
+    size_t		_coalesce_bytes;
     struct iovec* 	_iov;
+    Stats		_stats;
     ref_ptr<int>	_dtoken;
     list<BufferInfo *> 	_buffers;
 
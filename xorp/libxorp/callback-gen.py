@@ -318,6 +318,26 @@ if (! cb.is_empty()) {
  * owns the callback object corresponding the timer callback, there is
  * never an opportunity for the callback to be dispatched on a deleted object
  * or with invalid data.
+ *
+ * @sect Small Callbacks
+ *
+ * callback() allocates each callback object on the heap.  On hot paths,
+ * small_callback() takes the same arguments and returns a
+ * XorpSmallCallbackN, a value type that stores the callback object in
+ * place when it fits in XorpSmallCallbackN::BUFFER_SIZE bytes, and on
+ * the heap otherwise.  A XorpSmallCallbackN can be used like a RefPtr
+ * (operator->, is_empty(), release()), and a RefPtr converts to it:
+ *
+<pre>
+    typedef XorpSmallCallback1<int, int> SmallCallback;
+
+    SmallCallback cb1 = small_callback(sum, 5);	// No allocation
+    SmallCallback cb2 = callback(sum, 5);	// Shares the RefPtr's object
+    cout << cb1->dispatch(10) + cb2->dispatch(10) << endl; // 30
+</pre>
+ *
+ * Copying a XorpSmallCallbackN copies the callback object, rather than
+ * sharing it.
  */
 """
 
@@ -341,6 +361,7 @@ if (! cb.is_empty()) {
 #else
 #define callback(...) dbg_callback(__FILE__,__LINE__,__VA_ARGS__)
 #endif
+#define small_callback(...) dbg_small_callback(__FILE__,__LINE__,__VA_ARGS__)
 
 void trace_dispatch_enter(const char* file, int line);
 void trace_dispatch_leave();
@@ -374,6 +395,14 @@ def output_kdoc_factory_function(target, nl, nb):
     print " * %swith %d dispatch time arguments and %d bound arguments." % (target, nl, nb)
     print " */"
 
+def output_kdoc_small_factory_function(target, nl, nb):
+    if (target != ''):
+        target = target.strip() + ' '
+    print "/**"
+    print " * Factory function that creates a small callback targetted at a"
+    print " * %swith %d dispatch time arguments and %d bound arguments." % (target, nl, nb)
+    print " */"
+
 def output_base(l_types, dbg):
     n = len(l_types)
 
@@ -384,13 +413,18 @@ def output_base(l_types, dbg):
     print
     output_kdoc_base_class(n)
     print "template<class R%s>" % joining_csv(class_args(l_types))
-    print "struct XorpCallback%d {" % n
-    print "    typedef ref_ptr<XorpCallback%d> RefPtr;\n" % n
+    print "struct XorpCallback%d : public ref_counted {" % n
+    print "    typedef iref_ptr<XorpCallback%d> RefPtr;\n" % n
     if (dbg):
         print "    XorpCallback%d(const char* file, int line)" % n
         print "\t: _file(file), _line(line) {}"
     print "    virtual ~XorpCallback%d() {}" % n
     print "    virtual R dispatch(%s)" % csv(l_types) + " = 0;"
+    print "    /**"
+    print "     * Copy the callback object into the memory at mem, which must be"
+    print "     * large enough for the object, and return the copy."
+    print "     */"
+    print "    virtual XorpCallback%d* clone(void* mem) const = 0;" % n
 
     if (dbg):
         print "    const char* file() const\t\t{ return _file; }"
@@ -400,6 +434,99 @@ def output_base(l_types, dbg):
         print "    int         _line;"
     print "};\n"
 
+    output_small(l_types)
+
+def output_small(l_types):
+    n = len(l_types)
+    base = "XorpCallback%d<R%s>" % (n, joining_csv(l_types))
+    cls = "XorpSmallCallback%d" % n
+
+    print "/**"
+    print " * @short Small buffer optimized callback with %d dispatch time args." % n
+    print " *"
+    print " * Holds a %s.  Callback objects created by" % base
+    print " * small_callback() are stored in place when they fit in BUFFER_SIZE"
+    print " * bytes, otherwise on the heap.  A RefPtr converts to a %s" % cls
+    print " * that shares the RefPtr's callback object."
+    print " */"
+    o  = "template<class R%s>\n" % joining_csv(class_args(l_types))
+    o += "class %s {\n" % cls
+    o += "public:\n"
+    o += "    typedef %s Callback;\n" % base
+    o += "    typedef typename Callback::RefPtr RefPtr;\n"
+    o += "    enum { BUFFER_SIZE = 64 };\n"
+    o += "\n"
+    o += "    %s() : _cb(0) {}\n" % cls
+    o += "    %s(const RefPtr& rp) : _cb(rp.get()), _rp(rp) {}\n" % cls
+    o += "    %s(const %s& o) : _cb(0) { assign(o); }\n" % (cls, cls)
+    o += "    ~%s() { release(); }\n" % cls
+    o += "\n"
+    o += "    %s& operator=(const %s& o) {\n" % (cls, cls)
+    o += "\tif (this != &o) {\n"
+    o += "\t    release();\n"
+    o += "\t    assign(o);\n"
+    o += "\t}\n"
+    o += "\treturn *this;\n"
+    o += "    }\n"
+    o += "\n"
+    o += "    Callback* operator->() const\t{ return _cb; }\n"
+    o += "    Callback& operator*() const\t\t{ return *_cb; }\n"
+    o += "    Callback* get() const\t\t{ return _cb; }\n"
+    o += "    bool is_empty() const\t\t{ return _cb == 0; }\n"
+    o += "\n"
+    o += "    void release() {\n"
+    o += "\tif (is_inline())\n"
+    o += "\t    _cb->~Callback();\n"
+    o += "\t_cb = 0;\n"
+    o += "\t_rp.release();\n"
+    o += "    }\n"
+    o += "\n"
+    o += "    /**\n"
+    o += "     * Get the memory to construct a callback object in.\n"
+    o += "     *\n"
+    o += "     * @param size the size of the object.\n"
+    o += "     * @return the in-place buffer, or 0 if the object does not fit.\n"
+    o += "     */\n"
+    o += "    void* storage(size_t size) {\n"
+    o += "\treturn (size <= sizeof(_buf)) ? &_buf : 0;\n"
+    o += "    }\n"
+    o += "\n"
+    o += "    /**\n"
+    o += "     * Take ownership of a callback object, either constructed in the\n"
+    o += "     * memory returned by storage(), or allocated with new.  The\n"
+    o += "     * small callback must be empty.\n"
+    o += "     */\n"
+    o += "    void attach(Callback* cb) {\n"
+    o += "\tchar* p = reinterpret_cast<char*>(cb);\n"
+    o += "\tchar* b = reinterpret_cast<char*>(&_buf);\n"
+    o += "\tif (p < b || p >= b + sizeof(_buf))\n"
+    o += "\t    _rp = RefPtr(cb);\n"
+    o += "\t_cb = cb;\n"
+    o += "    }\n"
+    o += "\n"
+    o += "private:\n"
+    o += "    bool is_inline() const { return _cb != 0 && _rp.is_empty(); }\n"
+    o += "\n"
+    o += "    void assign(const %s& o) {\n" % cls
+    o += "\tif (o.is_inline()) {\n"
+    o += "\t    _cb = o._cb->clone(&_buf);\n"
+    o += "\t} else {\n"
+    o += "\t    _cb = o._cb;\n"
+    o += "\t    _rp = o._rp;\n"
+    o += "\t}\n"
+    o += "    }\n"
+    o += "\n"
+    o += "    union {\n"
+    o += "\tchar\t_bytes[BUFFER_SIZE];\n"
+    o += "\tvoid*\t_align_ptr;\n"
+    o += "\tdouble\t_align_double;\n"
+    o += "\tint64_t\t_align_int64;\n"
+    o += "    } _buf;\n"
+    o += "    Callback*\t_cb;\n"
+    o += "    RefPtr\t_rp;\t// Holds the callback object when not in place\n"
+    o += "};\n"
+    print o
+
 def output_rest(l_types, b_types, dbg):
     nl = len(l_types)
     nb = len(b_types)
@@ -409,8 +536,10 @@ def output_rest(l_types, b_types, dbg):
     if (dbg):
         debug_args = (("const char*", "file"),
                                  ("int", "line"))
+        safe_clone_debug_args = ["this->file()", "this->line()"]
     else:
         debug_args = (())
+        safe_clone_debug_args = []
 
     output_kdoc_class("functions", nl, nb)
 
@@ -434,6 +563,9 @@ def output_rest(l_types, b_types, dbg):
         o += "\trecord_dispatch_leave();\n"
     o += "\treturn r;\n"
     o += "    }\n"
+    o += "    %s* clone(void* mem) const {\n" % base_class
+    o += "\treturn new (mem) XorpFunctionCallback%dB%d(*this);\n" % (nl, nb)
+    o += "    }\n"
     o += "protected:\n    F   _f;\n"
     for ba in mem_decls(b_types):
         o += "    %s;\n" % ba
@@ -463,6 +595,9 @@ def output_rest(l_types, b_types, dbg):
     if (dbg):
         o += "\trecord_dispatch_leave();\n"
     o += "    }\n"
+    o += "    %s* clone(void* mem) const {\n" % void_base_class
+    o += "\treturn new (mem) XorpFunctionCallback%dB%d(*this);\n" % (nl, nb)
+    o += "    }\n"
     o += "protected:\n    F   _f;\n"
     for ba in mem_decls(b_types):
         o += "    %s;\n" % ba
@@ -486,6 +621,25 @@ def output_rest(l_types, b_types, dbg):
     print o
     print
 
+    output_kdoc_small_factory_function("function", nl, nb)
+    o  = "template <class R%s>\n" % joining_csv(class_args(l_types + b_types))
+    o += "XorpSmallCallback%d<R%s>\n" % (nl, joining_csv(l_types))
+    if (dbg):
+        o += "dbg_"
+    o += "small_callback("
+    o += starting_csv(flatten_pair_list(debug_args))
+    o += "R (*f)(%s)%s) {\n" % (csv(l_types + b_types), joining_csv(decl_args(b_types)))
+    o += "    typedef XorpFunctionCallback%dB%d<R%s> T;\n" \
+          % (nl, nb, joining_csv(l_types + b_types))
+    o += "    XorpSmallCallback%d<R%s> cb;\n" % (nl, joining_csv(l_types))
+    o += "    void* mem = cb.storage(sizeof(T));\n"
+    cargs = starting_csv(second_args(debug_args)) + "f" + joining_csv(call_args(b_types))
+    o += "    cb.attach(mem ? new (mem) T(%s) : new T(%s));\n" % (cargs, cargs)
+    o += "    return cb;\n"
+    o += "}"
+    print o
+    print
+
     for CONST,const in [('',''), ('Const', ' const')]:
         output_kdoc_class("%s member methods" % const, nl, nb)
         o = ""
@@ -506,6 +660,9 @@ def output_rest(l_types, b_types, dbg):
             o += "\trecord_dispatch_leave();\n"
         o += "\treturn r;\n"
         o += "    }\n"
+        o += "    %s* clone(void* mem) const {\n" % base_class
+        o += "\treturn new (mem) Xorp%sMemberCallback%dB%d(*this);\n" % (CONST, nl, nb)
+        o += "    }\n"
         o += "protected:\n"
         o += "    O*	_o;	// Callback's target object\n"
         o += "    M	_m;	// Callback's target method\n"
@@ -533,6 +690,9 @@ def output_rest(l_types, b_types, dbg):
         if (dbg):
             o += "\trecord_dispatch_leave();\n"
         o += "    }\n"
+        o += "    %s* clone(void* mem) const {\n" % void_base_class
+        o += "\treturn new (mem) Xorp%sMemberCallback%dB%d(*this);\n" % (CONST, nl, nb)
+        o += "    }\n"
         o += "protected:\n"
         o += "    O*	_o;	// Callback's target object\n"
         o += "    M	_m;	// Callback's target method\n"
@@ -567,6 +727,11 @@ def output_rest(l_types, b_types, dbg):
         o += "\t    return r;\n"
         o += "\t}\n"
         o += "    }\n"
+        o += "    %s* clone(void* mem) const {\n" % base_class
+        o += "\treturn new (mem) Xorp%sSafeMemberCallback%dB%d(" % (CONST, nl, nb)
+        o += starting_csv(safe_clone_debug_args)
+        o += "this->_o, this->_m%s);\n" % joining_csv(map(lambda x: "this->" + x, mem_args(b_types)))
+        o += "    }\n"
         o += "};\n"
         print o
 
@@ -595,6 +760,11 @@ def output_rest(l_types, b_types, dbg):
             o += "\t    record_dispatch_leave();\n"
         o += "\t}\n"
         o += "    }\n"
+        o += "    %s* clone(void* mem) const {\n" % void_base_class
+        o += "\treturn new (mem) Xorp%sSafeMemberCallback%dB%d(" % (CONST, nl, nb)
+        o += starting_csv(safe_clone_debug_args)
+        o += "this->_o, this->_m%s);\n" % joining_csv(map(lambda x: "this->" + x, mem_args(b_types)))
+        o += "    }\n"
         o += "};\n"
         print o
 
@@ -603,6 +773,8 @@ def output_rest(l_types, b_types, dbg):
              % (joining_csv(class_args(l_types) + class_args(b_types)))
         o += "struct Xorp%sMemberCallbackFactory%dB%d\n" % (CONST, nl, nb)
         o += "{\n"
+        o += "    typedef Xorp%sSafeMemberCallback%dB%d<R, O%s> Type;\n" \
+             % (CONST, nl, nb, joining_csv(l_types + b_types))
         o += "    static Xorp%sMemberCallback%dB%d<R, O%s>*\n" \
              % (CONST, nl, nb, joining_csv(l_types + b_types))
         o += "    make(%s" % starting_csv(flatten_pair_list(debug_args))
@@ -621,6 +793,8 @@ def output_rest(l_types, b_types, dbg):
         o += "struct Xorp%sMemberCallbackFactory%dB%d<R, O%s, false>\n" \
              % (CONST, nl, nb, joining_csv(l_types + b_types))
         o += "{\n"
+        o += "    typedef Xorp%sMemberCallback%dB%d<R, O%s> Type;\n" \
+             % (CONST, nl, nb, joining_csv(l_types + b_types))
         o += "    static Xorp%sMemberCallback%dB%d<R, O%s>*\n" \
              % (CONST, nl, nb, joining_csv(l_types + b_types))
         o += "    make(%s" % starting_csv(flatten_pair_list(debug_args))
@@ -654,6 +828,29 @@ def output_rest(l_types, b_types, dbg):
             o += "%so, p%s);\n" % (q, joining_csv(call_args(b_types)))
             o += "}\n"
             print o
+
+        for p,q in [('*', ''), ('&', '&')]:
+            output_kdoc_small_factory_function("%s member function" % const, nl, nb)
+
+            o  = "template <class R, class O%s>\n" \
+                      % joining_csv(class_args(l_types) + class_args(b_types))
+            o += "XorpSmallCallback%s<R%s>\n"  %  (nl, joining_csv(l_types))
+            if (dbg):
+                o += "dbg_"
+            o += "small_callback("
+            o += starting_csv(flatten_pair_list(debug_args))
+            o += "%s O%s o, R (O::*p)(%s)%s%s)\n" \
+                 % (const, p, csv(l_types + b_types), const, joining_csv(decl_args(b_types)))
+            o += "{\n"
+            o += "    typedef typename Xorp%sMemberCallbackFactory%dB%d<" % (CONST, nl, nb)
+            o += "R, %s O%s, BaseAndDerived<CallbackSafeObject, O>::True>::Type T;\n" % (const, joining_csv(l_types + b_types))
+            o += "    XorpSmallCallback%d<R%s> cb;\n" % (nl, joining_csv(l_types))
+            o += "    void* mem = cb.storage(sizeof(T));\n"
+            cargs = starting_csv(second_args(debug_args)) + "%so, p%s" % (q, joining_csv(call_args(b_types)))
+            o += "    cb.attach(mem ? new (mem) T(%s) : new T(%s));\n" % (cargs, cargs)
+            o += "    return cb;\n"
+            o += "}\n"
+            print o
         print ''
 
 def cb_gen(max_bound, max_late, dbg):
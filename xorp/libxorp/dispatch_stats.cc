@@ -0,0 +1,263 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+// 
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+// 
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+#include "xorp.h"
+
+#include "libxorp/c_format.hh"
+#include "libxorp/histogram.hh"
+
+#include "dispatch_stats.hh"
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+// Implementation Notes:
+//
+// The per-site statistics are kept in a map keyed by the site, which
+// is only looked up when the statistics are enabled.  The slowest
+// dispatches are kept in a small array: a dispatch replaces the
+// fastest of them when it is slower.
+//
+// Times are read from the monotonic clock directly rather than from
+// the TimerList, whose time is only advanced once per EventLoop::run().
+
+bool DispatchStats::_enabled = false;
+const size_t DispatchStats::SLOWEST;
+
+namespace {
+
+struct SiteStats {
+    DispatchStats::Kind	kind;
+    Log2Histogram	runtime;
+    Log2Histogram	lateness;
+};
+
+struct SlowDispatch {
+    DispatchStats::Kind	kind;
+    DispatchStats::Site	site;
+    uint64_t		when;
+    uint64_t		runtime;
+    uint64_t		lateness;
+};
+
+typedef map<DispatchStats::Site, SiteStats> SiteMap;
+
+SiteMap		s_sites;
+Log2Histogram	s_runtime[DispatchStats::KINDS];
+Log2Histogram	s_lateness;
+SlowDispatch	s_slowest[DispatchStats::SLOWEST];
+size_t		s_slowest_count = 0;
+uint64_t	s_since = 0;
+
+const char* const s_kind_names[DispatchStats::KINDS] = {
+    "io", "task", "timer"
+};
+
+string
+site_name(const DispatchStats::Site& site)
+{
+    string name = site.type->name();
+
+#ifdef __GNUC__
+    int status;
+    char* demangled = abi::__cxa_demangle(name.c_str(), 0, 0, &status);
+    if (demangled != NULL) {
+	name = demangled;
+	free(demangled);
+    }
+#endif
+
+    if (site.file != NULL)
+	name = c_format("%s:%d %s", site.file, site.line, name.c_str());
+
+    return name;
+}
+
+inline double
+us(uint64_t ns)
+{
+    return ns / 1000.0;
+}
+
+inline double
+ms(uint64_t ns)
+{
+    return ns / 1000000.0;
+}
+
+bool
+by_total_runtime(const SiteMap::const_iterator& a,
+		 const SiteMap::const_iterator& b)
+{
+    return a->second.runtime.sum() > b->second.runtime.sum();
+}
+
+bool
+by_runtime(const SlowDispatch& a, const SlowDispatch& b)
+{
+    return a.runtime > b.runtime;
+}
+
+} // anonymous namespace
+
+bool
+DispatchStats::Site::operator<(const Site& other) const
+{
+    if (type != other.type)
+	return type->before(*other.type);
+    if (file != other.file)
+	return file < other.file;
+    return line < other.line;
+}
+
+void
+DispatchStats::set_enabled(bool enabled)
+{
+    if (enabled && !_enabled)
+	clear();
+    _enabled = enabled;
+}
+
+void
+DispatchStats::clear()
+{
+    s_sites.clear();
+    for (size_t i = 0; i < KINDS; i++)
+	s_runtime[i].clear();
+    s_lateness.clear();
+    s_slowest_count = 0;
+    s_since = now();
+}
+
+uint64_t
+DispatchStats::now()
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(HAVE_CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (::clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+	return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+    struct timeval tv;
+
+    ::gettimeofday(&tv, NULL);
+    return uint64_t(tv.tv_sec) * 1000000000 + uint64_t(tv.tv_usec) * 1000;
+}
+
+void
+DispatchStats::record(Kind kind, const Site& site, uint64_t start,
+		      uint64_t lateness)
+{
+    uint64_t end = now();
+    uint64_t runtime = end - start;
+
+    SiteStats& ss = s_sites[site];
+    ss.kind = kind;
+    ss.runtime.add(runtime);
+    s_runtime[kind].add(runtime);
+    if (kind == TIMER) {
+	ss.lateness.add(lateness);
+	s_lateness.add(lateness);
+    }
+
+    SlowDispatch* slot;
+    if (s_slowest_count < SLOWEST) {
+	slot = &s_slowest[s_slowest_count++];
+    } else {
+	slot = &s_slowest[0];
+	for (size_t i = 1; i < SLOWEST; i++) {
+	    if (s_slowest[i].runtime < slot->runtime)
+		slot = &s_slowest[i];
+	}
+	if (slot->runtime >= runtime)
+	    return;
+    }
+    slot->kind = kind;
+    slot->site = site;
+    slot->when = end;
+    slot->runtime = runtime;
+    slot->lateness = lateness;
+}
+
+string
+DispatchStats::str()
+{
+    uint64_t t = now();
+    string s;
+
+    if (!_enabled && s_since == 0)
+	return "Dispatch statistics are disabled\n";
+
+    s += c_format("Dispatch statistics %s, collected over %.3f s\n",
+		  _enabled ? "enabled" : "disabled", ms(t - s_since) / 1000);
+
+    s += "\nKind   Count        Total ms   Mean us    p99 us     Max us\n";
+    for (size_t i = 0; i < KINDS; i++) {
+	const Log2Histogram& h = s_runtime[i];
+	s += c_format("%-6s %-12llu %-10.3f %-10.1f %-10.1f %.1f\n",
+		      s_kind_names[i], (unsigned long long)h.count(),
+		      ms(h.sum()), us(h.mean()), us(h.percentile(0.99)),
+		      us(h.max_value()));
+    }
+    s += c_format("Timer lateness: mean %.1f us, p99 %.1f us, max %.1f us\n",
+		  us(s_lateness.mean()), us(s_lateness.percentile(0.99)),
+		  us(s_lateness.max_value()));
+
+    vector<SlowDispatch> slowest(s_slowest, s_slowest + s_slowest_count);
+    sort(slowest.begin(), slowest.end(), by_runtime);
+    s += "\nSlowest dispatches:\n";
+    s += "Kind   Run us     Late us    Ago s      Site\n";
+    for (size_t i = 0; i < slowest.size(); i++) {
+	const SlowDispatch& sd = slowest[i];
+	s += c_format("%-6s %-10.1f %-10.1f %-10.3f %s\n",
+		      s_kind_names[sd.kind], us(sd.runtime),
+		      us(sd.lateness), ms(t - sd.when) / 1000,
+		      site_name(sd.site).c_str());
+    }
+
+    vector<SiteMap::const_iterator> sites;
+    for (SiteMap::const_iterator i = s_sites.begin(); i != s_sites.end(); ++i)
+	sites.push_back(i);
+    sort(sites.begin(), sites.end(), by_total_runtime);
+    s += "\nSites by total run time:\n";
+    s += "Kind   Count        Total ms   Mean us    p99 us     Max us     "
+	"p99 late us Site\n";
+    for (size_t i = 0; i < sites.size(); i++) {
+	const SiteStats& ss = sites[i]->second;
+	s += c_format("%-6s %-12llu %-10.3f %-10.1f %-10.1f %-10.1f ",
+		      s_kind_names[ss.kind],
+		      (unsigned long long)ss.runtime.count(),
+		      ms(ss.runtime.sum()), us(ss.runtime.mean()),
+		      us(ss.runtime.percentile(0.99)),
+		      us(ss.runtime.max_value()));
+	if (ss.kind == TIMER)
+	    s += c_format("%-11.1f ", us(ss.lateness.percentile(0.99)));
+	else
+	    s += c_format("%-11s ", "-");
+	s += site_name(sites[i]->first) + "\n";
+    }
+
+    return s;
+}
@@ -0,0 +1,173 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+// 
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+// 
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __LIBXORP_DISPATCH_STATS_HH__
+#define __LIBXORP_DISPATCH_STATS_HH__
+
+#include <typeinfo>
+
+#include "xorp.h"
+
+/**
+ * @short Event loop dispatch statistics.
+ *
+ * When enabled, the EventLoop measures how long each I/O event, task
+ * and timer callback runs, and how late each timer fires.  The samples
+ * are accounted per callback site, in histograms, and the slowest
+ * dispatches are kept along with their site.
+ *
+ * A callback site is the type of the callback object, which names the
+ * class and signature of the method called back.  If callbacks are
+ * built with DEBUG_CALLBACKS, the file and line the callback was
+ * created at are part of the site too.
+ *
+ * The statistics are disabled by default, and then only cost a test of
+ * a flag per dispatch.  They are process-wide, as there is only one
+ * EventLoop per process.
+ */
+class DispatchStats {
+public:
+    enum Kind {
+	IO_EVENT = 0,
+	TASK,
+	TIMER,
+	KINDS
+    };
+
+    /**
+     * Where a callback comes from.
+     */
+    struct Site {
+	const std::type_info*	type;
+	const char*		file;
+	int			line;
+
+	bool operator<(const Site& other) const;
+    };
+
+    /**
+     * The number of slowest dispatches kept.
+     */
+    static const size_t SLOWEST = 16;
+
+    /**
+     * @return true if the statistics are enabled.
+     */
+    static bool enabled()		{ return _enabled; }
+
+    /**
+     * Enable or disable the statistics.  Enabling them clears the
+     * statistics collected so far.
+     */
+    static void set_enabled(bool enabled);
+
+    /**
+     * Clear the statistics.
+     */
+    static void clear();
+
+    /**
+     * @return the current monotonic time in nanoseconds.
+     */
+    static uint64_t now();
+
+    /**
+     * Get the site of a callback.
+     *
+     * @param cb the callback object.
+     */
+    template <class C>
+    static Site site(const C* cb) {
+	Site s;
+	s.type = &typeid(*cb);
+#ifdef DEBUG_CALLBACKS
+	s.file = cb->file();
+	s.line = cb->line();
+#else
+	s.file = NULL;
+	s.line = 0;
+#endif
+	return s;
+    }
+
+    /**
+     * Account a dispatch that just finished.
+     *
+     * @param kind the kind of callback.
+     * @param site the site of the callback.
+     * @param start the time the dispatch started, as returned by now().
+     * @param lateness how late a timer fired, in nanoseconds.
+     */
+    static void record(Kind kind, const Site& site, uint64_t start,
+		       uint64_t lateness);
+
+    /**
+     * @return the statistics as text.
+     */
+    static string str();
+
+private:
+    static bool	_enabled;
+};
+
+/**
+ * @short Measure the dispatch of a callback.
+ *
+ * The dispatch is measured from the construction of the probe to its
+ * destruction, if the statistics are enabled when it is constructed.
+ * The site is taken before the dispatch, as the callback may be gone
+ * after it.
+ */
+class DispatchProbe : public NONCOPYABLE {
+public:
+    template <class C>
+    DispatchProbe(DispatchStats::Kind kind, const C* cb)
+	: _start(0), _lateness(0) {
+	if (DispatchStats::enabled()) {
+	    _kind = kind;
+	    _site = DispatchStats::site(cb);
+	    _start = DispatchStats::now();
+	}
+    }
+
+    ~DispatchProbe() {
+	if (_start != 0)
+	    DispatchStats::record(_kind, _site, _start, _lateness);
+    }
+
+    /**
+     * @return true if the dispatch is being measured.
+     */
+    bool active() const			{ return _start != 0; }
+
+    /**
+     * Set how late a timer fired, in nanoseconds.
+     */
+    void set_lateness(uint64_t lateness) { _lateness = lateness; }
+
+private:
+    DispatchStats::Kind	_kind;
+    DispatchStats::Site	_site;
+    uint64_t		_start;
+    uint64_t		_lateness;
+};
+
+#endif // __LIBXORP_DISPATCH_STATS_HH__
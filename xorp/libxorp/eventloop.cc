@@ -41,6 +41,9 @@ char xorp_sig_msg_buffer[64];
 
 EnvTrace eloop_trace("ELOOPTRACE");
 
+// Set to enable the dispatch statistics from the start.
+static EnvTrace dispatch_stats_trace("XORP_DISPATCH_STATS");
+
 //Trap some common signals to allow graceful exit.
 // NOTE:  Cannot do logging here, that logic is not re-entrant.
 // Copy msg into xorp-sig_msg_buffer instead..main program can check
@@ -133,6 +136,9 @@ EventLoop::EventLoop()
 #ifdef SIGPIPE
     signal(SIGPIPE, SIG_IGN);
 #endif
+
+    if (dispatch_stats_trace.on())
+	DispatchStats::set_enabled(true);
 }
 
 EventLoop::~EventLoop()
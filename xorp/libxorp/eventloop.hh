@@ -33,6 +33,7 @@
 #include "task.hh"
 #include "callback.hh"
 #include "ioevents.hh"
+#include "dispatch_stats.hh"
 
 #ifdef USE_WIN_DISPATCHER
 #include "win_dispatcher.hh"
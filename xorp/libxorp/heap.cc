@@ -77,6 +77,9 @@ Heap::resize(int new_size)
 		   _size, new_size);
         return 0;
     }
+    // Grow geometrically, so that filling a large heap stays linear
+    if (new_size < _size + _size / 2)
+	new_size = _size + _size / 2;
     new_size = (new_size + HEAP_INCREMENT ) & ~HEAP_INCREMENT ;
     p = new struct heap_entry[new_size];
     if (p == NULL) {
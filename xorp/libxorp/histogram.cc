@@ -0,0 +1,78 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+// 
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+// 
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+#include "xorp.h"
+
+#include "libxorp/c_format.hh"
+
+#include "histogram.hh"
+
+const size_t Log2Histogram::BUCKETS;
+
+void
+Log2Histogram::clear()
+{
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = _sum = _min = _max = 0;
+}
+
+uint64_t
+Log2Histogram::percentile(double fraction) const
+{
+    uint64_t n = 0;
+    uint64_t target = static_cast<uint64_t>(fraction * _count);
+
+    for (size_t i = 0; i < BUCKETS; i++) {
+	n += _buckets[i];
+	if (n > target || n == _count)
+	    return (i == 0) ? 0 : min(_max, (uint64_t(1) << i) - 1);
+    }
+    return _max;
+}
+
+string
+Log2Histogram::str() const
+{
+    string s;
+
+    s = c_format("count %llu min %llu max %llu mean %llu\n",
+		 (unsigned long long)_count, (unsigned long long)_min,
+		 (unsigned long long)_max,
+		 (unsigned long long)mean());
+    s += c_format("p50 %llu p90 %llu p99 %llu\n",
+		  (unsigned long long)percentile(0.50),
+		  (unsigned long long)percentile(0.90),
+		  (unsigned long long)percentile(0.99));
+
+    for (size_t i = 0; i < BUCKETS; i++) {
+	if (_buckets[i] == 0)
+	    continue;
+	uint64_t lo = (i == 0) ? 0 : uint64_t(1) << (i - 1);
+	uint64_t hi = (uint64_t(1) << i) - 1;
+	s += c_format("%llu\t%llu\t%llu\n", (unsigned long long)lo,
+		      (unsigned long long)hi, (unsigned long long)_buckets[i]);
+    }
+
+    return s;
+}
@@ -0,0 +1,83 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+// 
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+// 
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __LIBXORP_HISTOGRAM_HH__
+#define __LIBXORP_HISTOGRAM_HH__
+
+#include "xorp.h"
+
+/**
+ * @short An online histogram of samples, in power of two buckets.
+ *
+ * Adding a sample costs a few instructions and no allocation, so
+ * latencies can be measured on the fast path.  Bucket 0 counts the
+ * samples of value 0, and bucket i the samples in [2^(i-1), 2^i).
+ */
+class Log2Histogram {
+public:
+    static const size_t BUCKETS = 64;
+
+    Log2Histogram() { clear(); }
+
+    /**
+     * Count a sample.
+     */
+    void add(uint64_t sample) {
+	size_t b = 0;
+	for (uint64_t v = sample; v != 0; v >>= 1)
+	    b++;
+	_buckets[b < BUCKETS ? b : BUCKETS - 1]++;
+	if (_count == 0 || sample < _min)
+	    _min = sample;
+	if (sample > _max)
+	    _max = sample;
+	_count++;
+	_sum += sample;
+    }
+
+    void clear();
+    uint64_t count() const		{ return _count; }
+    uint64_t sum() const		{ return _sum; }
+    uint64_t min_value() const		{ return _min; }
+    uint64_t max_value() const		{ return _max; }
+    uint64_t mean() const		{ return _count ? _sum / _count : 0; }
+    uint64_t bucket(size_t i) const	{ return _buckets[i]; }
+
+    /**
+     * @return an upper bound of the value below which the given
+     * fraction of the samples fall.
+     */
+    uint64_t percentile(double fraction) const;
+
+    /**
+     * @return the histogram as text, one line per non-empty bucket.
+     */
+    string str() const;
+
+private:
+    uint64_t _buckets[BUCKETS];
+    uint64_t _count;
+    uint64_t _sum;
+    uint64_t _min;
+    uint64_t _max;
+};
+
+#endif // __LIBXORP_HISTOGRAM_HH__
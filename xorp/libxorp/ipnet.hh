@@ -560,12 +560,7 @@ template <>
 inline bool
 IPNet<IPv6>::contains(const IPv6& addr) const
 {
-    uint32_t prefixed_addr[4];
-    addr.mask_by_prefix_len_uint(_prefix_len, prefixed_addr);
-    return ((prefixed_addr[0] == _masked_addr.addr()[0])
-	    && (prefixed_addr[1] == _masked_addr.addr()[1])
-	    && (prefixed_addr[2] == _masked_addr.addr()[2])
-	    && (prefixed_addr[3] == _masked_addr.addr()[3]));
+    return addr.common_prefix_len(_masked_addr) >= _prefix_len;
 }
 
 template <class A>
@@ -219,116 +219,6 @@ IPv6::copy_in(const sockaddr_in6& from_sockaddr_in6) throw (InvalidFamily)
     return (copy_in(from_sockaddr_in6.sin6_addr));
 }
 
-IPv6
-IPv6::operator<<(uint32_t ls) const
-{
-    uint32_t tmp_addr[4];
-    x_static_assert(sizeof(_addr) == sizeof(tmp_addr));
-
-    // Shift the words, and at the same time convert them into host-order
-    switch (ls / 32) {
-    case 0:
-	tmp_addr[0] = ntohl(_addr[0]);
-	tmp_addr[1] = ntohl(_addr[1]);
-	tmp_addr[2] = ntohl(_addr[2]);
-	tmp_addr[3] = ntohl(_addr[3]);
-	break;
-    case 1:
-	tmp_addr[0] = ntohl(_addr[1]);
-	tmp_addr[1] = ntohl(_addr[2]);
-	tmp_addr[2] = ntohl(_addr[3]);
-	tmp_addr[3] = 0;
-	break;
-    case 2:
-	tmp_addr[0] = ntohl(_addr[2]);
-	tmp_addr[1] = ntohl(_addr[3]);
-	tmp_addr[2] = 0;
-	tmp_addr[3] = 0;
-	break;
-    case 3:
-	tmp_addr[0] = ntohl(_addr[3]);
-	tmp_addr[1] = 0;
-	tmp_addr[2] = 0;
-	tmp_addr[3] = 0;
-	break;
-    default:
-	// ls >= 128; clear all bits
-	return ZERO();
-    }
-
-    ls &= 0x1f;
-    if (ls != 0) {
-	uint32_t rs = 32 - ls;
-	tmp_addr[0] = (tmp_addr[0] << ls) | (tmp_addr[1] >> rs);
-	tmp_addr[1] = (tmp_addr[1] << ls) | (tmp_addr[2] >> rs);
-	tmp_addr[2] = (tmp_addr[2] << ls) | (tmp_addr[3] >> rs);
-	tmp_addr[3] = tmp_addr[3] << ls;
-    }
-
-    // Convert the words back into network-order
-    tmp_addr[0] = htonl(tmp_addr[0]);
-    tmp_addr[1] = htonl(tmp_addr[1]);
-    tmp_addr[2] = htonl(tmp_addr[2]);
-    tmp_addr[3] = htonl(tmp_addr[3]);
-
-    return IPv6(tmp_addr);
-}
-
-IPv6
-IPv6::operator>>(uint32_t rs) const
-{
-    uint32_t tmp_addr[4];
-    x_static_assert(sizeof(_addr) == sizeof(tmp_addr));
-
-    // Shift the words, and at the same time convert them into host-order
-    switch (rs / 32) {
-    case 0:
-	tmp_addr[3] = ntohl(_addr[3]);
-	tmp_addr[2] = ntohl(_addr[2]);
-	tmp_addr[1] = ntohl(_addr[1]);
-	tmp_addr[0] = ntohl(_addr[0]);
-	break;
-    case 1:
-	tmp_addr[3] = ntohl(_addr[2]);
-	tmp_addr[2] = ntohl(_addr[1]);
-	tmp_addr[1] = ntohl(_addr[0]);
-	tmp_addr[0] = 0;
-	break;
-    case 2:
-	tmp_addr[3] = ntohl(_addr[1]);
-	tmp_addr[2] = ntohl(_addr[0]);
-	tmp_addr[1] = 0;
-	tmp_addr[0] = 0;
-	break;
-    case 3:
-	tmp_addr[3] = ntohl(_addr[0]);
-	tmp_addr[2] = 0;
-	tmp_addr[1] = 0;
-	tmp_addr[0] = 0;
-	break;
-    default:
-	// rs >= 128; clear all bits
-	return ZERO();
-    }
-
-    rs &= 0x1f;
-    if (rs != 0) {
-	uint32_t ls = 32 - rs;
-	tmp_addr[3] = (tmp_addr[3] >> rs) | (tmp_addr[2] << ls);
-	tmp_addr[2] = (tmp_addr[2] >> rs) | (tmp_addr[1] << ls);
-	tmp_addr[1] = (tmp_addr[1] >> rs) | (tmp_addr[0] << ls);
-	tmp_addr[0] = (tmp_addr[0] >> rs);
-    }
-
-    // Convert the words back into network-order
-    tmp_addr[0] = htonl(tmp_addr[0]);
-    tmp_addr[1] = htonl(tmp_addr[1]);
-    tmp_addr[2] = htonl(tmp_addr[2]);
-    tmp_addr[3] = htonl(tmp_addr[3]);
-
-    return IPv6(tmp_addr);
-}
-
 static uint32_t
 init_prefixes(IPv6* v6prefix)
 {
@@ -423,21 +313,8 @@ IPv6::is_loopback() const
 uint32_t
 IPv6::mask_len() const
 {
-    uint32_t ctr = 0;
-
-    for (int j = 0; j < 4; j++) {
-	uint32_t shift = ntohl(_addr[j]);
-
-	for (int i = 0; i < 32; i++) {
-	    if ((shift & 0x80000000U) != 0) {
-		ctr++;
-		shift = shift << 1;
-	    } else {
-		return ctr;
-	    }
-	}
-    }
-    return ctr;
+    // The number of leading ones
+    return (~(*this)).leading_zero_count();
 }
 
 const string&
@@ -29,9 +29,149 @@
 #include "libxorp/range.hh"
 #include "libxorp/utils.hh"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 
 struct in6_addr;
 
+/**
+ * @short 128-bit kernels for the IPv6 address operations.
+ *
+ * An address is stored as four 32-bit words in network order.  The
+ * bitwise operations work on the whole address at once, with SSE2 or
+ * NEON where available and on two 64-bit words otherwise.  The
+ * operations that depend on the bit order (comparison, shifts, masks
+ * and leading zeroes) work on the address as two 64-bit words in host
+ * order.
+ *
+ * The equality test is done on two 64-bit words rather than a vector:
+ * it is as fast, and a vector load of an address that has just been
+ * stored as two words stalls on most processors.
+ */
+struct IPv6Kernels {
+#if defined(__SSE2__)
+    typedef __m128i Vector;
+
+    static Vector load(const uint32_t* p) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static void store(uint32_t* p, Vector v) {
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    }
+    static Vector vand(Vector a, Vector b)	{ return _mm_and_si128(a, b); }
+    static Vector vor(Vector a, Vector b)	{ return _mm_or_si128(a, b); }
+    static Vector vxor(Vector a, Vector b)	{ return _mm_xor_si128(a, b); }
+    static Vector vnot(Vector a) {
+	return _mm_xor_si128(a, _mm_set1_epi32(-1));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    typedef uint32x4_t Vector;
+
+    static Vector load(const uint32_t* p)	{ return vld1q_u32(p); }
+    static void store(uint32_t* p, Vector v)	{ vst1q_u32(p, v); }
+    static Vector vand(Vector a, Vector b)	{ return vandq_u32(a, b); }
+    static Vector vor(Vector a, Vector b)	{ return vorrq_u32(a, b); }
+    static Vector vxor(Vector a, Vector b)	{ return veorq_u32(a, b); }
+    static Vector vnot(Vector a)		{ return vmvnq_u32(a); }
+#else
+    struct Vector { uint64_t w[2]; };
+
+    static Vector load(const uint32_t* p) {
+	Vector v;
+	memcpy(v.w, p, sizeof(v.w));
+	return v;
+    }
+    static void store(uint32_t* p, const Vector& v) {
+	memcpy(p, v.w, sizeof(v.w));
+    }
+    static Vector vand(const Vector& a, const Vector& b) {
+	Vector r = {{ a.w[0] & b.w[0], a.w[1] & b.w[1] }};
+	return r;
+    }
+    static Vector vor(const Vector& a, const Vector& b) {
+	Vector r = {{ a.w[0] | b.w[0], a.w[1] | b.w[1] }};
+	return r;
+    }
+    static Vector vxor(const Vector& a, const Vector& b) {
+	Vector r = {{ a.w[0] ^ b.w[0], a.w[1] ^ b.w[1] }};
+	return r;
+    }
+    static Vector vnot(const Vector& a) {
+	Vector r = {{ ~a.w[0], ~a.w[1] }};
+	return r;
+    }
+#endif
+
+    /**
+     * Test two addresses for equality, as two 64-bit words.
+     */
+    static bool equal(const uint32_t* a, const uint32_t* b) {
+	uint64_t a0, a1, b0, b1;
+	memcpy(&a0, &a[0], sizeof(a0));
+	memcpy(&a1, &a[2], sizeof(a1));
+	memcpy(&b0, &b[0], sizeof(b0));
+	memcpy(&b1, &b[2], sizeof(b1));
+	return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+    }
+
+    /**
+     * Load two words of an address as a 64-bit word in host order.
+     */
+    static uint64_t load64(const uint32_t* p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return swap64(v);
+    }
+
+    /**
+     * Store a 64-bit word in host order as two words of an address.
+     */
+    static void store64(uint32_t* p, uint64_t v) {
+	v = swap64(v);
+	memcpy(p, &v, sizeof(v));
+    }
+
+    /**
+     * Convert a 64-bit word between network and host order.
+     */
+    static uint64_t swap64(uint64_t v) {
+#if BYTE_ORDER == BIG_ENDIAN
+	return v;
+#elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 3)))
+	return __builtin_bswap64(v);
+#else
+	return ((static_cast<uint64_t>(ntohl(static_cast<uint32_t>(v))) << 32)
+		| ntohl(static_cast<uint32_t>(v >> 32)));
+#endif
+    }
+
+    /**
+     * A mask of the @ref n most significant bits of a 64-bit word.
+     */
+    static uint64_t mask64(uint32_t n) {
+	// XXX: shifting with >= 64 bits is undefined
+	uint64_t ones = ~static_cast<uint64_t>(0);
+	uint64_t m = ~(ones >> (n & 63));
+	return (n >= 64) ? ones : m;
+    }
+
+    /**
+     * Count the leading zeroes of two 64-bit words, the most
+     * significant first.
+     */
+    static uint32_t clz128(uint64_t hi, uint64_t lo) {
+	if (hi != 0)
+	    return xorp_leading_zero_count_uint64(hi);
+	if (lo != 0)
+	    return 64 + xorp_leading_zero_count_uint64(lo);
+	return 128;
+    }
+};
+
 /**
  * @short IPv6 address class
  *
@@ -511,18 +651,33 @@ public:
      */
     IPv6 mask_by_prefix_len(uint32_t prefix_len) const
 	throw (InvalidNetmaskLength) {
-	return (*this) & make_prefix(prefix_len);
+	IPv6 r;
+	mask_by_prefix_len_uint(prefix_len, r._addr);
+	return r;
     }
 
     void mask_by_prefix_len_uint(uint32_t prefix_len, uint32_t* masked_addr) const
 	throw (InvalidNetmaskLength) {
-	const IPv6& other = make_prefix(prefix_len);
-	masked_addr[0] = _addr[0] & other._addr[0];
-	masked_addr[1] = _addr[1] & other._addr[1];
-	masked_addr[2] = _addr[2] & other._addr[2];
-	masked_addr[3] = _addr[3] & other._addr[3];
+	if (prefix_len > ADDR_BITLEN)
+	    xorp_throw(InvalidNetmaskLength, prefix_len);
+	IPv6Kernels::store64(&masked_addr[0],
+			     IPv6Kernels::load64(&_addr[0])
+			     & IPv6Kernels::mask64(prefix_len));
+	IPv6Kernels::store64(&masked_addr[2],
+			     IPv6Kernels::load64(&_addr[2])
+			     & IPv6Kernels::mask64(prefix_len > 64 ?
+						   prefix_len - 64 : 0));
     }
 
+    /**
+     * Get the length of the prefix common to this address and another.
+     *
+     * @param other the address to compare against.
+     * @return the number of the most significant bits that are the same
+     * in both addresses.
+     */
+    uint32_t common_prefix_len(const IPv6& other) const;
+
     /**
      * Get the mask length.
      *
@@ -658,47 +813,88 @@ IPv6::bit_count() const
 inline uint32_t
 IPv6::leading_zero_count() const
 {
-    uint32_t r = 0;
+    return IPv6Kernels::clz128(IPv6Kernels::load64(&_addr[0]),
+			       IPv6Kernels::load64(&_addr[2]));
+}
 
-    for (int i = 0; i < 4; i++) {
-	if (_addr[i] != 0) {
-	    r += xorp_leading_zero_count_uint32(ntohl(_addr[i]));
-	    break;
-	}
-	r += 32;
-    }
-    return (r);
+inline uint32_t
+IPv6::common_prefix_len(const IPv6& other) const
+{
+    return IPv6Kernels::clz128(IPv6Kernels::load64(&_addr[0])
+			       ^ IPv6Kernels::load64(&other._addr[0]),
+			       IPv6Kernels::load64(&_addr[2])
+			       ^ IPv6Kernels::load64(&other._addr[2]));
 }
 
 inline bool
 IPv6::operator<(const IPv6& other) const
 {
-    int i;
-    x_static_assert(sizeof(_addr) == 16);
+    uint64_t a = IPv6Kernels::load64(&_addr[0]);
+    uint64_t b = IPv6Kernels::load64(&other._addr[0]);
 
-    for (i = 0; i < 3; i++) {	// XXX: Loop ends intentionally at 3 not 4
-	if (_addr[i] != other._addr[i])
-	    break;
-    }
-    return ntohl(_addr[i]) < ntohl(other._addr[i]);
+    if (a != b)
+	return a < b;
+    return IPv6Kernels::load64(&_addr[2]) < IPv6Kernels::load64(&other._addr[2]);
 }
 
 inline bool
 IPv6::operator==(const IPv6& other) const
 {
-    return ((_addr[0] == other._addr[0])
-	    && (_addr[1] == other._addr[1])
-	    && (_addr[2] == other._addr[2])
-	    && (_addr[3] == other._addr[3]));
+    return IPv6Kernels::equal(_addr, other._addr);
 }
 
 inline bool
 IPv6::operator!=(const IPv6& other) const
 {
-    return ((_addr[0] != other._addr[0])
-	    || (_addr[1] != other._addr[1])
-	    || (_addr[2] != other._addr[2])
-	    || (_addr[3] != other._addr[3]));
+    return ! (*this == other);
+}
+
+inline IPv6
+IPv6::operator<<(uint32_t ls) const
+{
+    uint64_t hi = IPv6Kernels::load64(&_addr[0]);
+    uint64_t lo = IPv6Kernels::load64(&_addr[2]);
+
+    if (ls >= 128) {
+	// Clear all bits
+	return ZERO();
+    }
+    if (ls >= 64) {
+	hi = lo << (ls - 64);
+	lo = 0;
+    } else if (ls != 0) {
+	hi = (hi << ls) | (lo >> (64 - ls));
+	lo <<= ls;
+    }
+
+    IPv6 r;
+    IPv6Kernels::store64(&r._addr[0], hi);
+    IPv6Kernels::store64(&r._addr[2], lo);
+    return r;
+}
+
+inline IPv6
+IPv6::operator>>(uint32_t rs) const
+{
+    uint64_t hi = IPv6Kernels::load64(&_addr[0]);
+    uint64_t lo = IPv6Kernels::load64(&_addr[2]);
+
+    if (rs >= 128) {
+	// Clear all bits
+	return ZERO();
+    }
+    if (rs >= 64) {
+	lo = hi >> (rs - 64);
+	hi = 0;
+    } else if (rs != 0) {
+	lo = (lo >> rs) | (hi << (64 - rs));
+	hi >>= rs;
+    }
+
+    IPv6 r;
+    IPv6Kernels::store64(&r._addr[0], hi);
+    IPv6Kernels::store64(&r._addr[2], lo);
+    return r;
 }
 
 inline IPv6&
@@ -800,39 +996,30 @@ inline const IPv6& IPv6::SSM_ROUTERS(int) {
 }
 
 inline IPv6 IPv6::operator~() const {
-    uint32_t tmp_addr[4];
-    tmp_addr[0] = ~_addr[0];
-    tmp_addr[1] = ~_addr[1];
-    tmp_addr[2] = ~_addr[2];
-    tmp_addr[3] = ~_addr[3];
-    return IPv6(tmp_addr);
+    IPv6 r;
+    IPv6Kernels::store(r._addr, IPv6Kernels::vnot(IPv6Kernels::load(_addr)));
+    return r;
 }
 
 inline IPv6 IPv6::operator|(const IPv6& other) const {
-    uint32_t tmp_addr[4];
-    tmp_addr[0] = _addr[0] | other._addr[0];
-    tmp_addr[1] = _addr[1] | other._addr[1];
-    tmp_addr[2] = _addr[2] | other._addr[2];
-    tmp_addr[3] = _addr[3] | other._addr[3];
-    return IPv6(tmp_addr);
+    IPv6 r;
+    IPv6Kernels::store(r._addr, IPv6Kernels::vor(IPv6Kernels::load(_addr),
+					       IPv6Kernels::load(other._addr)));
+    return r;
 }
 
 inline IPv6 IPv6::operator&(const IPv6& other) const {
-    uint32_t tmp_addr[4];
-    tmp_addr[0] = _addr[0] & other._addr[0];
-    tmp_addr[1] = _addr[1] & other._addr[1];
-    tmp_addr[2] = _addr[2] & other._addr[2];
-    tmp_addr[3] = _addr[3] & other._addr[3];
-    return IPv6(tmp_addr);
+    IPv6 r;
+    IPv6Kernels::store(r._addr, IPv6Kernels::vand(IPv6Kernels::load(_addr),
+						IPv6Kernels::load(other._addr)));
+    return r;
 }
 
 inline IPv6 IPv6::operator^(const IPv6& other) const {
-    uint32_t tmp_addr[4];
-    tmp_addr[0] = _addr[0] ^ other._addr[0];
-    tmp_addr[1] = _addr[1] ^ other._addr[1];
-    tmp_addr[2] = _addr[2] ^ other._addr[2];
-    tmp_addr[3] = _addr[3] ^ other._addr[3];
-    return IPv6(tmp_addr);
+    IPv6 r;
+    IPv6Kernels::store(r._addr, IPv6Kernels::vxor(IPv6Kernels::load(_addr),
+						IPv6Kernels::load(other._addr)));
+    return r;
 }
 
 #endif // __LIBXORP_IPV6_HH__
@@ -0,0 +1,445 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+#ifndef __LIBXORP_LC_TRIE_HH__
+#define __LIBXORP_LC_TRIE_HH__
+
+#include "ipv4.hh"
+#include "ipv6.hh"
+#include "utils.hh"
+#include "trie.hh"
+
+#include <algorithm>
+
+/*
+ * This module implements a read-optimized variant of the Trie for
+ * longest-match lookups of addresses.
+ *
+ * The routes are kept in a regular Trie, which is used for updates, for
+ * subnet lookups and for iteration.  Lookups of addresses use a compiled,
+ * level-compressed multibit trie (in the style of Poptrie, Asai and
+ * Ohara, SIGCOMM 2015) that is built from the Trie on the first lookup
+ * after an update.  The compiled trie is made of:
+ *
+ *  - a direct-indexed array for the first LC_DIRECT_BITS bits of the
+ *    address, whose entries refer either to a leaf or to a node;
+ *  - an array of nodes, each consuming LC_STRIDE (6) bits of the address.
+ *    A node has a 64-bit bitmap of the children that are nodes, and
+ *    another one marking where a run of identical leaves starts.  The
+ *    children nodes (and the leaves) of a node are stored contiguously,
+ *    so the index of a child is found with a population count;
+ *  - an array of leaves, each being the TrieNode of the longest matching
+ *    prefix (or NULL).
+ *
+ * A lookup touches one direct entry and one 24-byte node per 6 bits of
+ * the address beyond the longest prefix found in the direct array, so an
+ * IPv4 lookup in a full table takes at most four dependent loads.
+ */
+
+/**
+ * @short Access to the bits of an address, most significant bit first.
+ *
+ * Bits beyond the end of the address read as zero.
+ */
+template <class A>
+class LcTrieKey {
+};
+
+template <>
+class LcTrieKey<IPv4> {
+public:
+    explicit LcTrieKey(const IPv4& a) : _w(ntohl(a.addr())) {}
+
+    uint32_t bits(uint32_t off, uint32_t len) const {
+	uint64_t w = static_cast<uint64_t>(_w) << 32;
+
+	return static_cast<uint32_t>((w << off) >> (64 - len));
+    }
+
+private:
+    uint32_t	_w;
+};
+
+template <>
+class LcTrieKey<IPv6> {
+public:
+    explicit LcTrieKey(const IPv6& a) {
+	const uint32_t* p = a.addr();
+
+	_hi = (static_cast<uint64_t>(ntohl(p[0])) << 32) | ntohl(p[1]);
+	_lo = (static_cast<uint64_t>(ntohl(p[2])) << 32) | ntohl(p[3]);
+    }
+
+    uint32_t bits(uint32_t off, uint32_t len) const {
+	uint64_t w;
+
+	if (off >= 128)
+	    return 0;
+	if (off == 0)
+	    w = _hi;
+	else if (off < 64)
+	    w = (_hi << off) | (_lo >> (64 - off));
+	else
+	    w = _lo << (off - 64);
+	return static_cast<uint32_t>(w >> (64 - len));
+    }
+
+private:
+    uint64_t	_hi;
+    uint64_t	_lo;
+};
+
+/**
+ * @short Level-compressed Trie
+ *
+ * LcTrie has the same interface as @ref Trie, and can be used in its
+ * place where address lookups are much more frequent than updates.
+ * Address lookups (find(const A&)) run on a compiled multibit trie
+ * that is rebuilt from scratch on the first lookup after the routes have
+ * changed, everything else is done on an embedded @ref Trie.
+ *
+ * The iterators are the ones of the embedded Trie.  As with a Trie,
+ * erasing a route invalidates the iterators that point to it.
+ */
+template <class A, class Payload, class __Iterator =
+    TriePostOrderIterator<A,Payload> >
+class LcTrie {
+public:
+    typedef IPNet<A> Key;
+    typedef TrieNode<A,Payload> Node;
+    typedef __Iterator iterator;
+
+    LcTrie() : _dirty(true), _direct_bits(0), _compile_count(0) {}
+
+    /**
+     * insert a key,payload pair, returns an iterator
+     * to the newly inserted node.
+     */
+    iterator insert(const Key& net, const Payload& p) {
+	_dirty = true;
+	return _trie.insert(net, p);
+    }
+
+    /**
+     * delete the node with the given key.
+     */
+    void erase(const Key& k)			{ erase(_trie.find(k)); }
+
+    /**
+     * delete the node pointed by the iterator.
+     */
+    void erase(iterator i)			{
+	_dirty = true;
+	_trie.erase(i);
+    }
+
+    iterator unbind_root(iterator i) const	{ return _trie.unbind_root(i); }
+
+    /**
+     * given a key, returns an iterator to the entry with the
+     * longest matching prefix.
+     */
+    iterator find(const Key& k) const		{
+	if (k.prefix_len() == A::addr_bitlen())
+	    return find(k.masked_addr());
+	return _trie.find(k);
+    }
+
+    /**
+     * given an address, returns an iterator to the entry with the
+     * longest matching prefix.
+     */
+    iterator find(const A& a) const		{
+	if (_dirty)
+	    compile();
+	return iterator(lookup_leaf(a));
+    }
+
+    iterator lower_bound(const Key& k) const	{ return _trie.lower_bound(k); }
+
+    iterator begin() const			{ return _trie.begin(); }
+    const iterator end() const			{ return _trie.end(); }
+
+    void delete_all_nodes()			{
+	_dirty = true;
+	_trie.delete_all_nodes();
+    }
+
+    /**
+     * lookup a subnet, must return exact match if found, end() if not.
+     */
+    iterator lookup_node(const Key& k) const	{ return _trie.lookup_node(k); }
+
+    /**
+     * returns an iterator to the subtree rooted at or below
+     * the key passed as parameter.
+     */
+    iterator search_subtree(const Key& key) const {
+	return _trie.search_subtree(key);
+    }
+
+    /**
+     * if I were to add this net to the trie, what would be its parent
+     * node?
+     */
+    iterator find_less_specific(const Key& key) const {
+	return _trie.find_less_specific(key);
+    }
+
+    /**
+     * return the lower and higher address in the range that contains a
+     * and would map to the same route.
+     */
+    void find_bounds(const A& a, A& lo, A& hi) const {
+	_trie.find_bounds(a, lo, hi);
+    }
+
+    int route_count() const			{ return _trie.route_count(); }
+    size_t size() const				{ return _trie.size(); }
+    bool empty() const				{ return _trie.empty(); }
+
+    void print() const				{ _trie.print(); }
+
+    /**
+     * Build the lookup structure now, rather than on the next lookup.
+     */
+    void compile() const;
+
+    /**
+     * @return the number of bytes used by the compiled lookup structure.
+     */
+    size_t compiled_bytes() const {
+	return (_direct.capacity() * sizeof(uint32_t)
+		+ _nodes.capacity() * sizeof(LcNode)
+		+ _leaves.capacity() * sizeof(Node*));
+    }
+
+    /**
+     * @return the number of times the lookup structure has been built.
+     */
+    size_t compile_count() const		{ return _compile_count; }
+
+private:
+    enum {
+	LC_STRIDE	= 6,		// bits consumed by a node
+	LC_DIRECT_BITS	= 16,		// bits of the direct array
+	LC_SMALL_BITS	= 8,		// ... for small tables
+	LC_SMALL_ROUTES	= 4096		// tables up to this size are small
+    };
+    static const uint32_t LC_LEAF = 0x80000000U;
+
+    struct LcNode {
+	uint64_t	vector;		// children that are nodes
+	uint64_t	leafvec;	// start of each run of leaves
+	uint32_t	base0;		// index of the first leaf
+	uint32_t	base1;		// index of the first child node
+    };
+
+    typedef vector<pair<Key, Node*> > EntryList;
+
+    struct EntryLess {
+	bool operator()(const pair<Key, Node*>& a,
+			const pair<Key, Node*>& b) const {
+	    if (a.first.masked_addr() != b.first.masked_addr())
+		return a.first.masked_addr() < b.first.masked_addr();
+	    return a.first.prefix_len() < b.first.prefix_len();
+	}
+    };
+
+    static uint32_t popcount(uint64_t x) {
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	return (xorp_bit_count_uint32(static_cast<uint32_t>(x))
+		+ xorp_bit_count_uint32(static_cast<uint32_t>(x >> 32)));
+#endif
+    }
+
+    inline Node* lookup_leaf(const A& a) const;
+
+    void paint(const EntryList& entries, size_t b, size_t e,
+	       uint32_t depth, uint32_t stride, Node** vals,
+	       size_t* cb, size_t* ce) const;
+    void build_node(const EntryList& entries, size_t idx, size_t b,
+		    size_t e, uint32_t depth, Node* def) const;
+
+    Trie<A, Payload, __Iterator>	_trie;
+
+    // the compiled lookup structure
+    mutable bool			_dirty;
+    mutable uint32_t			_direct_bits;
+    mutable vector<uint32_t>		_direct;
+    mutable vector<LcNode>		_nodes;
+    mutable vector<Node*>		_leaves;
+    mutable size_t			_compile_count;
+};
+
+template <class A, class Payload, class __Iterator>
+inline typename LcTrie<A, Payload, __Iterator>::Node*
+LcTrie<A, Payload, __Iterator>::lookup_leaf(const A& a) const
+{
+    LcTrieKey<A> key(a);
+    uint32_t i = _direct[key.bits(0, _direct_bits)];
+    uint32_t off = _direct_bits;
+
+    if (i & LC_LEAF)
+	return _leaves[i & ~LC_LEAF];
+
+    for (;;) {
+	const LcNode& n = _nodes[i];
+	uint32_t v = key.bits(off, LC_STRIDE);
+	uint64_t upto = ~static_cast<uint64_t>(0) >> (63 - v);
+
+	if (! (n.vector & (static_cast<uint64_t>(1) << v)))
+	    return _leaves[n.base0 + popcount(n.leafvec & upto) - 1];
+	i = n.base1 + popcount(n.vector & upto) - 1;
+	off += LC_STRIDE;
+    }
+}
+
+/*
+ * Work out the 2^stride slots of a node at the given depth: the
+ * longest match of each slot among the routes that are not longer than
+ * depth + stride, and the range of longer routes that fall in each slot.
+ *
+ * The entries are sorted by address then prefix length, so a route
+ * always comes before the more specific routes it contains, and routes
+ * that fall in the same slot are contiguous.
+ */
+template <class A, class Payload, class __Iterator>
+void
+LcTrie<A, Payload, __Iterator>::paint(const EntryList& entries,
+				      size_t b, size_t e,
+				      uint32_t depth, uint32_t stride,
+				      Node** vals, size_t* cb,
+				      size_t* ce) const
+{
+    uint32_t end_depth = depth + stride;
+
+    for (size_t i = b; i < e; i++) {
+	const Key& k = entries[i].first;
+	uint32_t v = LcTrieKey<A>(k.masked_addr()).bits(depth, stride);
+
+	if (k.prefix_len() <= end_depth) {
+	    uint32_t span = 1U << (end_depth - k.prefix_len());
+	    for (uint32_t j = v; j < v + span; j++)
+		vals[j] = entries[i].second;
+	} else {
+	    if (ce[v] == cb[v])
+		cb[v] = i;
+	    ce[v] = i + 1;
+	}
+    }
+}
+
+template <class A, class Payload, class __Iterator>
+void
+LcTrie<A, Payload, __Iterator>::build_node(const EntryList& entries,
+					   size_t idx, size_t b, size_t e,
+					   uint32_t depth, Node* def) const
+{
+    static const uint32_t SLOTS = 1U << LC_STRIDE;
+    Node* vals[SLOTS];
+    size_t cb[SLOTS], ce[SLOTS];
+
+    for (uint32_t v = 0; v < SLOTS; v++) {
+	vals[v] = def;
+	cb[v] = ce[v] = 0;
+    }
+    paint(entries, b, e, depth, LC_STRIDE, vals, cb, ce);
+
+    LcNode n;
+    n.vector = 0;
+    n.leafvec = 0;
+    n.base0 = _leaves.size();
+    for (uint32_t v = 0; v < SLOTS; v++) {
+	uint64_t bit = static_cast<uint64_t>(1) << v;
+	if (ce[v] != cb[v]) {
+	    n.vector |= bit;
+	    continue;
+	}
+	if (_leaves.size() == n.base0 || _leaves.back() != vals[v]) {
+	    n.leafvec |= bit;
+	    _leaves.push_back(vals[v]);
+	}
+    }
+    n.base1 = _nodes.size();
+    _nodes.resize(_nodes.size() + popcount(n.vector));
+    _nodes[idx] = n;
+
+    uint32_t child = n.base1;
+    for (uint32_t v = 0; v < SLOTS; v++) {
+	if (ce[v] != cb[v]) {
+	    build_node(entries, child++, cb[v], ce[v], depth + LC_STRIDE,
+		       vals[v]);
+	}
+    }
+}
+
+template <class A, class Payload, class __Iterator>
+void
+LcTrie<A, Payload, __Iterator>::compile() const
+{
+    EntryList entries;
+
+    entries.reserve(_trie.size());
+    for (iterator i = _trie.begin(); i != _trie.end(); ++i)
+	entries.push_back(make_pair(i.key(), i.cur()));
+    sort(entries.begin(), entries.end(), EntryLess());
+
+    _direct_bits = (entries.size() > LC_SMALL_ROUTES) ? LC_DIRECT_BITS
+						       : LC_SMALL_BITS;
+    _nodes.clear();
+    _leaves.clear();
+
+    uint32_t slots = 1U << _direct_bits;
+    vector<Node*> vals(slots, static_cast<Node*>(0));
+    vector<size_t> cb(slots, 0), ce(slots, 0);
+
+    paint(entries, 0, entries.size(), 0, _direct_bits,
+	  &vals[0], &cb[0], &ce[0]);
+
+    // The direct array, and the nodes it refers to
+    uint32_t nchildren = 0;
+    _direct.resize(slots);
+    for (uint32_t v = 0; v < slots; v++) {
+	if (ce[v] != cb[v]) {
+	    _direct[v] = nchildren++;
+	    continue;
+	}
+	if (_leaves.empty() || _leaves.back() != vals[v])
+	    _leaves.push_back(vals[v]);
+	_direct[v] = LC_LEAF | (_leaves.size() - 1);
+    }
+    _nodes.resize(nchildren);
+    for (uint32_t v = 0; v < slots; v++) {
+	if (ce[v] != cb[v]) {
+	    build_node(entries, _direct[v], cb[v], ce[v], _direct_bits,
+		       vals[v]);
+	}
+    }
+
+    _dirty = false;
+    _compile_count++;
+}
+
+#endif // __LIBXORP_LC_TRIE_HH__
@@ -0,0 +1,353 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2012 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+#include "libxorp/xorp.h"
+
+#include "libxorp/xlog.h"
+#include "libxorp/c_format.hh"
+
+#include "memory_pool.hh"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+// Implementation Notes:
+//
+// A chunk starts with a Chunk header, followed by _capacity slots of
+// _slot_size bytes.  Slots are handed out first from the chunk's own
+// free list, then by bumping _bump through the never used slots, so a
+// new chunk is not touched beyond its header until it is used.
+//
+// Every chunk is on exactly one of the _partial, _full or _spare lists.
+// A chunk whose owner has been destroyed is on none: it is released as
+// soon as its last object is freed.
+//
+// Chunks are obtained with mmap() where available, so that releasing a
+// chunk really gives the memory back, rather than leaving it to the
+// mercy of the malloc implementation.  To align a chunk on its size,
+// twice the size is mapped and the excess unmapped.  All chunks have
+// the same size, so that free() can find the header of any object.
+//
+// Each chunk of an allocator has an id, and the index of an object is
+// the id of its chunk times the capacity of a chunk plus its slot.  The
+// ids of the chunks released are reused, so the indices stay dense.
+
+const size_t SlabAllocator::SIZE_CLASS_GRANULARITY;
+const size_t SlabAllocator::MAX_SIZE_CLASS;
+const size_t SlabAllocator::CHUNK_SIZE;
+
+struct SlabAllocator::Chunk {
+    SlabAllocator*	owner;		// NULL once the owner is destroyed
+    Chunk*		next;
+    Chunk*		prev;
+    void*		free_list;	// freed slots
+    void*		raw;		// what to give back to the system
+    size_t		in_use;		// allocated slots
+    size_t		bump;		// slots handed out at least once
+    uint32_t		id;		// the index of the chunk in _chunk_ids
+};
+
+static const size_t SLAB_ALIGN = 16;
+
+static inline size_t
+round_up(size_t n, size_t align)
+{
+    return (n + align - 1) & ~(align - 1);
+}
+
+SlabAllocator::SlabAllocator(size_t object_size)
+    : _partial(NULL), _full(NULL), _spare(NULL)
+{
+    // Objects must hold the free list link, and be pointer aligned
+    _slot_size = round_up(max(object_size, sizeof(void*)), sizeof(void*));
+    _header_size = round_up(sizeof(Chunk), SLAB_ALIGN);
+    _capacity = (CHUNK_SIZE - _header_size) / _slot_size;
+    XLOG_ASSERT(_capacity > 0);
+
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.object_size = _slot_size;
+    _stats.chunk_size = CHUNK_SIZE;
+    _stats.objects_per_chunk = _capacity;
+}
+
+SlabAllocator::~SlabAllocator()
+{
+    Chunk* lists[] = { _partial, _full, _spare };
+
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+	Chunk* c = lists[i];
+	while (c != NULL) {
+	    Chunk* next = c->next;
+	    if (c->in_use == 0) {
+		release_chunk(c);
+	    } else {
+		// XXX: the objects may be freed later, e.g. by the
+		// destructor of another static object.
+		c->owner = NULL;
+		c->next = c->prev = NULL;
+	    }
+	    c = next;
+	}
+    }
+}
+
+void*
+SlabAllocator::alloc()
+{
+    Chunk* c = _partial;
+
+    if (c == NULL) {
+	if (_spare != NULL) {
+	    c = _spare;
+	    _spare = NULL;
+	} else {
+	    c = new_chunk();
+	}
+	link(_partial, c);
+    }
+
+    void* p;
+    if (c->free_list != NULL) {
+	p = c->free_list;
+	c->free_list = *reinterpret_cast<void**>(p);
+    } else {
+	p = reinterpret_cast<char*>(c) + _header_size + c->bump * _slot_size;
+	c->bump++;
+    }
+
+    if (++c->in_use == _capacity) {
+	unlink(_partial, c);
+	link(_full, c);
+    }
+    _stats.objects_in_use++;
+    _stats.allocs++;
+
+    return p;
+}
+
+void
+SlabAllocator::free(void* p)
+{
+    if (p == NULL)
+	return;
+
+    Chunk* c = chunk_of(p);
+
+    if (c->owner == NULL) {
+	// The owner is gone: give the chunk back with its last object
+	if (--c->in_use == 0)
+	    release_chunk(c);
+	return;
+    }
+    c->owner->free_slot(c, p);
+}
+
+void
+SlabAllocator::free_slot(Chunk* c, void* p)
+{
+    XLOG_ASSERT(c->in_use > 0);
+
+    *reinterpret_cast<void**>(p) = c->free_list;
+    c->free_list = p;
+    if (c->in_use-- == _capacity) {
+	unlink(_full, c);
+	link(_partial, c);
+    }
+    _stats.objects_in_use--;
+
+    if (c->in_use != 0)
+	return;
+
+    unlink(_partial, c);
+    if (_spare == NULL) {
+	// Forget the freed slots, so the spare is bump allocated again
+	c->free_list = NULL;
+	c->bump = 0;
+	_spare = c;
+	return;
+    }
+    release_chunk(c);
+}
+
+uint32_t
+SlabAllocator::index(const void* p) const
+{
+    const Chunk* c = chunk_of(p);
+    XLOG_ASSERT(c->owner == this);
+
+    size_t slot = (reinterpret_cast<const char*>(p)
+		   - reinterpret_cast<const char*>(c) - _header_size)
+	/ _slot_size;
+
+    return c->id * _capacity + slot;
+}
+
+void*
+SlabAllocator::object(uint32_t index) const
+{
+    XLOG_ASSERT(index / _capacity < _chunk_ids.size());
+    Chunk* c = _chunk_ids[index / _capacity];
+
+    return reinterpret_cast<char*>(c) + _header_size
+	+ (index % _capacity) * _slot_size;
+}
+
+SlabAllocator::Chunk*
+SlabAllocator::chunk_of(const void* p)
+{
+    return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(p)
+				    & ~(uintptr_t)(CHUNK_SIZE - 1));
+}
+
+SlabAllocator::Chunk*
+SlabAllocator::new_chunk()
+{
+    void* raw;
+    char* base;
+
+    bool reuse_id = !_free_ids.empty();
+    uint32_t id;
+    if (reuse_id) {
+	id = _free_ids.back();
+    } else {
+	// All the indices must fit in 32 bits
+	if ((_chunk_ids.size() + 1) * _capacity > 0xffffffffU)
+	    throw bad_alloc();
+	id = _chunk_ids.size();
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+    raw = mmap(NULL, 2 * CHUNK_SIZE, PROT_READ | PROT_WRITE,
+	       MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (raw == MAP_FAILED)
+	throw bad_alloc();
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = round_up(start, CHUNK_SIZE);
+    if (aligned > start)
+	munmap(raw, aligned - start);
+    if (start + CHUNK_SIZE > aligned)
+	munmap(reinterpret_cast<void*>(aligned + CHUNK_SIZE),
+	       start + CHUNK_SIZE - aligned);
+    base = reinterpret_cast<char*>(aligned);
+    raw = base;
+#else
+    raw = malloc(2 * CHUNK_SIZE);
+    if (raw == NULL)
+	throw bad_alloc();
+    base = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw),
+					    CHUNK_SIZE));
+#endif
+
+    Chunk* c = reinterpret_cast<Chunk*>(base);
+    c->owner = this;
+    c->next = c->prev = NULL;
+    c->free_list = NULL;
+    c->raw = raw;
+    c->in_use = 0;
+    c->bump = 0;
+    c->id = id;
+
+    if (reuse_id) {
+	_free_ids.pop_back();
+	_chunk_ids[id] = c;
+    } else {
+	_chunk_ids.push_back(c);
+    }
+
+    _stats.chunks++;
+    _stats.chunks_allocated++;
+
+    return c;
+}
+
+void
+SlabAllocator::release_chunk(Chunk* c)
+{
+    if (c->owner != NULL) {
+	c->owner->_stats.chunks--;
+	c->owner->_stats.chunks_released++;
+	c->owner->_chunk_ids[c->id] = NULL;
+	c->owner->_free_ids.push_back(c->id);
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+    munmap(c->raw, CHUNK_SIZE);
+#else
+    ::free(c->raw);
+#endif
+}
+
+void
+SlabAllocator::link(Chunk*& head, Chunk* c)
+{
+    c->prev = NULL;
+    c->next = head;
+    if (head != NULL)
+	head->prev = c;
+    head = c;
+}
+
+void
+SlabAllocator::unlink(Chunk*& head, Chunk* c)
+{
+    if (c->prev != NULL)
+	c->prev->next = c->next;
+    else
+	head = c->next;
+    if (c->next != NULL)
+	c->next->prev = c->prev;
+    c->next = c->prev = NULL;
+}
+
+string
+SlabAllocator::str() const
+{
+    return c_format("object size %u, %u objects in use, "
+		    "%u chunks of %u bytes (%u objects each), "
+		    "%u allocations, %u chunks allocated, %u chunks released",
+		    XORP_UINT_CAST(_stats.object_size),
+		    XORP_UINT_CAST(_stats.objects_in_use),
+		    XORP_UINT_CAST(_stats.chunks),
+		    XORP_UINT_CAST(_stats.chunk_size),
+		    XORP_UINT_CAST(_stats.objects_per_chunk),
+		    XORP_UINT_CAST(_stats.allocs),
+		    XORP_UINT_CAST(_stats.chunks_allocated),
+		    XORP_UINT_CAST(_stats.chunks_released));
+}
+
+SlabAllocator&
+SlabAllocator::size_class(size_t size)
+{
+    static SlabAllocator* classes[MAX_SIZE_CLASS / SIZE_CLASS_GRANULARITY + 1];
+
+    XLOG_ASSERT(size <= MAX_SIZE_CLASS);
+
+    size_t idx = (size + SIZE_CLASS_GRANULARITY - 1) / SIZE_CLASS_GRANULARITY;
+    if (classes[idx] == NULL) {
+	classes[idx] = new SlabAllocator(idx * SIZE_CLASS_GRANULARITY);
+    }
+
+    return *classes[idx];
+}
@@ -23,78 +23,163 @@
 
 #include "xorp.h"
 
+/**
+ * @short Slab allocator for objects of a fixed size.
+ *
+ * Objects are carved out of contiguous chunks of CHUNK_SIZE bytes.  A
+ * chunk is aligned on its size, so the chunk an object belongs to is
+ * found by masking the object's address, and an object can be freed
+ * without knowing which allocator it came from.
+ *
+ * Chunks that still have free slots are kept on a list, and allocation
+ * takes a slot from the first of them.  When the last object of a chunk
+ * is freed, the chunk is kept as a spare if there isn't one already,
+ * otherwise it is returned to the operating system.
+ */
+class SlabAllocator : public NONCOPYABLE {
+public:
+    /**
+     * Allocator statistics.
+     */
+    struct Stats {
+	size_t	object_size;	// the size of a slot, in bytes
+	size_t	chunk_size;	// the size of a chunk, in bytes
+	size_t	objects_per_chunk; // the number of slots in a chunk
+	size_t	objects_in_use;	// the number of allocated objects
+	size_t	chunks;		// the number of chunks currently held
+	size_t	allocs;		// the total number of allocations
+	size_t	chunks_allocated; // the number of chunks ever obtained
+	size_t	chunks_released; // the number of chunks given back
+    };
+
+    /**
+     * Constructor.
+     *
+     * No memory is allocated until the first object is.
+     *
+     * @param object_size the size of the objects.
+     */
+    explicit SlabAllocator(size_t object_size);
+
+    /**
+     * Destructor.
+     *
+     * The chunks without objects are released.  The chunks that still
+     * hold objects are kept until those objects are freed.
+     */
+    ~SlabAllocator();
+
+    /**
+     * Allocate an object.
+     *
+     * @return the uninitialized memory of the object.
+     */
+    void* alloc();
+
+    /**
+     * Free an object allocated by any SlabAllocator.
+     *
+     * @param p the object to free.
+     */
+    static void free(void* p);
+
+    /**
+     * Get the index of an object.
+     *
+     * The indices of the objects of an allocator are small integers
+     * that stay valid as long as the objects do, so they can be
+     * stored instead of pointers to the objects, in half the space.
+     *
+     * @param p an object allocated by this allocator.
+     * @return the index of the object.
+     */
+    uint32_t index(const void* p) const;
+
+    /**
+     * Get an object from its index.
+     *
+     * @param index the index of an object allocated by this allocator.
+     * @return the object.
+     */
+    void* object(uint32_t index) const;
+
+    /**
+     * @return the allocator statistics.
+     */
+    const Stats& stats() const		{ return _stats; }
+
+    /**
+     * @return the bytes held by the allocator, including the unused slots.
+     */
+    size_t bytes() const	{ return _stats.chunks * _stats.chunk_size; }
+
+    /**
+     * @return a human-readable summary of the statistics.
+     */
+    string str() const;
+
+    /**
+     * Get the allocator shared by all objects of a size class.
+     *
+     * The size classes are multiples of SIZE_CLASS_GRANULARITY bytes,
+     * up to MAX_SIZE_CLASS bytes.  Size class allocators are never
+     * destroyed.
+     *
+     * @param size the size of the object.
+     * @return the allocator for the size class of the object.
+     */
+    static SlabAllocator& size_class(size_t size);
+
+    static const size_t	SIZE_CLASS_GRANULARITY = 8;
+    static const size_t	MAX_SIZE_CLASS = 1024;
+    static const size_t	CHUNK_SIZE = 64 * 1024;
+
+private:
+    struct Chunk;
+
+    Chunk* new_chunk();
+    static Chunk* chunk_of(const void* p);
+    static void release_chunk(Chunk* c);
+    void free_slot(Chunk* c, void* p);
+    static void link(Chunk*& head, Chunk* c);
+    static void unlink(Chunk*& head, Chunk* c);
+
+    size_t	_slot_size;	// object size rounded up to the alignment
+    size_t	_capacity;	// slots per chunk
+    size_t	_header_size;	// size of the chunk header, rounded up
+    Chunk*	_partial;	// chunks with free slots
+    Chunk*	_full;		// chunks without free slots
+    Chunk*	_spare;		// an empty chunk kept for reuse
+    vector<Chunk*> _chunk_ids;	// the chunks by id, for the indices
+    vector<uint32_t> _free_ids;	// the ids of the chunks released
+    Stats	_stats;
+};
+
+/**
+ * @short Per-type memory pool.
+ *
+ * A thin wrapper around a @ref SlabAllocator of its own, to implement
+ * class-specific operator new and delete.  EXPANSION_SIZE is kept for
+ * source compatibility: a chunk holds as many objects as fit in
+ * SlabAllocator::CHUNK_SIZE bytes.
+ */
 template <class T, size_t EXPANSION_SIZE = 100>
 class MemoryPool : public NONCOPYABLE {
 public:
-    MemoryPool();
-    ~MemoryPool();
+    MemoryPool() : _slab(sizeof(T)) {}
 
-    //Allocate element of type T from free list
-    void* alloc();
+    // Allocate element of type T
+    void* alloc()			{ return _slab.alloc(); }
 
-    // Return element to the free list
-    void free(void* doomed);
-private:
-    // next element on the free list
-    MemoryPool<T, EXPANSION_SIZE>* _next;
+    // Return element to the pool
+    void free(void* doomed)		{ SlabAllocator::free(doomed); }
 
-    // Add free elements to the list
-    void expand_free_list();
+    const SlabAllocator::Stats& stats() const { return _slab.stats(); }
+    size_t bytes() const		{ return _slab.bytes(); }
+    string str() const			{ return _slab.str(); }
 
-    size_t _size;
+private:
+    SlabAllocator	_slab;
 };
 
-template <class T, size_t EXPANSION_SIZE>
-MemoryPool<T, EXPANSION_SIZE>::MemoryPool() :
-    _size((sizeof(T) > sizeof(MemoryPool<T, EXPANSION_SIZE>)) ? sizeof(T) :sizeof(MemoryPool<T, EXPANSION_SIZE>))
-{
-    expand_free_list();
-}
-
-template <class T, size_t EXPANSION_SIZE>
-MemoryPool<T, EXPANSION_SIZE>::~MemoryPool()
-{
-    for (MemoryPool<T, EXPANSION_SIZE> *nextPtr = _next; nextPtr != NULL; nextPtr = _next) {
-	_next = _next->_next;
-	delete [] reinterpret_cast<char* >(nextPtr);
-    }
-}
-
-template <class T, size_t EXPANSION_SIZE>
-inline void*
-MemoryPool<T, EXPANSION_SIZE>::alloc()
-{
-    if (!_next)
-	expand_free_list();
-
-    MemoryPool<T, EXPANSION_SIZE>* head = _next;
-    _next = head->_next;
-    return head;
-}
-
-template <class T, size_t EXPANSION_SIZE>
-inline void
-MemoryPool<T, EXPANSION_SIZE>::free(void* doomed)
-{
-    MemoryPool<T, EXPANSION_SIZE>* head = reinterpret_cast<MemoryPool<T, EXPANSION_SIZE>* >(doomed);
-
-    head->_next = _next;
-    _next = head;
-}
-
-template <class T, size_t EXPANSION_SIZE>
-inline void
-MemoryPool<T, EXPANSION_SIZE>::expand_free_list()
-{
-    // We must allocate object large enough to contain the next pointer
-    MemoryPool<T, EXPANSION_SIZE>* runner = reinterpret_cast<MemoryPool<T, EXPANSION_SIZE>* >(new char[_size]);
-
-    _next = runner;
-    for (size_t i = 0; i < EXPANSION_SIZE; ++i) {
-	runner->_next = reinterpret_cast<MemoryPool<T, EXPANSION_SIZE>* >(new char[_size]);
-	runner = runner->_next;
-    }
-    runner->_next = NULL;
-}
-
 #endif /* MEMORY_POOL_HH_ */
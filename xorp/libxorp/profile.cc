@@ -26,11 +26,65 @@
 
 #include "libxorp/timeval.hh"
 #include "libxorp/timer.hh"
+#include "libxorp/c_format.hh"
 
 #include "xlog.h"
 #include "debug.h"
 #include "profile.hh"
 
+// Implementation Notes:
+//
+// The ring buffer of a variable is allocated when the variable is
+// enabled, and then reused until the variable is destroyed.  Entries
+// logged as text keep their text in a parallel array of strings, which
+// is only allocated if the variable is ever logged to as text.  The
+// strings of the array are assigned to rather than constructed, so
+// once the ring has wrapped they reuse their buffers.
+//
+// Records are timestamped by reading the monotonic clock directly,
+// which is what the SystemClock of the TimerList reads too, so the
+// times read out are comparable with the previous log format.  Going
+// through the TimerList would also advance its time on every entry.
+
+const size_t Profile::DEFAULT_LOG_SIZE;
+void
+Profile::ProfileState::allocate()
+{
+    if (_ring == NULL)
+	_ring = new Record[_capacity];
+}
+
+void
+Profile::ProfileState::zap()
+{
+    delete[] _ring;
+    delete[] _text;
+    _ring = NULL;
+    _text = NULL;
+    clear();
+}
+
+string&
+Profile::ProfileState::text(const Record& r)
+{
+    if (_text == NULL)
+	_text = new string[_capacity];
+
+    return _text[&r - _ring];
+}
+
+const Profile::Record*
+Profile::ProfileState::next_record()
+{
+    if (_read >= _count)
+	return NULL;
+
+    size_t slot = (_head + _capacity - _count + _read) % _capacity;
+    _read++;
+
+    return &_ring[slot];
+}
+
 Profile::Profile()
     : _profile_cnt(0)
 {
@@ -38,15 +92,22 @@ Profile::Profile()
 
 Profile::~Profile()
 {
-    while (!_profiles.empty()) {
-	profiles::iterator i = _profiles.begin();
-	i->second->zap();
-	_profiles.erase(i);
-    }
+}
+
+Profile::ProfileState&
+Profile::find(const string& pname) const throw(PVariableUnknown)
+{
+    profiles::const_iterator i = _profiles.find(pname);
+
+    // Catch any mispelt pnames.
+    if (i == _profiles.end())
+	xorp_throw(PVariableUnknown, pname.c_str());
+
+    return *i->second;
 }
 
 void
-Profile::create(const string& pname, const string& comment)
+Profile::create(const string& pname, const string& comment, size_t log_size)
     throw(PVariableExists)
 {
     // Catch initialization problems.
@@ -55,117 +116,200 @@ Profile::create(const string& pname, const string& comment)
 	xorp_throw(PVariableExists, pname.c_str());
 #endif
 
-    ProfileState *p = new ProfileState(comment, false, false, new logentries);
+    XLOG_ASSERT(log_size > 0);
+    ProfileState *p = new ProfileState(comment, log_size);
     _profiles[pname] = ref_ptr<ProfileState>(p);
 }
 
+uint64_t
+Profile::timestamp()
+{
+    TimeVal tv;
+
+#if defined(HAVE_CLOCK_GETTIME) && defined(HAVE_CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (::clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+	return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+    TimerList::system_gettimeofday(&tv);
+
+    return uint64_t(tv.sec()) * 1000000000 + uint64_t(tv.usec()) * 1000;
+}
+
 void
 Profile::log(const string& pname, string comment)
     throw(PVariableUnknown,PVariableNotEnabled)
 {
-    profiles::iterator i = _profiles.find(pname);
+    ProfileState& ps = find(pname);
 
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    // In order to be logging, we must be enabled.
+    if (!ps.enabled())
+	xorp_throw(PVariableNotEnabled, pname.c_str());
+
+    uint64_t now = timestamp();
+    if (ps.histogram_mode()) {
+	if (ps.last() != 0)
+	    ps.histogram().add(now - ps.last());
+	ps.set_last(now);
+	return;
+    }
+
+    Record& r = ps.append();
+    r.time = now;
+    r.event = NULL;
+    r.value = 0;
+    r.addr_len = 0;
+    ps.text(r).assign(comment);
+}
+
+Profile::Record*
+Profile::append(const string& pname)
+    throw(PVariableUnknown,PVariableNotEnabled)
+{
+    ProfileState& ps = find(pname);
 
     // In order to be logging, we must be enabled.
-    if (!i->second->enabled())
+    if (!ps.enabled())
 	xorp_throw(PVariableNotEnabled, pname.c_str());
-    
-#if	0
-    // Make sure that this variable is not locked.
-    if (!i->second->locked())
-	xorp_throw(PVariableLocked, pname.c_str());
-#endif
-    
-    TimeVal tv;
-    TimerList::system_gettimeofday(&tv);
-    i->second->logptr()->push_back(ProfileLogEntry(tv, comment));
+
+    uint64_t now = timestamp();
+    if (ps.histogram_mode()) {
+	if (ps.last() != 0)
+	    ps.histogram().add(now - ps.last());
+	ps.set_last(now);
+	return NULL;
+    }
+
+    Record& r = ps.append();
+    r.time = now;
+
+    return &r;
 }
 
 void
-Profile::enable(const string& pname) throw(PVariableUnknown,PVariableLocked)
+Profile::log_event(const string& pname, const char* event, uint64_t value)
+    throw(PVariableUnknown,PVariableNotEnabled)
 {
-    profiles::iterator i = _profiles.find(pname);
+    ProfileState& ps = find(pname);
 
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    // In order to be logging, we must be enabled.
+    if (!ps.enabled())
+	xorp_throw(PVariableNotEnabled, pname.c_str());
+
+    if (ps.histogram_mode()) {
+	ps.histogram().add(value);
+	return;
+    }
+
+    Record& r = ps.append();
+    r.time = timestamp();
+    r.event = event;
+    r.value = value;
+    r.addr_len = 0;
+}
+
+void
+Profile::enable(const string& pname) throw(PVariableUnknown,PVariableLocked)
+{
+    ProfileState& ps = find(pname);
 
     // If this profile name is already enabled, get out of here
     // without updating the counter.
-    if (i->second->enabled())
+    if (ps.enabled())
 	return;
 
     // Don't allow a locked entry to be enabled.
-    if (i->second->locked())
+    if (ps.locked())
 	xorp_throw(PVariableLocked, pname.c_str());
     
-    i->second->set_enabled(true);
+    ps.allocate();
+    ps.set_enabled(true);
     _profile_cnt++;
 }
 
 void
 Profile::disable(const string& pname) throw(PVariableUnknown)
 {
-    profiles::iterator i = _profiles.find(pname);
-
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    ProfileState& ps = find(pname);
 
     // If this profile name is already disabled, get out of here
     // without updating the counter.
-    if (!i->second->enabled())
+    if (!ps.enabled())
 	return;
-    i->second->set_enabled(false);
+    ps.set_enabled(false);
     _profile_cnt--;
 }
 
 void
-Profile::lock_log(const string& pname) throw(PVariableUnknown,PVariableLocked)
+Profile::set_histogram(const string& pname, bool histogram)
+    throw(PVariableUnknown,PVariableLocked)
 {
-    profiles::iterator i = _profiles.find(pname);
+    ProfileState& ps = find(pname);
 
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    // Don't change the mode while the log is being read.
+    if (ps.locked())
+	xorp_throw(PVariableLocked, pname.c_str());
+
+    if (ps.histogram_mode() == histogram)
+	return;
+    ps.set_histogram_mode(histogram);
+    ps.histogram().clear();
+    ps.set_last(0);
+}
+
+string
+Profile::get_histogram(const string& pname) const throw(PVariableUnknown)
+{
+    return find(pname).histogram().str();
+}
+
+void
+Profile::lock_log(const string& pname) throw(PVariableUnknown,PVariableLocked)
+{
+    ProfileState& ps = find(pname);
 
     // Don't allow a locked entry to be locked again.
-    if (i->second->locked())
+    if (ps.locked())
 	xorp_throw(PVariableLocked, pname.c_str());
 
     // Disable logging.
     disable(pname);
 
     // Lock the entry
-    i->second->set_locked(true);
+    ps.set_locked(true);
 
-    i->second->set_iterator(i->second->logptr()->begin());
+    ps.rewind();
 }
 
 bool 
 Profile::read_log(const string& pname, ProfileLogEntry& entry) 
     throw(PVariableUnknown,PVariableNotLocked)
 {
-    profiles::iterator i = _profiles.find(pname);
-
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    ProfileState& ps = find(pname);
 
     // Verify that the log entry is locked
-    if (!i->second->locked())
+    if (!ps.locked())
 	xorp_throw(PVariableNotLocked, pname.c_str());
 
-    logentries::iterator li;
-    i->second->get_iterator(li);
-    if (li == i->second->logptr()->end())
+    const Record* r = ps.next_record();
+    if (r == NULL)
 	return false;
 
-    entry = *li;
-    i->second->set_iterator(++li);
+    TimeVal time(r->time / 1000000000, (r->time % 1000000000) / 1000);
+
+    if (r->event == NULL)
+	entry = ProfileLogEntry(time, ps.text(*r));
+    else {
+	string net;
+	if (r->addr_len == IPv4::addr_bytelen())
+	    net = " " + IPNet<IPv4>(IPv4(r->addr), r->prefix_len).str();
+	else if (r->addr_len == IPv6::addr_bytelen())
+	    net = " " + IPNet<IPv6>(IPv6(r->addr), r->prefix_len).str();
+	entry = ProfileLogEntry(time,
+				c_format("%s%s %llu", r->event, net.c_str(),
+					 (unsigned long long)r->value));
+    }
 
     return true;
 }
@@ -174,69 +318,42 @@ void
 Profile::release_log(const string& pname) 
     throw(PVariableUnknown,PVariableNotLocked)
 {
-    profiles::iterator i = _profiles.find(pname);
-
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    ProfileState& ps = find(pname);
 
     // Verify that the log entry is locked
-    if (!i->second->locked())
+    if (!ps.locked())
 	xorp_throw(PVariableNotLocked, pname.c_str());
 
     // Unlock the entry
-    i->second->set_locked(false);
+    ps.set_locked(false);
 }
 
 void
 Profile::clear(const string& pname) throw(PVariableUnknown,PVariableLocked)
 {
-    profiles::iterator i = _profiles.find(pname);
-
-    // Catch any mispelt pnames.
-    if (i == _profiles.end())
-	xorp_throw(PVariableUnknown, pname.c_str());
+    ProfileState& ps = find(pname);
 
     // Don't allow a locked entry to be cleared.
-    if (i->second->locked())
+    if (ps.locked())
 	xorp_throw(PVariableLocked, pname.c_str());
 
-    i->second->logptr()->clear();
+    ps.clear();
+    ps.histogram().clear();
+    ps.set_last(0);
 }
 
-#if 0
-class List: public unary_function<pair<const string, 
-				       ref_ptr<Profile::ProfileState> >,
-				  void> {
- public:
-    void operator()(const pair<const string, ref_ptr<Profile::ProfileState> >& p) {
-	_result += p.first;
-	_result += "\t";
-	_result += c_format("%d", p.second->size());
-	_result += "\t";
-	_result += p.second->enabled() ? "enabled" : "disabled";
-	_result += "\t";
-	_result += p.second->comment();
-	_result += "\n";
-    }
-
-    string result() const {
-	return _result;
-    }
- private:
-    string _result;
-};
-#endif
-
 string
 Profile::get_list() const
 {
     ostringstream oss;
     profiles::const_iterator i = _profiles.begin();
     while (i != _profiles.end()) {
-	oss << i->first << "\t" << i->second->size() << "\t"
-	    << (i->second->enabled() ? "enabled" : "disabled")
-	    << "\t" << i->second->comment() << "\n";
+	const ProfileState& ps = *i->second;
+	oss << i->first << "\t"
+	    << (ps.histogram_mode() ? ps.histogram().count() : ps.size())
+	    << "\t" << (ps.enabled() ? "enabled" : "disabled")
+	    << (ps.histogram_mode() ? " histogram" : "")
+	    << "\t" << ps.comment() << "\n";
 	i++;
     }
     return oss.str();
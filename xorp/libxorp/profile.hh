@@ -38,7 +38,9 @@
 #include "xorp.h"
 #include "timeval.hh"
 #include "exceptions.hh"
+#include "ipnet.hh"
 #include "ref_ptr.hh"
+#include "histogram.hh"
 
 /**
  * Container keyed by profile variable holding log entries.
@@ -100,47 +102,127 @@ class ProfileLogEntry {
 /**
  * Support for profiling XORP. Save the time that an event occured for
  * later retrieval.
+ *
+ * Each profile variable records into a fixed-size ring buffer, which is
+ * allocated when the variable is first enabled.  A record holds a
+ * monotonic timestamp, a small numeric payload and optionally a
+ * network, so logging does not allocate: the text of an entry is only
+ * formatted when the log is read.  When the ring is full the oldest records are overwritten.
+ *
+ * In histogram mode, a variable does not keep records but counts its
+ * samples in power of two buckets, to measure latencies online.
  */
 class Profile {
  public:
-    typedef list<ProfileLogEntry> logentries;	// Profiling info
+    /**
+     * A binary log record.
+     */
+    struct Record {
+	uint64_t	time;	// Monotonic time, in nanoseconds.
+	const char*	event;	// Static description, or NULL for text.
+	uint64_t	value;	// The numeric payload.
+	uint8_t		addr_len;	// Bytes of the network, 0 if none.
+	uint8_t		prefix_len;	// Prefix length of the network.
+	uint8_t		addr[16];	// Address of the network.
+    };
+
+    /**
+     * An online histogram of samples, in power of two buckets.
+     */
+    typedef Log2Histogram Histogram;
 
-    class ProfileState {
+    class ProfileState : public NONCOPYABLE {
     public:
-	ProfileState() : _enabled(false), _locked(false), _log(NULL) {}
-	ProfileState(const string& comment, bool enabled, bool locked,
-		     logentries *log) 
-	    : _comment(comment), _enabled(enabled), _locked(locked), _log(log)
+	ProfileState(const string& comment, size_t capacity)
+	    : _comment(comment), _enabled(false), _locked(false),
+	      _histogram_mode(false), _capacity(capacity), _ring(NULL),
+	      _text(NULL), _head(0), _count(0), _overruns(0), _read(0),
+	      _last(0)
 	{}
+	~ProfileState() { zap(); }
+
 	void set_enabled(bool v) { _enabled = v; }
 	bool enabled() const { return _enabled; }
 	void set_locked(bool v) { _locked = v; }
 	bool locked() const { return _locked; }
-	logentries *logptr() const { return _log; }
-	void zap() const { delete _log; }
-	void set_iterator(const logentries::iterator& i) { _i = i; }
-	void get_iterator(logentries::iterator& i) { i = _i; }
-	int size() const { return _log->size(); }
+	void set_histogram_mode(bool v) { _histogram_mode = v; }
+	bool histogram_mode() const { return _histogram_mode; }
+	void zap();
+	int size() const { return _count; }
+	size_t overruns() const { return _overruns; }
 	const string& comment() const {return _comment;}
+	Histogram& histogram() { return _histogram; }
+	const Histogram& histogram() const { return _histogram; }
+
+	/**
+	 * Allocate the ring buffer if it isn't already.
+	 */
+	void allocate();
+
+	/**
+	 * Append a record to the ring, overwriting the oldest if full.
+	 *
+	 * @return the record to fill in.
+	 */
+	Record& append() {
+	    size_t slot = _head;
+	    if (++_head == _capacity)
+		_head = 0;
+	    if (_count < _capacity)
+		_count++;
+	    else
+		_overruns++;
+	    return _ring[slot];
+	}
+
+	/**
+	 * @return the text slot of a record.
+	 */
+	string& text(const Record& r);
+
+	void clear() { _head = _count = _overruns = _read = 0; }
+	void rewind() { _read = 0; }
+	const Record* next_record();
+
+	uint64_t last() const { return _last; }
+	void set_last(uint64_t t) { _last = t; }
 
     private:
 	const string _comment;	// Textual description of this variable.
 	bool _enabled;		// True, if profiling is enabled.
 	bool _locked;		// True, if we are currently reading the log.
-	logentries::iterator _i;// pointer into the log
-	logentries *_log;
+	bool _histogram_mode;	// True, if samples go to the histogram.
+	size_t _capacity;	// The number of records in the ring.
+	Record* _ring;		// The records.
+	string* _text;		// The text of the records logged as text.
+	size_t _head;		// The next record to write.
+	size_t _count;		// The number of valid records.
+	size_t _overruns;	// The number of records overwritten.
+	size_t _read;		// The number of records read.
+	uint64_t _last;		// Time of the last event, for histograms.
+	Histogram _histogram;
     };
 
     typedef map<string, ref_ptr<ProfileState> > profiles;
 
+    /**
+     * The default number of records of a profile variable.
+     */
+    static const size_t DEFAULT_LOG_SIZE = 16384;
+
     Profile();
 
     ~Profile();
 
     /**
      * Create a new profile variable.
+     *
+     * @param pname the profile variable.
+     * @param comment a description of the variable.
+     * @param log_size the number of records the log keeps.
      */
-    void create(const string& pname, const string& comment = "")
+    void create(const string& pname, const string& comment = "",
+		size_t log_size = DEFAULT_LOG_SIZE)
 	throw(PVariableExists);
 
     /**
@@ -167,10 +249,74 @@ class Profile {
 
     /**
      * Add an entry to the profile log.
+     *
+     * The text is copied into the log.  In histogram mode, the time
+     * since the previous entry is counted instead.
      */
     void log(const string& pname, string comment)
 	throw(PVariableUnknown,PVariableNotEnabled);
 
+    /**
+     * Add a binary entry to the profile log.
+     *
+     * Nothing is formatted or allocated: the entry is read as the event
+     * followed by the value.  In histogram mode, the value is counted
+     * in the histogram instead.
+     *
+     * @param pname the profile variable.
+     * @param event a description of the event, which must be a static
+     * string.
+     * @param value the numeric payload.
+     */
+    void log_event(const string& pname, const char* event, uint64_t value = 0)
+	throw(PVariableUnknown,PVariableNotEnabled);
+
+    /**
+     * Add a binary entry about a network to the profile log.
+     *
+     * Nothing is formatted or allocated: the entry is read as the event,
+     * the network and the value.  In histogram mode, the time since the
+     * previous entry is counted instead.
+     *
+     * @param pname the profile variable.
+     * @param event a description of the event, which must be a static
+     * string.
+     * @param net the network.
+     * @param value the numeric payload.
+     */
+    template <class A>
+    void log_net(const string& pname, const char* event,
+		 const IPNet<A>& net, uint64_t value = 0)
+	throw(PVariableUnknown,PVariableNotEnabled) {
+	Record* r = append(pname);
+	if (r == NULL)
+	    return;
+	r->event = event;
+	r->value = value;
+	r->addr_len = A::addr_bytelen();
+	r->prefix_len = net.prefix_len();
+	net.masked_addr().copy_out(r->addr);
+    }
+
+    /**
+     * Add the time elapsed since a timestamp to the profile log.
+     *
+     * @param pname the profile variable.
+     * @param event a description of the event, which must be a static
+     * string.
+     * @param start the time the measured operation started, as returned
+     * by @ref timestamp().
+     */
+    void log_latency(const string& pname, const char* event, uint64_t start)
+	throw(PVariableUnknown,PVariableNotEnabled) {
+	log_event(pname, event, timestamp() - start);
+    }
+
+    /**
+     * @return the current monotonic time in nanoseconds.
+     */
+    static uint64_t timestamp();
+
     /**
      * Enable tracing.
      *
@@ -185,6 +331,22 @@ class Profile {
      */
     void disable(const string& pname) throw(PVariableUnknown);
 
+    /**
+     * Select between logging records and counting them in a histogram.
+     *
+     * @param pname the profile variable.
+     * @param histogram true to count the samples in a histogram.
+     */
+    void set_histogram(const string& pname, bool histogram)
+	throw(PVariableUnknown,PVariableLocked);
+
+    /**
+     * @param pname the profile variable.
+     * @return the histogram of the variable, as text.
+     */
+    string get_histogram(const string& pname) const
+	throw(PVariableUnknown);
+
     /**
      * Lock the log in preparation for reading log entries.
      */
@@ -218,6 +380,17 @@ class Profile {
     string get_list() const;
 
  private:
+    ProfileState& find(const string& pname) const throw(PVariableUnknown);
+
+    /**
+     * Append a record to the log of an entry whose time is the time
+     * since the previous entry in histogram mode.
+     *
+     * @return the record to fill in, or NULL in histogram mode.
+     */
+    Record* append(const string& pname)
+	throw(PVariableUnknown,PVariableNotEnabled);
+
     int _profile_cnt;		// Number of variables that are enabled.
     profiles _profiles;
 };
@@ -288,6 +288,197 @@ protected:
     mutable int32_t _M_index;	// index in ref_counter_pool
 };
 
+/**
+ * @short Base class for objects counted by iref_ptr.
+ *
+ * Objects that derive from ref_counted keep their own reference count,
+ * so @ref iref_ptr copies only touch the object they point to.  Copying
+ * a ref_counted object does not copy the count: the copy starts
+ * unreferenced.
+ */
+class ref_counted {
+public:
+    ref_counted() : _ref_count(0) {}
+    ref_counted(const ref_counted&) : _ref_count(0) {}
+    ref_counted& operator=(const ref_counted&) { return *this; }
+
+    /**
+     * @return the number of iref_ptr objects referring to this object.
+     */
+    int32_t ref_count() const { return _ref_count; }
+
+protected:
+    ~ref_counted() {}
+
+private:
+    mutable int32_t _ref_count;
+
+    template <class _Tp> friend class iref_ptr;
+};
+
+/**
+ * @short Intrusive Reference Counted Pointer Class.
+ *
+ * The iref_ptr class has the same interface as ref_ptr, but the object
+ * it points to must derive from @ref ref_counted, which holds the
+ * reference count.  In contrast to the ref_ptr class, there is no shared
+ * table of counters: copying or releasing a pointer only touches the
+ * object itself, which is likely to be in the cache already.  Also, an
+ * iref_ptr can safely be created from a raw pointer to an object that
+ * is already referenced by other iref_ptr objects.
+ */
+template <class _Tp>
+class iref_ptr {
+public:
+    /**
+     * Construct a reference pointer for object.
+     *
+     * @param p pointer to object to be reference counted.  p must be
+     * allocated using operator new as it will be destructed using delete
+     * when the reference count reaches zero.
+     */
+    iref_ptr(_Tp* __p = 0)
+	: _M_ptr(__p)
+    {
+	if (_M_ptr)
+	    counted(_M_ptr)->_ref_count++;
+    }
+
+    /**
+     * Copy Constructor
+     *
+     * Constructs a reference pointer for object.  Raises reference count
+     * associated with object by 1.
+     */
+    iref_ptr(const iref_ptr& __r)
+	: _M_ptr(0) {
+	ref(&__r);
+    }
+
+    /**
+     * Assignment Operator
+     *
+     * Assigns reference pointer to new object.
+     */
+    iref_ptr& operator=(const iref_ptr& __r) {
+	if (&__r != this) {
+	    // XXX: take the new reference first, __r may be owned by the
+	    // object we release.
+	    _Tp* old = _M_ptr;
+	    ref(&__r);
+	    unref(old);
+	}
+	return *this;
+    }
+
+    /**
+     * Destruct reference pointer instance and lower reference count on
+     * object being tracked.  The object being tracked will be deleted if
+     * the reference count falls to zero because of the destruction of the
+     * reference pointer.
+     */
+    ~iref_ptr() {
+	unref(_M_ptr);
+    }
+
+    /**
+     * Dereference reference counted object.
+     * @return reference to object.
+     */
+    _Tp& operator*() const { return *_M_ptr; }
+
+    /**
+     * Dereference pointer to reference counted object.
+     * @return pointer to object.
+     */
+    _Tp* operator->() const { return _M_ptr; }
+
+    /**
+     * Dereference pointer to reference counted object.
+     * @return pointer to object.
+     */
+    _Tp* get() const { return _M_ptr; }
+
+#ifdef XORP_USE_USTL
+
+    // Compare pointed-to items.
+    bool operator==(const iref_ptr& rp) const {
+	if (_M_ptr == rp._M_ptr)
+	    return true;
+	if (_M_ptr && rp._M_ptr)
+	    return (*_M_ptr == *rp._M_ptr);
+	return false;
+    }
+
+#else
+    /**
+     * Equality Operator
+     * @return true if reference pointers refer to same object.
+     */
+    bool operator==(const iref_ptr& rp) const { return _M_ptr == rp._M_ptr; }
+#endif
+
+    /**
+     * Check if reference pointer refers to an object or whether it has
+     * been assigned a null object.
+     * @return true if reference pointer refers to a null object.
+     */
+    bool is_empty() const { return _M_ptr == 0; }
+
+    /**
+     * @return true if reference pointer represents only reference to object.
+     */
+    bool is_only() const {
+	return _M_ptr && counted(_M_ptr)->_ref_count == 1;
+    }
+
+    /**
+     * @param n minimum count.
+     * @return true if there are at least n references to object.
+     */
+    bool at_least(int32_t n) const {
+	return _M_ptr && counted(_M_ptr)->_ref_count >= n;
+    }
+
+    /**
+     * Release reference on object.  The reference pointers underlying
+     * object is set to null, and the former object is destructed if
+     * necessary.
+     */
+    void release() const {
+	_Tp* old = _M_ptr;
+	_M_ptr = 0;
+	unref(old);
+    }
+    /* mimic functionality of boost weak_ptr, same as release()
+     */
+    void reset() const { release(); }
+
+private:
+    static const ref_counted* counted(const _Tp* __p) {
+	return static_cast<const ref_counted*>(__p);
+    }
+
+    /**
+     * Add reference.
+     */
+    void ref(const iref_ptr* __r) const {
+	_M_ptr = __r->_M_ptr;
+	if (_M_ptr)
+	    counted(_M_ptr)->_ref_count++;
+    }
+
+    /**
+     * Remove reference.
+     */
+    static void unref(_Tp* __p) {
+	if (__p && --counted(__p)->_ref_count == 0)
+	    delete __p;
+    }
+
+    mutable _Tp*    _M_ptr;
+};
+
 #if 0
 template <typename _Tp>
 ref_ptr<const _Tp>::ref_ptr(const ref_ptr<_Tp>& __r)
@@ -33,6 +33,7 @@
 #include "xlog.h"
 #include "debug.h"
 #include "minitraits.hh"
+#include "memory_pool.hh"
 #include "stack"
 
 
@@ -80,7 +81,7 @@ public:
     RefTrieNode() : _up(0), _left(0), _right(0), _k(Key()), _p(0),
 	_references(0){}
     RefTrieNode(const Key& key, const Payload& p, RefTrieNode* up = 0) :
-	_up(up), _left(0), _right(0), _k(key), _p(new PPayload(p)),
+	_up(up), _left(0), _right(0), _k(key), _p(new_payload(p)),
 	_references(0) {}
 
     RefTrieNode(const Key& key, RefTrieNode* up = 0) :
@@ -95,6 +96,15 @@ public:
 	    delete_payload(_p);
     }
 
+    /**
+     * Nodes are allocated from the slab shared by all the objects of
+     * their size class.
+     */
+    void* operator new(size_t size) {
+	return SlabAllocator::size_class(size).alloc();
+    }
+    void operator delete(void* ptr)	{ SlabAllocator::free(ptr); }
+
     /**
      * add a node to a subtree
      * @return a pointer to the node.
@@ -135,6 +145,15 @@ public:
     RefTrieNode* get_right()                      { return this->_right;  }
     RefTrieNode* get_parent()                     { return this->_up;   }
 
+    /**
+     * @return the number of nodes in the subtree, including the
+     * nodes without a payload.
+     */
+    size_t node_count() const {
+	return 1 + (_left ? _left->node_count() : 0)
+	    + (_right ? _right->node_count() : 0);
+    }
+
     bool has_payload() const			{ return _p != NULL;	}
     bool has_active_payload() const
     {
@@ -146,7 +165,7 @@ public:
     void set_payload(const Payload& p) {
 	if (_p)
 	    delete_payload(_p);
-	_p = new PPayload(p);
+	_p = new_payload(p);
 	// clear the DELETED flag
 	_references ^= _references & NODE_DELETED;
     }
@@ -325,9 +344,25 @@ public:
     }
 
 private:
+    /*
+     * Small payloads are allocated from the slab of their size class,
+     * rather than with a malloc() each.
+     */
+    static PPayload* new_payload(const Payload& p) {
+	if (sizeof(PPayload) > SlabAllocator::MAX_SIZE_CLASS)
+	    return new PPayload(p);
+	void* mem = SlabAllocator::size_class(sizeof(PPayload)).alloc();
+	return ::new (mem) PPayload(p);
+    }
+
     /* delete_payload is a separate method to allow specialization */
     void delete_payload(Payload* p) {
-	delete p;
+	if (sizeof(PPayload) > SlabAllocator::MAX_SIZE_CLASS) {
+	    delete p;
+	    return;
+	}
+	p->~Payload();
+	SlabAllocator::free(const_cast<PPayload*>(p));
     }
 
 
@@ -1033,6 +1068,14 @@ public:
 #endif // compatibility
     int route_count() const			{ return _payload_count; }
 
+    /**
+     * @return the number of nodes, which is found by walking the
+     * whole trie.
+     */
+    size_t node_count() const {
+	return _root ? _root->node_count() : 0;
+    }
+
     void print() const;
     string str() const;
 
@@ -33,9 +33,16 @@
 #include "libxorp/clock.hh"
 #include "libxorp/eventloop.hh"
 #include "libxorp/utility.h"
+#include "libxorp/dispatch_stats.hh"
 
 #include "selector.hh"
 
+#ifdef XORP_USE_EPOLL
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#endif
+
 
 // ----------------------------------------------------------------------------
 // Helper function to deal with translating between old and new
@@ -196,7 +203,10 @@ SelectorList::Node::run_hooks(SelectorMask m, XorpFd fd)
 	SelectorMask match = SelectorMask(_mask[i] & m & ~already_matched);
 	if (match) {
 	    assert(_cb[i].is_empty() == false);
-	    _cb[i]->dispatch(fd, _iot[i]);
+	    {
+		DispatchProbe probe(DispatchStats::IO_EVENT, _cb[i].get());
+		_cb[i]->dispatch(fd, _iot[i]);
+	    }
 	    assert(magic == GOOD_NODE_MAGIC);
 	    n++;
 	}
@@ -235,21 +245,103 @@ SelectorList::Node::is_empty()
 // the call to dispatch().
 // Seems like a lot of pain to fix this right, so in the meantime, will pre-allocate
 // logs of space in the selector_entries vector in hopes we do not have to resize.
-SelectorList::SelectorList(ClockBase *clock)
-    : _clock(clock), _observer(NULL), _testfds_n(0), _last_served_fd(-1),
+SelectorList::SelectorList(ClockBase *clock, Backend backend)
+    : _clock(clock), _observer(NULL), _backend(BACKEND_SELECT),
+      _testfds_n(0), _last_served_fd(-1),
       _last_served_sel(-1),
       // XXX: Preallocate to work around use-after-free in Node::run_hooks().
       _selector_entries(1024),
       _maxfd(0), _descriptor_count(0), _is_debug(false)
+#ifdef XORP_USE_EPOLL
+      , _epfd(-1)
+#endif
 {
     x_static_assert(SEL_RD == (1 << SEL_RD_IDX) && SEL_WR == (1 << SEL_WR_IDX)
 		  && SEL_EX == (1 << SEL_EX_IDX) && SEL_MAX_IDX == 3);
     for (int i = 0; i < SEL_MAX_IDX; i++)
 	FD_ZERO(&_fds[i]);
+
+#ifdef XORP_USE_EPOLL
+    if (backend == BACKEND_EPOLL) {
+	// XXX: the size argument is only a hint, but must be positive.
+	_epfd = epoll_create(1024);
+	if (_epfd < 0) {
+	    XLOG_WARNING("epoll_create() failed, falling back to select(): %s",
+			 strerror(errno));
+	} else {
+	    fcntl(_epfd, F_SETFD, FD_CLOEXEC);
+	    _backend = BACKEND_EPOLL;
+	    _epoll_interest.resize(_selector_entries.size(), 0);
+	    _ready_mask.resize(_selector_entries.size(), 0);
+	    _epoll_events.resize(64);
+	}
+    }
+#else
+    UNUSED(backend);
+#endif
 }
 
 SelectorList::~SelectorList()
 {
+#ifdef XORP_USE_EPOLL
+    if (_epfd >= 0)
+	close(_epfd);
+#endif
+}
+
+SelectorList::Backend
+SelectorList::default_backend()
+{
+    const char* value = getenv("XORP_SELECTOR");
+
+    if ((value != NULL) && (strcmp(value, "select") == 0))
+	return (BACKEND_SELECT);
+    if (backend_supported(BACKEND_EPOLL))
+	return (BACKEND_EPOLL);
+    return (BACKEND_SELECT);
+}
+
+bool
+SelectorList::backend_supported(Backend backend)
+{
+    switch (backend) {
+    case BACKEND_SELECT:
+	return (true);
+    case BACKEND_EPOLL:
+#ifdef XORP_USE_EPOLL
+	return (true);
+#else
+	return (false);
+#endif
+    }
+    return (false);
+}
+
+const char*
+SelectorList::backend_name() const
+{
+    switch (_backend) {
+    case BACKEND_SELECT:
+	return ("select");
+    case BACKEND_EPOLL:
+	return ("epoll");
+    }
+    return ("unknown");
+}
+
+void
+SelectorList::grow_entries(size_t n)
+{
+    if (n <= _selector_entries.size())
+	return;
+
+    _selector_entries.resize(n);
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL) {
+	_epoll_interest.resize(n, 0);
+	_ready_mask.resize(n, 0);
+    }
+#endif
 }
 
 bool
@@ -270,10 +362,16 @@ SelectorList::add_ioevent_cb(XorpFd		fd,
 		   "descriptor (fd = %s)\n", fd.str().c_str());
     }
 
+    if ((_backend == BACKEND_SELECT) && (fd.getSocket() >= FD_SETSIZE)) {
+	XLOG_ERROR("SelectorList::add_ioevent_cb: file descriptor %d "
+		   "exceeds FD_SETSIZE (%d)", (int)fd, FD_SETSIZE);
+	return false;
+    }
+
     if (fd.getSocket() >= _maxfd) {
 	_maxfd = fd;
 	if ((size_t)fd >= _selector_entries.size()) {
-	    _selector_entries.resize(fd + 32);
+	    grow_entries(fd + 32);
 	}
     }
 
@@ -281,12 +379,21 @@ SelectorList::add_ioevent_cb(XorpFd		fd,
     if (_selector_entries[fd].add_okay(mask, type, cb, priority) == false) {
 	return false;
     }
+
+#ifdef XORP_USE_EPOLL
+    if ((_backend == BACKEND_EPOLL) && (epoll_update(fd) == false)) {
+	_selector_entries[fd].clear(mask);
+	return false;
+    }
+#endif
+
     if (no_selectors_with_fd)
 	_descriptor_count++;
 
     for (int i = 0; i < SEL_MAX_IDX; i++) {
 	if (mask & (1 << i)) {
-	    FD_SET(fd, &_fds[i]);
+	    if (_backend == BACKEND_SELECT)
+		FD_SET(fd, &_fds[i]);
 	    if (_observer) _observer->notify_added(fd, mask);
 	}
     }
@@ -309,9 +416,10 @@ SelectorList::remove_ioevent_cb(XorpFd fd, IoEventType type)
     SelectorMask mask = map_ioevent_to_selectormask(type);
 
     for (int i = 0; i < SEL_MAX_IDX; i++) {
-	if (mask & (1 << i) && FD_ISSET(fd, &_fds[i])) {
+	if (mask & (1 << i) && _selector_entries[fd]._mask[i]) {
 	    found = true;
-	    FD_CLR(fd, &_fds[i]);
+	    if (_backend == BACKEND_SELECT)
+		FD_CLR(fd, &_fds[i]);
 	    if (_observer)
 		_observer->notify_removed(fd, ((SelectorMask) (1 << i)));
 	}
@@ -322,10 +430,16 @@ SelectorList::remove_ioevent_cb(XorpFd fd, IoEventType type)
     }
 
     _selector_entries[fd].clear(mask);
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL)
+	epoll_update(fd);
+#endif
     if (_selector_entries[fd].is_empty()) {
-	assert(FD_ISSET(fd, &_fds[SEL_RD_IDX]) == 0);
-	assert(FD_ISSET(fd, &_fds[SEL_WR_IDX]) == 0);
-	assert(FD_ISSET(fd, &_fds[SEL_EX_IDX]) == 0);
+	if (_backend == BACKEND_SELECT) {
+	    assert(FD_ISSET(fd, &_fds[SEL_RD_IDX]) == 0);
+	    assert(FD_ISSET(fd, &_fds[SEL_WR_IDX]) == 0);
+	    assert(FD_ISSET(fd, &_fds[SEL_EX_IDX]) == 0);
+	}
 	_descriptor_count--;
     }
 }
@@ -333,19 +447,28 @@ SelectorList::remove_ioevent_cb(XorpFd fd, IoEventType type)
 bool
 SelectorList::ready()
 {
-    fd_set testfds[SEL_MAX_IDX];
     int n = 0;
 
-    memcpy(testfds, _fds, sizeof(_fds));
-    struct timeval tv_zero;
-    tv_zero.tv_sec = 0;
-    tv_zero.tv_usec = 0;
-
-    n = ::select(_maxfd + 1,
-		 &testfds[SEL_RD_IDX],
-		 &testfds[SEL_WR_IDX],
-		 &testfds[SEL_EX_IDX],
-		 &tv_zero);
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL) {
+	struct epoll_event ev;
+	n = epoll_wait(_epfd, &ev, 1, 0);
+    } else
+#endif
+    {
+	fd_set testfds[SEL_MAX_IDX];
+
+	memcpy(testfds, _fds, sizeof(_fds));
+	struct timeval tv_zero;
+	tv_zero.tv_sec = 0;
+	tv_zero.tv_usec = 0;
+
+	n = ::select(_maxfd + 1,
+		     &testfds[SEL_RD_IDX],
+		     &testfds[SEL_WR_IDX],
+		     &testfds[SEL_EX_IDX],
+		     &tv_zero);
+    }
 
     if (n < 0) {
 	switch (errno) {
@@ -380,13 +503,20 @@ SelectorList::do_select(struct timeval* to, bool force)
 
     _maxpri_fd = _maxpri_sel = -1;
 
-    memcpy(_testfds, _fds, sizeof(_fds));
-
-    _testfds_n = ::select(_maxfd + 1,
-		          &_testfds[SEL_RD_IDX],
-		          &_testfds[SEL_WR_IDX],
-		          &_testfds[SEL_EX_IDX],
-		          to);
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL) {
+	_testfds_n = do_epoll(to);
+    } else
+#endif
+    {
+	memcpy(_testfds, _fds, sizeof(_fds));
+
+	_testfds_n = ::select(_maxfd + 1,
+			      &_testfds[SEL_RD_IDX],
+			      &_testfds[SEL_WR_IDX],
+			      &_testfds[SEL_EX_IDX],
+			      to);
+    }
 
     if (!to || to->tv_sec > 0)
 	    _clock->advance_time();
@@ -426,6 +556,11 @@ SelectorList::get_ready_priority(bool force)
     if (_maxpri_fd != -1)
 	return _selector_entries[_maxpri_fd]._priority[_maxpri_sel];
 
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL)
+	return epoll_ready_priority();
+#endif
+
     int max_priority = XorpTask::PRIORITY_INFINITY;
 
     //
@@ -499,14 +634,14 @@ SelectorList::wait_and_dispatch(TimeVal& timeout)
     // I cannot figure out how this assert could happen..unless maybe there is some re-entry issue or
     // similar.  Going to deal with things as best as possible w/out asserting.
     // TODO:  Re-write this logic entirely to be less crufty all around.
-    if (!(FD_ISSET(_maxpri_fd, &_testfds[_maxpri_sel]))) {
+    if (! is_pending(_maxpri_fd, _maxpri_sel)) {
 	_testfds_n = 0;
 	_maxpri_fd = -1;
 	_maxpri_sel = -1;
 	return 0;
     }
 
-    FD_CLR(_maxpri_fd, &_testfds[_maxpri_sel]);
+    clear_pending(_maxpri_fd, _maxpri_sel);
 
     SelectorMask sm = SEL_NONE;
 
@@ -549,9 +684,48 @@ SelectorList::wait_and_dispatch(int millisecs)
     return wait_and_dispatch(t);
 }
 
+bool
+SelectorList::is_pending(int fd, int sel_idx) const
+{
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL)
+	return ((_ready_mask[fd] & (1 << sel_idx)) != 0);
+#endif
+    return (FD_ISSET(fd, &_testfds[sel_idx]));
+}
+
+void
+SelectorList::clear_pending(int fd, int sel_idx)
+{
+#ifdef XORP_USE_EPOLL
+    if (_backend == BACKEND_EPOLL) {
+	_ready_mask[fd] &= ~(1 << sel_idx);
+	return;
+    }
+#endif
+    FD_CLR(fd, &_testfds[sel_idx]);
+}
+
 void
 SelectorList::get_fd_set(SelectorMask selected_mask, fd_set& fds) const
 {
+    if (_backend != BACKEND_SELECT) {
+	//
+	// The fd_sets are not maintained by the other backends, so build
+	// one on demand.  Descriptors beyond FD_SETSIZE cannot be stored.
+	//
+	FD_ZERO(&fds);
+	for (int fd = 0; (fd <= _maxfd) && (fd < FD_SETSIZE); fd++) {
+	    for (int i = 0; i < SEL_MAX_IDX; i++) {
+		if ((selected_mask == (1 << i))
+		    && _selector_entries[fd]._mask[i]) {
+		    FD_SET(fd, &fds);
+		}
+	    }
+	}
+	return;
+    }
+
     if (SEL_RD == selected_mask)
 	fds = _fds [SEL_RD_IDX];
     if (SEL_WR == selected_mask)
@@ -602,6 +776,219 @@ SelectorList::callback_bad_descriptors()
     XLOG_ASSERT(bc != 0);
 }
 
+#ifdef XORP_USE_EPOLL
+//
+// Update the epoll interest set for a file descriptor to match the
+// events registered in its Node.
+//
+bool
+SelectorList::epoll_update(int fd)
+{
+    static const uint32_t sel_to_epoll[SEL_MAX_IDX] = {
+	EPOLLIN,	// SEL_RD_IDX
+	EPOLLOUT,	// SEL_WR_IDX
+	EPOLLPRI	// SEL_EX_IDX
+    };
+    uint32_t events = 0;
+
+    for (int i = 0; i < SEL_MAX_IDX; i++) {
+	if (_selector_entries[fd]._mask[i])
+	    events |= sel_to_epoll[i];
+    }
+    if (events == _epoll_interest[fd])
+	return true;
+
+    if (_epoll_always_ready.find(fd) != _epoll_always_ready.end()) {
+	if (events == 0)
+	    _epoll_always_ready.erase(fd);
+	_epoll_interest[fd] = events;
+	return true;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+
+    int op = EPOLL_CTL_MOD;
+    if (_epoll_interest[fd] == 0)
+	op = EPOLL_CTL_ADD;
+    else if (events == 0)
+	op = EPOLL_CTL_DEL;
+
+    int r = epoll_ctl(_epfd, op, fd, &ev);
+    if (r < 0) {
+	//
+	// The kernel silently drops a descriptor from the epoll set when
+	// it is closed, so a descriptor that was closed (and possibly
+	// reused) without removing its callbacks first looks unknown.
+	//
+	if ((op == EPOLL_CTL_MOD) && (errno == ENOENT))
+	    r = epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev);
+	else if ((op == EPOLL_CTL_ADD) && (errno == EEXIST))
+	    r = epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &ev);
+	else if ((op == EPOLL_CTL_DEL) && ((errno == ENOENT)
+					   || (errno == EBADF)))
+	    r = 0;
+	else if ((op == EPOLL_CTL_ADD) && (errno == EPERM)) {
+	    // Regular files and some devices cannot be polled, but
+	    // select(2) always reports them as ready, so do the same.
+	    _epoll_always_ready.insert(fd);
+	    r = 0;
+	}
+    }
+    if (r < 0) {
+	XLOG_ERROR("epoll_ctl() failed for file descriptor %d: %s",
+		   fd, strerror(errno));
+	return false;
+    }
+
+    _epoll_interest[fd] = events;
+    return true;
+}
+
+void
+SelectorList::epoll_clear_ready()
+{
+    for (size_t i = 0; i < _ready_fds.size(); i++)
+	_ready_mask[_ready_fds[i]] = 0;
+    _ready_fds.clear();
+}
+
+//
+// Wait for events and record the ready (fd, event) pairs.
+//
+// Returns the number of ready events in the same sense as select(2), or
+// -1 on error.
+//
+int
+SelectorList::do_epoll(struct timeval* to)
+{
+    int timeout_ms = -1;
+
+    if (to != NULL) {
+	// Round up, so we don't spin waiting for sub-millisecond timers.
+	int64_t ms = (int64_t)to->tv_sec * 1000 + (to->tv_usec + 999) / 1000;
+	timeout_ms = (ms > INT_MAX) ? INT_MAX : (int)ms;
+    }
+
+    if (! _epoll_always_ready.empty())
+	timeout_ms = 0;
+
+    epoll_clear_ready();
+
+    int n = epoll_wait(_epfd, &_epoll_events[0], _epoll_events.size(),
+		       timeout_ms);
+    if (n < 0)
+	return n;
+
+    int ready = 0;
+    for (int i = 0; i < n; i++) {
+	int fd = _epoll_events[i].data.fd;
+	uint32_t ev = _epoll_events[i].events;
+	int registered = 0;
+	int m = 0;
+
+	for (int sel_idx = 0; sel_idx < SEL_MAX_IDX; sel_idx++) {
+	    if (_selector_entries[fd]._mask[sel_idx])
+		registered |= (1 << sel_idx);
+	}
+	if (ev & EPOLLIN)
+	    m |= SEL_RD;
+	if (ev & EPOLLOUT)
+	    m |= SEL_WR;
+	if (ev & EPOLLPRI)
+	    m |= SEL_EX;
+	if (ev & (EPOLLERR | EPOLLHUP)) {
+	    // select(2) reports errors and hangups as a readable and
+	    // writable descriptor.  Deliver them to whatever is
+	    // registered so that they are not reported forever.
+	    m |= SEL_RD | SEL_WR;
+	    if ((m & registered) == 0)
+		m |= SEL_EX;
+	}
+	m &= registered;
+	if (m == 0)
+	    continue;
+
+	_ready_mask[fd] = m;
+	_ready_fds.push_back(fd);
+	for (int sel_idx = 0; sel_idx < SEL_MAX_IDX; sel_idx++) {
+	    if (m & (1 << sel_idx))
+		ready++;
+	}
+    }
+
+    set<int>::const_iterator iter;
+    for (iter = _epoll_always_ready.begin();
+	 iter != _epoll_always_ready.end();
+	 ++iter) {
+	int fd = *iter;
+	int m = 0;
+
+	if (_selector_entries[fd]._mask[SEL_RD_IDX])
+	    m |= SEL_RD;
+	if (_selector_entries[fd]._mask[SEL_WR_IDX])
+	    m |= SEL_WR;
+	if (m == 0)
+	    continue;
+	_ready_mask[fd] = m;
+	_ready_fds.push_back(fd);
+	ready += ((m & SEL_RD) ? 1 : 0) + ((m & SEL_WR) ? 1 : 0);
+    }
+
+    // If the event buffer was filled, grow it for the next round.
+    if ((size_t)n == _epoll_events.size())
+	_epoll_events.resize(_epoll_events.size() * 2);
+
+    return ready;
+}
+
+//
+// Find the highest priority ready event by scanning only the ready
+// descriptors.  This picks the same event that the select(2) scan in
+// get_ready_priority() would: the remaining events of the last served
+// descriptor first, then round-robin starting at (_last_served_fd + 1).
+//
+int
+SelectorList::epoll_ready_priority()
+{
+    int max_priority = XorpTask::PRIORITY_INFINITY;
+    int best_rank = 0;
+    bool found_one = false;
+    int nfds = _maxfd + 1;
+
+    for (size_t i = 0; i < _ready_fds.size(); i++) {
+	int fd = _ready_fds[i];
+	for (int sel_idx = 0; sel_idx < SEL_MAX_IDX; sel_idx++) {
+	    if ((_ready_mask[fd] & (1 << sel_idx)) == 0)
+		continue;
+
+	    int rank;
+	    if ((fd == _last_served_fd) && (sel_idx > _last_served_sel))
+		rank = sel_idx - SEL_MAX_IDX;
+	    else
+		rank = ((fd - _last_served_fd - 1 + nfds) % nfds) * SEL_MAX_IDX
+		    + sel_idx;
+
+	    int p = _selector_entries[fd]._priority[sel_idx];
+	    if ((!found_one) || (p < max_priority)
+		|| ((p == max_priority) && (rank < best_rank))) {
+		found_one = true;
+		max_priority = p;
+		best_rank = rank;
+		_maxpri_fd = fd;
+		_maxpri_sel = sel_idx;
+	    }
+	}
+    }
+
+    XLOG_ASSERT(_maxpri_fd != -1);
+
+    return max_priority;
+}
+#endif // XORP_USE_EPOLL
+
 void
 SelectorList::set_observer(SelectorListObserverBase& obs)
 {
@@ -37,6 +37,16 @@
 
 #ifndef USE_WIN_DISPATCHER
 
+//
+// Use epoll(7) on systems that have it, unless it was disabled at
+// build time.  The select(2) backend is always compiled in and can be
+// forced at run time by setting XORP_SELECTOR=select in the environment.
+//
+#if defined(HAVE_SYS_EPOLL_H) && !defined(XORP_DISABLE_EPOLL)
+#define XORP_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #include "callback.hh"
 #include "ioevents.hh"
 #include "task.hh"
@@ -103,11 +113,22 @@ class SelectorList :
     public NONCOPYABLE
 {
 public:
+    /**
+     * The I/O multiplexing mechanism used to wait for events.
+     */
+    enum Backend {
+	BACKEND_SELECT,		// select(2) over fd_sets, O(maxfd)
+	BACKEND_EPOLL		// epoll(7), O(ready descriptors)
+    };
 
     /**
      * Default constructor.
+     *
+     * @param clock the clock to advance after waiting for events.
+     * @param backend the I/O multiplexing mechanism to use.  If the
+     * backend is not supported, select(2) is used instead.
      */
-    SelectorList(ClockBase* clock);
+    SelectorList(ClockBase* clock, Backend backend = default_backend());
 
     /**
      * Destructor.
@@ -117,6 +138,38 @@ public:
     void set_debug(bool v) { _is_debug = v;}
     bool is_debug() const { return (_is_debug); }
 
+    /**
+     * Get the backend chosen when no backend is explicitly specified.
+     *
+     * This is epoll(7) if it has been compiled in, unless the
+     * XORP_SELECTOR environment variable is set to "select".
+     *
+     * @return the default backend.
+     */
+    static Backend default_backend();
+
+    /**
+     * Test whether a backend has been compiled in.
+     *
+     * @param backend the backend to test.
+     * @return true if the backend is available.
+     */
+    static bool backend_supported(Backend backend);
+
+    /**
+     * Get the backend in use.
+     *
+     * @return the backend in use.
+     */
+    Backend backend() const { return _backend; }
+
+    /**
+     * Get the name of the backend in use.
+     *
+     * @return "select" or "epoll".
+     */
+    const char* backend_name() const;
+
     /**
      * Add a hook for pending I/O operations on a callback.
      *
@@ -197,7 +250,8 @@ public:
 
     /**
      * Get a copy of the current list of monitored file descriptors in
-     * Unix fd_set format
+     * Unix fd_set format.  With backends other than select(2) the set
+     * is built on demand and omits descriptors beyond FD_SETSIZE.
      *
      * @param the selected mask as @ref SelectorMask (SEL_RD, SEL_WR, or SEL_EX)
      *
@@ -232,6 +286,15 @@ protected:
 
 private:
     int do_select(struct timeval* to, bool force);
+    bool is_pending(int fd, int sel_idx) const;
+    void clear_pending(int fd, int sel_idx);
+    void grow_entries(size_t n);
+#ifdef XORP_USE_EPOLL
+    int do_epoll(struct timeval* to);
+    bool epoll_update(int fd);
+    int epoll_ready_priority();
+    void epoll_clear_ready();
+#endif
 
 private:
     enum {
@@ -266,6 +329,7 @@ private:
 
     ClockBase*		_clock;
     SelectorListObserverBase * _observer;
+    Backend		_backend;
     fd_set		_fds[SEL_MAX_IDX];
     fd_set		_testfds[SEL_MAX_IDX];
     int			_testfds_n;
@@ -278,6 +342,19 @@ private:
     int			_maxfd;
     size_t		_descriptor_count;
     bool		_is_debug;
+
+#ifdef XORP_USE_EPOLL
+    // epoll state.  The ready (fd, event) pairs returned by the last
+    // epoll_wait() are kept in _ready_mask (indexed by fd, SelectorMask
+    // bits) and _ready_fds (the fds with a non-zero ready mask), so
+    // that only ready descriptors are scanned when dispatching.
+    int				_epfd;
+    vector<uint32_t>		_epoll_interest;	// indexed by fd
+    vector<uint8_t>		_ready_mask;		// indexed by fd
+    vector<int>			_ready_fds;
+    vector<struct epoll_event>	_epoll_events;
+    set<int>			_epoll_always_ready;	// cannot be polled
+#endif
 };
 #endif // USE_WIN_DISPATCHER
 #endif // __LIBXORP_SELECTOR_HH__
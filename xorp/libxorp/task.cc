@@ -26,6 +26,7 @@
 
 #include "xlog.h"
 #include "task.hh"
+#include "dispatch_stats.hh"
 
 
 // ----------------------------------------------------------------------------
@@ -105,6 +106,7 @@ private:
 	// the callback decides to schedules again the task.
 	//
 	xorp_task.unschedule();
+	DispatchProbe probe(DispatchStats::TASK, _cb.get());
 	_cb->dispatch();
     }
 
@@ -119,7 +121,12 @@ public:
 
 private:
     void run(XorpTask& xorp_task) {
-	if (! _cb->dispatch()) {
+	bool again;
+	{
+	    DispatchProbe probe(DispatchStats::TASK, _cb.get());
+	    again = _cb->dispatch();
+	}
+	if (! again) {
 	    xorp_task.unschedule();
 	}
     }
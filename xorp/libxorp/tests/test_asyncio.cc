@@ -28,6 +28,8 @@
 #include "libxorp/xorpfd.hh"
 #include "libxorp/xlog.h"
 #include "libxorp/random.h"
+#include "libxorp/timeval.hh"
+#include "libxorp/timer.hh"
 
 #ifdef HAVE_FCNTL_H
 #include <fcntl.h>
@@ -526,6 +528,135 @@ run_test()
     print_passed(buf);
 }
 
+//
+// A table dump: many small buffers written through a queue that the
+// sender keeps topped up to a small window, as BGP does.
+//
+static const size_t DUMP_BUFFERS = 200000;
+static const size_t DUMP_WINDOW = 64;
+
+struct DumpState {
+    AsyncFileWriter*	afw;
+    uint8_t		msg[4096];
+    size_t		added;		// buffers added so far
+    size_t		completed;	// buffers written so far
+    size_t		bytes_added;
+    size_t		bytes_read;
+};
+
+static void dump_fill(DumpState* ds);
+
+static void
+dump_writer_check(AsyncFileWriter::Event ev,
+		  const uint8_t* buf, size_t bytes, size_t offset,
+		  size_t index, DumpState* ds)
+{
+    assert(ev == AsyncFileWriter::DATA);
+    assert(buf == ds->msg);
+    assert(offset == bytes);
+    assert(index == ds->completed);	// callbacks complete in order
+    ds->completed++;
+    dump_fill(ds);
+}
+
+static void
+dump_fill(DumpState* ds)
+{
+    while (ds->added < DUMP_BUFFERS
+	   && ds->afw->buffers_remaining() < DUMP_WINDOW) {
+	// Mostly UPDATE sized messages, with the odd large one
+	size_t b_bytes = 40 + (xorp_random() % 100);
+	if ((ds->added % 100) == 0)
+	    b_bytes = 4096;
+	ds->afw->add_buffer(ds->msg, b_bytes,
+			    callback(&dump_writer_check, ds->added, ds));
+	ds->added++;
+	ds->bytes_added += b_bytes;
+    }
+    ds->afw->start();
+}
+
+static void
+dump_reader(XorpFd fd, IoEventType type, DumpState* ds)
+{
+    char buf[65536];
+
+    assert(type == IOT_READ);
+    int n = recv(fd, buf, sizeof(buf), 0);
+    if (n > 0)
+	ds->bytes_read += n;
+}
+
+/**
+ * Write a table dump through an AsyncFileWriter and report the number of
+ * write system calls.
+ *
+ * @return the number of write system calls.
+ */
+static uint64_t
+run_dump_test(uint32_t max_buffers, size_t max_bytes)
+{
+    EventLoop e;
+
+    xsock_t s[2];
+    if (local_comm_sock_pair(AF_UNIX, SOCK_STREAM, 0, s) != XORP_OK) {
+	print_failed("Failed to open socket pair");
+	exit(1);
+    }
+    if (local_comm_sock_set_blocking(s[0], 0) != XORP_OK
+	|| local_comm_sock_set_blocking(s[1], 0) != XORP_OK) {
+	print_failed("Failed to set socket non-blocking");
+	exit(1);
+    }
+
+    DumpState ds;
+    memset(&ds, 0, sizeof(ds));
+    AsyncFileWriter afw(e, s[0]);
+    afw.set_coalesce(max_buffers, max_bytes);
+    ds.afw = &afw;
+    e.add_ioevent_cb(s[1], IOT_READ, callback(&dump_reader, &ds));
+
+    TimeVal start, end;
+    TimerList::system_gettimeofday(&start);
+    dump_fill(&ds);
+    while (ds.completed < DUMP_BUFFERS || ds.bytes_read < ds.bytes_added)
+	e.run();
+    TimerList::system_gettimeofday(&end);
+
+    e.remove_ioevent_cb(s[1], IOT_READ);
+    assert(afw.stats().buffers == DUMP_BUFFERS);
+    assert(afw.stats().bytes == ds.bytes_added);
+
+    double mb = ds.bytes_added / (1024.0 * 1024.0);
+    printf("coalesce %4u buffers/%6u bytes: %u buffers, %.1f MB, "
+	   "%u writes (%.0f writes/MB), %.3f seconds\n",
+	   XORP_UINT_CAST(afw.coalesce_buffers()),
+	   XORP_UINT_CAST(afw.coalesce_bytes()),
+	   XORP_UINT_CAST(DUMP_BUFFERS), mb,
+	   XORP_UINT_CAST(afw.stats().writes), afw.stats().writes / mb,
+	   (end - start).get_double());
+
+    local_comm_sock_close(s[0]);
+    local_comm_sock_close(s[1]);
+
+    return afw.stats().writes;
+}
+
+static void
+run_dump_tests()
+{
+    uint64_t single = run_dump_test(1, AsyncFileWriter::DEFAULT_COALESCE_BYTES);
+    uint64_t batched = run_dump_test(DUMP_WINDOW,
+				     AsyncFileWriter::DEFAULT_COALESCE_BYTES);
+    run_dump_test(DUMP_WINDOW, 1024);
+
+    if (batched * 4 > single) {
+	print_failed("Coalesced writes");
+	exit(1);
+    }
+    print_passed("Coalesced writes");
+}
+
 int
 main(int /* argc */, char *argv[]) 
 {
@@ -550,6 +681,7 @@ main(int /* argc */, char *argv[])
     }
 
     run_test();
+    run_dump_tests();
 
     local_comm_exit();
 
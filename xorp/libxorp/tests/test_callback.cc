@@ -42,6 +42,7 @@ void incr_failures()		{ s_failures++; }
 #include "libxorp/xorp_tests.hh"
 
 typedef XorpCallback1<void, int>::RefPtr TestCallback;
+typedef XorpSmallCallback1<void, int> SmallTestCallback;
 
 class Widget {
 public:
@@ -67,6 +68,90 @@ private:
     int* _counter;
 };
 
+/**
+ * A bound argument too large to be stored in a small callback.
+ */
+struct BigArg {
+    char data[SmallTestCallback::BUFFER_SIZE];
+};
+
+static int big_arg_calls = 0;
+
+static void
+big_arg_notify(int event, BigArg arg)
+{
+    if (arg.data[0] == 'x' && event == 7)
+	big_arg_calls++;
+}
+
+static int
+test_small_callbacks()
+{
+    Widget w;
+    SmallTestCallback scb;
+
+    if (!scb.is_empty()) {
+	print_failed("small callback is not empty");
+	return -1;
+    }
+
+    // Stored in place
+    scb = small_callback(&w, &Widget::notify);
+    if (scb.is_empty()) {
+	print_failed("small callback is empty");
+	return -1;
+    }
+    SmallTestCallback copy = scb;
+    scb.release();
+    if (!scb.is_empty()) {
+	print_failed("small callback not released");
+	return -1;
+    }
+    copy->dispatch(6);
+
+    // Shares the object of a RefPtr
+    TestCallback cbm = callback(&w, &Widget::notify);
+    scb = cbm;
+    if (scb.get() != cbm.get()) {
+	print_failed("small callback does not share RefPtr object");
+	return -1;
+    }
+    scb->dispatch(6);
+
+    // Too large to be stored in place
+    BigArg big;
+    big.data[0] = 'x';
+    scb = small_callback(big_arg_notify, big);
+    copy = scb;
+    scb->dispatch(7);
+    copy->dispatch(7);
+    if (big_arg_calls != 2) {
+	print_failed("small callback with large bound argument");
+	return -1;
+    }
+
+    // Copies of small safe callbacks are invalidated with the object
+    int counter = 0;
+    SafeWidget* sw = new SafeWidget(&counter);
+    scb = small_callback(sw, &SafeWidget::notify);
+    copy = scb;
+    scb->dispatch(1);
+    copy->dispatch(2);
+    {
+	SmallTestCallback tmp = copy;
+	tmp->dispatch(3);
+    }
+    delete sw;
+    scb->dispatch(4);
+    copy->dispatch(5);
+    if (counter != 3) {
+	print_failed("small safe callback executed after object deletion");
+	return -1;
+    }
+
+    return 0;
+}
+
 int
 main()
 {
@@ -137,6 +222,10 @@ main()
 	}
 	delete sw;
     }
+
+    if (test_small_callbacks() != 0)
+	return -1;
+
     print_passed("Callback tests");
     return (0);
 }
@@ -0,0 +1,253 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/eventloop.hh"
+#include "libxorp/dispatch_stats.hh"
+
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+
+
+//
+// XXX: MODIFY FOR YOUR TEST PROGRAM
+//
+static const char *program_name		= "test_dispatch_stats";
+static const char *program_description	= "Test the EventLoop dispatch statistics";
+static const char *program_version_id	= "0.1";
+static const char *program_date		= "October 17, 2026";
+static const char *program_copyright	= "See file LICENSE";
+static const char *program_return_value	= "0 on success, 1 if test error, 2 if internal error";
+
+static bool s_verbose = false;
+bool verbose()			{ return s_verbose; }
+void set_verbose(bool v)	{ s_verbose = v; }
+
+static int s_failures = 0;
+bool failures()			{ return s_failures; }
+void incr_failures()		{ s_failures++; }
+
+#include "libxorp/xorp_tests.hh"
+
+/**
+ * Print program info to output stream.
+ *
+ * @param stream the output stream the print the program info to.
+ */
+static void
+print_program_info(FILE *stream)
+{
+    fprintf(stream, "Name:          %s\n", program_name);
+    fprintf(stream, "Description:   %s\n", program_description);
+    fprintf(stream, "Version:       %s\n", program_version_id);
+    fprintf(stream, "Date:          %s\n", program_date);
+    fprintf(stream, "Copyright:     %s\n", program_copyright);
+    fprintf(stream, "Return:        %s\n", program_return_value);
+}
+
+/**
+ * Print program usage information to the stderr.
+ *
+ * @param progname the name of the program.
+ */
+static void
+usage(const char* progname)
+{
+    print_program_info(stderr);
+    fprintf(stderr, "usage: %s [-v] [-h]\n", progname);
+    fprintf(stderr, "       -h          : usage (this message)\n");
+    fprintf(stderr, "       -v          : verbose output\n");
+    fprintf(stderr, "Return 0 on success, 1 if test error, 2 if internal error.\n");
+}
+
+/**
+ * Callbacks of each kind, one of which hogs the event loop.
+ */
+class Handlers {
+public:
+    Handlers() : _timers(0), _tasks(0), _io(0) {}
+
+    void slow_timer() {
+	_timers++;
+	TimerList::system_sleep(TimeVal(0, 20000));
+    }
+
+    void fast_timer() {
+	_timers++;
+    }
+
+    bool task() {
+	return ++_tasks < 100;
+    }
+
+    void io_event(XorpFd fd, IoEventType) {
+	char c;
+	if (read(fd, &c, 1) == 1)
+	    _io++;
+    }
+
+    int _timers;
+    int _tasks;
+    int _io;
+};
+
+static void
+test_stats(EventLoop& e)
+{
+    Handlers h;
+    int fds[2];
+
+    verbose_assert(pipe(fds) == 0, "pipe");
+    e.add_ioevent_cb(fds[0], IOT_READ, callback(&h, &Handlers::io_event));
+    for (int i = 0; i < 10; i++)
+	verbose_assert(write(fds[1], "x", 1) == 1, "write");
+
+    DispatchStats::set_enabled(true);
+
+    XorpTimer slow = e.new_oneoff_after_ms(10,
+					   callback(&h, &Handlers::slow_timer));
+    XorpTimer fast = e.new_oneoff_after_ms(10,
+					   callback(&h, &Handlers::fast_timer));
+    XorpTask task = e.new_task(callback(&h, &Handlers::task));
+
+    while (h._timers < 2 || h._tasks < 100 || h._io < 10)
+	e.run();
+
+    e.remove_ioevent_cb(fds[0], IOT_READ);
+    close(fds[0]);
+    close(fds[1]);
+
+    string s = DispatchStats::str();
+    verbose_log("%s", s.c_str());
+
+    verbose_assert(s.find("Handlers") != string::npos, "sites are named");
+    verbose_assert(s.find("\ntimer  2 ") != string::npos, "timer count");
+    verbose_assert(s.find("\ntask   100 ") != string::npos, "task count");
+
+    // The slow timer is the slowest dispatch, and fired late as it ran
+    // after the fast one or the fast one ran late after it.
+    size_t slowest = s.find("Slowest dispatches:");
+    verbose_assert(slowest != string::npos
+		   && s.find("\ntimer  2", slowest) != string::npos,
+		   "slow timer is the slowest dispatch");
+
+    DispatchStats::set_enabled(false);
+    h._timers = 0;
+    fast = e.new_oneoff_after_ms(0, callback(&h, &Handlers::fast_timer));
+    while (h._timers < 1)
+	e.run();
+    s = DispatchStats::str();
+    verbose_assert(s.find("\ntimer  2 ") != string::npos,
+		   "nothing recorded when disabled");
+}
+
+/**
+ * Compare the cost of dispatching a callback with the statistics
+ * disabled and enabled.
+ */
+static void
+test_overhead()
+{
+    static const int DISPATCHES = 1000000;
+    Handlers h;
+    RepeatedTaskCallback cb = callback(&h, &Handlers::task);
+
+    for (int enabled = 0; enabled < 2; enabled++) {
+	DispatchStats::set_enabled(enabled);
+
+	uint64_t start = DispatchStats::now();
+	for (int i = 0; i < DISPATCHES; i++) {
+	    DispatchProbe probe(DispatchStats::TASK, cb.get());
+	    cb->dispatch();
+	}
+	uint64_t end = DispatchStats::now();
+
+	printf("%s: %.1f ns per dispatch\n",
+	       enabled ? "enabled" : "disabled",
+	       (double)(end - start) / DISPATCHES);
+    }
+    verbose_assert(h._tasks == 2 * DISPATCHES, "dispatches");
+    DispatchStats::set_enabled(false);
+}
+
+int
+main(int argc, char * const argv[])
+{
+    int ret_value = 0;
+
+    //
+    // Initialize and start xlog
+    //
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);         // Least verbose messages
+    // XXX: verbosity of the error messages temporary increased
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    int ch;
+    while ((ch = getopt(argc, argv, "hv")) != -1) {
+	switch (ch) {
+	case 'v':
+	    set_verbose(true);
+	    break;
+	case 'h':
+	case '?':
+	default:
+	    usage(argv[0]);
+	    xlog_stop();
+	    xlog_exit();
+	    if (ch == 'h')
+		return (0);
+	    else
+		return (1);
+	}
+    }
+    argc -= optind;
+    argv += optind;
+
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+    try {
+	EventLoop e;
+	test_stats(e);
+	test_overhead();
+	ret_value = failures() ? 1 : 0;
+    } catch (...) {
+	// Internal error
+	xorp_print_standard_exceptions();
+	ret_value = 2;
+    }
+
+    //
+    // Gracefully stop and exit xlog
+    //
+    xlog_stop();
+    xlog_exit();
+
+    return (ret_value);
+}
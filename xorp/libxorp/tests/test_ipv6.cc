@@ -26,6 +26,8 @@
 #include "libxorp/xorp.h"
 #include "libxorp/xlog.h"
 #include "libxorp/exceptions.hh"
+#include "libxorp/clock.hh"
+#include "libxorp/timeval.hh"
 
 #ifdef HAVE_GETOPT_H
 #include <getopt.h>
@@ -820,6 +822,167 @@ test_ipv6_invalid_manipulate_address()
     }
 }
 
+//
+// Deterministic pseudo-random addresses.  The second address of each
+// pair shares a random number of leading bits with the first one, so
+// that the comparisons are decided in every word.
+//
+static uint32_t s_seed = 0x12345678;
+
+static uint32_t
+next_random()
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed;
+}
+
+static void
+random_pair(uint8_t* a, uint8_t* b)
+{
+    for (size_t i = 0; i < 16; i++)
+	a[i] = next_random() >> 16;
+
+    uint32_t common = next_random() % 129;
+    for (size_t i = 0; i < 16; i++) {
+	uint8_t x = next_random() >> 16;
+	if (common >= 8 * (i + 1)) {
+	    b[i] = a[i];
+	} else if (common > 8 * i) {
+	    uint8_t m = 0xff << (8 - (common - 8 * i));
+	    b[i] = (a[i] & m) | (x & ~m);
+	} else {
+	    b[i] = x;
+	}
+    }
+}
+
+/**
+ * Test the IPv6 word operations against a byte by byte reference.
+ */
+void
+test_ipv6_word_operations()
+{
+    bool ok_less = true, ok_equal = true, ok_bitwise = true;
+    bool ok_shift = true, ok_lzc = true, ok_mask = true;
+
+    for (size_t n = 0; n < 100000; n++) {
+	uint8_t a[16], b[16], r[16];
+	random_pair(a, b);
+	IPv6 ip_a(a), ip_b(b);
+
+	int cmp = memcmp(a, b, 16);
+	ok_less = ok_less && ((ip_a < ip_b) == (cmp < 0))
+	    && ((ip_b < ip_a) == (cmp > 0));
+	ok_equal = ok_equal && ((ip_a == ip_b) == (cmp == 0))
+	    && ((ip_a != ip_b) == (cmp != 0));
+
+	for (size_t i = 0; i < 16; i++)
+	    r[i] = a[i] & b[i];
+	ok_bitwise = ok_bitwise && ((ip_a & ip_b) == IPv6(r));
+	for (size_t i = 0; i < 16; i++)
+	    r[i] = a[i] | b[i];
+	ok_bitwise = ok_bitwise && ((ip_a | ip_b) == IPv6(r));
+	for (size_t i = 0; i < 16; i++)
+	    r[i] = a[i] ^ b[i];
+	ok_bitwise = ok_bitwise && ((ip_a ^ ip_b) == IPv6(r));
+	for (size_t i = 0; i < 16; i++)
+	    r[i] = ~a[i];
+	ok_bitwise = ok_bitwise && (~ip_a == IPv6(r));
+
+	// Leading zeroes of the XOR: the common prefix length
+	uint32_t lzc = 0;
+	for (size_t i = 0; i < 16 && lzc == 8 * i; i++) {
+	    uint8_t x = a[i] ^ b[i];
+	    for (uint8_t m = 0x80; m != 0 && (x & m) == 0; m >>= 1)
+		lzc++;
+	}
+	ok_lzc = ok_lzc && ((ip_a ^ ip_b).leading_zero_count() == lzc);
+
+	uint32_t s = next_random() % 129;
+	memset(r, 0, sizeof(r));
+	for (uint32_t i = 0; i + s < 128; i++) {
+	    if (a[(i + s) / 8] & (0x80 >> ((i + s) % 8)))
+		r[i / 8] |= 0x80 >> (i % 8);
+	}
+	ok_shift = ok_shift && ((ip_a << s) == IPv6(r));
+	memset(r, 0, sizeof(r));
+	for (uint32_t i = 0; i + s < 128; i++) {
+	    if (a[i / 8] & (0x80 >> (i % 8)))
+		r[(i + s) / 8] |= 0x80 >> ((i + s) % 8);
+	}
+	ok_shift = ok_shift && ((ip_a >> s) == IPv6(r));
+
+	for (uint32_t i = 0; i < 16; i++) {
+	    if (s >= 8 * (i + 1))
+		r[i] = a[i];
+	    else if (s > 8 * i)
+		r[i] = a[i] & (0xff << (8 - (s - 8 * i)));
+	    else
+		r[i] = 0;
+	}
+	ok_mask = ok_mask && (ip_a.mask_by_prefix_len(s) == IPv6(r))
+	    && (IPv6::make_prefix(s).mask_len() == s);
+    }
+
+    verbose_assert(ok_less, "operator< matches memcmp()");
+    verbose_assert(ok_equal, "operator== and operator!= match memcmp()");
+    verbose_assert(ok_bitwise, "bitwise operators");
+    verbose_assert(ok_lzc, "leading_zero_count()");
+    verbose_assert(ok_shift, "operator<< and operator>>");
+    verbose_assert(ok_mask, "mask_by_prefix_len() and mask_len()");
+}
+
+/**
+ * Time the IPv6 operations used by the route lookups.
+ */
+void
+test_ipv6_performance()
+{
+    static const size_t N = 4096;
+    static const size_t ROUNDS = 500;
+    vector<IPv6> va(N), vb(N);
+    vector<uint32_t> len(N);
+
+    for (size_t i = 0; i < N; i++) {
+	uint8_t a[16], b[16];
+	random_pair(a, b);
+	va[i] = IPv6(a);
+	vb[i] = IPv6(b);
+	len[i] = next_random() % 129;
+    }
+
+    SystemClock clock;
+    TimeVal start, end;
+    size_t c;
+    const double ops = static_cast<double>(N) * ROUNDS;
+
+#define TIME_IPV6_OPERATION(name, expr)					\
+    do {								\
+	c = 0;								\
+	clock.advance_time();						\
+	clock.current_time(start);					\
+	for (size_t r = 0; r < ROUNDS; r++) {				\
+	    for (size_t i = 0; i < N; i++)				\
+		c += (expr);						\
+	}								\
+	clock.advance_time();						\
+	clock.current_time(end);					\
+	printf("%-28s %6.2f ns/op (%u)\n", name,			\
+	       (end - start).get_double() * 1e9 / ops,			\
+	       XORP_UINT_CAST(c & 1));					\
+    } while (false)
+
+    TIME_IPV6_OPERATION("operator<", va[i] < vb[i]);
+    TIME_IPV6_OPERATION("operator==", va[i] == vb[i]);
+    TIME_IPV6_OPERATION("mask_by_prefix_len()",
+			va[i].mask_by_prefix_len(len[i]) == vb[i]);
+    TIME_IPV6_OPERATION("common prefix length",
+			(va[i] ^ vb[i]).leading_zero_count());
+    TIME_IPV6_OPERATION("operator>>", (va[i] >> len[i]) < vb[i]);
+
+#undef TIME_IPV6_OPERATION
+}
+
 int
 main(int argc, char * const argv[])
 {
@@ -867,6 +1030,8 @@ main(int argc, char * const argv[])
 	test_ipv6_address_const();
 	test_ipv6_manipulate_address();
 	test_ipv6_invalid_manipulate_address();
+	test_ipv6_word_operations();
+	test_ipv6_performance();
 	ret_value = failures() ? 1 : 0;
     } catch (...) {
 	// Internal error
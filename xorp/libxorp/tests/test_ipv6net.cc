@@ -27,6 +27,7 @@
 #include "libxorp/xlog.h"
 #include "libxorp/exceptions.hh"
 #include "libxorp/timer.hh"
+#include "libxorp/trie.hh"
 #include "libxorp/test_main.hh"
 
 #ifdef HAVE_GETOPT_H
@@ -401,6 +402,66 @@ test_performance_ipv6net_address_overlap(TestInfo& test_info)
     return (! failures());
 }
 
+/**
+ * Test performance of IPv6Net trie inserts and lookups.
+ */
+bool
+test_performance_ipv6net_trie(TestInfo& test_info)
+{
+    UNUSED(test_info);
+
+    static const size_t ROUTES = 200000;
+    static const size_t LOOKUPS = 1000000;
+    typedef Trie<IPv6, uint32_t> RouteTrie;
+
+    //
+    // Prefixes under a few /24s, between /32 and /64 long, as in the
+    // global IPv6 table.
+    //
+    vector<IPv6Net> nets;
+    vector<IPv6> addrs;
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < ROUTES; i++) {
+	uint32_t w[4];
+	for (size_t j = 0; j < 4; j++) {
+	    x = x * 1103515245 + 12345;
+	    w[j] = htonl(x);
+	}
+	w[0] = htonl(0x20010000 | (ntohl(w[0]) & 0x0700ffff));
+	IPv6 a(w);
+	nets.push_back(IPv6Net(a, 32 + (x >> 8) % 33));
+	addrs.push_back(a);
+    }
+
+    RouteTrie trie;
+    TimeVal begin_timeval, end_timeval, delta_timeval;
+
+    TimerList::system_gettimeofday(&begin_timeval);
+    for (size_t i = 0; i < ROUTES; i++)
+	trie.insert(nets[i], i);
+    TimerList::system_gettimeofday(&end_timeval);
+    delta_timeval = end_timeval - begin_timeval;
+    verbose_log("Trie<IPv6>::insert(): %.3f us/route (%u routes)\n",
+		delta_timeval.get_double() * 1e6 / ROUTES,
+		XORP_UINT_CAST(trie.route_count()));
+
+    size_t found = 0;
+    TimerList::system_gettimeofday(&begin_timeval);
+    for (size_t i = 0; i < LOOKUPS; i++) {
+	if (trie.find(addrs[(i * 7919) % ROUTES]) != trie.end())
+	    found++;
+    }
+    TimerList::system_gettimeofday(&end_timeval);
+    delta_timeval = end_timeval - begin_timeval;
+    verbose_log("Trie<IPv6>::find(): %.3f us/lookup\n",
+		delta_timeval.get_double() * 1e6 / LOOKUPS);
+    verbose_assert(found == LOOKUPS, "every address is covered");
+
+    trie.delete_all_nodes();
+
+    return (! failures());
+}
+
 /**
  * Test IPv6Net address constant values.
  */
@@ -533,6 +594,10 @@ main(int argc, char * const argv[])
 	{ "test_performance_ipv6net_address_overlap",
 	  callback(test_performance_ipv6net_address_overlap),
 	  false
+	},
+	{ "test_performance_ipv6net_trie",
+	  callback(test_performance_ipv6net_trie),
+	  false
 	}
     };
 
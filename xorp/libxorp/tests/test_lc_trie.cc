@@ -0,0 +1,313 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/c_format.hh"
+#include "libxorp/random.h"
+#include "libxorp/ipv4net.hh"
+#include "libxorp/ipv6net.hh"
+#include "libxorp/lc_trie.hh"
+
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+
+
+//
+// XXX: MODIFY FOR YOUR TEST PROGRAM
+//
+static const char *program_name		= "test_lc_trie";
+static const char *program_description	= "Test LcTrie lookups against Trie";
+static const char *program_version_id	= "0.1";
+static const char *program_date		= "October 17, 2026";
+static const char *program_copyright	= "See file LICENSE";
+static const char *program_return_value	= "0 on success, 1 if test error, 2 if internal error";
+
+static bool s_verbose = false;
+bool verbose()			{ return s_verbose; }
+void set_verbose(bool v)	{ s_verbose = v; }
+
+static int s_failures = 0;
+bool failures()			{ return s_failures; }
+void incr_failures()		{ s_failures++; }
+
+#include "libxorp/xorp_tests.hh"
+
+/**
+ * Print program info to output stream.
+ *
+ * @param stream the output stream the print the program info to.
+ */
+static void
+print_program_info(FILE *stream)
+{
+    fprintf(stream, "Name:          %s\n", program_name);
+    fprintf(stream, "Description:   %s\n", program_description);
+    fprintf(stream, "Version:       %s\n", program_version_id);
+    fprintf(stream, "Date:          %s\n", program_date);
+    fprintf(stream, "Copyright:     %s\n", program_copyright);
+    fprintf(stream, "Return:        %s\n", program_return_value);
+}
+
+/**
+ * Print program usage information to the stderr.
+ *
+ * @param progname the name of the program.
+ */
+static void
+usage(const char* progname)
+{
+    print_program_info(stderr);
+    fprintf(stderr, "usage: %s [-v] [-h]\n", progname);
+    fprintf(stderr, "       -h          : usage (this message)\n");
+    fprintf(stderr, "       -v          : verbose output\n");
+    fprintf(stderr, "Return 0 on success, 1 if test error, 2 if internal error.\n");
+}
+
+class RouteEntry {};
+
+/**
+ * Make a random address.
+ */
+template <class A> A random_addr();
+
+template <>
+IPv4
+random_addr<IPv4>()
+{
+    return IPv4(htonl((xorp_random() << 16) ^ xorp_random()));
+}
+
+template <>
+IPv6
+random_addr<IPv6>()
+{
+    uint32_t a[4];
+
+    for (int i = 0; i < 4; i++)
+	a[i] = htonl((xorp_random() << 16) ^ xorp_random());
+    // Keep the addresses in a smaller space, so routes overlap
+    a[0] = htonl(0x20010000 | (ntohl(a[0]) & 0xff));
+    return IPv6(a);
+}
+
+/**
+ * Check that the LcTrie and the Trie return the same longest match for
+ * an address.
+ */
+template <class A>
+static bool
+check_find(const LcTrie<A, RouteEntry*>& lct, const Trie<A, RouteEntry*>& t,
+	   const A& a)
+{
+    typename LcTrie<A, RouteEntry*>::iterator li = lct.find(a);
+    typename Trie<A, RouteEntry*>::iterator ti = t.find(a);
+
+    if ((li == lct.end()) != (ti == t.end())) {
+	verbose_log("%s: LcTrie %s, Trie %s\n", a.str().c_str(),
+		    li == lct.end() ? "no match" : li.key().str().c_str(),
+		    ti == t.end() ? "no match" : ti.key().str().c_str());
+	return false;
+    }
+    if (li == lct.end())
+	return true;
+    if (li.key() != ti.key() || li.payload() != ti.payload()) {
+	verbose_log("%s: LcTrie %s, Trie %s\n", a.str().c_str(),
+		    li.key().str().c_str(), ti.key().str().c_str());
+	return false;
+    }
+    return true;
+}
+
+/**
+ * Look up random addresses, and the first, last and next addresses of
+ * every route.
+ */
+template <class A>
+static bool
+check_all(const LcTrie<A, RouteEntry*>& lct, const Trie<A, RouteEntry*>& t,
+	  size_t n_random)
+{
+    bool ok = true;
+
+    for (size_t i = 0; i < n_random; i++)
+	ok &= check_find(lct, t, random_addr<A>());
+
+    typename Trie<A, RouteEntry*>::iterator ti;
+    for (ti = t.begin(); ti != t.end(); ++ti) {
+	A lo = ti.key().masked_addr();
+	A hi = ti.key().top_addr();
+	ok &= check_find(lct, t, lo);
+	ok &= check_find(lct, t, hi);
+	ok &= check_find(lct, t, ++hi);
+	ok &= check_find(lct, t, --lo);
+    }
+    return ok;
+}
+
+static void
+test_basic()
+{
+    LcTrie<IPv4, RouteEntry*> lct;
+    RouteEntry r1, r2, r3;
+
+    verbose_assert(lct.find(IPv4("10.0.0.1")) == lct.end(),
+		   "lookup in empty trie");
+
+    size_t compiled = lct.compile_count();
+    lct.insert(IPv4Net("10.0.0.0/8"), &r1);
+    lct.insert(IPv4Net("10.1.0.0/16"), &r2);
+    lct.insert(IPv4Net("10.1.2.3/32"), &r3);
+
+    verbose_assert(lct.find(IPv4("10.2.0.1")).payload() == &r1,
+		   "lookup /8");
+    verbose_assert(lct.find(IPv4("10.1.0.1")).payload() == &r2,
+		   "lookup /16");
+    verbose_assert(lct.find(IPv4("10.1.2.3")).payload() == &r3,
+		   "lookup /32");
+    verbose_assert(lct.find(IPv4("11.0.0.0")) == lct.end(),
+		   "lookup outside routes");
+    verbose_assert(lct.compile_count() == compiled + 1,
+		   "compiled once for three lookups");
+
+    lct.erase(IPv4Net("10.1.0.0/16"));
+    verbose_assert(lct.find(IPv4("10.1.0.1")).payload() == &r1,
+		   "lookup after erase");
+    verbose_assert(lct.lookup_node(IPv4Net("10.1.2.3/32")).payload() == &r3,
+		   "lookup_node");
+    verbose_assert(lct.compile_count() == compiled + 2,
+		   "compiled again after erase");
+    verbose_assert(lct.route_count() == 2, "route count");
+
+    lct.insert(IPv4Net("0.0.0.0/0"), &r2);
+    verbose_assert(lct.find(IPv4("11.0.0.0")).payload() == &r2,
+		   "lookup default route");
+}
+
+/**
+ * Insert random routes up to max_len bits long, and compare lookups
+ * with the Trie as routes are added and removed.
+ */
+template <class A>
+static void
+test_random(size_t n_routes, uint32_t max_len)
+{
+    LcTrie<A, RouteEntry*> lct;
+    Trie<A, RouteEntry*> t;
+    vector<RouteEntry> entries(n_routes);
+    vector<IPNet<A> > nets;
+
+    for (size_t i = 0; i < n_routes; i++) {
+	uint32_t len = xorp_random() % (max_len + 1);
+	if (i % 2)
+	    len = max_len - (xorp_random() % 8);	// mostly long routes
+	IPNet<A> net(random_addr<A>(), len);
+	lct.insert(net, &entries[i]);
+	t.insert(net, &entries[i]);
+	nets.push_back(net);
+	if (i == 10 || i == 1000) {
+	    verbose_assert(check_all(lct, t, 10000),
+			   c_format("%s: lookups with %u routes",
+				    A::ip_version_str().c_str(),
+				    XORP_UINT_CAST(i + 1)));
+	}
+    }
+    verbose_assert(check_all(lct, t, 100000),
+		   c_format("%s: lookups with %u routes",
+			    A::ip_version_str().c_str(),
+			    XORP_UINT_CAST(t.route_count())));
+
+    for (size_t i = 0; i < nets.size(); i += 3) {
+	lct.erase(nets[i]);
+	t.erase(nets[i]);
+    }
+    verbose_assert(lct.route_count() == t.route_count(), "route count");
+    verbose_assert(check_all(lct, t, 100000),
+		   c_format("%s: lookups after erasing routes",
+			    A::ip_version_str().c_str()));
+
+    verbose_log("%s: %u routes, %u bytes compiled\n",
+		A::ip_version_str().c_str(), XORP_UINT_CAST(t.route_count()),
+		XORP_UINT_CAST(lct.compiled_bytes()));
+}
+
+int
+main(int argc, char * const argv[])
+{
+    int ret_value = 0;
+
+    //
+    // Initialize and start xlog
+    //
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);         // Least verbose messages
+    // XXX: verbosity of the error messages temporary increased
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    int ch;
+    while ((ch = getopt(argc, argv, "hv")) != -1) {
+	switch (ch) {
+	case 'v':
+	    set_verbose(true);
+	    break;
+	case 'h':
+	case '?':
+	default:
+	    usage(argv[0]);
+	    xlog_stop();
+	    xlog_exit();
+	    if (ch == 'h')
+		return (0);
+	    else
+		return (1);
+	}
+    }
+    argc -= optind;
+    argv += optind;
+
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+    try {
+	test_basic();
+	test_random<IPv4>(20000, 28);
+	test_random<IPv6>(20000, 64);
+	ret_value = failures() ? 1 : 0;
+    } catch (...) {
+	// Internal error
+	xorp_print_standard_exceptions();
+	ret_value = 2;
+    }
+
+    //
+    // Gracefully stop and exit xlog
+    //
+    xlog_stop();
+    xlog_exit();
+
+    return (ret_value);
+}
@@ -0,0 +1,357 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/c_format.hh"
+#include "libxorp/clock.hh"
+#include "libxorp/timeval.hh"
+#include "libxorp/ipv4net.hh"
+#include "libxorp/memory_pool.hh"
+#include "libxorp/trie.hh"
+
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+
+
+//
+// XXX: MODIFY FOR YOUR TEST PROGRAM
+//
+static const char *program_name		= "test_memory_pool";
+static const char *program_description	= "Test and benchmark the slab MemoryPool";
+static const char *program_version_id	= "0.1";
+static const char *program_date		= "October 17, 2026";
+static const char *program_copyright	= "See file LICENSE";
+static const char *program_return_value	= "0 on success, 1 if test error, 2 if internal error";
+
+static bool s_verbose = false;
+bool verbose()			{ return s_verbose; }
+void set_verbose(bool v)	{ s_verbose = v; }
+
+static int s_failures = 0;
+bool failures()			{ return s_failures; }
+void incr_failures()		{ s_failures++; }
+
+#include "libxorp/xorp_tests.hh"
+
+/**
+ * Print program info to output stream.
+ *
+ * @param stream the output stream the print the program info to.
+ */
+static void
+print_program_info(FILE *stream)
+{
+    fprintf(stream, "Name:          %s\n", program_name);
+    fprintf(stream, "Description:   %s\n", program_description);
+    fprintf(stream, "Version:       %s\n", program_version_id);
+    fprintf(stream, "Date:          %s\n", program_date);
+    fprintf(stream, "Copyright:     %s\n", program_copyright);
+    fprintf(stream, "Return:        %s\n", program_return_value);
+}
+
+/**
+ * Print program usage information to the stderr.
+ *
+ * @param progname the name of the program.
+ */
+static void
+usage(const char* progname)
+{
+    print_program_info(stderr);
+    fprintf(stderr, "usage: %s [-v] [-h]\n", progname);
+    fprintf(stderr, "       -h          : usage (this message)\n");
+    fprintf(stderr, "       -v          : verbose output\n");
+    fprintf(stderr, "Return 0 on success, 1 if test error, 2 if internal error.\n");
+}
+
+/**
+ * A class with its own pool, as used by the route entries.
+ */
+class Pooled {
+public:
+    Pooled(uint32_t v) : _v(v) { _live++; }
+    ~Pooled() { _live--; }
+
+    uint32_t v() const		{ return _v; }
+    static size_t live()	{ return _live; }
+
+    void* operator new(size_t/* size*/) { return memory_pool().alloc(); }
+    void operator delete(void* ptr)	{ memory_pool().free(ptr); }
+
+    static MemoryPool<Pooled>& memory_pool() {
+	static MemoryPool<Pooled> mp;
+	return mp;
+    }
+
+private:
+    uint32_t		_v;
+    char		_pad[20];
+    static size_t	_live;
+};
+
+size_t Pooled::_live = 0;
+
+/**
+ * Allocate a few chunks worth of objects, check they don't overlap, then
+ * free them all and check the chunks are given back.
+ */
+static void
+test_chunks()
+{
+    SlabAllocator slab(24);
+    const SlabAllocator::Stats& st = slab.stats();
+
+    verbose_assert(st.chunks == 0, "no chunk before the first allocation");
+    verbose_assert(st.object_size == 24, "object size");
+
+    size_t n = 3 * st.objects_per_chunk + 1;
+    vector<uint32_t*> v;
+    for (size_t i = 0; i < n; i++) {
+	uint32_t* p = static_cast<uint32_t*>(slab.alloc());
+	for (size_t j = 0; j < 6; j++)
+	    p[j] = i;
+	v.push_back(p);
+    }
+    verbose_assert(st.objects_in_use == n, "objects in use");
+    verbose_assert(st.chunks == 4, "four chunks");
+    verbose_assert(slab.bytes() == 4 * SlabAllocator::CHUNK_SIZE, "bytes");
+
+    bool intact = true;
+    for (size_t i = 0; i < n; i++) {
+	for (size_t j = 0; j < 6; j++)
+	    intact = intact && (v[i][j] == i);
+    }
+    verbose_assert(intact, "objects do not overlap");
+
+    // Free every other object: no chunk becomes empty
+    for (size_t i = 0; i < n; i += 2)
+	SlabAllocator::free(v[i]);
+    verbose_assert(st.chunks == 4, "no chunk released while in use");
+
+    // Freed slots are reused before a new chunk is allocated
+    for (size_t i = 0; i < n; i += 2)
+	v[i] = static_cast<uint32_t*>(slab.alloc());
+    verbose_assert(st.chunks_allocated == 4, "freed slots reused");
+
+    for (size_t i = 0; i < n; i++)
+	SlabAllocator::free(v[i]);
+    verbose_assert(st.objects_in_use == 0, "all objects freed");
+    verbose_assert(st.chunks == 1, "one spare chunk kept");
+    verbose_assert(st.chunks_released == 3, "empty chunks released");
+
+    verbose_log("%s\n", slab.str().c_str());
+}
+
+/**
+ * Check that objects can be found from their indices, and that the
+ * indices of the chunks released are reused.
+ */
+static void
+test_indices()
+{
+    SlabAllocator slab(40);
+    size_t n = 3 * slab.stats().objects_per_chunk;
+
+    vector<void*> v;
+    for (size_t i = 0; i < n; i++)
+	v.push_back(slab.alloc());
+
+    bool found = true, dense = true;
+    for (size_t i = 0; i < n; i++) {
+	uint32_t index = slab.index(v[i]);
+	found = found && (slab.object(index) == v[i]);
+	dense = dense && (index < n);
+    }
+    verbose_assert(found, "objects found from their indices");
+    verbose_assert(dense, "indices are dense");
+
+    // Release the first chunk, and the spare kept instead of the second
+    size_t per_chunk = slab.stats().objects_per_chunk;
+    for (size_t i = 0; i < 2 * per_chunk; i++)
+	SlabAllocator::free(v[i]);
+    verbose_assert(slab.stats().chunks == 2, "a chunk released");
+    for (size_t i = 0; i < 2 * per_chunk; i++)
+	v[i] = slab.alloc();
+
+    dense = true;
+    for (size_t i = 0; i < n; i++) {
+	uint32_t index = slab.index(v[i]);
+	dense = dense && (index < n) && (slab.object(index) == v[i]);
+    }
+    verbose_assert(dense, "indices of released chunks reused");
+
+    for (size_t i = 0; i < n; i++)
+	SlabAllocator::free(v[i]);
+}
+
+/**
+ * Check the per-type pools and the size classes.
+ */
+static void
+test_pools()
+{
+    vector<Pooled*> v;
+    for (uint32_t i = 0; i < 10000; i++)
+	v.push_back(new Pooled(i));
+
+    const SlabAllocator::Stats& st = Pooled::memory_pool().stats();
+    verbose_assert(st.objects_in_use == 10000, "pool objects in use");
+    verbose_assert(Pooled::memory_pool().bytes() < 10000 * 2 * sizeof(Pooled),
+		   "pool overhead");
+
+    bool intact = true;
+    for (uint32_t i = 0; i < v.size(); i++)
+	intact = intact && (v[i]->v() == i);
+    verbose_assert(intact, "pool objects intact");
+
+    for (size_t i = 0; i < v.size(); i++)
+	delete v[i];
+    verbose_assert(Pooled::live() == 0, "pool objects destroyed");
+    verbose_assert(st.objects_in_use == 0, "pool objects freed");
+    verbose_assert(st.chunks == 1, "pool keeps one spare chunk");
+
+    SlabAllocator& a = SlabAllocator::size_class(20);
+    SlabAllocator& b = SlabAllocator::size_class(24);
+    SlabAllocator& c = SlabAllocator::size_class(25);
+    verbose_assert(&a == &b, "same size class");
+    verbose_assert(&b != &c, "different size classes");
+    verbose_assert(c.stats().object_size == 32, "size class rounding");
+
+    // An allocator destroyed with objects in use leaves them valid
+    SlabAllocator* doomed = new SlabAllocator(64);
+    void* p = doomed->alloc();
+    memset(p, 0xa5, 64);
+    delete doomed;
+    SlabAllocator::free(p);
+}
+
+/**
+ * Load a table of routes in a Trie, whose nodes are allocated from a
+ * size class, and report the insertion time and memory per route.
+ */
+static void
+test_trie_load()
+{
+    static const size_t ROUTES = 1000000;
+    typedef Trie<IPv4, uint32_t> RouteTrie;
+    typedef TrieNode<IPv4, uint32_t> RouteNode;
+
+    SlabAllocator& slab = SlabAllocator::size_class(sizeof(RouteNode));
+    size_t nodes_before = slab.stats().objects_in_use;
+
+    SystemClock clock;
+    TimeVal start, end;
+    clock.advance_time();
+    clock.current_time(start);
+
+    RouteTrie trie;
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < ROUTES; i++) {
+	x = x * 1103515245 + 12345;	// deterministic, well spread
+	uint32_t len = 16 + (x >> 8) % 9;
+	trie.insert(IPv4Net(IPv4(htonl(x)), len), i);
+    }
+
+    clock.advance_time();
+    clock.current_time(end);
+
+    size_t routes = trie.route_count();
+    size_t nodes = slab.stats().objects_in_use - nodes_before;
+    verbose_assert(routes > ROUTES / 2, "routes loaded");
+    verbose_assert(nodes >= routes, "one node per route at least");
+
+    printf("%u routes, %u nodes: %.3f us/insert, "
+	   "%.1f node bytes/route (%u byte slots)\n",
+	   XORP_UINT_CAST(routes), XORP_UINT_CAST(nodes),
+	   (end - start).get_double() * 1000000.0 / ROUTES,
+	   (double)(nodes * slab.stats().object_size) / routes,
+	   XORP_UINT_CAST(slab.stats().object_size));
+
+    trie.delete_all_nodes();
+    verbose_assert(slab.stats().objects_in_use == nodes_before,
+		   "all nodes freed");
+    verbose_log("%s\n", slab.str().c_str());
+}
+
+int
+main(int argc, char * const argv[])
+{
+    int ret_value = 0;
+
+    //
+    // Initialize and start xlog
+    //
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);         // Least verbose messages
+    // XXX: verbosity of the error messages temporary increased
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    int ch;
+    while ((ch = getopt(argc, argv, "hv")) != -1) {
+	switch (ch) {
+	case 'v':
+	    set_verbose(true);
+	    break;
+	case 'h':
+	case '?':
+	default:
+	    usage(argv[0]);
+	    xlog_stop();
+	    xlog_exit();
+	    if (ch == 'h')
+		return (0);
+	    else
+		return (1);
+	}
+    }
+    argc -= optind;
+    argv += optind;
+
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+    try {
+	test_chunks();
+	test_indices();
+	test_pools();
+	test_trie_load();
+	ret_value = failures() ? 1 : 0;
+    } catch (...) {
+	// Internal error
+	xorp_print_standard_exceptions();
+	ret_value = 2;
+    }
+
+    //
+    // Gracefully stop and exit xlog
+    //
+    xlog_stop();
+    xlog_exit();
+
+    return (ret_value);
+}
@@ -31,6 +31,8 @@
 #include "clock.hh"
 #include "timeval.hh"
 #include "timer.hh"
+#include "ipv4net.hh"
+#include "ipv6net.hh"
 
 #ifndef	DEBUG_LOGGING
 #define DEBUG_LOGGING
@@ -230,6 +232,186 @@ test4(TestInfo& info)
     return true;
 }
 
+/**
+ * Binary entries, and overwriting the oldest entries of a full log.
+ */
+bool
+test5(TestInfo& info)
+{
+    Profile p;
+    string ar = "add_route";
+    p.create(ar, "", 64);
+
+    p.enable(ar);
+    p.log(ar, "first");
+    for (uint64_t i = 0; i < 100; i++)
+	p.log_event(ar, "add", i);
+    p.disable(ar);
+
+    p.lock_log(ar);
+    ProfileLogEntry ple;
+    TimeVal last;
+    int i;
+    for (i = 0; p.read_log(ar, ple); i++) {
+	string expected = c_format("add %d", 100 - 64 + i);
+	if (ple.loginfo() != expected) {
+	    DOUT(info) << "Expected " << expected << " got " <<
+		ple.loginfo() << endl;
+	    return false;
+	}
+	if (ple.time() < last) {
+	    DOUT(info) << "Entries out of order\n";
+	    return false;
+	}
+	last = ple.time();
+    }
+    p.release_log(ar);
+
+    if (i != 64) {
+	DOUT(info) << "Expected 64 entries got " << i << endl;
+	return false;
+    }
+
+    return true;
+}
+
+/**
+ * Histogram mode.
+ */
+bool
+test6(TestInfo& info)
+{
+    Profile p;
+    string lat = "latency";
+    p.create(lat);
+
+    p.set_histogram(lat, true);
+    p.enable(lat);
+    for (uint64_t i = 1; i <= 1000; i++)
+	p.log_event(lat, "lookup", i);
+    uint64_t start = Profile::timestamp();
+    p.log_latency(lat, "lookup", start);
+    p.disable(lat);
+
+    DOUT(info) << p.get_histogram(lat);
+    DOUT(info) << p.get_list();
+
+    // Nothing is logged in histogram mode.
+    p.lock_log(lat);
+    ProfileLogEntry ple;
+    if (p.read_log(lat, ple)) {
+	DOUT(info) << "Unexpected entry " << ple.loginfo() << endl;
+	return false;
+    }
+    p.release_log(lat);
+
+    Profile::Histogram h;
+    for (uint64_t i = 1; i <= 1000; i++)
+	h.add(i);
+    if (h.count() != 1000 || h.bucket(1) != 1 || h.bucket(10) != 1000 - 511) {
+	DOUT(info) << "Bad bucket counts\n" << h.str();
+	return false;
+    }
+    if (h.percentile(0.5) != 511 || h.percentile(0.99) != 1000) {
+	DOUT(info) << "Bad percentiles\n" << h.str();
+	return false;
+    }
+
+    if (p.get_histogram(lat).find("count 1001 ") != 0) {
+	DOUT(info) << "Bad histogram\n" << p.get_histogram(lat);
+	return false;
+    }
+
+    p.clear(lat);
+    if (p.get_histogram(lat).find("count 0 ") != 0) {
+	DOUT(info) << "Histogram not cleared\n";
+	return false;
+    }
+
+    return true;
+}
+
+/**
+ * Compare the cost of text and binary entries.
+ */
+bool
+test7(TestInfo& info)
+{
+    static const int EVENTS = 1000000;
+    Profile p;
+    string ar = "add_route";
+    p.create(ar);
+    p.enable(ar);
+
+    IPv4Net net("10.0.0.0/8");
+    SystemClock clock;
+    TimeVal start, text, binary;
+
+    clock.advance_time();
+    clock.current_time(start);
+    for (int i = 0; i < EVENTS; i++) {
+	if (p.enabled(ar))
+	    p.log(ar, c_format("add %s", net.str().c_str()));
+    }
+    clock.advance_time();
+    clock.current_time(text);
+    for (int i = 0; i < EVENTS; i++) {
+	if (p.enabled(ar))
+	    p.log_net(ar, "add", net);
+    }
+    clock.advance_time();
+    clock.current_time(binary);
+
+    DOUT(info) << c_format("text: %.1f ns/entry, binary: %.1f ns/entry\n",
+			   (text - start).get_double() * 1e9 / EVENTS,
+			   (binary - text).get_double() * 1e9 / EVENTS);
+
+    return true;
+}
+
+/**
+ * Binary entries about networks.
+ */
+bool
+test8(TestInfo& info)
+{
+    Profile p;
+    string ar = "add_route";
+    p.create(ar);
+
+    p.enable(ar);
+    p.log_net(ar, "add", IPv4Net("10.1.0.0/16"), 5);
+    p.log_net(ar, "delete", IPv6Net("2001:db8::/32"));
+    p.log_event(ar, "flush");
+    p.disable(ar);
+
+    const char* expected[] = {
+	"add 10.1.0.0/16 5",
+	"delete 2001:db8::/32 0",
+	"flush 0",
+    };
+
+    p.lock_log(ar);
+    ProfileLogEntry ple;
+    size_t i;
+    for (i = 0; p.read_log(ar, ple); i++) {
+	if (i >= sizeof(expected) / sizeof(expected[0])
+	    || ple.loginfo() != expected[i]) {
+	    DOUT(info) << "Unexpected entry " << ple.loginfo() << endl;
+	    return false;
+	}
+    }
+    p.release_log(ar);
+
+    if (i != sizeof(expected) / sizeof(expected[0])) {
+	DOUT(info) << "Expected " << sizeof(expected) / sizeof(expected[0])
+		   << " entries got " << i << endl;
+	return false;
+    }
+
+    return true;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -257,6 +439,10 @@ main(int argc, char **argv)
 	{"test2", callback(test2)},
 	{"test3", callback(test3)},
 	{"test4", callback(test4)},
+	{"test5", callback(test5)},
+	{"test6", callback(test6)},
+	{"test7", callback(test7)},
+	{"test8", callback(test8)},
     };
 
     try {
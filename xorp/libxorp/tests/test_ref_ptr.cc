@@ -26,10 +26,18 @@
 #include "libxorp/xorp.h"
 #include "libxorp/xlog.h"
 #include "libxorp/exceptions.hh"
+#include "libxorp/clock.hh"
+#include "libxorp/random.h"
+#include "libxorp/timeval.hh"
 
 #ifdef HAVE_GETOPT_H
 #include <getopt.h>
 #endif
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 
 #include "ref_ptr.hh"
 
@@ -80,7 +88,8 @@ static void
 usage(const char* progname)
 {
     print_program_info(stderr);
-    fprintf(stderr, "usage: %s [-v] [-h]\n", progname);
+    fprintf(stderr, "usage: %s [-v] [-b] [-h]\n", progname);
+    fprintf(stderr, "       -b          : benchmark ref_ptr against iref_ptr\n");
     fprintf(stderr, "       -h          : usage (this message)\n");
     fprintf(stderr, "       -v          : verbose output\n");
 }
@@ -96,6 +105,17 @@ protected:
     bool& _flag;
 };
 
+/**
+ * Same as FlagSetDestructor, counted by iref_ptr.
+ */
+class CountedFlagSetDestructor : public ref_counted {
+public:
+    CountedFlagSetDestructor(bool& flag_to_set) : _flag(flag_to_set) {}
+    ~CountedFlagSetDestructor() { _flag = true; }
+protected:
+    bool& _flag;
+};
+
 /**
  * Run through tests of some common operations on a ref_ptr object.
  */
@@ -184,9 +204,157 @@ run_test()
     }
     verbose_log("Pass.\n");
 
+    verbose_log("Running iref_ptr test:\n");
+    deleted = false;
+    {
+	iref_ptr<CountedFlagSetDestructor> rp =
+	    new CountedFlagSetDestructor(deleted);
+	{
+	    if (play_with_counts(rp, 1)) {
+		return 1;
+	    }
+	}
+	// A second pointer made from the raw pointer shares the count
+	iref_ptr<CountedFlagSetDestructor> rp2 = rp.get();
+	if (rp2.at_least(2) == false || rp.get()->ref_count() != 2) {
+	    verbose_log("Failed to share count with raw pointer copy\n");
+	    return 1;
+	}
+	rp2.release();
+	if (deleted || rp.is_only() == false) {
+	    verbose_log("Failed to release reference\n");
+	    return 1;
+	}
+    }
+    if (deleted == false) {
+	verbose_log("Failed to delete object.\n");
+	return 1;
+    }
+    verbose_log("Pass.\n");
+
     return 0;
 };
 
+/**
+ * Hardware cache miss counter for the calling thread, if the system
+ * supports it.
+ */
+class CacheMissCounter {
+public:
+    CacheMissCounter() : _fd(-1) {
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~CacheMissCounter() {
+	if (_fd >= 0)
+	    close(_fd);
+    }
+
+    bool ok() const { return _fd >= 0; }
+
+    void start() {
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	if (_fd >= 0) {
+	    ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+	    ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+    }
+
+    uint64_t stop() {
+	uint64_t count = 0;
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	if (_fd >= 0) {
+	    ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+	    if (read(_fd, &count, sizeof(count)) != sizeof(count))
+		count = 0;
+	}
+#endif
+	return count;
+    }
+
+private:
+    int _fd;
+};
+
+struct PlainObject {
+    PlainObject(uint32_t v) : value(v) {}
+    uint32_t value;
+};
+
+struct CountedObject : public ref_counted {
+    CountedObject(uint32_t v) : value(v) {}
+    uint32_t value;
+};
+
+/**
+ * Copy pointers to a large set of objects in random order and read the
+ * objects through the copies, as done when dispatching callbacks or
+ * walking a list of LSAs.
+ */
+template <class Ptr, class Obj>
+static void
+benchmark(const char* name, size_t n, size_t rounds)
+{
+    vector<Ptr> ptrs;
+    vector<size_t> order(n);
+
+    ptrs.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+	ptrs.push_back(Ptr(new Obj(i)));
+	order[i] = i;
+    }
+    for (size_t i = n - 1; i > 0; i--)
+	swap(order[i], order[xorp_random() % (i + 1)]);
+
+    SystemClock clock;
+    CacheMissCounter misses;
+    TimeVal start, end;
+    uint32_t sum = 0;
+
+    clock.advance_time();
+    clock.current_time(start);
+    misses.start();
+    for (size_t r = 0; r < rounds; r++) {
+	for (size_t i = 0; i < n; i++) {
+	    Ptr copy = ptrs[order[i]];
+	    sum += copy->value;
+	}
+    }
+    uint64_t n_misses = misses.stop();
+    clock.advance_time();
+    clock.current_time(end);
+
+    double ops = double(n) * double(rounds);
+    double secs = (end - start).get_double();
+    printf("%-9s %8.2f Mops/s", name, ops / secs / 1e6);
+    if (misses.ok())
+	printf("  %6.2f cache misses/op", double(n_misses) / ops);
+    else
+	printf("  (cache miss counter not available)");
+    printf("\n");
+    verbose_log("checksum %u\n", XORP_UINT_CAST(sum));
+}
+
+static void
+run_benchmark()
+{
+    static const size_t N = 1000000;
+    static const size_t ROUNDS = 10;
+
+    benchmark<ref_ptr<PlainObject>, PlainObject>("ref_ptr", N, ROUNDS);
+    benchmark<iref_ptr<CountedObject>, CountedObject>("iref_ptr", N, ROUNDS);
+}
+
 int
 main(int argc, char * const argv[])
 {
@@ -202,9 +370,13 @@ main(int argc, char * const argv[])
     xlog_add_default_output();
     xlog_start();
 
+    bool do_benchmark = false;
     int ch;
-    while ((ch = getopt(argc, argv, "hv")) != -1) {
+    while ((ch = getopt(argc, argv, "bhv")) != -1) {
         switch (ch) {
+        case 'b':
+            do_benchmark = true;
+            break;
         case 'v':
             set_verbose(true);
             break;
@@ -235,6 +407,8 @@ main(int argc, char * const argv[])
 		}
 	    }
 	}
+	if (ret_value == 0 && do_benchmark)
+	    run_benchmark();
     } catch (...) {
         // Internal error
         xorp_print_standard_exceptions();
@@ -0,0 +1,395 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/c_format.hh"
+#include "libxorp/clock.hh"
+#include "libxorp/timeval.hh"
+#include "libxorp/selector.hh"
+
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+
+//
+// XXX: MODIFY FOR YOUR TEST PROGRAM
+//
+static const char *program_name		= "test_selector";
+static const char *program_description	= "Test and benchmark SelectorList backends";
+static const char *program_version_id	= "0.1";
+static const char *program_date		= "October 17, 2026";
+static const char *program_copyright	= "See file LICENSE";
+static const char *program_return_value	= "0 on success, 1 if test error, 2 if internal error";
+
+static bool s_verbose = false;
+bool verbose()			{ return s_verbose; }
+void set_verbose(bool v)	{ s_verbose = v; }
+
+static int s_failures = 0;
+bool failures()			{ return s_failures; }
+void incr_failures()		{ s_failures++; }
+
+#include "libxorp/xorp_tests.hh"
+
+/**
+ * Print program info to output stream.
+ *
+ * @param stream the output stream the print the program info to.
+ */
+static void
+print_program_info(FILE *stream)
+{
+    fprintf(stream, "Name:          %s\n", program_name);
+    fprintf(stream, "Description:   %s\n", program_description);
+    fprintf(stream, "Version:       %s\n", program_version_id);
+    fprintf(stream, "Date:          %s\n", program_date);
+    fprintf(stream, "Copyright:     %s\n", program_copyright);
+    fprintf(stream, "Return:        %s\n", program_return_value);
+}
+
+/**
+ * Print program usage information to the stderr.
+ *
+ * @param progname the name of the program.
+ */
+static void
+usage(const char* progname)
+{
+    print_program_info(stderr);
+    fprintf(stderr, "usage: %s [-v] [-h]\n", progname);
+    fprintf(stderr, "       -h          : usage (this message)\n");
+    fprintf(stderr, "       -v          : verbose output\n");
+    fprintf(stderr, "Return 0 on success, 1 if test error, 2 if internal error.\n");
+}
+
+static const char*
+backend_str(SelectorList::Backend backend)
+{
+    return (backend == SelectorList::BACKEND_EPOLL) ? "epoll" : "select";
+}
+
+/**
+ * Try to make room for at least n open file descriptors.
+ *
+ * @return true if n descriptors can be opened.
+ */
+static bool
+reserve_descriptors(size_t n)
+{
+#ifdef HAVE_SYS_RESOURCE_H
+    struct rlimit rl;
+
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0)
+	return false;
+    if (rl.rlim_cur >= n)
+	return true;
+    if ((rl.rlim_max != RLIM_INFINITY) && (rl.rlim_max < n))
+	return false;
+    rl.rlim_cur = n;
+    return (setrlimit(RLIMIT_NOFILE, &rl) == 0);
+#else
+    return (n <= FD_SETSIZE);
+#endif
+}
+
+/**
+ * A set of descriptors registered with a SelectorList.
+ *
+ * A few descriptors are pipes with data pending, so they are always
+ * readable.  The rest are unbound UDP sockets which never become ready.
+ * The ready descriptors are spread evenly among the idle ones.
+ */
+class DescriptorSet {
+public:
+    DescriptorSet(SelectorList& sl, size_t n, size_t active);
+    ~DescriptorSet();
+
+    bool ok() const		{ return _ok; }
+    size_t dispatched() const	{ return _dispatched; }
+
+    void io_cb(XorpFd fd, IoEventType type, size_t idx);
+
+    bool check_fairness();
+
+    void set_priority(size_t active_idx, int priority);
+    size_t last_served() const	{ return _last_served; }
+    size_t active_index(size_t active_idx) const {
+	return _active[active_idx];
+    }
+
+private:
+    SelectorList&	_sl;
+    vector<int>		_fds;		// registered descriptors
+    vector<int>		_writers;	// write ends of the ready pipes
+    vector<size_t>	_active;	// indices of the ready descriptors
+    vector<size_t>	_counts;	// dispatch count per descriptor
+    size_t		_dispatched;
+    size_t		_last_served;
+    bool		_ok;
+};
+
+DescriptorSet::DescriptorSet(SelectorList& sl, size_t n, size_t active)
+    : _sl(sl), _counts(n, 0), _dispatched(0), _last_served(n), _ok(true)
+{
+    size_t stride = n / active;
+
+    for (size_t i = 0; i < n; i++) {
+	int fd;
+	if ((i % stride == 0) && (_active.size() < active)) {
+	    int p[2];
+	    if (pipe(p) != 0) {
+		_ok = false;
+		return;
+	    }
+	    if (write(p[1], "x", 1) != 1) {
+		_ok = false;
+		return;
+	    }
+	    fd = p[0];
+	    _writers.push_back(p[1]);
+	    _active.push_back(i);
+	} else {
+	    fd = socket(AF_INET, SOCK_DGRAM, 0);
+	    if (fd < 0) {
+		_ok = false;
+		return;
+	    }
+	}
+	_fds.push_back(fd);
+	if (! _sl.add_ioevent_cb(fd, IOT_READ,
+				 callback(this, &DescriptorSet::io_cb, i))) {
+	    _ok = false;
+	    return;
+	}
+    }
+}
+
+DescriptorSet::~DescriptorSet()
+{
+    for (size_t i = 0; i < _fds.size(); i++) {
+	_sl.remove_ioevent_cb(_fds[i], IOT_READ);
+	close(_fds[i]);
+    }
+    for (size_t i = 0; i < _writers.size(); i++)
+	close(_writers[i]);
+}
+
+void
+DescriptorSet::io_cb(XorpFd fd, IoEventType type, size_t idx)
+{
+    XLOG_ASSERT(type == IOT_READ);
+    XLOG_ASSERT((int)fd == _fds[idx]);
+
+    // XXX: leave the data in the pipe, so the descriptor stays ready.
+    _counts[idx]++;
+    _dispatched++;
+    _last_served = idx;
+}
+
+void
+DescriptorSet::set_priority(size_t active_idx, int priority)
+{
+    size_t idx = _active[active_idx];
+
+    _sl.remove_ioevent_cb(_fds[idx], IOT_READ);
+    _sl.add_ioevent_cb(_fds[idx], IOT_READ,
+		       callback(this, &DescriptorSet::io_cb, idx), priority);
+}
+
+/**
+ * Check that only the ready descriptors were dispatched, and that they
+ * were served round-robin.
+ */
+bool
+DescriptorSet::check_fairness()
+{
+    size_t lo = _counts[_active[0]];
+    size_t hi = lo;
+    size_t total = 0;
+
+    for (size_t i = 0; i < _active.size(); i++) {
+	size_t c = _counts[_active[i]];
+	lo = min(lo, c);
+	hi = max(hi, c);
+	total += c;
+    }
+
+    return ((total == _dispatched) && (hi - lo <= 1));
+}
+
+/**
+ * Dispatch events on n descriptors, of which a few are ready, and
+ * report the cost per dispatch.
+ */
+static void
+test_dispatch(SelectorList::Backend backend, size_t n)
+{
+    static const size_t ACTIVE = 10;
+    static const size_t DISPATCHES = 20000;
+    size_t active = min(n, ACTIVE);
+
+    if (! reserve_descriptors(n + active + 64)) {
+	printf("%-6s %6u descriptors: skipped (descriptor limit)\n",
+	       backend_str(backend), XORP_UINT_CAST(n));
+	return;
+    }
+    if ((backend == SelectorList::BACKEND_SELECT)
+	&& (n + active + 8 > FD_SETSIZE)) {
+	printf("%-6s %6u descriptors: skipped (FD_SETSIZE is %d)\n",
+	       backend_str(backend), XORP_UINT_CAST(n), FD_SETSIZE);
+	return;
+    }
+
+    SystemClock clock;
+    SelectorList sl(&clock, backend);
+    verbose_assert(sl.backend() == backend, "backend selection");
+
+    DescriptorSet ds(sl, n, active);
+    if (! verbose_assert(ds.ok(), "descriptor setup"))
+	return;
+    verbose_assert(sl.descriptor_count() == n, "descriptor count");
+
+    TimeVal start, end;
+    clock.advance_time();
+    clock.current_time(start);
+
+    size_t loops = 0;
+    while ((ds.dispatched() < DISPATCHES) && (loops++ < 2 * DISPATCHES))
+	sl.wait_and_dispatch(0);
+
+    clock.advance_time();
+    clock.current_time(end);
+
+    verbose_assert(ds.dispatched() == DISPATCHES, "dispatch count");
+    verbose_assert(ds.check_fairness(), "round-robin dispatch");
+
+    double usecs = (end - start).get_double() * 1000000.0;
+    printf("%-6s %6u descriptors: %8.3f us/dispatch\n",
+	   backend_str(backend), XORP_UINT_CAST(n),
+	   usecs / (double)ds.dispatched());
+}
+
+/**
+ * Check that the higher priority descriptor is served first.
+ */
+static void
+test_priority(SelectorList::Backend backend)
+{
+    SystemClock clock;
+    SelectorList sl(&clock, backend);
+
+    DescriptorSet ds(sl, 8, 2);
+    if (! verbose_assert(ds.ok(), "descriptor setup"))
+	return;
+
+    ds.set_priority(0, XorpTask::PRIORITY_BACKGROUND);
+    ds.set_priority(1, XorpTask::PRIORITY_HIGH);
+
+    sl.wait_and_dispatch(0);
+    verbose_assert(ds.last_served() == ds.active_index(1),
+		   c_format("%s: high priority served first",
+			    backend_str(backend)));
+    sl.wait_and_dispatch(0);
+    verbose_assert(ds.last_served() == ds.active_index(0),
+		   c_format("%s: low priority served next",
+			    backend_str(backend)));
+}
+
+static void
+test_backend(SelectorList::Backend backend)
+{
+    static const size_t sizes[] = { 10, 1000, 10000 };
+
+    if (! SelectorList::backend_supported(backend)) {
+	printf("%-6s not supported\n", backend_str(backend));
+	return;
+    }
+
+    test_priority(backend);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	test_dispatch(backend, sizes[i]);
+}
+
+int
+main(int argc, char * const argv[])
+{
+    int ret_value = 0;
+
+    //
+    // Initialize and start xlog
+    //
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);         // Least verbose messages
+    // XXX: verbosity of the error messages temporary increased
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    int ch;
+    while ((ch = getopt(argc, argv, "hv")) != -1) {
+	switch (ch) {
+	case 'v':
+	    set_verbose(true);
+	    break;
+	case 'h':
+	case '?':
+	default:
+	    usage(argv[0]);
+	    xlog_stop();
+	    xlog_exit();
+	    if (ch == 'h')
+		return (0);
+	    else
+		return (1);
+	}
+    }
+    argc -= optind;
+    argv += optind;
+
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+    try {
+	test_backend(SelectorList::BACKEND_SELECT);
+	test_backend(SelectorList::BACKEND_EPOLL);
+	ret_value = failures() ? 1 : 0;
+    } catch (...) {
+	// Internal error
+	xorp_print_standard_exceptions();
+	ret_value = 2;
+    }
+
+    //
+    // Gracefully stop and exit xlog
+    //
+    xlog_stop();
+    xlog_exit();
+
+    return (ret_value);
+}
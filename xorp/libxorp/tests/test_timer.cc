@@ -32,6 +32,8 @@
 
 #include "libxorp/timer.hh"
 #include "libxorp/eventloop.hh"
+#include "libxorp/clock.hh"
+#include "libxorp/random.h"
 #include "libxorp/xlog.h"
 
 int fired = 0 ;
@@ -165,6 +167,157 @@ test_zero_timer(EventLoop& eventloop)
     fprintf(stderr, "End ZeroTimer test\n");
 }
 
+//
+// A clock that only moves when told to, so a TimerList can be driven
+// through hours of timer activity in no time.
+//
+class ManualClock : public ClockBase {
+public:
+    ManualClock() : _now(1000, 0) {}
+    void advance_time() {}
+    void current_time(TimeVal& tv) { tv = _now; }
+    void advance(const TimeVal& d) { _now += d; }
+private:
+    TimeVal _now;
+};
+
+class OrderCheck {
+public:
+    OrderCheck(TimerList& tl) : _tl(tl), _fired(0) {}
+
+    void expire(TimeVal expiry) {
+	TimeVal now;
+	_tl.current_time(now);
+	// timers never fire early, and fire in expiry order
+	assert(expiry <= now);
+	assert(_last <= expiry);
+	_last = expiry;
+	_fired++;
+    }
+
+    // expire all the timers that are due
+    void run() {
+	TimeVal d;
+	while (_tl.get_next_delay(d) && d == TimeVal::ZERO())
+	    _tl.run();
+    }
+
+    int fired() const { return _fired; }
+
+private:
+    TimerList&	_tl;
+    TimeVal	_last;
+    int		_fired;
+};
+
+//
+// Schedule short and long timers, reschedule and cancel some of them,
+// and check that they expire exactly, whether or not they went through
+// the timing wheel.
+//
+static void
+test_wheel_order()
+{
+    static const int NT = 20000;
+    ManualClock clock;
+    TimerList tl(&clock);
+    OrderCheck oc(tl);
+    vector<XorpTimer> timers(NT);
+    vector<TimeVal> expiry(NT);
+    TimeVal now;
+
+    fprintf(stderr, "++ check expiry order of %d timers\n", NT);
+    for (int i = 0; i < NT; i++) {
+	// a third of the timers expire in less than a second
+	TimeVal wait(0, xorp_random() % 1000000);
+	if (i % 3)
+	    wait += TimeVal(xorp_random() % 3600, 0);
+	tl.current_time(now);
+	expiry[i] = now + wait;
+	timers[i] = tl.new_oneoff_at(expiry[i],
+				     callback(&oc, &OrderCheck::expire,
+					      expiry[i]));
+	if (i % 7 == 0)
+	    timers[i].unschedule();
+	clock.advance(TimeVal(0, xorp_random() % 1000));
+	oc.run();
+    }
+
+    int expected = 0;
+    for (int i = 0; i < NT; i++) {
+	if (timers[i].scheduled())
+	    expected++;
+    }
+    assert(tl.size() == (size_t)expected);
+
+    while (! tl.empty()) {
+	clock.advance(TimeVal(0, xorp_random() % 5000000));
+	oc.run();
+	tl.current_time(now);
+	for (int i = 0; i < NT; i++) {
+	    // every timer that is due has fired
+	    if (expiry[i] <= now)
+		assert(! timers[i].scheduled());
+	}
+    }
+    fprintf(stderr, "++ %d timers fired in order\n", oc.fired());
+}
+
+static void
+churn_cb()
+{
+}
+
+//
+// Keep a large number of long timers that are rescheduled over and over
+// again, as done for route and neighbor timeouts.
+//
+static double
+churn(bool use_wheel, int n, int rounds)
+{
+    ManualClock clock;
+    TimerList tl(&clock);
+    vector<XorpTimer> timers(n);
+    SystemClock sc;
+    TimeVal start, end;
+
+    tl.set_use_wheel(use_wheel);
+
+    sc.advance_time();
+    sc.current_time(start);
+    for (int i = 0; i < n; i++) {
+	timers[i] = tl.new_oneoff_after(TimeVal(30 + xorp_random() % 180, 0),
+					callback(churn_cb));
+    }
+    for (int r = 0; r < rounds; r++) {
+	for (int i = 0; i < n; i++) {
+	    timers[i].schedule_after(TimeVal(30 + xorp_random() % 180, 0));
+	}
+	clock.advance(TimeVal(1, 0));
+	tl.run();
+    }
+    for (int i = 0; i < n; i++)
+	timers[i].unschedule();
+    sc.advance_time();
+    sc.current_time(end);
+
+    assert(tl.empty());
+    return (end - start).get_double();
+}
+
+static void
+test_churn()
+{
+    static const int NT = 1000000;
+    static const int ROUNDS = 4;
+
+    fprintf(stderr, "++ churn %d timers %d times\n", NT, ROUNDS);
+    double heap_secs = churn(false, NT, ROUNDS);
+    double wheel_secs = churn(true, NT, ROUNDS);
+    fprintf(stderr, "heap:  %.3f s\n", heap_secs);
+    fprintf(stderr, "wheel: %.3f s\n", wheel_secs);
+}
+
 static void
 run_test()
 {
@@ -203,6 +356,11 @@ int main(int /* argc */, const char* argv[])
     xlog_add_default_output();
     xlog_start();
 
+    // XXX: TimerList is a singleton, so these run before the EventLoop
+    // is created.
+    test_wheel_order();
+    test_churn();
+
     run_test();
 
     //
@@ -36,6 +36,7 @@
 #include "xlog.h"
 #include "timer.hh"
 #include "clock.hh"
+#include "dispatch_stats.hh"
 
 // Implementation Notes:
 //
@@ -56,6 +57,14 @@
 // memory into the callback.  Under normal usage we expect XorpTimer
 // objects and the associated thunk values to have similar scope so
 // they both exist and disappear at the same time.
+//
+// TimerNode's that expire at least TimerWheel::WHEEL_MIN_DELAY_MS in the
+// future are not put straight in the heap of their priority, but in a
+// TimerWheel where they can be added and removed in constant time.  Most
+// such timers (e.g., route and neighbor timeouts) are rescheduled or
+// unscheduled long before they expire.  The wheel hands the nodes back at
+// the beginning of the tick they expire in, and they are then pushed in
+// their heap, so the expiry time and order of the timers are exact.
 
 //-----------------------------------------------------------------------------
 // Constants
@@ -90,8 +99,25 @@ void
 TimerNode::expire(XorpTimer& xorp_timer, void*)
 {
     // XXX: Implemented by children. Might be called only for custom timers.
-    if (! _cb.is_empty())
+    if (! _cb.is_empty()) {
+	DispatchProbe probe(DispatchStats::TIMER, _cb.get());
+	if (probe.active())
+	    probe.set_lateness(lateness_ns());
 	_cb->dispatch(xorp_timer);
+    }
+}
+
+uint64_t
+TimerNode::lateness_ns() const
+{
+    TimeVal now;
+
+    _list->current_time(now);
+    if (now <= _expires)
+	return 0;
+
+    TimeVal late = now - _expires;
+    return uint64_t(late.sec()) * 1000000000 + uint64_t(late.usec()) * 1000;
 }
 
 bool
@@ -166,6 +192,9 @@ private:
     OneoffTimerCallback _cb;
 
     void expire(XorpTimer&, void*) {
+	DispatchProbe probe(DispatchStats::TIMER, _cb.get());
+	if (probe.active())
+	    probe.set_lateness(lateness_ns());
 	_cb->dispatch();
     }
 };
@@ -182,7 +211,14 @@ private:
     TimeVal _period;
 
     void expire(XorpTimer& t, void*) {
-	if (_cb->dispatch())
+	bool again;
+	{
+	    DispatchProbe probe(DispatchStats::TIMER, _cb.get());
+	    if (probe.active())
+		probe.set_lateness(lateness_ns());
+	    again = _cb->dispatch();
+	}
+	if (again)
 	    t.reschedule_after(_period);
     }
 };
@@ -195,7 +231,7 @@ TimerList* the_timerlist = NULL;
 int timerlist_instance_count;
 
 TimerList::TimerList(ClockBase* clock)
-    : _clock(clock), _observer(NULL)
+    : _use_wheel(true), _clock(clock), _observer(NULL)
 {
     assert(the_timerlist == NULL);
     assert(timerlist_instance_count == 0);
@@ -370,11 +406,54 @@ TimerList::set_flag_after(const TimeVal& wait, bool *flag_ptr, bool to_value,
 			    priority);
 }
 
+void
+TimerList::set_use_wheel(bool v)
+{
+    acquire_lock();
+    _use_wheel = v;
+    if (! _use_wheel) {
+	// Move all the timers from the wheel to the heaps
+	_wheel_due.clear();
+	_wheel.pop_all(_wheel_due);
+	for (size_t i = 0; i < _wheel_due.size(); i++) {
+	    TimerNode* n = static_cast<TimerNode*>(_wheel_due[i]);
+	    find_heap(n->priority())->push(n->expiry(), n);
+	}
+	_wheel_due.clear();
+    }
+    release_lock();
+}
+
+void
+TimerList::advance_wheel()
+{
+    if (_wheel.size() == 0)
+	return;
+
+    TimeVal now;
+
+    current_time(now);
+
+    acquire_lock();
+    _wheel_due.clear();
+    _wheel.advance(now, _wheel_due);
+    for (size_t i = 0; i < _wheel_due.size(); i++) {
+	TimerNode* n = static_cast<TimerNode*>(_wheel_due[i]);
+	find_heap(n->priority())->push(n->expiry(), n);
+    }
+    _wheel_due.clear();
+    release_lock();
+}
+
 int
 TimerList::get_expired_priority() const
 {
     TimeVal now;
 
+    // XXX: moving the timers from the wheel to the heaps doesn't change
+    // the set of scheduled timers, hence the const_cast.
+    const_cast<TimerList*>(this)->advance_wheel();
+
     current_time(now);
 
     //
@@ -394,6 +473,8 @@ TimerList::get_expired_priority() const
 void
 TimerList::run()
 {
+    advance_wheel();
+
     //
     // Run through in increasing priority until we find a timer to expire
     //
@@ -470,6 +551,8 @@ TimerList::empty() const
 	if (hi->second->top() != 0)
 	    result = false;
     }
+    if (_wheel.size() != 0)
+	result = false;
     release_lock();
 
     return result;
@@ -485,6 +568,7 @@ TimerList::size() const
     for (hi = _heaplist.begin(); hi != _heaplist.end(); ++hi) {
 	result += hi->second->size();
     }
+    result += _wheel.size();
     release_lock();
 
     return result;
@@ -507,17 +591,29 @@ TimerList::get_next_delay(TimeVal& tv) const
 	    t = tmp_t;
     }
 
+    // the wheel needs to be advanced before its earliest timer expires
+    TimeVal wheel_key;
+    bool wheel_event = _wheel.next_event(wheel_key);
+
     release_lock();
 
-    if (t == 0) {
+    if (t == 0 && ! wheel_event) {
 	tv = TimeVal::MAXIMUM();
 	return false;
     } else {
+	TimeVal key;
+	if (t == 0)
+	    key = wheel_key;
+	else if (wheel_event)
+	    key = min(t->key, wheel_key);
+	else
+	    key = t->key;
+
 	TimeVal now;
 	_clock->current_time(now);
-	if (t->key > now) {
+	if (key > now) {
 	    // next event is in the future
-	    tv = t->key - now ;
+	    tv = key - now ;
 	} else {
 	    // next event is already in the past, return 0.0
 	    tv = TimeVal::ZERO();
@@ -530,8 +626,16 @@ void
 TimerList::schedule_node(TimerNode* n)
 {
     acquire_lock();
-    Heap *heap = find_heap(n->priority());
-    heap->push(n->expiry(), n);
+    bool in_wheel = false;
+    if (_use_wheel) {
+	TimeVal now;
+	current_time(now);
+	in_wheel = _wheel.push(n->expiry(), now, n);
+    }
+    if (! in_wheel) {
+	Heap *heap = find_heap(n->priority());
+	heap->push(n->expiry(), n);
+    }
     release_lock();
     if (_observer) _observer->notify_scheduled(n->expiry());
     assert(n->scheduled());
@@ -541,8 +645,12 @@ void
 TimerList::unschedule_node(TimerNode *n)
 {
     acquire_lock();
-    Heap *heap = find_heap(n->priority());
-    heap->pop_obj(n);
+    if (n->in_wheel()) {
+	_wheel.pop_obj(n);
+    } else {
+	Heap *heap = find_heap(n->priority());
+	heap->pop_obj(n);
+    }
     release_lock();
     if (_observer) _observer->notify_unscheduled(n->expiry());
 }
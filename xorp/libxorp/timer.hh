@@ -32,6 +32,7 @@
 
 #include "timeval.hh"
 #include "heap.hh"
+#include "timer_wheel.hh"
 #include "callback.hh"
 #include "task.hh"
 
@@ -403,6 +404,25 @@ public:
      */
     static TimerList* instance();
 
+    /**
+     * Enable or disable the timing wheel.
+     *
+     * By default timers that expire at least
+     * @ref TimerWheel::WHEEL_MIN_DELAY_MS in the future are kept in a
+     * @ref TimerWheel, and only moved to the per-priority heaps shortly
+     * before they expire.  This makes scheduling and unscheduling such
+     * timers O(1).  If the wheel is disabled, all the timers are kept in
+     * the heaps.
+     *
+     * @param v true to enable the timing wheel, otherwise false.
+     */
+    void set_use_wheel(bool v);
+
+    /**
+     * @return true if the timing wheel is enabled.
+     */
+    bool use_wheel() const		{ return _use_wheel; }
+
 private:
     void schedule_node(TimerNode* t);		// insert in time ordered pos.
     void unschedule_node(TimerNode* t);		// remove from list
@@ -418,6 +438,9 @@ private:
     // expire the highest priority timer
     bool expire_one(int worst_priority);
 
+    // move the timers that are due soon from the wheel to the heaps
+    void advance_wheel();
+
 private:
     // The following is not a noncopyable candidate.
     TimerList(const TimerList&);		// Not copyable.
@@ -427,6 +450,11 @@ private:
     // we need one heap for each priority level
     map<int, Heap*>		_heaplist;
 
+    // timers that expire far enough in the future
+    TimerWheel			_wheel;
+    vector<TimerWheelObjBase*>	_wheel_due;
+    bool			_use_wheel;
+
     ClockBase* 			_clock;
     TimerListObserverBase* 	_observer;
 #ifdef HOST_OS_WINDOWS
@@ -439,7 +467,8 @@ private:
 
 class TimerNode :
     public NONCOPYABLE,
-    public HeapBase
+    public HeapBase,
+    public TimerWheelObjBase
 {
 protected:
     TimerNode(TimerList*, BasicTimerCallback);
@@ -452,10 +481,11 @@ protected:
     TimerNode(const TimerNode&);	// never called
     TimerNode& operator=(const TimerNode&);
 
-    bool scheduled()		const	{ return _pos_in_heap >= 0; }
+    bool scheduled()		const	{ return _pos_in_heap >= 0 || in_wheel(); }
     int priority()		const	{ return _priority; }
     const TimeVal& expiry()	const	{ return _expires; }
     bool time_remaining(TimeVal& remain) const;
+    uint64_t lateness_ns() const;	// How late the node expires
 
     void schedule_at(const TimeVal&, int priority);
     void schedule_after(const TimeVal& wait, int priority);
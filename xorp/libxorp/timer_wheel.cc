@@ -0,0 +1,252 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "libxorp_module.h"
+#include "libxorp/xorp.h"
+
+#include "libxorp/xlog.h"
+
+#include "timer_wheel.hh"
+
+// Implementation Notes:
+//
+// This is the classic hashed hierarchical timing wheel (Varghese and
+// Lauck), as used by the BSD and Linux kernels.  Time is measured in
+// ticks of WHEEL_TICK_MS.  _now_tick is the next tick to be processed:
+// all the level 0 slots for earlier ticks have already been emptied.
+//
+// An object due at tick t is stored on level 0 in slot (t & L0_MASK) if
+// it is due within WHEEL_L0_SIZE ticks, otherwise on the lowest level L
+// whose span covers it, in slot ((t >> shift(L)) & LN_MASK).  When
+// _now_tick crosses a multiple of WHEEL_L0_SIZE, the matching level 1
+// slot is re-inserted ("cascaded") into level 0, and so on up the
+// levels whenever a level wraps around.
+
+TimerWheel::TimerWheel()
+    : _now_tick(0), _elements(0)
+{
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+	_slots[i] = NULL;
+    for (int i = 0; i < WHEEL_LEVELS; i++)
+	_level_count[i] = 0;
+}
+
+TimerWheel::~TimerWheel()
+{
+    vector<TimerWheelObjBase*> removed;
+
+    pop_all(removed);
+}
+
+int64_t
+TimerWheel::to_tick(const TimeVal& tv)
+{
+    int64_t ms = (int64_t)tv.sec() * 1000 + tv.usec() / 1000;
+
+    return (ms / WHEEL_TICK_MS);
+}
+
+TimeVal
+TimerWheel::from_tick(int64_t tick)
+{
+    TimeVal tv;
+
+    tv.set_ms(tick * WHEEL_TICK_MS);
+    return (tv);
+}
+
+bool
+TimerWheel::push(const TimeVal& key, const TimeVal& now, TimerWheelObjBase* p)
+{
+    XLOG_ASSERT(! p->in_wheel());
+
+    if (key < now + TimeVal(0, WHEEL_MIN_DELAY_MS * 1000))
+	return (false);
+
+    int64_t tick = to_tick(key);
+
+    if (_elements == 0) {
+	// Nothing to process, so the wheel can start at the current tick.
+	int64_t now_tick = to_tick(now);
+	if (now_tick > _now_tick)
+	    _now_tick = now_tick;
+    }
+    if (tick < _now_tick)
+	return (false);
+
+    p->_wheel_tick = tick;
+    insert(p);
+    _elements++;
+
+    return (true);
+}
+
+void
+TimerWheel::pop_obj(TimerWheelObjBase* p)
+{
+    XLOG_ASSERT(p->in_wheel());
+
+    unlink(p);
+    _elements--;
+}
+
+void
+TimerWheel::insert(TimerWheelObjBase* p)
+{
+    int64_t tick = p->_wheel_tick;
+    int64_t delta = tick - _now_tick;
+    int level;
+    int idx;
+
+    if (delta < 0) {
+	tick = _now_tick;
+	delta = 0;
+    }
+
+    if (delta < WHEEL_L0_SIZE) {
+	level = 0;
+	idx = tick & WHEEL_L0_MASK;
+    } else {
+	for (level = 1; level < WHEEL_LEVELS - 1; level++) {
+	    if (delta < ((int64_t)1 << (shift(level) + WHEEL_LN_BITS)))
+		break;
+	}
+	if (delta >= ((int64_t)1 << (shift(level) + WHEEL_LN_BITS))) {
+	    // Beyond the span of the wheel: park the object in the farthest
+	    // slot, it will be re-inserted when that slot is cascaded.
+	    tick = _now_tick + ((int64_t)1 << (shift(level) + WHEEL_LN_BITS))
+		- 1;
+	}
+	idx = (tick >> shift(level)) & WHEEL_LN_MASK;
+    }
+
+    TimerWheelObjBase** head = &_slots[slot_offset(level) + idx];
+
+    p->_wheel_next = *head;
+    if (p->_wheel_next != NULL)
+	p->_wheel_next->_wheel_pprev = &p->_wheel_next;
+    p->_wheel_pprev = head;
+    p->_wheel_level = level;
+    *head = p;
+    _level_count[level]++;
+}
+
+void
+TimerWheel::unlink(TimerWheelObjBase* p)
+{
+    *p->_wheel_pprev = p->_wheel_next;
+    if (p->_wheel_next != NULL)
+	p->_wheel_next->_wheel_pprev = p->_wheel_pprev;
+    p->_wheel_next = NULL;
+    p->_wheel_pprev = NULL;
+    _level_count[p->_wheel_level]--;
+}
+
+void
+TimerWheel::cascade(int level, int idx)
+{
+    TimerWheelObjBase* p = _slots[slot_offset(level) + idx];
+
+    while (p != NULL) {
+	TimerWheelObjBase* next = p->_wheel_next;
+	unlink(p);
+	insert(p);
+	p = next;
+    }
+}
+
+void
+TimerWheel::advance(const TimeVal& now, vector<TimerWheelObjBase*>& due)
+{
+    int64_t now_tick = to_tick(now);
+
+    while ((_elements > 0) && (_now_tick <= now_tick)) {
+	int idx = _now_tick & WHEEL_L0_MASK;
+
+	if (idx == 0) {
+	    // Level 0 wrapped around: cascade the upper levels.
+	    for (int level = 1; level < WHEEL_LEVELS; level++) {
+		int lidx = (_now_tick >> shift(level)) & WHEEL_LN_MASK;
+		cascade(level, lidx);
+		if (lidx != 0)
+		    break;
+	    }
+	}
+
+	TimerWheelObjBase* p = _slots[idx];
+	while (p != NULL) {
+	    TimerWheelObjBase* next = p->_wheel_next;
+	    unlink(p);
+	    _elements--;
+	    due.push_back(p);
+	    p = next;
+	}
+	_now_tick++;
+
+	if (_level_count[0] == 0) {
+	    // Nothing on level 0: skip to the next cascade.
+	    int64_t next_cascade = (_now_tick + WHEEL_L0_MASK)
+		& ~(int64_t)WHEEL_L0_MASK;
+	    _now_tick = min(next_cascade, now_tick + 1);
+	}
+    }
+
+    if ((_elements == 0) && (_now_tick <= now_tick))
+	_now_tick = now_tick + 1;
+}
+
+void
+TimerWheel::pop_all(vector<TimerWheelObjBase*>& removed)
+{
+    for (int i = 0; i < WHEEL_SLOTS; i++) {
+	while (_slots[i] != NULL) {
+	    TimerWheelObjBase* p = _slots[i];
+	    unlink(p);
+	    _elements--;
+	    removed.push_back(p);
+	}
+    }
+    XLOG_ASSERT(_elements == 0);
+}
+
+bool
+TimerWheel::next_event(TimeVal& when) const
+{
+    if (_elements == 0)
+	return (false);
+
+    int64_t next_cascade = (_now_tick + WHEEL_L0_MASK)
+	& ~(int64_t)WHEEL_L0_MASK;
+
+    if (_level_count[0] > 0) {
+	for (int64_t tick = _now_tick; tick < next_cascade; tick++) {
+	    if (_slots[tick & WHEEL_L0_MASK] != NULL) {
+		when = from_tick(tick);
+		return (true);
+	    }
+	}
+    }
+
+    when = from_tick(next_cascade);
+    return (true);
+}
@@ -0,0 +1,163 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License, Version
+// 2.1, June 1999 as published by the Free Software Foundation.
+// Redistribution and/or modification of this program under the terms of
+// any other version of the GNU Lesser General Public License is not
+// permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU Lesser General Public License, Version 2.1, a copy of
+// which can be found in the XORP LICENSE.lgpl file.
+//
+// XORP, Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+#ifndef __LIBXORP_TIMER_WHEEL_HH__
+#define __LIBXORP_TIMER_WHEEL_HH__
+
+#include "xorp.h"
+#include "timeval.hh"
+
+class TimerWheel;
+
+/**
+ * Objects stored in a @ref TimerWheel should inherit from this class.
+ * It holds the links of the wheel slot the object is stored in, so that
+ * it can be removed in constant time.
+ */
+class TimerWheelObjBase {
+public:
+    TimerWheelObjBase() : _wheel_next(NULL), _wheel_pprev(NULL),
+			  _wheel_tick(0), _wheel_level(0) {}
+
+    /**
+     * @return true if the object is stored in a @ref TimerWheel.
+     */
+    bool in_wheel() const { return _wheel_pprev != NULL; }
+
+private:
+    TimerWheelObjBase*	_wheel_next;	// next object in the same slot
+    TimerWheelObjBase**	_wheel_pprev;	// the pointer that points to us
+    int64_t		_wheel_tick;	// the tick the object is due at
+    int			_wheel_level;	// the wheel level the object is on
+
+    friend class TimerWheel;
+};
+
+/**
+ * @short Hierarchical timing wheel
+ *
+ * A TimerWheel holds objects that are due far enough in the future that
+ * they are likely to be removed before they are due, for example timers
+ * that are rescheduled every time a route is refreshed.  Adding and
+ * removing an object costs O(1), independent of the number of objects.
+ *
+ * The wheel is coarse grained: it does not order the objects within a
+ * tick of WHEEL_TICK_MS milliseconds.  Objects are handed back by @ref
+ * advance at the beginning of the tick they are due in, i.e. never
+ * after their key, and are expected to be moved to a @ref Heap which
+ * orders them exactly.
+ *
+ * The wheel has one level of 256 one-tick slots, and four levels of 64
+ * slots each covering 64 times the span of a slot of the level below.
+ * Objects on the upper levels are cascaded down a level each time the
+ * level below wraps around.  Keys beyond the span of the wheel (about
+ * 497 days) are kept on the top level and re-examined each time their
+ * slot is cascaded.
+ */
+class TimerWheel : public NONCOPYABLE {
+public:
+    static const int	WHEEL_TICK_MS = 10;	// length of a tick
+    static const int	WHEEL_MIN_DELAY_MS = 1000; // nearer keys are refused
+
+    TimerWheel();
+    ~TimerWheel();
+
+    /**
+     * Add an object to the wheel.
+     *
+     * @param key the time the object is due at.
+     * @param now the current time.
+     * @param p the object to add.
+     * @return true on success, false if the object is due in less than
+     * WHEEL_MIN_DELAY_MS milliseconds, in which case it is not added.
+     */
+    bool push(const TimeVal& key, const TimeVal& now, TimerWheelObjBase* p);
+
+    /**
+     * Remove an object from the wheel.
+     *
+     * @param p the object to remove.
+     */
+    void pop_obj(TimerWheelObjBase* p);
+
+    /**
+     * Advance the wheel and remove the objects that are due.
+     *
+     * @param now the current time.
+     * @param due the objects whose tick has been reached are appended to
+     * this vector.  They are no longer part of the wheel.
+     */
+    void advance(const TimeVal& now, vector<TimerWheelObjBase*>& due);
+
+    /**
+     * Remove all the objects from the wheel.
+     *
+     * @param removed the objects are appended to this vector.
+     */
+    void pop_all(vector<TimerWheelObjBase*>& removed);
+
+    /**
+     * Get the time of the next wheel event, i.e. the earliest time that
+     * @ref advance may need to be called to hand back an object.
+     *
+     * @param when the time of the next event.
+     * @return true if there is an event, false if the wheel is empty.
+     */
+    bool next_event(TimeVal& when) const;
+
+    /**
+     * @return the number of objects in the wheel.
+     */
+    size_t size() const { return _elements; }
+
+private:
+    enum {
+	WHEEL_LEVELS	= 5,
+	WHEEL_L0_BITS	= 8,
+	WHEEL_L0_SIZE	= 1 << WHEEL_L0_BITS,
+	WHEEL_L0_MASK	= WHEEL_L0_SIZE - 1,
+	WHEEL_LN_BITS	= 6,
+	WHEEL_LN_SIZE	= 1 << WHEEL_LN_BITS,
+	WHEEL_LN_MASK	= WHEEL_LN_SIZE - 1,
+	WHEEL_SLOTS	= WHEEL_L0_SIZE + (WHEEL_LEVELS - 1) * WHEEL_LN_SIZE
+    };
+
+    static int64_t to_tick(const TimeVal& tv);
+    static TimeVal from_tick(int64_t tick);
+    static int shift(int level) {
+	return WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+    }
+    static int slot_offset(int level) {
+	return (level == 0) ? 0 : WHEEL_L0_SIZE + (level - 1) * WHEEL_LN_SIZE;
+    }
+
+    void insert(TimerWheelObjBase* p);
+    void unlink(TimerWheelObjBase* p);
+    void cascade(int level, int idx);
+
+    TimerWheelObjBase*	_slots[WHEEL_SLOTS];
+    size_t		_level_count[WHEEL_LEVELS];
+    int64_t		_now_tick;	// the next tick to be processed
+    size_t		_elements;
+};
+
+#endif // __LIBXORP_TIMER_WHEEL_HH__
@@ -33,6 +33,7 @@
 #include "xlog.h"
 #include "debug.h"
 #include "minitraits.hh"
+#include "memory_pool.hh"
 
 #ifndef XORP_USE_USTL
 #include <stack>
@@ -75,7 +76,7 @@ public:
      */
     TrieNode() : _up(0), _left(0), _right(0), _k(Key()), _p(0) {}
     TrieNode(const Key& key, const Payload& p, TrieNode* up = 0) :
-	_up(up), _left(0), _right(0), _k(key), _p(new PPayload(p)) {}
+	_up(up), _left(0), _right(0), _k(key), _p(new_payload(p)) {}
 
     explicit TrieNode(const Key& key, TrieNode* up = 0) :
 	_up(up), _left(0), _right(0), _k(key), _p(0) {}
@@ -86,6 +87,15 @@ public:
 	    delete_payload(_p);
     }
 
+    /**
+     * Nodes are allocated from the slab shared by all the objects of
+     * their size class.
+     */
+    void* operator new(size_t size) {
+	return SlabAllocator::size_class(size).alloc();
+    }
+    void operator delete(void* ptr)	{ SlabAllocator::free(ptr); }
+
     /**
      * add a node to a subtree
      * @return a pointer to the node.
@@ -132,7 +142,7 @@ public:
     void set_payload(const Payload& p) {
 	if (_p)
 	    delete_payload(_p);
-	_p = new PPayload(p);
+	_p = new_payload(p);
     }
 
     const Key &k() const			{ return _k;		}
@@ -276,9 +286,25 @@ public:
     }
 
 private:
+    /*
+     * Small payloads are allocated from the slab of their size class,
+     * rather than with a malloc() each.
+     */
+    static PPayload* new_payload(const Payload& p) {
+	if (sizeof(PPayload) > SlabAllocator::MAX_SIZE_CLASS)
+	    return new PPayload(p);
+	void* mem = SlabAllocator::size_class(sizeof(PPayload)).alloc();
+	return ::new (mem) PPayload(p);
+    }
+
     /* delete_payload is a separate method to allow specialization */
     void delete_payload(Payload* p) {
-	delete p;
+	if (sizeof(PPayload) > SlabAllocator::MAX_SIZE_CLASS) {
+	    delete p;
+	    return;
+	}
+	p->~Payload();
+	SlabAllocator::free(const_cast<PPayload*>(p));
     }
 
     void dump(const char *msg) const
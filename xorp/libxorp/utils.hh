@@ -315,4 +315,26 @@ xorp_leading_zero_count_uint32(uint32_t x)
     return (32 - xorp_bit_count_uint32(x));
 }
 
+/**
+ * Count the number of leading zeroes in a 64-bit wide integer.
+ *
+ * @param x the value to count the leading zeroes of.
+ * @return the number of leading zeroes in @ref x.
+ */
+inline uint32_t
+xorp_leading_zero_count_uint64(uint64_t x)
+{
+#if defined(__GNUC__)
+    if (x == 0)
+	return (64);
+    return (__builtin_clzll(x));
+#else
+    uint32_t hi = static_cast<uint32_t>(x >> 32);
+
+    if (hi != 0)
+	return (xorp_leading_zero_count_uint32(hi));
+    return (32 + xorp_leading_zero_count_uint32(static_cast<uint32_t>(x)));
+#endif
+}
+
 #endif // __LIBXORP_UTILS_HH__
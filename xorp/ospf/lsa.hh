@@ -262,13 +262,13 @@ compare_all_header_fields(const Lsa_header& lhs, const Lsa_header& rhs)
  *
  * A generic LSA. All actual LSAs should be derived from this LSA.
  */
-class Lsa {
+class Lsa : public ref_counted {
  public:
     /**
      * A reference counted pointer to an LSA which will be
      * automatically deleted.
      */
-    typedef ref_ptr<Lsa> LsaRef;
+    typedef iref_ptr<Lsa> LsaRef;
 
     Lsa(OspfTypes::Version version)
 	:  _header(version), _version(version), _valid(true),
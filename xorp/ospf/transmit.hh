@@ -36,9 +36,9 @@
  */
 
 template <typename A>
-class Transmit {
+class Transmit : public ref_counted {
  public:
-    typedef ref_ptr<Transmit> TransmitRef;
+    typedef iref_ptr<Transmit> TransmitRef;
 
     virtual ~Transmit()
     {}
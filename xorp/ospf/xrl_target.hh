@@ -23,6 +23,7 @@
 #ifndef __OSPF_XRL_TARGET_HH__
 #define __OSPF_XRL_TARGET_HH__
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/ospfv2_base.hh"
 
 #include "ospf.hh"
@@ -60,6 +61,14 @@ class XrlOspfV2Target : XrlOspfv2TargetBase {
 
     XrlCmdError common_0_1_startup();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      *  Receive an IPv4 packet from a raw socket.
      *
@@ -24,6 +24,7 @@
 #define __OSPF_XRL_TARGET3_HH__
 
 #ifdef HAVE_IPV6
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/ospfv3_base.hh"
 
 #include "ospf.hh"
@@ -65,6 +66,14 @@ class XrlOspfV3Target : XrlOspfv3TargetBase {
 
     XrlCmdError common_0_1_startup();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     /**
      *  Receive an IPv4 packet from a raw socket.
      *
@@ -0,0 +1,532 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "policy/policy_module.h"
+#include "libxorp/xorp.h"
+
+#ifndef XORP_USE_USTL
+#include <typeinfo>
+#endif
+
+#include "policy/common/policy_utils.hh"
+#include "policy/common/elem_null.hh"
+#include "policy/common/operator.hh"
+#include "compiled_exec.hh"
+
+// Implementation Notes:
+//
+// The code mirrors IvExec, which remains the reference: the policies are
+// run from last to first, each term on an empty stack frame, a NEXT
+// POLICY in a subroutine also ends the term of the caller, and results
+// created by operations are deleted once the VarRW is synced.
+//
+// The instructions of all the terms are in a single array, each term
+// ending with END_TERM.  Executing an instruction is a switch on its
+// code rather than a virtual accept() and visit() per instruction, and
+// no string is looked up at run time: sets are resolved when compiling,
+// unless they are missing, in which case the lookup is left to run time
+// so that it throws like IvExec does.
+//
+// An operation whose arguments are all constants is run when compiling,
+// and replaced by a push of its result, unless it fails or divides.
+// Otherwise, the Dispatcher callback found for the types of the
+// arguments is kept with the instruction, and called directly as long
+// as the arguments are of the same types.  Null arguments and constructors always go through
+// Dispatcher::run(), which special cases them.
+
+CompiledExec::CompiledExec() :
+	_compiled(false), _sman(NULL), _policy_count(0), _varrw(NULL),
+	_ctr_flow(Next::TERM), _true(true), _false(false)
+{
+    unsigned ss = 128;
+
+    _stack_bottom = new const Element*[ss];
+    _stackend = &_stack_bottom[ss];
+}
+
+CompiledExec::~CompiledExec()
+{
+    clear();
+    delete [] _stack_bottom;
+}
+
+bool
+CompiledExec::compile(vector<PolicyInstr*>& policies, SUBR& subr,
+		      const SetManager& sman)
+{
+    clear();
+
+    for (vector<PolicyInstr*>::iterator i = policies.begin();
+	 i != policies.end(); ++i) {
+	if ((*i)->trace())
+	    return false;
+    }
+    for (SUBR::iterator i = subr.begin(); i != subr.end(); ++i) {
+	if (i->second->trace())
+	    return false;
+    }
+
+    _sman = &sman;
+
+    // the subroutines follow the policies
+    unsigned index = policies.size();
+    for (SUBR::iterator i = subr.begin(); i != subr.end(); ++i)
+	_subr[i->first] = index++;
+
+    for (vector<PolicyInstr*>::iterator i = policies.begin();
+	 i != policies.end(); ++i)
+	compile_policy(**i);
+    for (SUBR::iterator i = subr.begin(); i != subr.end(); ++i)
+	compile_policy(*i->second);
+
+    _policy_count = policies.size();
+    _compiled = true;
+
+    return true;
+}
+
+void
+CompiledExec::clear()
+{
+    clear_trash();
+    policy_utils::clear_container(_consts);
+
+    _compiled = false;
+    _sman = NULL;
+    _subr.clear();
+    _code.clear();
+    _terms.clear();
+    _policies.clear();
+    _policy_count = 0;
+}
+
+void
+CompiledExec::compile_policy(PolicyInstr& pi)
+{
+    TermInstr** terms = pi.terms();
+    Policy policy;
+
+    policy.first_term = _terms.size();
+    policy.termc = pi.termc();
+
+    for (int i = 0; i < pi.termc(); i++) {
+	TermInstr* ti = terms[i];
+	Instruction** instr = ti->instructions();
+
+	_terms.push_back(_code.size());
+
+	for (int j = 0; j < ti->instrc(); j++)
+	    instr[j]->accept(*this);
+
+	emit(END_TERM);
+    }
+
+    _policies.push_back(policy);
+}
+
+void
+CompiledExec::emit(Code code)
+{
+    Instr instr;
+
+    instr.code = code;
+    instr.elem = NULL;
+    instr.key = 0;
+    instr.funct.bin = NULL;
+
+    _code.push_back(instr);
+}
+
+void
+CompiledExec::visit(Push& p)
+{
+    emit(PUSH);
+    _code.back().elem = &p.elem();
+}
+
+void
+CompiledExec::visit(PushSet& ps)
+{
+    try {
+	const Element& s = _sman->getSet(ps.setid());
+
+	emit(PUSH);
+	_code.back().elem = &s;
+    } catch (const SetManager::SetNotFound&) {
+	emit(PUSH_SET);
+	_code.back().setid = &ps.setid();
+    }
+}
+
+void
+CompiledExec::visit(OnFalseExit& /* x */)
+{
+    emit(ON_FALSE_EXIT);
+}
+
+void
+CompiledExec::visit(Load& l)
+{
+    emit(LOAD);
+    _code.back().var = l.var();
+}
+
+void
+CompiledExec::visit(Store& s)
+{
+    emit(STORE);
+    _code.back().var = s.var();
+}
+
+void
+CompiledExec::visit(Accept& /* a */)
+{
+    emit(ACCEPT);
+}
+
+void
+CompiledExec::visit(Reject& /* r */)
+{
+    emit(REJECT);
+}
+
+void
+CompiledExec::visit(NaryInstr& nary)
+{
+    const Oper& op = nary.op();
+
+    if (fold(op))
+	return;
+
+    switch (op.arity()) {
+    case 1:
+	emit(UNARY);
+	break;
+
+    case 2:
+	emit(BINARY);
+	break;
+
+    default:
+	emit(NARY);
+	break;
+    }
+
+    _code.back().op = &op;
+}
+
+void
+CompiledExec::visit(Next& next)
+{
+    switch (next.flow()) {
+    case Next::TERM:
+	emit(NEXT_TERM);
+	break;
+
+    case Next::POLICY:
+	emit(NEXT_POLICY);
+	break;
+    }
+}
+
+void
+CompiledExec::visit(Subr& sub)
+{
+    map<string, unsigned>::iterator i = _subr.find(sub.target());
+
+    emit(CALL);
+
+    // a missing subroutine asserts when run, like with IvExec
+    _code.back().policy = i == _subr.end() ? ~0U : i->second;
+}
+
+bool
+CompiledExec::fold(const Oper& op)
+{
+    unsigned argc = op.arity();
+    const Element* argv[2];
+
+    if (argc != 1 && argc != 2)
+	return false;
+
+    // a division by zero must only fail if it is run
+    if (typeid(op) == typeid(OpDiv))
+	return false;
+
+    // the arguments must be pushed by the term being compiled
+    if (_code.size() - _terms.back() < argc)
+	return false;
+
+    Instrs::iterator first = _code.end() - argc;
+    for (unsigned i = 0; i < argc; i++) {
+	if (first[i].code != PUSH)
+	    return false;
+	argv[i] = first[i].elem;
+    }
+
+    Dispatcher::Key key;
+    Dispatcher::Value funct;
+    if (!_disp.resolve(op, argc, argv, key, funct))
+	return false;
+
+    // an operation which fails is left to fail at run time
+    Element* r;
+    try {
+	if (argc == 1)
+	    r = funct.un(*argv[0]);
+	else
+	    r = funct.bin(*argv[1], *argv[0]);
+    } catch (const PolicyException&) {
+	return false;
+    }
+
+    // elements which are shared, such as booleans, are not ours to delete
+    if (r->refcount() == 1)
+	_consts.push_back(r);
+
+    _code.erase(first, _code.end());
+    emit(PUSH);
+    _code.back().elem = r;
+
+    return true;
+}
+
+IvExec::FlowAction
+CompiledExec::run(VarRW* varrw)
+{
+    XLOG_ASSERT(_compiled);
+    XLOG_ASSERT(varrw);
+
+    _varrw = varrw;
+
+    FlowAction ret = IvExec::DEFAULT;
+
+    // execute all policies
+    for (int i = _policy_count - 1; i >= 0; --i) {
+	FlowAction fa = run_policy(_policies[i], _stack_bottom);
+
+	// if a policy rejected/accepted a route then terminate.
+	if (fa != IvExec::DEFAULT) {
+	    ret = fa;
+	    break;
+	}
+    }
+
+    // varrw may hold pointers to trash elements
+    _varrw->sync();
+
+    clear_trash();
+
+    return ret;
+}
+
+IvExec::FlowAction
+CompiledExec::run_policy(const Policy& policy, const Element** stack)
+{
+    FlowAction outcome = IvExec::DEFAULT;
+
+    XLOG_ASSERT(stack < _stackend && stack >= _stack_bottom);
+
+    _varrw->enable_trace(false);
+
+    // execute terms sequentially
+    _ctr_flow = Next::TERM;
+
+    for (unsigned i = 0; i < policy.termc; i++) {
+	FlowAction fa = run_term(&_code[_terms[policy.first_term + i]],
+				 stack);
+
+	// if term accepted/rejected route, then terminate.
+	if (fa != IvExec::DEFAULT) {
+	    outcome = fa;
+	    break;
+	}
+
+	if (_ctr_flow == Next::POLICY)
+	    break;
+    }
+
+    return outcome;
+}
+
+IvExec::FlowAction
+CompiledExec::run_term(Instr* ip, const Element** stack)
+{
+    const Element** sp = stack - 1;
+    const Element* arg;
+    Element* r;
+
+    for (;; ip++) {
+	switch (ip->code) {
+	case PUSH:
+	    sp++;
+	    XLOG_ASSERT(sp < _stackend);
+	    *sp = ip->elem;
+	    break;
+
+	case PUSH_SET:
+	    arg = &_sman->getSet(*ip->setid);
+	    sp++;
+	    XLOG_ASSERT(sp < _stackend);
+	    *sp = arg;
+	    break;
+
+	case LOAD:
+	    arg = &_varrw->read_trace(ip->var);
+	    sp++;
+	    XLOG_ASSERT(sp < _stackend);
+	    *sp = arg;
+	    break;
+
+	case STORE:
+	    if (sp < stack)
+		xorp_throw(IvExec::RuntimeError, "Stack empty on assign of "
+			   + policy_utils::to_str(ip->var));
+
+	    arg = *sp--;
+
+	    // storing null is a NOP
+	    if (arg->hash() != ElemNull::_hash)
+		_varrw->write_trace(ip->var, *arg);
+	    break;
+
+	case ON_FALSE_EXIT:
+	    if (sp < stack)
+		xorp_throw(IvExec::RuntimeError,
+			   "Got empty stack on ON_FALSE_EXIT");
+
+	    // the element is not popped
+	    arg = *sp;
+	    if (arg->hash() == ElemBool::_hash) {
+		if (!static_cast<const ElemBool*>(arg)->val())
+		    return IvExec::DEFAULT;
+	    } else if (arg->hash() == ElemNull::_hash) {
+		return IvExec::DEFAULT;
+	    } else {
+		xorp_throw(IvExec::RuntimeError,
+			   "Expected bool on top of stack instead: ");
+	    }
+	    break;
+
+	case ACCEPT:
+	    return IvExec::ACCEPT;
+
+	case REJECT:
+	    return IvExec::REJ;
+
+	case NEXT_TERM:
+	    _ctr_flow = Next::TERM;
+	    return IvExec::DEFAULT;
+
+	case NEXT_POLICY:
+	    _ctr_flow = Next::POLICY;
+	    return IvExec::DEFAULT;
+
+	case UNARY:
+	    XLOG_ASSERT(sp >= stack);
+
+	    if (Dispatcher::key(*ip->op, 1, sp) == ip->key)
+		r = ip->funct.un(*sp[0]);
+	    else
+		r = run_nary(*ip, 1, sp);
+
+	    if (r->refcount() == 1)
+		_trash.push_back(r);
+	    *sp = r;
+	    break;
+
+	case BINARY:
+	    XLOG_ASSERT(sp - 1 >= stack);
+
+	    sp--;
+	    if (Dispatcher::key(*ip->op, 2, sp) == ip->key)
+		r = ip->funct.bin(*sp[1], *sp[0]);
+	    else
+		r = run_nary(*ip, 2, sp);
+
+	    if (r->refcount() == 1)
+		_trash.push_back(r);
+	    *sp = r;
+	    break;
+
+	case NARY:
+	{
+	    unsigned arity = ip->op->arity();
+
+	    XLOG_ASSERT((sp - arity + 1) >= stack);
+
+	    r = _disp.run(*ip->op, arity, sp - arity + 1);
+	    if (arity)
+		sp -= arity - 1;
+	    else
+		sp++;
+
+	    if (r->refcount() == 1)
+		_trash.push_back(r);
+
+	    XLOG_ASSERT(sp < _stackend && sp >= stack);
+	    *sp = r;
+	    break;
+	}
+
+	case CALL:
+	{
+	    XLOG_ASSERT(ip->policy < _policies.size());
+
+	    FlowAction fa = run_policy(_policies[ip->policy], sp + 1);
+
+	    sp++;
+	    XLOG_ASSERT(sp < _stackend);
+	    *sp = fa == IvExec::REJ ? &_false : &_true;
+	    break;
+	}
+
+	case END_TERM:
+	    return IvExec::DEFAULT;
+	}
+    }
+
+    // unreach
+    return IvExec::DEFAULT;
+}
+
+Element*
+CompiledExec::run_nary(Instr& instr, unsigned argc, const Element** argv)
+{
+    Element* r = _disp.run(*instr.op, argc, argv);
+
+    // keep the callback for the next arguments of the same types
+    Dispatcher::Key key;
+    Dispatcher::Value funct;
+    if (_disp.resolve(*instr.op, argc, argv, key, funct)) {
+	instr.key = key;
+	instr.funct = funct;
+    }
+
+    return r;
+}
+
+void
+CompiledExec::clear_trash()
+{
+    policy_utils::clear_container(_trash);
+}
@@ -0,0 +1,172 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __POLICY_BACKEND_COMPILED_EXEC_HH__
+#define __POLICY_BACKEND_COMPILED_EXEC_HH__
+
+#include "libxorp/xorp.h"
+
+#include "policy/common/dispatcher.hh"
+#include "policy/common/varrw.hh"
+#include "policy/common/element.hh"
+
+#include "instruction.hh"
+#include "set_manager.hh"
+#include "term_instr.hh"
+#include "policy_instr.hh"
+#include "policy_backend_parser.hh"
+#include "iv_exec.hh"
+
+/**
+ * @short Executes policies compiled to a flat array of instructions.
+ *
+ * The instructions of the policies are compiled once, when the filter is
+ * configured, into an array which is run by a single loop instead of a
+ * visitor.  The operands are resolved at compile time: the sets are
+ * looked up in the SetManager, operations on constants are folded, and
+ * the Dispatcher callback of each operation is cached, for the types of
+ * the arguments it was last run on.
+ *
+ * The outcome of the policies is the same as with IvExec, but there is no
+ * support for tracing and profiling the execution: policies which trace
+ * are not compiled.
+ */
+class CompiledExec :
+    public NONCOPYABLE,
+    public InstrVisitor
+{
+public:
+    typedef IvExec::FlowAction FlowAction;
+
+    CompiledExec();
+    ~CompiledExec();
+
+    /**
+     * Compile policies.
+     *
+     * The policies, subroutines and sets must not change or be deleted
+     * until the code is cleared.
+     *
+     * @return false if a policy traces, in which case nothing is compiled.
+     * @param policies the policies, run from last to first.
+     * @param subr the subroutines the policies may call.
+     * @param sman the sets the policies match against.
+     */
+    bool compile(vector<PolicyInstr*>& policies, SUBR& subr,
+		 const SetManager& sman);
+
+    /**
+     * Forget the compiled code.
+     */
+    void clear();
+
+    /**
+     * @return true if policies are compiled.
+     */
+    bool compiled() const		{ return _compiled; }
+
+    /**
+     * Execute the policies.
+     *
+     * @param varrw the VarRW of the route.
+     */
+    FlowAction run(VarRW* varrw);
+
+    /**
+     * Compile an instruction at the end of the term being compiled.
+     */
+    void visit(Push& p);
+    void visit(PushSet& ps);
+    void visit(OnFalseExit& x);
+    void visit(Load& l);
+    void visit(Store& s);
+    void visit(Accept& a);
+    void visit(Reject& r);
+    void visit(NaryInstr& nary);
+    void visit(Next& next);
+    void visit(Subr& sub);
+
+private:
+    enum Code {
+	PUSH,		// push elem
+	PUSH_SET,	// push the set setid, looked up at run time
+	LOAD,		// push variable var
+	STORE,		// pop into variable var
+	ON_FALSE_EXIT,
+	ACCEPT,
+	REJECT,
+	NEXT_TERM,
+	NEXT_POLICY,
+	UNARY,		// op on the top of the stack
+	BINARY,		// op on the two top elements of the stack
+	NARY,		// op of any other arity, run by the Dispatcher
+	CALL,		// run subroutine policy, push its outcome
+	END_TERM
+    };
+
+    struct Instr {
+	Code			code;
+	union {
+	    const Element*	elem;
+	    const string*	setid;
+	    VarRW::Id		var;
+	    unsigned		policy;
+	    const Oper*		op;
+	};
+
+	// The callback of op for the arguments it was last run on.
+	Dispatcher::Key		key;
+	Dispatcher::Value	funct;
+    };
+
+    struct Policy {
+	unsigned		first_term;
+	unsigned		termc;
+    };
+
+    typedef vector<Instr> Instrs;
+
+    void compile_policy(PolicyInstr& pi);
+    void emit(Code code);
+    bool fold(const Oper& op);
+    FlowAction run_policy(const Policy& policy, const Element** stack);
+    FlowAction run_term(Instr* ip, const Element** stack);
+    Element* run_nary(Instr& instr, unsigned argc, const Element** argv);
+    void clear_trash();
+
+    bool		_compiled;
+    const SetManager*	_sman;
+    map<string, unsigned> _subr;	// Index of each subroutine policy
+    Instrs		_code;
+    vector<unsigned>	_terms;		// Index of the first instruction
+    vector<Policy>	_policies;	// The policies, then the subroutines
+    unsigned		_policy_count;
+    vector<Element*>	_consts;	// Results of folded operations
+    const Element**	_stack_bottom;
+    const Element**	_stackend;
+    VarRW*		_varrw;
+    Dispatcher		_disp;
+    vector<Element*>	_trash;
+    Next::Flow		_ctr_flow;
+    ElemBool		_true;
+    ElemBool		_false;
+};
+
+#endif // __POLICY_BACKEND_COMPILED_EXEC_HH__
@@ -24,6 +24,7 @@
 #define __POLICY_BACKEND_FILTER_BASE_HH__
 
 #include "policy/common/varrw.hh"
+#include "filter_changes.hh"
 
 
 /**
@@ -56,6 +57,29 @@ public:
      * @param varrw the VarRW associated with the route being filtered.
      */
     virtual bool acceptRoute(VarRW& varrw) = 0;
+
+    /**
+     * Find the routes the configurations done since the last call may
+     * have changed the verdict of, and start again from the current
+     * configuration.
+     *
+     * Filters which do not keep track of their configurations report
+     * that all routes may have changed.
+     *
+     * @param changes the changes are added to this.
+     */
+    virtual void take_changes(FilterChanges& changes) { changes.set_all(); }
+
+    /**
+     * Find out if the result of the filter may depend on a variable.
+     *
+     * Filters which do not know what they read report that they read
+     * every variable.
+     *
+     * @return true if the filter may read the variable.
+     * @param var the variable.
+     */
+    virtual bool reads(const VarRW::Id& /* var */) const { return true; }
 };
 
 #endif // __POLICY_BACKEND_FILTER_BASE_HH__
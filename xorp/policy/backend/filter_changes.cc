@@ -0,0 +1,56 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "policy/policy_module.h"
+#include "libxorp/xorp.h"
+#include "filter_changes.hh"
+
+template <class N>
+static string
+nets_str(const map<VarRW::Id, set<N> >& nets)
+{
+    string s;
+
+    typename map<VarRW::Id, set<N> >::const_iterator i;
+    for (i = nets.begin(); i != nets.end(); ++i) {
+	s += c_format("var %d:", i->first);
+
+	typename set<N>::const_iterator j;
+	for (j = i->second.begin(); j != i->second.end(); ++j)
+	    s += " " + j->str();
+	s += "\n";
+    }
+
+    return s;
+}
+
+string
+FilterChanges::str() const
+{
+    if (_all)
+	return "all routes\n";
+
+    if (empty())
+	return "no route\n";
+
+    return nets_str(_nets4) + nets_str(_nets6);
+}
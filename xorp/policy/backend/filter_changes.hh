@@ -0,0 +1,80 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __POLICY_BACKEND_FILTER_CHANGES_HH__
+#define __POLICY_BACKEND_FILTER_CHANGES_HH__
+
+#include "libxorp/ipv4net.hh"
+#include "libxorp/ipv6net.hh"
+#include "policy/common/varrw.hh"
+
+/**
+ * @short The routes a reconfiguration of filters may filter differently.
+ *
+ * Either all the routes may be affected, or only the routes for which the
+ * network read from a variable overlaps one of a list of networks: those
+ * added to or removed from the prefix lists the filters match against.
+ */
+class FilterChanges {
+public:
+    typedef map<VarRW::Id, set<IPv4Net> > Nets4;
+    typedef map<VarRW::Id, set<IPv6Net> > Nets6;
+
+    FilterChanges() : _all(false) {}
+
+    /**
+     * Any route may be affected.
+     */
+    void set_all()			{ _all = true; }
+    bool all() const			{ return _all; }
+
+    /**
+     * The routes for which the network held by a variable overlaps a
+     * network may be affected.
+     *
+     * @param var the variable holding the network of the route.
+     * @param net the network.
+     */
+    void add_net(const VarRW::Id& var, const IPv4Net& net) {
+	_nets4[var].insert(net);
+    }
+    void add_net(const VarRW::Id& var, const IPv6Net& net) {
+	_nets6[var].insert(net);
+    }
+
+    const Nets4& nets4() const		{ return _nets4; }
+    const Nets6& nets6() const		{ return _nets6; }
+
+    /**
+     * @return true if no route is affected.
+     */
+    bool empty() const {
+	return !_all && _nets4.empty() && _nets6.empty();
+    }
+
+    string str() const;
+
+private:
+    bool	_all;
+    Nets4	_nets4;
+    Nets6	_nets6;
+};
+
+#endif // __POLICY_BACKEND_FILTER_CHANGES_HH__
@@ -24,6 +24,7 @@
 #include "libxorp/xorp.h"
 #include "libxorp/xlog.h"
 #include "policy/common/policy_utils.hh"
+#include "policy/common/elem_set.hh"
 #include "policy_filter.hh"
 #include "policy_backend_parser.hh"
 #include "set_manager.hh"
@@ -32,6 +33,95 @@
 using namespace policy_utils;
 using policy_backend_parser::policy_backend_parse;
 
+bool PolicyFilter::_compile = true;
+
+// Implementation Notes:
+//
+// Routes keep a reference to the version of the filter that last filtered
+// them [see VersionFilter], and are filtered again by the latest version
+// when routes are pushed.  Two versions with the same code, but which
+// differ in the contents of the prefix lists matched as "network <= set",
+// can only filter differently the routes whose network overlaps a
+// network added to or removed from these sets: the match of any other
+// route against the sets is the same.  These are the only changes which
+// are narrowed down to a list of networks.
+
+/**
+ * @return the configuration without the sets.
+ */
+static string
+strip_sets(const string& conf)
+{
+    string code;
+    string::size_type pos = 0;
+
+    while (pos < conf.size()) {
+	string::size_type end = conf.find('\n', pos);
+	if (end == string::npos)
+	    end = conf.size();
+	else
+	    end++;
+
+	if (conf.compare(pos, 4, "SET ") != 0)
+	    code.append(conf, pos, end - pos);
+
+	pos = end;
+    }
+
+    return code;
+}
+
+/**
+ * Add the networks added to or removed from a set of networks to the
+ * changes.
+ *
+ * @return false if the sets are not sets of networks of this family, or
+ * if a network which matches all other networks changed.
+ */
+template <class A>
+static bool
+add_set_changes(const VarRW::Id& var, const Element& older,
+		const Element& newer, FilterChanges& changes)
+{
+    typedef ElemSetAny<ElemNet<A> > Set;
+
+    const Set* a = dynamic_cast<const Set*>(&older);
+    const Set* b = dynamic_cast<const Set*>(&newer);
+    if (a == NULL || b == NULL)
+	return false;
+
+    // The sets are sorted by network.  The modifier of a network is not
+    // part of the key, so a network whose modifier changed is in both.
+    vector<const ElemNet<A>*> changed;
+    typename Set::const_iterator i = a->begin();
+    typename Set::const_iterator j = b->begin();
+    while (i != a->end() || j != b->end()) {
+	if (j == b->end() || (i != a->end() && *i < *j)) {
+	    changed.push_back(&*i);
+	    ++i;
+	} else if (i == a->end() || *j < *i) {
+	    changed.push_back(&*j);
+	    ++j;
+	} else {
+	    if (i->mod() != j->mod()) {
+		changed.push_back(&*i);
+		changed.push_back(&*j);
+	    }
+	    ++i;
+	    ++j;
+	}
+    }
+
+    for (size_t k = 0; k < changed.size(); k++) {
+	if (changed[k]->mod() == ElemNet<A>::MOD_NOT
+	    || changed[k]->val().prefix_len() == 0)
+	    return false;
+	changes.add_net(var, changed[k]->val());
+    }
+
+    return true;
+}
+
 PolicyFilter::PolicyFilter() : _policies(NULL),
 #ifndef XORP_DISABLE_PROFILE
 			       _profiler_exec(NULL),
@@ -68,6 +158,15 @@ void PolicyFilter::configure(const string& str)
     _sman.replace_sets(sets);
     _exec.set_policies(_policies);
     _exec.set_subr(_subr);
+    if (_compile)
+	_compiled.compile(*_policies, *_subr, _sman);
+
+    _code = strip_sets(str);
+    for (vector<PolicyInstr*>::iterator i = _policies->begin();
+	 i != _policies->end(); ++i)
+	_footprint.add_policy(**i);
+    for (SUBR::iterator i = _subr->begin(); i != _subr->end(); ++i)
+	_footprint.add_policy(*i->second);
 }
 
 PolicyFilter::~PolicyFilter()
@@ -77,6 +176,9 @@ PolicyFilter::~PolicyFilter()
 
 void PolicyFilter::reset()
 {
+    // the code points to the instructions and sets
+    _compiled.clear();
+
     if (_policies) {
 	delete_vector(_policies);
 	_policies = NULL;
@@ -90,6 +192,8 @@ void PolicyFilter::reset()
     }
 
     _sman.clear();
+    _code = "";
+    _footprint.clear();
 }
 
 bool PolicyFilter::acceptRoute(VarRW& varrw)
@@ -106,13 +210,20 @@ bool PolicyFilter::acceptRoute(VarRW& varrw)
 	return default_action;
     }	
 
+    bool compiled = _compiled.compiled();
+
 #ifndef XORP_DISABLE_PROFILE
     // setup profiling
     _exec.set_profiler(_profiler_exec);
+
+    // only IvExec profiles instructions
+    if (_profiler_exec)
+	compiled = false;
 #endif
 
     // run policies
-    IvExec::FlowAction fa = _exec.run(&varrw);
+    IvExec::FlowAction fa = compiled ? _compiled.run(&varrw)
+				     : _exec.run(&varrw);
 
     // print any trace data...
     uint32_t level = varrw.trace();
@@ -168,6 +279,51 @@ bool PolicyFilter::acceptRoute(VarRW& varrw)
     return default_action;
 }
 
+void
+PolicyFilter::changes_from(const PolicyFilter& older,
+			   FilterChanges& changes) const
+{
+    if (_code != older._code) {
+	changes.set_all();
+	return;
+    }
+
+    // The same code reads the same sets.
+    const set<string>& sets = _footprint.sets();
+    for (set<string>::const_iterator i = sets.begin(); i != sets.end(); ++i) {
+	try {
+	    const Element& then = older._sman.getSet(*i);
+	    const Element& now = _sman.getSet(*i);
+
+	    if (string(then.type()) == now.type() && then.str() == now.str())
+		continue;
+
+	    VarRW::Id var;
+	    if (_footprint.indexed_set(*i, var)
+		&& (add_set_changes<IPv4Net>(var, then, now, changes)
+		    || add_set_changes<IPv6Net>(var, then, now, changes)))
+		continue;
+	} catch (const SetManager::SetNotFound&) {
+	    // A missing set is an error for any route that reads it.
+	}
+
+	changes.set_all();
+	return;
+    }
+}
+
+bool
+PolicyFilter::reads(const VarRW::Id& var) const
+{
+    const vector<PolicyFootprint::Term>& terms = _footprint.terms();
+    for (vector<PolicyFootprint::Term>::const_iterator i = terms.begin();
+	 i != terms.end(); ++i) {
+	if (i->vars.find(var) != i->vars.end())
+	    return true;
+    }
+    return false;
+}
+
 #ifndef XORP_DISABLE_PROFILE
 void
 PolicyFilter::set_profiler_exec(PolicyProfiler* profiler)
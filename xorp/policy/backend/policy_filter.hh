@@ -34,6 +34,8 @@
 #include "set_manager.hh"
 #include "filter_base.hh"
 #include "iv_exec.hh"
+#include "compiled_exec.hh"
+#include "policy_footprint.hh"
 #include "libxorp/ref_ptr.hh"
 
 /**
@@ -82,18 +84,65 @@ public:
      */
     bool acceptRoute(VarRW& varrw);
 
+    /**
+     * Find the routes an older configuration may filter differently.
+     *
+     * If only the prefix lists this filter matches networks against
+     * differ, the routes whose network overlaps a network added to or
+     * removed from them are added to the changes.  Otherwise all routes
+     * may be filtered differently, as they may be when a network of
+     * length 0 or a network matched with "not" is added or removed.
+     *
+     * @param older the older configuration.
+     * @param changes the changes are added to this.
+     */
+    void changes_from(const PolicyFilter& older, FilterChanges& changes) const;
+
+    /**
+     * @return what the terms of the filter read.
+     */
+    const PolicyFootprint& footprint() const { return _footprint; }
+
+    /**
+     * @return true if a term of the filter reads the variable.
+     * @param var the variable.
+     */
+    bool reads(const VarRW::Id& var) const;
+
 #ifndef XORP_DISABLE_PROFILE
     void set_profiler_exec(PolicyProfiler* profiler);
 #endif
 
+    /**
+     * Select how the filters run their policies.
+     *
+     * Policies are compiled [see CompiledExec] unless they trace, and run
+     * by IvExec when profiled.  The instructions may also always be run by
+     * IvExec, to compare the two.
+     *
+     * @param compile true to compile the policies.
+     */
+    static void set_compile(bool compile)	{ _compile = compile; }
+    static bool compile()			{ return _compile; }
+
+    /**
+     * @return true if the policies of this filter are compiled.
+     */
+    bool compiled() const		{ return _compiled.compiled(); }
+
 private:
     vector<PolicyInstr*>*   _policies;
     SetManager		    _sman;
     IvExec		    _exec;
+    CompiledExec	    _compiled;
 #ifndef XORP_DISABLE_PROFILE
     PolicyProfiler*	    _profiler_exec;
 #endif
     SUBR*		    _subr;
+    string		    _code;	// The configuration without the sets
+    PolicyFootprint	    _footprint;
+
+    static bool		    _compile;
 };
 
 typedef ref_ptr<PolicyFilter> RefPf;
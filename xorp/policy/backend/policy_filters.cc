@@ -65,6 +65,21 @@ PolicyFilters::reset(const uint32_t& ftype)
     pf.reset();
 }
 
+void
+PolicyFilters::take_changes(FilterChanges& changes)
+{
+    _import_filter->take_changes(changes);
+    _export_sm_filter->take_changes(changes);
+    _export_filter->take_changes(changes);
+}
+
+bool
+PolicyFilters::reads(const uint32_t& ftype, const VarRW::Id& var)
+{
+    FilterBase& pf = whichFilter(ftype);
+    return pf.reads(var);
+}
+
 FilterBase& 
 PolicyFilters::whichFilter(const uint32_t& ftype)
 {
@@ -80,6 +80,23 @@ public:
      */
     void reset(const uint32_t& type);
 
+    /**
+     * Find the routes the configurations done since the last call may
+     * have changed the verdict of, in any of the filters.
+     *
+     * @param changes the changes are added to this.
+     */
+    void take_changes(FilterChanges& changes);
+
+    /**
+     * Find out if the result of a filter may depend on a variable.
+     *
+     * @return true if the filter may read the variable.
+     * @param type the filter.
+     * @param var the variable.
+     */
+    bool reads(const uint32_t& type, const VarRW::Id& var);
+
 private:
     /**
      * Decide which filter to run based on its type.
@@ -0,0 +1,213 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+#include "policy/policy_module.h"
+#include "libxorp/xorp.h"
+#include "policy/common/operator.hh"
+#include "policy_footprint.hh"
+
+// Implementation Notes:
+//
+// The code generator evaluates the right operand of a binary operation
+// first, so "network4 <= set" is compiled to:
+//
+//	PUSH_SET set
+//	LOAD network4
+//	<=
+//
+// The footprint matches these three instructions.  A set pushed in any
+// other sequence is not indexed, as the result of the operation may then
+// depend on the whole set: "set == network4" is only true for a set of
+// one network, for instance.
+
+PolicyFootprint::PolicyFootprint() : _set_pushed(false), _var_loaded(false),
+				     _var(0)
+{
+}
+
+void
+PolicyFootprint::add_policy(PolicyInstr& pi)
+{
+    TermInstr** terms = pi.terms();
+
+    for (int i = 0; i < pi.termc(); i++) {
+	TermInstr* ti = terms[i];
+
+	_terms.push_back(Term());
+	_terms.back().policy = pi.name();
+	_terms.back().name = ti->name();
+
+	Instruction** instr = ti->instructions();
+	for (int j = 0; j < ti->instrc(); j++)
+	    instr[j]->accept(*this);
+
+	// A set pushed at the end of a term is left on the stack.
+	not_indexed();
+    }
+}
+
+void
+PolicyFootprint::clear()
+{
+    _terms.clear();
+    _sets.clear();
+    _indexed.clear();
+    _not_indexed.clear();
+    _set_pushed = _var_loaded = false;
+}
+
+bool
+PolicyFootprint::indexed_set(const string& setid, VarRW::Id& var) const
+{
+    if (_not_indexed.find(setid) != _not_indexed.end())
+	return false;
+
+    map<string, VarRW::Id>::const_iterator i = _indexed.find(setid);
+    if (i == _indexed.end())
+	return false;
+
+    var = i->second;
+    return true;
+}
+
+string
+PolicyFootprint::str() const
+{
+    ostringstream oss;
+
+    for (vector<Term>::const_iterator i = _terms.begin(); i != _terms.end();
+	 ++i) {
+	oss << i->policy << "." << i->name << ": vars";
+	for (set<VarRW::Id>::const_iterator v = i->vars.begin();
+	     v != i->vars.end(); ++v)
+	    oss << " " << *v;
+	oss << " sets";
+	for (set<string>::const_iterator s = i->sets.begin();
+	     s != i->sets.end(); ++s) {
+	    VarRW::Id var;
+	    oss << " " << *s;
+	    if (indexed_set(*s, var))
+		oss << "[" << var << "]";
+	}
+	oss << endl;
+    }
+
+    return oss.str();
+}
+
+void
+PolicyFootprint::not_indexed()
+{
+    if (_set_pushed)
+	_not_indexed.insert(_set);
+
+    _set_pushed = _var_loaded = false;
+}
+
+void
+PolicyFootprint::visit(Push& /* p */)
+{
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(PushSet& ps)
+{
+    not_indexed();
+
+    _terms.back().sets.insert(ps.setid());
+    _sets.insert(ps.setid());
+
+    _set = ps.setid();
+    _set_pushed = true;
+}
+
+void
+PolicyFootprint::visit(OnFalseExit& /* x */)
+{
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(Load& l)
+{
+    _terms.back().vars.insert(l.var());
+
+    if (_set_pushed && !_var_loaded) {
+	_var = l.var();
+	_var_loaded = true;
+	return;
+    }
+
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(Store& /* s */)
+{
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(Accept& /* a */)
+{
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(Reject& /* r */)
+{
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(NaryInstr& nary)
+{
+    if (_set_pushed && _var_loaded
+	&& dynamic_cast<const OpLe*>(&nary.op()) != NULL) {
+	map<string, VarRW::Id>::iterator i = _indexed.find(_set);
+
+	// A set matched against two variables is not indexed by either.
+	if (i != _indexed.end() && i->second != _var)
+	    _not_indexed.insert(_set);
+	else
+	    _indexed[_set] = _var;
+
+	_set_pushed = _var_loaded = false;
+	return;
+    }
+
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(Next& /* next */)
+{
+    not_indexed();
+}
+
+void
+PolicyFootprint::visit(Subr& /* sub */)
+{
+    // The terms of the subroutines are added as policies of their own.
+    not_indexed();
+}
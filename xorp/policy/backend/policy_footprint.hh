@@ -0,0 +1,118 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#ifndef __POLICY_BACKEND_POLICY_FOOTPRINT_HH__
+#define __POLICY_BACKEND_POLICY_FOOTPRINT_HH__
+
+#include "policy/common/varrw.hh"
+#include "instruction.hh"
+#include "policy_instr.hh"
+
+/**
+ * @short Visitor that finds the variables and sets each term reads.
+ *
+ * The variables are those of the Load instructions, the sets those of the
+ * PushSet instructions.
+ *
+ * A set is said to be indexed by a variable when every use of it is
+ * "variable <= set", which is how a network is matched against a prefix
+ * list.  Whether such a match is true for a route then only depends on
+ * the networks of the set which overlap the network of the route.
+ */
+class PolicyFootprint :
+    public NONCOPYABLE,
+    public InstrVisitor
+{
+public:
+    /**
+     * What a term reads.
+     */
+    struct Term {
+	string		policy;
+	string		name;
+	set<VarRW::Id>	vars;
+	set<string>	sets;
+    };
+
+    PolicyFootprint();
+
+    /**
+     * Add the terms of a policy.
+     *
+     * @param pi the policy.
+     */
+    void add_policy(PolicyInstr& pi);
+
+    /**
+     * Forget all the terms.
+     */
+    void clear();
+
+    /**
+     * @return what each term reads, in the order the terms were added.
+     */
+    const vector<Term>& terms() const		{ return _terms; }
+
+    /**
+     * @return the sets read by any term.
+     */
+    const set<string>& sets() const		{ return _sets; }
+
+    /**
+     * Find the variable a set is indexed by.
+     *
+     * @param setid the name of the set.
+     * @param var is set to the variable the set is matched against.
+     * @return true if the set is indexed by a variable.
+     */
+    bool indexed_set(const string& setid, VarRW::Id& var) const;
+
+    string str() const;
+
+    void visit(Push& p);
+    void visit(PushSet& ps);
+    void visit(OnFalseExit& x);
+    void visit(Load& l);
+    void visit(Store& s);
+    void visit(Accept& a);
+    void visit(Reject& r);
+    void visit(NaryInstr& nary);
+    void visit(Next& next);
+    void visit(Subr& sub);
+
+private:
+    /**
+     * The set pushed last is used in another way than "variable <= set".
+     */
+    void not_indexed();
+
+    vector<Term>	    _terms;
+    set<string>		    _sets;
+    map<string, VarRW::Id>  _indexed;
+    set<string>		    _not_indexed;
+
+    // The "variable <= set" being matched: PUSH_SET, LOAD then <=.
+    string		    _set;
+    bool		    _set_pushed;
+    bool		    _var_loaded;
+    VarRW::Id		    _var;
+};
+
+#endif // __POLICY_BACKEND_POLICY_FOOTPRINT_HH__
@@ -109,6 +109,11 @@ public:
      */
     bool contains_atleast_one(const PolicyTags& tags) const;
 
+    /**
+     * @return true if there are no tags and the tag is zero.
+     */
+    bool empty() const { return _tags.empty() && _tag == 0; }
+
 private:
     typedef set<uint32_t> Set;
 
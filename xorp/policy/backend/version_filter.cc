@@ -36,6 +36,7 @@
 
 VersionFilter::VersionFilter(const VarRW::Id& fname) : 
 		    _filter(new PolicyFilter), 
+		    _taken(_filter),
 		    _fname(fname)
 {
 }
@@ -101,3 +102,16 @@ VersionFilter::acceptRoute(VarRW& varrw)
     XLOG_ASSERT(!_filter.is_empty());
     return _filter->acceptRoute(varrw);
 }
+
+void
+VersionFilter::take_changes(FilterChanges& changes)
+{
+    _filter->changes_from(*_taken, changes);
+    _taken = _filter;
+}
+
+bool
+VersionFilter::reads(const VarRW::Id& var) const
+{
+    return _filter->reads(var);
+}
@@ -74,8 +74,26 @@ public:
      */
     bool acceptRoute(VarRW& varrw);
 
+    /**
+     * Find the routes the latest configuration may filter differently
+     * than the configuration current at the last call.
+     *
+     * Routes which are not found keep being filtered by the version they
+     * reference, which filters them as the latest one does.
+     *
+     * @param changes the changes are added to this.
+     */
+    void take_changes(FilterChanges& changes);
+
+    /**
+     * @return true if the latest configuration reads the variable.
+     * @param var the variable.
+     */
+    bool reads(const VarRW::Id& var) const;
+
 private:
     RefPf _filter;
+    RefPf _taken;	// The filter at the last take_changes()
     VarRW::Id _fname;
 };
 
@@ -100,6 +100,32 @@ Dispatcher::run(const Oper& op, unsigned argc, const Element** argv) const
 }
 
 
+bool
+Dispatcher::resolve(const Oper& op, unsigned argc, const Element** argv,
+		    Key& key, Value& funct) const
+{
+    XLOG_ASSERT(op.arity() == argc);
+
+    if (argc != 1 && argc != 2)
+	return false;
+
+    for (unsigned i = 0; i < argc; i++) {
+	if (argv[i]->hash() == ElemNull::_hash)
+	    return false;
+    }
+
+    if (typeid(op) == typeid(OpCtr))
+	return false;
+
+    key = Dispatcher::key(op, argc, argv);
+    funct = _map[key];
+
+    if (argc == 1)
+	return funct.un != NULL;
+
+    return funct.bin != NULL;
+}
+
 Element* 
 Dispatcher::run(const UnOper& op, const Element& arg) const
 {
@@ -151,7 +151,6 @@ public:
 		 const Element& left, 
 		 const Element& right) const;
 
-private:
     // Callback for binary operation
     typedef Element* (*CB_bin)(const Element&, const Element&);
     
@@ -167,6 +166,46 @@ private:
         CB_bin bin;
     } Value;
 
+    /**
+     * Key of the callback run() looks up for an operation.
+     *
+     * Unlike run(), null arguments are not special cased.
+     *
+     * @return key of the callback.
+     * @param op operation to dispatch.
+     * @param argc number of arguments [1 or 2].
+     * @param argv arguments of the operation.
+     */
+    static Key key(const Oper& op, unsigned argc, const Element** argv)
+    {
+	Key key = op.hash();
+
+	for (unsigned i = 0; i < argc; i++)
+	    key |= argv[i]->hash() << (5*(argc-i));
+
+	return key;
+    }
+
+    /**
+     * Find the callback run() calls for an operation, so that it may be
+     * called directly with arguments of the same types.
+     *
+     * A unary callback is called with argv[0], a binary one with argv[1]
+     * and argv[0], in this order.
+     *
+     * @return false if run() does not call a registered callback for these
+     * arguments: an argument is null, the operation is a constructor or no
+     * callback is registered.
+     * @param op operation to dispatch.
+     * @param argc number of arguments.
+     * @param argv arguments of the operation.
+     * @param key is set to the key of the callback [see key()].
+     * @param funct is set to the callback.
+     */
+    bool resolve(const Oper& op, unsigned argc, const Element** argv,
+		 Key& key, Value& funct) const;
+
+private:
     // Hashtable would be better
     typedef map<Key,Value> Map;
 
@@ -459,6 +459,7 @@ public:
     const A&	    val() const;
     static Mod	    str_to_mod(const char* p);
     static string   mod_to_str(Mod mod);
+    Mod		    mod() const { return _mod; }
     BinOper&	    op() const;
 
     bool	operator<(const ElemNet<A>& rhs) const;
@@ -0,0 +1,385 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#include "policy/policy_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/test_main.hh"
+
+#include "policy/common/policy_utils.hh"
+#include "policy/common/elem_null.hh"
+#include "policy/backend/policy_filter.hh"
+
+// Implementation Notes:
+//
+// Each test configures two filters with the same code, one compiled and
+// one run by IvExec, and runs routes through both.  The filters must
+// accept or reject the same routes, write the same variables, and throw
+// the same exceptions.  Only the type and reason of an exception are
+// compared, as the location it is thrown from differs.
+//
+// The routes have a network 10.<k>.0.0/16 and a metric of 0 to 9, or no
+// metric at all, which reads as null.
+
+enum {
+    VAR_NET = 10,
+    VAR_MED = 19
+};
+
+static const uint32_t NETS = 8;
+static const uint32_t MEDS = 11;	// The last one is null.
+
+/**
+ * A route, which logs what is written to it.
+ */
+class TestVarRW : public VarRW {
+public:
+    TestVarRW(uint32_t k, uint32_t med)
+	: _net(IPv4Net(IPv4(htonl(0x0a000000 | (k << 16))), 16)),
+	  _med(med), _has_med(med < MEDS - 1)
+    {
+    }
+
+    const Element& read(const Id& id) {
+	if (id == VAR_NET)
+	    return _net;
+	if (id == VAR_MED && _has_med)
+	    return _med;
+	return _null;
+    }
+
+    void write(const Id& id, const Element& e) {
+	_log += policy_utils::to_str(id) + "=" + e.str() + ";";
+    }
+
+    const string& log() const	{ return _log; }
+
+private:
+    ElemIPv4Net	_net;
+    ElemU32	_med;
+    bool	_has_med;
+    ElemNull	_null;
+    string	_log;
+};
+
+/**
+ * Run a route through a filter.
+ *
+ * @return the outcome and the variables written.
+ */
+static string
+filter_route(PolicyFilter& filter, uint32_t k, uint32_t med)
+{
+    TestVarRW varrw(k, med);
+    string outcome;
+
+    try {
+	outcome = filter.acceptRoute(varrw) ? "accept" : "reject";
+    } catch (const PolicyException& e) {
+	outcome = e.what() + ": " + e.why();
+    }
+
+    return outcome + " " + varrw.log();
+}
+
+/**
+ * Run routes through the code compiled and interpreted.
+ */
+static bool
+compare(TestInfo& info, const char* code)
+{
+    PolicyFilter interpreted, compiled;
+
+    PolicyFilter::set_compile(false);
+    interpreted.configure(code);
+    PolicyFilter::set_compile(true);
+    compiled.configure(code);
+
+    if (!compiled.compiled()) {
+	DOUT(info) << "The policies were not compiled\n";
+	return false;
+    }
+
+    bool ok = true;
+    for (uint32_t k = 0; k < NETS; k++) {
+	for (uint32_t med = 0; med < MEDS; med++) {
+	    string iv = filter_route(interpreted, k, med);
+	    string cx = filter_route(compiled, k, med);
+
+	    if (iv != cx) {
+		DOUT(info) << "net " << k << " med " << med << ":\n"
+			   << "  IvExec:   " << iv << "\n"
+			   << "  compiled: " << cx << "\n";
+		ok = false;
+	    } else if (k == 0) {
+		DOUT(info) << "med " << med << ": " << cx << "\n";
+	    }
+	}
+    }
+
+    return ok;
+}
+
+/*
+** A subroutine that rejects some routes, and ends the policy calling it
+** on others with NEXT POLICY.  The last policy, run first, folds an
+** addition, and stores a null variable.
+*/
+static const char* SUBROUTINE =
+"SUBR_START\n"
+"POLICY_START sub\n"
+"TERM_START a\n"
+"PUSH u32 5\n"
+"LOAD 19\n"
+"<\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"TERM_START b\n"
+"PUSH u32 8\n"
+"LOAD 19\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"NEXT POLICY\n"
+"TERM_END\n"
+"POLICY_END\n"
+"SUBR_END\n"
+"POLICY_START p1\n"
+"TERM_START t1\n"
+"POLICY sub\n"
+"ONFALSE_EXIT\n"
+"PUSH u32 7\n"
+"STORE 19\n"
+"TERM_END\n"
+"TERM_START t2\n"
+"PUSH u32 100\n"
+"STORE 17\n"
+"ACCEPT\n"
+"TERM_END\n"
+"POLICY_END\n"
+"POLICY_START p0\n"
+"TERM_START u1\n"
+"PUSH u32 2\n"
+"PUSH u32 3\n"
+"+\n"
+"LOAD 19\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"TERM_START u2\n"
+"PUSH u32 9\n"
+"LOAD 19\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"NEXT TERM\n"
+"TERM_END\n"
+"TERM_START u3\n"
+"LOAD 20\n"
+"STORE 19\n"
+"PUSH u32 3\n"
+"PUSH u32 6\n"
+"/\n"
+"STORE 18\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+bool
+test_subroutine(TestInfo& info)
+{
+    return compare(info, SUBROUTINE);
+}
+
+/*
+** Exits on a null variable, and a metric which is not a bool.
+*/
+static const char* NULL_EXIT =
+"POLICY_START p\n"
+"TERM_START a\n"
+"LOAD 20\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"TERM_START b\n"
+"LOAD 20\n"
+"STORE 18\n"
+"PUSH u32 1\n"
+"STORE 17\n"
+"TERM_END\n"
+"TERM_START c\n"
+"LOAD 19\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+bool
+test_null(TestInfo& info)
+{
+    return compare(info, NULL_EXIT);
+}
+
+/*
+** Operations on constants, which are folded unless they fail: an
+** invalid regular expression, and a constructor, which is never
+** folded.  They must only fail when they are run.
+*/
+static const char* FOLD =
+"POLICY_START p\n"
+"TERM_START a\n"
+"PUSH u32 3\n"
+"LOAD 19\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"PUSH txt \"(\"\n"
+"PUSH txt \"abc\"\n"
+"REGEX\n"
+"STORE 18\n"
+"TERM_END\n"
+"TERM_START b\n"
+"PUSH u32 4\n"
+"LOAD 19\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"PUSH txt \"garbage\"\n"
+"PUSH txt \"ipv4net\"\n"
+"CTR\n"
+"STORE 18\n"
+"TERM_END\n"
+"TERM_START c\n"
+"PUSH u32 5\n"
+"LOAD 19\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"PUSH bool true\n"
+"NOT\n"
+"PUSH u32 1\n"
+"PUSH u32 2\n"
+"<\n"
+"AND\n"
+"STORE 18\n"
+"PUSH txt \"^a\"\n"
+"PUSH txt \"abc\"\n"
+"REGEX\n"
+"STORE 17\n"
+"ACCEPT\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+bool
+test_fold(TestInfo& info)
+{
+    return compare(info, FOLD);
+}
+
+/*
+** Sets matched against the network, one of them missing, which must
+** only fail when it is pushed.
+*/
+static const char* SETS =
+"POLICY_START q\n"
+"TERM_START a\n"
+"PUSH_SET nets\n"
+"LOAD 10\n"
+"<=\n"
+"PUSH u32 4\n"
+"LOAD 19\n"
+">\n"
+"AND\n"
+"ONFALSE_EXIT\n"
+"PUSH bool true\n"
+"NOT\n"
+"STORE 20\n"
+"ACCEPT\n"
+"TERM_END\n"
+"TERM_START b\n"
+"PUSH u32 2\n"
+"PUSH u32 1\n"
+"<\n"
+"NOT\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"TERM_START c\n"
+"PUSH_SET missing\n"
+"LOAD 10\n"
+"<=\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"POLICY_END\n"
+"SET set_ipv4net nets \"10.0.0.0/16,10.3.0.0/16,10.5.0.0/16\"\n";
+
+bool
+test_sets(TestInfo& info)
+{
+    return compare(info, SETS);
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    t.complete_args_parsing();
+
+    struct test {
+	string test_name;
+	XorpCallback1<bool, TestInfo&>::RefPtr cb;
+    } tests[] = {
+	{"subroutine", callback(test_subroutine)},
+	{"null", callback(test_null)},
+	{"fold", callback(test_fold)},
+	{"sets", callback(test_sets)},
+    };
+
+    try {
+	if (test_name.empty()) {
+	    for (unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		 i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	} else {
+	    for (unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		 i++)
+		if (test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
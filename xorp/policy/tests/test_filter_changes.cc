@@ -0,0 +1,250 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+//
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+#include "policy/policy_module.h"
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/test_main.hh"
+
+#include "policy/backend/policy_filter.hh"
+#include "policy/backend/filter_changes.hh"
+
+// Implementation Notes:
+//
+// Each test configures a filter, then a new version of it, and checks
+// the FilterChanges the new version reports: the networks added to or
+// removed from the prefix lists, or all routes when a change may affect
+// routes outside these networks.
+
+/*
+** The network of the route, variable 10, matched against a prefix list.
+*/
+static const char* MATCH =
+"POLICY_START p\n"
+"TERM_START a\n"
+"PUSH_SET nets\n"
+"LOAD 10\n"
+"<=\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+/*
+** The same prefix list also matched against variable 11.
+*/
+static const char* TWO_VARS =
+"POLICY_START p\n"
+"TERM_START a\n"
+"PUSH_SET nets\n"
+"LOAD 10\n"
+"<=\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"TERM_START b\n"
+"PUSH_SET nets\n"
+"LOAD 11\n"
+"<=\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+/*
+** The prefix list compared to the network rather than matched.
+*/
+static const char* NOT_LE =
+"POLICY_START p\n"
+"TERM_START a\n"
+"PUSH_SET nets\n"
+"LOAD 10\n"
+"==\n"
+"ONFALSE_EXIT\n"
+"REJECT\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+/*
+** The code of MATCH, accepting the routes it matches.
+*/
+static const char* MATCH_ACCEPT =
+"POLICY_START p\n"
+"TERM_START a\n"
+"PUSH_SET nets\n"
+"LOAD 10\n"
+"<=\n"
+"ONFALSE_EXIT\n"
+"ACCEPT\n"
+"TERM_END\n"
+"POLICY_END\n";
+
+/**
+ * @return the configuration of a filter.
+ */
+static string
+filter_conf(const char* code, const string& nets)
+{
+    return string(code) + "SET set_ipv4net nets \"" + nets + "\"\n";
+}
+
+/**
+ * Check the changes reported by a new version of a filter.
+ */
+static bool
+check_changes(TestInfo& info, const string& older_conf,
+	      const string& newer_conf, const string& expected)
+{
+    PolicyFilter older, newer;
+    older.configure(older_conf);
+    newer.configure(newer_conf);
+
+    FilterChanges changes;
+    newer.changes_from(older, changes);
+
+    DOUT(info) << changes.str();
+    if (changes.str() != expected) {
+	DOUT(info) << "Expected " << expected;
+	return false;
+    }
+
+    return true;
+}
+
+bool
+test_prefix_list(TestInfo& info)
+{
+    string nets = "10.0.0.0/16,10.1.0.0/16";
+
+    return check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH, nets),
+			 "no route\n")
+	&& check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH, "10.0.0.0/16,10.2.0.0/16"),
+			 "var 10: 10.1.0.0/16 10.2.0.0/16\n")
+	&& check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH, "10.0.0.0/16~longer,10.1.0.0/16"),
+			 "var 10: 10.0.0.0/16\n");
+}
+
+bool
+test_mod_not(TestInfo& info)
+{
+    string nets = "10.0.0.0/16,10.1.0.0/16";
+
+    return check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH, nets + ",10.2.0.0/16~not"),
+			 "all routes\n")
+	&& check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH, "10.0.0.0/16~not,10.1.0.0/16"),
+			 "all routes\n");
+}
+
+bool
+test_default_route(TestInfo& info)
+{
+    string nets = "10.0.0.0/16,10.1.0.0/16";
+
+    return check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH, nets + ",0.0.0.0/0"),
+			 "all routes\n")
+	&& check_changes(info, filter_conf(MATCH, nets + ",0.0.0.0/0"),
+			 filter_conf(MATCH, nets),
+			 "all routes\n");
+}
+
+bool
+test_two_vars(TestInfo& info)
+{
+    return check_changes(info, filter_conf(TWO_VARS, "10.0.0.0/16"),
+			 filter_conf(TWO_VARS, "10.0.0.0/16,10.1.0.0/16"),
+			 "all routes\n");
+}
+
+bool
+test_not_le(TestInfo& info)
+{
+    return check_changes(info, filter_conf(NOT_LE, "10.0.0.0/16"),
+			 filter_conf(NOT_LE, "10.0.0.0/16,10.1.0.0/16"),
+			 "all routes\n");
+}
+
+bool
+test_code(TestInfo& info)
+{
+    string nets = "10.0.0.0/16";
+
+    return check_changes(info, filter_conf(MATCH, nets),
+			 filter_conf(MATCH_ACCEPT, nets),
+			 "all routes\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    TestMain t(argc, argv);
+
+    string test_name =
+	t.get_optional_args("-t", "--test", "run only the specified test");
+    t.complete_args_parsing();
+
+    struct test {
+	string test_name;
+	XorpCallback1<bool, TestInfo&>::RefPtr cb;
+    } tests[] = {
+	{"prefix_list", callback(test_prefix_list)},
+	{"mod_not", callback(test_mod_not)},
+	{"default_route", callback(test_default_route)},
+	{"two_vars", callback(test_two_vars)},
+	{"not_le", callback(test_not_le)},
+	{"code", callback(test_code)},
+    };
+
+    try {
+	if (test_name.empty()) {
+	    for (unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		 i++)
+		t.run(tests[i].test_name, tests[i].cb);
+	} else {
+	    for (unsigned int i = 0; i < sizeof(tests) / sizeof(struct test);
+		 i++)
+		if (test_name == tests[i].test_name) {
+		    t.run(tests[i].test_name, tests[i].cb);
+		    return t.exit();
+		}
+	    t.failed("No test with name " + test_name + " found\n");
+	}
+    } catch(...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    xlog_stop();
+    xlog_exit();
+
+    return t.exit();
+}
@@ -24,6 +24,7 @@
 #define __POLICY_XRL_TARGET_HH__
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/policy_base.hh"
 #include "policy_target.hh"
 
@@ -59,6 +60,14 @@ public:
 	return XrlCmdError::OKAY();
     }
 
+    virtual XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    virtual XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError policy_0_1_create_term(
         // Input values,
         const string&   policy,
@@ -171,8 +171,7 @@ AddRoute<IPv4>::dispatch(XrlRouter& xrl_router, Profile& profile)
 {
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		    c_format("add %s", _net.str().c_str()));
+	profile.log_net(profile_route_rpc_out, "add", _net);
 #else
     UNUSED(profile);
 #endif
@@ -194,8 +193,7 @@ AddRoute<IPv6>::dispatch(XrlRouter& xrl_router, Profile& profile)
 {
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		    c_format("add %s", _net.str().c_str()));
+	profile.log_net(profile_route_rpc_out, "add", _net);
 #else
     UNUSED(profile);
 #endif
@@ -257,8 +255,7 @@ DeleteRoute<IPv4>::dispatch(XrlRouter& xrl_router, Profile& profile)
 {
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		    c_format("delete %s", _net.str().c_str()));
+	profile.log_net(profile_route_rpc_out, "delete", _net);
 #else
     UNUSED(profile);
 #endif
@@ -281,8 +278,7 @@ DeleteRoute<IPv6>::dispatch(XrlRouter& xrl_router, Profile& profile)
 {
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		    c_format("delete %s", _net.str().c_str()));
+	profile.log_net(profile_route_rpc_out, "delete", _net);
 #else
     UNUSED(profile);
 #endif
@@ -509,8 +505,7 @@ RedistXrlOutput<A>::add_route(const IPRouteEntry<A>& ipr)
 	return;		// The target is not interested in this route
 
     PROFILE(if (_profile.enabled(profile_route_rpc_in))
-		_profile.log(profile_route_rpc_in,
-			     c_format("add %s", ipr.net().str().c_str())));
+		_profile.log_net(profile_route_rpc_in, "add", ipr.net()));
 
     enqueue_task(new AddRoute<A>(this, ipr));
     if (_queued == 1)
@@ -525,8 +520,7 @@ RedistXrlOutput<A>::delete_route(const IPRouteEntry<A>& ipr)
 	return;		// The target is not interested in this route
 
     PROFILE(if (_profile.enabled(profile_route_rpc_in))
-		_profile.log(profile_route_rpc_in,
-			     c_format("delete %s", ipr.net().str().c_str())));
+		_profile.log_net(profile_route_rpc_in, "delete", ipr.net()));
 
     enqueue_task(new DeleteRoute<A>(this, ipr));
     if (_queued == 1)
@@ -696,12 +690,7 @@ AddTransactionRoute<IPv4>::dispatch(XrlRouter& xrl_router, Profile& profile)
 
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		     c_format("add %s %s %s %u",
-			      p->xrl_target_name().c_str(),
-			      _net.str().c_str(),
-			      _nexthop.str().c_str(),
-			      XORP_UINT_CAST(_metric)));
+	profile.log_net(profile_route_rpc_out, "add", _net, _metric);
 #else
     UNUSED(profile);
 #endif
@@ -733,12 +722,7 @@ AddTransactionRoute<IPv6>::dispatch(XrlRouter& xrl_router, Profile& profile)
 
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		     c_format("add %s %s %s %u",
-			      p->xrl_target_name().c_str(),
-			      _net.str().c_str(),
-			      _nexthop.str().c_str(),
-			      XORP_UINT_CAST(_metric)));
+	profile.log_net(profile_route_rpc_out, "add", _net, _metric);
 #else
     UNUSED(profile);
 #endif
@@ -774,10 +758,7 @@ DeleteTransactionRoute<IPv4>::dispatch(XrlRouter& xrl_router, Profile& profile)
 
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		     c_format("delete %s %s",
-			      p->xrl_target_name().c_str(),
-			      _net.str().c_str()));
+	profile.log_net(profile_route_rpc_out, "delete", _net);
 #else
     UNUSED(profile);
 #endif
@@ -809,10 +790,7 @@ DeleteTransactionRoute<IPv6>::dispatch(XrlRouter& xrl_router, Profile& profile)
 
 #ifndef XORP_DISABLE_PROFILE
     if (profile.enabled(profile_route_rpc_out))
-	profile.log(profile_route_rpc_out,
-		     c_format("delete %s %s",
-			      p->xrl_target_name().c_str(),
-			      _net.str().c_str()));
+	profile.log_net(profile_route_rpc_out, "delete", _net);
 #else
     UNUSED(profile);
 #endif
@@ -1047,12 +1025,8 @@ void
 RedistTransactionXrlOutput<A>::add_route(const IPRouteEntry<A>& ipr)
 {
     PROFILE(if (this->_profile.enabled(profile_route_rpc_in))
-		this->_profile.log(profile_route_rpc_in,
-				   c_format("add %s %s %s %u",
-					    ipr.protocol()->name().c_str(),
-					    ipr.net().str().c_str(),
-					    ipr.nexthop()->str().c_str(),
-					    XORP_UINT_CAST(ipr.metric()))));
+		this->_profile.log_net(profile_route_rpc_in,
+				       "add", ipr.net(), ipr.metric()));
 
     bool no_running_tasks = (this->_queued == 0);
 
@@ -1078,10 +1052,8 @@ void
 RedistTransactionXrlOutput<A>::delete_route(const IPRouteEntry<A>& ipr)
 {
     PROFILE(if (this->_profile.enabled(profile_route_rpc_in))
-		this->_profile.log(profile_route_rpc_in,
-				   c_format("add %s %s",
-					    ipr.protocol()->name().c_str(),
-					    ipr.net().str().c_str())));
+		this->_profile.log_net(profile_route_rpc_in,
+				       "add", ipr.net()));
 
     bool no_running_tasks = (this->_queued == 0);
 
@@ -41,6 +41,7 @@
 #include "libxorp/service.hh"
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 
 #include "xrl/interfaces/rib_xif.hh"
 #include "xrl/interfaces/finder_event_notifier_xif.hh"
@@ -82,6 +83,14 @@ public:
     XrlCmdError common_0_1_get_version(string& version);
     XrlCmdError common_0_1_get_status(uint32_t& status, string& reason);
     XrlCmdError common_0_1_shutdown();
+
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     XrlCmdError finder_event_observer_0_1_xrl_target_birth(const string& cls,
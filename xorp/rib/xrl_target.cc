@@ -43,6 +43,84 @@
 #include "vifmanager.hh"
 #include "profile_vars.hh"
 
+static inline void
+atom_addr(const XrlAtom& atom, IPv4& addr)
+{
+    addr = atom.ipv4();
+}
+
+static inline void
+atom_net(const XrlAtom& atom, IPv4Net& net)
+{
+    net = atom.ipv4net();
+}
+
+#ifdef HAVE_IPV6
+static inline void
+atom_addr(const XrlAtom& atom, IPv6& addr)
+{
+    addr = atom.ipv6();
+}
+
+static inline void
+atom_net(const XrlAtom& atom, IPv6Net& net)
+{
+    net = atom.ipv6net();
+}
+#endif
+
+/**
+ * One change carried by a route_changes request.
+ */
+template <class A>
+struct RouteChange {
+    bool	add;
+    IPNet<A>	net;
+    A		nexthop;
+    uint32_t	metric;
+    XrlAtomList	policytags;
+};
+
+/**
+ * Split the lists of a route_changes request into its changes.
+ */
+template <class A>
+static XrlCmdError
+parse_route_changes(const XrlAtomList& adds, const XrlAtomList& networks,
+		    const XrlAtomList& nexthops, const XrlAtomList& metrics,
+		    const XrlAtomList& tag_counts,
+		    const XrlAtomList& policytags,
+		    vector<RouteChange<A> >& changes)
+{
+    size_t n = adds.size();
+    if (networks.size() != n || nexthops.size() != n ||
+	metrics.size() != n || tag_counts.size() != n)
+	return XrlCmdError::BAD_ARGS("route change lists differ in length");
+
+    changes.resize(n);
+    size_t tag = 0;
+    try {
+	for (size_t i = 0; i < n; i++) {
+	    RouteChange<A>& c = changes[i];
+	    c.add = adds.get(i).boolean();
+	    atom_net(networks.get(i), c.net);
+	    atom_addr(nexthops.get(i), c.nexthop);
+	    c.metric = metrics.get(i).uint32();
+	    uint32_t count = tag_counts.get(i).uint32();
+	    if (count > policytags.size() - tag)
+		return XrlCmdError::BAD_ARGS("too few policy tags");
+	    for (uint32_t j = 0; j < count; j++)
+		c.policytags.append(policytags.get(tag++));
+	}
+    } catch (const XorpException& e) {
+	return XrlCmdError::BAD_ARGS(e.str());
+    }
+    if (tag != policytags.size())
+	return XrlCmdError::BAD_ARGS("too many policy tags");
+
+    return XrlCmdError::OKAY();
+}
+
 XrlCmdError
 XrlRibTarget::common_0_1_get_target_name(string& name)
 {
@@ -363,14 +441,8 @@ XrlRibTarget::rib_0_1_add_route4(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("add %s %s%s %s %s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"add", network, metric);
     }
 #endif
 
@@ -415,14 +487,8 @@ XrlRibTarget::rib_0_1_replace_route4(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("replace %s %s%s %s %s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"replace", network, metric);
     }
 #endif
 
@@ -460,12 +526,8 @@ XrlRibTarget::rib_0_1_delete_route4(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("delete %s %s%s %s",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str()));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"delete", network);
     }
 #endif
 
@@ -482,6 +544,54 @@ XrlRibTarget::rib_0_1_delete_route4(const string&	protocol,
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlRibTarget::rib_0_1_route_changes4(const string&	protocol,
+				     const bool&	unicast,
+				     const bool&	multicast,
+				     const XrlAtomList&	adds,
+				     const XrlAtomList&	networks,
+				     const XrlAtomList&	nexthops,
+				     const XrlAtomList&	metrics,
+				     const XrlAtomList&	tag_counts,
+				     const XrlAtomList&	policytags)
+{
+    vector<RouteChange<IPv4> > changes;
+    XrlCmdError e = parse_route_changes(adds, networks, nexthops, metrics,
+					tag_counts, policytags, changes);
+    if (!e.isOK())
+	return e;
+
+    debug_msg("route_changes4 protocol: %s unicast: %s multicast: %s "
+	      "changes %u\n",
+	      protocol.c_str(),
+	      bool_c_str(unicast),
+	      bool_c_str(multicast),
+	      XORP_UINT_CAST(changes.size()));
+
+    size_t failed = 0;
+    string first_error;
+    vector<RouteChange<IPv4> >::const_iterator i;
+    for (i = changes.begin(); i != changes.end(); ++i) {
+	if (i->add)
+	    e = rib_0_1_add_route4(protocol, unicast, multicast, i->net,
+				   i->nexthop, i->metric, i->policytags);
+	else
+	    e = rib_0_1_delete_route4(protocol, unicast, multicast, i->net);
+	if (!e.isOK() && 0 == failed++)
+	    first_error = e.note();
+    }
+
+    if (0 != failed) {
+	string err = c_format("%u of %u route changes failed, first: %s",
+			      XORP_UINT_CAST(failed),
+			      XORP_UINT_CAST(changes.size()),
+			      first_error.c_str());
+	return XrlCmdError::COMMAND_FAILED(err);
+    }
+
+    return XrlCmdError::OKAY();
+}
+
 XrlCmdError
 XrlRibTarget::rib_0_1_add_interface_route4(const string&	protocol,
 					   const bool&		unicast,
@@ -506,16 +616,8 @@ XrlRibTarget::rib_0_1_add_interface_route4(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("add %s %s%s %s %s %s/%s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     ifname.c_str(),
-					     vifname.c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"add", network, metric);
     }
 #endif
 
@@ -562,16 +664,8 @@ XrlRibTarget::rib_0_1_replace_interface_route4(const string&	    protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("replace %s %s%s %s %s %s/%s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     ifname.c_str(),
-					     vifname.c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"replace", network, metric);
     }
 #endif
 
@@ -763,33 +857,31 @@ XrlRibTarget::rib_0_1_redist_transaction_disable4(const string&	target_name,
     return XrlCmdError::OKAY();
 }
 
-XrlCmdError
-XrlRibTarget::rib_0_1_register_interest4(// Input values,
-					 const string& target,
-					 const IPv4& addr,
-					 // Output values,
-					 bool& resolves,
-					 IPv4&	base_addr,
-					 uint32_t& prefix_len,
-					 uint32_t& real_prefix_len,
-					 IPv4&	nexthop,
-					 uint32_t& metric)
+/**
+ * Register @a target's interest in @a addr with @a rib and fill in the
+ * register_interest response.  Shared by the single and bulk XRLs.
+ */
+template <class A>
+static void
+register_interest(RIB<A>& rib, const string& target, const A& addr,
+		  bool& resolves, A& base_addr, uint32_t& prefix_len,
+		  uint32_t& real_prefix_len, A& nexthop, uint32_t& metric)
 {
-    debug_msg("register_interest4 target = %s addr = %s\n",
+    debug_msg("register_interest target = %s addr = %s\n",
 	      target.c_str(), addr.str().c_str());
 
-    RouteRegister<IPv4>* rt_reg = _urib4.route_register(addr, target);
+    RouteRegister<A>* rt_reg = rib.route_register(addr, target);
+    base_addr = rt_reg->valid_subnet().masked_addr();
+    prefix_len = real_prefix_len = rt_reg->valid_subnet().prefix_len();
+    nexthop = A::ZERO();
+    metric = 0;
     if (rt_reg->route() == NULL) {
-	base_addr = rt_reg->valid_subnet().masked_addr();
-	prefix_len = real_prefix_len = rt_reg->valid_subnet().prefix_len();
 	resolves = false;
 	debug_msg("#### XRL -> REGISTER INTEREST UNRESOLVABLE %s\n",
 		  rt_reg->valid_subnet().str().c_str());
     } else {
 	metric = rt_reg->route()->metric();
-	base_addr = rt_reg->valid_subnet().masked_addr();
-	prefix_len = real_prefix_len = rt_reg->valid_subnet().prefix_len();
-	IPNextHop<IPv4>* nh = rt_reg->route()->nexthop();
+	IPNextHop<A>* nh = rt_reg->route()->nexthop();
 	switch (nh->type()) {
 	case GENERIC_NEXTHOP:
 	    // this shouldn't be possible
@@ -807,6 +899,98 @@ XrlRibTarget::rib_0_1_register_interest4(// Input values,
 	    break;
 	}
     }
+}
+
+/**
+ * Register @a target's interest in each of @a addrs, appending one
+ * register_interest response per address to the output lists.
+ */
+template <class A>
+static XrlCmdError
+bulk_register_interest(RIB<A>& rib, const string& target,
+		       const XrlAtomList& addrs, XrlAtomList& resolves_list,
+		       XrlAtomList& base_addrs, XrlAtomList& prefix_lens,
+		       XrlAtomList& real_prefix_lens, XrlAtomList& nexthops,
+		       XrlAtomList& metrics)
+{
+    for (size_t i = 0; i < addrs.size(); i++) {
+	A addr;
+	try {
+	    atom_addr(addrs.get(i), addr);
+	} catch (const XorpException&) {
+	    return XrlCmdError::BAD_ARGS(c_format("addrs[%u] is not an "
+						  "address",
+						  XORP_UINT_CAST(i)));
+	}
+
+	bool resolves;
+	A base_addr, nexthop;
+	uint32_t prefix_len, real_prefix_len, metric;
+	register_interest(rib, target, addr, resolves, base_addr,
+			  prefix_len, real_prefix_len, nexthop, metric);
+
+	resolves_list.append(XrlAtom(resolves));
+	base_addrs.append(XrlAtom(base_addr));
+	prefix_lens.append(XrlAtom(prefix_len));
+	real_prefix_lens.append(XrlAtom(real_prefix_len));
+	nexthops.append(XrlAtom(nexthop));
+	metrics.append(XrlAtom(metric));
+    }
+    return XrlCmdError::OKAY();
+}
+
+/**
+ * Deregister @a target's interest in each addrs[i]/prefix_lens[i].
+ * A failure to find an interest is reported per entry rather than
+ * failing the whole request.
+ */
+template <class A>
+static XrlCmdError
+bulk_deregister_interest(RIB<A>& rib, const string& target,
+			 const XrlAtomList& addrs,
+			 const XrlAtomList& prefix_lens,
+			 XrlAtomList& deregistered)
+{
+    if (addrs.size() != prefix_lens.size())
+	return XrlCmdError::BAD_ARGS("addrs and prefix_lens differ in length");
+
+    for (size_t i = 0; i < addrs.size(); i++) {
+	A addr;
+	uint32_t prefix_len;
+	try {
+	    atom_addr(addrs.get(i), addr);
+	    prefix_len = prefix_lens.get(i).uint32();
+	} catch (const XorpException&) {
+	    return XrlCmdError::BAD_ARGS(c_format("entry %u is malformed",
+						  XORP_UINT_CAST(i)));
+	}
+	if (prefix_len > A::addr_bitlen())
+	    return XrlCmdError::BAD_ARGS(c_format("entry %u has a bad prefix "
+						  "length %u",
+						  XORP_UINT_CAST(i),
+						  XORP_UINT_CAST(prefix_len)));
+
+	bool ok = rib.route_deregister(IPNet<A>(addr, prefix_len), target)
+	    == XORP_OK;
+	deregistered.append(XrlAtom(ok));
+    }
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlRibTarget::rib_0_1_register_interest4(// Input values,
+					 const string& target,
+					 const IPv4& addr,
+					 // Output values,
+					 bool& resolves,
+					 IPv4& base_addr,
+					 uint32_t& prefix_len,
+					 uint32_t& real_prefix_len,
+					 IPv4&	nexthop,
+					 uint32_t& metric)
+{
+    register_interest(_urib4, target, addr, resolves, base_addr, prefix_len,
+		      real_prefix_len, nexthop, metric);
     return XrlCmdError::OKAY();
 }
 
@@ -828,6 +1012,35 @@ XrlRibTarget::rib_0_1_deregister_interest4(// Input values,
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlRibTarget::rib_0_1_bulk_register_interest4(// Input values,
+					      const string& target,
+					      const XrlAtomList& addrs,
+					      // Output values,
+					      XrlAtomList& resolves,
+					      XrlAtomList& base_addrs,
+					      XrlAtomList& prefix_lens,
+					      XrlAtomList& real_prefix_lens,
+					      XrlAtomList& nexthops,
+					      XrlAtomList& metrics)
+{
+    return bulk_register_interest(_urib4, target, addrs, resolves, base_addrs,
+				  prefix_lens, real_prefix_lens, nexthops,
+				  metrics);
+}
+
+XrlCmdError
+XrlRibTarget::rib_0_1_bulk_deregister_interest4(// Input values,
+						const string& target,
+						const XrlAtomList& addrs,
+						const XrlAtomList& prefix_lens,
+						// Output values,
+						XrlAtomList& deregistered)
+{
+    return bulk_deregister_interest(_urib4, target, addrs, prefix_lens,
+				    deregistered);
+}
+
 XrlCmdError
 XrlRibTarget::rib_0_1_get_protocol_admin_distances(
     // Input values,
@@ -1148,6 +1361,39 @@ XrlRibTarget::profile_0_1_list(string& info)
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlRibTarget::profile_0_1_set_histogram(const string& pname,
+					const bool& histogram)
+{
+    debug_msg("profile variable %s histogram %s\n", pname.c_str(),
+	      bool_c_str(histogram));
+
+    try {
+	_rib_manager->profile().set_histogram(pname, histogram);
+    } catch(PVariableUnknown& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    } catch(PVariableLocked& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    }
+
+    return XrlCmdError::OKAY();
+}
+
+XrlCmdError
+XrlRibTarget::profile_0_1_get_histogram(const string& pname,
+					string& histogram)
+{
+    debug_msg("profile variable %s\n", pname.c_str());
+
+    try {
+	histogram = _rib_manager->profile().get_histogram(pname);
+    } catch(PVariableUnknown& e) {
+	return XrlCmdError::COMMAND_FAILED(e.str());
+    }
+
+    return XrlCmdError::OKAY();
+}
+
 #endif // profile
 
 
@@ -1280,14 +1526,8 @@ XrlRibTarget::rib_0_1_add_route6(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("add %s %s%s %s %s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"add", network, metric);
     }
 #endif
 
@@ -1334,14 +1574,8 @@ XrlRibTarget::rib_0_1_replace_route6(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("replace %s %s%s %s %s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"replace", network, metric);
     }
 #endif
 
@@ -1379,12 +1613,8 @@ XrlRibTarget::rib_0_1_delete_route6(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("delete %s %s%s %s",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str()));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"delete", network);
     }
 #endif
 
@@ -1401,6 +1631,54 @@ XrlRibTarget::rib_0_1_delete_route6(const string&	protocol,
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlRibTarget::rib_0_1_route_changes6(const string&	protocol,
+				     const bool&	unicast,
+				     const bool&	multicast,
+				     const XrlAtomList&	adds,
+				     const XrlAtomList&	networks,
+				     const XrlAtomList&	nexthops,
+				     const XrlAtomList&	metrics,
+				     const XrlAtomList&	tag_counts,
+				     const XrlAtomList&	policytags)
+{
+    vector<RouteChange<IPv6> > changes;
+    XrlCmdError e = parse_route_changes(adds, networks, nexthops, metrics,
+					tag_counts, policytags, changes);
+    if (!e.isOK())
+	return e;
+
+    debug_msg("route_changes6 protocol: %s unicast: %s multicast: %s "
+	      "changes %u\n",
+	      protocol.c_str(),
+	      bool_c_str(unicast),
+	      bool_c_str(multicast),
+	      XORP_UINT_CAST(changes.size()));
+
+    size_t failed = 0;
+    string first_error;
+    vector<RouteChange<IPv6> >::const_iterator i;
+    for (i = changes.begin(); i != changes.end(); ++i) {
+	if (i->add)
+	    e = rib_0_1_add_route6(protocol, unicast, multicast, i->net,
+				   i->nexthop, i->metric, i->policytags);
+	else
+	    e = rib_0_1_delete_route6(protocol, unicast, multicast, i->net);
+	if (!e.isOK() && 0 == failed++)
+	    first_error = e.note();
+    }
+
+    if (0 != failed) {
+	string err = c_format("%u of %u route changes failed, first: %s",
+			      XORP_UINT_CAST(failed),
+			      XORP_UINT_CAST(changes.size()),
+			      first_error.c_str());
+	return XrlCmdError::COMMAND_FAILED(err);
+    }
+
+    return XrlCmdError::OKAY();
+}
+
 XrlCmdError
 XrlRibTarget::rib_0_1_add_interface_route6(const string&	protocol,
 					   const bool&		unicast,
@@ -1425,16 +1703,8 @@ XrlRibTarget::rib_0_1_add_interface_route6(const string&	protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("add %s %s%s %s %s %s/%s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     ifname.c_str(),
-					     vifname.c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"add", network, metric);
     }
 #endif
 
@@ -1481,16 +1751,8 @@ XrlRibTarget::rib_0_1_replace_interface_route6(const string&	    protocol,
 
 #ifndef XORP_DISABLE_PROFILE
     if (_rib_manager->profile().enabled(profile_route_ribin)) {
-	_rib_manager->profile().log(profile_route_ribin,
-				    c_format("replace %s %s%s %s %s %s/%s %u",
-					     protocol.c_str(),
-					     unicast ? "u" : "",
-					     multicast ? "m" : "",
-					     network.str().c_str(),
-					     nexthop.str().c_str(),
-					     ifname.c_str(),
-					     vifname.c_str(),
-					     XORP_UINT_CAST(metric)));
+	_rib_manager->profile().log_net(profile_route_ribin,
+					"replace", network, metric);
     }
 #endif
 
@@ -1641,38 +1903,8 @@ XrlRibTarget::rib_0_1_register_interest6(// Input values,
 					 IPv6&	nexthop,
 					 uint32_t& metric)
 {
-    debug_msg("register_interest6 target = %s addr = %s\n",
-	      target.c_str(), addr.str().c_str());
-
-    RouteRegister<IPv6>* rt_reg = _urib6.route_register(addr, target);
-    if (rt_reg->route() == NULL) {
-	base_addr = rt_reg->valid_subnet().masked_addr();
-	prefix_len = real_prefix_len = rt_reg->valid_subnet().prefix_len();
-	resolves = false;
-	debug_msg("#### XRL -> REGISTER INTEREST UNRESOLVABLE %s\n",
-		  rt_reg->valid_subnet().str().c_str());
-    } else {
-	metric = rt_reg->route()->metric();
-	base_addr = rt_reg->valid_subnet().masked_addr();
-	prefix_len = real_prefix_len = rt_reg->valid_subnet().prefix_len();
-	IPNextHop<IPv6>* nh = rt_reg->route()->nexthop();
-	switch (nh->type()) {
-	case GENERIC_NEXTHOP:
-	    // this shouldn't be possible
-	    XLOG_UNREACHABLE();
-	case PEER_NEXTHOP:
-	case ENCAPS_NEXTHOP:
-	    resolves = true;
-	    nexthop = nh->addr();
-	    real_prefix_len = rt_reg->route()->prefix_len();
-	    break;
-	case EXTERNAL_NEXTHOP:
-	case DISCARD_NEXTHOP:
-	case UNREACHABLE_NEXTHOP:
-	    resolves = false;
-	    break;
-	}
-    }
+    register_interest(_urib6, target, addr, resolves, base_addr, prefix_len,
+		      real_prefix_len, nexthop, metric);
     return XrlCmdError::OKAY();
 }
 
@@ -1694,4 +1926,33 @@ XrlRibTarget::rib_0_1_deregister_interest6(// Input values,
     return XrlCmdError::OKAY();
 }
 
+XrlCmdError
+XrlRibTarget::rib_0_1_bulk_register_interest6(// Input values,
+					      const string& target,
+					      const XrlAtomList& addrs,
+					      // Output values,
+					      XrlAtomList& resolves,
+					      XrlAtomList& base_addrs,
+					      XrlAtomList& prefix_lens,
+					      XrlAtomList& real_prefix_lens,
+					      XrlAtomList& nexthops,
+					      XrlAtomList& metrics)
+{
+    return bulk_register_interest(_urib6, target, addrs, resolves, base_addrs,
+				  prefix_lens, real_prefix_lens, nexthops,
+				  metrics);
+}
+
+XrlCmdError
+XrlRibTarget::rib_0_1_bulk_deregister_interest6(// Input values,
+						const string& target,
+						const XrlAtomList& addrs,
+						const XrlAtomList& prefix_lens,
+						// Output values,
+						XrlAtomList& deregistered)
+{
+    return bulk_deregister_interest(_urib6, target, addrs, prefix_lens,
+				    deregistered);
+}
+
 #endif //ipv6
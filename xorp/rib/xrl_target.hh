@@ -23,6 +23,7 @@
 #define __RIB_XRL_TARGET_HH__
 
 #include "libxipc/xrl_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/rib_base.hh"
 
 #include "rib.hh"
@@ -106,6 +107,14 @@ protected:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return rib_0_1_start_rib(); }
 
     /**
@@ -288,6 +297,38 @@ protected:
 	const bool&	multicast,
 	const IPv4Net&	network);
 
+    /**
+     *  Apply a batch of route adds and deletes in order.
+     *
+     *  Equivalent to calling add_route4 or delete_route4 once per
+     *  change, but in a single request.
+     *
+     *  @param adds true for each change that is an add, false for a delete.
+     *
+     *  @param networks the network address prefix of each change.
+     *
+     *  @param nexthops the next-hop router of each change, ignored for
+     *  deletes.
+     *
+     *  @param metrics the routing metric of each change, ignored for
+     *  deletes.
+     *
+     *  @param tag_counts the number of policy tags of each change.
+     *
+     *  @param policytags the policy tags of all the changes, in order.
+     */
+    XrlCmdError rib_0_1_route_changes4(
+	// Input values,
+	const string&	protocol,
+	const bool&	unicast,
+	const bool&	multicast,
+	const XrlAtomList&	adds,
+	const XrlAtomList&	networks,
+	const XrlAtomList&	nexthops,
+	const XrlAtomList&	metrics,
+	const XrlAtomList&	tag_counts,
+	const XrlAtomList&	policytags);
+
     /**
      *  Add/replace a route by explicitly specifying the network interface
      *  toward the destination.
@@ -546,6 +587,53 @@ protected:
 	const IPv4&	addr,
 	const uint32_t&	prefix_len);
 
+    /**
+     *  Register an interest in many routes in one request.
+     *
+     *  Equivalent to calling register_interest4 once per address, but
+     *  without a round trip per address. The i'th element of each returned
+     *  list is the register_interest4 response for the i'th element of
+     *  addrs.
+     *
+     *  @param target the name of the XRL module to notify when the
+     *  information returned by this call becomes invalid.
+     *
+     *  @param addrs the addresses of interest.
+     */
+    XrlCmdError rib_0_1_bulk_register_interest4(
+	// Input values,
+        const string&	target,
+	const XrlAtomList&	addrs,
+	// Output values,
+	XrlAtomList&	resolves,
+	XrlAtomList&	base_addrs,
+	XrlAtomList&	prefix_lens,
+	XrlAtomList&	real_prefix_lens,
+	XrlAtomList&	nexthops,
+	XrlAtomList&	metrics);
+
+    /**
+     *  De-register an interest in many routes in one request.
+     *
+     *  @param target the name of the XRL module that registered the
+     *  interests.
+     *
+     *  @param addrs the base addresses of the registered interests.
+     *
+     *  @param prefix_lens the prefix lengths of the registered interests,
+     *  one per element of addrs.
+     *
+     *  @param deregistered returns, for each interest, whether it was found
+     *  and removed.
+     */
+    XrlCmdError rib_0_1_bulk_deregister_interest4(
+	// Input values,
+        const string&	target,
+	const XrlAtomList&	addrs,
+	const XrlAtomList&	prefix_lens,
+	// Output values,
+	XrlAtomList&	deregistered);
+
     /**
      *  Get the configured admin distances from a selected RIB
      *  for all routing protocols configured with one.
@@ -729,6 +817,38 @@ protected:
 	const bool&	multicast,
 	const IPv6Net&	network);
 
+    /**
+     *  Apply a batch of route adds and deletes in order.
+     *
+     *  Equivalent to calling add_route6 or delete_route6 once per
+     *  change, but in a single request.
+     *
+     *  @param adds true for each change that is an add, false for a delete.
+     *
+     *  @param networks the network address prefix of each change.
+     *
+     *  @param nexthops the next-hop router of each change, ignored for
+     *  deletes.
+     *
+     *  @param metrics the routing metric of each change, ignored for
+     *  deletes.
+     *
+     *  @param tag_counts the number of policy tags of each change.
+     *
+     *  @param policytags the policy tags of all the changes, in order.
+     */
+    XrlCmdError rib_0_1_route_changes6(
+	// Input values,
+	const string&	protocol,
+	const bool&	unicast,
+	const bool&	multicast,
+	const XrlAtomList&	adds,
+	const XrlAtomList&	networks,
+	const XrlAtomList&	nexthops,
+	const XrlAtomList&	metrics,
+	const XrlAtomList&	tag_counts,
+	const XrlAtomList&	policytags);
+
     XrlCmdError rib_0_1_add_interface_route6(
 	// Input values,
 	const string&	    protocol,
@@ -942,6 +1062,53 @@ protected:
 	const IPv6&	addr,
 	const uint32_t&	prefix_len);
 
+    /**
+     *  Register an interest in many routes in one request.
+     *
+     *  Equivalent to calling register_interest6 once per address, but
+     *  without a round trip per address. The i'th element of each returned
+     *  list is the register_interest6 response for the i'th element of
+     *  addrs.
+     *
+     *  @param target the name of the XRL module to notify when the
+     *  information returned by this call becomes invalid.
+     *
+     *  @param addrs the addresses of interest.
+     */
+    XrlCmdError rib_0_1_bulk_register_interest6(
+	// Input values,
+        const string&	target,
+	const XrlAtomList&	addrs,
+	// Output values,
+	XrlAtomList&	resolves,
+	XrlAtomList&	base_addrs,
+	XrlAtomList&	prefix_lens,
+	XrlAtomList&	real_prefix_lens,
+	XrlAtomList&	nexthops,
+	XrlAtomList&	metrics);
+
+    /**
+     *  De-register an interest in many routes in one request.
+     *
+     *  @param target the name of the XRL module that registered the
+     *  interests.
+     *
+     *  @param addrs the base addresses of the registered interests.
+     *
+     *  @param prefix_lens the prefix lengths of the registered interests,
+     *  one per element of addrs.
+     *
+     *  @param deregistered returns, for each interest, whether it was found
+     *  and removed.
+     */
+    XrlCmdError rib_0_1_bulk_deregister_interest6(
+	// Input values,
+        const string&	target,
+	const XrlAtomList&	addrs,
+	const XrlAtomList&	prefix_lens,
+	// Output values,
+	XrlAtomList&	deregistered);
+
 #endif //ipv6
 
 #ifndef XORP_DISABLE_PROFILE
@@ -990,6 +1157,28 @@ protected:
     XrlCmdError profile_0_1_list(
 	// Output values,
 	string&	info);
+
+    /**
+     *  Select between logging entries and counting them in a histogram.
+     *
+     *  @param pname profile variable
+     *  @param histogram true to count the entries in a histogram
+     */
+    XrlCmdError profile_0_1_set_histogram(
+	// Input values,
+	const string&	pname,
+	const bool&	histogram);
+
+    /**
+     *  Get the histogram of a profile variable.
+     *
+     *  @param pname profile variable
+     */
+    XrlCmdError profile_0_1_get_histogram(
+	// Input values,
+	const string&	pname,
+	// Output values,
+	string&	histogram);
 #endif
 };
 
@@ -22,6 +22,7 @@
 #define __RIP_XRL_TARGET_RIPNG_HH__
 
 #include "libxorp/status_codes.h"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/ripng_base.hh"
 
 class XrlRouter;
@@ -50,6 +51,14 @@ public:
     XrlCmdError common_0_1_shutdown();
     XrlCmdError common_0_1_startup();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError
     finder_event_observer_0_1_xrl_target_birth(const string& class_name,
 					       const string& instance_name);
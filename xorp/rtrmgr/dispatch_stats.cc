@@ -0,0 +1,175 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+// vim:set sts=4 ts=8:
+
+// Copyright (c) 2001-2011 XORP, Inc and Others
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, Version 2, June
+// 1991 as published by the Free Software Foundation. Redistribution
+// and/or modification of this program under the terms of any other
+// version of the GNU General Public License is not permitted.
+// 
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. For more details,
+// see the GNU General Public License, Version 2, a copy of which can be
+// found in the XORP LICENSE.gpl file.
+// 
+// XORP Inc, 2953 Bunker Hill Lane, Suite 204, Santa Clara, CA 95054, USA;
+// http://xorp.net
+
+
+
+
+// Show or switch the event loop dispatch statistics of a XORP process.
+
+#include "rtrmgr_module.h"
+
+#include <stdio.h>
+
+#include "libxorp/xorp.h"
+#include "libxorp/xlog.h"
+#include "libxorp/exceptions.hh"
+#include "libxorp/callback.hh"
+
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+
+#include "libxipc/xrl_std_router.hh"
+
+#include "xrl/interfaces/common_xif.hh"
+
+
+class DispatchStatsClient {
+public:
+    DispatchStatsClient(XrlRouter& xrl_router)
+	: _common(&xrl_router), _done(false), _failed(false)
+    {}
+
+    void
+    get(const string& target)
+    {
+	XrlCommonV0p1Client::GetDispatchStatsCB cb =
+	    callback(this, &DispatchStatsClient::get_cb);
+	_common.send_get_dispatch_stats(target.c_str(), cb);
+    }
+
+    void
+    get_cb(const XrlError& error, const string* stats)
+    {
+	_done = true;
+	if (XrlError::OKAY() != error) {
+	    fprintf(stderr, "Failed to get the dispatch statistics: %s\n",
+		    error.str().c_str());
+	    _failed = true;
+	    return;
+	}
+	printf("%s", stats->c_str());
+    }
+
+    void
+    set(const string& target, bool enable)
+    {
+	XrlCommonV0p1Client::SetDispatchStatsCB cb =
+	    callback(this, &DispatchStatsClient::set_cb);
+	_common.send_set_dispatch_stats(target.c_str(), enable, cb);
+    }
+
+    void
+    set_cb(const XrlError& error)
+    {
+	_done = true;
+	if (XrlError::OKAY() != error) {
+	    fprintf(stderr, "Failed to set the dispatch statistics: %s\n",
+		    error.str().c_str());
+	    _failed = true;
+	}
+    }
+
+    bool done() const	{ return _done; }
+    bool failed() const	{ return _failed; }
+
+private:
+    XrlCommonV0p1Client	_common;
+    bool		_done;
+    bool		_failed;
+};
+
+int
+usage(const char *myname)
+{
+    fprintf(stderr, "usage: %s [-e | -d] target\n", myname);
+    fprintf(stderr, "  -e enable the dispatch statistics of the target\n");
+    fprintf(stderr, "  -d disable them\n");
+    fprintf(stderr, "Without an option the statistics are shown.\n");
+    return 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    XorpUnexpectedHandler x(xorp_unexpected_handler);
+    //
+    // Initialize and start xlog
+    //
+    xlog_init(argv[0], NULL);
+    xlog_set_verbose(XLOG_VERBOSE_LOW);		// Least verbose messages
+    // XXX: verbosity of the error messages temporary increased
+    xlog_level_set_verbose(XLOG_LEVEL_ERROR, XLOG_VERBOSE_HIGH);
+    xlog_add_default_output();
+    xlog_start();
+
+    const char* myname = argv[0];
+    string command = "get";
+
+    int c;
+    while ((c = getopt(argc, argv, "ed")) != -1) {
+	switch (c) {
+	case 'e':
+	    command = "enable";
+	    break;
+	case 'd':
+	    command = "disable";
+	    break;
+	default:
+	    return usage(myname);
+	}
+    }
+    argc -= optind;
+    argv += optind;
+
+    if (argc != 1)
+	return usage(myname);
+    string target = argv[0];
+
+    int ret = 1;
+    try {
+	EventLoop eventloop;
+	XrlStdRouter xrl_router(eventloop, "dispatch_stats");
+	DispatchStatsClient client(xrl_router);
+
+	xrl_router.finalize();
+	wait_until_xrl_router_is_ready(eventloop, xrl_router);
+
+	if (command == "get")
+	    client.get(target);
+	else
+	    client.set(target, command == "enable");
+
+	while (!client.done())
+	    eventloop.run();
+
+	ret = client.failed() ? 1 : 0;
+    } catch (...) {
+	xorp_catch_standard_exceptions();
+    }
+
+    //
+    // Gracefully stop and exit xlog
+    //
+    xlog_stop();
+    xlog_exit();
+
+    return ret;
+}
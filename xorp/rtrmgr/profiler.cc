@@ -44,6 +44,7 @@
 #endif
 
 #include "libxipc/xrl_std_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 
 #include "xrl/interfaces/profile_xif.hh"
 
@@ -88,6 +89,14 @@ class XrlProfilerTarget :  XrlProfilerTargetBase {
 	return XrlCmdError::OKAY();
     }
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError
     profile_client_0_1_log(const string& pname,	const uint32_t&	sec,
 			   const uint32_t& usec, const string&	comment)
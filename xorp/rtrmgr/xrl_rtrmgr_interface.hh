@@ -25,6 +25,7 @@
 
 #include "libxorp/timer.hh"
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/rtrmgr_base.hh"
 #include "xrl/interfaces/rtrmgr_client_xif.hh"
 #include "xrl/interfaces/finder_event_notifier_xif.hh"
@@ -73,6 +74,14 @@ public:
      */
     XrlCmdError common_0_1_shutdown();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     XrlCmdError rtrmgr_0_1_get_pid(
@@ -24,6 +24,7 @@
 #ifndef __RTRMGR_XRL_XORPSH_INTERFACE_HH__
 #define __RTRMGR_XRL_XORPSH_INTERFACE_HH__
 
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/xorpsh_base.hh"
 
 
@@ -52,6 +53,14 @@ public:
      * Shutdown cleanly
      */
     XrlCmdError common_0_1_shutdown();
+
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
     XrlCmdError common_0_1_startup() { return XrlCmdError::OKAY(); }
 
     XrlCmdError rtrmgr_client_0_2_new_config_user(
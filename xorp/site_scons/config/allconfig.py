@@ -188,6 +188,7 @@ def DoAllConfig(env, conf, host_os):
     has_sys_uio_h = conf.CheckHeader('sys/uio.h')
     has_sys_ioctl_h = conf.CheckHeader('sys/ioctl.h')
     has_sys_select_h = conf.CheckHeader('sys/select.h')
+    has_sys_epoll_h = conf.CheckHeader('sys/epoll.h')
     has_sys_socket_h = conf.CheckHeader('sys/socket.h')
     has_sys_sockio_h = conf.CheckHeader('sys/sockio.h')
     has_sys_un_h = conf.CheckHeader('sys/un.h')
@@ -201,6 +202,7 @@ def DoAllConfig(env, conf, host_os):
 
     has_sys_resource_h = conf.CheckHeader('sys/resource.h')
     has_sys_stat_h = conf.CheckHeader('sys/stat.h')
+    has_sys_mman_h = conf.CheckHeader('sys/mman.h')
     has_sys_syslog_h = conf.CheckHeader('sys/syslog.h')
     
     # bsd
@@ -210,6 +212,7 @@ def DoAllConfig(env, conf, host_os):
     # linux
     has_linux_types_h = conf.CheckHeader('linux/types.h')
     has_linux_sockios_h = conf.CheckHeader('linux/sockios.h')
+    has_linux_perf_event_h = conf.CheckHeader('linux/perf_event.h')
     
     # XXX needs header conditionals
     has_struct_iovec = conf.CheckType('struct iovec', includes='#include <sys/uio.h>')
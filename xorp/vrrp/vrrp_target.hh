@@ -24,6 +24,7 @@
 #define __VRRP_VRRP_TARGET_HH__
 
 #include "libxipc/xrl_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "libfeaclient/ifmgr_xrl_mirror.hh"
 #include "xrl/targets/vrrp_base.hh"
 #include "xrl/interfaces/fea_rawlink_xif.hh"
@@ -154,6 +155,14 @@ protected:
     XrlCmdError common_0_1_shutdown();
     XrlCmdError common_0_1_startup();
 
+    XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     XrlCmdError vrrp_0_1_add_vrid(
         // Input values,
         const string&   ifname,
@@ -23,6 +23,7 @@
 
 
 #include "libxipc/xrl_router.hh"
+#include "libxipc/xrl_dispatch_stats.hh"
 #include "xrl/targets/test_base.hh"
 
 class XrlTestTarget: public XrlTestTargetBase {
@@ -46,6 +47,14 @@ protected:
 
     virtual XrlCmdError common_0_1_shutdown();
 
+    virtual XrlCmdError common_0_1_set_dispatch_stats(const bool& enable) {
+	return xrl_set_dispatch_stats(enable);
+    }
+
+    virtual XrlCmdError common_0_1_get_dispatch_stats(string& stats) {
+	return xrl_get_dispatch_stats(stats);
+    }
+
     virtual XrlCmdError test_1_0_print_hello_world();
 
     virtual XrlCmdError test_1_0_print_hello_world_and_message(